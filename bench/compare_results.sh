@@ -0,0 +1,78 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Compare the BENCH_RESULTS blocks of two benchmark logs by avg_ms and fail
+# when any label present in both got slower by more than THRESHOLD percent.
+# Labels below MIN_MS in the base run are reported but never fail the gate,
+# since sub-millisecond pgbench latencies are dominated by noise.
+
+if [[ $# -lt 2 || $# -gt 3 ]]; then
+  echo "usage: $0 BASE.out NEW.out [THRESHOLD_PCT]" >&2
+  exit 2
+fi
+
+BASE="$1"
+NEW="$2"
+THRESHOLD="${3:-${THRESHOLD:-5}}"
+MIN_MS="${MIN_MS:-0}"
+
+for file in "${BASE}" "${NEW}"; do
+  if [[ ! -r "${file}" ]]; then
+    echo "cannot read ${file}" >&2
+    exit 2
+  fi
+done
+
+echo "Comparing benchmark results (avg_ms, lower is better)"
+echo "  base=${BASE}"
+echo "  new=${NEW}"
+echo "  threshold=${THRESHOLD}% min_ms=${MIN_MS}"
+echo
+
+awk -F'|' -v threshold="${THRESHOLD}" -v min_ms="${MIN_MS}" '
+  FNR == 1 { file++; in_block = 0 }
+  /^BENCH_RESULTS_BEGIN$/ { in_block = 1; next }
+  /^BENCH_RESULTS_END$/ { in_block = 0; next }
+  !in_block || NF < 2 { next }
+  file == 1 { base[$1] = $2; next }
+  { cur[$1] = $2; order[++n] = $1 }
+  END {
+    printf "%-44s %12s %12s %9s  %s\n", "label", "base_ms", "new_ms", "delta", "status"
+    failed = 0
+    for (i = 1; i <= n; i++) {
+      label = order[i]
+      if (!(label in base)) {
+        printf "%-44s %12s %12.3f %9s  %s\n", label, "-", cur[label], "-", "new"
+        continue
+      }
+      delta = base[label] > 0 ? (cur[label] - base[label]) * 100.0 / base[label] : 0
+      status = "ok"
+      if (delta > threshold) {
+        if (base[label] < min_ms) {
+          status = "noise"
+        } else {
+          status = "REGRESSED"
+          failed++
+        }
+      } else if (delta < -threshold) {
+        status = "improved"
+      }
+      printf "%-44s %12.3f %12.3f %+8.1f%%  %s\n", label, base[label], cur[label], delta, status
+      seen[label] = 1
+    }
+    for (label in base) {
+      if (!(label in seen)) {
+        printf "%-44s %12.3f %12s %9s  %s\n", label, base[label], "-", "-", "missing"
+      }
+    }
+    if (n == 0) {
+      print "\nno BENCH_RESULTS rows in the new run" > "/dev/stderr"
+      exit 2
+    }
+    if (failed > 0) {
+      printf "\n%d benchmark(s) regressed by more than %s%%\n", failed, threshold > "/dev/stderr"
+      exit 1
+    }
+    printf "\nno regression beyond %s%%\n", threshold
+  }
+' "${BASE}" "${NEW}"
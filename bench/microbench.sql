@@ -75,6 +75,18 @@ SELECT
 FROM generate_series(1, 220000) gs(i);
 ANALYZE bench_numeric;
 
+DROP TABLE IF EXISTS bench_decode;
+CREATE TABLE bench_decode AS
+SELECT
+  t.i0 AS id,
+  row_to_msgpack(t.*) AS m,
+  row_to_cbor(t.*) AS c,
+  row_to_zera(t.*) AS z,
+  row_to_flexbuffers(t.*) AS f,
+  to_jsonb(t.*)::text AS js
+FROM bench_wide t;
+ANALYZE bench_decode;
+
 DROP TABLE IF EXISTS bench_results;
 CREATE TEMP TABLE bench_results(
   label text PRIMARY KEY,
@@ -137,6 +149,17 @@ SELECT pg_temp.run_bench('wide_flex', 'SELECT sum(octet_length(row_to_flexbuffer
 SELECT pg_temp.run_bench('arrays_msgpack', 'SELECT sum(octet_length(row_to_msgpack(t.*))) FROM bench_arrays t', :warmup, :runs);
 SELECT pg_temp.run_bench('numeric_msgpack', 'SELECT sum(octet_length(row_to_msgpack(t.*))) FROM bench_numeric t', :warmup, :runs);
 
+SELECT pg_temp.run_bench('decode_msgpack', 'SELECT sum(pg_column_size(msgpack_to_jsonb(t.m))) FROM bench_decode t', :warmup, :runs);
+SELECT pg_temp.run_bench('decode_cbor', 'SELECT sum(pg_column_size(cbor_to_jsonb(t.c))) FROM bench_decode t', :warmup, :runs);
+SELECT pg_temp.run_bench('decode_zera', 'SELECT sum(pg_column_size(zera_to_jsonb(t.z))) FROM bench_decode t', :warmup, :runs);
+SELECT pg_temp.run_bench('decode_flex', 'SELECT sum(pg_column_size(flexbuffers_to_jsonb(t.f))) FROM bench_decode t', :warmup, :runs);
+SELECT pg_temp.run_bench('decode_json_text', 'SELECT sum(pg_column_size(t.js::jsonb)) FROM bench_decode t', :warmup, :runs);
+
+SELECT pg_temp.run_bench('narrow_row_to_json', 'SELECT sum(octet_length(row_to_json(t.*)::text)) FROM bench_narrow t', :warmup, :runs);
+SELECT pg_temp.run_bench('narrow_to_jsonb', 'SELECT sum(pg_column_size(to_jsonb(t.*))) FROM bench_narrow t', :warmup, :runs);
+SELECT pg_temp.run_bench('wide_row_to_json', 'SELECT sum(octet_length(row_to_json(t.*)::text)) FROM bench_wide t', :warmup, :runs);
+SELECT pg_temp.run_bench('wide_to_jsonb', 'SELECT sum(pg_column_size(to_jsonb(t.*))) FROM bench_wide t', :warmup, :runs);
+
 \pset format unaligned
 \pset tuples_only on
 \echo BENCH_RESULTS_BEGIN
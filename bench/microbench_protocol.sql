@@ -65,21 +65,33 @@ SELECT pg_temp.run_bench('narrow_msgpack', 'SELECT sum(octet_length(row_to_msgpa
 SELECT pg_temp.run_bench('wide_msgpack', 'SELECT sum(octet_length(row_to_msgpack(t.*))) FROM bench_wide t', :warmup, :runs);
 SELECT pg_temp.run_bench('arrays_msgpack', 'SELECT sum(octet_length(row_to_msgpack(t.*))) FROM bench_arrays t', :warmup, :runs);
 SELECT pg_temp.run_bench('numeric_msgpack', 'SELECT sum(octet_length(row_to_msgpack(t.*))) FROM bench_numeric t', :warmup, :runs);
+SELECT pg_temp.run_bench('decode_msgpack', 'SELECT sum(pg_column_size(msgpack_to_jsonb(t.m))) FROM bench_decode t', :warmup, :runs);
 \endif
 
 \if :{?run_cbor}
 SELECT pg_temp.run_bench('narrow_cbor', 'SELECT sum(octet_length(row_to_cbor(t.*))) FROM bench_narrow t', :warmup, :runs);
 SELECT pg_temp.run_bench('wide_cbor', 'SELECT sum(octet_length(row_to_cbor(t.*))) FROM bench_wide t', :warmup, :runs);
+SELECT pg_temp.run_bench('decode_cbor', 'SELECT sum(pg_column_size(cbor_to_jsonb(t.c))) FROM bench_decode t', :warmup, :runs);
 \endif
 
 \if :{?run_zera}
 SELECT pg_temp.run_bench('narrow_zera', 'SELECT sum(octet_length(row_to_zera(t.*))) FROM bench_narrow t', :warmup, :runs);
 SELECT pg_temp.run_bench('wide_zera', 'SELECT sum(octet_length(row_to_zera(t.*))) FROM bench_wide t', :warmup, :runs);
+SELECT pg_temp.run_bench('decode_zera', 'SELECT sum(pg_column_size(zera_to_jsonb(t.z))) FROM bench_decode t', :warmup, :runs);
 \endif
 
 \if :{?run_flex}
 SELECT pg_temp.run_bench('narrow_flex', 'SELECT sum(octet_length(row_to_flexbuffers(t.*))) FROM bench_narrow t', :warmup, :runs);
 SELECT pg_temp.run_bench('wide_flex', 'SELECT sum(octet_length(row_to_flexbuffers(t.*))) FROM bench_wide t', :warmup, :runs);
+SELECT pg_temp.run_bench('decode_flex', 'SELECT sum(pg_column_size(flexbuffers_to_jsonb(t.f))) FROM bench_decode t', :warmup, :runs);
+\endif
+
+\if :{?run_json}
+SELECT pg_temp.run_bench('narrow_row_to_json', 'SELECT sum(octet_length(row_to_json(t.*)::text)) FROM bench_narrow t', :warmup, :runs);
+SELECT pg_temp.run_bench('narrow_to_jsonb', 'SELECT sum(pg_column_size(to_jsonb(t.*))) FROM bench_narrow t', :warmup, :runs);
+SELECT pg_temp.run_bench('wide_row_to_json', 'SELECT sum(octet_length(row_to_json(t.*)::text)) FROM bench_wide t', :warmup, :runs);
+SELECT pg_temp.run_bench('wide_to_jsonb', 'SELECT sum(pg_column_size(to_jsonb(t.*))) FROM bench_wide t', :warmup, :runs);
+SELECT pg_temp.run_bench('decode_json_text', 'SELECT sum(pg_column_size(t.js::jsonb)) FROM bench_decode t', :warmup, :runs);
 \endif
 
 \pset format unaligned
@@ -68,3 +68,15 @@ SELECT
   ((i::numeric / 13.0) + 0.123456)::numeric AS n3
 FROM generate_series(1, 220000) gs(i);
 ANALYZE bench_numeric;
+
+DROP TABLE IF EXISTS bench_decode;
+CREATE TABLE bench_decode AS
+SELECT
+  t.i0 AS id,
+  row_to_msgpack(t.*) AS m,
+  row_to_cbor(t.*) AS c,
+  row_to_zera(t.*) AS z,
+  row_to_flexbuffers(t.*) AS f,
+  to_jsonb(t.*)::text AS js
+FROM bench_wide t;
+ANALYZE bench_decode;
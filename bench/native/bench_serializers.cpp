@@ -0,0 +1,427 @@
+/*
+ * bench_serializers.cpp
+ * Server-free microbenchmarks for the vendored serializers
+ *
+ * Each benchmark encodes a batch of synthetic rows shaped like rows_to_*
+ * output: one protocol array of maps, written through the vendored
+ * serializers. The row loop, key preencoding, and numeric parsing below are
+ * this file's own stand-ins for the extension's per-column writers, which
+ * are not run; only the MessagePack integer encoder and array kernels come
+ * from pg_zerialize_kernels.hpp. Column values are held in their datum form
+ * (pass-by-value scalars, text views, and packed array payloads), so tuple
+ * deforming and detoasting are left out.
+ *
+ * Counters: ns/row, bytes/row, and allocs/row. Pass
+ * --benchmark_perf_counters=CYCLES,INSTRUCTIONS to add perf_event counters
+ * when Google Benchmark was built with libpfm.
+ */
+
+#include "pg_zerialize_kernels.hpp"
+
+#include <benchmark/benchmark.h>
+#include <fast_float/fast_float.h>
+#include <zerialize/protocols/cbor.hpp>
+#include <zerialize/protocols/flex.hpp>
+#include <zerialize/protocols/zera.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+/*
+ * Allocation counting. operator new covers the CBOR, ZERA, and FlexBuffers
+ * builders; the MessagePack root grows through its realloc hook, as it does
+ * with palloc in the extension.
+ */
+static std::atomic<uint64_t> allocation_count{0};
+
+void* operator new(std::size_t size)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+static void* counting_realloc(void* ptr, std::size_t size)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    return std::realloc(ptr, size);
+}
+
+/* Column kinds the shapes use, named after their ConverterKind. */
+enum class Kind { Int4, Int8, Float8, Bool, Text, Numeric, Int4Array, Float8Array, TextArray, Composite };
+
+struct Shape;
+
+struct Column {
+    std::string name;
+    Kind kind;
+    std::vector<uint8_t> msgpack_key;   // preencoded fixstr/str8 key
+    const Shape* composite = nullptr;
+    std::vector<uint8_t> cbor_key;      // preencoded text string key
+    // Flex key already written into document flex_key_document.
+    mutable z::flex::Serializer::KeyRef flex_key{};
+    mutable uint64_t flex_key_document = 0;
+};
+
+/*
+ * One column value in datum form. Arrays keep the packed payload that
+ * ARR_DATA_PTR points at; numerics keep their digits as decimal text.
+ */
+struct Value {
+    bool isnull = false;
+    int64_t i = 0;
+    double d = 0;
+    std::string text;
+    std::vector<int32_t> int4s;
+    std::vector<double> float8s;
+    std::vector<std::string> texts;
+    std::vector<std::vector<Value>> rows;   // composite elements
+};
+
+struct Shape {
+    std::string name;
+    std::vector<Column> columns;
+    std::vector<std::vector<Value>> rows;
+};
+
+static std::vector<uint8_t> msgpack_preencode_key(const std::string& name)
+{
+    std::vector<uint8_t> out;
+    if (name.size() <= 31) {
+        out.push_back(static_cast<uint8_t>(0xa0 | name.size()));
+    } else {
+        out.push_back(0xd9);
+        out.push_back(static_cast<uint8_t>(name.size()));
+    }
+    out.insert(out.end(), name.begin(), name.end());
+    return out;
+}
+
+static std::vector<uint8_t> cbor_preencode_key(const std::string& name)
+{
+    std::vector<uint8_t> out;
+    if (name.size() <= 23) {
+        out.push_back(static_cast<uint8_t>(0x60 | name.size()));
+    } else {
+        out.push_back(0x78);
+        out.push_back(static_cast<uint8_t>(name.size()));
+    }
+    out.insert(out.end(), name.begin(), name.end());
+    return out;
+}
+
+static void add_column(Shape& shape, std::string name, Kind kind, const Shape* composite = nullptr)
+{
+    std::vector<uint8_t> key = msgpack_preencode_key(name);
+    std::vector<uint8_t> cbor_key = cbor_preencode_key(name);
+    shape.columns.push_back(Column{std::move(name), kind, std::move(key), composite, std::move(cbor_key)});
+}
+
+static Value make_value(const Column& col, int row, int col_index)
+{
+    Value v;
+    const int seed = row * 31 + col_index * 7;
+    switch (col.kind) {
+        case Kind::Int4: v.i = seed % 100000 - 5000; break;
+        case Kind::Int8: v.i = static_cast<int64_t>(seed) * 92233720368547; break;
+        case Kind::Float8: v.d = seed / 8.0 - 3; break;
+        case Kind::Bool: v.i = seed % 2; break;
+        case Kind::Text: v.text = "value-" + std::to_string(seed % 997); break;
+        case Kind::Numeric:
+            v.text = std::to_string(seed % 1000000) + "." + std::to_string(seed % 97 + 100);
+            break;
+        case Kind::Int4Array:
+            for (int k = 0; k < 64; k++) v.int4s.push_back((seed + k) % 1000);
+            break;
+        case Kind::Float8Array:
+            for (int k = 0; k < 32; k++) v.float8s.push_back((seed + k) * 0.25);
+            break;
+        case Kind::TextArray:
+            for (int k = 0; k < 4; k++) v.texts.push_back("tag-" + std::to_string((seed + k) % 13));
+            break;
+        case Kind::Composite:
+            for (int k = 0; k < 4; k++) {
+                std::vector<Value> inner;
+                for (size_t c = 0; c < col.composite->columns.size(); c++) {
+                    inner.push_back(make_value(col.composite->columns[c], row + k,
+                                               static_cast<int>(c)));
+                }
+                v.rows.push_back(std::move(inner));
+            }
+            break;
+    }
+    if (col.kind != Kind::Composite && seed % 11 == 0) v.isnull = true;
+    return v;
+}
+
+static void fill_rows(Shape& shape, int nrows)
+{
+    for (int r = 0; r < nrows; r++) {
+        std::vector<Value> row;
+        for (size_t c = 0; c < shape.columns.size(); c++) {
+            row.push_back(make_value(shape.columns[c], r, static_cast<int>(c)));
+        }
+        shape.rows.push_back(std::move(row));
+    }
+}
+
+/* Stands in for numeric_parse_fast, which parses the rendered digits with fast_float. */
+static inline double numeric_text_to_double(const std::string& text)
+{
+    double out = 0;
+    fast_float::from_chars(text.data(), text.data() + text.size(), out);
+    return out;
+}
+
+template <typename WriterT>
+static void write_row(WriterT& writer, const Shape& shape, const std::vector<Value>& row);
+
+template <typename WriterT>
+static void write_value(WriterT& writer, const Column& col, const Value& v)
+{
+    if (v.isnull) {
+        writer.null();
+        return;
+    }
+    switch (col.kind) {
+        case Kind::Int4:
+        case Kind::Int8:
+            writer.int64(v.i);
+            return;
+        case Kind::Float8:
+            writer.double_(v.d);
+            return;
+        case Kind::Bool:
+            writer.boolean(v.i != 0);
+            return;
+        case Kind::Text:
+            writer.string(v.text);
+            return;
+        case Kind::Numeric:
+            writer.double_(numeric_text_to_double(v.text));
+            return;
+        case Kind::Int4Array:
+            writer.begin_array(v.int4s.size());
+            if constexpr (std::is_same_v<WriterT, z::MsgPackSerializer>) {
+                msgpack_write_int64_sequence(writer, reinterpret_cast<const int32*>(v.int4s.data()),
+                                             static_cast<int>(v.int4s.size()));
+            } else {
+                for (int32_t x : v.int4s) writer.int64(x);
+            }
+            writer.end_array();
+            return;
+        case Kind::Float8Array:
+            writer.begin_array(v.float8s.size());
+            if constexpr (std::is_same_v<WriterT, z::MsgPackSerializer>) {
+                msgpack_write_double_sequence(writer, v.float8s.data(),
+                                              static_cast<int>(v.float8s.size()));
+            } else {
+                for (double x : v.float8s) writer.double_(x);
+            }
+            writer.end_array();
+            return;
+        case Kind::TextArray:
+            writer.begin_array(v.texts.size());
+            for (const std::string& t : v.texts) writer.string(t);
+            writer.end_array();
+            return;
+        case Kind::Composite:
+            writer.begin_array(v.rows.size());
+            for (const std::vector<Value>& inner : v.rows) write_row(writer, *col.composite, inner);
+            writer.end_array();
+            return;
+    }
+}
+
+template <typename WriterT>
+static void write_row(WriterT& writer, const Shape& shape, const std::vector<Value>& row)
+{
+    writer.begin_map(shape.columns.size());
+    for (size_t c = 0; c < shape.columns.size(); c++) {
+        const Column& col = shape.columns[c];
+        if constexpr (std::is_same_v<WriterT, z::MsgPackSerializer>) {
+            writer.key_preencoded(col.msgpack_key.data(), col.msgpack_key.size());
+        } else if constexpr (std::is_same_v<WriterT, z::cborjc::Serializer>) {
+            writer.key_preencoded(col.cbor_key);
+        } else if constexpr (std::is_same_v<WriterT, z::flex::Serializer>) {
+            if (col.flex_key_document == writer.document()) {
+                writer.key_reused(col.flex_key);
+            } else {
+                col.flex_key = writer.key_for_reuse(col.name);
+                col.flex_key_document = writer.document();
+            }
+        } else {
+            writer.key(col.name);
+        }
+        write_value(writer, col, row[c]);
+    }
+    writer.end_map();
+}
+
+enum class Protocol { MsgPack, CBOR, Zera, Flex };
+
+/*
+ * Encodes the whole batch once per iteration into a root reused across
+ * iterations, as the backend-local roots are reused across calls.
+ */
+static void run_batch(benchmark::State& state, const Shape* shape, Protocol protocol, bool simd)
+{
+    simd_kernels_enabled = simd;
+    z::MsgPackRootSerializer msgpack_rs;
+    msgpack_rs.realloc_fn = counting_realloc;
+    std::vector<uint8_t> cbor_storage;
+    z::zera::RootSerializer zera_rs;
+    z::flex::RootSerializer flex_rs;
+    std::vector<uint8_t> zera_out;
+
+    const size_t nrows = shape->rows.size();
+    uint64_t total_bytes = 0;
+    const uint64_t allocs_before = allocation_count.load(std::memory_order_relaxed);
+
+    for (auto _ : state) {
+        size_t bytes = 0;
+        switch (protocol) {
+            case Protocol::MsgPack:
+            {
+                msgpack_rs.sbuf.size = 0;
+                z::MsgPackSerializer writer(msgpack_rs);
+                writer.begin_array(nrows);
+                for (const auto& row : shape->rows) write_row(writer, *shape, row);
+                writer.end_array();
+                bytes = msgpack_rs.sbuf.size;
+                benchmark::DoNotOptimize(msgpack_rs.sbuf.data);
+                break;
+            }
+            case Protocol::CBOR:
+            {
+                z::cborjc::RootSerializer rs(std::move(cbor_storage));
+                z::cborjc::Serializer writer(rs);
+                writer.begin_array(nrows);
+                for (const auto& row : shape->rows) write_row(writer, *shape, row);
+                writer.end_array();
+                bytes = rs.bytes().size();
+                cbor_storage = rs.release();
+                benchmark::DoNotOptimize(cbor_storage.data());
+                break;
+            }
+            case Protocol::Zera:
+            {
+                zera_rs.reset();
+                z::zera::Serializer writer(zera_rs);
+                writer.begin_array(nrows);
+                for (const auto& row : shape->rows) write_row(writer, *shape, row);
+                writer.end_array();
+                bytes = zera_rs.finished_size();
+                zera_out.resize(bytes);
+                zera_rs.finish_into(zera_out.data());
+                benchmark::DoNotOptimize(zera_out.data());
+                break;
+            }
+            case Protocol::Flex:
+            {
+                flex_rs.reset();
+                z::flex::Serializer writer(flex_rs);
+                writer.begin_array(nrows);
+                for (const auto& row : shape->rows) write_row(writer, *shape, row);
+                writer.end_array();
+                bytes = flex_rs.bytes().size();
+                benchmark::DoNotOptimize(flex_rs.bytes().data());
+                break;
+            }
+        }
+        total_bytes += bytes;
+        benchmark::ClobberMemory();
+    }
+
+    if (msgpack_rs.sbuf.data != nullptr) std::free(msgpack_rs.sbuf.data);
+    msgpack_rs.sbuf.data = nullptr;
+
+    const double rows = static_cast<double>(state.iterations()) * static_cast<double>(nrows);
+    const uint64_t allocs = allocation_count.load(std::memory_order_relaxed) - allocs_before;
+    state.SetItemsProcessed(static_cast<int64_t>(rows));
+    state.counters["ns/row"] = benchmark::Counter(
+        rows, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+    state.counters["bytes/row"] = static_cast<double>(total_bytes) / rows;
+    state.counters["allocs/row"] = static_cast<double>(allocs) / rows;
+}
+
+/* Loosely the tables of bench/microbench_setup.sql, plus a nested shape. */
+static std::vector<Shape*> build_shapes(int nrows)
+{
+    auto* narrow = new Shape{"narrow", {}, {}};
+    add_column(*narrow, "id", Kind::Int4);
+    add_column(*narrow, "active", Kind::Bool);
+    add_column(*narrow, "name", Kind::Text);
+    fill_rows(*narrow, nrows);
+
+    auto* wide = new Shape{"wide", {}, {}};
+    for (int i = 0; i < 4; i++) {
+        add_column(*wide, "i" + std::to_string(i), Kind::Int4);
+        add_column(*wide, "b" + std::to_string(i), Kind::Int8);
+        add_column(*wide, "f" + std::to_string(i), Kind::Float8);
+        add_column(*wide, "t" + std::to_string(i), Kind::Text);
+        add_column(*wide, "flag" + std::to_string(i), Kind::Bool);
+    }
+    fill_rows(*wide, nrows);
+
+    auto* arrays = new Shape{"arrays", {}, {}};
+    add_column(*arrays, "id", Kind::Int4);
+    add_column(*arrays, "ints", Kind::Int4Array);
+    add_column(*arrays, "floats", Kind::Float8Array);
+    add_column(*arrays, "tags", Kind::TextArray);
+    fill_rows(*arrays, nrows);
+
+    auto* numeric = new Shape{"numeric", {}, {}};
+    add_column(*numeric, "id", Kind::Int4);
+    for (int i = 0; i < 6; i++) add_column(*numeric, "n" + std::to_string(i), Kind::Numeric);
+    fill_rows(*numeric, nrows);
+
+    auto* inner = new Shape{"inner", {}, {}};
+    add_column(*inner, "k", Kind::Int4);
+    add_column(*inner, "v", Kind::Text);
+    add_column(*inner, "w", Kind::Float8);
+
+    auto* nested = new Shape{"nested", {}, {}};
+    add_column(*nested, "id", Kind::Int4);
+    add_column(*nested, "label", Kind::Text);
+    add_column(*nested, "items", Kind::Composite, inner);
+    fill_rows(*nested, nrows);
+
+    return {narrow, wide, arrays, numeric, nested};
+}
+
+int main(int argc, char** argv)
+{
+    const char* env_rows = std::getenv("PGZ_BENCH_ROWS");
+    const int nrows = env_rows != nullptr ? std::atoi(env_rows) : 1000;
+
+    static const std::pair<Protocol, const char*> protocols[] = {
+        {Protocol::MsgPack, "msgpack"},
+        {Protocol::CBOR, "cbor"},
+        {Protocol::Zera, "zera"},
+        {Protocol::Flex, "flex"},
+    };
+
+    for (Shape* shape : build_shapes(nrows)) {
+        for (const auto& [protocol, name] : protocols) {
+            benchmark::RegisterBenchmark((std::string(name) + "/" + shape->name).c_str(),
+                                         run_batch, shape, protocol, true);
+        }
+        if (shape->name == "arrays") {
+            benchmark::RegisterBenchmark("msgpack/arrays/simd_off", run_batch, shape,
+                                         Protocol::MsgPack, false);
+        }
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,5 @@
+-- SET STATISTICS rewrites the pg_attribute row even when the target does not
+-- change, and takes only ShareUpdateExclusiveLock, so encoders keep running
+-- while every backend receives a relcache invalidation for bench_churn. The
+-- statement has no variables so it also prepares under -M prepared.
+ALTER TABLE bench_churn ALTER COLUMN t0 SET STATISTICS 100;
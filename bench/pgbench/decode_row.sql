@@ -0,0 +1,3 @@
+\set id random(1, 120000)
+SELECT msgpack_to_jsonb(t.m), cbor_to_jsonb(t.c), zera_to_jsonb(t.z), flexbuffers_to_jsonb(t.f)
+FROM bench_decode t WHERE t.id = :id;
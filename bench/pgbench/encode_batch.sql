@@ -0,0 +1,2 @@
+\set id random(1, 119901)
+SELECT msgpack_rows_agg(t.*) FROM bench_wide t WHERE t.i0 BETWEEN :id AND :id + 99;
@@ -0,0 +1,2 @@
+\set id random(1, 120000)
+SELECT row_to_msgpack(t.*) FROM bench_wide t WHERE t.i0 = :id;
@@ -0,0 +1,17 @@
+\set ON_ERROR_STOP on
+
+SET client_min_messages TO warning;
+
+-- Point lookups for the pgbench scenarios; run after microbench_setup.sql.
+CREATE INDEX IF NOT EXISTS bench_wide_i0_idx ON bench_wide (i0);
+CREATE INDEX IF NOT EXISTS bench_decode_id_idx ON bench_decode (id);
+
+-- The invalidation storm alters this table, so the shared tables keep stable
+-- relcache entries for the other scenarios.
+DROP TABLE IF EXISTS bench_churn;
+CREATE TABLE bench_churn AS
+SELECT * FROM bench_wide;
+CREATE INDEX bench_churn_i0_idx ON bench_churn (i0);
+ANALYZE bench_wide;
+ANALYZE bench_decode;
+ANALYZE bench_churn;
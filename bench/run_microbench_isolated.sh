@@ -7,7 +7,7 @@ TS="$(date +%Y%m%d_%H%M%S)"
 OUT_FILE="${OUT_DIR}/microbench_isolated_${TS}.out"
 RUNS="${RUNS:-5}"
 WARMUP="${WARMUP:-1}"
-PROTOCOLS="${PROTOCOLS:-msgpack cbor zera flex}"
+PROTOCOLS="${PROTOCOLS:-msgpack cbor zera flex json}"
 
 mkdir -p "${OUT_DIR}"
 
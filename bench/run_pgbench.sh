@@ -0,0 +1,163 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+SCRIPT_DIR="${ROOT_DIR}/bench/pgbench"
+OUT_DIR="${ROOT_DIR}/results"
+TS="$(date +%Y%m%d_%H%M%S)"
+OUT_FILE="${OUT_DIR}/pgbench_${TS}.out"
+RUNS="${RUNS:-3}"
+WARMUP="${WARMUP:-1}"
+CLIENTS="${CLIENTS:-1 2 4 8 16}"
+DURATION="${DURATION:-10}"
+SCENARIOS="${SCENARIOS:-encode_row encode_row_to_jsonb encode_batch decode_row invalidation_storm}"
+CHURN_WEIGHT="${CHURN_WEIGHT:-1}"
+PGBENCH_MODE="${PGBENCH_MODE:-prepared}"
+SKIP_SETUP="${SKIP_SETUP:-0}"
+NPROC="$(getconf _NPROCESSORS_ONLN 2>/dev/null || echo 1)"
+
+mkdir -p "${OUT_DIR}"
+
+PGHOST="${PGHOST:-127.0.0.1}"
+PGPORT="${PGPORT:-5432}"
+PGUSER="${PGUSER:-postgres}"
+PGPASSWORD="${PGPASSWORD:-postgres}"
+PGDATABASE="${PGDATABASE:-postgres}"
+
+export PGHOST PGPORT PGUSER PGPASSWORD PGDATABASE
+
+# Private resident memory (RssAnon) of every pgbench backend, sampled halfway
+# through the last measured run. This covers the schema cache, the reusable
+# writer buffers, and palloc'd memory alike. Reading /proc needs a local Linux
+# server and superuser or pg_read_server_files; otherwise nothing is recorded.
+RSS_SQL="
+SELECT max(kb) || '|' || round(avg(kb)) || '|' ||
+       (SELECT substring(pg_read_file('/proc/' || pg_backend_pid() || '/status', true)
+                         FROM 'RssAnon:\\s+(\\d+) kB')) || '|' || count(kb)
+FROM (SELECT substring(pg_read_file('/proc/' || pid || '/status', true)
+                       FROM 'RssAnon:\\s+(\\d+) kB')::bigint AS kb
+      FROM pg_stat_activity
+      WHERE application_name = 'pgbench' AND backend_type = 'client backend') AS s
+HAVING count(kb) > 0"
+
+scenario_args() {
+  case "$1" in
+    encode_row|encode_row_to_jsonb|encode_batch|decode_row)
+      SCENARIO_ARGS=(-f "${SCRIPT_DIR}/$1.sql")
+      ;;
+    invalidation_storm)
+      SCENARIO_ARGS=(-f "${SCRIPT_DIR}/churn_encode.sql@$((100 - CHURN_WEIGHT))"
+                     -f "${SCRIPT_DIR}/churn_ddl.sql@${CHURN_WEIGHT}")
+      ;;
+    *)
+      echo "Unknown pgbench scenario: $1" >&2
+      exit 1
+      ;;
+  esac
+}
+
+echo "Running pg_zerialize pgbench scenarios..." | tee "${OUT_FILE}"
+{
+  echo "  host=${PGHOST} port=${PGPORT} db=${PGDATABASE} user=${PGUSER}"
+  echo "  runs=${RUNS} warmup=${WARMUP} duration=${DURATION}s mode=${PGBENCH_MODE}"
+  echo "  clients=${CLIENTS}"
+  echo "  scenarios=${SCENARIOS}"
+  echo "  output=${OUT_FILE}"
+} | tee -a "${OUT_FILE}"
+
+if [[ "${SKIP_SETUP}" != "1" ]]; then
+  {
+    echo "Running setup SQL..."
+    psql -v ON_ERROR_STOP=1 -f "${ROOT_DIR}/bench/microbench_setup.sql"
+    psql -v ON_ERROR_STOP=1 -f "${SCRIPT_DIR}/setup.sql"
+  } | tee -a "${OUT_FILE}"
+fi
+
+TMP_RUN="$(mktemp /tmp/pgbench_run.XXXXXX)"
+TMP_RESULTS="$(mktemp /tmp/pgbench_results.XXXXXX)"
+TMP_TPS="$(mktemp /tmp/pgbench_tps.XXXXXX)"
+TMP_MEMORY="$(mktemp /tmp/pgbench_memory.XXXXXX)"
+trap 'rm -f "${TMP_RUN}" "${TMP_RESULTS}" "${TMP_TPS}" "${TMP_MEMORY}"' EXIT
+
+for scenario in ${SCENARIOS}; do
+  scenario_args "${scenario}"
+  for clients in ${CLIENTS}; do
+    label="pgbench_${scenario}_c${clients}"
+    jobs=$(( clients < NPROC ? clients : NPROC ))
+    latencies=""
+    tps_values=""
+    echo | tee -a "${OUT_FILE}"
+    echo "Running ${label}" | tee -a "${OUT_FILE}"
+
+    for (( run = 1; run <= WARMUP + RUNS; run++ )); do
+      pgbench -n -M "${PGBENCH_MODE}" -c "${clients}" -j "${jobs}" -T "${DURATION}" \
+        "${SCENARIO_ARGS[@]}" > "${TMP_RUN}" 2>&1 &
+      pid=$!
+      rss=""
+      if (( run == WARMUP + RUNS )); then
+        sleep $(( (DURATION + 1) / 2 ))
+        rss="$(psql -X -At -c "${RSS_SQL}" 2>/dev/null || true)"
+      fi
+      if ! wait "${pid}"; then
+        cat "${TMP_RUN}" >&2
+        exit 1
+      fi
+
+      latency="$(awk '/^latency average = / {print $4}' "${TMP_RUN}")"
+      tps="$(awk '/^tps = / {print $3}' "${TMP_RUN}")"
+      if (( run <= WARMUP )); then
+        echo "  warmup ${run}: latency_ms=${latency} tps=${tps}" | tee -a "${OUT_FILE}"
+        continue
+      fi
+      echo "  run $(( run - WARMUP )): latency_ms=${latency} tps=${tps}" | tee -a "${OUT_FILE}"
+      latencies="${latencies} ${latency}"
+      tps_values="${tps_values} ${tps}"
+      if [[ -n "${rss}" ]]; then
+        echo "  backend RssAnon kB (max|avg|fresh backend|backends): ${rss}" | tee -a "${OUT_FILE}"
+        echo "${label}|${rss}" >> "${TMP_MEMORY}"
+      fi
+    done
+
+    # Same line format as the SQL harness, with per-run latency averages in
+    # place of per-query times, so compare_results.sh gates both alike.
+    echo "${latencies}" | awk -v label="${label}" -v runs="${RUNS}" -v warmup="${WARMUP}" \
+      -v ts="$(date +%Y-%m-%dT%H:%M:%S%:::z)" '{
+        min = $1; max = $1; sum = 0
+        for (i = 1; i <= NF; i++) {
+          sum += $i
+          if ($i < min) min = $i
+          if ($i > max) max = $i
+        }
+        printf "%s|%.3f|%.3f|%.3f|%d|%d|%s\n", label, sum / NF, min, max, runs, warmup, ts
+      }' >> "${TMP_RESULTS}"
+    echo "${tps_values}" | awk -v label="${label}" '{
+        min = $1; max = $1; sum = 0
+        for (i = 1; i <= NF; i++) {
+          sum += $i
+          if ($i < min) min = $i
+          if ($i > max) max = $i
+        }
+        printf "%s|%.1f|%.1f|%.1f\n", label, sum / NF, min, max
+      }' >> "${TMP_TPS}"
+  done
+done
+
+{
+  echo
+  echo "BENCH_RESULTS_BEGIN"
+  cat "${TMP_RESULTS}"
+  echo "BENCH_RESULTS_END"
+  echo
+  echo "BENCH_THROUGHPUT_BEGIN"
+  cat "${TMP_TPS}"
+  echo "BENCH_THROUGHPUT_END"
+  echo
+  echo "BENCH_MEMORY_BEGIN"
+  cat "${TMP_MEMORY}"
+  echo "BENCH_MEMORY_END"
+} | tee -a "${OUT_FILE}"
+
+echo
+echo "Saved benchmark output: ${OUT_FILE}"
+echo "Latest symlink update: ${OUT_DIR}/pgbench_latest.out"
+ln -sf "$(basename "${OUT_FILE}")" "${OUT_DIR}/pgbench_latest.out"
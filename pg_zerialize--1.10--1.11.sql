@@ -0,0 +1,18 @@
+-- pg_zerialize extension upgrade from 1.10 to 1.11.
+
+-- Batch splitting; each element is returned as its own document
+CREATE OR REPLACE FUNCTION msgpack_array_elements(bytea)
+RETURNS SETOF bytea
+AS 'MODULE_PATHNAME', 'msgpack_array_elements'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION msgpack_array_elements(bytea) IS
+'Return each element of a MessagePack array as a standalone MessagePack value';
+
+CREATE OR REPLACE FUNCTION cbor_array_elements(bytea)
+RETURNS SETOF bytea
+AS 'MODULE_PATHNAME', 'cbor_array_elements'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION cbor_array_elements(bytea) IS
+'Return each element of a CBOR array as a standalone CBOR data item';
@@ -0,0 +1,66 @@
+-- pg_zerialize extension upgrade from 1.11 to 1.12.
+
+-- Column projection; only the named columns are emitted, in list order
+CREATE OR REPLACE FUNCTION row_to_flexbuffers(record, text[])
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'row_to_flexbuffers_columns'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION row_to_flexbuffers(record, text[]) IS
+'Convert the named columns of a PostgreSQL row/record to FlexBuffers binary format';
+
+CREATE OR REPLACE FUNCTION rows_to_flexbuffers(anyarray, text[])
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'rows_to_flexbuffers_columns'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION rows_to_flexbuffers(anyarray, text[]) IS
+'Convert the named columns of an array of PostgreSQL rows/records to FlexBuffers binary format (batch processing)';
+
+CREATE OR REPLACE FUNCTION row_to_msgpack(record, text[])
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'row_to_msgpack_columns'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION row_to_msgpack(record, text[]) IS
+'Convert the named columns of a PostgreSQL row/record to MessagePack binary format';
+
+CREATE OR REPLACE FUNCTION rows_to_msgpack(anyarray, text[])
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'rows_to_msgpack_columns'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION rows_to_msgpack(anyarray, text[]) IS
+'Convert the named columns of an array of PostgreSQL rows/records to MessagePack binary format (batch processing)';
+
+CREATE OR REPLACE FUNCTION row_to_cbor(record, text[])
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'row_to_cbor_columns'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION row_to_cbor(record, text[]) IS
+'Convert the named columns of a PostgreSQL row/record to CBOR binary format';
+
+CREATE OR REPLACE FUNCTION rows_to_cbor(anyarray, text[])
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'rows_to_cbor_columns'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION rows_to_cbor(anyarray, text[]) IS
+'Convert the named columns of an array of PostgreSQL rows/records to CBOR binary format (batch processing)';
+
+CREATE OR REPLACE FUNCTION row_to_zera(record, text[])
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'row_to_zera_columns'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION row_to_zera(record, text[]) IS
+'Convert the named columns of a PostgreSQL row/record to ZERA binary format';
+
+CREATE OR REPLACE FUNCTION rows_to_zera(anyarray, text[])
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'rows_to_zera_columns'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION rows_to_zera(anyarray, text[]) IS
+'Convert the named columns of an array of PostgreSQL rows/records to ZERA binary format (batch processing)';
@@ -0,0 +1,29 @@
+-- pg_zerialize extension upgrade from 1.12 to 1.13.
+
+-- Compact batches; column names once, rows as positional arrays
+CREATE OR REPLACE FUNCTION rows_to_msgpack_compact(anyarray)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'rows_to_msgpack_compact'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION rows_to_msgpack_compact(anyarray) IS
+'Convert an array of PostgreSQL rows/records to a compact MessagePack batch of column names and positional rows';
+
+CREATE OR REPLACE FUNCTION rows_to_cbor_compact(anyarray)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'rows_to_cbor_compact'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION rows_to_cbor_compact(anyarray) IS
+'Convert an array of PostgreSQL rows/records to a compact CBOR batch of column names and positional rows';
+
+CREATE OR REPLACE FUNCTION rows_to_zera_compact(anyarray)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'rows_to_zera_compact'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION rows_to_zera_compact(anyarray) IS
+'Convert an array of PostgreSQL rows/records to a compact ZERA batch of column names and positional rows';
+
+COMMENT ON FUNCTION msgpack_to_recordset(anyelement, bytea) IS
+'Decode a MessagePack array of maps, or a rows_to_msgpack_compact batch, into rows of the first argument''s type';
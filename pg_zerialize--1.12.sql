@@ -0,0 +1,480 @@
+-- pg_zerialize extension SQL definitions, version 1.12
+
+-- Function to convert a row to FlexBuffers format
+CREATE OR REPLACE FUNCTION row_to_flexbuffers(record)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'row_to_flexbuffers'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION row_to_flexbuffers(record) IS
+'Convert a PostgreSQL row/record to FlexBuffers binary format';
+
+-- Function to convert a row to MessagePack format
+CREATE OR REPLACE FUNCTION row_to_msgpack(record)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'row_to_msgpack'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION row_to_msgpack(record) IS
+'Convert a PostgreSQL row/record to MessagePack binary format';
+
+-- Test helper: force generic (slow) MessagePack path for parity validation
+CREATE OR REPLACE FUNCTION row_to_msgpack_slow(record)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'row_to_msgpack_slow'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION row_to_msgpack_slow(record) IS
+'Convert a PostgreSQL row/record to MessagePack using generic slow path (test/parity helper)';
+
+-- Convert nested jsonb to nested MessagePack
+CREATE OR REPLACE FUNCTION msgpack_from_jsonb(jsonb)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'msgpack_from_jsonb'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION msgpack_from_jsonb(jsonb) IS
+'Convert jsonb value (including nested objects/arrays) to MessagePack';
+
+CREATE OR REPLACE FUNCTION msgpack_to_jsonb(bytea)
+RETURNS jsonb
+AS 'MODULE_PATHNAME', 'msgpack_to_jsonb'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION msgpack_to_jsonb(bytea) IS
+'Decode one MessagePack value to jsonb; binary values use a tagged base64 array';
+
+CREATE OR REPLACE FUNCTION flexbuffers_to_jsonb(bytea)
+RETURNS jsonb
+AS 'MODULE_PATHNAME', 'flexbuffers_to_jsonb'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION flexbuffers_to_jsonb(bytea) IS
+'Decode one verified FlexBuffer value to jsonb; blobs use a tagged base64 array';
+
+CREATE OR REPLACE FUNCTION cbor_to_jsonb(bytea)
+RETURNS jsonb
+AS 'MODULE_PATHNAME', 'cbor_to_jsonb'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION cbor_to_jsonb(bytea) IS
+'Strictly decode one CBOR value to jsonb; byte strings use a tagged base64 array';
+
+CREATE OR REPLACE FUNCTION zera_to_jsonb(bytea)
+RETURNS jsonb
+AS 'MODULE_PATHNAME', 'zera_to_jsonb'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION zera_to_jsonb(bytea) IS
+'Validate and decode one ZERA v1 document to jsonb; U8 typed arrays use base64';
+
+-- SQL-builder style wrappers
+CREATE OR REPLACE FUNCTION msgpack_build_object(VARIADIC "any")
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'msgpack_build_object'
+LANGUAGE C STABLE;
+
+COMMENT ON FUNCTION msgpack_build_object(VARIADIC "any") IS
+'Build a MessagePack object from key/value pairs (json_build_object-style)';
+
+CREATE OR REPLACE FUNCTION msgpack_build_array(VARIADIC "any")
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'msgpack_build_array'
+LANGUAGE C STABLE;
+
+COMMENT ON FUNCTION msgpack_build_array(VARIADIC "any") IS
+'Build a MessagePack array from variadic values (json_build_array-style)';
+
+-- Aggregate support functions
+CREATE OR REPLACE FUNCTION msgpack_agg_transfn(internal, anyelement)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'msgpack_agg_transfn'
+LANGUAGE C;
+
+CREATE OR REPLACE FUNCTION msgpack_agg_finalfn(internal)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'msgpack_agg_finalfn'
+LANGUAGE C PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION msgpack_object_agg_transfn(internal, text, anyelement)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'msgpack_object_agg_transfn'
+LANGUAGE C;
+
+CREATE OR REPLACE FUNCTION msgpack_object_agg_finalfn(internal)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'msgpack_object_agg_finalfn'
+LANGUAGE C;
+
+CREATE AGGREGATE msgpack_agg(anyelement)
+(
+    SFUNC = msgpack_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = msgpack_agg_finalfn
+);
+
+COMMENT ON AGGREGATE msgpack_agg(anyelement) IS
+'Aggregate values into a MessagePack array (json_agg-style)';
+
+CREATE AGGREGATE msgpack_object_agg(text, anyelement)
+(
+    SFUNC = msgpack_object_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = msgpack_object_agg_finalfn
+);
+
+COMMENT ON AGGREGATE msgpack_object_agg(text, anyelement) IS
+'Aggregate key/value pairs into a MessagePack object (json_object_agg-style)';
+
+-- Function to convert a row to CBOR format
+CREATE OR REPLACE FUNCTION row_to_cbor(record)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'row_to_cbor'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION row_to_cbor(record) IS
+'Convert a PostgreSQL row/record to CBOR binary format';
+
+-- Function to convert a row to ZERA format
+CREATE OR REPLACE FUNCTION row_to_zera(record)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'row_to_zera'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION row_to_zera(record) IS
+'Convert a PostgreSQL row/record to ZERA binary format (zerialize native protocol)';
+
+-- Batch processing functions (multiple rows at once for better performance)
+
+-- Function to convert an array of rows to FlexBuffers format
+CREATE OR REPLACE FUNCTION rows_to_flexbuffers(anyarray)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'rows_to_flexbuffers'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION rows_to_flexbuffers(anyarray) IS
+'Convert an array of PostgreSQL rows/records to FlexBuffers binary format (batch processing)';
+
+-- Function to convert an array of rows to MessagePack format
+CREATE OR REPLACE FUNCTION rows_to_msgpack(anyarray)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'rows_to_msgpack'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION rows_to_msgpack(anyarray) IS
+'Convert an array of PostgreSQL rows/records to MessagePack binary format (batch processing)';
+
+-- Test helper: force generic (slow) MessagePack batch path for parity validation
+CREATE OR REPLACE FUNCTION rows_to_msgpack_slow(anyarray)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'rows_to_msgpack_slow'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION rows_to_msgpack_slow(anyarray) IS
+'Convert an array of PostgreSQL rows/records to MessagePack using generic slow path (test/parity helper)';
+
+-- Function to convert an array of rows to CBOR format
+CREATE OR REPLACE FUNCTION rows_to_cbor(anyarray)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'rows_to_cbor'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION rows_to_cbor(anyarray) IS
+'Convert an array of PostgreSQL rows/records to CBOR binary format (batch processing)';
+
+-- Function to convert an array of rows to ZERA format
+CREATE OR REPLACE FUNCTION rows_to_zera(anyarray)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'rows_to_zera'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION rows_to_zera(anyarray) IS
+'Convert an array of PostgreSQL rows/records to ZERA binary format (batch processing)';
+
+-- Batch aggregates; partial states are MessagePack rows and combine by concatenation
+CREATE OR REPLACE FUNCTION msgpack_rows_agg_transfn(internal, record)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'msgpack_rows_agg_transfn'
+LANGUAGE C PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION msgpack_rows_agg_combinefn(internal, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'msgpack_rows_agg_combinefn'
+LANGUAGE C PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION msgpack_rows_agg_serialfn(internal)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'msgpack_rows_agg_serialfn'
+LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION msgpack_rows_agg_deserialfn(bytea, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'msgpack_rows_agg_deserialfn'
+LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION cbor_rows_agg_finalfn(internal)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'cbor_rows_agg_finalfn'
+LANGUAGE C PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION zera_rows_agg_finalfn(internal)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'zera_rows_agg_finalfn'
+LANGUAGE C PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION flexbuffers_rows_agg_finalfn(internal)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'flexbuffers_rows_agg_finalfn'
+LANGUAGE C PARALLEL SAFE;
+
+CREATE AGGREGATE msgpack_rows_agg(record)
+(
+    SFUNC = msgpack_rows_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = msgpack_agg_finalfn,
+    COMBINEFUNC = msgpack_rows_agg_combinefn,
+    SERIALFUNC = msgpack_rows_agg_serialfn,
+    DESERIALFUNC = msgpack_rows_agg_deserialfn,
+    PARALLEL = SAFE
+);
+
+COMMENT ON AGGREGATE msgpack_rows_agg(record) IS
+'Aggregate records into one MessagePack array (rows_to_msgpack-style, parallel safe)';
+
+CREATE AGGREGATE cbor_rows_agg(record)
+(
+    SFUNC = msgpack_rows_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = cbor_rows_agg_finalfn,
+    COMBINEFUNC = msgpack_rows_agg_combinefn,
+    SERIALFUNC = msgpack_rows_agg_serialfn,
+    DESERIALFUNC = msgpack_rows_agg_deserialfn,
+    PARALLEL = SAFE
+);
+
+COMMENT ON AGGREGATE cbor_rows_agg(record) IS
+'Aggregate records into one CBOR array (rows_to_cbor-style, parallel safe)';
+
+CREATE AGGREGATE zera_rows_agg(record)
+(
+    SFUNC = msgpack_rows_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = zera_rows_agg_finalfn,
+    COMBINEFUNC = msgpack_rows_agg_combinefn,
+    SERIALFUNC = msgpack_rows_agg_serialfn,
+    DESERIALFUNC = msgpack_rows_agg_deserialfn,
+    PARALLEL = SAFE
+);
+
+COMMENT ON AGGREGATE zera_rows_agg(record) IS
+'Aggregate records into one ZERA array (rows_to_zera-style, parallel safe)';
+
+CREATE AGGREGATE flexbuffers_rows_agg(record)
+(
+    SFUNC = msgpack_rows_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = flexbuffers_rows_agg_finalfn,
+    COMBINEFUNC = msgpack_rows_agg_combinefn,
+    SERIALFUNC = msgpack_rows_agg_serialfn,
+    DESERIALFUNC = msgpack_rows_agg_deserialfn,
+    PARALLEL = SAFE
+);
+
+COMMENT ON AGGREGATE flexbuffers_rows_agg(record) IS
+'Aggregate records into one FlexBuffers vector (rows_to_flexbuffers-style, parallel safe)';
+
+-- Path extraction; paths follow jsonb #> (map keys, zero-based array indexes)
+CREATE OR REPLACE FUNCTION msgpack_extract(bytea, text[])
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'msgpack_extract'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION msgpack_extract(bytea, text[]) IS
+'Return the MessagePack value at a path without decoding the rest of the document';
+
+CREATE OR REPLACE FUNCTION msgpack_extract_text(bytea, text[])
+RETURNS text
+AS 'MODULE_PATHNAME', 'msgpack_extract_text'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION msgpack_extract_text(bytea, text[]) IS
+'Extract the MessagePack value at a path as text, matching msgpack_to_jsonb(...) #>> path';
+
+CREATE OR REPLACE FUNCTION msgpack_extract_int8(bytea, text[])
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'msgpack_extract_int8'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION msgpack_extract_int8(bytea, text[]) IS
+'Extract the MessagePack integer at a path as bigint';
+
+CREATE OR REPLACE FUNCTION msgpack_extract_float8(bytea, text[])
+RETURNS double precision
+AS 'MODULE_PATHNAME', 'msgpack_extract_float8'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION msgpack_extract_float8(bytea, text[]) IS
+'Extract the MessagePack number at a path as double precision';
+
+CREATE OR REPLACE FUNCTION cbor_extract(bytea, text[])
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'cbor_extract'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION cbor_extract(bytea, text[]) IS
+'Return the CBOR data item at a path without decoding the rest of the document';
+
+CREATE OR REPLACE FUNCTION cbor_extract_text(bytea, text[])
+RETURNS text
+AS 'MODULE_PATHNAME', 'cbor_extract_text'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION cbor_extract_text(bytea, text[]) IS
+'Extract the CBOR value at a path as text, matching cbor_to_jsonb(...) #>> path';
+
+CREATE OR REPLACE FUNCTION cbor_extract_int8(bytea, text[])
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'cbor_extract_int8'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION cbor_extract_int8(bytea, text[]) IS
+'Extract the CBOR integer at a path as bigint';
+
+CREATE OR REPLACE FUNCTION cbor_extract_float8(bytea, text[])
+RETURNS double precision
+AS 'MODULE_PATHNAME', 'cbor_extract_float8'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION cbor_extract_float8(bytea, text[]) IS
+'Extract the CBOR number at a path as double precision';
+
+CREATE OR REPLACE FUNCTION zera_extract(bytea, text[])
+RETURNS jsonb
+AS 'MODULE_PATHNAME', 'zera_extract'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION zera_extract(bytea, text[]) IS
+'Decode only the ZERA value at a path to jsonb';
+
+CREATE OR REPLACE FUNCTION zera_extract_text(bytea, text[])
+RETURNS text
+AS 'MODULE_PATHNAME', 'zera_extract_text'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION zera_extract_text(bytea, text[]) IS
+'Extract the ZERA value at a path as text, matching zera_to_jsonb(...) #>> path';
+
+CREATE OR REPLACE FUNCTION zera_extract_int8(bytea, text[])
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'zera_extract_int8'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION zera_extract_int8(bytea, text[]) IS
+'Extract the ZERA integer at a path as bigint';
+
+CREATE OR REPLACE FUNCTION zera_extract_float8(bytea, text[])
+RETURNS double precision
+AS 'MODULE_PATHNAME', 'zera_extract_float8'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION zera_extract_float8(bytea, text[]) IS
+'Extract the ZERA number at a path as double precision';
+
+-- Record decoding; keys map to attributes through the cached row schema
+CREATE OR REPLACE FUNCTION msgpack_populate_record(anyelement, bytea)
+RETURNS anyelement
+AS 'MODULE_PATHNAME', 'msgpack_populate_record'
+LANGUAGE C STABLE PARALLEL SAFE;
+
+COMMENT ON FUNCTION msgpack_populate_record(anyelement, bytea) IS
+'Decode a MessagePack map into a row of the first argument''s type, keeping its values for missing keys';
+
+CREATE OR REPLACE FUNCTION msgpack_to_recordset(anyelement, bytea)
+RETURNS SETOF anyelement
+AS 'MODULE_PATHNAME', 'msgpack_to_recordset'
+LANGUAGE C STABLE PARALLEL SAFE;
+
+COMMENT ON FUNCTION msgpack_to_recordset(anyelement, bytea) IS
+'Decode a MessagePack array of maps, such as a rows_to_msgpack batch, into rows of the first argument''s type';
+
+-- Batch splitting; each element is returned as its own document
+CREATE OR REPLACE FUNCTION msgpack_array_elements(bytea)
+RETURNS SETOF bytea
+AS 'MODULE_PATHNAME', 'msgpack_array_elements'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION msgpack_array_elements(bytea) IS
+'Return each element of a MessagePack array as a standalone MessagePack value';
+
+CREATE OR REPLACE FUNCTION cbor_array_elements(bytea)
+RETURNS SETOF bytea
+AS 'MODULE_PATHNAME', 'cbor_array_elements'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION cbor_array_elements(bytea) IS
+'Return each element of a CBOR array as a standalone CBOR data item';
+
+-- Column projection; only the named columns are emitted, in list order
+CREATE OR REPLACE FUNCTION row_to_flexbuffers(record, text[])
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'row_to_flexbuffers_columns'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION row_to_flexbuffers(record, text[]) IS
+'Convert the named columns of a PostgreSQL row/record to FlexBuffers binary format';
+
+CREATE OR REPLACE FUNCTION rows_to_flexbuffers(anyarray, text[])
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'rows_to_flexbuffers_columns'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION rows_to_flexbuffers(anyarray, text[]) IS
+'Convert the named columns of an array of PostgreSQL rows/records to FlexBuffers binary format (batch processing)';
+
+CREATE OR REPLACE FUNCTION row_to_msgpack(record, text[])
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'row_to_msgpack_columns'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION row_to_msgpack(record, text[]) IS
+'Convert the named columns of a PostgreSQL row/record to MessagePack binary format';
+
+CREATE OR REPLACE FUNCTION rows_to_msgpack(anyarray, text[])
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'rows_to_msgpack_columns'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION rows_to_msgpack(anyarray, text[]) IS
+'Convert the named columns of an array of PostgreSQL rows/records to MessagePack binary format (batch processing)';
+
+CREATE OR REPLACE FUNCTION row_to_cbor(record, text[])
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'row_to_cbor_columns'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION row_to_cbor(record, text[]) IS
+'Convert the named columns of a PostgreSQL row/record to CBOR binary format';
+
+CREATE OR REPLACE FUNCTION rows_to_cbor(anyarray, text[])
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'rows_to_cbor_columns'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION rows_to_cbor(anyarray, text[]) IS
+'Convert the named columns of an array of PostgreSQL rows/records to CBOR binary format (batch processing)';
+
+CREATE OR REPLACE FUNCTION row_to_zera(record, text[])
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'row_to_zera_columns'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION row_to_zera(record, text[]) IS
+'Convert the named columns of a PostgreSQL row/record to ZERA binary format';
+
+CREATE OR REPLACE FUNCTION rows_to_zera(anyarray, text[])
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'rows_to_zera_columns'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION rows_to_zera(anyarray, text[]) IS
+'Convert the named columns of an array of PostgreSQL rows/records to ZERA binary format (batch processing)';
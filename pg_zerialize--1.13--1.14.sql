@@ -0,0 +1,10 @@
+-- pg_zerialize extension upgrade from 1.13 to 1.14.
+
+-- Columnar ZERA batches; one contiguous buffer per column
+CREATE OR REPLACE FUNCTION rows_to_zera_columnar(anyarray)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'rows_to_zera_columnar'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION rows_to_zera_columnar(anyarray) IS
+'Convert an array of PostgreSQL rows/records to a columnar ZERA batch with one typed buffer per column';
@@ -0,0 +1,10 @@
+-- pg_zerialize extension upgrade from 1.14 to 1.15.
+
+-- Chunked query export without building one large bytea
+CREATE OR REPLACE FUNCTION msgpack_stream(query text, chunk_bytes integer DEFAULT 1048576)
+RETURNS SETOF bytea
+AS 'MODULE_PATHNAME', 'msgpack_stream'
+LANGUAGE C VOLATILE STRICT PARALLEL UNSAFE;
+
+COMMENT ON FUNCTION msgpack_stream(text, integer) IS
+'Run a query and return its rows as MessagePack arrays of row maps, one chunk per chunk_bytes of encoded rows';
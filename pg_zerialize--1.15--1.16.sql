@@ -0,0 +1,34 @@
+-- pg_zerialize extension upgrade from 1.15 to 1.16.
+
+-- CBOR and ZERA SQL builders
+CREATE OR REPLACE FUNCTION cbor_build_object(VARIADIC "any")
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'cbor_build_object'
+LANGUAGE C STABLE;
+
+COMMENT ON FUNCTION cbor_build_object(VARIADIC "any") IS
+'Build a CBOR object from key/value pairs (json_build_object-style)';
+
+CREATE OR REPLACE FUNCTION cbor_build_array(VARIADIC "any")
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'cbor_build_array'
+LANGUAGE C STABLE;
+
+COMMENT ON FUNCTION cbor_build_array(VARIADIC "any") IS
+'Build a CBOR array from variadic values (json_build_array-style)';
+
+CREATE OR REPLACE FUNCTION zera_build_object(VARIADIC "any")
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'zera_build_object'
+LANGUAGE C STABLE;
+
+COMMENT ON FUNCTION zera_build_object(VARIADIC "any") IS
+'Build a ZERA object from key/value pairs (json_build_object-style)';
+
+CREATE OR REPLACE FUNCTION zera_build_array(VARIADIC "any")
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'zera_build_array'
+LANGUAGE C STABLE;
+
+COMMENT ON FUNCTION zera_build_array(VARIADIC "any") IS
+'Build a ZERA array from variadic values (json_build_array-style)';
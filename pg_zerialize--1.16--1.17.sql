@@ -0,0 +1,44 @@
+-- pg_zerialize extension upgrade from 1.16 to 1.17.
+
+-- Path and schema cache instrumentation
+CREATE OR REPLACE FUNCTION pg_zerialize_stats(
+    shared boolean DEFAULT false,
+    OUT metric text,
+    OUT protocol text,
+    OUT entry_point text,
+    OUT value bigint)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME', 'pg_zerialize_stats'
+LANGUAGE C VOLATILE STRICT;
+
+COMMENT ON FUNCTION pg_zerialize_stats(boolean) IS
+'Fast-path, fallback, row, byte, and schema cache counters for this backend, or for all backends when preloaded and shared is true';
+
+CREATE OR REPLACE FUNCTION pg_zerialize_stats_reset()
+RETURNS void
+AS 'MODULE_PATHNAME', 'pg_zerialize_stats_reset'
+LANGUAGE C VOLATILE;
+
+COMMENT ON FUNCTION pg_zerialize_stats_reset() IS
+'Reset this backend''s pg_zerialize counters';
+
+CREATE OR REPLACE FUNCTION pg_zerialize_schema_cache(
+    OUT type regtype,
+    OUT typmod integer,
+    OUT projected boolean,
+    OUT columns text[],
+    OUT fallback_columns integer,
+    OUT nested boolean,
+    OUT msgpack_fast boolean,
+    OUT cbor_fast boolean,
+    OUT zera_fast boolean,
+    OUT flex_fast boolean)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME', 'pg_zerialize_schema_cache'
+LANGUAGE C VOLATILE;
+
+COMMENT ON FUNCTION pg_zerialize_schema_cache() IS
+'Row schemas cached by this backend with their fast-path flags';
+
+CREATE OR REPLACE VIEW pg_zerialize_schema_cache AS
+SELECT * FROM pg_zerialize_schema_cache();
@@ -0,0 +1,42 @@
+-- pg_zerialize extension upgrade from 1.17 to 1.18.
+
+-- Compressed batches; the *_to_jsonb decoders and zerialize_decompress unwrap them
+CREATE OR REPLACE FUNCTION rows_to_flexbuffers(anyarray, compression text, level integer DEFAULT 0)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'rows_to_flexbuffers_compressed'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION rows_to_flexbuffers(anyarray, text, integer) IS
+'Convert an array of PostgreSQL rows/records to FlexBuffers compressed with lz4 or zstd (batch processing)';
+
+CREATE OR REPLACE FUNCTION rows_to_msgpack(anyarray, compression text, level integer DEFAULT 0)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'rows_to_msgpack_compressed'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION rows_to_msgpack(anyarray, text, integer) IS
+'Convert an array of PostgreSQL rows/records to MessagePack compressed with lz4 or zstd (batch processing)';
+
+CREATE OR REPLACE FUNCTION rows_to_cbor(anyarray, compression text, level integer DEFAULT 0)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'rows_to_cbor_compressed'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION rows_to_cbor(anyarray, text, integer) IS
+'Convert an array of PostgreSQL rows/records to CBOR compressed with lz4 or zstd (batch processing)';
+
+CREATE OR REPLACE FUNCTION rows_to_zera(anyarray, compression text, level integer DEFAULT 0)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'rows_to_zera_compressed'
+LANGUAGE C STABLE STRICT;
+
+COMMENT ON FUNCTION rows_to_zera(anyarray, text, integer) IS
+'Convert an array of PostgreSQL rows/records to ZERA compressed with lz4 or zstd (batch processing)';
+
+CREATE OR REPLACE FUNCTION zerialize_decompress(bytea)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'zerialize_decompress'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION zerialize_decompress(bytea) IS
+'Decompress a compressed rows_to_* batch; other input is returned unchanged';
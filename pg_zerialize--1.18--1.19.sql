@@ -0,0 +1,98 @@
+-- pg_zerialize extension upgrade from 1.18 to 1.19.
+
+-- Direct protocol-to-protocol transcoders; compressed frames are accepted as input
+CREATE OR REPLACE FUNCTION msgpack_to_cbor(bytea)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'msgpack_to_cbor'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION msgpack_to_cbor(bytea) IS
+'Transcode one MessagePack value to CBOR without an intermediate jsonb or dynamic tree';
+
+CREATE OR REPLACE FUNCTION msgpack_to_zera(bytea)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'msgpack_to_zera'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION msgpack_to_zera(bytea) IS
+'Transcode one MessagePack value to ZERA without an intermediate jsonb or dynamic tree';
+
+CREATE OR REPLACE FUNCTION msgpack_to_flexbuffers(bytea)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'msgpack_to_flexbuffers'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION msgpack_to_flexbuffers(bytea) IS
+'Transcode one MessagePack value to FlexBuffers without an intermediate jsonb or dynamic tree';
+
+CREATE OR REPLACE FUNCTION cbor_to_msgpack(bytea)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'cbor_to_msgpack'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION cbor_to_msgpack(bytea) IS
+'Transcode one CBOR value to MessagePack without an intermediate jsonb or dynamic tree';
+
+CREATE OR REPLACE FUNCTION cbor_to_zera(bytea)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'cbor_to_zera'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION cbor_to_zera(bytea) IS
+'Transcode one CBOR value to ZERA without an intermediate jsonb or dynamic tree';
+
+CREATE OR REPLACE FUNCTION cbor_to_flexbuffers(bytea)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'cbor_to_flexbuffers'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION cbor_to_flexbuffers(bytea) IS
+'Transcode one CBOR value to FlexBuffers without an intermediate jsonb or dynamic tree';
+
+CREATE OR REPLACE FUNCTION zera_to_msgpack(bytea)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'zera_to_msgpack'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION zera_to_msgpack(bytea) IS
+'Transcode one ZERA value to MessagePack without an intermediate jsonb or dynamic tree';
+
+CREATE OR REPLACE FUNCTION zera_to_cbor(bytea)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'zera_to_cbor'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION zera_to_cbor(bytea) IS
+'Transcode one ZERA value to CBOR without an intermediate jsonb or dynamic tree';
+
+CREATE OR REPLACE FUNCTION zera_to_flexbuffers(bytea)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'zera_to_flexbuffers'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION zera_to_flexbuffers(bytea) IS
+'Transcode one ZERA value to FlexBuffers without an intermediate jsonb or dynamic tree';
+
+CREATE OR REPLACE FUNCTION flexbuffers_to_msgpack(bytea)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'flexbuffers_to_msgpack'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION flexbuffers_to_msgpack(bytea) IS
+'Transcode one FlexBuffers value to MessagePack without an intermediate jsonb or dynamic tree';
+
+CREATE OR REPLACE FUNCTION flexbuffers_to_cbor(bytea)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'flexbuffers_to_cbor'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION flexbuffers_to_cbor(bytea) IS
+'Transcode one FlexBuffers value to CBOR without an intermediate jsonb or dynamic tree';
+
+CREATE OR REPLACE FUNCTION flexbuffers_to_zera(bytea)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'flexbuffers_to_zera'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION flexbuffers_to_zera(bytea) IS
+'Transcode one FlexBuffers value to ZERA without an intermediate jsonb or dynamic tree';
@@ -0,0 +1,188 @@
+-- pg_zerialize extension upgrade from 1.19 to 1.20.
+
+CREATE TYPE msgpack;
+
+CREATE FUNCTION msgpack_in(cstring)
+RETURNS msgpack
+AS 'MODULE_PATHNAME', 'msgpack_in'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION msgpack_out(msgpack)
+RETURNS cstring
+AS 'MODULE_PATHNAME', 'msgpack_out'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION msgpack_recv(internal)
+RETURNS msgpack
+AS 'MODULE_PATHNAME', 'msgpack_recv'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION msgpack_send(msgpack)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'msgpack_send'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE TYPE msgpack (
+    INPUT = msgpack_in,
+    OUTPUT = msgpack_out,
+    RECEIVE = msgpack_recv,
+    SEND = msgpack_send,
+    INTERNALLENGTH = VARIABLE,
+    ALIGNMENT = int4,
+    STORAGE = extended,
+    CATEGORY = 'U'
+);
+
+COMMENT ON TYPE msgpack IS
+'One validated MessagePack value; text I/O is JSON or \x hex of the exact bytes, binary I/O is the raw bytes';
+
+CREATE FUNCTION msgpack(bytea)
+RETURNS msgpack
+AS 'MODULE_PATHNAME', 'msgpack_from_bytea'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION msgpack(bytea) IS
+'Validate one MessagePack value and return it as msgpack';
+
+CREATE FUNCTION msgpack(jsonb)
+RETURNS msgpack
+AS 'MODULE_PATHNAME', 'msgpack_from_jsonb'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION msgpack(jsonb) IS
+'Convert jsonb to msgpack, as msgpack_from_jsonb';
+
+-- msgpack has bytea's representation, so every bytea function accepts it.
+CREATE CAST (msgpack AS bytea) WITHOUT FUNCTION AS IMPLICIT;
+CREATE CAST (bytea AS msgpack) WITH FUNCTION msgpack(bytea) AS ASSIGNMENT;
+CREATE CAST (jsonb AS msgpack) WITH FUNCTION msgpack(jsonb);
+CREATE CAST (msgpack AS jsonb) WITH FUNCTION msgpack_to_jsonb(bytea);
+
+CREATE FUNCTION msgpack_object_field(msgpack, text)
+RETURNS msgpack
+AS 'MODULE_PATHNAME', 'msgpack_object_field'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION msgpack_object_field(msgpack, text) IS
+'Return the value of a map key, as msgpack -> text';
+
+CREATE FUNCTION msgpack_object_field_text(msgpack, text)
+RETURNS text
+AS 'MODULE_PATHNAME', 'msgpack_object_field_text'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION msgpack_object_field_text(msgpack, text) IS
+'Return the value of a map key as text, as msgpack ->> text';
+
+CREATE FUNCTION msgpack_array_element(msgpack, integer)
+RETURNS msgpack
+AS 'MODULE_PATHNAME', 'msgpack_array_element'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION msgpack_array_element(msgpack, integer) IS
+'Return an array element, counting from the end when negative, as msgpack -> integer';
+
+CREATE FUNCTION msgpack_array_element_text(msgpack, integer)
+RETURNS text
+AS 'MODULE_PATHNAME', 'msgpack_array_element_text'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION msgpack_array_element_text(msgpack, integer) IS
+'Return an array element as text, as msgpack ->> integer';
+
+CREATE FUNCTION msgpack_contains(msgpack, msgpack)
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'msgpack_contains'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION msgpack_contains(msgpack, msgpack) IS
+'Whether the first value contains the second, with jsonb @> rules';
+
+CREATE FUNCTION msgpack_contained(msgpack, msgpack)
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'msgpack_contained'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+COMMENT ON FUNCTION msgpack_contained(msgpack, msgpack) IS
+'Whether the first value is contained by the second, with jsonb <@ rules';
+
+CREATE OPERATOR -> (
+    LEFTARG = msgpack,
+    RIGHTARG = text,
+    FUNCTION = msgpack_object_field
+);
+
+CREATE OPERATOR ->> (
+    LEFTARG = msgpack,
+    RIGHTARG = text,
+    FUNCTION = msgpack_object_field_text
+);
+
+CREATE OPERATOR -> (
+    LEFTARG = msgpack,
+    RIGHTARG = integer,
+    FUNCTION = msgpack_array_element
+);
+
+CREATE OPERATOR ->> (
+    LEFTARG = msgpack,
+    RIGHTARG = integer,
+    FUNCTION = msgpack_array_element_text
+);
+
+CREATE OPERATOR @> (
+    LEFTARG = msgpack,
+    RIGHTARG = msgpack,
+    FUNCTION = msgpack_contains,
+    COMMUTATOR = <@,
+    RESTRICT = matchingsel,
+    JOIN = matchingjoinsel
+);
+
+CREATE OPERATOR <@ (
+    LEFTARG = msgpack,
+    RIGHTARG = msgpack,
+    FUNCTION = msgpack_contained,
+    COMMUTATOR = @>,
+    RESTRICT = matchingsel,
+    JOIN = matchingjoinsel
+);
+
+CREATE FUNCTION gin_extract_msgpack(msgpack, internal, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'gin_extract_msgpack'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION gin_extract_msgpack_query(msgpack, internal, int2, internal, internal,
+                                          internal, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'gin_extract_msgpack_query'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION gin_consistent_msgpack(internal, int2, msgpack, int4, internal, internal,
+                                       internal, internal)
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'gin_consistent_msgpack'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION gin_triconsistent_msgpack(internal, int2, msgpack, int4, internal, internal,
+                                          internal)
+RETURNS "char"
+AS 'MODULE_PATHNAME', 'gin_triconsistent_msgpack'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OPERATOR CLASS msgpack_path_ops
+DEFAULT FOR TYPE msgpack USING gin AS
+    OPERATOR 7 @>,
+    FUNCTION 1 btint4cmp(int4, int4),
+    FUNCTION 2 gin_extract_msgpack(msgpack, internal, internal),
+    FUNCTION 3 gin_extract_msgpack_query(msgpack, internal, int2, internal, internal,
+                                         internal, internal),
+    FUNCTION 4 gin_consistent_msgpack(internal, int2, msgpack, int4, internal, internal,
+                                      internal, internal),
+    FUNCTION 6 gin_triconsistent_msgpack(internal, int2, msgpack, int4, internal, internal,
+                                         internal),
+    STORAGE int4;
+
+COMMENT ON OPERATOR CLASS msgpack_path_ops USING gin IS
+'Hashes of key paths and scalar values, supporting @>';
@@ -0,0 +1,27 @@
+-- pg_zerialize extension upgrade from 1.20 to 1.21.
+
+-- cbor_rows_agg keeps CBOR rows in its partial states, so the final step
+-- only writes the array header instead of re-encoding every row.
+CREATE FUNCTION cbor_rows_agg_transfn(internal, record)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'cbor_rows_agg_transfn'
+LANGUAGE C PARALLEL SAFE;
+
+CREATE FUNCTION cbor_rows_agg_concat_finalfn(internal)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'cbor_rows_agg_concat_finalfn'
+LANGUAGE C PARALLEL SAFE;
+
+-- Replace in place so dependent views keep working.
+CREATE OR REPLACE AGGREGATE cbor_rows_agg(record)
+(
+    SFUNC = cbor_rows_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = cbor_rows_agg_concat_finalfn,
+    COMBINEFUNC = msgpack_rows_agg_combinefn,
+    SERIALFUNC = msgpack_rows_agg_serialfn,
+    DESERIALFUNC = msgpack_rows_agg_deserialfn,
+    PARALLEL = SAFE
+);
+
+DROP FUNCTION cbor_rows_agg_finalfn(internal);
@@ -20,7 +20,13 @@ extern "C" {
 #include "utils/datetime.h"
 #include "utils/jsonb.h"
 #include "utils/timestamp.h"
+#include "access/gin.h"
+#include "access/detoast.h"
+#include "access/htup_details.h"
+#include "access/sysattr.h"
 #include "access/tupdesc.h"
+#include "access/xact.h"
+#include "commands/defrem.h"
 #include "executor/spi.h"
 #include "utils/syscache.h"
 #include "utils/typcache.h"
@@ -28,7 +34,20 @@ extern "C" {
 #include "utils/inet.h"
 #include "utils/guc.h"
 #include "utils/uuid.h"
+#include "utils/rel.h"
+#include "utils/relcache.h"
+#include "common/hashfn.h"
+#include "libpq/pqformat.h"
 #include "mb/pg_wchar.h"
+#include "nodes/pg_list.h"
+#include "nodes/primnodes.h"
+#include "port/atomics.h"
+#include "port/pg_bitutils.h"
+#include "replication/logical.h"
+#include "replication/output_plugin.h"
+#include "storage/ipc.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
 
 #ifdef PG_MODULE_MAGIC
 PG_MODULE_MAGIC;
@@ -39,13 +58,16 @@ Datum jsonb_agg_finalfn(PG_FUNCTION_ARGS);
 Datum jsonb_object_agg_finalfn(PG_FUNCTION_ARGS);
 }
 
+#include <algorithm>
 #include <vector>
+#include <deque>
 #include <string>
 #include <string_view>
 #include <cstring>
 #include <array>
 #include <exception>
 #include <memory>
+#include <new>
 #include <unordered_map>
 #include <unordered_set>
 #include <type_traits>
@@ -54,6 +76,19 @@ Datum jsonb_object_agg_finalfn(PG_FUNCTION_ARGS);
 #include <charconv>
 #include <bit>
 #include <limits>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <pthread.h>
+#include <signal.h>
+#ifdef USE_LZ4
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
 #include <fast_float/fast_float.h>
 #include <zerialize/zerialize.hpp>
 #include <zerialize/protocols/flex.hpp>
@@ -63,6 +98,8 @@ Datum jsonb_object_agg_finalfn(PG_FUNCTION_ARGS);
 #include <zerialize/dynamic.hpp>
 #include <zerialize/internals/base64.hpp>
 
+#include "pg_zerialize_kernels.hpp"
+
 namespace z = zerialize;
 
 enum NumericFloatBackend {
@@ -73,10 +110,30 @@ enum NumericFloatBackend {
 enum NumericEncoding {
     NUMERIC_ENCODING_FLOAT64 = 0,
     NUMERIC_ENCODING_TAGGED_DECIMAL = 1,
+    NUMERIC_ENCODING_BINARY_DECIMAL = 2,
+};
+
+enum ArrayEncoding {
+    ARRAY_ENCODING_GENERIC = 0,
+    ARRAY_ENCODING_TYPED = 1,
+};
+
+enum TypeEncoding {
+    TYPE_ENCODING_PLAIN = 0,
+    TYPE_ENCODING_NATIVE = 1,
 };
 
 static int numeric_float_backend = NUMERIC_FLOAT_FAST_FLOAT;
 static int numeric_encoding = NUMERIC_ENCODING_FLOAT64;
+static int array_encoding = ARRAY_ENCODING_GENERIC;
+static int type_encoding = TYPE_ENCODING_PLAIN;
+static int schema_cache_max_entries = 4096;
+static int batch_threads = 1;
+
+// Upper bound for pg_zerialize.batch_threads, and the fewest rows each thread
+// takes; smaller batches are not worth waking the workers for.
+static constexpr int kBatchThreadsMax = 64;
+static constexpr int kBatchThreadSliceRows = 16384;
 
 static const config_enum_entry numeric_float_backend_options[] = {
     {"postgres", NUMERIC_FLOAT_POSTGRES, false},
@@ -87,6 +144,19 @@ static const config_enum_entry numeric_float_backend_options[] = {
 static const config_enum_entry numeric_encoding_options[] = {
     {"float64", NUMERIC_ENCODING_FLOAT64, false},
     {"tagged_decimal", NUMERIC_ENCODING_TAGGED_DECIMAL, false},
+    {"binary_decimal", NUMERIC_ENCODING_BINARY_DECIMAL, false},
+    {nullptr, 0, false},
+};
+
+static const config_enum_entry array_encoding_options[] = {
+    {"generic", ARRAY_ENCODING_GENERIC, false},
+    {"typed", ARRAY_ENCODING_TYPED, false},
+    {nullptr, 0, false},
+};
+
+static const config_enum_entry type_encoding_options[] = {
+    {"plain", TYPE_ENCODING_PLAIN, false},
+    {"native", TYPE_ENCODING_NATIVE, false},
     {nullptr, 0, false},
 };
 
@@ -105,8 +175,68 @@ extern "C" {
     Datum flexbuffers_to_jsonb(PG_FUNCTION_ARGS);
     Datum cbor_to_jsonb(PG_FUNCTION_ARGS);
     Datum zera_to_jsonb(PG_FUNCTION_ARGS);
+    Datum msgpack_to_cbor(PG_FUNCTION_ARGS);
+    Datum msgpack_to_zera(PG_FUNCTION_ARGS);
+    Datum msgpack_to_flexbuffers(PG_FUNCTION_ARGS);
+    Datum cbor_to_msgpack(PG_FUNCTION_ARGS);
+    Datum cbor_to_zera(PG_FUNCTION_ARGS);
+    Datum cbor_to_flexbuffers(PG_FUNCTION_ARGS);
+    Datum zera_to_msgpack(PG_FUNCTION_ARGS);
+    Datum zera_to_cbor(PG_FUNCTION_ARGS);
+    Datum zera_to_flexbuffers(PG_FUNCTION_ARGS);
+    Datum flexbuffers_to_msgpack(PG_FUNCTION_ARGS);
+    Datum flexbuffers_to_cbor(PG_FUNCTION_ARGS);
+    Datum flexbuffers_to_zera(PG_FUNCTION_ARGS);
+    Datum msgpack_extract(PG_FUNCTION_ARGS);
+    Datum msgpack_extract_text(PG_FUNCTION_ARGS);
+    Datum msgpack_extract_int8(PG_FUNCTION_ARGS);
+    Datum msgpack_extract_float8(PG_FUNCTION_ARGS);
+    Datum msgpack_in(PG_FUNCTION_ARGS);
+    Datum msgpack_out(PG_FUNCTION_ARGS);
+    Datum msgpack_recv(PG_FUNCTION_ARGS);
+    Datum msgpack_send(PG_FUNCTION_ARGS);
+    Datum msgpack_from_bytea(PG_FUNCTION_ARGS);
+    Datum msgpack_object_field(PG_FUNCTION_ARGS);
+    Datum msgpack_object_field_text(PG_FUNCTION_ARGS);
+    Datum msgpack_array_element(PG_FUNCTION_ARGS);
+    Datum msgpack_array_element_text(PG_FUNCTION_ARGS);
+    Datum msgpack_contains(PG_FUNCTION_ARGS);
+    Datum msgpack_contained(PG_FUNCTION_ARGS);
+    Datum gin_extract_msgpack(PG_FUNCTION_ARGS);
+    Datum gin_extract_msgpack_query(PG_FUNCTION_ARGS);
+    Datum gin_consistent_msgpack(PG_FUNCTION_ARGS);
+    Datum gin_triconsistent_msgpack(PG_FUNCTION_ARGS);
+    Datum cbor_extract(PG_FUNCTION_ARGS);
+    Datum cbor_extract_text(PG_FUNCTION_ARGS);
+    Datum cbor_extract_int8(PG_FUNCTION_ARGS);
+    Datum cbor_extract_float8(PG_FUNCTION_ARGS);
+    Datum zera_extract(PG_FUNCTION_ARGS);
+    Datum zera_extract_text(PG_FUNCTION_ARGS);
+    Datum zera_extract_int8(PG_FUNCTION_ARGS);
+    Datum zera_extract_float8(PG_FUNCTION_ARGS);
+    Datum msgpack_array_elements(PG_FUNCTION_ARGS);
+    Datum cbor_array_elements(PG_FUNCTION_ARGS);
+    Datum msgpack_populate_record(PG_FUNCTION_ARGS);
+    Datum msgpack_to_recordset(PG_FUNCTION_ARGS);
     Datum msgpack_build_object(PG_FUNCTION_ARGS);
     Datum msgpack_build_array(PG_FUNCTION_ARGS);
+    Datum cbor_build_object(PG_FUNCTION_ARGS);
+    Datum cbor_build_array(PG_FUNCTION_ARGS);
+    Datum zera_build_object(PG_FUNCTION_ARGS);
+    Datum zera_build_array(PG_FUNCTION_ARGS);
+    Datum msgpack_agg_transfn(PG_FUNCTION_ARGS);
+    Datum msgpack_agg_finalfn(PG_FUNCTION_ARGS);
+    Datum msgpack_object_agg_transfn(PG_FUNCTION_ARGS);
+    Datum msgpack_object_agg_finalfn(PG_FUNCTION_ARGS);
+    Datum msgpack_rows_agg_transfn(PG_FUNCTION_ARGS);
+    Datum msgpack_rows_agg_combinefn(PG_FUNCTION_ARGS);
+    Datum msgpack_rows_agg_serialfn(PG_FUNCTION_ARGS);
+    Datum msgpack_rows_agg_deserialfn(PG_FUNCTION_ARGS);
+    Datum cbor_rows_agg_transfn(PG_FUNCTION_ARGS);
+    Datum cbor_rows_agg_finalfn(PG_FUNCTION_ARGS);
+    Datum cbor_rows_agg_concat_finalfn(PG_FUNCTION_ARGS);
+    Datum zera_rows_agg_finalfn(PG_FUNCTION_ARGS);
+    Datum flexbuffers_rows_agg_finalfn(PG_FUNCTION_ARGS);
     Datum msgpack_agg_final(PG_FUNCTION_ARGS);
     Datum msgpack_object_agg_final(PG_FUNCTION_ARGS);
     Datum row_to_cbor(PG_FUNCTION_ARGS);
@@ -119,6 +249,30 @@ extern "C" {
     Datum rows_to_cbor(PG_FUNCTION_ARGS);
     Datum rows_to_zera(PG_FUNCTION_ARGS);
 
+    // Column projection variants
+    Datum row_to_flexbuffers_columns(PG_FUNCTION_ARGS);
+    Datum row_to_msgpack_columns(PG_FUNCTION_ARGS);
+    Datum row_to_cbor_columns(PG_FUNCTION_ARGS);
+    Datum row_to_zera_columns(PG_FUNCTION_ARGS);
+    Datum rows_to_flexbuffers_columns(PG_FUNCTION_ARGS);
+    Datum rows_to_msgpack_columns(PG_FUNCTION_ARGS);
+    Datum rows_to_cbor_columns(PG_FUNCTION_ARGS);
+    Datum rows_to_zera_columns(PG_FUNCTION_ARGS);
+
+    // Compact batch functions
+    Datum rows_to_msgpack_compact(PG_FUNCTION_ARGS);
+    Datum rows_to_cbor_compact(PG_FUNCTION_ARGS);
+    Datum rows_to_zera_compact(PG_FUNCTION_ARGS);
+    Datum rows_to_zera_columnar(PG_FUNCTION_ARGS);
+
+    // Streaming export
+    Datum msgpack_stream(PG_FUNCTION_ARGS);
+
+    // Instrumentation
+    Datum pg_zerialize_stats(PG_FUNCTION_ARGS);
+    Datum pg_zerialize_stats_reset(PG_FUNCTION_ARGS);
+    Datum pg_zerialize_schema_cache(PG_FUNCTION_ARGS);
+
     PG_FUNCTION_INFO_V1(row_to_flexbuffers);
     PG_FUNCTION_INFO_V1(row_to_msgpack);
     PG_FUNCTION_INFO_V1(row_to_msgpack_slow);
@@ -127,8 +281,68 @@ extern "C" {
     PG_FUNCTION_INFO_V1(flexbuffers_to_jsonb);
     PG_FUNCTION_INFO_V1(cbor_to_jsonb);
     PG_FUNCTION_INFO_V1(zera_to_jsonb);
+    PG_FUNCTION_INFO_V1(msgpack_to_cbor);
+    PG_FUNCTION_INFO_V1(msgpack_to_zera);
+    PG_FUNCTION_INFO_V1(msgpack_to_flexbuffers);
+    PG_FUNCTION_INFO_V1(cbor_to_msgpack);
+    PG_FUNCTION_INFO_V1(cbor_to_zera);
+    PG_FUNCTION_INFO_V1(cbor_to_flexbuffers);
+    PG_FUNCTION_INFO_V1(zera_to_msgpack);
+    PG_FUNCTION_INFO_V1(zera_to_cbor);
+    PG_FUNCTION_INFO_V1(zera_to_flexbuffers);
+    PG_FUNCTION_INFO_V1(flexbuffers_to_msgpack);
+    PG_FUNCTION_INFO_V1(flexbuffers_to_cbor);
+    PG_FUNCTION_INFO_V1(flexbuffers_to_zera);
+    PG_FUNCTION_INFO_V1(msgpack_extract);
+    PG_FUNCTION_INFO_V1(msgpack_extract_text);
+    PG_FUNCTION_INFO_V1(msgpack_extract_int8);
+    PG_FUNCTION_INFO_V1(msgpack_extract_float8);
+    PG_FUNCTION_INFO_V1(msgpack_in);
+    PG_FUNCTION_INFO_V1(msgpack_out);
+    PG_FUNCTION_INFO_V1(msgpack_recv);
+    PG_FUNCTION_INFO_V1(msgpack_send);
+    PG_FUNCTION_INFO_V1(msgpack_from_bytea);
+    PG_FUNCTION_INFO_V1(msgpack_object_field);
+    PG_FUNCTION_INFO_V1(msgpack_object_field_text);
+    PG_FUNCTION_INFO_V1(msgpack_array_element);
+    PG_FUNCTION_INFO_V1(msgpack_array_element_text);
+    PG_FUNCTION_INFO_V1(msgpack_contains);
+    PG_FUNCTION_INFO_V1(msgpack_contained);
+    PG_FUNCTION_INFO_V1(gin_extract_msgpack);
+    PG_FUNCTION_INFO_V1(gin_extract_msgpack_query);
+    PG_FUNCTION_INFO_V1(gin_consistent_msgpack);
+    PG_FUNCTION_INFO_V1(gin_triconsistent_msgpack);
+    PG_FUNCTION_INFO_V1(cbor_extract);
+    PG_FUNCTION_INFO_V1(cbor_extract_text);
+    PG_FUNCTION_INFO_V1(cbor_extract_int8);
+    PG_FUNCTION_INFO_V1(cbor_extract_float8);
+    PG_FUNCTION_INFO_V1(zera_extract);
+    PG_FUNCTION_INFO_V1(zera_extract_text);
+    PG_FUNCTION_INFO_V1(zera_extract_int8);
+    PG_FUNCTION_INFO_V1(zera_extract_float8);
+    PG_FUNCTION_INFO_V1(msgpack_array_elements);
+    PG_FUNCTION_INFO_V1(cbor_array_elements);
+    PG_FUNCTION_INFO_V1(msgpack_populate_record);
+    PG_FUNCTION_INFO_V1(msgpack_to_recordset);
     PG_FUNCTION_INFO_V1(msgpack_build_object);
     PG_FUNCTION_INFO_V1(msgpack_build_array);
+    PG_FUNCTION_INFO_V1(cbor_build_object);
+    PG_FUNCTION_INFO_V1(cbor_build_array);
+    PG_FUNCTION_INFO_V1(zera_build_object);
+    PG_FUNCTION_INFO_V1(zera_build_array);
+    PG_FUNCTION_INFO_V1(msgpack_agg_transfn);
+    PG_FUNCTION_INFO_V1(msgpack_agg_finalfn);
+    PG_FUNCTION_INFO_V1(msgpack_object_agg_transfn);
+    PG_FUNCTION_INFO_V1(msgpack_object_agg_finalfn);
+    PG_FUNCTION_INFO_V1(msgpack_rows_agg_transfn);
+    PG_FUNCTION_INFO_V1(msgpack_rows_agg_combinefn);
+    PG_FUNCTION_INFO_V1(msgpack_rows_agg_serialfn);
+    PG_FUNCTION_INFO_V1(msgpack_rows_agg_deserialfn);
+    PG_FUNCTION_INFO_V1(cbor_rows_agg_transfn);
+    PG_FUNCTION_INFO_V1(cbor_rows_agg_finalfn);
+    PG_FUNCTION_INFO_V1(cbor_rows_agg_concat_finalfn);
+    PG_FUNCTION_INFO_V1(zera_rows_agg_finalfn);
+    PG_FUNCTION_INFO_V1(flexbuffers_rows_agg_finalfn);
     PG_FUNCTION_INFO_V1(msgpack_agg_final);
     PG_FUNCTION_INFO_V1(msgpack_object_agg_final);
     PG_FUNCTION_INFO_V1(row_to_cbor);
@@ -139,6 +353,31 @@ extern "C" {
     PG_FUNCTION_INFO_V1(rows_to_msgpack_slow);
     PG_FUNCTION_INFO_V1(rows_to_cbor);
     PG_FUNCTION_INFO_V1(rows_to_zera);
+    PG_FUNCTION_INFO_V1(rows_to_flexbuffers_compressed);
+    PG_FUNCTION_INFO_V1(rows_to_msgpack_compressed);
+    PG_FUNCTION_INFO_V1(rows_to_cbor_compressed);
+    PG_FUNCTION_INFO_V1(rows_to_zera_compressed);
+    PG_FUNCTION_INFO_V1(zerialize_decompress);
+
+    PG_FUNCTION_INFO_V1(row_to_flexbuffers_columns);
+    PG_FUNCTION_INFO_V1(row_to_msgpack_columns);
+    PG_FUNCTION_INFO_V1(row_to_cbor_columns);
+    PG_FUNCTION_INFO_V1(row_to_zera_columns);
+    PG_FUNCTION_INFO_V1(rows_to_flexbuffers_columns);
+    PG_FUNCTION_INFO_V1(rows_to_msgpack_columns);
+    PG_FUNCTION_INFO_V1(rows_to_cbor_columns);
+    PG_FUNCTION_INFO_V1(rows_to_zera_columns);
+
+    PG_FUNCTION_INFO_V1(rows_to_msgpack_compact);
+    PG_FUNCTION_INFO_V1(rows_to_cbor_compact);
+    PG_FUNCTION_INFO_V1(rows_to_zera_compact);
+    PG_FUNCTION_INFO_V1(rows_to_zera_columnar);
+
+    PG_FUNCTION_INFO_V1(msgpack_stream);
+
+    PG_FUNCTION_INFO_V1(pg_zerialize_stats);
+    PG_FUNCTION_INFO_V1(pg_zerialize_stats_reset);
+    PG_FUNCTION_INFO_V1(pg_zerialize_schema_cache);
 }
 
 /*
@@ -169,6 +408,44 @@ namespace std {
     };
 }
 
+/*
+ * Column projections are cached per row type and requested column list. The
+ * list is kept as the names joined by NUL, which text values cannot contain.
+ */
+struct ProjectionCacheKey {
+    Oid tupType;
+    int32 tupTypmod;
+    std::string columns;
+
+    bool operator==(const ProjectionCacheKey& other) const {
+        return tupType == other.tupType && tupTypmod == other.tupTypmod &&
+               columns == other.columns;
+    }
+};
+
+namespace std {
+    template<>
+    struct hash<ProjectionCacheKey> {
+        size_t operator()(const ProjectionCacheKey& k) const {
+            return hash<TypeCacheKey>()(TypeCacheKey{k.tupType, k.tupTypmod}) ^
+                   (hash<std::string>()(k.columns) << 1);
+        }
+    };
+}
+
+struct ColumnProjection {
+    std::string key;
+    std::vector<std::string_view> names;
+};
+
+// Lets column lookups by decoded key probe with a string_view.
+struct ColumnNameHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view name) const {
+        return std::hash<std::string_view>()(name);
+    }
+};
+
 enum class ConverterKind {
     Int2,
     Int4,
@@ -197,8 +474,24 @@ enum class ConverterKind {
 };
 
 struct CachedColumn;
+struct CachedSchema;
+
+/*
+ * A resolved schema for one (type, typmod), valid while
+ * schema_cache_generation is unchanged, i.e. no cache entry has been freed.
+ */
+struct SchemaMemo {
+    const CachedSchema* schema = nullptr;
+    uint64 generation = 0;
+    Oid typid = InvalidOid;
+    int32 typmod = -1;
+};
+
 using MsgpackScalarWriterFn = void (*)(z::MsgPackSerializer&, const CachedColumn&, Datum, bool);
 using MsgpackArrayElemWriterFn = void (*)(z::MsgPackSerializer&, Datum, bool);
+// Column and array element writers for the CBOR, ZERA, and Flex direct paths.
+template <typename WriterT>
+using ColumnWriterFn = void (*)(WriterT&, const CachedColumn&, Datum, bool);
 
 struct CachedColumn {
     int attnum;
@@ -208,31 +501,64 @@ struct CachedColumn {
     const uint8_t* msgpack_key_ptr;
     size_t msgpack_key_len;
     std::vector<uint8_t> zera_key_encoded;
+    // Empty when the name is not valid UTF-8, so the encoder rejects it.
+    std::vector<uint8_t> cbor_key_encoded;
+    // Key bytes already written into Flex document flex_key_document.
+    mutable z::flex::Serializer::KeyRef flex_key{};
+    mutable uint64 flex_key_document = 0;
     MsgpackScalarWriterFn msgpack_scalar_writer;
     MsgpackArrayElemWriterFn msgpack_array_elem_writer;
+    ColumnWriterFn<z::cborjc::Serializer> cbor_scalar_writer;
+    ColumnWriterFn<z::cborjc::Serializer> cbor_array_elem_writer;
+    ColumnWriterFn<z::zera::Serializer> zera_scalar_writer;
+    ColumnWriterFn<z::zera::Serializer> zera_array_elem_writer;
+    ColumnWriterFn<z::flex::Serializer> flex_scalar_writer;
+    ColumnWriterFn<z::flex::Serializer> flex_array_elem_writer;
     Oid typid;
+    int32 typmod;
     Oid typoutput;
+    Oid typinput;
+    Oid typioparam;
     ConverterKind kind;
     Oid array_element_typid;
     Oid array_element_typoutput;
+    Oid array_element_typinput;
+    Oid array_element_typioparam;
     ConverterKind array_element_kind;
     int16 array_typlen;
     bool array_typbyval;
     char array_typalign;
+    // Schema of this column's composite values or array elements.
+    mutable SchemaMemo nested_memo;
 };
 
 struct CachedSchema {
     TupleDesc tupdesc;
     std::vector<CachedColumn> columns;
+    std::unordered_map<std::string, size_t, ColumnNameHash, std::equal_to<>> column_index_by_name;
     std::vector<uint8_t> msgpack_map_header_encoded;
     const uint8_t* msgpack_map_header_ptr;
     size_t msgpack_map_header_len;
     bool use_deform_access;
-    bool msgpack_has_recursive_columns;
+    bool has_recursive_columns;
     bool msgpack_fast_supported;
     bool cbor_fast_supported;
     bool zera_fast_supported;
     bool flex_fast_supported;
+    // Running average of encoded MessagePack row size, used to size the
+    // in-place bytea buffer; updated through const cache references.
+    mutable size_t msgpack_row_bytes;
+    // Invalidation keys: the row type's relation, or InvalidOid for blessed
+    // records, and the TYPEOID syscache hashes of the row and column types.
+    Oid relid;
+    std::vector<uint32> type_hashes;
+    // Lookup tick of the most recent use, for LRU trimming.
+    mutable uint64 last_used;
+    // Recursive fast-path verdicts, one bit per StatsProtocol, valid while
+    // nested_generation matches schema_cache_generation.
+    mutable uint64 nested_generation;
+    mutable uint8 nested_checked;
+    mutable uint8 nested_supported;
 };
 
 static bool is_msgpack_fast_kind(ConverterKind kind);
@@ -241,8 +567,11 @@ static bool is_msgpack_fast_column(const CachedColumn& col);
 static std::vector<uint8_t> encode_msgpack_string_key(std::string_view key);
 static std::vector<uint8_t> encode_msgpack_map_header(size_t n);
 static std::vector<uint8_t> encode_zera_key(std::string_view key);
+static std::vector<uint8_t> encode_cbor_key(std::string_view key);
 static MsgpackScalarWriterFn select_msgpack_scalar_writer(ConverterKind kind);
 static MsgpackArrayElemWriterFn select_msgpack_array_elem_writer(ConverterKind kind);
+template <typename WriterT>
+static ColumnWriterFn<WriterT> select_column_writer(ConverterKind kind, bool element);
 static inline std::span<const std::byte> datum_bytea_span(Datum value);
 static inline std::span<const std::byte> datum_jsonb_span(Datum value);
 static constexpr size_t kHybridHeapDeformThreshold = 24;
@@ -274,36 +603,283 @@ public:
     }
 };
 
+struct CachedEnumLabel {
+    std::string label;
+    uint32 hash;  // ENUMOID syscache hash of the label's OID
+};
+
 // Global cache for per-schema metadata and TupleDesc lookups.
 static std::unordered_map<TypeCacheKey, CachedSchema> schema_cache;
-static std::unordered_map<Oid, std::string> enum_label_cache;
+static std::unordered_map<ProjectionCacheKey, CachedSchema> projection_cache;
+static std::unordered_map<Oid, CachedEnumLabel> enum_label_cache;
+
+/*
+ * Path and cache statistics. Counters are backend-local; when the library is
+ * preloaded, every transaction end also folds their growth since the last
+ * flush into a shared-memory aggregate.
+ */
+enum class StatsProtocol : uint8 { MsgPack, Cbor, Zera, Flex };
+enum class StatsEntryPoint : uint8 { Row, Rows, Compact, Embedded };
+enum class StatsPathMetric : uint8 { FastPath, FallbackUnsupported, FallbackRecursive, Rows, Bytes };
+enum class StatsCacheMetric : uint8 { Hits, Misses, Invalidations, Evictions };
+
+static constexpr const char* kStatsProtocolNames[] = {"msgpack", "cbor", "zera", "flexbuffers"};
+static constexpr const char* kStatsEntryPointNames[] = {"row", "rows", "compact", "embedded"};
+static constexpr const char* kStatsPathMetricNames[] = {
+    "fast_path", "fallback_unsupported", "fallback_recursive", "rows", "bytes"};
+static constexpr const char* kStatsCacheMetricNames[] = {
+    "schema_cache_hits", "schema_cache_misses", "schema_cache_invalidations",
+    "schema_cache_evictions"};
+
+static constexpr size_t kStatsProtocols = std::size(kStatsProtocolNames);
+static constexpr size_t kStatsEntryPoints = std::size(kStatsEntryPointNames);
+static constexpr size_t kStatsPathMetrics = std::size(kStatsPathMetricNames);
+static constexpr size_t kStatsPathCounters = kStatsProtocols * kStatsEntryPoints * kStatsPathMetrics;
+static constexpr size_t kStatsCounters = kStatsPathCounters + std::size(kStatsCacheMetricNames);
+
+struct SharedStats {
+    pg_atomic_uint64 counters[kStatsCounters];
+};
+
+static uint64 stats_counters[kStatsCounters];
+static uint64 stats_flushed[kStatsCounters];
+static SharedStats* shared_stats = nullptr;
+static shmem_request_hook_type prev_shmem_request_hook = nullptr;
+static shmem_startup_hook_type prev_shmem_startup_hook = nullptr;
+
+static inline size_t stats_path_index(
+    StatsProtocol protocol, StatsEntryPoint entry, StatsPathMetric metric)
+{
+    return (static_cast<size_t>(protocol) * kStatsEntryPoints + static_cast<size_t>(entry)) *
+               kStatsPathMetrics +
+           static_cast<size_t>(metric);
+}
+
+static inline void stats_count(
+    StatsProtocol protocol, StatsEntryPoint entry, StatsPathMetric metric, uint64 n = 1)
+{
+    stats_counters[stats_path_index(protocol, entry, metric)] += n;
+}
+
+static inline void stats_count(StatsCacheMetric metric, uint64 n = 1)
+{
+    stats_counters[kStatsPathCounters + static_cast<size_t>(metric)] += n;
+}
+
+/*
+ * Count one finished document and the rows in it, whichever path wrote it.
+ */
+static inline void stats_count_document(
+    StatsProtocol protocol, StatsEntryPoint entry, const bytea* result, uint64 rows)
+{
+    stats_count(protocol, entry, StatsPathMetric::Rows, rows);
+    stats_count(protocol, entry, StatsPathMetric::Bytes, VARSIZE(result) - VARHDRSZ);
+}
+
+template<typename Protocol>
+static constexpr StatsProtocol stats_protocol_of()
+{
+    if constexpr (std::is_same_v<Protocol, z::MsgPack>) {
+        return StatsProtocol::MsgPack;
+    } else if constexpr (std::is_same_v<Protocol, z::CBOR>) {
+        return StatsProtocol::Cbor;
+    } else if constexpr (std::is_same_v<Protocol, z::Zera>) {
+        return StatsProtocol::Zera;
+    } else {
+        return StatsProtocol::Flex;
+    }
+}
+
+static void stats_shmem_request(void)
+{
+    if (prev_shmem_request_hook != nullptr) {
+        prev_shmem_request_hook();
+    }
+    RequestAddinShmemSpace(MAXALIGN(sizeof(SharedStats)));
+}
+
+static void stats_shmem_startup(void)
+{
+    if (prev_shmem_startup_hook != nullptr) {
+        prev_shmem_startup_hook();
+    }
+
+    bool found;
+    LWLockAcquire(AddinShmemInitLock, LW_EXCLUSIVE);
+    shared_stats = static_cast<SharedStats*>(
+        ShmemInitStruct("pg_zerialize stats", sizeof(SharedStats), &found));
+    if (!found) {
+        for (pg_atomic_uint64& counter : shared_stats->counters) {
+            pg_atomic_init_u64(&counter, 0);
+        }
+    }
+    LWLockRelease(AddinShmemInitLock);
+}
+
+static void stats_flush(void)
+{
+    for (size_t i = 0; i < kStatsCounters; i++) {
+        const uint64 delta = stats_counters[i] - stats_flushed[i];
+        if (delta != 0) {
+            pg_atomic_fetch_add_u64(&shared_stats->counters[i], static_cast<int64>(delta));
+            stats_flushed[i] = stats_counters[i];
+        }
+    }
+}
+
+static void stats_xact_callback(XactEvent event, void* arg)
+{
+    (void)arg;
+    switch (event) {
+        case XACT_EVENT_COMMIT:
+        case XACT_EVENT_ABORT:
+        case XACT_EVENT_PARALLEL_COMMIT:
+        case XACT_EVENT_PARALLEL_ABORT:
+            if (shared_stats != nullptr) {
+                stats_flush();
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+ * LRU bookkeeping. Every lookup stamps its entry with a new tick. Entries
+ * stamped since the current scope began may still be referenced by a caller,
+ * so trimming leaves them alone even above the bound. A scope is a statement,
+ * or one logical decoding callback: a walsender's statement start timestamp
+ * never advances, so decoding would otherwise protect every entry forever.
+ */
+static uint64 schema_cache_tick = 0;
+static uint64 schema_cache_statement_tick = 0;
+static TimestampTz schema_cache_statement_start = 0;
+
+// Bumped whenever an entry is freed, so SchemaMemo pointers and nested
+// verdicts know to resolve again.
+static uint64 schema_cache_generation = 0;
+
+static inline void schema_cache_begin_scope()
+{
+    schema_cache_statement_tick = schema_cache_tick + 1;
+}
+
+static inline void touch_cached_schema(const CachedSchema& schema)
+{
+    const TimestampTz start = GetCurrentStatementStartTimestamp();
+    if (start != schema_cache_statement_start) {
+        schema_cache_statement_start = start;
+        schema_cache_begin_scope();
+    }
+    schema.last_used = ++schema_cache_tick;
+}
+
+/*
+ * Drop the least recently used entries down to 7/8 of
+ * pg_zerialize.schema_cache_max_entries, so trimming runs once per batch of
+ * inserts rather than on every one.
+ */
+template<typename Map>
+static void trim_schema_cache(Map& cache)
+{
+    const size_t limit = static_cast<size_t>(schema_cache_max_entries);
+    if (limit == 0 || cache.size() < limit) {
+        return;
+    }
+
+    std::vector<std::pair<uint64, typename Map::iterator>> candidates;
+    candidates.reserve(cache.size());
+    for (auto it = cache.begin(); it != cache.end(); ++it) {
+        if (it->second.last_used < schema_cache_statement_tick) {
+            candidates.emplace_back(it->second.last_used, it);
+        }
+    }
+
+    const size_t excess = cache.size() + 1 - (limit - limit / 8);
+    if (candidates.size() > excess) {
+        std::nth_element(candidates.begin(), candidates.begin() + excess, candidates.end(),
+                         [](const auto& a, const auto& b) { return a.first < b.first; });
+        candidates.resize(excess);
+    }
+    for (auto& candidate : candidates) {
+        FreeTupleDesc(candidate.second->second.tupdesc);
+        cache.erase(candidate.second);
+    }
+    if (!candidates.empty()) {
+        schema_cache_generation++;
+    }
+    stats_count(StatsCacheMetric::Evictions, candidates.size());
+}
+
+template<typename Map, typename Pred>
+static void invalidate_schema_entries(Map& cache, Pred stale)
+{
+    for (auto it = cache.begin(); it != cache.end();) {
+        if (stale(it->second)) {
+            FreeTupleDesc(it->second.tupdesc);
+            it = cache.erase(it);
+            schema_cache_generation++;
+            stats_count(StatsCacheMetric::Invalidations);
+        } else {
+            ++it;
+        }
+    }
+}
 
 static inline void clear_tupdesc_cache()
 {
+    stats_count(StatsCacheMetric::Invalidations, schema_cache.size() + projection_cache.size());
+    schema_cache_generation++;
     for (auto& entry : schema_cache) {
         FreeTupleDesc(entry.second.tupdesc);
     }
     schema_cache.clear();
+    for (auto& entry : projection_cache) {
+        FreeTupleDesc(entry.second.tupdesc);
+    }
+    projection_cache.clear();
     enum_label_cache.clear();
 }
 
 /*
  * Invalidate cached tuple descriptors when catalog/relcache changes occur.
- * This avoids stale descriptors after ALTER TABLE/TYPE.
+ * Only entries depending on the changed type, enum label, or relation are
+ * dropped; a zero hash or InvalidOid relid means a full cache reset.
  */
 static void tupdesc_syscache_callback(Datum arg, int cacheid, uint32 hashvalue)
 {
     (void)arg;
-    (void)cacheid;
-    (void)hashvalue;
-    clear_tupdesc_cache();
+    if (hashvalue == 0) {
+        clear_tupdesc_cache();
+        return;
+    }
+
+    if (cacheid == ENUMOID) {
+        for (auto it = enum_label_cache.begin(); it != enum_label_cache.end();) {
+            it = it->second.hash == hashvalue ? enum_label_cache.erase(it) : std::next(it);
+        }
+        return;
+    }
+
+    auto stale = [hashvalue](const CachedSchema& schema) {
+        return std::find(schema.type_hashes.begin(), schema.type_hashes.end(), hashvalue) !=
+               schema.type_hashes.end();
+    };
+    invalidate_schema_entries(schema_cache, stale);
+    invalidate_schema_entries(projection_cache, stale);
 }
 
 static void tupdesc_relcache_callback(Datum arg, Oid relid)
 {
     (void)arg;
-    (void)relid;
-    clear_tupdesc_cache();
+    if (!OidIsValid(relid)) {
+        clear_tupdesc_cache();
+        return;
+    }
+
+    auto stale = [relid](const CachedSchema& schema) { return schema.relid == relid; };
+    invalidate_schema_entries(schema_cache, stale);
+    invalidate_schema_entries(projection_cache, stale);
 }
 
 extern "C" void
@@ -333,11 +909,83 @@ _PG_init(void)
         nullptr,
         nullptr,
         nullptr);
+    DefineCustomEnumVariable(
+        "pg_zerialize.array_encoding",
+        "Selects the wire representation for numeric arrays.",
+        "typed packs no-null one-dimensional int2, int4, int8, float4, and float8 arrays "
+        "into each protocol's typed-array form.",
+        &array_encoding,
+        ARRAY_ENCODING_GENERIC,
+        array_encoding_options,
+        PGC_USERSET,
+        GUC_NOT_IN_SAMPLE,
+        nullptr,
+        nullptr,
+        nullptr);
+    DefineCustomEnumVariable(
+        "pg_zerialize.type_encoding",
+        "Selects the wire representation for uuid, timestamp, inet, cidr, and interval values.",
+        "native writes binary uuids, protocol timestamps, packed network addresses, and "
+        "interval triples instead of text and PostgreSQL-epoch microseconds.",
+        &type_encoding,
+        TYPE_ENCODING_PLAIN,
+        type_encoding_options,
+        PGC_USERSET,
+        GUC_NOT_IN_SAMPLE,
+        nullptr,
+        nullptr,
+        nullptr);
+    DefineCustomIntVariable(
+        "pg_zerialize.schema_cache_max_entries",
+        "Maximum number of cached row schemas per backend.",
+        "Least recently used schemas beyond this are dropped; 0 disables the limit.",
+        &schema_cache_max_entries,
+        4096,
+        0,
+        INT_MAX,
+        PGC_USERSET,
+        0,
+        nullptr,
+        nullptr,
+        nullptr);
+    DefineCustomBoolVariable(
+        "pg_zerialize.simd",
+        "Uses vector kernels for large int4, int8, and float8 arrays in MessagePack.",
+        "Output is identical either way; off keeps the per-value encoders.",
+        &simd_kernels_enabled,
+        true,
+        PGC_USERSET,
+        0,
+        nullptr,
+        nullptr,
+        nullptr);
+    DefineCustomIntVariable(
+        "pg_zerialize.batch_threads",
+        "Number of threads that encode one large MessagePack batch.",
+        "Only rows_to_msgpack batches of fixed-width and text columns use them; "
+        "1 keeps all encoding on the backend's own thread.",
+        &batch_threads,
+        1,
+        1,
+        kBatchThreadsMax,
+        PGC_USERSET,
+        0,
+        nullptr,
+        nullptr,
+        nullptr);
     MarkGUCPrefixReserved("pg_zerialize");
 
+    if (process_shared_preload_libraries_in_progress) {
+        prev_shmem_request_hook = shmem_request_hook;
+        shmem_request_hook = stats_shmem_request;
+        prev_shmem_startup_hook = shmem_startup_hook;
+        shmem_startup_hook = stats_shmem_startup;
+        RegisterXactCallback(stats_xact_callback, nullptr);
+    }
+
+    // pg_class and pg_attribute changes arrive as relcache invalidations for
+    // the row type's relation, so RELOID and ATTNUM need no callbacks.
     CacheRegisterSyscacheCallback(TYPEOID, tupdesc_syscache_callback, (Datum) 0);
-    CacheRegisterSyscacheCallback(RELOID, tupdesc_syscache_callback, (Datum) 0);
-    CacheRegisterSyscacheCallback(ATTNUM, tupdesc_syscache_callback, (Datum) 0);
     CacheRegisterSyscacheCallback(ENUMOID, tupdesc_syscache_callback, (Datum) 0);
     CacheRegisterRelcacheCallback(tupdesc_relcache_callback, (Datum) 0);
 }
@@ -404,6 +1052,120 @@ static ConverterKind classify_type(Oid typid)
     }
 }
 
+/*
+ * Fill the type-dependent part of a cached column: converter kind, writer
+ * plans, output and input functions, and array element storage metadata.
+ */
+static void select_array_elem_writers(CachedColumn& col)
+{
+    col.msgpack_array_elem_writer = select_msgpack_array_elem_writer(col.array_element_kind);
+    col.cbor_array_elem_writer = select_column_writer<z::cborjc::Serializer>(col.array_element_kind, true);
+    col.zera_array_elem_writer = select_column_writer<z::zera::Serializer>(col.array_element_kind, true);
+    col.flex_array_elem_writer = select_column_writer<z::flex::Serializer>(col.array_element_kind, true);
+}
+
+static void init_cached_column_type(CachedColumn& col, Oid typid, ConverterKind kind)
+{
+    col.msgpack_array_elem_writer = nullptr;
+    col.cbor_array_elem_writer = nullptr;
+    col.zera_array_elem_writer = nullptr;
+    col.flex_array_elem_writer = nullptr;
+    col.typid = typid;
+    col.kind = kind;
+    col.msgpack_scalar_writer = select_msgpack_scalar_writer(col.kind);
+    col.cbor_scalar_writer = select_column_writer<z::cborjc::Serializer>(col.kind, false);
+    col.zera_scalar_writer = select_column_writer<z::zera::Serializer>(col.kind, false);
+    col.flex_scalar_writer = select_column_writer<z::flex::Serializer>(col.kind, false);
+    col.typoutput = InvalidOid;
+    col.array_element_typid = InvalidOid;
+    col.array_element_typoutput = InvalidOid;
+    col.array_element_typinput = InvalidOid;
+    col.array_element_typioparam = InvalidOid;
+    col.array_element_kind = ConverterKind::Fallback;
+    col.array_typlen = 0;
+    col.array_typbyval = false;
+    col.array_typalign = 'i';
+
+    if (col.kind == ConverterKind::Array) {
+        col.array_element_typid = get_element_type(col.typid);
+        if (OidIsValid(col.array_element_typid)) {
+            col.array_element_kind = classify_type(col.array_element_typid);
+            select_array_elem_writers(col);
+            bool element_typisvarlena;
+            getTypeOutputInfo(col.array_element_typid,
+                              &col.array_element_typoutput,
+                              &element_typisvarlena);
+            getTypeInputInfo(col.array_element_typid,
+                             &col.array_element_typinput,
+                             &col.array_element_typioparam);
+            get_typlenbyvalalign(col.array_element_typid,
+                                &col.array_typlen,
+                                &col.array_typbyval,
+                                &col.array_typalign);
+        }
+    }
+
+    if (col.kind == ConverterKind::Fallback || col.kind == ConverterKind::Array) {
+        bool typIsVarlena;
+        getTypeOutputInfo(col.typid, &col.typoutput, &typIsVarlena);
+    }
+    getTypeInputInfo(col.typid, &col.typinput, &col.typioparam);
+}
+
+static void init_cached_schema(CachedSchema& schema, TupleDesc tupdesc)
+{
+    schema.tupdesc = tupdesc;
+    schema.use_deform_access = false;
+    schema.has_recursive_columns = false;
+    schema.msgpack_fast_supported = true;
+    schema.cbor_fast_supported = true;
+    schema.zera_fast_supported = true;
+    schema.flex_fast_supported = true;
+    schema.msgpack_row_bytes = 0;
+    schema.relid = InvalidOid;
+    schema.last_used = 0;
+    schema.nested_generation = 0;
+    schema.nested_checked = 0;
+    schema.nested_supported = 0;
+}
+
+static inline void note_schema_type(CachedSchema& schema, Oid typid)
+{
+    schema.type_hashes.push_back(GetSysCacheHashValue1(TYPEOID, ObjectIdGetDatum(typid)));
+}
+
+/*
+ * Add a column plan to a schema, folding its kind into the per-protocol
+ * fast-path flags.
+ */
+static void append_cached_column(CachedSchema& schema, CachedColumn&& col)
+{
+    if (col.kind == ConverterKind::Composite ||
+        (col.kind == ConverterKind::Array &&
+         col.array_element_kind == ConverterKind::Composite)) {
+        schema.has_recursive_columns = true;
+    }
+    if (!is_msgpack_fast_column(col)) {
+        schema.msgpack_fast_supported = false;
+        schema.cbor_fast_supported = false;
+        schema.zera_fast_supported = false;
+        schema.flex_fast_supported = false;
+    }
+
+    schema.column_index_by_name.emplace(col.name, schema.columns.size());
+    schema.columns.push_back(std::move(col));
+    schema.columns.back().msgpack_key_view = schema.columns.back().msgpack_key_encoded;
+    schema.columns.back().msgpack_key_ptr = schema.columns.back().msgpack_key_encoded.data();
+    schema.columns.back().msgpack_key_len = schema.columns.back().msgpack_key_encoded.size();
+}
+
+static void finish_cached_schema(CachedSchema& schema)
+{
+    schema.msgpack_map_header_encoded = encode_msgpack_map_header(schema.columns.size());
+    schema.msgpack_map_header_ptr = schema.msgpack_map_header_encoded.data();
+    schema.msgpack_map_header_len = schema.msgpack_map_header_encoded.size();
+}
+
 /*
  * Get per-schema metadata with caching to avoid repeated catalog lookups and
  * repeated per-column type classification.
@@ -414,8 +1176,11 @@ static const CachedSchema& get_cached_schema(Oid tupType, int32 tupTypmod)
 
     auto it = schema_cache.find(key);
     if (it != schema_cache.end()) {
+        touch_cached_schema(it->second);
+        stats_count(StatsCacheMetric::Hits);
         return it->second;
     }
+    stats_count(StatsCacheMetric::Misses);
 
     // Not in cache, look it up
     TupleDesc tupdesc = lookup_rowtype_tupdesc(tupType, tupTypmod);
@@ -425,14 +1190,12 @@ static const CachedSchema& get_cached_schema(Oid tupType, int32 tupTypmod)
     ReleaseTupleDesc(tupdesc);
 
     CachedSchema schema;
-    schema.tupdesc = cached_tupdesc;
-    schema.use_deform_access = false;
-    schema.msgpack_has_recursive_columns = false;
-    schema.msgpack_fast_supported = true;
-    schema.cbor_fast_supported = true;
-    schema.zera_fast_supported = true;
-    schema.flex_fast_supported = true;
+    init_cached_schema(schema, cached_tupdesc);
     schema.columns.reserve(cached_tupdesc->natts);
+    if (tupType != RECORDOID) {
+        schema.relid = get_typ_typrelid(tupType);
+    }
+    note_schema_type(schema, tupType);
 
     for (int i = 0; i < cached_tupdesc->natts; i++) {
         Form_pg_attribute att = TupleDescAttr(cached_tupdesc, i);
@@ -448,123 +1211,582 @@ static const CachedSchema& get_cached_schema(Oid tupType, int32 tupTypmod)
         col.msgpack_key_ptr = nullptr;
         col.msgpack_key_len = 0;
         col.zera_key_encoded = encode_zera_key(col.name);
-        col.msgpack_scalar_writer = nullptr;
-        col.msgpack_array_elem_writer = nullptr;
-        col.typid = att->atttypid;
-        col.kind = classify_type(col.typid);
-        col.msgpack_scalar_writer = select_msgpack_scalar_writer(col.kind);
-        col.typoutput = InvalidOid;
-        col.array_element_typid = InvalidOid;
-        col.array_element_typoutput = InvalidOid;
-        col.array_element_kind = ConverterKind::Fallback;
-        col.array_typlen = 0;
-        col.array_typbyval = false;
-        col.array_typalign = 'i';
-
-        if (col.kind == ConverterKind::Array) {
-            col.array_element_typid = get_element_type(col.typid);
-            if (OidIsValid(col.array_element_typid)) {
-                col.array_element_kind = classify_type(col.array_element_typid);
-                col.msgpack_array_elem_writer = select_msgpack_array_elem_writer(col.array_element_kind);
-                bool element_typisvarlena;
-                getTypeOutputInfo(col.array_element_typid,
-                                  &col.array_element_typoutput,
-                                  &element_typisvarlena);
-                get_typlenbyvalalign(col.array_element_typid,
-                                    &col.array_typlen,
-                                    &col.array_typbyval,
-                                    &col.array_typalign);
-            }
-        }
-
-        if (!is_msgpack_fast_column(col)) {
-            schema.msgpack_fast_supported = false;
-        }
-        if (col.kind == ConverterKind::Composite ||
-            (col.kind == ConverterKind::Array &&
-             col.array_element_kind == ConverterKind::Composite)) {
-            schema.msgpack_has_recursive_columns = true;
-        }
-        if (!is_msgpack_fast_column(col) || col.kind == ConverterKind::Composite ||
-            (col.kind == ConverterKind::Array &&
-             col.array_element_kind == ConverterKind::Composite)) {
-            schema.cbor_fast_supported = false;
-            schema.zera_fast_supported = false;
-            schema.flex_fast_supported = false;
-        }
-
-        if (col.kind == ConverterKind::Fallback || col.kind == ConverterKind::Array) {
-            bool typIsVarlena;
-            getTypeOutputInfo(col.typid, &col.typoutput, &typIsVarlena);
+        col.cbor_key_encoded = encode_cbor_key(col.name);
+        col.typmod = att->atttypmod;
+        init_cached_column_type(col, att->atttypid, classify_type(att->atttypid));
+        note_schema_type(schema, col.typid);
+        if (OidIsValid(col.array_element_typid)) {
+            note_schema_type(schema, col.array_element_typid);
         }
-
-        schema.columns.push_back(std::move(col));
-        schema.columns.back().msgpack_key_view = schema.columns.back().msgpack_key_encoded;
-        schema.columns.back().msgpack_key_ptr = schema.columns.back().msgpack_key_encoded.data();
-        schema.columns.back().msgpack_key_len = schema.columns.back().msgpack_key_encoded.size();
+        append_cached_column(schema, std::move(col));
     }
 
-    schema.msgpack_map_header_encoded = encode_msgpack_map_header(schema.columns.size());
-    schema.msgpack_map_header_ptr = schema.msgpack_map_header_encoded.data();
-    schema.msgpack_map_header_len = schema.msgpack_map_header_encoded.size();
+    finish_cached_schema(schema);
     schema.use_deform_access = schema.columns.size() >= kHybridHeapDeformThreshold;
 
+    trim_schema_cache(schema_cache);
     auto [inserted_it, inserted] = schema_cache.emplace(key, std::move(schema));
     (void)inserted;
+    touch_cached_schema(inserted_it->second);
     return inserted_it->second;
 }
 
 /*
- * Forward declarations for conversion functions
+ * Get the schema for a column subset, in the requested order. Column plans
+ * are copied from the full schema; the tuple descriptor stops at the highest
+ * projected attribute, so deforming never walks past it.
  */
-static z::dyn::Value datum_to_dynamic(Datum value, Oid typid, bool isnull);
-static z::dyn::Value record_to_dynamic_map(HeapTupleHeader rec);
-static bytea* try_serialize_msgpack_row_fast(HeapTupleHeader rec);
-static bytea* try_serialize_msgpack_array_fast(Datum* elements, bool* nulls, int nitems);
-static bytea* try_serialize_cbor_row_fast(HeapTupleHeader rec);
-static bytea* try_serialize_cbor_array_fast(Datum* elements, bool* nulls, int nitems);
-static bytea* try_serialize_zera_row_fast(HeapTupleHeader rec);
-static bytea* try_serialize_zera_array_fast(Datum* elements, bool* nulls, int nitems);
-static bytea* try_serialize_flex_row_fast(HeapTupleHeader rec);
-static bytea* try_serialize_flex_array_fast(Datum* elements, bool* nulls, int nitems);
-
-static z::dyn::Value array_level_to_dynamic(
-    Datum* elements,
-    bool* nulls,
-    Oid element_type,
-    const int* dims,
-    int ndim,
-    int depth,
-    int* offset)
+static const CachedSchema& get_projected_schema(
+    Oid tupType, int32 tupTypmod, const ColumnProjection& projection)
 {
-    z::dyn::Value::Array result;
-    result.reserve(dims[depth]);
+    ProjectionCacheKey key{tupType, tupTypmod, projection.key};
 
-    if (depth == ndim - 1) {
-        for (int i = 0; i < dims[depth]; i++, (*offset)++) {
-            result.push_back(datum_to_dynamic(
-                elements[*offset], element_type, nulls[*offset]));
+    auto it = projection_cache.find(key);
+    if (it != projection_cache.end()) {
+        touch_cached_schema(it->second);
+        stats_count(StatsCacheMetric::Hits);
+        return it->second;
+    }
+    stats_count(StatsCacheMetric::Misses);
+
+    const CachedSchema& full = get_cached_schema(tupType, tupTypmod);
+    std::vector<size_t> indexes;
+    indexes.reserve(projection.names.size());
+    int max_attnum = 0;
+    for (std::string_view name : projection.names) {
+        auto found = full.column_index_by_name.find(name);
+        if (found == full.column_index_by_name.end()) {
+            ereport(ERROR,
+                    (errcode(ERRCODE_UNDEFINED_COLUMN),
+                     errmsg("column \"%.*s\" does not exist in type %s",
+                            static_cast<int>(name.size()), name.data(),
+                            format_type_be(tupType))));
         }
-    } else {
-        for (int i = 0; i < dims[depth]; i++) {
-            result.push_back(array_level_to_dynamic(
-                elements, nulls, element_type, dims, ndim, depth + 1, offset));
+        for (size_t seen : indexes) {
+            if (seen == found->second) {
+                ereport(ERROR,
+                        (errcode(ERRCODE_DUPLICATE_COLUMN),
+                         errmsg("column \"%.*s\" specified more than once",
+                                static_cast<int>(name.size()), name.data())));
+            }
         }
+        indexes.push_back(found->second);
+        max_attnum = Max(max_attnum, full.columns[found->second].attnum);
     }
 
-    return z::dyn::Value::array(std::move(result));
+    MemoryContext old_context = MemoryContextSwitchTo(TopMemoryContext);
+    TupleDesc prefix = CreateTemplateTupleDesc(max_attnum);
+    for (int attnum = 1; attnum <= max_attnum; attnum++) {
+        TupleDescCopyEntry(prefix, attnum, full.tupdesc, attnum);
+    }
+    prefix->tdtypeid = full.tupdesc->tdtypeid;
+    prefix->tdtypmod = full.tupdesc->tdtypmod;
+    MemoryContextSwitchTo(old_context);
+
+    CachedSchema schema;
+    init_cached_schema(schema, prefix);
+    schema.columns.reserve(indexes.size());
+    for (size_t index : indexes) {
+        CachedColumn col = full.columns[index];
+        append_cached_column(schema, std::move(col));
+    }
+    finish_cached_schema(schema);
+    schema.use_deform_access = full.use_deform_access;
+    schema.relid = full.relid;
+    schema.type_hashes = full.type_hashes;
+
+    trim_schema_cache(projection_cache);
+    auto [inserted_it, inserted] = projection_cache.emplace(std::move(key), std::move(schema));
+    (void)inserted;
+    touch_cached_schema(inserted_it->second);
+    return inserted_it->second;
+}
+
+static const CachedSchema& get_record_schema(
+    HeapTupleHeader rec, const ColumnProjection* projection)
+{
+    Oid tupType = HeapTupleHeaderGetTypeId(rec);
+    int32 tupTypmod = HeapTupleHeaderGetTypMod(rec);
+    if (projection == nullptr) {
+        return get_cached_schema(tupType, tupTypmod);
+    }
+    return get_projected_schema(tupType, tupTypmod, *projection);
 }
 
 /*
- * Convert a PostgreSQL array to a zerialize dyn::Value array
+ * Resolve a schema through a memo, falling back to the keyed lookup when the
+ * type differs or an entry has been freed since the memo was filled. A memo
+ * serves one projection, or none, for its whole life.
  */
-static z::dyn::Value array_to_dynamic(Datum value, Oid typid)
+static inline const CachedSchema* memo_lookup(SchemaMemo& memo, Oid tupType, int32 tupTypmod)
 {
-    (void) typid;
-    ArrayType* arr = DatumGetArrayTypeP(value);
-    int ndim = ARR_NDIM(arr);
-
-    // Handle empty arrays
+    if (memo.schema == nullptr || memo.generation != schema_cache_generation ||
+        memo.typid != tupType || memo.typmod != tupTypmod) {
+        return nullptr;
+    }
+    touch_cached_schema(*memo.schema);
+    stats_count(StatsCacheMetric::Hits);
+    return memo.schema;
+}
+
+static inline const CachedSchema& memo_cached_schema(SchemaMemo& memo, Oid tupType, int32 tupTypmod)
+{
+    if (const CachedSchema* hit = memo_lookup(memo, tupType, tupTypmod)) {
+        return *hit;
+    }
+    const CachedSchema& schema = get_cached_schema(tupType, tupTypmod);
+    memo = SchemaMemo{&schema, schema_cache_generation, tupType, tupTypmod};
+    return schema;
+}
+
+static inline const CachedSchema& memo_record_schema(
+    SchemaMemo& memo, HeapTupleHeader rec, const ColumnProjection* projection)
+{
+    const Oid tupType = HeapTupleHeaderGetTypeId(rec);
+    const int32 tupTypmod = HeapTupleHeaderGetTypMod(rec);
+    if (const CachedSchema* hit = memo_lookup(memo, tupType, tupTypmod)) {
+        return *hit;
+    }
+    const CachedSchema& schema = get_record_schema(rec, projection);
+    memo = SchemaMemo{&schema, schema_cache_generation, tupType, tupTypmod};
+    return schema;
+}
+
+/*
+ * Resolve the schema of a SQL function's record argument, memoized in
+ * fn_extra so repeated calls from one call site skip the hash lookup.
+ */
+static const CachedSchema& call_site_record_schema(
+    FunctionCallInfo fcinfo, HeapTupleHeader rec, const ColumnProjection* projection)
+{
+    if (fcinfo == nullptr || fcinfo->flinfo == nullptr || projection != nullptr) {
+        return get_record_schema(rec, projection);
+    }
+    auto* memo = static_cast<SchemaMemo*>(fcinfo->flinfo->fn_extra);
+    if (memo == nullptr) {
+        memo = new (MemoryContextAlloc(fcinfo->flinfo->fn_mcxt, sizeof(SchemaMemo))) SchemaMemo();
+        fcinfo->flinfo->fn_extra = memo;
+    }
+    return memo_record_schema(*memo, rec, nullptr);
+}
+
+/*
+ * Forward declarations for conversion functions
+ */
+static z::dyn::Value datum_to_dynamic(Datum value, Oid typid, bool isnull);
+static z::dyn::Value record_to_dynamic_map(
+    HeapTupleHeader rec, const ColumnProjection* projection = nullptr);
+static bytea* try_serialize_msgpack_row_fast(HeapTupleHeader rec, const CachedSchema& schema);
+/*
+ * Worker threads for pg_zerialize.batch_threads, owned by the backend. They
+ * start on first use with every signal blocked, so PostgreSQL's handlers only
+ * run on the backend's own thread, and are joined in proc_exit. run() hands
+ * slice indexes to the workers and the calling thread alike and returns once
+ * every slice is done. Slice functions must not palloc, ereport, or touch any
+ * other backend state, and must not throw.
+ */
+class BatchWorkerPool {
+public:
+    using SliceFn = void (*)(void* arg, int slice);
+
+    // Starts workers up to `workers`; returns how many are running.
+    int ensure_workers(int workers)
+    {
+        if (static_cast<int>(threads_.size()) >= workers) {
+            return workers;
+        }
+        sigset_t blocked;
+        sigset_t saved;
+        sigfillset(&blocked);
+        pthread_sigmask(SIG_SETMASK, &blocked, &saved);
+        try {
+            while (static_cast<int>(threads_.size()) < workers) {
+                threads_.emplace_back(&BatchWorkerPool::worker_main, this);
+            }
+        } catch (const std::exception&) {
+            // Run with the threads that did start.
+        }
+        pthread_sigmask(SIG_SETMASK, &saved, nullptr);
+        return static_cast<int>(threads_.size());
+    }
+
+    void run(int nslices, SliceFn fn, void* arg)
+    {
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            fn_ = fn;
+            arg_ = arg;
+            nslices_ = nslices;
+            next_.store(0);
+            finished_.store(0);
+            generation_++;
+        }
+        wake_.notify_all();
+        drain(fn, arg, nslices);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_.wait(lock, [&] { return active_ == 0 && finished_.load() == nslices; });
+        // Workers that wake from here on find no work to pick up.
+        fn_ = nullptr;
+        arg_ = nullptr;
+    }
+
+    void shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (std::thread& thread : threads_) {
+            thread.join();
+        }
+        threads_.clear();
+    }
+
+private:
+    void worker_main()
+    {
+        uint64 seen = 0;
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            wake_.wait(lock, [&] { return stopping_ || (fn_ != nullptr && generation_ != seen); });
+            if (stopping_) {
+                return;
+            }
+            seen = generation_;
+            SliceFn fn = fn_;
+            void* arg = arg_;
+            const int nslices = nslices_;
+            active_++;
+            lock.unlock();
+            drain(fn, arg, nslices);
+            lock.lock();
+            active_--;
+            idle_.notify_one();
+        }
+    }
+
+    void drain(SliceFn fn, void* arg, int nslices)
+    {
+        for (int slice = next_.fetch_add(1); slice < nslices; slice = next_.fetch_add(1)) {
+            fn(arg, slice);
+            finished_.fetch_add(1);
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    std::vector<std::thread> threads_;
+    SliceFn fn_ = nullptr;
+    void* arg_ = nullptr;
+    int nslices_ = 0;
+    uint64 generation_ = 0;
+    int active_ = 0;
+    std::atomic<int> next_{0};
+    std::atomic<int> finished_{0};
+    bool stopping_ = false;
+};
+
+static void batch_worker_pool_shutdown(int, Datum);
+
+// Never destroyed, so no thread outlives its mutex at exit.
+static BatchWorkerPool& batch_worker_pool()
+{
+    static BatchWorkerPool* pool = nullptr;
+    if (pool == nullptr) {
+        pool = new BatchWorkerPool();
+        on_proc_exit(batch_worker_pool_shutdown, (Datum) 0);
+    }
+    return *pool;
+}
+
+static void batch_worker_pool_shutdown(int, Datum)
+{
+    batch_worker_pool().shutdown();
+}
+
+/*
+ * Columns a batch worker can encode: every writer for these kinds only reads
+ * the datum and the GUCs, once the backend has detoasted varlena values.
+ */
+static bool is_msgpack_threaded_kind(ConverterKind kind)
+{
+    switch (kind) {
+        case ConverterKind::Int2:
+        case ConverterKind::Int4:
+        case ConverterKind::Int8:
+        case ConverterKind::Float4:
+        case ConverterKind::Float8:
+        case ConverterKind::Bool:
+        case ConverterKind::Text:
+        case ConverterKind::JsonText:
+        case ConverterKind::Bytea:
+        case ConverterKind::Uuid:
+        case ConverterKind::NameText:
+        case ConverterKind::CharText:
+        case ConverterKind::Date:
+        case ConverterKind::Timestamp:
+        case ConverterKind::Timestamptz:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool is_msgpack_varlena_kind(ConverterKind kind)
+{
+    return kind == ConverterKind::Text || kind == ConverterKind::JsonText ||
+           kind == ConverterKind::Bytea;
+}
+
+static bool schema_msgpack_threaded(const CachedSchema& schema)
+{
+    for (const CachedColumn& col : schema.columns) {
+        if (!is_msgpack_threaded_kind(col.kind)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * msgpack_write_record_map for batch workers. The backend deformed and
+ * detoasted the row beforehand, so this touches neither the tuple
+ * descriptor nor palloc.
+ */
+static void msgpack_write_record_map_detached(
+    z::MsgPackSerializer& writer,
+    const CachedSchema& schema,
+    const Datum* values,
+    const bool* isnull)
+{
+    if (schema.columns.size() > 15) {
+        writer.begin_map_preencoded(schema.msgpack_map_header_ptr, schema.msgpack_map_header_len);
+    } else {
+        writer.begin_map(schema.columns.size());
+    }
+    for (const CachedColumn& col : schema.columns) {
+        const int idx = col.attnum - 1;
+        writer.key_preencoded(col.msgpack_key_ptr, col.msgpack_key_len);
+        col.msgpack_scalar_writer(writer, col, values[idx], isnull[idx]);
+    }
+    writer.end_map();
+}
+
+struct MsgpackBatchJob {
+    const CachedSchema* const* schemas;  // nullptr for null rows
+    const Datum* values;                 // max_natts per row
+    const bool* isnull;
+    int nitems;
+    int nslices;
+    int max_natts;
+    std::deque<z::MsgPackRootSerializer>* roots;  // malloc-backed, one per slice
+    bool* slice_ok;
+};
+
+static void msgpack_encode_batch_slice(void* arg, int slice)
+{
+    const MsgpackBatchJob& job = *static_cast<const MsgpackBatchJob*>(arg);
+    const int begin = static_cast<int>(static_cast<int64>(job.nitems) * slice / job.nslices);
+    const int end = static_cast<int>(static_cast<int64>(job.nitems) * (slice + 1) / job.nslices);
+    z::MsgPackRootSerializer& rs = (*job.roots)[slice];
+    bool ok = true;
+
+    msgpack_sbuffer_clear(&rs.sbuf);
+    try {
+        z::MsgPackSerializer writer(rs);
+
+        for (int i = begin; i < end; i++) {
+            if (job.schemas[i] == nullptr) {
+                writer.null();
+            } else {
+                const size_t row = static_cast<size_t>(i) * job.max_natts;
+                msgpack_write_record_map_detached(
+                    writer, *job.schemas[i], job.values + row, job.isnull + row);
+            }
+        }
+    } catch (...) {
+        ok = false;
+    }
+    job.slice_ok[slice] = ok;
+}
+
+static void msgpack_write_array_header(uint8_t* out, size_t* len, uint32_t n)
+{
+    if (n <= 15) {
+        out[0] = static_cast<uint8_t>(0x90 | n);
+        *len = 1;
+    } else if (n <= UINT16_MAX) {
+        out[0] = 0xdc;
+        out[1] = static_cast<uint8_t>(n >> 8);
+        out[2] = static_cast<uint8_t>(n);
+        *len = 3;
+    } else {
+        out[0] = 0xdd;
+        out[1] = static_cast<uint8_t>(n >> 24);
+        out[2] = static_cast<uint8_t>(n >> 16);
+        out[3] = static_cast<uint8_t>(n >> 8);
+        out[4] = static_cast<uint8_t>(n);
+        *len = 5;
+    }
+}
+
+/*
+ * Encode a batch on pg_zerialize.batch_threads threads: each takes a
+ * contiguous slice of rows into its own buffer, and the slices are joined
+ * after the array header. The backend deforms every row and detoasts its
+ * varlena values first, so workers share no tuple descriptor and never
+ * palloc. Returns nullptr when the batch is too small, has columns the
+ * workers cannot write, or a worker failed; the caller then encodes serially.
+ */
+static bytea* try_serialize_msgpack_array_threaded(
+    const std::vector<HeapTupleHeader>& records,
+    const std::vector<const CachedSchema*>& schemas,
+    int nitems)
+{
+    if (batch_threads <= 1 || nitems < 2 * kBatchThreadSliceRows) {
+        return nullptr;
+    }
+
+    int max_natts = 1;
+    const CachedSchema* checked = nullptr;
+    for (const CachedSchema* schema : schemas) {
+        if (schema == nullptr || schema == checked) {
+            continue;
+        }
+        if (!schema_msgpack_threaded(*schema)) {
+            return nullptr;
+        }
+        max_natts = Max(max_natts, schema->tupdesc->natts);
+        checked = schema;
+    }
+
+    int nslices = Min(batch_threads, nitems / kBatchThreadSliceRows);
+    BatchWorkerPool& pool = batch_worker_pool();
+    nslices = Min(nslices, pool.ensure_workers(nslices - 1) + 1);
+    if (nslices <= 1) {
+        return nullptr;
+    }
+
+    // Deformed rows and detoasted copies live only as long as the batch.
+    MemoryContext batch_cxt = AllocSetContextCreate(CurrentMemoryContext,
+                                                    "pg_zerialize batch rows",
+                                                    ALLOCSET_DEFAULT_SIZES);
+    MemoryContext old_cxt = MemoryContextSwitchTo(batch_cxt);
+    const size_t ncells = static_cast<size_t>(nitems) * max_natts;
+    Datum* values = (Datum*) palloc_extended(ncells * sizeof(Datum), MCXT_ALLOC_HUGE);
+    bool* isnull = (bool*) palloc_extended(ncells * sizeof(bool), MCXT_ALLOC_HUGE);
+    for (int i = 0; i < nitems; i++) {
+        if (records[i] == nullptr) {
+            continue;
+        }
+        Datum* row_values = values + static_cast<size_t>(i) * max_natts;
+        bool* row_isnull = isnull + static_cast<size_t>(i) * max_natts;
+        HeapTupleData tuple;
+        tuple.t_len = HeapTupleHeaderGetDatumLength(records[i]);
+        tuple.t_data = records[i];
+        heap_deform_tuple(&tuple, schemas[i]->tupdesc, row_values, row_isnull);
+        for (const CachedColumn& col : schemas[i]->columns) {
+            const int idx = col.attnum - 1;
+            if (!row_isnull[idx] && is_msgpack_varlena_kind(col.kind)) {
+                row_values[idx] = PointerGetDatum(
+                    pg_detoast_datum_packed((struct varlena*) DatumGetPointer(row_values[idx])));
+            }
+        }
+    }
+    MemoryContextSwitchTo(old_cxt);
+
+    // Slice buffers are kept for the next batch, like msgpack_reusable_root.
+    static std::deque<z::MsgPackRootSerializer> slice_roots;
+    while (static_cast<int>(slice_roots.size()) < nslices) {
+        slice_roots.emplace_back();
+    }
+    std::array<bool, kBatchThreadsMax> slice_ok{};
+    MsgpackBatchJob job{schemas.data(), values, isnull, nitems, nslices, max_natts,
+                        &slice_roots, slice_ok.data()};
+    pool.run(nslices, msgpack_encode_batch_slice, &job);
+    MemoryContextDelete(batch_cxt);
+
+    bool ok = true;
+    size_t len = 0;
+    for (int i = 0; i < nslices; i++) {
+        ok = ok && slice_ok[i];
+        len += slice_roots[i].sbuf.size;
+    }
+    if (!ok) {
+        for (int i = 0; i < nslices; i++) {
+            msgpack_sbuffer_clear(&slice_roots[i].sbuf);
+        }
+        return nullptr;
+    }
+
+    uint8_t header[5];
+    size_t header_len;
+    msgpack_write_array_header(header, &header_len, static_cast<uint32_t>(nitems));
+    bytea* result = (bytea*) palloc(header_len + len + VARHDRSZ);
+    SET_VARSIZE(result, header_len + len + VARHDRSZ);
+    char* out = VARDATA(result);
+    memcpy(out, header, header_len);
+    out += header_len;
+    for (int i = 0; i < nslices; i++) {
+        memcpy(out, slice_roots[i].sbuf.data, slice_roots[i].sbuf.size);
+        out += slice_roots[i].sbuf.size;
+        msgpack_sbuffer_clear(&slice_roots[i].sbuf);
+    }
+    return result;
+}
+
+static bytea* try_serialize_msgpack_array_fast(
+    Datum* elements, bool* nulls, int nitems, const ColumnProjection* projection);
+static bytea* try_serialize_cbor_row_fast(HeapTupleHeader rec, const CachedSchema& schema);
+static bytea* try_serialize_cbor_array_fast(
+    Datum* elements, bool* nulls, int nitems, const ColumnProjection* projection);
+static bytea* try_serialize_zera_row_fast(HeapTupleHeader rec, const CachedSchema& schema);
+static bytea* try_serialize_zera_array_fast(
+    Datum* elements, bool* nulls, int nitems, const ColumnProjection* projection);
+static bytea* try_serialize_flex_row_fast(HeapTupleHeader rec, const CachedSchema& schema);
+static bytea* try_serialize_flex_array_fast(
+    Datum* elements, bool* nulls, int nitems, const ColumnProjection* projection);
+
+static z::dyn::Value array_level_to_dynamic(
+    Datum* elements,
+    bool* nulls,
+    Oid element_type,
+    const int* dims,
+    int ndim,
+    int depth,
+    int* offset)
+{
+    z::dyn::Value::Array result;
+    result.reserve(dims[depth]);
+
+    if (depth == ndim - 1) {
+        for (int i = 0; i < dims[depth]; i++, (*offset)++) {
+            result.push_back(datum_to_dynamic(
+                elements[*offset], element_type, nulls[*offset]));
+        }
+    } else {
+        for (int i = 0; i < dims[depth]; i++) {
+            result.push_back(array_level_to_dynamic(
+                elements, nulls, element_type, dims, ndim, depth + 1, offset));
+        }
+    }
+
+    return z::dyn::Value::array(std::move(result));
+}
+
+/*
+ * Convert a PostgreSQL array to a zerialize dyn::Value array
+ */
+static z::dyn::Value array_to_dynamic(Datum value, Oid typid)
+{
+    (void) typid;
+    ArrayType* arr = DatumGetArrayTypeP(value);
+    int ndim = ARR_NDIM(arr);
+
+    // Handle empty arrays
     if (ndim == 0 || ArrayGetNItems(ndim, ARR_DIMS(arr)) == 0) {
         return z::dyn::Value::array(z::dyn::Value::Array());
     }
@@ -619,8 +1841,180 @@ static inline bool numeric_text_try_int64(
     return parsed.ec == std::errc() && parsed.ptr == integer_end;
 }
 
+/*
+ * The on-disk numeric layout from numeric.c, unchanged since PostgreSQL 14:
+ * a uint16 header, an int16 weight unless the header marks the short form,
+ * then int16 base-10000 digits, most significant first, with no trailing
+ * zero digits. The header also holds the sign and display scale. Special
+ * values use header forms of their own.
+ */
+static constexpr uint16_t kNumericSignMask = 0xC000;
+static constexpr uint16_t kNumericNeg = 0x4000;
+static constexpr uint16_t kNumericShort = 0x8000;
+static constexpr uint16_t kNumericSpecial = 0xC000;
+static constexpr uint16_t kNumericExtSignMask = 0xF000;
+static constexpr uint16_t kNumericNaN = 0xC000;
+static constexpr uint16_t kNumericPInf = 0xD000;
+static constexpr uint16_t kNumericShortSignMask = 0x2000;
+static constexpr uint16_t kNumericShortWeightSignMask = 0x0040;
+static constexpr uint16_t kNumericShortWeightMask = 0x003F;
+static constexpr uint16_t kNumericShortDscaleMask = 0x1F80;
+static constexpr int kNumericShortDscaleShift = 7;
+static constexpr uint16_t kNumericDscaleMask = 0x3FFF;
+static constexpr int kNumericBase = 10000;
+
+// Longer non-integral values take the numeric_out path.
+static constexpr size_t kNumericDigitsMaxDirect = 64;
+
+struct NumericDigitArray {
+    bool special;
+    uint16_t special_kind;
+    bool negative;
+    int weight;
+    int dscale;
+    size_t ndigits;
+    const uint8_t* digits;
+};
+
+static bool numeric_read_digit_array(const uint8_t* data, size_t len, NumericDigitArray* out)
+{
+    auto read_u16 = [data](size_t offset) {
+        uint16_t word;
+        memcpy(&word, data + offset, sizeof(word));
+        return word;
+    };
+
+    if (len < 2) return false;
+    const uint16_t header = read_u16(0);
+    size_t offset;
+    *out = NumericDigitArray{};
+    if ((header & kNumericSignMask) == kNumericSpecial) {
+        out->special = true;
+        out->special_kind = header & kNumericExtSignMask;
+        return true;
+    }
+    if ((header & kNumericSignMask) == kNumericShort) {
+        out->negative = (header & kNumericShortSignMask) != 0;
+        out->weight = ((header & kNumericShortWeightSignMask) ? ~int{kNumericShortWeightMask} : 0) |
+                      (header & kNumericShortWeightMask);
+        out->dscale = (header & kNumericShortDscaleMask) >> kNumericShortDscaleShift;
+        offset = 2;
+    } else {
+        if (len < 4) return false;
+        out->negative = (header & kNumericSignMask) == kNumericNeg;
+        out->dscale = header & kNumericDscaleMask;
+        out->weight = static_cast<int16_t>(read_u16(2));
+        offset = 4;
+    }
+    out->ndigits = (len - offset) / 2;
+    out->digits = data + offset;
+    return true;
+}
+
+static bool numeric_decode_digits(const uint8_t* data, size_t len, bool allow_float,
+                                  NumericFastValue* out)
+{
+    NumericDigitArray array;
+    if (!numeric_read_digit_array(data, len, &array)) return false;
+    if (array.special) {
+        if (!allow_float) return false;
+        double number = std::numeric_limits<double>::quiet_NaN();
+        if (array.special_kind != kNumericNaN) {
+            number = array.special_kind == kNumericPInf ? std::numeric_limits<double>::infinity()
+                                                        : -std::numeric_limits<double>::infinity();
+        }
+        *out = NumericFastValue{false, 0, number};
+        return true;
+    }
+    const bool negative = array.negative;
+    const int weight = array.weight;
+    const size_t ndigits = array.ndigits;
+    const uint8_t* digits = array.digits;
+
+    /* Integral when no digit sits right of the decimal point. */
+    if (ndigits == 0 || (weight >= 0 && ndigits <= static_cast<size_t>(weight) + 1)) {
+        if (weight <= 4) {
+            uint64_t magnitude = 0;
+            bool overflow = false;
+            for (int i = 0; i <= weight && ndigits > 0; i++) {
+                uint16_t digit = 0;
+                if (static_cast<size_t>(i) < ndigits) {
+                    memcpy(&digit, digits + 2 * i, sizeof(digit));
+                    if (digit >= kNumericBase) return false;
+                }
+                overflow |= __builtin_mul_overflow(magnitude, uint64_t{kNumericBase}, &magnitude);
+                overflow |= __builtin_add_overflow(magnitude, uint64_t{digit}, &magnitude);
+            }
+            const uint64_t limit = static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) +
+                                   (negative ? 1 : 0);
+            if (!overflow && magnitude <= limit) {
+                const int64_t number = negative
+                    ? static_cast<int64_t>(0 - magnitude)
+                    : static_cast<int64_t>(magnitude);
+                *out = NumericFastValue{true, number, 0.0};
+                return true;
+            }
+        }
+    }
+
+    if (!allow_float || ndigits > kNumericDigitsMaxDirect) return false;
+
+    /*
+     * The exact value is the digit string times 10^(4 * (weight + 1 -
+     * ndigits)); fast_float rounds that decimal form correctly. It is the
+     * same decimal that numeric_out would print.
+     */
+    std::array<char, kNumericDigitsMaxDirect * 4 + 16> buffer;
+    char* p = buffer.data();
+    if (negative) *p++ = '-';
+    for (size_t i = 0; i < ndigits; i++) {
+        uint16_t digit;
+        memcpy(&digit, digits + 2 * i, sizeof(digit));
+        if (digit >= kNumericBase) return false;
+        p[0] = static_cast<char>('0' + digit / 1000);
+        p[1] = static_cast<char>('0' + digit / 100 % 10);
+        p[2] = static_cast<char>('0' + digit / 10 % 10);
+        p[3] = static_cast<char>('0' + digit % 10);
+        p += 4;
+    }
+    *p++ = 'e';
+    const int exponent = 4 * (weight + 1 - static_cast<int>(ndigits));
+    p = std::to_chars(p, buffer.data() + buffer.size(), exponent).ptr;
+
+    double number;
+    auto parsed = fast_float::from_chars(buffer.data(), p, number);
+    if (parsed.ec != std::errc() || parsed.ptr != p) {
+        // Preserve PostgreSQL's overflow behavior.
+        return false;
+    }
+    *out = NumericFastValue{false, 0, number};
+    return true;
+}
+
+/*
+ * Reads the digits in place, detoasting only compressed or external values.
+ * Returns false when the numeric_out path must decide.
+ */
+static inline bool numeric_parse_digits(Datum value, NumericFastValue* out)
+{
+    auto* raw = reinterpret_cast<struct varlena*>(DatumGetPointer(value));
+    struct varlena* packed = pg_detoast_datum_packed(raw);
+    const bool parsed = numeric_decode_digits(
+        reinterpret_cast<const uint8_t*>(VARDATA_ANY(packed)), VARSIZE_ANY_EXHDR(packed),
+        numeric_float_backend == NUMERIC_FLOAT_FAST_FLOAT, out);
+    if (packed != raw) {
+        pfree(packed);
+    }
+    return parsed;
+}
+
 static inline NumericFastValue numeric_parse_fast(Datum value)
 {
+    NumericFastValue direct;
+    if (numeric_parse_digits(value, &direct)) {
+        return direct;
+    }
+
     char* text = DatumGetCString(DirectFunctionCall1(numeric_out, value));
     const char* end = text + std::strlen(text);
     int64_t int64_value;
@@ -647,4361 +2041,11775 @@ static inline NumericFastValue numeric_parse_fast(Datum value)
     return NumericFastValue{false, 0, DatumGetFloat8(float_val)};
 }
 
-template <typename WriterT>
-static inline void numeric_write_fast(WriterT& writer, Datum value)
-{
-    if (numeric_encoding == NUMERIC_ENCODING_TAGGED_DECIMAL) {
-        char* text = DatumGetCString(DirectFunctionCall1(numeric_out, value));
-        writer.begin_array(3);
-        writer.string("~n");
-        writer.string(std::string_view(text));
-        writer.string("decimal");
-        writer.end_array();
-        pfree(text);
-        return;
-    }
+/*
+ * Binary decimal encoding (pg_zerialize.numeric_encoding = binary_decimal).
+ * A finite numeric is written as mantissa * 10^exponent, the exponent being
+ * its negated display scale, so 1.20 keeps both fractional digits:
+ *
+ *   CBOR          RFC 8949 tag 4 decimal fraction [exponent, mantissa], the
+ *                 mantissa an integer or a tag 2/3 bignum
+ *   MessagePack   ext type 4: a big-endian int16 exponent, then the mantissa
+ *                 as minimal big-endian two's complement
+ *   ZERA, Flex    ["~d", exponent, mantissa], the mantissa an integer or,
+ *                 past int64, a blob of the same two's-complement bytes
+ *
+ * NaN and the infinities have no decimal form and are written as float64.
+ * Decoders accept exponents in the int16 range.
+ */
+static constexpr uint8_t kMsgpackDecimalExt = 4;
+// Past numeric's 131072 integral and 16383 fractional digits.
+static constexpr size_t kDecimalMantissaMaxBytes = 65536;
 
-    NumericFastValue parsed = numeric_parse_fast(value);
-    if (parsed.is_int64) {
-        writer.int64(parsed.int64_value);
-    } else {
-        writer.double_(parsed.float8_value);
-    }
-}
-
-static inline z::dyn::Value numeric_to_dynamic_fast(Datum value)
-{
-    if (numeric_encoding == NUMERIC_ENCODING_TAGGED_DECIMAL) {
-        char* text = DatumGetCString(DirectFunctionCall1(numeric_out, value));
-        z::dyn::Value::Array tagged;
-        tagged.reserve(3);
-        tagged.emplace_back("~n");
-        tagged.emplace_back(std::string(text));
-        tagged.emplace_back("decimal");
-        pfree(text);
-        return z::dyn::Value::array(std::move(tagged));
-    }
+class JsonbDecodeWriter;
 
-    NumericFastValue parsed = numeric_parse_fast(value);
-    if (parsed.is_int64) {
-        return z::dyn::Value(parsed.int64_value);
-    }
-    return z::dyn::Value(parsed.float8_value);
-}
+struct DecimalValue {
+    bool negative = false;
+    int exponent = 0;
+    /* Unscaled digits without leading zeros; "0" for zero. */
+    std::string_view digits;
+    std::array<char, 40> inline_storage;
+    std::string heap_storage;
 
-static z::dyn::Value jsonb_token_to_dynamic(JsonbIterator** it, JsonbIteratorToken tok, JsonbValue* v);
+    DecimalValue() = default;
+    DecimalValue(const DecimalValue&) = delete;
+    DecimalValue& operator=(const DecimalValue&) = delete;
 
-static z::dyn::Value jsonb_scalar_to_dynamic(const JsonbValue& v)
-{
-    switch (v.type) {
-        case jbvNull:
-            return z::dyn::Value();
-        case jbvBool:
-            return z::dyn::Value(v.val.boolean);
-        case jbvNumeric:
-            return numeric_to_dynamic_fast(NumericGetDatum(v.val.numeric));
-        case jbvString:
-            return z::dyn::Value(std::string(v.val.string.val, v.val.string.len));
-        default:
-            ereport(ERROR,
-                    (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-                     errmsg("unsupported jsonb scalar type for msgpack conversion")));
+    char* reserve(size_t size)
+    {
+        if (size <= inline_storage.size()) return inline_storage.data();
+        heap_storage.resize(size);
+        return heap_storage.data();
     }
-}
+};
 
-static z::dyn::Value jsonb_token_to_dynamic(JsonbIterator** it, JsonbIteratorToken tok, JsonbValue* v)
+/* Points digits at p, dropping leading zeros; set the sign first. */
+static void decimal_set_digits(DecimalValue* out, const char* p, size_t size)
 {
-    if (tok == WJB_BEGIN_OBJECT) {
-        z::dyn::Value::Map map_entries;
-        JsonbIteratorToken t = JsonbIteratorNext(it, v, false);
-        while (t != WJB_END_OBJECT) {
-            if (t != WJB_KEY) {
-                ereport(ERROR,
-                        (errcode(ERRCODE_DATA_CORRUPTED),
-                         errmsg("invalid jsonb object token sequence")));
-            }
-            std::string key(v->val.string.val, v->val.string.len);
-            t = JsonbIteratorNext(it, v, false);
-            map_entries.emplace_back(std::move(key), jsonb_token_to_dynamic(it, t, v));
-            t = JsonbIteratorNext(it, v, false);
-        }
-        return z::dyn::Value::map(std::move(map_entries));
+    while (size > 1 && *p == '0') {
+        p++;
+        size--;
     }
-
-    if (tok == WJB_BEGIN_ARRAY) {
-        z::dyn::Value::Array arr;
-        JsonbIteratorToken t = JsonbIteratorNext(it, v, false);
-        while (t != WJB_END_ARRAY) {
-            arr.push_back(jsonb_token_to_dynamic(it, t, v));
-            t = JsonbIteratorNext(it, v, false);
-        }
-        return z::dyn::Value::array(std::move(arr));
+    if (size == 0 || (size == 1 && *p == '0')) {
+        out->digits = "0";
+        out->negative = false;
+        return;
     }
+    out->digits = std::string_view(p, size);
+}
+
+/* Reads a finite numeric's digit array; false for special values. */
+static bool numeric_decimal_from_digits(const uint8_t* data, size_t len, DecimalValue* out)
+{
+    NumericDigitArray array;
+    if (!numeric_read_digit_array(data, len, &array) || array.special) return false;
+    if (array.ndigits == 0) {
+        out->exponent = -array.dscale;
+        decimal_set_digits(out, "0", 1);
+        return true;
+    }
+
+    /*
+     * The value times 10^dscale is the digit string times 10^shift. Storage
+     * keeps no digit past the display scale, so a negative shift only drops
+     * zeros from the last base-10000 digit.
+     */
+    const int shift = 4 * (array.weight + 1 - static_cast<int>(array.ndigits)) + array.dscale;
+    if (shift < -3) return false;
+    const size_t written = 4 * array.ndigits;
+    const size_t padding = shift > 0 ? static_cast<size_t>(shift) : 0;
+    char* p = out->reserve(written + padding);
+    for (size_t i = 0; i < array.ndigits; i++) {
+        uint16_t digit;
+        memcpy(&digit, array.digits + 2 * i, sizeof(digit));
+        if (digit >= kNumericBase) return false;
+        p[4 * i] = static_cast<char>('0' + digit / 1000);
+        p[4 * i + 1] = static_cast<char>('0' + digit / 100 % 10);
+        p[4 * i + 2] = static_cast<char>('0' + digit / 10 % 10);
+        p[4 * i + 3] = static_cast<char>('0' + digit % 10);
+    }
+    memset(p + written, '0', padding);
+    size_t size = written + padding;
+    for (int i = shift; i < 0; i++) {
+        if (p[--size] != '0') return false;
+    }
+    out->negative = array.negative;
+    out->exponent = -array.dscale;
+    decimal_set_digits(out, p, size);
+    return true;
+}
 
-    if (tok == WJB_VALUE || tok == WJB_ELEM) {
-        return jsonb_scalar_to_dynamic(*v);
+/* Reads numeric_out text; false for NaN and the infinities. */
+static bool numeric_decimal_from_text(const char* text, DecimalValue* out)
+{
+    const bool negative = *text == '-';
+    if (negative) text++;
+    char* p = out->reserve(std::strlen(text));
+    size_t size = 0;
+    int scale = 0;
+    bool point = false;
+    for (; *text != '\0'; text++) {
+        if (*text == '.' && !point) {
+            point = true;
+        } else if (*text >= '0' && *text <= '9') {
+            p[size++] = *text;
+            scale += point ? 1 : 0;
+        } else {
+            return false;
+        }
     }
-
-    ereport(ERROR,
-            (errcode(ERRCODE_DATA_CORRUPTED),
-             errmsg("invalid jsonb token for conversion")));
+    if (size == 0) return false;
+    out->negative = negative;
+    out->exponent = -scale;
+    decimal_set_digits(out, p, size);
+    return true;
 }
 
-static inline void msgpack_require_bytes(
-    std::span<const uint8_t> data, size_t pos, size_t count)
+/*
+ * Reads the digits in place like numeric_parse_digits; layouts the reader
+ * does not expect go through numeric_out. Returns false for NaN and the
+ * infinities.
+ */
+static bool numeric_to_decimal(Datum value, DecimalValue* out)
 {
-    if (pos > data.size() || count > data.size() - pos) {
-        throw z::DeserializationError("truncated MessagePack value");
+    auto* raw = reinterpret_cast<struct varlena*>(DatumGetPointer(value));
+    struct varlena* packed = pg_detoast_datum_packed(raw);
+    bool read = numeric_decimal_from_digits(
+        reinterpret_cast<const uint8_t*>(VARDATA_ANY(packed)), VARSIZE_ANY_EXHDR(packed), out);
+    if (packed != raw) {
+        pfree(packed);
     }
+    if (read) return true;
+
+    char* text = DatumGetCString(DirectFunctionCall1(numeric_out, value));
+    read = numeric_decimal_from_text(text, out);
+    pfree(text);
+    return read;
 }
 
-static inline uint16_t msgpack_read_u16(std::span<const uint8_t> data, size_t pos)
+static bool decimal_mantissa_int64(const DecimalValue& value, int64_t* out)
 {
-    msgpack_require_bytes(data, pos, 2);
-    return static_cast<uint16_t>(
-        (static_cast<uint16_t>(data[pos]) << 8) | data[pos + 1]);
+    if (value.digits.size() > 19) return false;
+    uint64_t magnitude = 0;
+    std::from_chars(value.digits.data(), value.digits.data() + value.digits.size(), magnitude);
+    const uint64_t limit = static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) +
+                           (value.negative ? 1 : 0);
+    if (magnitude > limit) return false;
+    *out = value.negative ? static_cast<int64_t>(0 - magnitude) : static_cast<int64_t>(magnitude);
+    return true;
 }
 
-static inline uint32_t msgpack_read_u32(std::span<const uint8_t> data, size_t pos)
+/* Drops sign-extension bytes from big-endian two's complement. */
+static size_t twos_complement_trim(const uint8_t* bytes, size_t size)
 {
-    msgpack_require_bytes(data, pos, 4);
-    return (static_cast<uint32_t>(data[pos]) << 24) |
-           (static_cast<uint32_t>(data[pos + 1]) << 16) |
-           (static_cast<uint32_t>(data[pos + 2]) << 8) |
-           static_cast<uint32_t>(data[pos + 3]);
+    size_t start = 0;
+    while (start + 1 < size &&
+           ((bytes[start] == 0x00 && (bytes[start + 1] & 0x80) == 0) ||
+            (bytes[start] == 0xff && (bytes[start + 1] & 0x80) != 0))) {
+        start++;
+    }
+    return start;
 }
 
-static inline bool msgpack_marker_is_string(uint8_t marker)
+/* Minimal big-endian two's complement of number; returns its length. */
+static size_t twos_complement_int64(int64_t number, uint8_t out[8])
 {
-    return (marker & 0xe0) == 0xa0 || marker == 0xd9 ||
-           marker == 0xda || marker == 0xdb;
+    for (int i = 0; i < 8; i++) {
+        out[i] = static_cast<uint8_t>(static_cast<uint64_t>(number) >> (56 - 8 * i));
+    }
+    const size_t start = twos_complement_trim(out, 8);
+    memmove(out, out + start, 8 - start);
+    return 8 - start;
 }
 
-static size_t msgpack_validate_value(std::span<const uint8_t> data, size_t pos)
+/* The mantissa as minimal big-endian two's complement, for any size. */
+static void decimal_mantissa_bytes(const DecimalValue& value, std::vector<uint8_t>* out)
 {
-    check_stack_depth();
-    msgpack_require_bytes(data, pos, 1);
-    const uint8_t marker = data[pos++];
-
-    if (marker <= 0x7f || marker >= 0xe0 || marker == 0xc0 ||
-        marker == 0xc2 || marker == 0xc3) {
-        return pos;
+    // Little-endian base 2^32, fed nine decimal digits at a time.
+    std::vector<uint32_t> limbs;
+    const std::string_view digits = value.digits;
+    size_t chunk = digits.size() % 9 == 0 ? 9 : digits.size() % 9;
+    for (size_t i = 0; i < digits.size(); i += chunk, chunk = 9) {
+        uint32_t part = 0;
+        uint32_t scale = 1;
+        for (size_t j = 0; j < chunk; j++) {
+            part = part * 10 + static_cast<uint32_t>(digits[i + j] - '0');
+            scale *= 10;
+        }
+        uint64_t carry = part;
+        for (uint32_t& limb : limbs) {
+            const uint64_t product = uint64_t{limb} * scale + carry;
+            limb = static_cast<uint32_t>(product);
+            carry = product >> 32;
+        }
+        if (carry != 0) {
+            limbs.push_back(static_cast<uint32_t>(carry));
+        }
     }
 
-    uint64_t count = 0;
-    if ((marker & 0xe0) == 0xa0) {
-        count = marker & 0x1f;
-        msgpack_require_bytes(data, pos, static_cast<size_t>(count));
-        return pos + static_cast<size_t>(count);
-    }
-    if ((marker & 0xf0) == 0x90) {
-        count = marker & 0x0f;
-        for (uint64_t i = 0; i < count; i++) {
-            pos = msgpack_validate_value(data, pos);
+    // A leading zero byte leaves room for the sign.
+    out->assign(4 * limbs.size() + 1, 0);
+    for (size_t i = 0; i < limbs.size(); i++) {
+        for (size_t b = 0; b < 4; b++) {
+            (*out)[out->size() - 1 - 4 * i - b] = static_cast<uint8_t>(limbs[i] >> (8 * b));
         }
-        return pos;
     }
-    if ((marker & 0xf0) == 0x80) {
-        count = marker & 0x0f;
-        std::unordered_set<std::string_view> keys;
-        for (uint64_t i = 0; i < count; i++) {
-            msgpack_require_bytes(data, pos, 1);
-            if (!msgpack_marker_is_string(data[pos])) {
-                throw z::DeserializationError("MessagePack map key is not a string");
-            }
-            const size_t key_start = pos;
-            pos = msgpack_validate_value(data, pos);
-            z::MsgPackDeserializer key_reader(
-                data.subspan(key_start, pos - key_start));
-            if (!keys.insert(key_reader.asStringView()).second) {
-                throw z::DeserializationError("duplicate MessagePack map key");
-            }
-            pos = msgpack_validate_value(data, pos);
+    if (value.negative) {
+        bool carry = true;
+        for (size_t i = out->size(); i-- > 0;) {
+            (*out)[i] = static_cast<uint8_t>(~(*out)[i] + (carry ? 1 : 0));
+            carry = carry && (*out)[i] == 0;
         }
-        return pos;
     }
+    out->erase(out->begin(), out->begin() + twos_complement_trim(out->data(), out->size()));
+}
 
-    size_t payload_size = 0;
-    switch (marker) {
-        case 0xc4:
-        case 0xd9:
-            msgpack_require_bytes(data, pos, 1);
-            payload_size = data[pos++];
-            break;
-        case 0xc5:
-        case 0xda:
-            payload_size = msgpack_read_u16(data, pos);
-            pos += 2;
-            break;
-        case 0xc6:
-        case 0xdb:
-            payload_size = msgpack_read_u32(data, pos);
-            pos += 4;
-            break;
-        case 0xca:
-        case 0xce:
-        case 0xd2:
-            payload_size = 4;
-            break;
-        case 0xcb:
-        case 0xcf:
-        case 0xd3:
-            payload_size = 8;
-            break;
-        case 0xcc:
-        case 0xd0:
-            payload_size = 1;
-            break;
-        case 0xcd:
-        case 0xd1:
-            payload_size = 2;
-            break;
-        case 0xdc:
-            count = msgpack_read_u16(data, pos);
-            pos += 2;
-            for (uint64_t i = 0; i < count; i++) {
-                pos = msgpack_validate_value(data, pos);
-            }
-            return pos;
-        case 0xdd:
-            count = msgpack_read_u32(data, pos);
-            pos += 4;
-            for (uint64_t i = 0; i < count; i++) {
-                pos = msgpack_validate_value(data, pos);
-            }
-            return pos;
-        case 0xde:
-        case 0xdf:
-            if (marker == 0xde) {
-                count = msgpack_read_u16(data, pos);
-                pos += 2;
-            } else {
-                count = msgpack_read_u32(data, pos);
-                pos += 4;
-            }
-            {
-                std::unordered_set<std::string_view> keys;
-                for (uint64_t i = 0; i < count; i++) {
-                    msgpack_require_bytes(data, pos, 1);
-                    if (!msgpack_marker_is_string(data[pos])) {
-                        throw z::DeserializationError("MessagePack map key is not a string");
-                    }
-                    const size_t key_start = pos;
-                    pos = msgpack_validate_value(data, pos);
-                    z::MsgPackDeserializer key_reader(
-                        data.subspan(key_start, pos - key_start));
-                    if (!keys.insert(key_reader.asStringView()).second) {
-                        throw z::DeserializationError("duplicate MessagePack map key");
-                    }
-                    pos = msgpack_validate_value(data, pos);
-                }
-            }
-            return pos;
-        default:
-            throw z::DeserializationError("unsupported or reserved MessagePack marker");
+/*
+ * Sets digits from a big-endian magnitude, plus one for CBOR's negative
+ * bignums and negated two's complement. Set the sign first.
+ */
+static void decimal_from_magnitude(const uint8_t* bytes, size_t size, bool plus_one,
+                                   DecimalValue* out)
+{
+    if (size > kDecimalMantissaMaxBytes) {
+        throw z::DeserializationError("decimal mantissa is too large");
+    }
+    std::vector<uint32_t> limbs(size / 4 + 2, 0);
+    for (size_t i = 0; i < size; i++) {
+        const size_t shift = size - 1 - i;
+        limbs[shift / 4] |= static_cast<uint32_t>(bytes[i]) << (8 * (shift % 4));
+    }
+    if (plus_one) {
+        for (uint32_t& limb : limbs) {
+            if (++limb != 0) break;
+        }
     }
+    size_t used = limbs.size();
+    while (used > 0 && limbs[used - 1] == 0) used--;
 
-    msgpack_require_bytes(data, pos, payload_size);
-    return pos + payload_size;
+    // Nine digits per division by 10^9, least significant first.
+    const size_t capacity = 10 * (used + 1);
+    char* end = out->reserve(capacity) + capacity;
+    char* p = end;
+    while (used > 0) {
+        uint64_t remainder = 0;
+        for (size_t i = used; i-- > 0;) {
+            const uint64_t current = (remainder << 32) | limbs[i];
+            limbs[i] = static_cast<uint32_t>(current / 1000000000);
+            remainder = current % 1000000000;
+        }
+        while (used > 0 && limbs[used - 1] == 0) used--;
+        for (int d = 0; d < 9; d++) {
+            *--p = static_cast<char>('0' + remainder % 10);
+            remainder /= 10;
+        }
+    }
+    decimal_set_digits(out, p, static_cast<size_t>(end - p));
 }
 
-static void append_json_string(std::string& out, std::string_view value)
+static void decimal_from_twos_complement(const uint8_t* bytes, size_t size, DecimalValue* out)
 {
-    if (value.find('\0') != std::string_view::npos) {
-        throw z::DeserializationError("decoded string contains NUL");
+    out->negative = (bytes[0] & 0x80) != 0;
+    if (size <= 8) {
+        uint64_t bits = out->negative ? ~uint64_t{0} : 0;
+        for (size_t i = 0; i < size; i++) {
+            bits = (bits << 8) | bytes[i];
+        }
+        const uint64_t magnitude = out->negative ? 0 - bits : bits;
+        char* p = out->reserve(20);
+        auto converted = std::to_chars(p, p + 20, magnitude);
+        decimal_set_digits(out, p, static_cast<size_t>(converted.ptr - p));
+        return;
     }
-    if (!pg_verify_mbstr(GetDatabaseEncoding(), value.data(), value.size(), true)) {
-        throw z::DeserializationError(
-            "decoded string is invalid in the database encoding");
+    if (!out->negative) {
+        decimal_from_magnitude(bytes, size, false, out);
+        return;
     }
-    static constexpr char hex[] = "0123456789abcdef";
-    out.push_back('"');
-    for (unsigned char ch : value) {
-        switch (ch) {
-            case '"': out += "\\\""; break;
-            case '\\': out += "\\\\"; break;
-            case '\b': out += "\\b"; break;
-            case '\f': out += "\\f"; break;
-            case '\n': out += "\\n"; break;
-            case '\r': out += "\\r"; break;
-            case '\t': out += "\\t"; break;
-            default:
-                if (ch < 0x20) {
-                    out += "\\u00";
-                    out.push_back(hex[ch >> 4]);
-                    out.push_back(hex[ch & 0x0f]);
-                } else {
-                    out.push_back(static_cast<char>(ch));
-                }
-        }
+    std::vector<uint8_t> inverted(bytes, bytes + size);
+    for (uint8_t& b : inverted) {
+        b = static_cast<uint8_t>(~b);
     }
-    out.push_back('"');
+    decimal_from_magnitude(inverted.data(), size, true, out);
 }
 
-template<typename Number>
-static void append_json_number(std::string& out, Number value)
+static int decimal_checked_exponent(int64_t exponent)
 {
-    std::array<char, 64> buffer;
-    std::to_chars_result converted;
-    if constexpr (std::is_floating_point_v<Number>) {
-        converted = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value,
-                                  std::chars_format::general,
-                                  std::numeric_limits<Number>::max_digits10);
-    } else {
-        converted = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
-    }
-    if (converted.ec != std::errc()) {
-        throw z::DeserializationError("failed to format decoded number");
+    if (exponent < PG_INT16_MIN || exponent > PG_INT16_MAX) {
+        throw z::DeserializationError("decimal exponent is out of range");
     }
-    out.append(buffer.data(), converted.ptr);
+    return static_cast<int>(exponent);
 }
 
-static void msgpack_reader_to_json(
-    const z::MsgPackDeserializer& value, std::string& out)
+/* Plain decimal text as numeric_out prints it, such as -12.30. */
+static void decimal_format_fixed(const DecimalValue& value, std::string* out)
 {
-    check_stack_depth();
-    if (value.isNull()) {
-        out += "null";
-    } else if (value.isBool()) {
-        out += value.asBool() ? "true" : "false";
-    } else if (value.isUInt()) {
-        append_json_number(out, value.asUInt64());
-    } else if (value.isInt()) {
-        append_json_number(out, value.asInt64());
-    } else if (value.isFloat()) {
-        const double number = value.asDouble();
-        if (std::isfinite(number)) {
-            append_json_number(out, number);
-        } else if (std::isnan(number)) {
-            append_json_string(out, "NaN");
-        } else {
-            append_json_string(out, number > 0 ? "Infinity" : "-Infinity");
-        }
-    } else if (value.isString()) {
-        append_json_string(out, value.asStringView());
-    } else if (value.isBlob()) {
-        out += "[\"~b\",";
-        append_json_string(out, z::base64Encode(value.asBlob()));
-        out += ",\"base64\"]";
-    } else if (value.isArray()) {
-        out.push_back('[');
-        const size_t count = value.arraySize();
-        for (size_t i = 0; i < count; i++) {
-            if (i > 0) out.push_back(',');
-            msgpack_reader_to_json(value[i], out);
-        }
-        out.push_back(']');
-    } else if (value.isMap()) {
-        out.push_back('{');
-        bool first = true;
-        for (std::string_view key : value.mapKeys()) {
-            if (!first) out.push_back(',');
-            first = false;
-            append_json_string(out, key);
-            out.push_back(':');
-            msgpack_reader_to_json(value[key], out);
-        }
-        out.push_back('}');
+    const std::string_view digits = value.digits;
+    out->clear();
+    if (value.negative) out->push_back('-');
+    if (value.exponent >= 0) {
+        out->append(digits);
+        if (digits != "0") out->append(static_cast<size_t>(value.exponent), '0');
+        return;
+    }
+    const size_t scale = static_cast<size_t>(-value.exponent);
+    if (digits.size() > scale) {
+        out->append(digits.substr(0, digits.size() - scale));
+        out->push_back('.');
+        out->append(digits.substr(digits.size() - scale));
     } else {
-        throw z::DeserializationError("unsupported MessagePack value");
+        out->append("0.");
+        out->append(scale - digits.size(), '0');
+        out->append(digits);
     }
 }
 
-static void flex_reference_to_json(
-    const ::flexbuffers::Reference& value, std::string& out)
+/* Writes a MessagePack ext header and type byte; returns the payload start. */
+static inline uint8_t* msgpack_write_ext_header(uint8_t* out, size_t len, uint8_t type)
 {
-    check_stack_depth();
-    if (value.IsNull()) {
-        out += "null";
-    } else if (value.IsBool()) {
-        out += value.AsBool() ? "true" : "false";
-    } else if (value.IsUInt()) {
-        append_json_number(out, value.AsUInt64());
-    } else if (value.IsInt()) {
-        append_json_number(out, value.AsInt64());
-    } else if (value.IsFloat()) {
-        const double number = value.AsDouble();
-        if (std::isfinite(number)) {
-            append_json_number(out, number);
-        } else if (std::isnan(number)) {
-            append_json_string(out, "NaN");
-        } else {
-            append_json_string(out, number > 0 ? "Infinity" : "-Infinity");
-        }
-    } else if (value.IsString()) {
-        auto string_value = value.AsString();
-        append_json_string(
-            out, std::string_view(string_value.c_str(), string_value.size()));
-    } else if (value.IsBlob()) {
-        auto blob = value.AsBlob();
-        auto bytes = std::span<const std::byte>(
-            reinterpret_cast<const std::byte*>(blob.data()), blob.size());
-        out += "[\"~b\",";
-        append_json_string(out, z::base64Encode(bytes));
-        out += ",\"base64\"]";
-    } else if (value.IsMap()) {
-        auto map = value.AsMap();
-        auto keys = map.Keys();
-        auto values = map.Values();
-        std::unordered_set<std::string_view> seen_keys;
-
-        out.push_back('{');
-        for (size_t i = 0; i < keys.size(); i++) {
-            if (i > 0) out.push_back(',');
-            auto key_value = keys[i].AsString();
-            std::string_view key(key_value.c_str(), key_value.size());
-            if (!seen_keys.insert(key).second) {
-                throw z::DeserializationError("duplicate FlexBuffer map key");
-            }
-            append_json_string(out, key);
-            out.push_back(':');
-            flex_reference_to_json(values[i], out);
-        }
-        out.push_back('}');
-    } else if (value.IsAnyVector()) {
-        auto append_vector = [&](const auto& vector) {
-            out.push_back('[');
-            for (size_t i = 0; i < vector.size(); i++) {
-                if (i > 0) out.push_back(',');
-                flex_reference_to_json(vector[i], out);
+    switch (len) {
+        case 1: *out++ = 0xd4; break;
+        case 2: *out++ = 0xd5; break;
+        case 4: *out++ = 0xd6; break;
+        case 8: *out++ = 0xd7; break;
+        case 16: *out++ = 0xd8; break;
+        default:
+            if (len <= 0xff) {
+                *out++ = 0xc7;
+                *out++ = static_cast<uint8_t>(len);
+            } else if (len <= 0xffff) {
+                *out++ = 0xc8;
+                *out++ = static_cast<uint8_t>(len >> 8);
+                *out++ = static_cast<uint8_t>(len);
+            } else {
+                *out++ = 0xc9;
+                for (int shift = 24; shift >= 0; shift -= 8) {
+                    *out++ = static_cast<uint8_t>(len >> shift);
+                }
             }
-            out.push_back(']');
-        };
-
-        if (value.IsTypedVector()) {
-            append_vector(value.AsTypedVector());
-        } else if (value.IsFixedTypedVector()) {
-            append_vector(value.AsFixedTypedVector());
-        } else {
-            append_vector(value.AsVector());
-        }
-    } else {
-        throw z::DeserializationError("unsupported FlexBuffer value");
+            break;
     }
+    *out++ = type;
+    return out;
 }
 
-struct CborHead {
-    uint8_t major;
-    uint8_t additional;
-    uint64_t value;
-    size_t next;
-    bool indefinite;
-};
-
-static inline void cbor_require_bytes(
-    std::span<const uint8_t> data, size_t pos, size_t count)
-{
-    if (pos > data.size() || count > data.size() - pos) {
-        throw z::DeserializationError("truncated CBOR value");
+/* A CBOR head: major type and argument, in its shortest form. */
+static inline size_t cbor_store_head(uint8_t* out, uint8_t major, uint64_t value)
+{
+    const uint8_t type = static_cast<uint8_t>(major << 5);
+    if (value < 24) {
+        out[0] = static_cast<uint8_t>(type | value);
+        return 1;
+    }
+    size_t width;
+    if (value <= 0xFFu) {
+        out[0] = type | 24;
+        width = 1;
+    } else if (value <= 0xFFFFu) {
+        out[0] = type | 25;
+        width = 2;
+    } else if (value <= 0xFFFFFFFFu) {
+        out[0] = type | 26;
+        width = 4;
+    } else {
+        out[0] = type | 27;
+        width = 8;
+    }
+    for (size_t i = 0; i < width; i++) {
+        out[1 + i] = static_cast<uint8_t>(value >> (8 * (width - 1 - i)));
     }
+    return 1 + width;
 }
 
-static CborHead cbor_read_head(std::span<const uint8_t> data, size_t pos)
-{
-    cbor_require_bytes(data, pos, 1);
-    const uint8_t initial = data[pos++];
-    CborHead head{static_cast<uint8_t>(initial >> 5),
-                  static_cast<uint8_t>(initial & 0x1f), 0, pos, false};
-
-    if (head.additional < 24) {
-        head.value = head.additional;
-        return head;
-    }
-    if (head.additional == 31) {
-        head.indefinite = true;
-        return head;
+/*
+ * The mantissa of a decimal fraction as an encoded CBOR integer, or as a
+ * tag 2/3 bignum once it no longer fits in 64 bits.
+ */
+static void cbor_decimal_mantissa(const DecimalValue& value, std::vector<uint8_t>* out)
+{
+    int64_t small;
+    uint8_t head[9];
+    if (decimal_mantissa_int64(value, &small)) {
+        const size_t len = small < 0 ? cbor_store_head(head, 1, ~static_cast<uint64_t>(small))
+                                     : cbor_store_head(head, 0, static_cast<uint64_t>(small));
+        out->assign(head, head + len);
+        return;
     }
-    if (head.additional >= 28) {
-        throw z::DeserializationError("reserved CBOR additional information");
+
+    // CBOR stores -1 - m for negatives, which is the complement of m's bytes.
+    std::vector<uint8_t> bytes;
+    decimal_mantissa_bytes(value, &bytes);
+    if (value.negative) {
+        for (uint8_t& b : bytes) b = static_cast<uint8_t>(~b);
     }
+    size_t start = 0;
+    while (start < bytes.size() && bytes[start] == 0) start++;
+    const size_t len = bytes.size() - start;
 
-    const size_t width = size_t{1} << (head.additional - 24);
-    cbor_require_bytes(data, pos, width);
-    for (size_t i = 0; i < width; i++) {
-        head.value = (head.value << 8) | data[pos + i];
+    if (len <= 8) {
+        uint64_t argument = 0;
+        for (size_t i = start; i < bytes.size(); i++) argument = (argument << 8) | bytes[i];
+        const size_t head_len = cbor_store_head(head, value.negative ? 1 : 0, argument);
+        out->assign(head, head + head_len);
+        return;
     }
-    head.next = pos + width;
-    return head;
+    out->clear();
+    out->reserve(10 + len);
+    out->push_back(value.negative ? 0xc3 : 0xc2);
+    const size_t head_len = cbor_store_head(head, 2, len);
+    out->insert(out->end(), head, head + head_len);
+    out->insert(out->end(), bytes.begin() + start, bytes.end());
 }
 
-static size_t cbor_parse_text(
-    std::span<const uint8_t> data, size_t pos, std::string* result)
+/* Writes a decimal in the writer's binary decimal form. */
+template <typename WriterT>
+static void write_decimal(WriterT& writer, const DecimalValue& value)
 {
-    CborHead head = cbor_read_head(data, pos);
-    if (head.major != 3) {
-        throw z::DeserializationError("CBOR map key is not a text string");
-    }
-
-    if (!head.indefinite) {
-        if (head.value > std::numeric_limits<size_t>::max()) {
-            throw z::DeserializationError("CBOR text string is too large");
-        }
-        const size_t length = static_cast<size_t>(head.value);
-        cbor_require_bytes(data, head.next, length);
-        result->assign(reinterpret_cast<const char*>(data.data() + head.next), length);
-        return head.next + length;
-    }
+    int64_t small;
+    const bool fits_int64 = decimal_mantissa_int64(value, &small);
 
-    result->clear();
-    pos = head.next;
-    for (;;) {
-        cbor_require_bytes(data, pos, 1);
-        if (data[pos] == 0xff) {
-            return pos + 1;
-        }
-        CborHead chunk = cbor_read_head(data, pos);
-        if (chunk.major != 3 || chunk.indefinite) {
-            throw z::DeserializationError("invalid CBOR text string chunk");
+    if constexpr (std::is_same_v<WriterT, z::MsgPackSerializer>) {
+        if (value.exponent < PG_INT16_MIN || value.exponent > PG_INT16_MAX) {
+            throw z::SerializationError("decimal exponent is out of range for MessagePack");
         }
-        if (chunk.value > std::numeric_limits<size_t>::max()) {
-            throw z::DeserializationError("CBOR text string chunk is too large");
+        uint8_t small_bytes[8];
+        std::vector<uint8_t> big_bytes;
+        const uint8_t* mantissa = small_bytes;
+        size_t mantissa_len;
+        if (fits_int64) {
+            mantissa_len = twos_complement_int64(small, small_bytes);
+        } else {
+            decimal_mantissa_bytes(value, &big_bytes);
+            mantissa = big_bytes.data();
+            mantissa_len = big_bytes.size();
+        }
+        const size_t len = 2 + mantissa_len;
+        uint8_t* begin = writer.reserve_raw_append(len + 6);
+        uint8_t* out = msgpack_write_ext_header(begin, len, kMsgpackDecimalExt);
+        const uint16_t exponent = static_cast<uint16_t>(static_cast<int16_t>(value.exponent));
+        *out++ = static_cast<uint8_t>(exponent >> 8);
+        *out++ = static_cast<uint8_t>(exponent);
+        memcpy(out, mantissa, mantissa_len);
+        out += mantissa_len;
+        writer.commit_raw_append(static_cast<size_t>(out - begin));
+    } else if constexpr (std::is_same_v<WriterT, z::cborjc::Serializer>) {
+        std::vector<uint8_t> mantissa;
+        cbor_decimal_mantissa(value, &mantissa);
+        writer.decimal_fraction(value.exponent, mantissa);
+    } else if constexpr (std::is_same_v<WriterT, JsonbDecodeWriter>) {
+        std::string text;
+        decimal_format_fixed(value, &text);
+        writer.numeric_text(text.c_str());
+    } else {
+        writer.begin_array(3);
+        writer.string("~d");
+        writer.int64(value.exponent);
+        if (fits_int64) {
+            writer.int64(small);
+        } else {
+            std::vector<uint8_t> bytes;
+            decimal_mantissa_bytes(value, &bytes);
+            writer.binary(std::as_bytes(std::span<const uint8_t>(bytes)));
         }
-        const size_t length = static_cast<size_t>(chunk.value);
-        cbor_require_bytes(data, chunk.next, length);
-        result->append(
-            reinterpret_cast<const char*>(data.data() + chunk.next), length);
-        pos = chunk.next + length;
+        writer.end_array();
     }
 }
 
-static size_t cbor_parse_bytes(
-    std::span<const uint8_t> data, size_t pos, std::vector<std::byte>* result)
+template <typename WriterT>
+static inline void numeric_write_fast(WriterT& writer, Datum value)
 {
-    CborHead head = cbor_read_head(data, pos);
-    if (head.major != 2) {
-        throw z::DeserializationError("CBOR value is not a byte string");
+    if (numeric_encoding == NUMERIC_ENCODING_BINARY_DECIMAL) {
+        DecimalValue decimal;
+        if (numeric_to_decimal(value, &decimal)) {
+            write_decimal(writer, decimal);
+        } else {
+            writer.double_(DatumGetFloat8(DirectFunctionCall1(numeric_float8, value)));
+        }
+        return;
+    }
+    if (numeric_encoding == NUMERIC_ENCODING_TAGGED_DECIMAL) {
+        char* text = DatumGetCString(DirectFunctionCall1(numeric_out, value));
+        writer.begin_array(3);
+        writer.string("~n");
+        writer.string(std::string_view(text));
+        writer.string("decimal");
+        writer.end_array();
+        pfree(text);
+        return;
     }
 
-    result->clear();
-    if (!head.indefinite) {
-        if (head.value > std::numeric_limits<size_t>::max()) {
-            throw z::DeserializationError("CBOR byte string is too large");
-        }
-        const size_t length = static_cast<size_t>(head.value);
-        cbor_require_bytes(data, head.next, length);
-        const auto* begin = reinterpret_cast<const std::byte*>(
-            data.data() + head.next);
-        result->assign(begin, begin + length);
-        return head.next + length;
+    NumericFastValue parsed = numeric_parse_fast(value);
+    if (parsed.is_int64) {
+        writer.int64(parsed.int64_value);
+    } else {
+        writer.double_(parsed.float8_value);
     }
+}
 
-    pos = head.next;
-    for (;;) {
-        cbor_require_bytes(data, pos, 1);
-        if (data[pos] == 0xff) {
-            return pos + 1;
-        }
-        CborHead chunk = cbor_read_head(data, pos);
-        if (chunk.major != 2 || chunk.indefinite) {
-            throw z::DeserializationError("invalid CBOR byte string chunk");
+static inline z::dyn::Value numeric_to_dynamic_fast(Datum value, int encoding)
+{
+    if (encoding == NUMERIC_ENCODING_BINARY_DECIMAL) {
+        // Dynamic values carry no protocol tags, so every protocol gets the array form.
+        DecimalValue decimal;
+        if (!numeric_to_decimal(value, &decimal)) {
+            return z::dyn::Value(DatumGetFloat8(DirectFunctionCall1(numeric_float8, value)));
         }
-        if (chunk.value > std::numeric_limits<size_t>::max()) {
-            throw z::DeserializationError("CBOR byte string chunk is too large");
+        z::dyn::Value::Array tagged;
+        tagged.reserve(3);
+        tagged.emplace_back("~d");
+        tagged.emplace_back(static_cast<int64_t>(decimal.exponent));
+        int64_t mantissa;
+        if (decimal_mantissa_int64(decimal, &mantissa)) {
+            tagged.emplace_back(mantissa);
+        } else {
+            std::vector<uint8_t> bytes;
+            decimal_mantissa_bytes(decimal, &bytes);
+            tagged.push_back(z::dyn::Value::blob(std::as_bytes(std::span<const uint8_t>(bytes))));
         }
-        const size_t length = static_cast<size_t>(chunk.value);
-        cbor_require_bytes(data, chunk.next, length);
-        const auto* begin = reinterpret_cast<const std::byte*>(
-            data.data() + chunk.next);
-        result->insert(result->end(), begin, begin + length);
-        pos = chunk.next + length;
+        return z::dyn::Value::array(std::move(tagged));
+    }
+    if (encoding == NUMERIC_ENCODING_TAGGED_DECIMAL) {
+        char* text = DatumGetCString(DirectFunctionCall1(numeric_out, value));
+        z::dyn::Value::Array tagged;
+        tagged.reserve(3);
+        tagged.emplace_back("~n");
+        tagged.emplace_back(std::string(text));
+        tagged.emplace_back("decimal");
+        pfree(text);
+        return z::dyn::Value::array(std::move(tagged));
+    }
+
+    NumericFastValue parsed = numeric_parse_fast(value);
+    if (parsed.is_int64) {
+        return z::dyn::Value(parsed.int64_value);
     }
+    return z::dyn::Value(parsed.float8_value);
 }
 
-static double cbor_decode_half(uint16_t bits)
+/*
+ * Native type encoding (pg_zerialize.type_encoding = native). uuid,
+ * timestamp, timestamptz, inet, cidr, and interval values are written in
+ * binary forms instead of canonical text and PostgreSQL-epoch microseconds:
+ *
+ *   uuid          its 16 bytes as binary, in every protocol
+ *   timestamp     MessagePack ext type -1 (timestamp 32, 64, or 96); CBOR
+ *                 tag 1 epoch seconds, an integer or a float64 carrying the
+ *                 microseconds; ZERA and Flex ["~t", seconds, nanoseconds]
+ *   inet, cidr    MessagePack ext type 5: the prefix length, then the 4 or
+ *                 16 address bytes; elsewhere ["~ip", prefix, address]
+ *   interval      MessagePack ext type 6: big-endian int32 months, int32
+ *                 days, and int64 microseconds; elsewhere ["~iv", months,
+ *                 days, microseconds]
+ *
+ * Seconds count from the Unix epoch, and timestamp without time zone is
+ * read as UTC. Infinite timestamps have no epoch form and are written as
+ * the strings "infinity" and "-infinity". As with binary decimals, the
+ * dynamic paths use the array forms for every protocol.
+ */
+static constexpr uint8_t kMsgpackTimestampExt = 0xff;
+static constexpr uint8_t kMsgpackNetworkExt = 5;
+static constexpr uint8_t kMsgpackIntervalExt = 6;
+static constexpr int64_t kUnixEpochSeconds =
+    int64_t{POSTGRES_EPOCH_JDATE - UNIX_EPOCH_JDATE} * SECS_PER_DAY;
+
+struct EpochTime {
+    int64_t seconds;
+    uint32_t nanoseconds;
+};
+
+static inline EpochTime timestamp_to_epoch(Timestamp ts)
 {
-    const bool negative = (bits & 0x8000) != 0;
-    const uint16_t exponent = (bits >> 10) & 0x1f;
-    const uint16_t fraction = bits & 0x03ff;
+    int64_t seconds = ts / USECS_PER_SEC;
+    int64_t micros = ts % USECS_PER_SEC;
+    if (micros < 0) {
+        seconds--;
+        micros += USECS_PER_SEC;
+    }
+    return EpochTime{seconds + kUnixEpochSeconds, static_cast<uint32_t>(micros * 1000)};
+}
 
-    if (exponent == 0) {
-        if (fraction == 0) return negative ? -0.0 : 0.0;
-        const double value = std::ldexp(static_cast<double>(fraction), -24);
-        return negative ? -value : value;
+/* Rounds to the microsecond; throws for instants timestamp cannot hold. */
+static Timestamp timestamp_from_epoch(int64_t seconds, uint32_t nanoseconds)
+{
+    if (nanoseconds >= 1000000000) {
+        throw z::DeserializationError("timestamp nanoseconds are out of range");
     }
-    if (exponent == 0x1f) {
-        if (fraction != 0) return std::numeric_limits<double>::quiet_NaN();
-        return negative ? -std::numeric_limits<double>::infinity()
-                        : std::numeric_limits<double>::infinity();
+    // Bounds the seconds first so the multiply below cannot overflow.
+    if (seconds < MIN_TIMESTAMP / USECS_PER_SEC - 1 + kUnixEpochSeconds ||
+        seconds > END_TIMESTAMP / USECS_PER_SEC + kUnixEpochSeconds) {
+        throw z::DeserializationError("timestamp out of range");
     }
-
-    const double mantissa = 1.0 + static_cast<double>(fraction) / 1024.0;
-    const double value = std::ldexp(mantissa, static_cast<int>(exponent) - 15);
-    return negative ? -value : value;
+    const Timestamp ts = (seconds - kUnixEpochSeconds) * USECS_PER_SEC + (nanoseconds + 500) / 1000;
+    if (!IS_VALID_TIMESTAMP(ts)) {
+        throw z::DeserializationError("timestamp out of range");
+    }
+    return ts;
 }
 
-static void append_cbor_float(std::string& out, double number)
+/* ISO 8601 in UTC, the text form of a decoded native timestamp. */
+static std::string_view timestamp_iso_text(Timestamp ts, char (&out)[MAXDATELEN + 1])
 {
-    if (std::isfinite(number)) {
-        append_json_number(out, number);
-    } else if (std::isnan(number)) {
-        append_json_string(out, "NaN");
-    } else {
-        append_json_string(out, number > 0 ? "Infinity" : "-Infinity");
+    struct pg_tm tm;
+    fsec_t fsec;
+    if (timestamp2tm(ts, nullptr, &tm, &fsec, nullptr, nullptr) != 0) {
+        throw z::DeserializationError("timestamp out of range");
     }
+    EncodeDateTime(&tm, fsec, true, 0, nullptr, USE_XSD_DATES, out);
+    return std::string_view(out, strlen(out));
 }
 
-static size_t cbor_value_to_json(
-    std::span<const uint8_t> data, size_t pos, std::string& out)
+struct NetworkValue {
+    uint8_t bits;
+    /* 4 for IPv4, 16 for IPv6. */
+    uint8_t size;
+    uint8_t address[16];
+};
+
+static inline NetworkValue network_from_datum(Datum value)
 {
-    check_stack_depth();
-    CborHead head = cbor_read_head(data, pos);
+    inet* src = DatumGetInetPP(value);
+    NetworkValue out;
+    out.bits = static_cast<uint8_t>(ip_bits(src));
+    out.size = static_cast<uint8_t>(ip_addrsize(src));
+    memcpy(out.address, ip_addr(src), out.size);
+    return out;
+}
 
-    if (head.major <= 1 && head.indefinite) {
-        throw z::DeserializationError("indefinite CBOR integer");
+static constexpr size_t kNetworkTextCapacity =
+    sizeof("xxxx:xxxx:xxxx:xxxx:xxxx:xxxx:255.255.255.255/128");
+
+static std::string_view network_format_text(
+    const NetworkValue& network, bool is_cidr, char (&out)[kNetworkTextCapacity])
+{
+    const int family = network.size == 4 ? PGSQL_AF_INET : PGSQL_AF_INET6;
+    if (pg_inet_net_ntop(family, network.address, network.bits, out, sizeof(out)) == nullptr) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                 errmsg("could not format inet value")));
     }
 
-    switch (head.major) {
-        case 0:
-            append_json_number(out, head.value);
-            return head.next;
-        case 1:
-            if (head.value <= static_cast<uint64_t>(INT64_MAX)) {
-                const int64_t value = -1 - static_cast<int64_t>(head.value);
-                append_json_number(out, value);
-            } else if (head.value == UINT64_MAX) {
-                out += "-18446744073709551616";
-            } else {
-                out.push_back('-');
-                append_json_number(out, head.value + 1);
-            }
-            return head.next;
-        case 2:
-        {
-            std::vector<std::byte> bytes;
-            const size_t next = cbor_parse_bytes(data, pos, &bytes);
-            out += "[\"~b\",";
-            append_json_string(out, z::base64Encode(bytes));
-            out += ",\"base64\"]";
-            return next;
-        }
-        case 3:
-        {
-            std::string text_value;
-            const size_t next = cbor_parse_text(data, pos, &text_value);
-            append_json_string(out, text_value);
-            return next;
-        }
-        case 4:
-        {
-            out.push_back('[');
-            size_t cursor = head.next;
-            uint64_t index = 0;
-            if (head.indefinite) {
-                while (true) {
-                    cbor_require_bytes(data, cursor, 1);
-                    if (data[cursor] == 0xff) {
-                        cursor++;
-                        break;
-                    }
-                    if (index++ > 0) out.push_back(',');
-                    cursor = cbor_value_to_json(data, cursor, out);
-                }
-            } else {
-                for (; index < head.value; index++) {
-                    if (index > 0) out.push_back(',');
-                    cursor = cbor_value_to_json(data, cursor, out);
-                }
-            }
-            out.push_back(']');
-            return cursor;
+    size_t len = strlen(out);
+    if (is_cidr && strchr(out, '/') == nullptr) {
+        int written = snprintf(out + len, sizeof(out) - len, "/%u", network.bits);
+        if (written < 0 || static_cast<size_t>(written) >= sizeof(out) - len) {
+            ereport(ERROR,
+                    (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+                     errmsg("formatted cidr value exceeds buffer")));
         }
-        case 5:
-        {
-            out.push_back('{');
-            size_t cursor = head.next;
-            uint64_t index = 0;
-            std::unordered_set<std::string> keys;
-            auto append_entry = [&]() {
-                std::string key;
-                cursor = cbor_parse_text(data, cursor, &key);
-                if (!keys.insert(key).second) {
-                    throw z::DeserializationError("duplicate CBOR map key");
-                }
-                if (index++ > 0) out.push_back(',');
-                append_json_string(out, key);
-                out.push_back(':');
-                cursor = cbor_value_to_json(data, cursor, out);
-            };
+        len += static_cast<size_t>(written);
+    }
+    return std::string_view(out, len);
+}
 
-            if (head.indefinite) {
-                while (true) {
-                    cbor_require_bytes(data, cursor, 1);
-                    if (data[cursor] == 0xff) {
-                        cursor++;
-                        break;
-                    }
-                    append_entry();
-                }
-            } else {
-                while (index < head.value) append_entry();
-            }
-            out.push_back('}');
-            return cursor;
+static std::string_view interval_format_text(const Interval& span, char (&out)[MAXDATELEN + 1])
+{
+#if PG_VERSION_NUM >= 170000
+    if (INTERVAL_IS_NOBEGIN(&span)) {
+        return std::string_view(EARLY, sizeof(EARLY) - 1);
+    }
+    if (INTERVAL_IS_NOEND(&span)) {
+        return std::string_view(LATE, sizeof(LATE) - 1);
+    }
+#endif
+
+    struct pg_itm itm;
+    interval2itm(span, &itm);
+    EncodeInterval(&itm, IntervalStyle, out);
+    return std::string_view(out, strlen(out));
+}
+
+static inline uint8_t* store_be(uint8_t* out, uint64_t value, int width)
+{
+    for (int shift = 8 * (width - 1); shift >= 0; shift -= 8) {
+        *out++ = static_cast<uint8_t>(value >> shift);
+    }
+    return out;
+}
+
+static inline uint64_t load_be(const uint8_t* p, int width)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < width; i++) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+/* Writes a finite or infinite timestamp in the writer's native form. */
+template <typename WriterT>
+static void write_native_timestamp(WriterT& writer, Timestamp ts)
+{
+    if (TIMESTAMP_NOT_FINITE(ts)) {
+        writer.string(TIMESTAMP_IS_NOBEGIN(ts) ? "-infinity" : "infinity");
+        return;
+    }
+    const EpochTime epoch = timestamp_to_epoch(ts);
+
+    if constexpr (std::is_same_v<WriterT, z::MsgPackSerializer>) {
+        uint8_t* begin = writer.reserve_raw_append(15);
+        uint8_t* out;
+        if (epoch.nanoseconds == 0 && epoch.seconds >= 0 &&
+            epoch.seconds <= static_cast<int64_t>(UINT32_MAX)) {
+            out = msgpack_write_ext_header(begin, 4, kMsgpackTimestampExt);
+            out = store_be(out, static_cast<uint64_t>(epoch.seconds), 4);
+        } else if (epoch.seconds >= 0 && epoch.seconds < (int64_t{1} << 34)) {
+            out = msgpack_write_ext_header(begin, 8, kMsgpackTimestampExt);
+            out = store_be(out, (uint64_t{epoch.nanoseconds} << 34) |
+                                    static_cast<uint64_t>(epoch.seconds), 8);
+        } else {
+            out = msgpack_write_ext_header(begin, 12, kMsgpackTimestampExt);
+            out = store_be(out, epoch.nanoseconds, 4);
+            out = store_be(out, static_cast<uint64_t>(epoch.seconds), 8);
+        }
+        writer.commit_raw_append(static_cast<size_t>(out - begin));
+    } else if constexpr (std::is_same_v<WriterT, z::cborjc::Serializer>) {
+        if (epoch.nanoseconds == 0) {
+            writer.epoch_time(epoch.seconds);
+        } else {
+            writer.epoch_time(static_cast<double>(epoch.seconds) + epoch.nanoseconds / 1e9);
         }
-        case 6:
-            throw z::DeserializationError("CBOR semantic tags are not supported");
-        case 7:
-            if (head.indefinite) {
-                throw z::DeserializationError("unexpected CBOR break marker");
-            }
-            if (head.additional == 20 || head.additional == 21) {
-                out += head.additional == 21 ? "true" : "false";
-                return head.next;
-            }
-            if (head.additional == 22) {
-                out += "null";
-                return head.next;
-            }
-            if (head.additional == 25) {
-                append_cbor_float(out, cbor_decode_half(static_cast<uint16_t>(head.value)));
-                return head.next;
-            }
-            if (head.additional == 26) {
-                append_cbor_float(out, std::bit_cast<float>(static_cast<uint32_t>(head.value)));
-                return head.next;
-            }
-            if (head.additional == 27) {
-                append_cbor_float(out, std::bit_cast<double>(head.value));
-                return head.next;
-            }
-            throw z::DeserializationError("unsupported CBOR simple value");
-        default:
-            pg_unreachable();
+    } else if constexpr (std::is_same_v<WriterT, JsonbDecodeWriter>) {
+        char out[MAXDATELEN + 1];
+        writer.string(writer.retain(timestamp_iso_text(ts, out)));
+    } else {
+        writer.begin_array(3);
+        writer.string("~t");
+        writer.int64(epoch.seconds);
+        writer.int64(epoch.nanoseconds);
+        writer.end_array();
     }
 }
 
-struct ZeraDecodeContext {
-    std::span<const uint8_t> envelope;
-    std::span<const uint8_t> arena;
-    std::unordered_set<uint32_t> active_refs;
-};
+template <typename WriterT>
+static void write_native_network(WriterT& writer, const NetworkValue& network, bool is_cidr)
+{
+    if constexpr (std::is_same_v<WriterT, z::MsgPackSerializer>) {
+        const size_t len = 1 + network.size;
+        uint8_t* begin = writer.reserve_raw_append(len + 3);
+        uint8_t* out = msgpack_write_ext_header(begin, len, kMsgpackNetworkExt);
+        *out++ = network.bits;
+        memcpy(out, network.address, network.size);
+        out += network.size;
+        writer.commit_raw_append(static_cast<size_t>(out - begin));
+    } else if constexpr (std::is_same_v<WriterT, JsonbDecodeWriter>) {
+        char out[kNetworkTextCapacity];
+        writer.string(writer.retain(network_format_text(network, is_cidr, out)));
+    } else {
+        writer.begin_array(3);
+        writer.string("~ip");
+        writer.int64(network.bits);
+        writer.binary(std::as_bytes(std::span<const uint8_t>(network.address, network.size)));
+        writer.end_array();
+    }
+}
 
-static inline void zera_require_span(
-    std::span<const uint8_t> data, size_t offset, size_t length,
-    const char* message)
+template <typename WriterT>
+static void write_native_interval(WriterT& writer, const Interval& span)
+{
+    if constexpr (std::is_same_v<WriterT, z::MsgPackSerializer>) {
+        uint8_t* begin = writer.reserve_raw_append(18);
+        uint8_t* out = msgpack_write_ext_header(begin, 16, kMsgpackIntervalExt);
+        out = store_be(out, static_cast<uint32_t>(span.month), 4);
+        out = store_be(out, static_cast<uint32_t>(span.day), 4);
+        out = store_be(out, static_cast<uint64_t>(span.time), 8);
+        writer.commit_raw_append(static_cast<size_t>(out - begin));
+    } else if constexpr (std::is_same_v<WriterT, JsonbDecodeWriter>) {
+        char out[MAXDATELEN + 1];
+        writer.string(writer.retain(interval_format_text(span, out)));
+    } else {
+        writer.begin_array(4);
+        writer.string("~iv");
+        writer.int64(span.month);
+        writer.int64(span.day);
+        writer.int64(span.time);
+        writer.end_array();
+    }
+}
+
+static z::dyn::Value native_timestamp_to_dynamic(Timestamp ts)
 {
-    if (offset > data.size() || length > data.size() - offset) {
-        throw z::DeserializationError(message);
+    if (TIMESTAMP_NOT_FINITE(ts)) {
+        return z::dyn::Value(std::string(TIMESTAMP_IS_NOBEGIN(ts) ? "-infinity" : "infinity"));
     }
+    const EpochTime epoch = timestamp_to_epoch(ts);
+    z::dyn::Value::Array tagged;
+    tagged.reserve(3);
+    tagged.emplace_back("~t");
+    tagged.emplace_back(epoch.seconds);
+    tagged.emplace_back(static_cast<int64_t>(epoch.nanoseconds));
+    return z::dyn::Value::array(std::move(tagged));
 }
 
-static size_t zera_value_to_json(
-    ZeraDecodeContext& context, uint32_t ref_offset, std::string& out,
-    size_t depth)
+static z::dyn::Value native_network_to_dynamic(const NetworkValue& network)
 {
-    if (depth > 64) {
-        throw z::DeserializationError("ZERA nesting depth exceeds 64");
+    z::dyn::Value::Array tagged;
+    tagged.reserve(3);
+    tagged.emplace_back("~ip");
+    tagged.emplace_back(static_cast<int64_t>(network.bits));
+    tagged.push_back(z::dyn::Value::blob(
+        std::as_bytes(std::span<const uint8_t>(network.address, network.size))));
+    return z::dyn::Value::array(std::move(tagged));
+}
+
+static z::dyn::Value native_interval_to_dynamic(const Interval& span)
+{
+    z::dyn::Value::Array tagged;
+    tagged.reserve(4);
+    tagged.emplace_back("~iv");
+    tagged.emplace_back(static_cast<int64_t>(span.month));
+    tagged.emplace_back(static_cast<int64_t>(span.day));
+    tagged.emplace_back(static_cast<int64_t>(span.time));
+    return z::dyn::Value::array(std::move(tagged));
+}
+
+/*
+ * Typed-array encoding (pg_zerialize.array_encoding = typed). A no-null,
+ * one-dimensional int2, int4, int8, float4, or float8 array is written as
+ * its packed little-endian element bytes in each protocol's own typed form:
+ *
+ *   CBOR          RFC 8746 tag over a byte string: 77-79 for sint16/32/64le,
+ *                 85-86 for float32/64le
+ *   MessagePack   ext type carrying the same number as the CBOR tag
+ *   ZERA          rank-1 TypedArray with the matching DType
+ *   FlexBuffers   typed vector
+ *
+ * Arrays with NULLs, more than one dimension, or other element types keep
+ * the generic per-element form. Writers without a typed form, such as the
+ * jsonb decode writer, receive the elements one by one.
+ */
+struct TypedArrayFormat {
+    ConverterKind kind;
+    uint8_t tag;
+    uint8_t width;
+    bool is_float;
+    z::zera::DType zera_dtype;
+};
+
+static constexpr TypedArrayFormat typed_array_formats[] = {
+    {ConverterKind::Int2, 77, 2, false, z::zera::DType::I16},
+    {ConverterKind::Int4, 78, 4, false, z::zera::DType::I32},
+    {ConverterKind::Int8, 79, 8, false, z::zera::DType::I64},
+    {ConverterKind::Float4, 85, 4, true, z::zera::DType::F32},
+    {ConverterKind::Float8, 86, 8, true, z::zera::DType::F64},
+};
+
+static inline const TypedArrayFormat* typed_array_format(ConverterKind kind)
+{
+    for (const TypedArrayFormat& fmt : typed_array_formats) {
+        if (fmt.kind == kind) return &fmt;
     }
-    zera_require_span(
-        context.envelope, ref_offset, 16, "ZERA ValueRef is out of bounds");
-    if (!context.active_refs.insert(ref_offset).second) {
-        throw z::DeserializationError("cyclic ZERA envelope reference");
+    return nullptr;
+}
+
+/* Looks up a MessagePack ext type or CBOR tag written by this extension. */
+static inline const TypedArrayFormat* typed_array_format_for_tag(uint64_t tag)
+{
+    for (const TypedArrayFormat& fmt : typed_array_formats) {
+        if (fmt.tag == tag) return &fmt;
     }
+    return nullptr;
+}
 
-    const uint8_t* ref = context.envelope.data() + ref_offset;
-    const auto tag = static_cast<z::zera::Tag>(ref[0]);
-    const uint8_t flags = ref[1];
-    const uint16_t aux = z::zera::read_u16_le(ref + 2);
-    const uint32_t a = z::zera::read_u32_le(ref + 4);
-    const uint32_t b = z::zera::read_u32_le(ref + 8);
-    const uint32_t c = z::zera::read_u32_le(ref + 12);
+static inline uint64_t typed_array_load_bits(const uint8_t* p, int width)
+{
+    uint64_t bits = 0;
+    for (int b = width - 1; b >= 0; b--) {
+        bits = (bits << 8) | p[b];
+    }
+    return bits;
+}
 
-    auto require_no_flags = [&]() {
-        if (flags != 0) {
-            throw z::DeserializationError("non-string ZERA value has flags");
-        }
-    };
+template <typename T>
+static inline T typed_array_load(const uint8_t* p)
+{
+    using Bits = std::conditional_t<sizeof(T) == 2, uint16_t,
+                 std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>;
+    return std::bit_cast<T>(static_cast<Bits>(typed_array_load_bits(p, sizeof(T))));
+}
 
-    switch (tag) {
-        case z::zera::Tag::Null:
-            require_no_flags();
-            out += "null";
+template <typename WriterT>
+static inline void typed_array_write_element(
+    WriterT& writer, const TypedArrayFormat& fmt, const uint8_t* p)
+{
+    switch (fmt.kind) {
+        case ConverterKind::Int2:
+            writer.int64(typed_array_load<int16_t>(p));
             break;
-        case z::zera::Tag::Bool:
-            require_no_flags();
-            if (aux > 1) throw z::DeserializationError("invalid ZERA boolean");
-            out += aux == 1 ? "true" : "false";
+        case ConverterKind::Int4:
+            writer.int64(typed_array_load<int32_t>(p));
             break;
-        case z::zera::Tag::I64:
-        {
-            require_no_flags();
-            const uint64_t bits = static_cast<uint64_t>(a) |
-                                  (static_cast<uint64_t>(b) << 32);
-            append_json_number(out, static_cast<int64_t>(bits));
+        case ConverterKind::Int8:
+            writer.int64(typed_array_load<int64_t>(p));
             break;
-        }
-        case z::zera::Tag::U64:
-        {
-            require_no_flags();
-            const uint64_t value = static_cast<uint64_t>(a) |
-                                   (static_cast<uint64_t>(b) << 32);
-            append_json_number(out, value);
+        case ConverterKind::Float4:
+            writer.double_(static_cast<double>(typed_array_load<float>(p)));
             break;
-        }
-        case z::zera::Tag::F64:
-        {
-            require_no_flags();
-            const uint64_t bits = static_cast<uint64_t>(a) |
-                                  (static_cast<uint64_t>(b) << 32);
-            append_cbor_float(out, std::bit_cast<double>(bits));
+        default:
+            writer.double_(typed_array_load<double>(p));
             break;
+    }
+}
+
+template <typename T>
+static void flex_write_typed_vector(z::flex::Serializer& writer, const uint8_t* le_bytes, size_t nitems)
+{
+    if constexpr (std::endian::native == std::endian::little) {
+        if (reinterpret_cast<uintptr_t>(le_bytes) % alignof(T) == 0) {
+            writer.typed_vector(reinterpret_cast<const T*>(le_bytes), nitems);
+            return;
         }
-        case z::zera::Tag::String:
-        {
-            if ((flags & ~uint8_t{1}) != 0) {
-                throw z::DeserializationError("unknown ZERA string flags");
-            }
-            std::string_view value;
-            if ((flags & 1) != 0) {
-                if (aux > z::zera::InlineMax) {
-                    throw z::DeserializationError("ZERA inline string is too long");
-                }
-                value = std::string_view(
-                    reinterpret_cast<const char*>(ref + 4), aux);
-            } else {
-                zera_require_span(
-                    context.arena, a, b, "ZERA string arena span is out of bounds");
-                value = std::string_view(
-                    reinterpret_cast<const char*>(context.arena.data() + a), b);
-            }
-            append_json_string(out, value);
-            break;
+    }
+    T* values = static_cast<T*>(palloc(sizeof(T) * nitems + 1));
+    for (size_t i = 0; i < nitems; i++) {
+        values[i] = typed_array_load<T>(le_bytes + sizeof(T) * i);
+    }
+    writer.typed_vector(values, nitems);
+    pfree(values);
+}
+
+/* Writes nitems packed little-endian elements in the writer's typed form. */
+template <typename WriterT>
+static void write_typed_array(
+    WriterT& writer, const TypedArrayFormat& fmt, const uint8_t* le_bytes, size_t nitems)
+{
+    const size_t len = nitems * fmt.width;
+    auto bytes = std::span<const std::byte>(reinterpret_cast<const std::byte*>(le_bytes), len);
+
+    if constexpr (std::is_same_v<WriterT, z::MsgPackSerializer>) {
+        if (len > std::numeric_limits<uint32_t>::max()) {
+            throw z::SerializationError("typed array is too large for MessagePack");
+        }
+        uint8_t* begin = writer.reserve_raw_append(len + 6);
+        uint8_t* out = msgpack_write_ext_header(begin, len, fmt.tag);
+        if (len > 0) {
+            memcpy(out, le_bytes, len);
+            out += len;
+        }
+        writer.commit_raw_append(static_cast<size_t>(out - begin));
+    } else if constexpr (std::is_same_v<WriterT, z::cborjc::Serializer>) {
+        writer.tagged_binary(fmt.tag, bytes);
+    } else if constexpr (std::is_same_v<WriterT, z::zera::Serializer>) {
+        writer.typed_array(fmt.zera_dtype, bytes, nitems);
+    } else if constexpr (std::is_same_v<WriterT, z::flex::Serializer>) {
+        switch (fmt.kind) {
+            case ConverterKind::Int2: flex_write_typed_vector<int16_t>(writer, le_bytes, nitems); break;
+            case ConverterKind::Int4: flex_write_typed_vector<int32_t>(writer, le_bytes, nitems); break;
+            case ConverterKind::Int8: flex_write_typed_vector<int64_t>(writer, le_bytes, nitems); break;
+            case ConverterKind::Float4: flex_write_typed_vector<float>(writer, le_bytes, nitems); break;
+            default: flex_write_typed_vector<double>(writer, le_bytes, nitems); break;
         }
-        case z::zera::Tag::Array:
-        {
-            require_no_flags();
-            zera_require_span(
-                context.envelope, a, 4, "ZERA array payload is out of bounds");
-            const uint32_t count = z::zera::read_u32_le(context.envelope.data() + a);
-            const size_t values_offset = static_cast<size_t>(a) + 4;
-            if (static_cast<size_t>(count) >
-                (context.envelope.size() - values_offset) / 16) {
-                throw z::DeserializationError("ZERA array values are out of bounds");
-            }
-            out.push_back('[');
-            for (uint32_t i = 0; i < count; i++) {
-                if (i > 0) out.push_back(',');
-                zera_value_to_json(
-                    context,
-                    static_cast<uint32_t>(values_offset + 16 * static_cast<size_t>(i)),
-                    out, depth + 1);
+    } else {
+        writer.begin_array(nitems);
+        for (size_t i = 0; i < nitems; i++) {
+            typed_array_write_element(writer, fmt, le_bytes + fmt.width * i);
+        }
+        writer.end_array();
+    }
+}
+
+/*
+ * Writes a one-dimensional array in the typed form when it is enabled and
+ * applies; returns false to let the caller take the generic path.
+ */
+template <typename WriterT>
+static inline bool write_typed_array_if_enabled(
+    WriterT& writer, ConverterKind elem_kind, ArrayType* arr)
+{
+    if (array_encoding != ARRAY_ENCODING_TYPED || ARR_HASNULL(arr)) return false;
+    const TypedArrayFormat* fmt = typed_array_format(elem_kind);
+    if (fmt == nullptr) return false;
+
+    const size_t nitems = static_cast<size_t>(ArrayGetNItems(ARR_NDIM(arr), ARR_DIMS(arr)));
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(ARR_DATA_PTR(arr));
+    if constexpr (std::endian::native == std::endian::little) {
+        write_typed_array(writer, *fmt, data, nitems);
+    } else {
+        const size_t len = nitems * fmt->width;
+        uint8_t* le_bytes = static_cast<uint8_t*>(palloc(len + 1));
+        for (size_t i = 0; i < len; i += fmt->width) {
+            for (size_t b = 0; b < fmt->width; b++) {
+                le_bytes[i + b] = data[i + fmt->width - 1 - b];
             }
-            out.push_back(']');
-            break;
         }
-        case z::zera::Tag::Object:
-        {
-            require_no_flags();
-            zera_require_span(
-                context.envelope, a, 4, "ZERA object payload is out of bounds");
-            const uint32_t count = z::zera::read_u32_le(context.envelope.data() + a);
-            size_t cursor = static_cast<size_t>(a) + 4;
-            std::unordered_set<std::string> keys;
-            out.push_back('{');
-            for (uint32_t i = 0; i < count; i++) {
-                zera_require_span(
-                    context.envelope, cursor, 4, "ZERA object entry is truncated");
-                const uint8_t* entry = context.envelope.data() + cursor;
-                const uint16_t key_length = z::zera::read_u16_le(entry);
-                const uint16_t reserved = z::zera::read_u16_le(entry + 2);
-                if (reserved != 0) {
-                    throw z::DeserializationError("ZERA object reserved field is nonzero");
-                }
-                cursor += 4;
-                zera_require_span(
-                    context.envelope, cursor, static_cast<size_t>(key_length) + 16,
-                    "ZERA object key/value is truncated");
-                std::string key(
-                    reinterpret_cast<const char*>(context.envelope.data() + cursor),
-                    key_length);
-                if (!keys.insert(key).second) {
-                    throw z::DeserializationError("duplicate ZERA object key");
-                }
-                if (i > 0) out.push_back(',');
-                append_json_string(out, key);
-                out.push_back(':');
-                cursor += key_length;
-                zera_value_to_json(
-                    context, static_cast<uint32_t>(cursor), out, depth + 1);
-                cursor += 16;
-            }
-            out.push_back('}');
-            break;
-        }
-        case z::zera::Tag::TypedArray:
-        {
-            require_no_flags();
-            if (aux != static_cast<uint16_t>(z::zera::DType::U8)) {
-                throw z::DeserializationError(
-                    "non-U8 ZERA typed arrays are not supported");
-            }
-            zera_require_span(
-                context.arena, a, b, "ZERA blob arena span is out of bounds");
-            zera_require_span(
-                context.envelope, c, 12, "ZERA blob shape is out of bounds");
-            const uint8_t* shape = context.envelope.data() + c;
-            if (z::zera::read_u32_le(shape) != 1 ||
-                z::zera::read_u64_le(shape + 4) != b) {
-                throw z::DeserializationError("invalid ZERA blob shape");
-            }
-            auto bytes = std::span<const std::byte>(
-                reinterpret_cast<const std::byte*>(context.arena.data() + a), b);
-            out += "[\"~b\",";
-            append_json_string(out, z::base64Encode(bytes));
-            out += ",\"base64\"]";
-            break;
-        }
-        default:
-            throw z::DeserializationError("unknown ZERA value tag");
+        write_typed_array(writer, *fmt, le_bytes, nitems);
+        pfree(le_bytes);
     }
+    return true;
+}
 
-    context.active_refs.erase(ref_offset);
-    return ref_offset + 16;
+static z::dyn::Value jsonb_token_to_dynamic(
+    JsonbIterator** it, JsonbIteratorToken tok, JsonbValue* v, int encoding);
+
+static z::dyn::Value jsonb_scalar_to_dynamic(const JsonbValue& v, int encoding)
+{
+    switch (v.type) {
+        case jbvNull:
+            return z::dyn::Value();
+        case jbvBool:
+            return z::dyn::Value(v.val.boolean);
+        case jbvNumeric:
+            return numeric_to_dynamic_fast(NumericGetDatum(v.val.numeric), encoding);
+        case jbvString:
+            return z::dyn::Value(std::string(v.val.string.val, v.val.string.len));
+        default:
+            ereport(ERROR,
+                    (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                     errmsg("unsupported jsonb scalar type for msgpack conversion")));
+    }
 }
 
-static z::dyn::Value jsonb_to_dynamic(Jsonb* jb)
+static z::dyn::Value jsonb_token_to_dynamic(
+    JsonbIterator** it, JsonbIteratorToken tok, JsonbValue* v, int encoding)
 {
-    JsonbIterator* it = JsonbIteratorInit(&jb->root);
-    JsonbValue v;
+    if (tok == WJB_BEGIN_OBJECT) {
+        z::dyn::Value::Map map_entries;
+        JsonbIteratorToken t = JsonbIteratorNext(it, v, false);
+        while (t != WJB_END_OBJECT) {
+            if (t != WJB_KEY) {
+                ereport(ERROR,
+                        (errcode(ERRCODE_DATA_CORRUPTED),
+                         errmsg("invalid jsonb object token sequence")));
+            }
+            std::string key(v->val.string.val, v->val.string.len);
+            t = JsonbIteratorNext(it, v, false);
+            map_entries.emplace_back(std::move(key), jsonb_token_to_dynamic(it, t, v, encoding));
+            t = JsonbIteratorNext(it, v, false);
+        }
+        return z::dyn::Value::map(std::move(map_entries));
+    }
 
-    if (JB_ROOT_IS_SCALAR(jb)) {
-        JsonbIteratorToken tok = JsonbIteratorNext(&it, &v, false); /* begin pseudo-array */
-        if (tok != WJB_BEGIN_ARRAY) {
-            ereport(ERROR,
-                    (errcode(ERRCODE_DATA_CORRUPTED),
-                     errmsg("invalid scalar jsonb root")));
+    if (tok == WJB_BEGIN_ARRAY) {
+        z::dyn::Value::Array arr;
+        JsonbIteratorToken t = JsonbIteratorNext(it, v, false);
+        while (t != WJB_END_ARRAY) {
+            arr.push_back(jsonb_token_to_dynamic(it, t, v, encoding));
+            t = JsonbIteratorNext(it, v, false);
         }
-        tok = JsonbIteratorNext(&it, &v, false); /* scalar elem */
-        z::dyn::Value out = jsonb_token_to_dynamic(&it, tok, &v);
-        (void) JsonbIteratorNext(&it, &v, false); /* end pseudo-array */
-        return out;
+        return z::dyn::Value::array(std::move(arr));
     }
 
-    JsonbIteratorToken tok = JsonbIteratorNext(&it, &v, false);
-    return jsonb_token_to_dynamic(&it, tok, &v);
-}
+    if (tok == WJB_VALUE || tok == WJB_ELEM) {
+        return jsonb_scalar_to_dynamic(*v, encoding);
+    }
 
-static inline std::string text_to_owned_string(Datum value)
-{
-    text* txt = DatumGetTextPP(value);
-    return std::string(VARDATA_ANY(txt), static_cast<size_t>(VARSIZE_ANY_EXHDR(txt)));
+    ereport(ERROR,
+            (errcode(ERRCODE_DATA_CORRUPTED),
+             errmsg("invalid jsonb token for conversion")));
 }
 
-static inline void format_uuid(Datum value, char (&out)[36])
+static inline void msgpack_require_bytes(
+    std::span<const uint8_t> data, size_t pos, size_t count)
 {
-    static constexpr char hex[] = "0123456789abcdef";
-    const pg_uuid_t* uuid = DatumGetUUIDP(value);
-    size_t pos = 0;
-    for (size_t i = 0; i < UUID_LEN; ++i) {
-        if (i == 4 || i == 6 || i == 8 || i == 10) {
-            out[pos++] = '-';
-        }
-        out[pos++] = hex[uuid->data[i] >> 4];
-        out[pos++] = hex[uuid->data[i] & 0x0f];
+    if (pos > data.size() || count > data.size() - pos) {
+        throw z::DeserializationError("truncated MessagePack value");
     }
 }
 
-static inline std::string uuid_to_owned_string(Datum value)
+static inline uint16_t msgpack_read_u16(std::span<const uint8_t> data, size_t pos)
 {
-    char out[36];
-    format_uuid(value, out);
-    return std::string(out, sizeof(out));
+    msgpack_require_bytes(data, pos, 2);
+    return static_cast<uint16_t>(
+        (static_cast<uint16_t>(data[pos]) << 8) | data[pos + 1]);
 }
 
-static inline std::string_view name_text_view(Datum value)
+static inline uint32_t msgpack_read_u32(std::span<const uint8_t> data, size_t pos)
 {
-    const char* name = NameStr(*DatumGetName(value));
-    return std::string_view(name, strnlen(name, NAMEDATALEN));
+    msgpack_require_bytes(data, pos, 4);
+    return (static_cast<uint32_t>(data[pos]) << 24) |
+           (static_cast<uint32_t>(data[pos + 1]) << 16) |
+           (static_cast<uint32_t>(data[pos + 2]) << 8) |
+           static_cast<uint32_t>(data[pos + 3]);
 }
 
-static inline std::string char_to_owned_string(Datum value)
+static inline bool msgpack_marker_is_string(uint8_t marker)
 {
-    char ch = DatumGetChar(value);
-    return ch == '\0' ? std::string() : std::string(1, ch);
+    return (marker & 0xe0) == 0xa0 || marker == 0xd9 ||
+           marker == 0xda || marker == 0xdb;
 }
 
-static inline std::string_view enum_label_view(Datum value)
+static inline bool msgpack_marker_is_array(uint8_t marker)
 {
-    Oid enum_value = DatumGetObjectId(value);
-    auto cached = enum_label_cache.find(enum_value);
-    if (cached != enum_label_cache.end()) {
-        return cached->second;
-    }
+    return (marker & 0xf0) == 0x90 || marker == 0xdc || marker == 0xdd;
+}
 
-    HeapTuple tuple = SearchSysCache1(ENUMOID, ObjectIdGetDatum(enum_value));
-    if (!HeapTupleIsValid(tuple)) {
-        ereport(ERROR,
-                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
-                 errmsg("invalid internal value for enum: %u", enum_value)));
-    }
-    Form_pg_enum entry = (Form_pg_enum) GETSTRUCT(tuple);
-    auto [it, inserted] = enum_label_cache.emplace(enum_value, NameStr(entry->enumlabel));
-    (void)inserted;
-    ReleaseSysCache(tuple);
-    return it->second;
+static inline bool msgpack_marker_is_map(uint8_t marker)
+{
+    return (marker & 0xf0) == 0x80 || marker == 0xde || marker == 0xdf;
 }
 
-static constexpr size_t kNetworkTextCapacity =
-    sizeof("xxxx:xxxx:xxxx:xxxx:xxxx:xxxx:255.255.255.255/128");
+static inline bool msgpack_marker_is_ext(uint8_t marker)
+{
+    return (marker >= 0xc7 && marker <= 0xc9) || (marker >= 0xd4 && marker <= 0xd8);
+}
 
-static inline std::string_view network_text_view(
-    Datum value, bool is_cidr, char (&out)[kNetworkTextCapacity])
+/*
+ * Reads an ext header after its marker, leaving *pos at the payload; returns
+ * false for other markers.
+ */
+static inline bool msgpack_read_ext(
+    std::span<const uint8_t> data, size_t* pos, uint8_t marker, uint8_t* type, size_t* len)
 {
-    inet* src = DatumGetInetPP(value);
-    if (pg_inet_net_ntop(ip_family(src), ip_addr(src), ip_bits(src),
-                         out, sizeof(out)) == nullptr) {
-        ereport(ERROR,
-                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
-                 errmsg("could not format inet value")));
+    switch (marker) {
+        case 0xd4: *len = 1; break;
+        case 0xd5: *len = 2; break;
+        case 0xd6: *len = 4; break;
+        case 0xd7: *len = 8; break;
+        case 0xd8: *len = 16; break;
+        case 0xc7:
+            msgpack_require_bytes(data, *pos, 1);
+            *len = data[(*pos)++];
+            break;
+        case 0xc8:
+            *len = msgpack_read_u16(data, *pos);
+            *pos += 2;
+            break;
+        case 0xc9:
+            *len = msgpack_read_u32(data, *pos);
+            *pos += 4;
+            break;
+        default:
+            return false;
     }
+    msgpack_require_bytes(data, *pos, 1);
+    *type = data[(*pos)++];
+    msgpack_require_bytes(data, *pos, *len);
+    return true;
+}
 
-    size_t len = strlen(out);
-    if (is_cidr && strchr(out, '/') == nullptr) {
-        int written = snprintf(out + len, sizeof(out) - len, "/%u", ip_bits(src));
-        if (written < 0 || static_cast<size_t>(written) >= sizeof(out) - len) {
-            ereport(ERROR,
-                    (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
-                     errmsg("formatted cidr value exceeds buffer")));
-        }
-        len += static_cast<size_t>(written);
+/* Only the typed-array ext types of pg_zerialize.array_encoding are accepted. */
+static const TypedArrayFormat& msgpack_typed_array_ext(uint8_t type, size_t len)
+{
+    const TypedArrayFormat* fmt = typed_array_format_for_tag(type);
+    if (fmt == nullptr) {
+        throw z::DeserializationError("unsupported MessagePack extension type");
     }
-    return std::string_view(out, len);
+    if (len % fmt->width != 0) {
+        throw z::DeserializationError(
+            "MessagePack typed array length is not a multiple of its element size");
+    }
+    return *fmt;
 }
 
-template <typename WriterT>
-static inline void write_network_string(WriterT& writer, Datum value, bool is_cidr)
+/* Reads a timestamp ext payload in any of its three sizes. */
+static Timestamp msgpack_read_timestamp(const uint8_t* payload, size_t len)
 {
-    char out[kNetworkTextCapacity];
-    writer.string(network_text_view(value, is_cidr, out));
+    switch (len) {
+        case 4:
+            return timestamp_from_epoch(static_cast<int64_t>(load_be(payload, 4)), 0);
+        case 8:
+        {
+            const uint64_t bits = load_be(payload, 8);
+            return timestamp_from_epoch(static_cast<int64_t>(bits & ((uint64_t{1} << 34) - 1)),
+                                        static_cast<uint32_t>(bits >> 34));
+        }
+        case 12:
+            return timestamp_from_epoch(static_cast<int64_t>(load_be(payload + 4, 8)),
+                                        static_cast<uint32_t>(load_be(payload, 4)));
+        default:
+            throw z::DeserializationError("MessagePack timestamp has an invalid length");
+    }
 }
 
-static inline std::string_view interval_text_view(
-    Datum value, char (&out)[MAXDATELEN + 1])
+static NetworkValue msgpack_read_network(const uint8_t* payload, size_t len)
 {
-    Interval* span = DatumGetIntervalP(value);
-#if PG_VERSION_NUM >= 170000
-    if (INTERVAL_IS_NOBEGIN(span)) {
-        return std::string_view(EARLY, sizeof(EARLY) - 1);
+    if (len != 5 && len != 17) {
+        throw z::DeserializationError("MessagePack network address has an invalid length");
     }
-    if (INTERVAL_IS_NOEND(span)) {
-        return std::string_view(LATE, sizeof(LATE) - 1);
+    NetworkValue network;
+    network.bits = payload[0];
+    network.size = static_cast<uint8_t>(len - 1);
+    if (network.bits > 8 * network.size) {
+        throw z::DeserializationError("network prefix length is out of range");
     }
-#endif
+    memcpy(network.address, payload + 1, network.size);
+    return network;
+}
 
-    struct pg_itm itm;
-    interval2itm(*span, &itm);
-    EncodeInterval(&itm, IntervalStyle, out);
-    return std::string_view(out, strlen(out));
+static Interval msgpack_read_interval(const uint8_t* payload, size_t len)
+{
+    if (len != 16) {
+        throw z::DeserializationError("MessagePack interval has an invalid length");
+    }
+    Interval span;
+    span.month = static_cast<int32>(static_cast<uint32_t>(load_be(payload, 4)));
+    span.day = static_cast<int32>(static_cast<uint32_t>(load_be(payload + 4, 4)));
+    span.time = static_cast<TimeOffset>(load_be(payload + 8, 8));
+    return span;
 }
 
-template <typename WriterT>
-static inline void write_interval_string(WriterT& writer, Datum value)
+static inline bool msgpack_ext_is_native(uint8_t type)
 {
-    char out[MAXDATELEN + 1];
-    writer.string(interval_text_view(value, out));
+    return type == kMsgpackTimestampExt || type == kMsgpackNetworkExt ||
+           type == kMsgpackIntervalExt;
 }
 
+/* Replays a native type ext payload in the writer's own native form. */
 template <typename WriterT>
-static inline void write_output_string(WriterT& writer, Oid typoutput, Datum value)
+static void msgpack_replay_native_ext(
+    WriterT& writer, uint8_t type, const uint8_t* payload, size_t len)
 {
-    char* str = OidOutputFunctionCall(typoutput, value);
-    writer.string(std::string_view(str));
-    pfree(str);
+    if (type == kMsgpackTimestampExt) {
+        write_native_timestamp(writer, msgpack_read_timestamp(payload, len));
+    } else if (type == kMsgpackNetworkExt) {
+        write_native_network(writer, msgpack_read_network(payload, len), false);
+    } else {
+        write_native_interval(writer, msgpack_read_interval(payload, len));
+    }
 }
 
 /*
- * Convert a PostgreSQL Datum to a zerialize dyn::Value
+ * Binary decimals, the native type ext types, and the typed-array ext types
+ * are the only ones accepted.
  */
-static z::dyn::Value datum_to_dynamic(Datum value, Oid typid, bool isnull)
+static void msgpack_check_ext(std::span<const uint8_t> data, size_t pos, uint8_t type, size_t len)
 {
-    if (isnull) {
-        return z::dyn::Value();  // null value
+    if (type == kMsgpackDecimalExt) {
+        if (len < 3) {
+            throw z::DeserializationError("MessagePack decimal is too short");
+        }
+        return;
     }
-
-    // Check if this is an array type
-    if (OidIsValid(get_element_type(typid))) {
-        return array_to_dynamic(value, typid);
+    if (type == kMsgpackTimestampExt) {
+        msgpack_read_timestamp(data.data() + pos, len);
+        return;
     }
+    if (type == kMsgpackNetworkExt) {
+        msgpack_read_network(data.data() + pos, len);
+        return;
+    }
+    if (type == kMsgpackIntervalExt) {
+        msgpack_read_interval(data.data() + pos, len);
+        return;
+    }
+    msgpack_typed_array_ext(type, len);
+}
 
-    switch (typid) {
-        case INT2OID:
-            return z::dyn::Value(static_cast<int64_t>(DatumGetInt16(value)));
-
-        case INT4OID:
-            return z::dyn::Value(static_cast<int64_t>(DatumGetInt32(value)));
+/* Reads a binary decimal ext payload. */
+static void msgpack_read_decimal(const uint8_t* payload, size_t len, DecimalValue* out)
+{
+    if (len < 3) {
+        throw z::DeserializationError("MessagePack decimal is too short");
+    }
+    const int16_t exponent = static_cast<int16_t>((payload[0] << 8) | payload[1]);
+    decimal_from_twos_complement(payload + 2, len - 2, out);
+    out->exponent = exponent;
+}
 
-        case INT8OID:
-            return z::dyn::Value(static_cast<int64_t>(DatumGetInt64(value)));
+/* Reads a binary decimal ext value at pos; false for other values. */
+static bool msgpack_ext_decimal(std::span<const uint8_t> data, size_t pos, DecimalValue* out)
+{
+    const uint8_t marker = data[pos++];
+    uint8_t type;
+    size_t len;
+    if (!msgpack_marker_is_ext(marker) || !msgpack_read_ext(data, &pos, marker, &type, &len) ||
+        type != kMsgpackDecimalExt) {
+        return false;
+    }
+    msgpack_read_decimal(data.data() + pos, len, out);
+    return true;
+}
 
-        case FLOAT4OID:
-            return z::dyn::Value(static_cast<double>(DatumGetFloat4(value)));
+static size_t msgpack_validate_value(std::span<const uint8_t> data, size_t pos)
+{
+    check_stack_depth();
+    msgpack_require_bytes(data, pos, 1);
+    const uint8_t marker = data[pos++];
 
-        case FLOAT8OID:
-            return z::dyn::Value(DatumGetFloat8(value));
+    if (marker <= 0x7f || marker >= 0xe0 || marker == 0xc0 ||
+        marker == 0xc2 || marker == 0xc3) {
+        return pos;
+    }
 
-        case BOOLOID:
-            return z::dyn::Value(DatumGetBool(value));
+    uint64_t count = 0;
+    if ((marker & 0xe0) == 0xa0) {
+        count = marker & 0x1f;
+        msgpack_require_bytes(data, pos, static_cast<size_t>(count));
+        return pos + static_cast<size_t>(count);
+    }
+    if ((marker & 0xf0) == 0x90) {
+        count = marker & 0x0f;
+        for (uint64_t i = 0; i < count; i++) {
+            pos = msgpack_validate_value(data, pos);
+        }
+        return pos;
+    }
+    if ((marker & 0xf0) == 0x80) {
+        count = marker & 0x0f;
+        std::unordered_set<std::string_view> keys;
+        for (uint64_t i = 0; i < count; i++) {
+            msgpack_require_bytes(data, pos, 1);
+            if (!msgpack_marker_is_string(data[pos])) {
+                throw z::DeserializationError("MessagePack map key is not a string");
+            }
+            const size_t key_start = pos;
+            pos = msgpack_validate_value(data, pos);
+            z::MsgPackDeserializer key_reader(
+                data.subspan(key_start, pos - key_start));
+            if (!keys.insert(key_reader.asStringView()).second) {
+                throw z::DeserializationError("duplicate MessagePack map key");
+            }
+            pos = msgpack_validate_value(data, pos);
+        }
+        return pos;
+    }
 
-        case TEXTOID:
-        case VARCHAROID:
-        case BPCHAROID:
-        case JSONOID:
+    size_t payload_size = 0;
+    switch (marker) {
+        case 0xc4:
+        case 0xd9:
+            msgpack_require_bytes(data, pos, 1);
+            payload_size = data[pos++];
+            break;
+        case 0xc5:
+        case 0xda:
+            payload_size = msgpack_read_u16(data, pos);
+            pos += 2;
+            break;
+        case 0xc6:
+        case 0xdb:
+            payload_size = msgpack_read_u32(data, pos);
+            pos += 4;
+            break;
+        case 0xca:
+        case 0xce:
+        case 0xd2:
+            payload_size = 4;
+            break;
+        case 0xcb:
+        case 0xcf:
+        case 0xd3:
+            payload_size = 8;
+            break;
+        case 0xcc:
+        case 0xd0:
+            payload_size = 1;
+            break;
+        case 0xcd:
+        case 0xd1:
+            payload_size = 2;
+            break;
+        case 0xdc:
+            count = msgpack_read_u16(data, pos);
+            pos += 2;
+            for (uint64_t i = 0; i < count; i++) {
+                pos = msgpack_validate_value(data, pos);
+            }
+            return pos;
+        case 0xdd:
+            count = msgpack_read_u32(data, pos);
+            pos += 4;
+            for (uint64_t i = 0; i < count; i++) {
+                pos = msgpack_validate_value(data, pos);
+            }
+            return pos;
+        case 0xde:
+        case 0xdf:
+            if (marker == 0xde) {
+                count = msgpack_read_u16(data, pos);
+                pos += 2;
+            } else {
+                count = msgpack_read_u32(data, pos);
+                pos += 4;
+            }
+            {
+                std::unordered_set<std::string_view> keys;
+                for (uint64_t i = 0; i < count; i++) {
+                    msgpack_require_bytes(data, pos, 1);
+                    if (!msgpack_marker_is_string(data[pos])) {
+                        throw z::DeserializationError("MessagePack map key is not a string");
+                    }
+                    const size_t key_start = pos;
+                    pos = msgpack_validate_value(data, pos);
+                    z::MsgPackDeserializer key_reader(
+                        data.subspan(key_start, pos - key_start));
+                    if (!keys.insert(key_reader.asStringView()).second) {
+                        throw z::DeserializationError("duplicate MessagePack map key");
+                    }
+                    pos = msgpack_validate_value(data, pos);
+                }
+            }
+            return pos;
+        case 0xc7:
+        case 0xc8:
+        case 0xc9:
+        case 0xd4:
+        case 0xd5:
+        case 0xd6:
+        case 0xd7:
+        case 0xd8:
         {
-            return z::dyn::Value(text_to_owned_string(value));
+            uint8_t type;
+            msgpack_read_ext(data, &pos, marker, &type, &payload_size);
+            msgpack_check_ext(data, pos, type, payload_size);
+            break;
+        }
+        default:
+            throw z::DeserializationError("unsupported or reserved MessagePack marker");
+    }
+
+    msgpack_require_bytes(data, pos, payload_size);
+    return pos + payload_size;
+}
+
+static void check_decoded_string(std::string_view text)
+{
+    if (text.find('\0') != std::string_view::npos) {
+        throw z::DeserializationError("decoded string contains NUL");
+    }
+    if (!pg_verify_mbstr(GetDatabaseEncoding(), text.data(), text.size(), true)) {
+        throw z::DeserializationError(
+            "decoded string is invalid in the database encoding");
+    }
+}
+
+/* Formats a finite decoded float with round-trip precision. */
+static void format_decoded_double(double number, std::array<char, 64>& buffer)
+{
+    auto converted = std::to_chars(
+        buffer.data(), buffer.data() + buffer.size() - 1, number,
+        std::chars_format::general, std::numeric_limits<double>::max_digits10);
+    if (converted.ec != std::errc()) {
+        throw z::DeserializationError("failed to format decoded number");
+    }
+    *converted.ptr = '\0';
+}
+
+/*
+ * Writer-shaped jsonb builder shared by the *_to_jsonb decoders. Tokens are
+ * pushed straight into a JsonbParseState, so decoded documents skip the JSON
+ * text round trip and integers reach numeric without being printed. Strings
+ * are referenced rather than copied and must stay valid until finish();
+ * decoders that materialize temporaries pass them through retain().
+ */
+class JsonbDecodeWriter {
+public:
+    void null()
+    {
+        JsonbValue value;
+        value.type = jbvNull;
+        scalar(&value);
+    }
+
+    void boolean(bool flag)
+    {
+        JsonbValue value;
+        value.type = jbvBool;
+        value.val.boolean = flag;
+        scalar(&value);
+    }
+
+    void int64(int64_t number)
+    {
+        numeric(DirectFunctionCall1(int8_numeric, Int64GetDatum(number)));
+    }
+
+    void uint64(uint64_t number)
+    {
+        if (number <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+            int64(static_cast<int64_t>(number));
+            return;
+        }
+        std::array<char, 32> buffer;
+        auto converted = std::to_chars(
+            buffer.data(), buffer.data() + buffer.size() - 1, number);
+        *converted.ptr = '\0';
+        numeric_text(buffer.data());
+    }
+
+    void double_(double number)
+    {
+        if (std::isnan(number)) {
+            string("NaN");
+            return;
+        }
+        if (std::isinf(number)) {
+            string(number > 0 ? "Infinity" : "-Infinity");
+            return;
+        }
+        std::array<char, 64> buffer;
+        format_decoded_double(number, buffer);
+        numeric_text(buffer.data());
+    }
+
+    /* Integer or decimal text that has no exact int64 form. */
+    void numeric_text(const char* text)
+    {
+        numeric(DirectFunctionCall3(numeric_in, CStringGetDatum(text),
+                                    ObjectIdGetDatum(InvalidOid), Int32GetDatum(-1)));
+    }
+
+    void string(std::string_view text)
+    {
+        JsonbValue value = string_value(text);
+        scalar(&value);
+    }
+
+    void binary(std::span<const std::byte> bytes)
+    {
+        begin_array(3);
+        string("~b");
+        string(retain(z::base64Encode(bytes)));
+        string("base64");
+        end_array();
+    }
+
+    void begin_array(size_t)
+    {
+        pushJsonbValue(&state_, WJB_BEGIN_ARRAY, nullptr);
+    }
+
+    void end_array()
+    {
+        close(WJB_END_ARRAY);
+    }
+
+    void begin_map(size_t)
+    {
+        pushJsonbValue(&state_, WJB_BEGIN_OBJECT, nullptr);
+    }
+
+    void end_map()
+    {
+        close(WJB_END_OBJECT);
+    }
+
+    void key(std::string_view text)
+    {
+        JsonbValue value = string_value(text);
+        pushJsonbValue(&state_, WJB_KEY, &value);
+    }
+
+    std::string_view retain(std::string_view text)
+    {
+        char* copy = static_cast<char*>(palloc(text.size() + 1));
+        memcpy(copy, text.data(), text.size());
+        copy[text.size()] = '\0';
+        return std::string_view(copy, text.size());
+    }
+
+    Jsonb* finish()
+    {
+        if (root_ == nullptr || state_ != nullptr) {
+            throw z::DeserializationError("incomplete decoded document");
+        }
+        return JsonbValueToJsonb(root_);
+    }
+
+private:
+    static JsonbValue string_value(std::string_view text)
+    {
+        check_decoded_string(text);
+        if (text.size() > JENTRY_OFFLENMASK) {
+            throw z::DeserializationError("decoded string is too long for jsonb");
+        }
+        JsonbValue value;
+        value.type = jbvString;
+        value.val.string.len = static_cast<int>(text.size());
+        value.val.string.val = const_cast<char*>(text.data());
+        return value;
+    }
+
+    void numeric(Datum number)
+    {
+        JsonbValue value;
+        value.type = jbvNumeric;
+        value.val.numeric = DatumGetNumeric(number);
+        scalar(&value);
+    }
+
+    /* Mirrors jsonb_in: a scalar root becomes a raw-scalar pseudo-array. */
+    void scalar(JsonbValue* value)
+    {
+        if (state_ == nullptr) {
+            JsonbValue wrapper;
+            wrapper.type = jbvArray;
+            wrapper.val.array.rawScalar = true;
+            wrapper.val.array.nElems = 1;
+            pushJsonbValue(&state_, WJB_BEGIN_ARRAY, &wrapper);
+            pushJsonbValue(&state_, WJB_ELEM, value);
+            root_ = pushJsonbValue(&state_, WJB_END_ARRAY, nullptr);
+            return;
+        }
+        pushJsonbValue(&state_,
+                       state_->contVal.type == jbvObject ? WJB_VALUE : WJB_ELEM,
+                       value);
+    }
+
+    void close(JsonbIteratorToken token)
+    {
+        JsonbValue* value = pushJsonbValue(&state_, token, nullptr);
+        if (state_ == nullptr) {
+            root_ = value;
+        }
+    }
+
+    JsonbParseState* state_ = nullptr;
+    JsonbValue* root_ = nullptr;
+};
+
+static size_t msgpack_replay_string(
+    std::span<const uint8_t> data, size_t pos, uint8_t marker, std::string_view* out)
+{
+    size_t len;
+    if ((marker & 0xe0) == 0xa0) {
+        len = marker & 0x1f;
+    } else if (marker == 0xd9) {
+        msgpack_require_bytes(data, pos, 1);
+        len = data[pos++];
+    } else if (marker == 0xda) {
+        len = msgpack_read_u16(data, pos);
+        pos += 2;
+    } else if (marker == 0xdb) {
+        len = msgpack_read_u32(data, pos);
+        pos += 4;
+    } else {
+        throw z::DeserializationError("expected a MessagePack string");
+    }
+    msgpack_require_bytes(data, pos, len);
+    *out = std::string_view(reinterpret_cast<const char*>(data.data() + pos), len);
+    return pos + len;
+}
+
+/*
+ * Replay one MessagePack value into another protocol writer. Buffered
+ * aggregate state is produced by this extension's MessagePack writers, so
+ * integers are replayed through int64 and floats through double_, preserving
+ * the exact writer call sequence of the direct row serializers. External
+ * input must pass msgpack_validate_value first.
+ */
+template <typename WriterT>
+static size_t msgpack_replay_value(std::span<const uint8_t> data, size_t pos, WriterT& writer)
+{
+    msgpack_require_bytes(data, pos, 1);
+    const uint8_t marker = data[pos++];
+
+    if (marker <= 0x7f) {
+        writer.int64(static_cast<int64_t>(marker));
+        return pos;
+    }
+    if (marker >= 0xe0) {
+        writer.int64(static_cast<int64_t>(static_cast<int8_t>(marker)));
+        return pos;
+    }
+
+    size_t count;
+    bool is_map;
+    if ((marker & 0xf0) == 0x80 || (marker & 0xf0) == 0x90) {
+        count = marker & 0x0f;
+        is_map = (marker & 0xf0) == 0x80;
+    } else if (marker == 0xdc || marker == 0xde) {
+        count = msgpack_read_u16(data, pos);
+        pos += 2;
+        is_map = marker == 0xde;
+    } else if (marker == 0xdd || marker == 0xdf) {
+        count = msgpack_read_u32(data, pos);
+        pos += 4;
+        is_map = marker == 0xdf;
+    } else {
+        switch (marker) {
+            case 0xc0:
+                writer.null();
+                return pos;
+            case 0xc2:
+            case 0xc3:
+                writer.boolean(marker == 0xc3);
+                return pos;
+            case 0xc4:
+            case 0xc5:
+            case 0xc6:
+            {
+                size_t len;
+                if (marker == 0xc4) {
+                    msgpack_require_bytes(data, pos, 1);
+                    len = data[pos++];
+                } else if (marker == 0xc5) {
+                    len = msgpack_read_u16(data, pos);
+                    pos += 2;
+                } else {
+                    len = msgpack_read_u32(data, pos);
+                    pos += 4;
+                }
+                msgpack_require_bytes(data, pos, len);
+                writer.binary(std::span<const std::byte>(
+                    reinterpret_cast<const std::byte*>(data.data() + pos), len));
+                return pos + len;
+            }
+            case 0xca:
+                writer.double_(static_cast<double>(
+                    std::bit_cast<float>(msgpack_read_u32(data, pos))));
+                return pos + 4;
+            case 0xcb:
+            {
+                uint64_t bits = (static_cast<uint64_t>(msgpack_read_u32(data, pos)) << 32) |
+                                msgpack_read_u32(data, pos + 4);
+                writer.double_(std::bit_cast<double>(bits));
+                return pos + 8;
+            }
+            case 0xcc:
+                msgpack_require_bytes(data, pos, 1);
+                writer.int64(static_cast<int64_t>(data[pos]));
+                return pos + 1;
+            case 0xcd:
+                writer.int64(static_cast<int64_t>(msgpack_read_u16(data, pos)));
+                return pos + 2;
+            case 0xce:
+                writer.int64(static_cast<int64_t>(msgpack_read_u32(data, pos)));
+                return pos + 4;
+            case 0xcf:
+            {
+                uint64_t value = (static_cast<uint64_t>(msgpack_read_u32(data, pos)) << 32) |
+                                 msgpack_read_u32(data, pos + 4);
+                if (value > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+                    writer.uint64(value);
+                } else {
+                    writer.int64(static_cast<int64_t>(value));
+                }
+                return pos + 8;
+            }
+            case 0xd0:
+                msgpack_require_bytes(data, pos, 1);
+                writer.int64(static_cast<int64_t>(static_cast<int8_t>(data[pos])));
+                return pos + 1;
+            case 0xd1:
+                writer.int64(static_cast<int64_t>(
+                    static_cast<int16_t>(msgpack_read_u16(data, pos))));
+                return pos + 2;
+            case 0xd2:
+                writer.int64(static_cast<int64_t>(
+                    static_cast<int32_t>(msgpack_read_u32(data, pos))));
+                return pos + 4;
+            case 0xd3:
+            {
+                uint64_t bits = (static_cast<uint64_t>(msgpack_read_u32(data, pos)) << 32) |
+                                msgpack_read_u32(data, pos + 4);
+                writer.int64(static_cast<int64_t>(bits));
+                return pos + 8;
+            }
+            case 0xc7:
+            case 0xc8:
+            case 0xc9:
+            case 0xd4:
+            case 0xd5:
+            case 0xd6:
+            case 0xd7:
+            case 0xd8:
+            {
+                uint8_t type;
+                size_t len;
+                msgpack_read_ext(data, &pos, marker, &type, &len);
+                if (type == kMsgpackDecimalExt) {
+                    DecimalValue decimal;
+                    msgpack_read_decimal(data.data() + pos, len, &decimal);
+                    write_decimal(writer, decimal);
+                    return pos + len;
+                }
+                if (msgpack_ext_is_native(type)) {
+                    msgpack_replay_native_ext(writer, type, data.data() + pos, len);
+                    return pos + len;
+                }
+                const TypedArrayFormat& fmt = msgpack_typed_array_ext(type, len);
+                write_typed_array(writer, fmt, data.data() + pos, len / fmt.width);
+                return pos + len;
+            }
+            default:
+            {
+                std::string_view sv;
+                pos = msgpack_replay_string(data, pos, marker, &sv);
+                writer.string(sv);
+                return pos;
+            }
         }
+    }
+
+    if (is_map) {
+        writer.begin_map(count);
+        for (size_t i = 0; i < count; i++) {
+            msgpack_require_bytes(data, pos, 1);
+            std::string_view key;
+            pos = msgpack_replay_string(data, pos + 1, data[pos], &key);
+            writer.key(key);
+            pos = msgpack_replay_value(data, pos, writer);
+        }
+        writer.end_map();
+    } else {
+        writer.begin_array(count);
+        for (size_t i = 0; i < count; i++) {
+            pos = msgpack_replay_value(data, pos, writer);
+        }
+        writer.end_array();
+    }
+    return pos;
+}
+
+/* Replay a verified FlexBuffer reference into a writer. */
+template <typename WriterT>
+static void flex_replay_reference(const ::flexbuffers::Reference& value, WriterT& out)
+{
+    check_stack_depth();
+    if (value.IsNull()) {
+        out.null();
+    } else if (value.IsBool()) {
+        out.boolean(value.AsBool());
+    } else if (value.IsUInt()) {
+        out.uint64(value.AsUInt64());
+    } else if (value.IsInt()) {
+        out.int64(value.AsInt64());
+    } else if (value.IsFloat()) {
+        out.double_(value.AsDouble());
+    } else if (value.IsString()) {
+        auto string_value = value.AsString();
+        out.string(std::string_view(string_value.c_str(), string_value.size()));
+    } else if (value.IsBlob()) {
+        auto blob = value.AsBlob();
+        out.binary(std::span<const std::byte>(
+            reinterpret_cast<const std::byte*>(blob.data()), blob.size()));
+    } else if (value.IsMap()) {
+        auto map = value.AsMap();
+        auto keys = map.Keys();
+        auto values = map.Values();
+        std::unordered_set<std::string_view> seen_keys;
+
+        out.begin_map(keys.size());
+        for (size_t i = 0; i < keys.size(); i++) {
+            auto key_value = keys[i].AsString();
+            std::string_view key(key_value.c_str(), key_value.size());
+            if (!seen_keys.insert(key).second) {
+                throw z::DeserializationError("duplicate FlexBuffer map key");
+            }
+            out.key(key);
+            flex_replay_reference(values[i], out);
+        }
+        out.end_map();
+    } else if (value.IsAnyVector()) {
+        auto append_vector = [&](const auto& vector) {
+            out.begin_array(vector.size());
+            for (size_t i = 0; i < vector.size(); i++) {
+                flex_replay_reference(vector[i], out);
+            }
+            out.end_array();
+        };
+
+        if (value.IsTypedVector()) {
+            append_vector(value.AsTypedVector());
+        } else if (value.IsFixedTypedVector()) {
+            append_vector(value.AsFixedTypedVector());
+        } else {
+            append_vector(value.AsVector());
+        }
+    } else {
+        throw z::DeserializationError("unsupported FlexBuffer value");
+    }
+}
+
+struct CborHead {
+    uint8_t major;
+    uint8_t additional;
+    uint64_t value;
+    size_t next;
+    bool indefinite;
+};
+
+static inline void cbor_require_bytes(
+    std::span<const uint8_t> data, size_t pos, size_t count)
+{
+    if (pos > data.size() || count > data.size() - pos) {
+        throw z::DeserializationError("truncated CBOR value");
+    }
+}
+
+static CborHead cbor_read_head(std::span<const uint8_t> data, size_t pos)
+{
+    cbor_require_bytes(data, pos, 1);
+    const uint8_t initial = data[pos++];
+    CborHead head{static_cast<uint8_t>(initial >> 5),
+                  static_cast<uint8_t>(initial & 0x1f), 0, pos, false};
+
+    if (head.additional < 24) {
+        head.value = head.additional;
+        return head;
+    }
+    if (head.additional == 31) {
+        head.indefinite = true;
+        return head;
+    }
+    if (head.additional >= 28) {
+        throw z::DeserializationError("reserved CBOR additional information");
+    }
+
+    const size_t width = size_t{1} << (head.additional - 24);
+    cbor_require_bytes(data, pos, width);
+    for (size_t i = 0; i < width; i++) {
+        head.value = (head.value << 8) | data[pos + i];
+    }
+    head.next = pos + width;
+    return head;
+}
+
+static size_t cbor_parse_text(
+    std::span<const uint8_t> data, size_t pos, std::string* result)
+{
+    CborHead head = cbor_read_head(data, pos);
+    if (head.major != 3) {
+        throw z::DeserializationError("CBOR map key is not a text string");
+    }
+
+    if (!head.indefinite) {
+        if (head.value > std::numeric_limits<size_t>::max()) {
+            throw z::DeserializationError("CBOR text string is too large");
+        }
+        const size_t length = static_cast<size_t>(head.value);
+        cbor_require_bytes(data, head.next, length);
+        result->assign(reinterpret_cast<const char*>(data.data() + head.next), length);
+        return head.next + length;
+    }
+
+    result->clear();
+    pos = head.next;
+    for (;;) {
+        cbor_require_bytes(data, pos, 1);
+        if (data[pos] == 0xff) {
+            return pos + 1;
+        }
+        CborHead chunk = cbor_read_head(data, pos);
+        if (chunk.major != 3 || chunk.indefinite) {
+            throw z::DeserializationError("invalid CBOR text string chunk");
+        }
+        if (chunk.value > std::numeric_limits<size_t>::max()) {
+            throw z::DeserializationError("CBOR text string chunk is too large");
+        }
+        const size_t length = static_cast<size_t>(chunk.value);
+        cbor_require_bytes(data, chunk.next, length);
+        result->append(
+            reinterpret_cast<const char*>(data.data() + chunk.next), length);
+        pos = chunk.next + length;
+    }
+}
+
+static size_t cbor_parse_bytes(
+    std::span<const uint8_t> data, size_t pos, std::vector<std::byte>* result)
+{
+    CborHead head = cbor_read_head(data, pos);
+    if (head.major != 2) {
+        throw z::DeserializationError("CBOR value is not a byte string");
+    }
+
+    result->clear();
+    if (!head.indefinite) {
+        if (head.value > std::numeric_limits<size_t>::max()) {
+            throw z::DeserializationError("CBOR byte string is too large");
+        }
+        const size_t length = static_cast<size_t>(head.value);
+        cbor_require_bytes(data, head.next, length);
+        const auto* begin = reinterpret_cast<const std::byte*>(
+            data.data() + head.next);
+        result->assign(begin, begin + length);
+        return head.next + length;
+    }
+
+    pos = head.next;
+    for (;;) {
+        cbor_require_bytes(data, pos, 1);
+        if (data[pos] == 0xff) {
+            return pos + 1;
+        }
+        CborHead chunk = cbor_read_head(data, pos);
+        if (chunk.major != 2 || chunk.indefinite) {
+            throw z::DeserializationError("invalid CBOR byte string chunk");
+        }
+        if (chunk.value > std::numeric_limits<size_t>::max()) {
+            throw z::DeserializationError("CBOR byte string chunk is too large");
+        }
+        const size_t length = static_cast<size_t>(chunk.value);
+        cbor_require_bytes(data, chunk.next, length);
+        const auto* begin = reinterpret_cast<const std::byte*>(
+            data.data() + chunk.next);
+        result->insert(result->end(), begin, begin + length);
+        pos = chunk.next + length;
+    }
+}
+
+static double cbor_decode_half(uint16_t bits)
+{
+    const bool negative = (bits & 0x8000) != 0;
+    const uint16_t exponent = (bits >> 10) & 0x1f;
+    const uint16_t fraction = bits & 0x03ff;
+
+    if (exponent == 0) {
+        if (fraction == 0) return negative ? -0.0 : 0.0;
+        const double value = std::ldexp(static_cast<double>(fraction), -24);
+        return negative ? -value : value;
+    }
+    if (exponent == 0x1f) {
+        if (fraction != 0) return std::numeric_limits<double>::quiet_NaN();
+        return negative ? -std::numeric_limits<double>::infinity()
+                        : std::numeric_limits<double>::infinity();
+    }
+
+    const double mantissa = 1.0 + static_cast<double>(fraction) / 1024.0;
+    const double value = std::ldexp(mantissa, static_cast<int>(exponent) - 15);
+    return negative ? -value : value;
+}
+
+/*
+ * RFC 8746 typed arrays are tags 64-87, 0b010fsell: f marks floats, s
+ * signed integers, e little-endian (clamped for uint8), and ll the size
+ * class. Tag 76 is reserved and the float128 tags 83 and 87 have no jsonb
+ * form. Apart from these, only the bignum and decimal fraction tags of
+ * cbor_tag_is_decimal and the tag 1 epoch times of native timestamps are
+ * supported.
+ */
+static inline bool cbor_tag_is_typed_array(const CborHead& head)
+{
+    return head.major == 6 && !head.indefinite &&
+           head.value >= 64 && head.value <= 87 &&
+           head.value != 76 && head.value != 83 && head.value != 87;
+}
+
+/* Bignums (tags 2 and 3) and decimal fractions (tag 4). */
+static inline bool cbor_tag_is_decimal(const CborHead& head)
+{
+    return head.major == 6 && !head.indefinite && head.value >= 2 && head.value <= 4;
+}
+
+static size_t cbor_read_bignum(
+    std::span<const uint8_t> data, const CborHead& head, DecimalValue* out)
+{
+    std::vector<std::byte> bytes;
+    const size_t next = cbor_parse_bytes(data, head.next, &bytes);
+    out->negative = head.value == 3;
+    decimal_from_magnitude(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size(),
+                           head.value == 3, out);
+    return next;
+}
+
+/* Reads the value under a cbor_tag_is_decimal tag. */
+static size_t cbor_read_decimal(
+    std::span<const uint8_t> data, const CborHead& head, DecimalValue* out)
+{
+    if (head.value != 4) {
+        out->exponent = 0;
+        return cbor_read_bignum(data, head, out);
+    }
+
+    const CborHead array = cbor_read_head(data, head.next);
+    if (array.major != 4 || array.indefinite || array.value != 2) {
+        throw z::DeserializationError("CBOR decimal fraction is not a two-element array");
+    }
+    const CborHead exponent = cbor_read_head(data, array.next);
+    if (exponent.major > 1 || exponent.indefinite) {
+        throw z::DeserializationError("CBOR decimal fraction exponent is not an integer");
+    }
+    if (exponent.value > static_cast<uint64_t>(PG_INT16_MAX) + 1) {
+        throw z::DeserializationError("decimal exponent is out of range");
+    }
+    const int64_t exponent_value = exponent.major == 0
+        ? static_cast<int64_t>(exponent.value)
+        : -1 - static_cast<int64_t>(exponent.value);
+
+    const CborHead mantissa = cbor_read_head(data, exponent.next);
+    size_t next;
+    if (mantissa.major <= 1 && !mantissa.indefinite) {
+        uint8_t bytes[8];
+        for (int i = 0; i < 8; i++) {
+            bytes[i] = static_cast<uint8_t>(mantissa.value >> (56 - 8 * i));
+        }
+        out->negative = mantissa.major == 1;
+        decimal_from_magnitude(bytes, sizeof(bytes), mantissa.major == 1, out);
+        next = mantissa.next;
+    } else if (mantissa.major == 6 && !mantissa.indefinite &&
+               (mantissa.value == 2 || mantissa.value == 3)) {
+        next = cbor_read_bignum(data, mantissa, out);
+    } else {
+        throw z::DeserializationError("CBOR decimal fraction mantissa is not an integer");
+    }
+    out->exponent = decimal_checked_exponent(exponent_value);
+    return next;
+}
+
+static inline bool cbor_tag_is_epoch_time(const CborHead& head)
+{
+    return head.major == 6 && !head.indefinite && head.value == 1;
+}
+
+/* Reads the integer or float seconds under a tag 1 epoch time. */
+static size_t cbor_read_epoch_time(
+    std::span<const uint8_t> data, const CborHead& head, Timestamp* out)
+{
+    const CborHead content = cbor_read_head(data, head.next);
+    if (content.major <= 1 && !content.indefinite) {
+        if (content.value > static_cast<uint64_t>(INT64_MAX)) {
+            throw z::DeserializationError("timestamp out of range");
+        }
+        const int64_t seconds = content.major == 0 ? static_cast<int64_t>(content.value)
+                                                   : -1 - static_cast<int64_t>(content.value);
+        *out = timestamp_from_epoch(seconds, 0);
+        return content.next;
+    }
+
+    double seconds;
+    if (content.major == 7 && content.additional == 25) {
+        seconds = cbor_decode_half(static_cast<uint16_t>(content.value));
+    } else if (content.major == 7 && content.additional == 26) {
+        seconds = std::bit_cast<float>(static_cast<uint32_t>(content.value));
+    } else if (content.major == 7 && content.additional == 27) {
+        seconds = std::bit_cast<double>(content.value);
+    } else {
+        throw z::DeserializationError("CBOR epoch time is not a number");
+    }
+    // Past the timestamp range either way; keeps the cast below defined.
+    if (!(std::fabs(seconds) < 1e15)) {
+        throw z::DeserializationError("timestamp out of range");
+    }
+    const double whole = std::floor(seconds);
+    int64_t epoch_seconds = static_cast<int64_t>(whole);
+    int64_t nanoseconds = std::llround((seconds - whole) * 1e9);
+    if (nanoseconds >= 1000000000) {
+        epoch_seconds++;
+        nanoseconds -= 1000000000;
+    }
+    *out = timestamp_from_epoch(epoch_seconds, static_cast<uint32_t>(nanoseconds));
+    return content.next;
+}
+
+/*
+ * Decodes the byte string under a typed-array tag into a number array.
+ * Serializers keep the five tags they can write as typed arrays.
+ */
+template <typename WriterT>
+static size_t cbor_replay_typed_array(
+    std::span<const uint8_t> data, const CborHead& head, WriterT& out)
+{
+    if (!cbor_tag_is_typed_array(head)) {
+        throw z::DeserializationError("CBOR semantic tags are not supported");
+    }
+    const unsigned bits = static_cast<unsigned>(head.value - 64);
+    const bool is_float = (bits & 0x10) != 0;
+    const bool is_signed = !is_float && (bits & 0x08) != 0;
+    const bool little_endian = (bits & 0x04) != 0;
+    const size_t width = is_float ? size_t{2} << (bits & 3) : size_t{1} << (bits & 3);
+
+    std::vector<std::byte> bytes;
+    const size_t next = cbor_parse_bytes(data, head.next, &bytes);
+    if (bytes.size() % width != 0) {
+        throw z::DeserializationError(
+            "CBOR typed array length is not a multiple of its element size");
+    }
+
+    const auto* packed = reinterpret_cast<const uint8_t*>(bytes.data());
+    const size_t nitems = bytes.size() / width;
+    if constexpr (!std::is_same_v<WriterT, JsonbDecodeWriter>) {
+        for (const TypedArrayFormat& fmt : typed_array_formats) {
+            if (fmt.tag == head.value) {
+                write_typed_array(out, fmt, packed, nitems);
+                return next;
+            }
+        }
+    }
+    out.begin_array(nitems);
+    for (size_t i = 0; i < nitems; i++) {
+        const uint8_t* p = packed + width * i;
+        uint64_t value = 0;
+        for (size_t b = 0; b < width; b++) {
+            value = (value << 8) | p[little_endian ? width - 1 - b : b];
+        }
+        if (is_float) {
+            if (width == 2) {
+                out.double_(cbor_decode_half(static_cast<uint16_t>(value)));
+            } else if (width == 4) {
+                out.double_(std::bit_cast<float>(static_cast<uint32_t>(value)));
+            } else {
+                out.double_(std::bit_cast<double>(value));
+            }
+        } else if (is_signed) {
+            const int shift = static_cast<int>(64 - 8 * width);
+            out.int64(static_cast<int64_t>(value << shift) >> shift);
+        } else {
+            out.uint64(value);
+        }
+    }
+    out.end_array();
+    return next;
+}
+
+/*
+ * Reads a text string without copying a definite one: *out points into data,
+ * or into *scratch when indefinite chunks had to be joined.
+ */
+static size_t cbor_text_view(
+    std::span<const uint8_t> data, size_t pos, std::string* scratch, std::string_view* out)
+{
+    const CborHead head = cbor_read_head(data, pos);
+    if (head.major == 3 && !head.indefinite) {
+        if (head.value > std::numeric_limits<size_t>::max()) {
+            throw z::DeserializationError("CBOR text string is too large");
+        }
+        const size_t length = static_cast<size_t>(head.value);
+        cbor_require_bytes(data, head.next, length);
+        *out = std::string_view(reinterpret_cast<const char*>(data.data() + head.next), length);
+        return head.next + length;
+    }
+    const size_t next = cbor_parse_text(data, pos, scratch);
+    *out = *scratch;
+    return next;
+}
+
+static size_t cbor_skip_value(std::span<const uint8_t> data, size_t pos);
+
+/* Counts the entries of an indefinite array or map ahead of replaying it. */
+static size_t cbor_count_indefinite(std::span<const uint8_t> data, size_t pos, bool is_map)
+{
+    size_t count = 0;
+    for (;;) {
+        cbor_require_bytes(data, pos, 1);
+        if (data[pos] == 0xff) {
+            return count;
+        }
+        pos = cbor_skip_value(data, pos);
+        if (is_map) {
+            pos = cbor_skip_value(data, pos);
+        }
+        count++;
+    }
+}
+
+/*
+ * A definite array or map length from the input, checked against the bytes
+ * left: every item takes at least one byte, so a larger count is truncated
+ * and never reaches a writer's size hint.
+ */
+static size_t cbor_definite_count(std::span<const uint8_t> data, const CborHead& head, bool is_map)
+{
+    const uint64_t per_item = is_map ? 2 : 1;
+    if (head.value > (data.size() - head.next) / per_item) {
+        throw z::DeserializationError("truncated CBOR value");
+    }
+    return static_cast<size_t>(head.value);
+}
+
+/* MessagePack and CBOR put a container's length in its header. */
+template <typename WriterT>
+static constexpr bool writer_needs_length =
+    std::is_same_v<WriterT, z::MsgPackSerializer> ||
+    std::is_same_v<WriterT, z::cborjc::Serializer>;
+
+/*
+ * Replay one CBOR value into a writer, validating as it goes. Definite text
+ * is passed as views into data; JsonbDecodeWriter retains joined chunks.
+ */
+template <typename WriterT>
+static size_t cbor_replay_value(std::span<const uint8_t> data, size_t pos, WriterT& out)
+{
+    check_stack_depth();
+    CborHead head = cbor_read_head(data, pos);
+
+    if (head.major <= 1 && head.indefinite) {
+        throw z::DeserializationError("indefinite CBOR integer");
+    }
+
+    switch (head.major) {
+        case 0:
+            out.uint64(head.value);
+            return head.next;
+        case 1:
+            if (head.value <= static_cast<uint64_t>(INT64_MAX)) {
+                out.int64(-1 - static_cast<int64_t>(head.value));
+            } else {
+                // Below int64; the same integer as a zero-exponent decimal.
+                uint8_t bytes[8];
+                store_be(bytes, head.value, 8);
+                DecimalValue decimal;
+                decimal.negative = true;
+                decimal_from_magnitude(bytes, sizeof(bytes), true, &decimal);
+                write_decimal(out, decimal);
+            }
+            return head.next;
+        case 2:
+        {
+            std::vector<std::byte> bytes;
+            const size_t next = cbor_parse_bytes(data, pos, &bytes);
+            out.binary(bytes);
+            return next;
+        }
+        case 3:
+        {
+            std::string scratch;
+            std::string_view text_value;
+            const size_t next = cbor_text_view(data, pos, &scratch, &text_value);
+            if constexpr (std::is_same_v<WriterT, JsonbDecodeWriter>) {
+                if (!scratch.empty()) text_value = out.retain(text_value);
+            }
+            out.string(text_value);
+            return next;
+        }
+        case 4:
+        {
+            size_t count;
+            if (head.indefinite) {
+                count = writer_needs_length<WriterT>
+                    ? cbor_count_indefinite(data, head.next, false)
+                    : 0;
+            } else {
+                count = cbor_definite_count(data, head, false);
+            }
+            out.begin_array(count);
+            size_t cursor = head.next;
+            if (head.indefinite) {
+                while (true) {
+                    cbor_require_bytes(data, cursor, 1);
+                    if (data[cursor] == 0xff) {
+                        cursor++;
+                        break;
+                    }
+                    cursor = cbor_replay_value(data, cursor, out);
+                }
+            } else {
+                for (uint64_t index = 0; index < head.value; index++) {
+                    cursor = cbor_replay_value(data, cursor, out);
+                }
+            }
+            out.end_array();
+            return cursor;
+        }
+        case 5:
+        {
+            size_t count;
+            if (head.indefinite) {
+                count = writer_needs_length<WriterT>
+                    ? cbor_count_indefinite(data, head.next, true)
+                    : 0;
+            } else {
+                count = cbor_definite_count(data, head, true);
+            }
+            out.begin_map(count);
+            size_t cursor = head.next;
+            uint64_t index = 0;
+            // Joined keys are retained or parked in a deque so views stay valid.
+            std::unordered_set<std::string_view> keys;
+            std::deque<std::string> joined_keys;
+            auto append_entry = [&]() {
+                std::string scratch;
+                std::string_view key;
+                cursor = cbor_text_view(data, cursor, &scratch, &key);
+                if (!scratch.empty()) {
+                    if constexpr (std::is_same_v<WriterT, JsonbDecodeWriter>) {
+                        key = out.retain(key);
+                    } else {
+                        key = joined_keys.emplace_back(std::move(scratch));
+                    }
+                }
+                if (!keys.insert(key).second) {
+                    throw z::DeserializationError("duplicate CBOR map key");
+                }
+                index++;
+                out.key(key);
+                cursor = cbor_replay_value(data, cursor, out);
+            };
+
+            if (head.indefinite) {
+                while (true) {
+                    cbor_require_bytes(data, cursor, 1);
+                    if (data[cursor] == 0xff) {
+                        cursor++;
+                        break;
+                    }
+                    append_entry();
+                }
+            } else {
+                while (index < head.value) append_entry();
+            }
+            out.end_map();
+            return cursor;
+        }
+        case 6:
+            if (cbor_tag_is_decimal(head)) {
+                DecimalValue decimal;
+                const size_t next = cbor_read_decimal(data, head, &decimal);
+                write_decimal(out, decimal);
+                return next;
+            }
+            if (cbor_tag_is_epoch_time(head)) {
+                Timestamp ts;
+                const size_t next = cbor_read_epoch_time(data, head, &ts);
+                write_native_timestamp(out, ts);
+                return next;
+            }
+            return cbor_replay_typed_array(data, head, out);
+        case 7:
+            if (head.indefinite) {
+                throw z::DeserializationError("unexpected CBOR break marker");
+            }
+            if (head.additional == 20 || head.additional == 21) {
+                out.boolean(head.additional == 21);
+                return head.next;
+            }
+            if (head.additional == 22) {
+                out.null();
+                return head.next;
+            }
+            if (head.additional == 25) {
+                out.double_(cbor_decode_half(static_cast<uint16_t>(head.value)));
+                return head.next;
+            }
+            if (head.additional == 26) {
+                out.double_(std::bit_cast<float>(static_cast<uint32_t>(head.value)));
+                return head.next;
+            }
+            if (head.additional == 27) {
+                out.double_(std::bit_cast<double>(head.value));
+                return head.next;
+            }
+            throw z::DeserializationError("unsupported CBOR simple value");
+        default:
+            pg_unreachable();
+    }
+}
+
+struct ZeraDecodeContext {
+    std::span<const uint8_t> envelope;
+    std::span<const uint8_t> arena;
+    std::unordered_set<uint32_t> active_refs;
+};
+
+static inline void zera_require_span(
+    std::span<const uint8_t> data, size_t offset, size_t length,
+    const char* message)
+{
+    if (offset > data.size() || length > data.size() - offset) {
+        throw z::DeserializationError(message);
+    }
+}
+
+/* Resolves an inline or arena String ValueRef. */
+static std::string_view zera_string_view(
+    const ZeraDecodeContext& context, const uint8_t* ref)
+{
+    const uint8_t flags = ref[1];
+    const uint16_t aux = z::zera::read_u16_le(ref + 2);
+    if ((flags & ~uint8_t{1}) != 0) {
+        throw z::DeserializationError("unknown ZERA string flags");
+    }
+    if ((flags & 1) != 0) {
+        if (aux > z::zera::InlineMax) {
+            throw z::DeserializationError("ZERA inline string is too long");
+        }
+        return std::string_view(reinterpret_cast<const char*>(ref + 4), aux);
+    }
+    const uint32_t a = z::zera::read_u32_le(ref + 4);
+    const uint32_t b = z::zera::read_u32_le(ref + 8);
+    zera_require_span(
+        context.arena, a, b, "ZERA string arena span is out of bounds");
+    return std::string_view(
+        reinterpret_cast<const char*>(context.arena.data() + a), b);
+}
+
+/* Replay one ZERA ValueRef into a writer; strings are views into the buffer. */
+template <typename WriterT>
+static size_t zera_replay_value(
+    ZeraDecodeContext& context, uint32_t ref_offset, WriterT& out, size_t depth)
+{
+    if (depth > 64) {
+        throw z::DeserializationError("ZERA nesting depth exceeds 64");
+    }
+    zera_require_span(
+        context.envelope, ref_offset, 16, "ZERA ValueRef is out of bounds");
+    if (!context.active_refs.insert(ref_offset).second) {
+        throw z::DeserializationError("cyclic ZERA envelope reference");
+    }
+
+    const uint8_t* ref = context.envelope.data() + ref_offset;
+    const auto tag = static_cast<z::zera::Tag>(ref[0]);
+    const uint8_t flags = ref[1];
+    const uint16_t aux = z::zera::read_u16_le(ref + 2);
+    const uint32_t a = z::zera::read_u32_le(ref + 4);
+    const uint32_t b = z::zera::read_u32_le(ref + 8);
+    const uint32_t c = z::zera::read_u32_le(ref + 12);
+
+    auto require_no_flags = [&]() {
+        if (flags != 0) {
+            throw z::DeserializationError("non-string ZERA value has flags");
+        }
+    };
+
+    switch (tag) {
+        case z::zera::Tag::Null:
+            require_no_flags();
+            out.null();
+            break;
+        case z::zera::Tag::Bool:
+            require_no_flags();
+            if (aux > 1) throw z::DeserializationError("invalid ZERA boolean");
+            out.boolean(aux == 1);
+            break;
+        case z::zera::Tag::I64:
+        {
+            require_no_flags();
+            const uint64_t bits = static_cast<uint64_t>(a) |
+                                  (static_cast<uint64_t>(b) << 32);
+            out.int64(static_cast<int64_t>(bits));
+            break;
+        }
+        case z::zera::Tag::U64:
+        {
+            require_no_flags();
+            const uint64_t value = static_cast<uint64_t>(a) |
+                                   (static_cast<uint64_t>(b) << 32);
+            out.uint64(value);
+            break;
+        }
+        case z::zera::Tag::F64:
+        {
+            require_no_flags();
+            const uint64_t bits = static_cast<uint64_t>(a) |
+                                  (static_cast<uint64_t>(b) << 32);
+            out.double_(std::bit_cast<double>(bits));
+            break;
+        }
+        case z::zera::Tag::String:
+            out.string(zera_string_view(context, ref));
+            break;
+        case z::zera::Tag::Array:
+        {
+            require_no_flags();
+            zera_require_span(
+                context.envelope, a, 4, "ZERA array payload is out of bounds");
+            const uint32_t count = z::zera::read_u32_le(context.envelope.data() + a);
+            const size_t values_offset = static_cast<size_t>(a) + 4;
+            if (static_cast<size_t>(count) >
+                (context.envelope.size() - values_offset) / 16) {
+                throw z::DeserializationError("ZERA array values are out of bounds");
+            }
+            out.begin_array(count);
+            for (uint32_t i = 0; i < count; i++) {
+                zera_replay_value(
+                    context,
+                    static_cast<uint32_t>(values_offset + 16 * static_cast<size_t>(i)),
+                    out, depth + 1);
+            }
+            out.end_array();
+            break;
+        }
+        case z::zera::Tag::Object:
+        {
+            require_no_flags();
+            zera_require_span(
+                context.envelope, a, 4, "ZERA object payload is out of bounds");
+            const uint32_t count = z::zera::read_u32_le(context.envelope.data() + a);
+            size_t cursor = static_cast<size_t>(a) + 4;
+            std::unordered_set<std::string_view> keys;
+            out.begin_map(count);
+            for (uint32_t i = 0; i < count; i++) {
+                zera_require_span(
+                    context.envelope, cursor, 4, "ZERA object entry is truncated");
+                const uint8_t* entry = context.envelope.data() + cursor;
+                const uint16_t key_length = z::zera::read_u16_le(entry);
+                const uint16_t reserved = z::zera::read_u16_le(entry + 2);
+                if (reserved != 0) {
+                    throw z::DeserializationError("ZERA object reserved field is nonzero");
+                }
+                cursor += 4;
+                zera_require_span(
+                    context.envelope, cursor, static_cast<size_t>(key_length) + 16,
+                    "ZERA object key/value is truncated");
+                std::string_view key(
+                    reinterpret_cast<const char*>(context.envelope.data() + cursor),
+                    key_length);
+                if (!keys.insert(key).second) {
+                    throw z::DeserializationError("duplicate ZERA object key");
+                }
+                out.key(key);
+                cursor += key_length;
+                zera_replay_value(
+                    context, static_cast<uint32_t>(cursor), out, depth + 1);
+                cursor += 16;
+            }
+            out.end_map();
+            break;
+        }
+        case z::zera::Tag::TypedArray:
+        {
+            require_no_flags();
+            if (aux == static_cast<uint16_t>(z::zera::DType::U8)) {
+                zera_require_span(
+                    context.arena, a, b, "ZERA blob arena span is out of bounds");
+                zera_require_span(
+                    context.envelope, c, 12, "ZERA blob shape is out of bounds");
+                const uint8_t* shape = context.envelope.data() + c;
+                if (z::zera::read_u32_le(shape) != 1 ||
+                    z::zera::read_u64_le(shape + 4) != b) {
+                    throw z::DeserializationError("invalid ZERA blob shape");
+                }
+                auto bytes = std::span<const std::byte>(
+                    reinterpret_cast<const std::byte*>(context.arena.data() + a), b);
+                out.binary(bytes);
+                break;
+            }
+
+            // Other dtypes are rank-1 numeric arrays, as written under
+            // pg_zerialize.array_encoding = typed.
+            const TypedArrayFormat* fmt = nullptr;
+            for (const TypedArrayFormat& candidate : typed_array_formats) {
+                if (static_cast<uint16_t>(candidate.zera_dtype) == aux) {
+                    fmt = &candidate;
+                    break;
+                }
+            }
+            if (fmt == nullptr) {
+                throw z::DeserializationError(
+                    "unsupported ZERA typed array dtype");
+            }
+            zera_require_span(
+                context.arena, a, b, "ZERA typed array arena span is out of bounds");
+            zera_require_span(
+                context.envelope, c, 12, "ZERA typed array shape is out of bounds");
+            const uint8_t* shape = context.envelope.data() + c;
+            if (z::zera::read_u32_le(shape) != 1 || b % fmt->width != 0 ||
+                z::zera::read_u64_le(shape + 4) != b / fmt->width) {
+                throw z::DeserializationError("invalid ZERA typed array shape");
+            }
+            write_typed_array(out, *fmt, context.arena.data() + a, b / fmt->width);
+            break;
+        }
+        default:
+            throw z::DeserializationError("unknown ZERA value tag");
+    }
+
+    context.active_refs.erase(ref_offset);
+    return ref_offset + 16;
+}
+
+/* Validates the v1 header and padding, returning the decode context. */
+static ZeraDecodeContext zera_open_document(
+    std::span<const uint8_t> data, uint32_t* root_ofs)
+{
+    if (data.size() < z::zera::HeaderSize) {
+        throw z::DeserializationError("truncated ZERA header");
+    }
+    const z::zera::HeaderView header = z::zera::parse_header(data);
+    if (header.magic != z::zera::Magic) {
+        throw z::DeserializationError("invalid ZERA magic");
+    }
+    if (header.version != z::zera::Version) {
+        throw z::DeserializationError("unsupported ZERA version");
+    }
+    if (header.flags != 1) {
+        throw z::DeserializationError("invalid ZERA header flags");
+    }
+    if (header.env_size < 16 ||
+        header.env_size > data.size() - z::zera::HeaderSize) {
+        throw z::DeserializationError("invalid ZERA envelope size");
+    }
+    if (header.root_ofs > header.env_size - 16) {
+        throw z::DeserializationError("ZERA root ValueRef is out of bounds");
+    }
+    const size_t envelope_end =
+        z::zera::HeaderSize + static_cast<size_t>(header.env_size);
+    if (header.arena_ofs < envelope_end || header.arena_ofs > data.size() ||
+        header.arena_ofs % z::zera::ArenaBaseAlign != 0) {
+        throw z::DeserializationError("invalid ZERA arena offset");
+    }
+    for (size_t i = envelope_end; i < header.arena_ofs; i++) {
+        if (data[i] != 0) {
+            throw z::DeserializationError("nonzero ZERA envelope padding");
+        }
+    }
+
+    *root_ofs = header.root_ofs;
+    return ZeraDecodeContext{
+        data.subspan(z::zera::HeaderSize, header.env_size),
+        data.subspan(header.arena_ofs),
+        {}};
+}
+
+/*
+ * Path extraction reads one value without decoding the rest of a document.
+ * Each step matches a map key, or inside an array a zero-based index where
+ * negative values count from the end, following jsonb's #> operator. Only
+ * the containers along the path are walked; siblings are skipped with
+ * bounds-checked header reads.
+ */
+struct ExtractedScalar {
+    enum class Kind { Null, Bool, Int, UInt, NegUInt, Float, Decimal, String, Container };
+    Kind kind = Kind::Null;
+    const char* type_name = "null";
+    bool boolean = false;
+    int64_t int_value = 0;
+    /* UInt holds the value; NegUInt holds CBOR's n for the integer -1 - n. */
+    uint64_t uint_value = 0;
+    double float_value = 0.0;
+    /* Decimal keeps its plain numeric text here. */
+    std::string_view string_value;
+};
+
+static void extracted_decimal(const DecimalValue& decimal, const char* type_name,
+                              ExtractedScalar* out)
+{
+    std::string text;
+    decimal_format_fixed(decimal, &text);
+    out->kind = ExtractedScalar::Kind::Decimal;
+    out->type_name = type_name;
+    out->string_value = std::string_view(pnstrdup(text.data(), text.size()), text.size());
+}
+
+/* A native timestamp, network address, or interval, by its text form. */
+static void extracted_native_text(std::string_view text, const char* type_name,
+                                  ExtractedScalar* out)
+{
+    out->kind = ExtractedScalar::Kind::String;
+    out->type_name = type_name;
+    out->string_value = std::string_view(pnstrdup(text.data(), text.size()), text.size());
+}
+
+/* Reads a native type ext value at pos as its text; false for other values. */
+static bool msgpack_ext_native(std::span<const uint8_t> data, size_t pos, ExtractedScalar* out)
+{
+    const uint8_t marker = data[pos++];
+    uint8_t type;
+    size_t len;
+    if (!msgpack_marker_is_ext(marker) || !msgpack_read_ext(data, &pos, marker, &type, &len) ||
+        !msgpack_ext_is_native(type)) {
+        return false;
+    }
+    const uint8_t* payload = data.data() + pos;
+    if (type == kMsgpackTimestampExt) {
+        char out_text[MAXDATELEN + 1];
+        extracted_native_text(timestamp_iso_text(msgpack_read_timestamp(payload, len), out_text),
+                              "timestamp", out);
+    } else if (type == kMsgpackNetworkExt) {
+        char out_text[kNetworkTextCapacity];
+        extracted_native_text(
+            network_format_text(msgpack_read_network(payload, len), false, out_text), "inet", out);
+    } else {
+        char out_text[MAXDATELEN + 1];
+        extracted_native_text(interval_format_text(msgpack_read_interval(payload, len), out_text),
+                              "interval", out);
+    }
+    return true;
+}
+
+using ExtractScalarFn = bool (*)(std::span<const uint8_t> data,
+                                 std::span<const std::string_view> path,
+                                 ExtractedScalar* out, Jsonb** container);
+
+static bool path_step_index(std::string_view step, uint64_t count, uint64_t* index)
+{
+    int64_t value;
+    const char* end = step.data() + step.size();
+    auto parsed = std::from_chars(step.data(), end, value);
+    if (parsed.ec != std::errc() || parsed.ptr != end) {
+        return false;
+    }
+    if (value < 0) {
+        const uint64_t back = static_cast<uint64_t>(-(value + 1)) + 1;
+        if (back > count) return false;
+        *index = count - back;
+        return true;
+    }
+    if (static_cast<uint64_t>(value) >= count) return false;
+    *index = static_cast<uint64_t>(value);
+    return true;
+}
+
+/*
+ * Iterative bounded skip over one MessagePack value. Unlike
+ * msgpack_validate_value it keeps no per-map key set.
+ */
+static size_t msgpack_skip_value(std::span<const uint8_t> data, size_t pos)
+{
+    uint64_t pending = 1;
+    while (pending > 0) {
+        pending--;
+        msgpack_require_bytes(data, pos, 1);
+        const uint8_t marker = data[pos++];
+
+        if (marker <= 0x7f || marker >= 0xe0 || marker == 0xc0 ||
+            marker == 0xc2 || marker == 0xc3) {
+            continue;
+        }
+        if ((marker & 0xe0) == 0xa0) {
+            const size_t length = marker & 0x1f;
+            msgpack_require_bytes(data, pos, length);
+            pos += length;
+            continue;
+        }
+        if ((marker & 0xf0) == 0x90) {
+            pending += marker & 0x0f;
+            continue;
+        }
+        if ((marker & 0xf0) == 0x80) {
+            pending += 2 * static_cast<uint64_t>(marker & 0x0f);
+            continue;
+        }
+
+        size_t payload_size = 0;
+        switch (marker) {
+            case 0xc4:
+            case 0xd9:
+                msgpack_require_bytes(data, pos, 1);
+                payload_size = data[pos++];
+                break;
+            case 0xc5:
+            case 0xda:
+                payload_size = msgpack_read_u16(data, pos);
+                pos += 2;
+                break;
+            case 0xc6:
+            case 0xdb:
+                payload_size = msgpack_read_u32(data, pos);
+                pos += 4;
+                break;
+            case 0xca:
+            case 0xce:
+            case 0xd2:
+                payload_size = 4;
+                break;
+            case 0xcb:
+            case 0xcf:
+            case 0xd3:
+                payload_size = 8;
+                break;
+            case 0xcc:
+            case 0xd0:
+                payload_size = 1;
+                break;
+            case 0xcd:
+            case 0xd1:
+                payload_size = 2;
+                break;
+            case 0xdc:
+                pending += msgpack_read_u16(data, pos);
+                pos += 2;
+                break;
+            case 0xdd:
+                pending += msgpack_read_u32(data, pos);
+                pos += 4;
+                break;
+            case 0xde:
+                pending += 2 * static_cast<uint64_t>(msgpack_read_u16(data, pos));
+                pos += 2;
+                break;
+            case 0xdf:
+                pending += 2 * static_cast<uint64_t>(msgpack_read_u32(data, pos));
+                pos += 4;
+                break;
+            case 0xc7:
+            case 0xc8:
+            case 0xc9:
+            case 0xd4:
+            case 0xd5:
+            case 0xd6:
+            case 0xd7:
+            case 0xd8:
+            {
+                uint8_t type;
+                msgpack_read_ext(data, &pos, marker, &type, &payload_size);
+                break;
+            }
+            default:
+                throw z::DeserializationError("unsupported or reserved MessagePack marker");
+        }
+        msgpack_require_bytes(data, pos, payload_size);
+        pos += payload_size;
+    }
+    return pos;
+}
+
+/* Reads an array or map header at *pos; returns false for scalars. */
+static bool msgpack_read_container(
+    std::span<const uint8_t> data, size_t* pos, uint64_t* count, bool* is_map)
+{
+    msgpack_require_bytes(data, *pos, 1);
+    const uint8_t marker = data[*pos];
+    if ((marker & 0xf0) == 0x90 || (marker & 0xf0) == 0x80) {
+        *count = marker & 0x0f;
+        *is_map = (marker & 0xf0) == 0x80;
+        *pos += 1;
+        return true;
+    }
+    if (marker == 0xdc || marker == 0xde) {
+        *count = msgpack_read_u16(data, *pos + 1);
+        *is_map = marker == 0xde;
+        *pos += 3;
+        return true;
+    }
+    if (marker == 0xdd || marker == 0xdf) {
+        *count = msgpack_read_u32(data, *pos + 1);
+        *is_map = marker == 0xdf;
+        *pos += 5;
+        return true;
+    }
+    return false;
+}
+
+static bool msgpack_locate_path(
+    std::span<const uint8_t> data, std::span<const std::string_view> path,
+    size_t* value_pos)
+{
+    size_t pos = 0;
+    for (std::string_view step : path) {
+        size_t cursor = pos;
+        uint64_t count;
+        bool is_map;
+        if (!msgpack_read_container(data, &cursor, &count, &is_map)) {
+            return false;
+        }
+
+        bool found = false;
+        if (is_map) {
+            for (uint64_t i = 0; i < count; i++) {
+                msgpack_require_bytes(data, cursor, 1);
+                const uint8_t marker = data[cursor];
+                if (!msgpack_marker_is_string(marker)) {
+                    throw z::DeserializationError("MessagePack map key is not a string");
+                }
+                std::string_view key;
+                cursor = msgpack_replay_string(data, cursor + 1, marker, &key);
+                if (key == step) {
+                    found = true;
+                    break;
+                }
+                cursor = msgpack_skip_value(data, cursor);
+            }
+        } else {
+            uint64_t index;
+            if (path_step_index(step, count, &index)) {
+                for (uint64_t i = 0; i < index; i++) {
+                    cursor = msgpack_skip_value(data, cursor);
+                }
+                found = true;
+            }
+        }
+        if (!found) return false;
+        pos = cursor;
+    }
+    *value_pos = pos;
+    return true;
+}
+
+static bool msgpack_extract_slice(
+    std::span<const uint8_t> data, std::span<const std::string_view> path,
+    size_t* start, size_t* end)
+{
+    if (!msgpack_locate_path(data, path, start)) return false;
+    *end = msgpack_validate_value(data, *start);
+    return true;
+}
+
+static bool msgpack_extract_scalar(
+    std::span<const uint8_t> data, std::span<const std::string_view> path,
+    ExtractedScalar* out, Jsonb** container)
+{
+    size_t start;
+    size_t end;
+    if (!msgpack_extract_slice(data, path, &start, &end)) return false;
+
+    std::span<const uint8_t> value_bytes = data.subspan(start, end - start);
+    if (msgpack_ext_native(value_bytes, 0, out)) {
+        return true;
+    }
+    z::MsgPackDeserializer value(value_bytes);
+    DecimalValue decimal;
+    using Kind = ExtractedScalar::Kind;
+    if (value.isNull()) {
+        out->kind = Kind::Null;
+    } else if (value.isBool()) {
+        out->kind = Kind::Bool;
+        out->type_name = "boolean";
+        out->boolean = value.asBool();
+    } else if (value.isUInt()) {
+        out->kind = Kind::UInt;
+        out->type_name = "integer";
+        out->uint_value = value.asUInt64();
+    } else if (value.isInt()) {
+        out->kind = Kind::Int;
+        out->type_name = "integer";
+        out->int_value = value.asInt64();
+    } else if (value.isFloat()) {
+        out->kind = Kind::Float;
+        out->type_name = "float";
+        out->float_value = value.asDouble();
+    } else if (value.isString()) {
+        out->kind = Kind::String;
+        out->type_name = "string";
+        out->string_value = value.asStringView();
+        check_decoded_string(out->string_value);
+    } else if (msgpack_ext_decimal(value_bytes, 0, &decimal)) {
+        extracted_decimal(decimal, "decimal", out);
+    } else {
+        out->kind = Kind::Container;
+        out->type_name = value.isArray() || msgpack_marker_is_ext(value_bytes[0]) ? "array" :
+                         value.isMap() ? "map" : "binary";
+        if (container != nullptr) {
+            JsonbDecodeWriter writer;
+            msgpack_replay_value(value_bytes, 0, writer);
+            *container = writer.finish();
+        }
+    }
+    return true;
+}
+
+/*
+ * Bounded skip over one CBOR value; semantic tags other than typed arrays,
+ * bignums, decimal fractions, and epoch times are rejected as in decoding.
+ */
+static size_t cbor_skip_value(std::span<const uint8_t> data, size_t pos)
+{
+    check_stack_depth();
+    CborHead head = cbor_read_head(data, pos);
+
+    switch (head.major) {
+        case 0:
+        case 1:
+            if (head.indefinite) {
+                throw z::DeserializationError("indefinite CBOR integer");
+            }
+            return head.next;
+        case 2:
+        case 3:
+            if (!head.indefinite) {
+                cbor_require_bytes(data, head.next, head.value);
+                return head.next + static_cast<size_t>(head.value);
+            }
+            pos = head.next;
+            for (;;) {
+                cbor_require_bytes(data, pos, 1);
+                if (data[pos] == 0xff) {
+                    return pos + 1;
+                }
+                CborHead chunk = cbor_read_head(data, pos);
+                if (chunk.major != head.major || chunk.indefinite) {
+                    throw z::DeserializationError("invalid CBOR string chunk");
+                }
+                cbor_require_bytes(data, chunk.next, chunk.value);
+                pos = chunk.next + static_cast<size_t>(chunk.value);
+            }
+        case 4:
+        case 5:
+        {
+            const uint64_t per_entry = head.major == 5 ? 2 : 1;
+            pos = head.next;
+            if (head.indefinite) {
+                for (;;) {
+                    cbor_require_bytes(data, pos, 1);
+                    if (data[pos] == 0xff) {
+                        return pos + 1;
+                    }
+                    for (uint64_t i = 0; i < per_entry; i++) {
+                        pos = cbor_skip_value(data, pos);
+                    }
+                }
+            }
+            for (uint64_t i = 0; i < head.value; i++) {
+                for (uint64_t j = 0; j < per_entry; j++) {
+                    pos = cbor_skip_value(data, pos);
+                }
+            }
+            return pos;
+        }
+        case 6:
+            if (cbor_tag_is_decimal(head)) {
+                const CborHead content = cbor_read_head(data, head.next);
+                if (head.value == 4 && (content.major != 4 || content.indefinite ||
+                                        content.value != 2)) {
+                    throw z::DeserializationError(
+                        "CBOR decimal fraction is not a two-element array");
+                }
+                if (head.value != 4 && content.major != 2) {
+                    throw z::DeserializationError("CBOR value is not a byte string");
+                }
+                return cbor_skip_value(data, head.next);
+            }
+            if (cbor_tag_is_epoch_time(head)) {
+                Timestamp ts;
+                return cbor_read_epoch_time(data, head, &ts);
+            }
+            if (!cbor_tag_is_typed_array(head)) {
+                throw z::DeserializationError("CBOR semantic tags are not supported");
+            }
+            if (cbor_read_head(data, head.next).major != 2) {
+                throw z::DeserializationError("CBOR value is not a byte string");
+            }
+            return cbor_skip_value(data, head.next);
+        case 7:
+            if (head.indefinite) {
+                throw z::DeserializationError("unexpected CBOR break marker");
+            }
+            return head.next;
+        default:
+            pg_unreachable();
+    }
+}
+
+static bool cbor_locate_path(
+    std::span<const uint8_t> data, std::span<const std::string_view> path,
+    size_t* value_pos)
+{
+    size_t pos = 0;
+    std::string key;
+    for (std::string_view step : path) {
+        CborHead head = cbor_read_head(data, pos);
+        size_t cursor = head.next;
+        bool found = false;
+
+        if (head.major == 5) {
+            for (uint64_t i = 0; head.indefinite || i < head.value; i++) {
+                if (head.indefinite) {
+                    cbor_require_bytes(data, cursor, 1);
+                    if (data[cursor] == 0xff) break;
+                }
+                cursor = cbor_parse_text(data, cursor, &key);
+                if (key == step) {
+                    found = true;
+                    break;
+                }
+                cursor = cbor_skip_value(data, cursor);
+            }
+        } else if (head.major == 4) {
+            uint64_t count = head.value;
+            if (head.indefinite) {
+                /* Indefinite arrays are counted only when indexed from the end. */
+                count = std::numeric_limits<uint64_t>::max();
+                if (!step.empty() && step[0] == '-') {
+                    count = 0;
+                    for (size_t probe = cursor;; count++) {
+                        cbor_require_bytes(data, probe, 1);
+                        if (data[probe] == 0xff) break;
+                        probe = cbor_skip_value(data, probe);
+                    }
+                }
+            }
+            uint64_t index;
+            if (path_step_index(step, count, &index)) {
+                found = true;
+                for (uint64_t i = 0; i < index; i++) {
+                    if (head.indefinite) {
+                        cbor_require_bytes(data, cursor, 1);
+                        if (data[cursor] == 0xff) {
+                            found = false;
+                            break;
+                        }
+                    }
+                    cursor = cbor_skip_value(data, cursor);
+                }
+                if (found && head.indefinite) {
+                    cbor_require_bytes(data, cursor, 1);
+                    found = data[cursor] != 0xff;
+                }
+            }
+        }
+        if (!found) return false;
+        pos = cursor;
+    }
+    *value_pos = pos;
+    return true;
+}
+
+static bool cbor_extract_slice(
+    std::span<const uint8_t> data, std::span<const std::string_view> path,
+    size_t* start, size_t* end)
+{
+    if (!cbor_locate_path(data, path, start)) return false;
+    *end = cbor_skip_value(data, *start);
+    return true;
+}
+
+static bool cbor_extract_scalar(
+    std::span<const uint8_t> data, std::span<const std::string_view> path,
+    ExtractedScalar* out, Jsonb** container)
+{
+    size_t pos;
+    if (!cbor_locate_path(data, path, &pos)) return false;
+
+    CborHead head = cbor_read_head(data, pos);
+    using Kind = ExtractedScalar::Kind;
+    switch (head.major) {
+        case 0:
+            out->kind = Kind::UInt;
+            out->type_name = "integer";
+            out->uint_value = head.value;
+            return true;
+        case 1:
+            out->type_name = "integer";
+            if (head.value <= static_cast<uint64_t>(INT64_MAX)) {
+                out->kind = Kind::Int;
+                out->int_value = -1 - static_cast<int64_t>(head.value);
+            } else {
+                out->kind = Kind::NegUInt;
+                out->uint_value = head.value;
+            }
+            return true;
+        case 3:
+        {
+            std::string text_value;
+            cbor_parse_text(data, pos, &text_value);
+            check_decoded_string(text_value);
+            char* copy = static_cast<char*>(palloc(text_value.size() + 1));
+            memcpy(copy, text_value.data(), text_value.size());
+            copy[text_value.size()] = '\0';
+            out->kind = Kind::String;
+            out->type_name = "string";
+            out->string_value = std::string_view(copy, text_value.size());
+            return true;
+        }
+        case 2:
+        case 4:
+        case 5:
+        case 6:
+            if (cbor_tag_is_decimal(head)) {
+                DecimalValue decimal;
+                cbor_read_decimal(data, head, &decimal);
+                extracted_decimal(decimal, head.value == 4 ? "decimal" : "integer", out);
+                return true;
+            }
+            if (cbor_tag_is_epoch_time(head)) {
+                Timestamp ts;
+                char out_text[MAXDATELEN + 1];
+                cbor_read_epoch_time(data, head, &ts);
+                extracted_native_text(timestamp_iso_text(ts, out_text), "timestamp", out);
+                return true;
+            }
+            if (head.major == 6 && !cbor_tag_is_typed_array(head)) {
+                throw z::DeserializationError("CBOR semantic tags are not supported");
+            }
+            out->kind = Kind::Container;
+            out->type_name = head.major == 2 ? "byte string" :
+                             head.major == 5 ? "map" : "array";
+            if (container != nullptr) {
+                JsonbDecodeWriter writer;
+                cbor_replay_value(data, pos, writer);
+                *container = writer.finish();
+            }
+            return true;
+        case 7:
+            if (head.indefinite) {
+                throw z::DeserializationError("unexpected CBOR break marker");
+            }
+            if (head.additional == 20 || head.additional == 21) {
+                out->kind = Kind::Bool;
+                out->type_name = "boolean";
+                out->boolean = head.additional == 21;
+                return true;
+            }
+            if (head.additional == 22) {
+                out->kind = Kind::Null;
+                return true;
+            }
+            out->kind = Kind::Float;
+            out->type_name = "float";
+            if (head.additional == 25) {
+                out->float_value = cbor_decode_half(static_cast<uint16_t>(head.value));
+            } else if (head.additional == 26) {
+                out->float_value = std::bit_cast<float>(static_cast<uint32_t>(head.value));
+            } else if (head.additional == 27) {
+                out->float_value = std::bit_cast<double>(head.value);
+            } else {
+                throw z::DeserializationError("unsupported CBOR simple value");
+            }
+            return true;
+        default:
+            pg_unreachable();
+    }
+}
+
+/*
+ * ZERA objects are scanned entry by entry in the envelope and arrays are
+ * indexed directly, so lookups cost O(keys) along the path and copy nothing.
+ */
+static bool zera_locate_path(
+    const ZeraDecodeContext& context, uint32_t root_ofs,
+    std::span<const std::string_view> path, uint32_t* value_ofs)
+{
+    uint32_t ref_offset = root_ofs;
+    for (std::string_view step : path) {
+        zera_require_span(
+            context.envelope, ref_offset, 16, "ZERA ValueRef is out of bounds");
+        const uint8_t* ref = context.envelope.data() + ref_offset;
+        const auto tag = static_cast<z::zera::Tag>(ref[0]);
+        if (tag != z::zera::Tag::Array && tag != z::zera::Tag::Object) {
+            return false;
+        }
+        if (ref[1] != 0) {
+            throw z::DeserializationError("non-string ZERA value has flags");
+        }
+        const uint32_t a = z::zera::read_u32_le(ref + 4);
+        zera_require_span(
+            context.envelope, a, 4, "ZERA container payload is out of bounds");
+        const uint32_t count = z::zera::read_u32_le(context.envelope.data() + a);
+
+        bool found = false;
+        if (tag == z::zera::Tag::Array) {
+            const size_t values_offset = static_cast<size_t>(a) + 4;
+            if (static_cast<size_t>(count) >
+                (context.envelope.size() - values_offset) / 16) {
+                throw z::DeserializationError("ZERA array values are out of bounds");
+            }
+            uint64_t index;
+            if (path_step_index(step, count, &index)) {
+                ref_offset = static_cast<uint32_t>(values_offset + 16 * index);
+                found = true;
+            }
+        } else {
+            size_t cursor = static_cast<size_t>(a) + 4;
+            for (uint32_t i = 0; i < count; i++) {
+                zera_require_span(
+                    context.envelope, cursor, 4, "ZERA object entry is truncated");
+                const uint8_t* entry = context.envelope.data() + cursor;
+                const uint16_t key_length = z::zera::read_u16_le(entry);
+                cursor += 4;
+                zera_require_span(
+                    context.envelope, cursor, static_cast<size_t>(key_length) + 16,
+                    "ZERA object key/value is truncated");
+                std::string_view key(
+                    reinterpret_cast<const char*>(context.envelope.data() + cursor),
+                    key_length);
+                cursor += key_length;
+                if (key == step) {
+                    ref_offset = static_cast<uint32_t>(cursor);
+                    found = true;
+                    break;
+                }
+                cursor += 16;
+            }
+        }
+        if (!found) return false;
+    }
+    *value_ofs = ref_offset;
+    return true;
+}
+
+static bool zera_extract_scalar(
+    std::span<const uint8_t> data, std::span<const std::string_view> path,
+    ExtractedScalar* out, Jsonb** container)
+{
+    uint32_t root_ofs;
+    ZeraDecodeContext context = zera_open_document(data, &root_ofs);
+    uint32_t ref_offset;
+    if (!zera_locate_path(context, root_ofs, path, &ref_offset)) return false;
+
+    zera_require_span(
+        context.envelope, ref_offset, 16, "ZERA ValueRef is out of bounds");
+    const uint8_t* ref = context.envelope.data() + ref_offset;
+    const auto tag = static_cast<z::zera::Tag>(ref[0]);
+    const uint16_t aux = z::zera::read_u16_le(ref + 2);
+    const uint64_t bits = static_cast<uint64_t>(z::zera::read_u32_le(ref + 4)) |
+                          (static_cast<uint64_t>(z::zera::read_u32_le(ref + 8)) << 32);
+    if (tag != z::zera::Tag::String && ref[1] != 0) {
+        throw z::DeserializationError("non-string ZERA value has flags");
+    }
+
+    using Kind = ExtractedScalar::Kind;
+    switch (tag) {
+        case z::zera::Tag::Null:
+            out->kind = Kind::Null;
+            break;
+        case z::zera::Tag::Bool:
+            if (aux > 1) throw z::DeserializationError("invalid ZERA boolean");
+            out->kind = Kind::Bool;
+            out->type_name = "boolean";
+            out->boolean = aux == 1;
+            break;
+        case z::zera::Tag::I64:
+            out->kind = Kind::Int;
+            out->type_name = "integer";
+            out->int_value = static_cast<int64_t>(bits);
+            break;
+        case z::zera::Tag::U64:
+            out->kind = Kind::UInt;
+            out->type_name = "integer";
+            out->uint_value = bits;
+            break;
+        case z::zera::Tag::F64:
+            out->kind = Kind::Float;
+            out->type_name = "float";
+            out->float_value = std::bit_cast<double>(bits);
+            break;
+        case z::zera::Tag::String:
+            out->kind = Kind::String;
+            out->type_name = "string";
+            out->string_value = zera_string_view(context, ref);
+            check_decoded_string(out->string_value);
+            break;
+        case z::zera::Tag::Array:
+        case z::zera::Tag::Object:
+        case z::zera::Tag::TypedArray:
+            out->kind = Kind::Container;
+            out->type_name = tag == z::zera::Tag::Array ? "array" :
+                             tag == z::zera::Tag::Object ? "object" : "typed array";
+            if (container != nullptr) {
+                JsonbDecodeWriter writer;
+                zera_replay_value(context, ref_offset, writer, 0);
+                *container = writer.finish();
+            }
+            break;
+        default:
+            throw z::DeserializationError("unknown ZERA value tag");
+    }
+    return true;
+}
+
+/* encoding is a NumericEncoding, normally pg_zerialize.numeric_encoding. */
+static z::dyn::Value jsonb_to_dynamic(Jsonb* jb, int encoding)
+{
+    JsonbIterator* it = JsonbIteratorInit(&jb->root);
+    JsonbValue v;
+
+    if (JB_ROOT_IS_SCALAR(jb)) {
+        JsonbIteratorToken tok = JsonbIteratorNext(&it, &v, false); /* begin pseudo-array */
+        if (tok != WJB_BEGIN_ARRAY) {
+            ereport(ERROR,
+                    (errcode(ERRCODE_DATA_CORRUPTED),
+                     errmsg("invalid scalar jsonb root")));
+        }
+        tok = JsonbIteratorNext(&it, &v, false); /* scalar elem */
+        z::dyn::Value out = jsonb_token_to_dynamic(&it, tok, &v, encoding);
+        (void) JsonbIteratorNext(&it, &v, false); /* end pseudo-array */
+        return out;
+    }
+
+    JsonbIteratorToken tok = JsonbIteratorNext(&it, &v, false);
+    return jsonb_token_to_dynamic(&it, tok, &v, encoding);
+}
+
+static inline std::string text_to_owned_string(Datum value)
+{
+    text* txt = DatumGetTextPP(value);
+    return std::string(VARDATA_ANY(txt), static_cast<size_t>(VARSIZE_ANY_EXHDR(txt)));
+}
+
+static inline void format_uuid(Datum value, char (&out)[36])
+{
+    static constexpr char hex[] = "0123456789abcdef";
+    const pg_uuid_t* uuid = DatumGetUUIDP(value);
+    size_t pos = 0;
+    for (size_t i = 0; i < UUID_LEN; ++i) {
+        if (i == 4 || i == 6 || i == 8 || i == 10) {
+            out[pos++] = '-';
+        }
+        out[pos++] = hex[uuid->data[i] >> 4];
+        out[pos++] = hex[uuid->data[i] & 0x0f];
+    }
+}
+
+static inline std::string uuid_to_owned_string(Datum value)
+{
+    char out[36];
+    format_uuid(value, out);
+    return std::string(out, sizeof(out));
+}
+
+static inline std::string_view name_text_view(Datum value)
+{
+    const char* name = NameStr(*DatumGetName(value));
+    return std::string_view(name, strnlen(name, NAMEDATALEN));
+}
+
+static inline std::string char_to_owned_string(Datum value)
+{
+    char ch = DatumGetChar(value);
+    return ch == '\0' ? std::string() : std::string(1, ch);
+}
+
+static inline std::string_view enum_label_view(Datum value)
+{
+    Oid enum_value = DatumGetObjectId(value);
+    auto cached = enum_label_cache.find(enum_value);
+    if (cached != enum_label_cache.end()) {
+        return cached->second.label;
+    }
+
+    HeapTuple tuple = SearchSysCache1(ENUMOID, ObjectIdGetDatum(enum_value));
+    if (!HeapTupleIsValid(tuple)) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                 errmsg("invalid internal value for enum: %u", enum_value)));
+    }
+    Form_pg_enum entry = (Form_pg_enum) GETSTRUCT(tuple);
+    auto [it, inserted] = enum_label_cache.emplace(
+        enum_value,
+        CachedEnumLabel{NameStr(entry->enumlabel),
+                        GetSysCacheHashValue1(ENUMOID, ObjectIdGetDatum(enum_value))});
+    (void)inserted;
+    ReleaseSysCache(tuple);
+    return it->second.label;
+}
+
+static inline std::string_view network_text_view(
+    Datum value, bool is_cidr, char (&out)[kNetworkTextCapacity])
+{
+    return network_format_text(network_from_datum(value), is_cidr, out);
+}
+
+static inline std::string_view interval_text_view(
+    Datum value, char (&out)[MAXDATELEN + 1])
+{
+    return interval_format_text(*DatumGetIntervalP(value), out);
+}
+
+/*
+ * Writers for the types pg_zerialize.type_encoding switches between text
+ * (or, for timestamps, PostgreSQL-epoch microseconds) and native forms.
+ */
+template <typename WriterT>
+static inline void write_uuid(WriterT& writer, Datum value)
+{
+    if (type_encoding == TYPE_ENCODING_NATIVE) {
+        writer.binary(std::as_bytes(std::span<const uint8_t>(DatumGetUUIDP(value)->data, UUID_LEN)));
+        return;
+    }
+    char out[36];
+    format_uuid(value, out);
+    writer.string(std::string_view(out, sizeof(out)));
+}
+
+template <typename WriterT>
+static inline void write_timestamp(WriterT& writer, Timestamp ts)
+{
+    if (type_encoding == TYPE_ENCODING_NATIVE) {
+        write_native_timestamp(writer, ts);
+        return;
+    }
+    writer.int64(static_cast<int64_t>(ts));
+}
+
+template <typename WriterT>
+static inline void write_network(WriterT& writer, Datum value, bool is_cidr)
+{
+    if (type_encoding == TYPE_ENCODING_NATIVE) {
+        write_native_network(writer, network_from_datum(value), is_cidr);
+        return;
+    }
+    char out[kNetworkTextCapacity];
+    writer.string(network_text_view(value, is_cidr, out));
+}
+
+template <typename WriterT>
+static inline void write_interval(WriterT& writer, Datum value)
+{
+    if (type_encoding == TYPE_ENCODING_NATIVE) {
+        write_native_interval(writer, *DatumGetIntervalP(value));
+        return;
+    }
+    char out[MAXDATELEN + 1];
+    writer.string(interval_text_view(value, out));
+}
+
+static z::dyn::Value uuid_to_dynamic(Datum value)
+{
+    if (type_encoding == TYPE_ENCODING_NATIVE) {
+        return z::dyn::Value::blob(
+            std::as_bytes(std::span<const uint8_t>(DatumGetUUIDP(value)->data, UUID_LEN)));
+    }
+    return z::dyn::Value(uuid_to_owned_string(value));
+}
+
+static z::dyn::Value timestamp_to_dynamic(Timestamp ts)
+{
+    if (type_encoding == TYPE_ENCODING_NATIVE) {
+        return native_timestamp_to_dynamic(ts);
+    }
+    return z::dyn::Value(static_cast<int64_t>(ts));
+}
+
+static z::dyn::Value network_to_dynamic(Datum value, bool is_cidr)
+{
+    if (type_encoding == TYPE_ENCODING_NATIVE) {
+        return native_network_to_dynamic(network_from_datum(value));
+    }
+    char out[kNetworkTextCapacity];
+    return z::dyn::Value(std::string(network_text_view(value, is_cidr, out)));
+}
+
+static z::dyn::Value interval_to_dynamic(Datum value)
+{
+    if (type_encoding == TYPE_ENCODING_NATIVE) {
+        return native_interval_to_dynamic(*DatumGetIntervalP(value));
+    }
+    char out[MAXDATELEN + 1];
+    return z::dyn::Value(std::string(interval_text_view(value, out)));
+}
+
+template <typename WriterT>
+static inline void write_output_string(WriterT& writer, Oid typoutput, Datum value)
+{
+    char* str = OidOutputFunctionCall(typoutput, value);
+    writer.string(std::string_view(str));
+    pfree(str);
+}
+
+/*
+ * Convert a PostgreSQL Datum to a zerialize dyn::Value
+ */
+static z::dyn::Value datum_to_dynamic(Datum value, Oid typid, bool isnull)
+{
+    if (isnull) {
+        return z::dyn::Value();  // null value
+    }
+
+    // Check if this is an array type
+    if (OidIsValid(get_element_type(typid))) {
+        return array_to_dynamic(value, typid);
+    }
+
+    switch (typid) {
+        case INT2OID:
+            return z::dyn::Value(static_cast<int64_t>(DatumGetInt16(value)));
+
+        case INT4OID:
+            return z::dyn::Value(static_cast<int64_t>(DatumGetInt32(value)));
+
+        case INT8OID:
+            return z::dyn::Value(static_cast<int64_t>(DatumGetInt64(value)));
+
+        case FLOAT4OID:
+            return z::dyn::Value(static_cast<double>(DatumGetFloat4(value)));
+
+        case FLOAT8OID:
+            return z::dyn::Value(DatumGetFloat8(value));
+
+        case BOOLOID:
+            return z::dyn::Value(DatumGetBool(value));
+
+        case TEXTOID:
+        case VARCHAROID:
+        case BPCHAROID:
+        case JSONOID:
+        {
+            return z::dyn::Value(text_to_owned_string(value));
+        }
+
+        case UUIDOID:
+            return uuid_to_dynamic(value);
+        case NAMEOID:
+            return z::dyn::Value(std::string(name_text_view(value)));
+        case CHAROID:
+            return z::dyn::Value(char_to_owned_string(value));
+
+        case NUMERICOID:
+            return numeric_to_dynamic_fast(value, numeric_encoding);
+        case DATEOID:
+            return z::dyn::Value(static_cast<int64_t>(DatumGetDateADT(value)));
+        case TIMESTAMPOID:
+            return timestamp_to_dynamic(DatumGetTimestamp(value));
+        case TIMESTAMPTZOID:
+            return timestamp_to_dynamic(DatumGetTimestampTz(value));
+        case INETOID:
+        case CIDROID:
+            return network_to_dynamic(value, typid == CIDROID);
+        case INTERVALOID:
+            return interval_to_dynamic(value);
+        case JSONBOID:
+            return z::dyn::Value::blob(datum_jsonb_span(value));
+        case BYTEAOID:
+            return z::dyn::Value::blob(datum_bytea_span(value));
+
+        default:
+        {
+            if (typid == RECORDOID || get_typtype(typid) == TYPTYPE_COMPOSITE) {
+                return record_to_dynamic_map(DatumGetHeapTupleHeader(value));
+            }
+
+            // For unsupported types, convert to text representation
+            Oid typoutput;
+            bool typIsVarlena;
+            char* str;
+
+            getTypeOutputInfo(typid, &typoutput, &typIsVarlena);
+            str = OidOutputFunctionCall(typoutput, value);
+            std::string strval(str);
+            pfree(str);
+            return z::dyn::Value(strval);
+        }
+    }
+}
+
+static z::dyn::Value fallback_to_text_output(Datum value, Oid typoutput)
+{
+    char* str = OidOutputFunctionCall(typoutput, value);
+    std::string strval(str);
+    pfree(str);
+    return z::dyn::Value(strval);
+}
+
+static inline std::span<const std::byte> datum_bytea_span(Datum value)
+{
+    bytea* b = DatumGetByteaPP(value);
+    const std::byte* ptr = reinterpret_cast<const std::byte*>(VARDATA_ANY(b));
+    size_t len = static_cast<size_t>(VARSIZE_ANY_EXHDR(b));
+    return std::span<const std::byte>(ptr, len);
+}
+
+static inline std::span<const std::byte> datum_jsonb_span(Datum value)
+{
+    Jsonb* jb = DatumGetJsonbP(value);
+    const std::byte* ptr = reinterpret_cast<const std::byte*>(VARDATA_ANY(jb));
+    size_t len = static_cast<size_t>(VARSIZE_ANY_EXHDR(jb));
+    return std::span<const std::byte>(ptr, len);
+}
+
+static z::dyn::Value datum_to_dynamic_cached(Datum value, bool isnull, const CachedColumn& col)
+{
+    if (isnull) {
+        return z::dyn::Value();
+    }
+
+    switch (col.kind) {
+        case ConverterKind::Int2:
+            return z::dyn::Value(static_cast<int64_t>(DatumGetInt16(value)));
+        case ConverterKind::Int4:
+            return z::dyn::Value(static_cast<int64_t>(DatumGetInt32(value)));
+        case ConverterKind::Int8:
+            return z::dyn::Value(static_cast<int64_t>(DatumGetInt64(value)));
+        case ConverterKind::Float4:
+            return z::dyn::Value(static_cast<double>(DatumGetFloat4(value)));
+        case ConverterKind::Float8:
+            return z::dyn::Value(DatumGetFloat8(value));
+        case ConverterKind::Bool:
+            return z::dyn::Value(DatumGetBool(value));
+        case ConverterKind::Text:
+        case ConverterKind::JsonText:
+        {
+            return z::dyn::Value(text_to_owned_string(value));
+        }
+        case ConverterKind::Uuid:
+            return uuid_to_dynamic(value);
+        case ConverterKind::NameText:
+            return z::dyn::Value(std::string(name_text_view(value)));
+        case ConverterKind::CharText:
+            return z::dyn::Value(char_to_owned_string(value));
+        case ConverterKind::EnumText:
+            return z::dyn::Value(std::string(enum_label_view(value)));
+        case ConverterKind::InetText:
+        case ConverterKind::CidrText:
+            return network_to_dynamic(value, col.kind == ConverterKind::CidrText);
+        case ConverterKind::IntervalText:
+            return interval_to_dynamic(value);
+        case ConverterKind::Numeric:
+            return numeric_to_dynamic_fast(value, numeric_encoding);
+        case ConverterKind::Date:
+            return z::dyn::Value(static_cast<int64_t>(DatumGetDateADT(value)));
+        case ConverterKind::Timestamp:
+            return timestamp_to_dynamic(DatumGetTimestamp(value));
+        case ConverterKind::Timestamptz:
+            return timestamp_to_dynamic(DatumGetTimestampTz(value));
+        case ConverterKind::Jsonb:
+            return z::dyn::Value::blob(datum_jsonb_span(value));
+        case ConverterKind::Bytea:
+            return z::dyn::Value::blob(datum_bytea_span(value));
+        case ConverterKind::Array:
+            return array_to_dynamic(value, col.typid);
+        case ConverterKind::Composite:
+            return record_to_dynamic_map(DatumGetHeapTupleHeader(value));
+        case ConverterKind::Fallback:
+            return fallback_to_text_output(value, col.typoutput);
+    }
+
+    return z::dyn::Value();
+}
+
+static bool is_msgpack_fast_kind(ConverterKind kind)
+{
+    switch (kind) {
+        case ConverterKind::Int2:
+        case ConverterKind::Int4:
+        case ConverterKind::Int8:
+        case ConverterKind::Float4:
+        case ConverterKind::Float8:
+        case ConverterKind::Bool:
+        case ConverterKind::Text:
+        case ConverterKind::JsonText:
+        case ConverterKind::Uuid:
+        case ConverterKind::NameText:
+        case ConverterKind::CharText:
+        case ConverterKind::EnumText:
+        case ConverterKind::InetText:
+        case ConverterKind::CidrText:
+        case ConverterKind::IntervalText:
+        case ConverterKind::Numeric:
+        case ConverterKind::Date:
+        case ConverterKind::Timestamp:
+        case ConverterKind::Timestamptz:
+        case ConverterKind::Jsonb:
+        case ConverterKind::Bytea:
+        case ConverterKind::Fallback:
+        case ConverterKind::Composite:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool is_msgpack_fast_array_element_kind(ConverterKind kind)
+{
+    switch (kind) {
+        case ConverterKind::Int2:
+        case ConverterKind::Int4:
+        case ConverterKind::Int8:
+        case ConverterKind::Float4:
+        case ConverterKind::Float8:
+        case ConverterKind::Bool:
+        case ConverterKind::Text:
+        case ConverterKind::JsonText:
+        case ConverterKind::Uuid:
+        case ConverterKind::NameText:
+        case ConverterKind::CharText:
+        case ConverterKind::EnumText:
+        case ConverterKind::InetText:
+        case ConverterKind::CidrText:
+        case ConverterKind::IntervalText:
+        case ConverterKind::Numeric:
+        case ConverterKind::Date:
+        case ConverterKind::Timestamp:
+        case ConverterKind::Timestamptz:
+        case ConverterKind::Jsonb:
+        case ConverterKind::Bytea:
+        case ConverterKind::Fallback:
+        case ConverterKind::Composite:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool is_msgpack_fast_column(const CachedColumn& col)
+{
+    if (col.kind != ConverterKind::Array) {
+        return is_msgpack_fast_kind(col.kind);
+    }
+    return OidIsValid(col.array_element_typid) &&
+           is_msgpack_fast_array_element_kind(col.array_element_kind);
+}
+
+static std::vector<uint8_t> encode_msgpack_string_key(std::string_view key)
+{
+    std::vector<uint8_t> out;
+    const size_t n = key.size();
+
+    if (n <= 31) {
+        out.reserve(1 + n);
+        out.push_back(static_cast<uint8_t>(0xA0u | static_cast<uint8_t>(n)));
+    } else if (n <= 0xFFu) {
+        out.reserve(2 + n);
+        out.push_back(0xD9u);
+        out.push_back(static_cast<uint8_t>(n));
+    } else if (n <= 0xFFFFu) {
+        out.reserve(3 + n);
+        out.push_back(0xDAu);
+        out.push_back(static_cast<uint8_t>((n >> 8) & 0xFFu));
+        out.push_back(static_cast<uint8_t>(n & 0xFFu));
+    } else if (n <= 0xFFFFFFFFu) {
+        out.reserve(5 + n);
+        out.push_back(0xDBu);
+        out.push_back(static_cast<uint8_t>((n >> 24) & 0xFFu));
+        out.push_back(static_cast<uint8_t>((n >> 16) & 0xFFu));
+        out.push_back(static_cast<uint8_t>((n >> 8) & 0xFFu));
+        out.push_back(static_cast<uint8_t>(n & 0xFFu));
+    } else {
+        ereport(ERROR,
+                (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+                 errmsg("map key length exceeds MessagePack limits")));
+    }
+
+    out.insert(out.end(), key.begin(), key.end());
+    return out;
+}
+
+static std::vector<uint8_t> encode_msgpack_map_header(size_t n)
+{
+    std::vector<uint8_t> out;
+    if (n <= 15u) {
+        out.reserve(1);
+        out.push_back(static_cast<uint8_t>(0x80u | static_cast<uint8_t>(n)));
+        return out;
+    }
+
+    if (n <= 0xFFFFu) {
+        out.reserve(3);
+        out.push_back(0xDEu);
+        out.push_back(static_cast<uint8_t>((n >> 8) & 0xFFu));
+        out.push_back(static_cast<uint8_t>(n & 0xFFu));
+        return out;
+    }
+
+    if (n <= 0xFFFFFFFFu) {
+        out.reserve(5);
+        out.push_back(0xDFu);
+        out.push_back(static_cast<uint8_t>((n >> 24) & 0xFFu));
+        out.push_back(static_cast<uint8_t>((n >> 16) & 0xFFu));
+        out.push_back(static_cast<uint8_t>((n >> 8) & 0xFFu));
+        out.push_back(static_cast<uint8_t>(n & 0xFFu));
+        return out;
+    }
+
+    ereport(ERROR,
+            (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+             errmsg("map field count exceeds MessagePack limits")));
+}
+
+static std::vector<uint8_t> encode_zera_key(std::string_view key)
+{
+    if (key.size() > 0xFFFFu) {
+        ereport(ERROR,
+                (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+                 errmsg("map key length exceeds ZERA key limit")));
+    }
+
+    std::vector<uint8_t> out;
+    out.reserve(4 + key.size());
+    const uint16_t len = static_cast<uint16_t>(key.size());
+    out.push_back(static_cast<uint8_t>(len & 0xFFu));
+    out.push_back(static_cast<uint8_t>((len >> 8) & 0xFFu));
+    out.push_back(0);
+    out.push_back(0);
+    out.insert(out.end(), key.begin(), key.end());
+    return out;
+}
+
+/*
+ * CBOR text string header and bytes for a map key, as the encoder would
+ * write them. Names that are not valid UTF-8 stay unencoded, so the encoder
+ * still rejects them.
+ */
+static std::vector<uint8_t> encode_cbor_key(std::string_view key)
+{
+    std::vector<uint8_t> out;
+    if (pg_encoding_verifymbstr(PG_UTF8, key.data(), static_cast<int>(key.size())) !=
+        static_cast<int>(key.size())) {
+        return out;
+    }
+
+    const uint64_t len = key.size();
+    out.reserve(9 + key.size());
+    if (len <= 23) {
+        out.push_back(static_cast<uint8_t>(0x60 | len));
+    } else {
+        const int width = len <= UINT8_MAX ? 1 : len <= UINT16_MAX ? 2 : len <= UINT32_MAX ? 4 : 8;
+        out.push_back(static_cast<uint8_t>(width == 1 ? 0x78 : width == 2 ? 0x79 : width == 4 ? 0x7a : 0x7b));
+        for (int shift = (width - 1) * 8; shift >= 0; shift -= 8) {
+            out.push_back(static_cast<uint8_t>(len >> shift));
+        }
+    }
+    out.insert(out.end(), key.begin(), key.end());
+    return out;
+}
+
+static inline void msgpack_write_text(z::MsgPackSerializer& writer, Datum value)
+{
+    text* txt = DatumGetTextPP(value);
+    const char* ptr = VARDATA_ANY(txt);
+    int len = VARSIZE_ANY_EXHDR(txt);
+    writer.string(std::string_view(ptr, static_cast<size_t>(len)));
+}
+
+static inline void msgpack_write_record_map(
+    z::MsgPackSerializer& writer,
+    HeapTupleHeader rec,
+    const CachedSchema& schema,
+    TupleDeformScratch* scratch);
+
+static inline void msgpack_array_elem_unsupported(
+    z::MsgPackSerializer& writer,
+    Datum value,
+    bool isnull)
+{
+    (void)writer;
+    (void)value;
+    (void)isnull;
+    ereport(ERROR,
+            (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+             errmsg("unsupported array element type for fast MessagePack path")));
+}
+
+/*
+ * Write a nested record, resolving its schema through the column's memo.
+ */
+static inline void msgpack_write_composite(
+    z::MsgPackSerializer& writer, const CachedColumn& col, Datum value)
+{
+    HeapTupleHeader rec = DatumGetHeapTupleHeader(value);
+    const CachedSchema& schema = memo_cached_schema(
+        col.nested_memo, HeapTupleHeaderGetTypeId(rec), HeapTupleHeaderGetTypMod(rec));
+    TupleDeformScratch scratch;
+    msgpack_write_record_map(writer, rec, schema, &scratch);
+}
+
+static inline void msgpack_array_elem_composite(
+    z::MsgPackSerializer& writer, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    HeapTupleHeader rec = DatumGetHeapTupleHeader(value);
+    const CachedSchema& schema = get_cached_schema(
+        HeapTupleHeaderGetTypeId(rec), HeapTupleHeaderGetTypMod(rec));
+    TupleDeformScratch scratch;
+    msgpack_write_record_map(writer, rec, schema, &scratch);
+}
+
+static inline void msgpack_array_elem_int2(z::MsgPackSerializer& writer, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    writer.int64(static_cast<int64_t>(DatumGetInt16(value)));
+}
+
+static inline void msgpack_array_elem_int4(z::MsgPackSerializer& writer, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    writer.int64(static_cast<int64_t>(DatumGetInt32(value)));
+}
+
+static inline void msgpack_array_elem_int8(z::MsgPackSerializer& writer, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    writer.int64(static_cast<int64_t>(DatumGetInt64(value)));
+}
+
+static inline void msgpack_array_elem_float4(z::MsgPackSerializer& writer, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    writer.double_(static_cast<double>(DatumGetFloat4(value)));
+}
+
+static inline void msgpack_array_elem_float8(z::MsgPackSerializer& writer, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    writer.double_(DatumGetFloat8(value));
+}
+
+static inline void msgpack_array_elem_bool(z::MsgPackSerializer& writer, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    writer.boolean(DatumGetBool(value));
+}
+
+static inline void msgpack_array_elem_text(z::MsgPackSerializer& writer, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    msgpack_write_text(writer, value);
+}
+
+static inline void msgpack_array_elem_uuid(z::MsgPackSerializer& writer, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    write_uuid(writer, value);
+}
+
+static inline void msgpack_array_elem_name(z::MsgPackSerializer& writer, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    writer.string(name_text_view(value));
+}
+
+static inline void msgpack_array_elem_char(z::MsgPackSerializer& writer, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    char ch = DatumGetChar(value);
+    writer.string(std::string_view(&ch, ch == '\0' ? 0 : 1));
+}
+
+static inline void msgpack_array_elem_enum(z::MsgPackSerializer& writer, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    writer.string(enum_label_view(value));
+}
+
+static inline void msgpack_array_elem_inet(z::MsgPackSerializer& writer, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    write_network(writer, value, false);
+}
+
+static inline void msgpack_array_elem_cidr(z::MsgPackSerializer& writer, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    write_network(writer, value, true);
+}
+
+static inline void msgpack_array_elem_interval(z::MsgPackSerializer& writer, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    write_interval(writer, value);
+}
+
+static inline void msgpack_array_elem_numeric(z::MsgPackSerializer& writer, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    numeric_write_fast(writer, value);
+}
+
+static inline void msgpack_array_elem_date(z::MsgPackSerializer& writer, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    writer.int64(static_cast<int64_t>(DatumGetDateADT(value)));
+}
+
+static inline void msgpack_array_elem_timestamp(z::MsgPackSerializer& writer, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    write_timestamp(writer, DatumGetTimestamp(value));
+}
+
+static inline void msgpack_array_elem_timestamptz(z::MsgPackSerializer& writer, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    write_timestamp(writer, DatumGetTimestampTz(value));
+}
+
+static inline void msgpack_array_elem_jsonb(z::MsgPackSerializer& writer, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    writer.binary(datum_jsonb_span(value));
+}
+
+static inline void msgpack_array_elem_bytea(z::MsgPackSerializer& writer, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    writer.binary(datum_bytea_span(value));
+}
+
+static MsgpackArrayElemWriterFn select_msgpack_array_elem_writer(ConverterKind kind)
+{
+    switch (kind) {
+        case ConverterKind::Int2: return &msgpack_array_elem_int2;
+        case ConverterKind::Int4: return &msgpack_array_elem_int4;
+        case ConverterKind::Int8: return &msgpack_array_elem_int8;
+        case ConverterKind::Float4: return &msgpack_array_elem_float4;
+        case ConverterKind::Float8: return &msgpack_array_elem_float8;
+        case ConverterKind::Bool: return &msgpack_array_elem_bool;
+        case ConverterKind::Text:
+        case ConverterKind::JsonText:
+            return &msgpack_array_elem_text;
+        case ConverterKind::Uuid: return &msgpack_array_elem_uuid;
+        case ConverterKind::NameText: return &msgpack_array_elem_name;
+        case ConverterKind::CharText: return &msgpack_array_elem_char;
+        case ConverterKind::EnumText: return &msgpack_array_elem_enum;
+        case ConverterKind::InetText: return &msgpack_array_elem_inet;
+        case ConverterKind::CidrText: return &msgpack_array_elem_cidr;
+        case ConverterKind::IntervalText: return &msgpack_array_elem_interval;
+        case ConverterKind::Numeric: return &msgpack_array_elem_numeric;
+        case ConverterKind::Date: return &msgpack_array_elem_date;
+        case ConverterKind::Timestamp: return &msgpack_array_elem_timestamp;
+        case ConverterKind::Timestamptz: return &msgpack_array_elem_timestamptz;
+        case ConverterKind::Jsonb: return &msgpack_array_elem_jsonb;
+        case ConverterKind::Bytea: return &msgpack_array_elem_bytea;
+        case ConverterKind::Composite: return &msgpack_array_elem_composite;
+        default: return &msgpack_array_elem_unsupported;
+    }
+}
+
+static inline void msgpack_write_array_no_nulls(
+    z::MsgPackSerializer& writer,
+    ConverterKind elem_kind,
+    Datum* elements,
+    int nitems)
+{
+    switch (elem_kind) {
+        case ConverterKind::Int2:
+            for (int i = 0; i < nitems; i++) {
+                writer.int64(static_cast<int64_t>(DatumGetInt16(elements[i])));
+            }
+            return;
+        case ConverterKind::Int4:
+            for (int i = 0; i < nitems; i++) {
+                writer.int64(static_cast<int64_t>(DatumGetInt32(elements[i])));
+            }
+            return;
+        case ConverterKind::Int8:
+            for (int i = 0; i < nitems; i++) {
+                writer.int64(static_cast<int64_t>(DatumGetInt64(elements[i])));
+            }
+            return;
+        case ConverterKind::Float4:
+            for (int i = 0; i < nitems; i++) {
+                writer.double_(static_cast<double>(DatumGetFloat4(elements[i])));
+            }
+            return;
+        case ConverterKind::Float8:
+            for (int i = 0; i < nitems; i++) {
+                writer.double_(DatumGetFloat8(elements[i]));
+            }
+            return;
+        case ConverterKind::Bool:
+            for (int i = 0; i < nitems; i++) {
+                writer.boolean(DatumGetBool(elements[i]));
+            }
+            return;
+        case ConverterKind::Text:
+        case ConverterKind::JsonText:
+            for (int i = 0; i < nitems; i++) {
+                msgpack_write_text(writer, elements[i]);
+            }
+            return;
+        case ConverterKind::Uuid:
+            for (int i = 0; i < nitems; i++) {
+                write_uuid(writer, elements[i]);
+            }
+            return;
+        case ConverterKind::NameText:
+            for (int i = 0; i < nitems; i++) {
+                writer.string(name_text_view(elements[i]));
+            }
+            return;
+        case ConverterKind::CharText:
+            for (int i = 0; i < nitems; i++) {
+                char ch = DatumGetChar(elements[i]);
+                writer.string(std::string_view(&ch, ch == '\0' ? 0 : 1));
+            }
+            return;
+        case ConverterKind::EnumText:
+            for (int i = 0; i < nitems; i++) {
+                writer.string(enum_label_view(elements[i]));
+            }
+            return;
+        case ConverterKind::InetText:
+            for (int i = 0; i < nitems; i++) {
+                write_network(writer, elements[i], false);
+            }
+            return;
+        case ConverterKind::CidrText:
+            for (int i = 0; i < nitems; i++) {
+                write_network(writer, elements[i], true);
+            }
+            return;
+        case ConverterKind::IntervalText:
+            for (int i = 0; i < nitems; i++) {
+                write_interval(writer, elements[i]);
+            }
+            return;
+        case ConverterKind::Numeric:
+            for (int i = 0; i < nitems; i++) {
+                numeric_write_fast(writer, elements[i]);
+            }
+            return;
+        case ConverterKind::Date:
+            for (int i = 0; i < nitems; i++) {
+                writer.int64(static_cast<int64_t>(DatumGetDateADT(elements[i])));
+            }
+            return;
+        case ConverterKind::Timestamp:
+            for (int i = 0; i < nitems; i++) {
+                write_timestamp(writer, DatumGetTimestamp(elements[i]));
+            }
+            return;
+        case ConverterKind::Timestamptz:
+            for (int i = 0; i < nitems; i++) {
+                write_timestamp(writer, DatumGetTimestampTz(elements[i]));
+            }
+            return;
+        case ConverterKind::Jsonb:
+            for (int i = 0; i < nitems; i++) {
+                writer.binary(datum_jsonb_span(elements[i]));
+            }
+            return;
+        case ConverterKind::Bytea:
+            for (int i = 0; i < nitems; i++) {
+                writer.binary(datum_bytea_span(elements[i]));
+            }
+            return;
+        case ConverterKind::Composite:
+            for (int i = 0; i < nitems; i++) {
+                msgpack_array_elem_composite(writer, elements[i], false);
+            }
+            return;
+        default:
+            ereport(ERROR,
+                    (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                     errmsg("unsupported array element type for fast MessagePack path")));
+    }
+}
+
+static inline bool msgpack_write_fixed_array_no_nulls(
+    z::MsgPackSerializer& writer,
+    ConverterKind elem_kind,
+    ArrayType* arr,
+    int nitems)
+{
+    switch (elem_kind) {
+        case ConverterKind::Int2:
+        case ConverterKind::Int4:
+        case ConverterKind::Int8:
+        case ConverterKind::Float4:
+        case ConverterKind::Float8:
+        case ConverterKind::Bool:
+        case ConverterKind::Uuid:
+        case ConverterKind::NameText:
+        case ConverterKind::CharText:
+        case ConverterKind::EnumText:
+        case ConverterKind::IntervalText:
+        case ConverterKind::Date:
+        case ConverterKind::Timestamp:
+        case ConverterKind::Timestamptz:
+            break;
+        default:
+            return false;
+    }
+
+    const char* data = ARR_DATA_PTR(arr);
+    writer.begin_array(static_cast<size_t>(nitems));
+    switch (elem_kind) {
+        case ConverterKind::Int2:
+        {
+            const int16* values = reinterpret_cast<const int16*>(data);
+            msgpack_write_int64_sequence(writer, values, nitems);
+            break;
+        }
+        case ConverterKind::Int4:
+        {
+            const int32* values = reinterpret_cast<const int32*>(data);
+            msgpack_write_int64_sequence(writer, values, nitems);
+            break;
+        }
+        case ConverterKind::Int8:
+        {
+            const int64* values = reinterpret_cast<const int64*>(data);
+            msgpack_write_int64_sequence(writer, values, nitems);
+            break;
+        }
+        case ConverterKind::Float4:
+        {
+            const float4* values = reinterpret_cast<const float4*>(data);
+            msgpack_write_double_sequence(writer, values, nitems);
+            break;
+        }
+        case ConverterKind::Float8:
+        {
+            const float8* values = reinterpret_cast<const float8*>(data);
+            msgpack_write_double_sequence(writer, values, nitems);
+            break;
+        }
+        case ConverterKind::Bool:
+        {
+            const bool* values = reinterpret_cast<const bool*>(data);
+            msgpack_write_bool_sequence(writer, values, nitems);
+            break;
+        }
+        case ConverterKind::Uuid:
+        {
+            const pg_uuid_t* values = reinterpret_cast<const pg_uuid_t*>(data);
+            for (int i = 0; i < nitems; i++) {
+                write_uuid(writer, PointerGetDatum(&values[i]));
+            }
+            break;
+        }
+        case ConverterKind::NameText:
+        {
+            const NameData* values = reinterpret_cast<const NameData*>(data);
+            for (int i = 0; i < nitems; i++) writer.string(name_text_view(NameGetDatum(&values[i])));
+            break;
+        }
+        case ConverterKind::CharText:
+            for (int i = 0; i < nitems; i++) {
+                char ch = data[i];
+                writer.string(std::string_view(&ch, ch == '\0' ? 0 : 1));
+            }
+            break;
+        case ConverterKind::EnumText:
+        {
+            const Oid* values = reinterpret_cast<const Oid*>(data);
+            for (int i = 0; i < nitems; i++) writer.string(enum_label_view(ObjectIdGetDatum(values[i])));
+            break;
+        }
+        case ConverterKind::IntervalText:
+        {
+            const Interval* values = reinterpret_cast<const Interval*>(data);
+            for (int i = 0; i < nitems; i++) write_interval(writer, PointerGetDatum(&values[i]));
+            break;
+        }
+        case ConverterKind::Date:
+        {
+            const DateADT* values = reinterpret_cast<const DateADT*>(data);
+            msgpack_write_int64_sequence(writer, values, nitems);
+            break;
+        }
+        case ConverterKind::Timestamp:
+        case ConverterKind::Timestamptz:
+        {
+            const int64* values = reinterpret_cast<const int64*>(data);
+            if (type_encoding == TYPE_ENCODING_NATIVE) {
+                for (int i = 0; i < nitems; i++) write_native_timestamp(writer, values[i]);
+                break;
+            }
+            msgpack_write_int64_sequence(writer, values, nitems);
+            break;
+        }
+        default:
+            pg_unreachable();
+    }
+    writer.end_array();
+    return true;
+}
+
+static inline void msgpack_write_array(
+    z::MsgPackSerializer& writer,
+    const CachedColumn& col,
+    Datum value)
+{
+    ArrayType* arr = DatumGetArrayTypeP(value);
+    int ndim = ARR_NDIM(arr);
+
+    if (ndim == 0) {
+        writer.begin_array(0);
+        writer.end_array();
+        return;
+    }
+
+    if (ndim != 1) {
+        z::dyn::serialize(array_to_dynamic(value, col.typid), writer);
+        return;
+    }
+
+    if (write_typed_array_if_enabled(writer, col.array_element_kind, arr)) {
+        return;
+    }
+
+    int nitems = ArrayGetNItems(ndim, ARR_DIMS(arr));
+    if (!ARR_HASNULL(arr) &&
+        msgpack_write_fixed_array_no_nulls(writer, col.array_element_kind, arr, nitems)) {
+        return;
+    }
+
+    Datum* elements;
+    bool* nulls;
+    deconstruct_array(arr,
+                      col.array_element_typid,
+                      col.array_typlen,
+                      col.array_typbyval,
+                      col.array_typalign,
+                      &elements,
+                      &nulls,
+                      &nitems);
+
+    MsgpackArrayElemWriterFn elem_writer = col.msgpack_array_elem_writer;
+    if (elem_writer == nullptr) {
+        elem_writer = &msgpack_array_elem_unsupported;
+    }
+
+    writer.begin_array(static_cast<size_t>(nitems));
+    if (col.array_element_kind == ConverterKind::Fallback) {
+        for (int i = 0; i < nitems; i++) {
+            if (nulls[i]) {
+                writer.null();
+            } else {
+                write_output_string(writer, col.array_element_typoutput, elements[i]);
+            }
+        }
+    } else if (col.array_element_kind == ConverterKind::Composite) {
+        for (int i = 0; i < nitems; i++) {
+            if (nulls[i]) {
+                writer.null();
+            } else {
+                msgpack_write_composite(writer, col, elements[i]);
+            }
+        }
+    } else if (!ARR_HASNULL(arr)) {
+        msgpack_write_array_no_nulls(writer, col.array_element_kind, elements, nitems);
+    } else {
+        for (int i = 0; i < nitems; i++) {
+            elem_writer(writer, elements[i], nulls[i]);
+        }
+    }
+    writer.end_array();
+
+    pfree(elements);
+    pfree(nulls);
+}
+
+static inline void msgpack_scalar_unsupported(
+    z::MsgPackSerializer& writer,
+    const CachedColumn& col,
+    Datum value,
+    bool isnull)
+{
+    (void)writer;
+    (void)value;
+    (void)isnull;
+    ereport(ERROR,
+            (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+             errmsg("unsupported type for fast MessagePack path"),
+             errdetail("column type OID %u", col.typid)));
+}
+
+static inline void msgpack_scalar_composite(
+    z::MsgPackSerializer& writer, const CachedColumn& col, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    msgpack_write_composite(writer, col, value);
+}
+
+static inline void msgpack_scalar_fallback(
+    z::MsgPackSerializer& writer, const CachedColumn& col, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    char* str = OidOutputFunctionCall(col.typoutput, value);
+    writer.string(std::string_view(str));
+    pfree(str);
+}
+
+static inline void msgpack_scalar_int2(
+    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    writer.int64(static_cast<int64_t>(DatumGetInt16(value)));
+}
+
+static inline void msgpack_scalar_int4(
+    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    writer.int64(static_cast<int64_t>(DatumGetInt32(value)));
+}
+
+static inline void msgpack_scalar_int8(
+    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    writer.int64(static_cast<int64_t>(DatumGetInt64(value)));
+}
+
+static inline void msgpack_scalar_float4(
+    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    writer.double_(static_cast<double>(DatumGetFloat4(value)));
+}
+
+static inline void msgpack_scalar_float8(
+    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    writer.double_(DatumGetFloat8(value));
+}
+
+static inline void msgpack_scalar_bool(
+    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    writer.boolean(DatumGetBool(value));
+}
+
+static inline void msgpack_scalar_text(
+    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    msgpack_write_text(writer, value);
+}
+
+static inline void msgpack_scalar_numeric(
+    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    numeric_write_fast(writer, value);
+}
+
+static inline void msgpack_scalar_date(
+    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    writer.int64(static_cast<int64_t>(DatumGetDateADT(value)));
+}
+
+static inline void msgpack_scalar_timestamp(
+    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    write_timestamp(writer, DatumGetTimestamp(value));
+}
+
+static inline void msgpack_scalar_timestamptz(
+    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    write_timestamp(writer, DatumGetTimestampTz(value));
+}
+
+static inline void msgpack_scalar_jsonb(
+    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    writer.binary(datum_jsonb_span(value));
+}
+
+static inline void msgpack_scalar_bytea(
+    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    writer.binary(datum_bytea_span(value));
+}
+
+static inline void msgpack_scalar_array(
+    z::MsgPackSerializer& writer, const CachedColumn& col, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    msgpack_write_array(writer, col, value);
+}
+
+static inline void msgpack_scalar_uuid(
+    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    write_uuid(writer, value);
+}
+
+static inline void msgpack_scalar_name(
+    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    writer.string(name_text_view(value));
+}
+
+static inline void msgpack_scalar_char(
+    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    char ch = DatumGetChar(value);
+    writer.string(std::string_view(&ch, ch == '\0' ? 0 : 1));
+}
+
+static inline void msgpack_scalar_enum(
+    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    writer.string(enum_label_view(value));
+}
+
+static inline void msgpack_scalar_inet(
+    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    write_network(writer, value, false);
+}
+
+static inline void msgpack_scalar_cidr(
+    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    write_network(writer, value, true);
+}
+
+static inline void msgpack_scalar_interval(
+    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    write_interval(writer, value);
+}
+
+static MsgpackScalarWriterFn select_msgpack_scalar_writer(ConverterKind kind)
+{
+    switch (kind) {
+        case ConverterKind::Int2: return &msgpack_scalar_int2;
+        case ConverterKind::Int4: return &msgpack_scalar_int4;
+        case ConverterKind::Int8: return &msgpack_scalar_int8;
+        case ConverterKind::Float4: return &msgpack_scalar_float4;
+        case ConverterKind::Float8: return &msgpack_scalar_float8;
+        case ConverterKind::Bool: return &msgpack_scalar_bool;
+        case ConverterKind::Text:
+        case ConverterKind::JsonText:
+            return &msgpack_scalar_text;
+        case ConverterKind::Uuid: return &msgpack_scalar_uuid;
+        case ConverterKind::NameText: return &msgpack_scalar_name;
+        case ConverterKind::CharText: return &msgpack_scalar_char;
+        case ConverterKind::EnumText: return &msgpack_scalar_enum;
+        case ConverterKind::InetText: return &msgpack_scalar_inet;
+        case ConverterKind::CidrText: return &msgpack_scalar_cidr;
+        case ConverterKind::IntervalText: return &msgpack_scalar_interval;
+        case ConverterKind::Numeric: return &msgpack_scalar_numeric;
+        case ConverterKind::Date: return &msgpack_scalar_date;
+        case ConverterKind::Timestamp: return &msgpack_scalar_timestamp;
+        case ConverterKind::Timestamptz: return &msgpack_scalar_timestamptz;
+        case ConverterKind::Jsonb: return &msgpack_scalar_jsonb;
+        case ConverterKind::Bytea: return &msgpack_scalar_bytea;
+        case ConverterKind::Array: return &msgpack_scalar_array;
+        case ConverterKind::Fallback: return &msgpack_scalar_fallback;
+        case ConverterKind::Composite: return &msgpack_scalar_composite;
+    }
+    return &msgpack_scalar_unsupported;
+}
+
+static inline void msgpack_write_record_map(
+    z::MsgPackSerializer& writer,
+    HeapTupleHeader rec,
+    const CachedSchema& schema,
+    TupleDeformScratch* scratch)
+{
+    HeapTupleData tuple;
+    tuple.t_len = HeapTupleHeaderGetDatumLength(rec);
+    tuple.t_data = rec;
+
+    if (schema.columns.size() > 15) {
+        writer.begin_map_preencoded(schema.msgpack_map_header_ptr, schema.msgpack_map_header_len);
+    } else {
+        writer.begin_map(schema.columns.size());
+    }
+    if (!schema.use_deform_access) {
+        for (const CachedColumn& col : schema.columns) {
+            bool isnull;
+            Datum value = heap_getattr(&tuple, col.attnum, schema.tupdesc, &isnull);
+            writer.key_preencoded(col.msgpack_key_ptr, col.msgpack_key_len);
+            col.msgpack_scalar_writer(writer, col, value, isnull);
+        }
+    } else {
+        const size_t nattrs = static_cast<size_t>(schema.tupdesc->natts);
+        scratch->ensure(nattrs);
+        heap_deform_tuple(&tuple, schema.tupdesc, scratch->values, scratch->nulls);
+        for (const CachedColumn& col : schema.columns) {
+            const int idx = col.attnum - 1;
+            writer.key_preencoded(col.msgpack_key_ptr, col.msgpack_key_len);
+            col.msgpack_scalar_writer(writer, col, scratch->values[idx], scratch->nulls[idx]);
+        }
+    }
+    writer.end_map();
+}
+
+// Positional form of msgpack_write_record_map for compact batches.
+static inline void msgpack_write_record_tuple(
+    z::MsgPackSerializer& writer,
+    HeapTupleHeader rec,
+    const CachedSchema& schema,
+    TupleDeformScratch* scratch)
+{
+    HeapTupleData tuple;
+    tuple.t_len = HeapTupleHeaderGetDatumLength(rec);
+    tuple.t_data = rec;
+
+    writer.begin_array(schema.columns.size());
+    if (!schema.use_deform_access) {
+        for (const CachedColumn& col : schema.columns) {
+            bool isnull;
+            Datum value = heap_getattr(&tuple, col.attnum, schema.tupdesc, &isnull);
+            col.msgpack_scalar_writer(writer, col, value, isnull);
+        }
+    } else {
+        const size_t nattrs = static_cast<size_t>(schema.tupdesc->natts);
+        scratch->ensure(nattrs);
+        heap_deform_tuple(&tuple, schema.tupdesc, scratch->values, scratch->nulls);
+        for (const CachedColumn& col : schema.columns) {
+            const int idx = col.attnum - 1;
+            col.msgpack_scalar_writer(writer, col, scratch->values[idx], scratch->nulls[idx]);
+        }
+    }
+    writer.end_array();
+}
+
+static inline z::MsgPackRootSerializer& msgpack_reusable_root()
+{
+    static z::MsgPackRootSerializer rs;
+    return rs;
+}
+
+static inline bytea* msgpack_result_from_reusable_root(z::MsgPackRootSerializer& rs)
+{
+    size_t len = rs.sbuf.size;
+    bytea* result = (bytea*) palloc(len + VARHDRSZ);
+    SET_VARSIZE(result, len + VARHDRSZ);
+    if (len > 0) {
+        memcpy(VARDATA(result), rs.sbuf.data, len);
+    }
+    msgpack_sbuffer_clear(&rs.sbuf);
+    return result;
+}
+
+static void* msgpack_palloc_realloc(void* ptr, size_t size)
+{
+    const int flags = MCXT_ALLOC_HUGE | MCXT_ALLOC_NO_OOM;
+    return ptr == nullptr ? palloc_extended(size, flags) : repalloc_extended(ptr, size, flags);
+}
+
+/*
+ * Point a MessagePack root at a palloc'd buffer whose first VARHDRSZ bytes
+ * are kept for the bytea header, so the finished payload is returned in
+ * place. The reserve is rounded up to a power of two, which is the chunk
+ * size palloc would hand out anyway.
+ */
+static inline void msgpack_palloc_root_init(z::MsgPackRootSerializer& rs, size_t reserve)
+{
+    const size_t alloc = pg_nextpower2_size_t(Max(reserve + VARHDRSZ, (size_t) 64));
+    rs.realloc_fn = msgpack_palloc_realloc;
+    rs.sbuf.data = (char*) palloc(alloc);
+    rs.sbuf.alloc = alloc;
+    rs.sbuf.size = VARHDRSZ;
+}
+
+static inline bytea* msgpack_result_from_palloc_root(z::MsgPackRootSerializer& rs)
+{
+    if (rs.sbuf.size > MaxAllocSize) {
+        ereport(ERROR,
+                (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+                 errmsg("MessagePack result exceeds the maximum bytea size")));
+    }
+    bytea* result = (bytea*) rs.sbuf.data;
+    SET_VARSIZE(result, rs.sbuf.size);
+    rs.sbuf.data = nullptr;
+    rs.sbuf.size = 0;
+    rs.sbuf.alloc = 0;
+    return result;
+}
+
+/*
+ * Backend-local output buffers for the CBOR, ZERA, and FlexBuffers fast
+ * paths. They keep their capacity between calls and are reset before each
+ * use, so a document abandoned by an error leaves nothing behind.
+ */
+static inline std::vector<uint8_t>& cbor_reusable_storage()
+{
+    static std::vector<uint8_t> storage;
+    return storage;
+}
+
+static inline bytea* bytea_from_span(std::span<const uint8_t> data)
+{
+    const size_t len = data.size();
+    bytea* result = (bytea*) palloc(len + VARHDRSZ);
+    SET_VARSIZE(result, len + VARHDRSZ);
+    if (len > 0) {
+        memcpy(VARDATA(result), data.data(), len);
+    }
+    return result;
+}
+
+static inline bytea* cbor_result_from_root(z::cborjc::RootSerializer& rs)
+{
+    bytea* result = bytea_from_span(rs.bytes());
+    cbor_reusable_storage() = rs.release();
+    return result;
+}
+
+static inline z::zera::RootSerializer& zera_reusable_root()
+{
+    static z::zera::RootSerializer rs;
+    rs.reset();
+    return rs;
+}
+
+// ZERA lays out its header, envelope, and arena straight into the bytea.
+static inline bytea* zera_result_from_root(z::zera::RootSerializer& rs)
+{
+    const size_t len = rs.finished_size();
+    bytea* result = (bytea*) palloc(len + VARHDRSZ);
+    SET_VARSIZE(result, len + VARHDRSZ);
+    rs.finish_into(reinterpret_cast<uint8_t*>(VARDATA(result)));
+    return result;
+}
+
+static inline z::flex::RootSerializer& flex_reusable_root()
+{
+    static z::flex::RootSerializer rs;
+    rs.reset();
+    return rs;
+}
+
+static inline bytea* flex_result_from_root(z::flex::RootSerializer& rs)
+{
+    return bytea_from_span(rs.bytes());
+}
+
+/*
+ * Compressed batch frames. A 16-byte header carries the magic "\xc1PGZ",
+ * a format version, the codec, the protocol of the wrapped document, a zero
+ * byte, and the uncompressed length as a big-endian uint64. 0xc1 is never a
+ * MessagePack marker, and no CBOR or ZERA batch can start with it. A
+ * FlexBuffers map starts with its first key's raw bytes, so a key such as
+ * LATIN1 "\xc1PGZ..." would match the magic alone; input counts as a frame
+ * only when every header field is one a frame can carry. An lz4 payload is
+ * one raw block and a zstd payload is one frame; the header already records
+ * the length both need.
+ */
+static constexpr uint8_t kFrameMagic[4] = {0xc1, 'P', 'G', 'Z'};
+static constexpr uint8_t kFrameVersion = 1;
+static constexpr size_t kFrameHeaderSize = 16;
+
+enum class FrameCodec : uint8 { None = 0, Lz4 = 1, Zstd = 2 };
+
+template<typename Protocol>
+static constexpr uint8_t frame_protocol_of()
+{
+    if constexpr (std::is_same_v<Protocol, z::MsgPack>) {
+        return 1;
+    } else if constexpr (std::is_same_v<Protocol, z::CBOR>) {
+        return 2;
+    } else if constexpr (std::is_same_v<Protocol, z::Zera>) {
+        return 3;
+    } else {
+        return 4;
+    }
+}
+
+static const char* frame_protocol_name(uint8_t protocol)
+{
+    static const char* const names[] = {"MessagePack", "CBOR", "ZERA", "FlexBuffers"};
+    return names[protocol - 1];
+}
+
+[[noreturn]] static void frame_codec_unsupported(const char* name)
+{
+    ereport(ERROR,
+            (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+             errmsg("compression method %s not supported", name),
+             errdetail("This functionality requires the server to be built with %s support.",
+                       name)));
+    pg_unreachable();
+}
+
+/* Resolves a compression argument and checks its level before any encoding. */
+static FrameCodec frame_codec_from_args(text* method, int level)
+{
+    const char* name = text_to_cstring(method);
+    if (pg_strcasecmp(name, "none") == 0) {
+        return FrameCodec::None;
+    }
+    if (pg_strcasecmp(name, "lz4") == 0) {
+#ifdef USE_LZ4
+        // 0 is LZ4's fast mode; 1 and up select the high-compression levels.
+        if (level < 0 || level > LZ4HC_CLEVEL_MAX) {
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("lz4 compression level %d is out of range", level),
+                     errdetail("Levels run from 0 to %d.", LZ4HC_CLEVEL_MAX)));
+        }
+        return FrameCodec::Lz4;
+#else
+        frame_codec_unsupported("lz4");
+#endif
+    }
+    if (pg_strcasecmp(name, "zstd") == 0) {
+#ifdef USE_ZSTD
+        // 0 is zstd's own default level.
+        if (level < ZSTD_minCLevel() || level > ZSTD_maxCLevel()) {
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("zstd compression level %d is out of range", level),
+                     errdetail("Levels run from %d to %d.", ZSTD_minCLevel(), ZSTD_maxCLevel())));
+        }
+        return FrameCodec::Zstd;
+#else
+        frame_codec_unsupported("zstd");
+#endif
+    }
+    ereport(ERROR,
+            (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+             errmsg("unrecognized compression method \"%s\"", name),
+             errhint("Valid methods are \"lz4\", \"zstd\", and \"none\".")));
+    pg_unreachable();
+}
+
+/* Compresses a finished document into a new framed bytea. */
+static bytea* frame_compress(const bytea* document, uint8_t protocol, FrameCodec codec, int level)
+{
+    const char* src = VARDATA(document);
+    const size_t len = VARSIZE(document) - VARHDRSZ;
+    size_t bound = 0;
+#ifdef USE_LZ4
+    if (codec == FrameCodec::Lz4) {
+        bound = static_cast<size_t>(LZ4_compressBound(static_cast<int>(len)));
+    }
+#endif
+#ifdef USE_ZSTD
+    if (codec == FrameCodec::Zstd) {
+        bound = ZSTD_compressBound(len);
+    }
+#endif
+
+    bytea* result = (bytea*) palloc_extended(VARHDRSZ + kFrameHeaderSize + bound, MCXT_ALLOC_HUGE);
+    uint8_t* header = reinterpret_cast<uint8_t*>(VARDATA(result));
+    memcpy(header, kFrameMagic, sizeof(kFrameMagic));
+    header[4] = kFrameVersion;
+    header[5] = static_cast<uint8_t>(codec);
+    header[6] = protocol;
+    header[7] = 0;
+    store_be(header + 8, len, 8);
+    char* dst = reinterpret_cast<char*>(header + kFrameHeaderSize);
+
+    size_t written = 0;
+#ifdef USE_LZ4
+    if (codec == FrameCodec::Lz4) {
+        const int n = level == 0
+            ? LZ4_compress_default(src, dst, static_cast<int>(len), static_cast<int>(bound))
+            : LZ4_compress_HC(src, dst, static_cast<int>(len), static_cast<int>(bound), level);
+        if (n <= 0) {
+            elog(ERROR, "lz4 compression failed");
+        }
+        written = static_cast<size_t>(n);
+    }
+#endif
+#ifdef USE_ZSTD
+    if (codec == FrameCodec::Zstd) {
+        written = ZSTD_compress(dst, bound, src, len, level);
+        if (ZSTD_isError(written)) {
+            elog(ERROR, "zstd compression failed: %s", ZSTD_getErrorName(written));
+        }
+    }
+#endif
+
+    const size_t total = VARHDRSZ + kFrameHeaderSize + written;
+    if (total > MaxAllocSize) {
+        ereport(ERROR,
+                (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+                 errmsg("compressed result exceeds the maximum bytea size")));
+    }
+    SET_VARSIZE(result, total);
+    return result;
+}
+
+static inline bool frame_has_header(std::span<const uint8_t> data)
+{
+    if (data.size() < kFrameHeaderSize ||
+        memcmp(data.data(), kFrameMagic, sizeof(kFrameMagic)) != 0) {
+        return false;
+    }
+    const uint8_t* header = data.data();
+    const uint8_t codec = header[5];
+    const uint8_t protocol = header[6];
+    return header[4] == kFrameVersion &&
+           (codec == static_cast<uint8_t>(FrameCodec::Lz4) ||
+            codec == static_cast<uint8_t>(FrameCodec::Zstd)) &&
+           protocol >= 1 && protocol <= 4 && header[7] == 0 &&
+           load_be(header + 8, 8) <= MaxAllocSize - VARHDRSZ;
+}
+
+[[noreturn]] static void frame_corrupt(const char* detail)
+{
+    ereport(ERROR,
+            (errcode(ERRCODE_DATA_CORRUPTED),
+             errmsg("invalid compressed frame"),
+             errdetail("%s", detail)));
+    pg_unreachable();
+}
+
+/*
+ * Decompresses a framed document, already checked by frame_has_header, into
+ * a new bytea. A nonzero protocol must match the frame's, so each decoder
+ * rejects the other protocols' batches.
+ */
+static bytea* frame_decompress(std::span<const uint8_t> frame, uint8_t protocol)
+{
+    const uint8_t* header = frame.data();
+    const uint8_t frame_protocol = header[6];
+    if (protocol != 0 && frame_protocol != protocol) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("compressed frame holds %s, not %s",
+                        frame_protocol_name(frame_protocol), frame_protocol_name(protocol))));
+    }
+    const uint64_t len = load_be(header + 8, 8);
+    const char* src = reinterpret_cast<const char*>(header + kFrameHeaderSize);
+    const size_t src_len = frame.size() - kFrameHeaderSize;
+    bytea* result = (bytea*) palloc(VARHDRSZ + len);
+    SET_VARSIZE(result, VARHDRSZ + len);
+    switch (static_cast<FrameCodec>(header[5])) {
+        case FrameCodec::Lz4:
+        {
+#ifdef USE_LZ4
+            if (src_len > static_cast<size_t>(INT_MAX) ||
+                LZ4_decompress_safe(src, VARDATA(result), static_cast<int>(src_len),
+                                    static_cast<int>(len)) != static_cast<int>(len)) {
+                frame_corrupt("lz4 payload does not decompress to the recorded length");
+            }
+            break;
+#else
+            frame_codec_unsupported("lz4");
+#endif
+        }
+        case FrameCodec::Zstd:
+        {
+#ifdef USE_ZSTD
+            const size_t n = ZSTD_decompress(VARDATA(result), len, src, src_len);
+            if (ZSTD_isError(n) || n != len) {
+                frame_corrupt("zstd payload does not decompress to the recorded length");
+            }
+            break;
+#else
+            frame_codec_unsupported("zstd");
+#endif
+        }
+        default:
+            frame_corrupt("unknown codec");
+    }
+    return result;
+}
+
+/* The document a decoder should read: the input, or its decompressed frame. */
+static std::span<const uint8_t> decoder_input(bytea* input, uint8_t protocol)
+{
+    std::span<const uint8_t> data(reinterpret_cast<const uint8_t*>(VARDATA_ANY(input)),
+                                  static_cast<size_t>(VARSIZE_ANY_EXHDR(input)));
+    if (!frame_has_header(data)) {
+        return data;
+    }
+    bytea* document = frame_decompress(data, protocol);
+    return std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(VARDATA(document)),
+                                    VARSIZE(document) - VARHDRSZ);
+}
+
+/*
+ * Check that every composite reachable from a schema also supports a
+ * protocol's fast writer, which recurses into nested rows directly.
+ */
+static bool schema_recursive_supported(
+    const CachedSchema& schema, bool CachedSchema::*fast_supported,
+    std::unordered_set<Oid>& active_types)
+{
+    if (!(schema.*fast_supported)) {
+        return false;
+    }
+    for (const CachedColumn& col : schema.columns) {
+        Oid nested_type = InvalidOid;
+        if (col.kind == ConverterKind::Composite) {
+            nested_type = col.typid;
+        } else if (col.kind == ConverterKind::Array &&
+                   col.array_element_kind == ConverterKind::Composite) {
+            nested_type = col.array_element_typid;
+        }
+        if (!OidIsValid(nested_type) || !active_types.insert(nested_type).second) {
+            continue;
+        }
+        const CachedSchema& nested = memo_cached_schema(col.nested_memo, nested_type, -1);
+        const bool supported = schema_recursive_supported(nested, fast_supported, active_types);
+        active_types.erase(nested_type);
+        if (!supported) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static constexpr bool CachedSchema::*kStatsProtocolFastFlags[] = {
+    &CachedSchema::msgpack_fast_supported,
+    &CachedSchema::cbor_fast_supported,
+    &CachedSchema::zera_fast_supported,
+    &CachedSchema::flex_fast_supported,
+};
+
+/*
+ * Decide whether a protocol's fast writer handles a record, counting the
+ * reason under the entry point when it falls back to the dynamic tree. The
+ * nested walk runs once per schema and protocol until a cache entry is freed.
+ */
+static bool schema_fast_supported(
+    const CachedSchema& schema, Oid tupType, StatsProtocol protocol, StatsEntryPoint entry)
+{
+    bool CachedSchema::*fast_supported = kStatsProtocolFastFlags[static_cast<size_t>(protocol)];
+    if (!(schema.*fast_supported)) {
+        stats_count(protocol, entry, StatsPathMetric::FallbackUnsupported);
+        return false;
+    }
+    if (!schema.has_recursive_columns) {
+        return true;
+    }
+
+    if (schema.nested_generation != schema_cache_generation) {
+        schema.nested_generation = schema_cache_generation;
+        schema.nested_checked = 0;
+        schema.nested_supported = 0;
+    }
+    const uint8 bit = static_cast<uint8>(1u << static_cast<unsigned>(protocol));
+    bool supported = (schema.nested_supported & bit) != 0;
+    if ((schema.nested_checked & bit) == 0) {
+        // Resolving children may free entries; a verdict reached across that
+        // is used once but not kept.
+        const uint64 generation = schema_cache_generation;
+        std::unordered_set<Oid> active_types{tupType};
+        supported = schema_recursive_supported(schema, fast_supported, active_types);
+        if (generation == schema_cache_generation) {
+            schema.nested_checked |= bit;
+            if (supported) {
+                schema.nested_supported |= bit;
+            }
+        }
+    }
+    if (!supported) {
+        stats_count(protocol, entry, StatsPathMetric::FallbackRecursive);
+        return false;
+    }
+    return true;
+}
+
+static bytea* try_serialize_msgpack_row_fast(HeapTupleHeader rec, const CachedSchema& schema)
+{
+    Oid tupType = HeapTupleHeaderGetTypeId(rec);
+
+    if (!schema_fast_supported(schema, tupType, StatsProtocol::MsgPack, StatsEntryPoint::Row)) {
+        return nullptr;
+    }
+    stats_count(StatsProtocol::MsgPack, StatsEntryPoint::Row, StatsPathMetric::FastPath);
+
+    // Single rows are written in place into their bytea; the reserve tracks
+    // this schema's recent row sizes with 25% headroom.
+    z::MsgPackRootSerializer rs;
+    msgpack_palloc_root_init(rs, schema.msgpack_row_bytes + schema.msgpack_row_bytes / 4);
+
+    try {
+        z::MsgPackSerializer writer(rs);
+        if (!schema.use_deform_access) {
+            msgpack_write_record_map(writer, rec, schema, nullptr);
+        } else {
+            TupleDeformScratch scratch;
+            msgpack_write_record_map(writer, rec, schema, &scratch);
+        }
+
+        const size_t len = rs.sbuf.size - VARHDRSZ;
+        schema.msgpack_row_bytes = schema.msgpack_row_bytes == 0
+            ? len
+            : schema.msgpack_row_bytes - schema.msgpack_row_bytes / 8 + len / 8;
+        return msgpack_result_from_palloc_root(rs);
+    } catch (const std::exception& ex) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("fast MessagePack row serialization failed"),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("fast MessagePack row serialization failed with unknown exception")));
+    }
+
+    return nullptr;
+}
+
+static bytea* try_serialize_msgpack_array_fast(
+    Datum* elements, bool* nulls, int nitems, const ColumnProjection* projection)
+{
+    std::vector<const CachedSchema*> schemas;
+    std::vector<HeapTupleHeader> records;
+    schemas.reserve(nitems);
+    records.reserve(nitems);
+    SchemaMemo memo;
+
+    for (int i = 0; i < nitems; i++) {
+        if (nulls[i]) {
+            schemas.push_back(nullptr);
+            records.push_back(nullptr);
+            continue;
+        }
+
+        HeapTupleHeader rec = DatumGetHeapTupleHeader(elements[i]);
+        Oid tupType = HeapTupleHeaderGetTypeId(rec);
+        const CachedSchema& schema = memo_record_schema(memo, rec, projection);
+
+        if (!schema_fast_supported(schema, tupType, StatsProtocol::MsgPack, StatsEntryPoint::Rows)) {
+            return nullptr;
+        }
+        schemas.push_back(&schema);
+        records.push_back(rec);
+    }
+    stats_count(StatsProtocol::MsgPack, StatsEntryPoint::Rows, StatsPathMetric::FastPath);
+
+    z::MsgPackRootSerializer& rs = msgpack_reusable_root();
+    msgpack_sbuffer_clear(&rs.sbuf);
+
+    try {
+        if (bytea* result = try_serialize_msgpack_array_threaded(records, schemas, nitems)) {
+            return result;
+        }
+
+        z::MsgPackSerializer writer(rs);
+        TupleDeformScratch scratch;
+
+        writer.begin_array(static_cast<size_t>(nitems));
+        for (int i = 0; i < nitems; i++) {
+            if (nulls[i]) {
+                writer.null();
+            } else {
+                msgpack_write_record_map(writer, records[i], *schemas[i], &scratch);
+            }
+        }
+        writer.end_array();
+
+        return msgpack_result_from_reusable_root(rs);
+    } catch (const std::exception& ex) {
+        msgpack_sbuffer_clear(&rs.sbuf);
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("fast MessagePack batch serialization failed"),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        msgpack_sbuffer_clear(&rs.sbuf);
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("fast MessagePack batch serialization failed with unknown exception")));
+    }
+
+    return nullptr;
+}
+
+/*
+ * Compact batches name the columns once and emit each row as a positional
+ * array: {"columns": [name, ...], "rows": [[v1, v2, ...], ...]}. A null
+ * schema means no row was typed, so the column list is empty.
+ */
+template<typename Writer, typename RowWriter>
+static void write_compact_batch(
+    Writer& writer, const CachedSchema* schema, Datum* elements, bool* nulls, int nitems,
+    RowWriter write_row)
+{
+    TupleDeformScratch scratch;
+
+    writer.begin_map(2);
+    writer.key("columns");
+    writer.begin_array(schema != nullptr ? schema->columns.size() : 0);
+    if (schema != nullptr) {
+        for (const CachedColumn& col : schema->columns) {
+            writer.string(col.name);
+        }
+    }
+    writer.end_array();
+    writer.key("rows");
+    writer.begin_array(static_cast<size_t>(nitems));
+    for (int i = 0; i < nitems; i++) {
+        if (nulls[i]) {
+            writer.null();
+        } else {
+            write_row(writer, DatumGetHeapTupleHeader(elements[i]), *schema, &scratch);
+        }
+    }
+    writer.end_array();
+    writer.end_map();
+}
+
+static bytea* try_serialize_msgpack_compact_fast(
+    const CachedSchema* schema, Datum* elements, bool* nulls, int nitems)
+{
+    if (schema != nullptr) {
+        if (!schema_fast_supported(*schema, schema->tupdesc->tdtypeid,
+                                   StatsProtocol::MsgPack, StatsEntryPoint::Compact)) {
+            return nullptr;
+        }
+    }
+    stats_count(StatsProtocol::MsgPack, StatsEntryPoint::Compact, StatsPathMetric::FastPath);
+
+    z::MsgPackRootSerializer& rs = msgpack_reusable_root();
+    msgpack_sbuffer_clear(&rs.sbuf);
+
+    try {
+        z::MsgPackSerializer writer(rs);
+        write_compact_batch(writer, schema, elements, nulls, nitems, msgpack_write_record_tuple);
+        return msgpack_result_from_reusable_root(rs);
+    } catch (const std::exception& ex) {
+        msgpack_sbuffer_clear(&rs.sbuf);
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("fast MessagePack compact batch serialization failed"),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        msgpack_sbuffer_clear(&rs.sbuf);
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("fast MessagePack compact batch serialization failed with unknown exception")));
+    }
+
+    return nullptr;
+}
+
+static inline void cbor_write_text(z::cborjc::Serializer& writer, Datum value)
+{
+    text* txt = DatumGetTextPP(value);
+    const char* ptr = VARDATA_ANY(txt);
+    int len = VARSIZE_ANY_EXHDR(txt);
+    writer.string(std::string_view(ptr, static_cast<size_t>(len)));
+}
+
+static inline void cbor_write_key(z::cborjc::Serializer& writer, const CachedColumn& col)
+{
+    if (col.cbor_key_encoded.empty()) {
+        writer.key(col.name);
+    } else {
+        writer.key_preencoded(col.cbor_key_encoded);
+    }
+}
+
+static inline void cbor_write_record_map(
+    z::cborjc::Serializer& writer,
+    HeapTupleHeader rec,
+    const CachedSchema& schema,
+    TupleDeformScratch* scratch);
+
+static inline void cbor_write_composite(
+    z::cborjc::Serializer& writer, const CachedColumn& col, Datum value)
+{
+    HeapTupleHeader rec = DatumGetHeapTupleHeader(value);
+    const CachedSchema& schema = memo_cached_schema(
+        col.nested_memo, HeapTupleHeaderGetTypeId(rec), HeapTupleHeaderGetTypMod(rec));
+    TupleDeformScratch scratch;
+    cbor_write_record_map(writer, rec, schema, &scratch);
+}
+
+static inline void cbor_write_array_element(
+    z::cborjc::Serializer& writer,
+    const CachedColumn& col,
+    Datum value,
+    bool isnull)
+{
+    col.cbor_array_elem_writer(writer, col, value, isnull);
+}
+
+static inline void cbor_write_array(
+    z::cborjc::Serializer& writer,
+    const CachedColumn& col,
+    Datum value)
+{
+    ArrayType* arr = DatumGetArrayTypeP(value);
+    int ndim = ARR_NDIM(arr);
+
+    if (ndim == 0) {
+        writer.begin_array(0);
+        writer.end_array();
+        return;
+    }
+
+    if (ndim != 1) {
+        z::dyn::serialize(array_to_dynamic(value, col.typid), writer);
+        return;
+    }
+
+    if (write_typed_array_if_enabled(writer, col.array_element_kind, arr)) {
+        return;
+    }
+
+    Datum* elements;
+    bool* nulls;
+    int nitems;
+    deconstruct_array(arr,
+                      col.array_element_typid,
+                      col.array_typlen,
+                      col.array_typbyval,
+                      col.array_typalign,
+                      &elements,
+                      &nulls,
+                      &nitems);
+
+    writer.begin_array(static_cast<size_t>(nitems));
+    for (int i = 0; i < nitems; i++) {
+        if (nulls[i]) {
+            writer.null();
+        } else if (col.array_element_kind == ConverterKind::Fallback) {
+            write_output_string(writer, col.array_element_typoutput, elements[i]);
+        } else {
+            cbor_write_array_element(writer, col, elements[i], false);
+        }
+    }
+    writer.end_array();
+
+    pfree(elements);
+    pfree(nulls);
+}
+
+static inline void cbor_write_scalar(
+    z::cborjc::Serializer& writer,
+    const CachedColumn& col,
+    Datum value,
+    bool isnull)
+{
+    col.cbor_scalar_writer(writer, col, value, isnull);
+}
+
+static inline void cbor_write_record_map(
+    z::cborjc::Serializer& writer,
+    HeapTupleHeader rec,
+    const CachedSchema& schema,
+    TupleDeformScratch* scratch)
+{
+    HeapTupleData tuple;
+    tuple.t_len = HeapTupleHeaderGetDatumLength(rec);
+    tuple.t_data = rec;
+
+    writer.begin_map(schema.columns.size());
+    if (!schema.use_deform_access) {
+        for (const CachedColumn& col : schema.columns) {
+            bool isnull;
+            Datum value = heap_getattr(&tuple, col.attnum, schema.tupdesc, &isnull);
+            cbor_write_key(writer, col);
+            cbor_write_scalar(writer, col, value, isnull);
+        }
+    } else {
+        const size_t nattrs = static_cast<size_t>(schema.tupdesc->natts);
+        scratch->ensure(nattrs);
+        heap_deform_tuple(&tuple, schema.tupdesc, scratch->values, scratch->nulls);
+        for (const CachedColumn& col : schema.columns) {
+            const int idx = col.attnum - 1;
+            cbor_write_key(writer, col);
+            cbor_write_scalar(writer, col, scratch->values[idx], scratch->nulls[idx]);
+        }
+    }
+    writer.end_map();
+}
+
+// Positional form of cbor_write_record_map for compact batches.
+static inline void cbor_write_record_tuple(
+    z::cborjc::Serializer& writer,
+    HeapTupleHeader rec,
+    const CachedSchema& schema,
+    TupleDeformScratch* scratch)
+{
+    HeapTupleData tuple;
+    tuple.t_len = HeapTupleHeaderGetDatumLength(rec);
+    tuple.t_data = rec;
+
+    writer.begin_array(schema.columns.size());
+    if (!schema.use_deform_access) {
+        for (const CachedColumn& col : schema.columns) {
+            bool isnull;
+            Datum value = heap_getattr(&tuple, col.attnum, schema.tupdesc, &isnull);
+            cbor_write_scalar(writer, col, value, isnull);
+        }
+    } else {
+        const size_t nattrs = static_cast<size_t>(schema.tupdesc->natts);
+        scratch->ensure(nattrs);
+        heap_deform_tuple(&tuple, schema.tupdesc, scratch->values, scratch->nulls);
+        for (const CachedColumn& col : schema.columns) {
+            const int idx = col.attnum - 1;
+            cbor_write_scalar(writer, col, scratch->values[idx], scratch->nulls[idx]);
+        }
+    }
+    writer.end_array();
+}
+
+static bytea* try_serialize_cbor_row_fast(HeapTupleHeader rec, const CachedSchema& schema)
+{
+    if (!schema_fast_supported(schema, HeapTupleHeaderGetTypeId(rec),
+                               StatsProtocol::Cbor, StatsEntryPoint::Row)) {
+        return nullptr;
+    }
+    stats_count(StatsProtocol::Cbor, StatsEntryPoint::Row, StatsPathMetric::FastPath);
+
+    try {
+        z::cborjc::RootSerializer rs(std::move(cbor_reusable_storage()));
+        z::cborjc::Serializer writer(rs);
+        if (!schema.use_deform_access) {
+            cbor_write_record_map(writer, rec, schema, nullptr);
+        } else {
+            TupleDeformScratch scratch;
+            cbor_write_record_map(writer, rec, schema, &scratch);
+        }
+
+        return cbor_result_from_root(rs);
+    } catch (const std::exception& ex) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("fast CBOR row serialization failed"),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("fast CBOR row serialization failed with unknown exception")));
+    }
+
+    return nullptr;
+}
+
+static bytea* try_serialize_cbor_array_fast(
+    Datum* elements, bool* nulls, int nitems, const ColumnProjection* projection)
+{
+    std::vector<const CachedSchema*> schemas;
+    schemas.reserve(nitems);
+    SchemaMemo memo;
+
+    for (int i = 0; i < nitems; i++) {
+        if (nulls[i]) {
+            schemas.push_back(nullptr);
+            continue;
+        }
+
+        HeapTupleHeader rec = DatumGetHeapTupleHeader(elements[i]);
+        const CachedSchema& schema = memo_record_schema(memo, rec, projection);
+
+        if (!schema_fast_supported(schema, HeapTupleHeaderGetTypeId(rec),
+                                   StatsProtocol::Cbor, StatsEntryPoint::Rows)) {
+            return nullptr;
+        }
+        schemas.push_back(&schema);
+    }
+    stats_count(StatsProtocol::Cbor, StatsEntryPoint::Rows, StatsPathMetric::FastPath);
+
+    try {
+        z::cborjc::RootSerializer rs(std::move(cbor_reusable_storage()));
+        z::cborjc::Serializer writer(rs);
+        TupleDeformScratch scratch;
+
+        writer.begin_array(static_cast<size_t>(nitems));
+        for (int i = 0; i < nitems; i++) {
+            if (nulls[i]) {
+                writer.null();
+            } else {
+                HeapTupleHeader rec = DatumGetHeapTupleHeader(elements[i]);
+                cbor_write_record_map(writer, rec, *schemas[i], &scratch);
+            }
+        }
+        writer.end_array();
+
+        return cbor_result_from_root(rs);
+    } catch (const std::exception& ex) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("fast CBOR batch serialization failed"),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("fast CBOR batch serialization failed with unknown exception")));
+    }
+
+    return nullptr;
+}
+
+static bytea* try_serialize_cbor_compact_fast(
+    const CachedSchema* schema, Datum* elements, bool* nulls, int nitems)
+{
+    if (schema != nullptr &&
+        !schema_fast_supported(*schema, schema->tupdesc->tdtypeid,
+                               StatsProtocol::Cbor, StatsEntryPoint::Compact)) {
+        return nullptr;
+    }
+    stats_count(StatsProtocol::Cbor, StatsEntryPoint::Compact, StatsPathMetric::FastPath);
+
+    try {
+        z::cborjc::RootSerializer rs(std::move(cbor_reusable_storage()));
+        z::cborjc::Serializer writer(rs);
+        write_compact_batch(writer, schema, elements, nulls, nitems, cbor_write_record_tuple);
+
+        return cbor_result_from_root(rs);
+    } catch (const std::exception& ex) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("fast CBOR compact batch serialization failed"),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("fast CBOR compact batch serialization failed with unknown exception")));
+    }
+
+    return nullptr;
+}
+
+static inline void zera_write_text(z::zera::Serializer& writer, Datum value)
+{
+    text* txt = DatumGetTextPP(value);
+    const char* ptr = VARDATA_ANY(txt);
+    int len = VARSIZE_ANY_EXHDR(txt);
+    writer.string(std::string_view(ptr, static_cast<size_t>(len)));
+}
+
+static inline void zera_write_record_map(
+    z::zera::Serializer& writer,
+    HeapTupleHeader rec,
+    const CachedSchema& schema,
+    TupleDeformScratch* scratch);
+
+static inline void zera_write_composite(
+    z::zera::Serializer& writer, const CachedColumn& col, Datum value)
+{
+    HeapTupleHeader rec = DatumGetHeapTupleHeader(value);
+    const CachedSchema& schema = memo_cached_schema(
+        col.nested_memo, HeapTupleHeaderGetTypeId(rec), HeapTupleHeaderGetTypMod(rec));
+    TupleDeformScratch scratch;
+    zera_write_record_map(writer, rec, schema, &scratch);
+}
+
+static inline void zera_write_array_element(
+    z::zera::Serializer& writer,
+    const CachedColumn& col,
+    Datum value,
+    bool isnull)
+{
+    col.zera_array_elem_writer(writer, col, value, isnull);
+}
+
+static inline void zera_write_array(
+    z::zera::Serializer& writer,
+    const CachedColumn& col,
+    Datum value)
+{
+    ArrayType* arr = DatumGetArrayTypeP(value);
+    int ndim = ARR_NDIM(arr);
+
+    if (ndim == 0) {
+        writer.begin_array(0);
+        writer.end_array();
+        return;
+    }
+
+    if (ndim != 1) {
+        z::dyn::serialize(array_to_dynamic(value, col.typid), writer);
+        return;
+    }
+
+    if (write_typed_array_if_enabled(writer, col.array_element_kind, arr)) {
+        return;
+    }
+
+    Datum* elements;
+    bool* nulls;
+    int nitems;
+    deconstruct_array(arr,
+                      col.array_element_typid,
+                      col.array_typlen,
+                      col.array_typbyval,
+                      col.array_typalign,
+                      &elements,
+                      &nulls,
+                      &nitems);
+
+    writer.begin_array(static_cast<size_t>(nitems));
+    for (int i = 0; i < nitems; i++) {
+        if (nulls[i]) {
+            writer.null();
+        } else if (col.array_element_kind == ConverterKind::Fallback) {
+            write_output_string(writer, col.array_element_typoutput, elements[i]);
+        } else {
+            zera_write_array_element(writer, col, elements[i], false);
+        }
+    }
+    writer.end_array();
+
+    pfree(elements);
+    pfree(nulls);
+}
+
+static inline void zera_write_scalar(
+    z::zera::Serializer& writer,
+    const CachedColumn& col,
+    Datum value,
+    bool isnull)
+{
+    col.zera_scalar_writer(writer, col, value, isnull);
+}
+
+static inline void zera_write_record_map(
+    z::zera::Serializer& writer,
+    HeapTupleHeader rec,
+    const CachedSchema& schema,
+    TupleDeformScratch* scratch)
+{
+    HeapTupleData tuple;
+    tuple.t_len = HeapTupleHeaderGetDatumLength(rec);
+    tuple.t_data = rec;
+
+    writer.begin_map(schema.columns.size());
+    if (!schema.use_deform_access) {
+        for (const CachedColumn& col : schema.columns) {
+            bool isnull;
+            Datum value = heap_getattr(&tuple, col.attnum, schema.tupdesc, &isnull);
+            writer.key_preencoded(col.zera_key_encoded);
+            zera_write_scalar(writer, col, value, isnull);
+        }
+    } else {
+        const size_t nattrs = static_cast<size_t>(schema.tupdesc->natts);
+        scratch->ensure(nattrs);
+        heap_deform_tuple(&tuple, schema.tupdesc, scratch->values, scratch->nulls);
+        for (const CachedColumn& col : schema.columns) {
+            const int idx = col.attnum - 1;
+            writer.key_preencoded(col.zera_key_encoded);
+            zera_write_scalar(writer, col, scratch->values[idx], scratch->nulls[idx]);
+        }
+    }
+    writer.end_map();
+}
+
+// Positional form of zera_write_record_map for compact batches.
+static inline void zera_write_record_tuple(
+    z::zera::Serializer& writer,
+    HeapTupleHeader rec,
+    const CachedSchema& schema,
+    TupleDeformScratch* scratch)
+{
+    HeapTupleData tuple;
+    tuple.t_len = HeapTupleHeaderGetDatumLength(rec);
+    tuple.t_data = rec;
+
+    writer.begin_array(schema.columns.size());
+    if (!schema.use_deform_access) {
+        for (const CachedColumn& col : schema.columns) {
+            bool isnull;
+            Datum value = heap_getattr(&tuple, col.attnum, schema.tupdesc, &isnull);
+            zera_write_scalar(writer, col, value, isnull);
+        }
+    } else {
+        const size_t nattrs = static_cast<size_t>(schema.tupdesc->natts);
+        scratch->ensure(nattrs);
+        heap_deform_tuple(&tuple, schema.tupdesc, scratch->values, scratch->nulls);
+        for (const CachedColumn& col : schema.columns) {
+            const int idx = col.attnum - 1;
+            zera_write_scalar(writer, col, scratch->values[idx], scratch->nulls[idx]);
+        }
+    }
+    writer.end_array();
+}
+
+static bytea* try_serialize_zera_row_fast(HeapTupleHeader rec, const CachedSchema& schema)
+{
+    if (!schema_fast_supported(schema, HeapTupleHeaderGetTypeId(rec),
+                               StatsProtocol::Zera, StatsEntryPoint::Row)) {
+        return nullptr;
+    }
+    stats_count(StatsProtocol::Zera, StatsEntryPoint::Row, StatsPathMetric::FastPath);
+
+    try {
+        z::zera::RootSerializer& rs = zera_reusable_root();
+        z::zera::Serializer writer(rs);
+        if (!schema.use_deform_access) {
+            zera_write_record_map(writer, rec, schema, nullptr);
+        } else {
+            TupleDeformScratch scratch;
+            zera_write_record_map(writer, rec, schema, &scratch);
+        }
+
+        return zera_result_from_root(rs);
+    } catch (const std::exception& ex) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("fast ZERA row serialization failed"),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("fast ZERA row serialization failed with unknown exception")));
+    }
+
+    return nullptr;
+}
+
+static bytea* try_serialize_zera_array_fast(
+    Datum* elements, bool* nulls, int nitems, const ColumnProjection* projection)
+{
+    std::vector<const CachedSchema*> schemas;
+    schemas.reserve(nitems);
+    SchemaMemo memo;
+
+    for (int i = 0; i < nitems; i++) {
+        if (nulls[i]) {
+            schemas.push_back(nullptr);
+            continue;
+        }
+
+        HeapTupleHeader rec = DatumGetHeapTupleHeader(elements[i]);
+        const CachedSchema& schema = memo_record_schema(memo, rec, projection);
+
+        if (!schema_fast_supported(schema, HeapTupleHeaderGetTypeId(rec),
+                                   StatsProtocol::Zera, StatsEntryPoint::Rows)) {
+            return nullptr;
+        }
+        schemas.push_back(&schema);
+    }
+    stats_count(StatsProtocol::Zera, StatsEntryPoint::Rows, StatsPathMetric::FastPath);
+
+    try {
+        z::zera::RootSerializer& rs = zera_reusable_root();
+        z::zera::Serializer writer(rs);
+        TupleDeformScratch scratch;
+
+        writer.begin_array(static_cast<size_t>(nitems));
+        for (int i = 0; i < nitems; i++) {
+            if (nulls[i]) {
+                writer.null();
+            } else {
+                HeapTupleHeader rec = DatumGetHeapTupleHeader(elements[i]);
+                zera_write_record_map(writer, rec, *schemas[i], &scratch);
+            }
+        }
+        writer.end_array();
+
+        return zera_result_from_root(rs);
+    } catch (const std::exception& ex) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("fast ZERA batch serialization failed"),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("fast ZERA batch serialization failed with unknown exception")));
+    }
+
+    return nullptr;
+}
+
+static bytea* try_serialize_zera_compact_fast(
+    const CachedSchema* schema, Datum* elements, bool* nulls, int nitems)
+{
+    if (schema != nullptr &&
+        !schema_fast_supported(*schema, schema->tupdesc->tdtypeid,
+                               StatsProtocol::Zera, StatsEntryPoint::Compact)) {
+        return nullptr;
+    }
+    stats_count(StatsProtocol::Zera, StatsEntryPoint::Compact, StatsPathMetric::FastPath);
+
+    try {
+        z::zera::RootSerializer& rs = zera_reusable_root();
+        z::zera::Serializer writer(rs);
+        write_compact_batch(writer, schema, elements, nulls, nitems, zera_write_record_tuple);
+
+        return zera_result_from_root(rs);
+    } catch (const std::exception& ex) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("fast ZERA compact batch serialization failed"),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("fast ZERA compact batch serialization failed with unknown exception")));
+    }
+
+    return nullptr;
+}
+
+static inline void flex_write_text(z::flex::Serializer& writer, Datum value)
+{
+    text* txt = DatumGetTextPP(value);
+    const char* ptr = VARDATA_ANY(txt);
+    int len = VARSIZE_ANY_EXHDR(txt);
+    writer.string(std::string_view(ptr, static_cast<size_t>(len)));
+}
+
+// The first map of a document writes each key; later ones point at it.
+static inline void flex_write_key(z::flex::Serializer& writer, const CachedColumn& col)
+{
+    if (col.flex_key_document == writer.document()) {
+        writer.key_reused(col.flex_key);
+        return;
+    }
+    col.flex_key = writer.key_for_reuse(col.name);
+    col.flex_key_document = writer.document();
+}
+
+static inline void flex_write_record_map(
+    z::flex::Serializer& writer,
+    HeapTupleHeader rec,
+    const CachedSchema& schema,
+    TupleDeformScratch* scratch);
+
+static inline void flex_write_composite(
+    z::flex::Serializer& writer, const CachedColumn& col, Datum value)
+{
+    HeapTupleHeader rec = DatumGetHeapTupleHeader(value);
+    const CachedSchema& schema = memo_cached_schema(
+        col.nested_memo, HeapTupleHeaderGetTypeId(rec), HeapTupleHeaderGetTypMod(rec));
+    TupleDeformScratch scratch;
+    flex_write_record_map(writer, rec, schema, &scratch);
+}
+
+static inline void flex_write_array_element(
+    z::flex::Serializer& writer,
+    const CachedColumn& col,
+    Datum value,
+    bool isnull)
+{
+    col.flex_array_elem_writer(writer, col, value, isnull);
+}
+
+static inline void flex_write_array(
+    z::flex::Serializer& writer,
+    const CachedColumn& col,
+    Datum value)
+{
+    ArrayType* arr = DatumGetArrayTypeP(value);
+    int ndim = ARR_NDIM(arr);
+
+    if (ndim == 0) {
+        writer.begin_array(0);
+        writer.end_array();
+        return;
+    }
+
+    if (ndim != 1) {
+        z::dyn::serialize(array_to_dynamic(value, col.typid), writer);
+        return;
+    }
+
+    if (write_typed_array_if_enabled(writer, col.array_element_kind, arr)) {
+        return;
+    }
+
+    Datum* elements;
+    bool* nulls;
+    int nitems;
+    deconstruct_array(arr,
+                      col.array_element_typid,
+                      col.array_typlen,
+                      col.array_typbyval,
+                      col.array_typalign,
+                      &elements,
+                      &nulls,
+                      &nitems);
+
+    writer.begin_array(static_cast<size_t>(nitems));
+    for (int i = 0; i < nitems; i++) {
+        if (nulls[i]) {
+            writer.null();
+        } else if (col.array_element_kind == ConverterKind::Fallback) {
+            write_output_string(writer, col.array_element_typoutput, elements[i]);
+        } else {
+            flex_write_array_element(writer, col, elements[i], false);
+        }
+    }
+    writer.end_array();
+
+    pfree(elements);
+    pfree(nulls);
+}
+
+static inline void flex_write_scalar(
+    z::flex::Serializer& writer,
+    const CachedColumn& col,
+    Datum value,
+    bool isnull)
+{
+    col.flex_scalar_writer(writer, col, value, isnull);
+}
+
+template <typename WriterT>
+static constexpr const char* column_writer_protocol()
+{
+    if constexpr (std::is_same_v<WriterT, z::cborjc::Serializer>) {
+        return "CBOR";
+    } else if constexpr (std::is_same_v<WriterT, z::zera::Serializer>) {
+        return "ZERA";
+    } else {
+        return "Flex";
+    }
+}
+
+template <typename WriterT, bool Element>
+static void write_unsupported_value(WriterT&, const CachedColumn& col, Datum, bool)
+{
+    if constexpr (Element) {
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("unsupported array element type for fast %s path",
+                        column_writer_protocol<WriterT>())));
+    } else {
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("unsupported type for fast %s path", column_writer_protocol<WriterT>()),
+                 errdetail("column type OID %u", col.typid)));
+    }
+}
+
+/*
+ * One column writer per protocol, converter kind, and role, so the CBOR,
+ * ZERA, and Flex direct paths call through the pointer chosen in
+ * init_cached_column_type instead of switching on the kind for every value.
+ * Element writers serve one-dimensional array elements; the array writers
+ * handle fallback elements themselves.
+ */
+template <typename WriterT, ConverterKind Kind, bool Element>
+static void write_planned_value(WriterT& writer, const CachedColumn& col, Datum value, bool isnull)
+{
+    constexpr bool is_cbor = std::is_same_v<WriterT, z::cborjc::Serializer>;
+    constexpr bool is_zera = std::is_same_v<WriterT, z::zera::Serializer>;
+
+    if (isnull) {
+        writer.null();
+        return;
+    }
+
+    if constexpr (Kind == ConverterKind::Int2) {
+        writer.int64(static_cast<int64_t>(DatumGetInt16(value)));
+    } else if constexpr (Kind == ConverterKind::Int4) {
+        writer.int64(static_cast<int64_t>(DatumGetInt32(value)));
+    } else if constexpr (Kind == ConverterKind::Int8) {
+        writer.int64(static_cast<int64_t>(DatumGetInt64(value)));
+    } else if constexpr (Kind == ConverterKind::Float4) {
+        writer.double_(static_cast<double>(DatumGetFloat4(value)));
+    } else if constexpr (Kind == ConverterKind::Float8) {
+        writer.double_(DatumGetFloat8(value));
+    } else if constexpr (Kind == ConverterKind::Bool) {
+        writer.boolean(DatumGetBool(value));
+    } else if constexpr (Kind == ConverterKind::Text || Kind == ConverterKind::JsonText) {
+        if constexpr (is_cbor) {
+            cbor_write_text(writer, value);
+        } else if constexpr (is_zera) {
+            zera_write_text(writer, value);
+        } else {
+            flex_write_text(writer, value);
+        }
+    } else if constexpr (Kind == ConverterKind::Uuid) {
+        write_uuid(writer, value);
+    } else if constexpr (Kind == ConverterKind::NameText) {
+        writer.string(name_text_view(value));
+    } else if constexpr (Kind == ConverterKind::CharText) {
+        char ch = DatumGetChar(value);
+        writer.string(std::string_view(&ch, ch == '\0' ? 0 : 1));
+    } else if constexpr (Kind == ConverterKind::EnumText) {
+        writer.string(enum_label_view(value));
+    } else if constexpr (Kind == ConverterKind::InetText) {
+        write_network(writer, value, false);
+    } else if constexpr (Kind == ConverterKind::CidrText) {
+        write_network(writer, value, true);
+    } else if constexpr (Kind == ConverterKind::IntervalText) {
+        write_interval(writer, value);
+    } else if constexpr (Kind == ConverterKind::Numeric) {
+        numeric_write_fast(writer, value);
+    } else if constexpr (Kind == ConverterKind::Date) {
+        writer.int64(static_cast<int64_t>(DatumGetDateADT(value)));
+    } else if constexpr (Kind == ConverterKind::Timestamp) {
+        write_timestamp(writer, DatumGetTimestamp(value));
+    } else if constexpr (Kind == ConverterKind::Timestamptz) {
+        write_timestamp(writer, DatumGetTimestampTz(value));
+    } else if constexpr (Kind == ConverterKind::Jsonb) {
+        writer.binary(datum_jsonb_span(value));
+    } else if constexpr (Kind == ConverterKind::Bytea) {
+        writer.binary(datum_bytea_span(value));
+    } else if constexpr (Kind == ConverterKind::Composite) {
+        if constexpr (is_cbor) {
+            cbor_write_composite(writer, col, value);
+        } else if constexpr (is_zera) {
+            zera_write_composite(writer, col, value);
+        } else {
+            flex_write_composite(writer, col, value);
+        }
+    } else if constexpr (Kind == ConverterKind::Array && !Element) {
+        if constexpr (is_cbor) {
+            cbor_write_array(writer, col, value);
+        } else if constexpr (is_zera) {
+            zera_write_array(writer, col, value);
+        } else {
+            flex_write_array(writer, col, value);
+        }
+    } else if constexpr (Kind == ConverterKind::Fallback && !Element) {
+        char* str = OidOutputFunctionCall(col.typoutput, value);
+        writer.string(std::string_view(str));
+        pfree(str);
+    } else {
+        write_unsupported_value<WriterT, Element>(writer, col, value, isnull);
+    }
+}
+
+template <typename WriterT, ConverterKind Kind>
+static ColumnWriterFn<WriterT> planned_writer(bool element)
+{
+    return element ? &write_planned_value<WriterT, Kind, true>
+                   : &write_planned_value<WriterT, Kind, false>;
+}
+
+template <typename WriterT>
+static ColumnWriterFn<WriterT> select_column_writer(ConverterKind kind, bool element)
+{
+    switch (kind) {
+        case ConverterKind::Int2: return planned_writer<WriterT, ConverterKind::Int2>(element);
+        case ConverterKind::Int4: return planned_writer<WriterT, ConverterKind::Int4>(element);
+        case ConverterKind::Int8: return planned_writer<WriterT, ConverterKind::Int8>(element);
+        case ConverterKind::Float4: return planned_writer<WriterT, ConverterKind::Float4>(element);
+        case ConverterKind::Float8: return planned_writer<WriterT, ConverterKind::Float8>(element);
+        case ConverterKind::Bool: return planned_writer<WriterT, ConverterKind::Bool>(element);
+        case ConverterKind::Text: return planned_writer<WriterT, ConverterKind::Text>(element);
+        case ConverterKind::JsonText: return planned_writer<WriterT, ConverterKind::JsonText>(element);
+        case ConverterKind::Uuid: return planned_writer<WriterT, ConverterKind::Uuid>(element);
+        case ConverterKind::NameText: return planned_writer<WriterT, ConverterKind::NameText>(element);
+        case ConverterKind::CharText: return planned_writer<WriterT, ConverterKind::CharText>(element);
+        case ConverterKind::EnumText: return planned_writer<WriterT, ConverterKind::EnumText>(element);
+        case ConverterKind::InetText: return planned_writer<WriterT, ConverterKind::InetText>(element);
+        case ConverterKind::CidrText: return planned_writer<WriterT, ConverterKind::CidrText>(element);
+        case ConverterKind::IntervalText: return planned_writer<WriterT, ConverterKind::IntervalText>(element);
+        case ConverterKind::Numeric: return planned_writer<WriterT, ConverterKind::Numeric>(element);
+        case ConverterKind::Date: return planned_writer<WriterT, ConverterKind::Date>(element);
+        case ConverterKind::Timestamp: return planned_writer<WriterT, ConverterKind::Timestamp>(element);
+        case ConverterKind::Timestamptz: return planned_writer<WriterT, ConverterKind::Timestamptz>(element);
+        case ConverterKind::Jsonb: return planned_writer<WriterT, ConverterKind::Jsonb>(element);
+        case ConverterKind::Bytea: return planned_writer<WriterT, ConverterKind::Bytea>(element);
+        case ConverterKind::Composite: return planned_writer<WriterT, ConverterKind::Composite>(element);
+        case ConverterKind::Array: return planned_writer<WriterT, ConverterKind::Array>(element);
+        case ConverterKind::Fallback: return planned_writer<WriterT, ConverterKind::Fallback>(element);
+    }
+    return element ? &write_unsupported_value<WriterT, true> : &write_unsupported_value<WriterT, false>;
+}
+
+static inline void flex_write_record_map(
+    z::flex::Serializer& writer,
+    HeapTupleHeader rec,
+    const CachedSchema& schema,
+    TupleDeformScratch* scratch)
+{
+    HeapTupleData tuple;
+    tuple.t_len = HeapTupleHeaderGetDatumLength(rec);
+    tuple.t_data = rec;
+
+    writer.begin_map(schema.columns.size());
+    if (!schema.use_deform_access) {
+        for (const CachedColumn& col : schema.columns) {
+            bool isnull;
+            Datum value = heap_getattr(&tuple, col.attnum, schema.tupdesc, &isnull);
+            flex_write_key(writer, col);
+            flex_write_scalar(writer, col, value, isnull);
+        }
+    } else {
+        const size_t nattrs = static_cast<size_t>(schema.tupdesc->natts);
+        scratch->ensure(nattrs);
+        heap_deform_tuple(&tuple, schema.tupdesc, scratch->values, scratch->nulls);
+        for (const CachedColumn& col : schema.columns) {
+            const int idx = col.attnum - 1;
+            flex_write_key(writer, col);
+            flex_write_scalar(writer, col, scratch->values[idx], scratch->nulls[idx]);
+        }
+    }
+    writer.end_map();
+}
+
+static bytea* try_serialize_flex_row_fast(HeapTupleHeader rec, const CachedSchema& schema)
+{
+    if (!schema_fast_supported(schema, HeapTupleHeaderGetTypeId(rec),
+                               StatsProtocol::Flex, StatsEntryPoint::Row)) {
+        return nullptr;
+    }
+    stats_count(StatsProtocol::Flex, StatsEntryPoint::Row, StatsPathMetric::FastPath);
+
+    try {
+        z::flex::RootSerializer& rs = flex_reusable_root();
+        z::flex::Serializer writer(rs);
+        if (!schema.use_deform_access) {
+            flex_write_record_map(writer, rec, schema, nullptr);
+        } else {
+            TupleDeformScratch scratch;
+            flex_write_record_map(writer, rec, schema, &scratch);
+        }
+
+        return flex_result_from_root(rs);
+    } catch (const std::exception& ex) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("fast Flex row serialization failed"),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("fast Flex row serialization failed with unknown exception")));
+    }
+
+    return nullptr;
+}
+
+static bytea* try_serialize_flex_array_fast(
+    Datum* elements, bool* nulls, int nitems, const ColumnProjection* projection)
+{
+    std::vector<const CachedSchema*> schemas;
+    schemas.reserve(nitems);
+    SchemaMemo memo;
+
+    for (int i = 0; i < nitems; i++) {
+        if (nulls[i]) {
+            schemas.push_back(nullptr);
+            continue;
+        }
+
+        HeapTupleHeader rec = DatumGetHeapTupleHeader(elements[i]);
+        const CachedSchema& schema = memo_record_schema(memo, rec, projection);
+
+        if (!schema_fast_supported(schema, HeapTupleHeaderGetTypeId(rec),
+                                   StatsProtocol::Flex, StatsEntryPoint::Rows)) {
+            return nullptr;
+        }
+        schemas.push_back(&schema);
+    }
+    stats_count(StatsProtocol::Flex, StatsEntryPoint::Rows, StatsPathMetric::FastPath);
+
+    try {
+        z::flex::RootSerializer& rs = flex_reusable_root();
+        z::flex::Serializer writer(rs);
+        TupleDeformScratch scratch;
+
+        writer.begin_array(static_cast<size_t>(nitems));
+        for (int i = 0; i < nitems; i++) {
+            if (nulls[i]) {
+                writer.null();
+            } else {
+                HeapTupleHeader rec = DatumGetHeapTupleHeader(elements[i]);
+                flex_write_record_map(writer, rec, *schemas[i], &scratch);
+            }
+        }
+        writer.end_array();
+
+        return flex_result_from_root(rs);
+    } catch (const std::exception& ex) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("fast Flex batch serialization failed"),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("fast Flex batch serialization failed with unknown exception")));
+    }
 
-        case UUIDOID:
-            return z::dyn::Value(uuid_to_owned_string(value));
-        case NAMEOID:
-            return z::dyn::Value(std::string(name_text_view(value)));
-        case CHAROID:
-            return z::dyn::Value(char_to_owned_string(value));
+    return nullptr;
+}
 
-        case NUMERICOID:
-            return numeric_to_dynamic_fast(value);
-        case DATEOID:
-            return z::dyn::Value(static_cast<int64_t>(DatumGetDateADT(value)));
-        case TIMESTAMPOID:
-            return z::dyn::Value(static_cast<int64_t>(DatumGetTimestamp(value)));
-        case TIMESTAMPTZOID:
-            return z::dyn::Value(static_cast<int64_t>(DatumGetTimestampTz(value)));
-        case JSONBOID:
-            return z::dyn::Value::blob(datum_jsonb_span(value));
-        case BYTEAOID:
-            return z::dyn::Value::blob(datum_bytea_span(value));
+/*
+ * Convert a PostgreSQL record (HeapTupleHeader) to a zerialize dynamic map
+ * This is used by both single-record and batch processing functions
+ */
+static z::dyn::Value record_to_dynamic_map(
+    HeapTupleHeader rec, const ColumnProjection* projection)
+{
+    const CachedSchema* schema;
+    HeapTupleData tuple;
 
-        default:
-        {
-            if (typid == RECORDOID || get_typtype(typid) == TYPTYPE_COMPOSITE) {
-                return record_to_dynamic_map(DatumGetHeapTupleHeader(value));
-            }
+    // Extract type info from the record
+    schema = &get_record_schema(rec, projection);
+    tuple.t_len = HeapTupleHeaderGetDatumLength(rec);
+    tuple.t_data = rec;
 
-            // For unsupported types, convert to text representation
-            Oid typoutput;
-            bool typIsVarlena;
-            char* str;
+    // Build map of column name -> value
+    // Pre-allocate space to avoid reallocation overhead
+    z::dyn::Value::Map entries;
+    entries.reserve(schema->columns.size());
 
-            getTypeOutputInfo(typid, &typoutput, &typIsVarlena);
-            str = OidOutputFunctionCall(typoutput, value);
-            std::string strval(str);
-            pfree(str);
-            return z::dyn::Value(strval);
+    if (!schema->use_deform_access) {
+        for (const CachedColumn& col : schema->columns) {
+            bool isnull;
+            Datum value = heap_getattr(&tuple, col.attnum, schema->tupdesc, &isnull);
+            entries.emplace_back(col.name, datum_to_dynamic_cached(value, isnull, col));
+        }
+    } else {
+        TupleDeformScratch scratch;
+        const size_t nattrs = static_cast<size_t>(schema->tupdesc->natts);
+        scratch.ensure(nattrs);
+        heap_deform_tuple(&tuple, schema->tupdesc, scratch.values, scratch.nulls);
+        for (const CachedColumn& col : schema->columns) {
+            const int idx = col.attnum - 1;
+            entries.emplace_back(col.name,
+                                 datum_to_dynamic_cached(scratch.values[idx], scratch.nulls[idx], col));
         }
     }
+
+    return z::dyn::Value::map(std::move(entries));
 }
 
-static z::dyn::Value fallback_to_text_output(Datum value, Oid typoutput)
+/*
+ * Generic helper function to convert PostgreSQL tuple to any binary format
+ * Template parameter determines the serialization protocol
+ */
+template<typename Protocol>
+static bytea* tuple_to_binary(
+    HeapTupleHeader rec, const ColumnProjection* projection = nullptr,
+    FunctionCallInfo fcinfo = nullptr)
 {
-    char* str = OidOutputFunctionCall(typoutput, value);
-    std::string strval(str);
-    pfree(str);
-    return z::dyn::Value(strval);
+    try {
+        const CachedSchema& schema = call_site_record_schema(fcinfo, rec, projection);
+        bytea* fast = nullptr;
+        if constexpr (std::is_same_v<Protocol, z::MsgPack>) {
+            fast = try_serialize_msgpack_row_fast(rec, schema);
+        } else if constexpr (std::is_same_v<Protocol, z::CBOR>) {
+            fast = try_serialize_cbor_row_fast(rec, schema);
+        } else if constexpr (std::is_same_v<Protocol, z::Zera>) {
+            fast = try_serialize_zera_row_fast(rec, schema);
+        } else if constexpr (std::is_same_v<Protocol, z::Flex>) {
+            fast = try_serialize_flex_row_fast(rec, schema);
+        }
+        if (fast != nullptr) {
+            stats_count_document(stats_protocol_of<Protocol>(), StatsEntryPoint::Row, fast, 1);
+            return fast;
+        }
+
+        // Convert record to dynamic map
+        z::dyn::Value map = record_to_dynamic_map(rec, projection);
+
+        // Serialize
+        z::ZBuffer buffer = z::serialize<Protocol>(map);
+        std::span<const uint8_t> data = buffer.buf();
+
+        // Allocate PostgreSQL bytea with actual size
+        // (Estimation helps zerialize internally, allocation uses actual size)
+        size_t len = data.size();
+        bytea* result = (bytea*) palloc(len + VARHDRSZ);
+        SET_VARSIZE(result, len + VARHDRSZ);
+        memcpy(VARDATA(result), data.data(), len);
+
+        stats_count_document(stats_protocol_of<Protocol>(), StatsEntryPoint::Row, result, 1);
+        return result;
+    } catch (const std::exception& ex) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("serialization failed"),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("serialization failed with unknown exception")));
+    }
+
+    return nullptr;
 }
 
-static std::string datum_to_string_output(Datum value, Oid typid)
+template<typename Protocol>
+static bytea* tuple_to_binary_slow(HeapTupleHeader rec)
 {
-    Oid typoutput;
-    bool typIsVarlena;
-    getTypeOutputInfo(typid, &typoutput, &typIsVarlena);
-    char* str = OidOutputFunctionCall(typoutput, value);
-    std::string out(str);
-    pfree(str);
-    return out;
+    try {
+        z::dyn::Value map = record_to_dynamic_map(rec);
+        z::ZBuffer buffer = z::serialize<Protocol>(map);
+        std::span<const uint8_t> data = buffer.buf();
+        size_t len = data.size();
+        bytea* result = (bytea*) palloc(len + VARHDRSZ);
+        SET_VARSIZE(result, len + VARHDRSZ);
+        memcpy(VARDATA(result), data.data(), len);
+        return result;
+    } catch (const std::exception& ex) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("slow-path serialization failed"),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("slow-path serialization failed with unknown exception")));
+    }
+    return nullptr;
 }
 
-static inline std::span<const std::byte> datum_bytea_span(Datum value)
+static bytea* dynamic_to_msgpack_binary(const z::dyn::Value& v)
 {
-    bytea* b = DatumGetByteaPP(value);
-    const std::byte* ptr = reinterpret_cast<const std::byte*>(VARDATA_ANY(b));
-    size_t len = static_cast<size_t>(VARSIZE_ANY_EXHDR(b));
-    return std::span<const std::byte>(ptr, len);
+    try {
+        z::ZBuffer buffer = z::serialize<z::MsgPack>(v);
+        std::span<const uint8_t> data = buffer.buf();
+        size_t len = data.size();
+        bytea* result = (bytea*) palloc(len + VARHDRSZ);
+        SET_VARSIZE(result, len + VARHDRSZ);
+        memcpy(VARDATA(result), data.data(), len);
+        return result;
+    } catch (const std::exception& ex) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("msgpack serialization failed"),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("msgpack serialization failed with unknown exception")));
+    }
+    return nullptr;
 }
 
-static inline std::span<const std::byte> datum_jsonb_span(Datum value)
-{
-    Jsonb* jb = DatumGetJsonbP(value);
-    const std::byte* ptr = reinterpret_cast<const std::byte*>(VARDATA_ANY(jb));
-    size_t len = static_cast<size_t>(VARSIZE_ANY_EXHDR(jb));
-    return std::span<const std::byte>(ptr, len);
+/*
+ * Generic helper function to convert array of PostgreSQL tuples to binary format
+ * This is the batch processing version for improved performance
+ * Template parameter determines the serialization protocol
+ */
+template<typename Protocol>
+static bytea* array_to_binary(ArrayType* arr, const ColumnProjection* projection = nullptr)
+{
+    // Get array element type (should be a record type)
+    Oid element_type = ARR_ELEMTYPE(arr);
+    int ndim = ARR_NDIM(arr);
+
+    // Handle empty arrays
+    if (ndim == 0 || ArrayGetNItems(ndim, ARR_DIMS(arr)) == 0) {
+        // Return empty array
+        z::ZBuffer buffer = z::serialize<Protocol>(z::dyn::Value::array(z::dyn::Value::Array()));
+        std::span<const uint8_t> data = buffer.buf();
+        size_t len = data.size();
+        bytea* result = (bytea*) palloc(len + VARHDRSZ);
+        SET_VARSIZE(result, len + VARHDRSZ);
+        memcpy(VARDATA(result), data.data(), len);
+        stats_count_document(stats_protocol_of<Protocol>(), StatsEntryPoint::Rows, result, 0);
+        return result;
+    }
+
+    // For now, handle 1D arrays (covers most use cases)
+    if (ndim > 1) {
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("multidimensional arrays not supported for batch serialization")));
+    }
+
+    // Batch functions only support arrays of records/composite values.
+    if (element_type != RECORDOID && get_typtype(element_type) != TYPTYPE_COMPOSITE) {
+        ereport(ERROR,
+                (errcode(ERRCODE_DATATYPE_MISMATCH),
+                 errmsg("batch serialization requires an array of composite records"),
+                 errdetail("Got array element type OID %u.", element_type)));
+    }
+
+    // Get array element info
+    int16 typlen;
+    bool typbyval;
+    char typalign;
+    get_typlenbyvalalign(element_type, &typlen, &typbyval, &typalign);
+
+    // Deconstruct array into elements
+    Datum* elements;
+    bool* nulls;
+    int nitems;
+
+    deconstruct_array(arr, element_type, typlen, typbyval, typalign,
+                     &elements, &nulls, &nitems);
+
+    bytea* fast = nullptr;
+    if constexpr (std::is_same_v<Protocol, z::MsgPack>) {
+        fast = try_serialize_msgpack_array_fast(elements, nulls, nitems, projection);
+    } else if constexpr (std::is_same_v<Protocol, z::CBOR>) {
+        fast = try_serialize_cbor_array_fast(elements, nulls, nitems, projection);
+    } else if constexpr (std::is_same_v<Protocol, z::Zera>) {
+        fast = try_serialize_zera_array_fast(elements, nulls, nitems, projection);
+    } else if constexpr (std::is_same_v<Protocol, z::Flex>) {
+        fast = try_serialize_flex_array_fast(elements, nulls, nitems, projection);
+    }
+    if (fast != nullptr) {
+        pfree(elements);
+        pfree(nulls);
+        stats_count_document(stats_protocol_of<Protocol>(), StatsEntryPoint::Rows, fast, nitems);
+        return fast;
+    }
+
+    // Build array of record maps with pre-allocated capacity
+    z::dyn::Value::Array result_array;
+    result_array.reserve(nitems);  // Pre-allocate array capacity
+
+    for (int i = 0; i < nitems; i++) {
+        if (nulls[i]) {
+            // Add null for NULL records
+            result_array.push_back(z::dyn::Value());
+        } else {
+            // Convert record to map
+            HeapTupleHeader rec = DatumGetHeapTupleHeader(elements[i]);
+            result_array.push_back(record_to_dynamic_map(rec, projection));
+        }
+    }
+
+    pfree(elements);
+    pfree(nulls);
+
+    try {
+        // Serialize the array
+        z::ZBuffer buffer = z::serialize<Protocol>(z::dyn::Value::array(std::move(result_array)));
+        std::span<const uint8_t> data = buffer.buf();
+
+        // Copy to PostgreSQL bytea
+        size_t len = data.size();
+        bytea* result = (bytea*) palloc(len + VARHDRSZ);
+        SET_VARSIZE(result, len + VARHDRSZ);
+        memcpy(VARDATA(result), data.data(), len);
+
+        stats_count_document(stats_protocol_of<Protocol>(), StatsEntryPoint::Rows, result, nitems);
+        return result;
+    } catch (const std::exception& ex) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("batch serialization failed"),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("batch serialization failed with unknown exception")));
+    }
+
+    return nullptr;
 }
 
-static z::dyn::Value datum_to_dynamic_cached(Datum value, bool isnull, const CachedColumn& col)
+template<typename Protocol>
+static bytea* array_to_binary_slow(ArrayType* arr)
 {
-    if (isnull) {
-        return z::dyn::Value();
+    Oid element_type = ARR_ELEMTYPE(arr);
+    int ndim = ARR_NDIM(arr);
+
+    if (ndim == 0 || ArrayGetNItems(ndim, ARR_DIMS(arr)) == 0) {
+        z::ZBuffer buffer = z::serialize<Protocol>(z::dyn::Value::array(z::dyn::Value::Array()));
+        std::span<const uint8_t> data = buffer.buf();
+        size_t len = data.size();
+        bytea* result = (bytea*) palloc(len + VARHDRSZ);
+        SET_VARSIZE(result, len + VARHDRSZ);
+        memcpy(VARDATA(result), data.data(), len);
+        return result;
     }
 
-    switch (col.kind) {
-        case ConverterKind::Int2:
-            return z::dyn::Value(static_cast<int64_t>(DatumGetInt16(value)));
-        case ConverterKind::Int4:
-            return z::dyn::Value(static_cast<int64_t>(DatumGetInt32(value)));
-        case ConverterKind::Int8:
-            return z::dyn::Value(static_cast<int64_t>(DatumGetInt64(value)));
-        case ConverterKind::Float4:
-            return z::dyn::Value(static_cast<double>(DatumGetFloat4(value)));
-        case ConverterKind::Float8:
-            return z::dyn::Value(DatumGetFloat8(value));
-        case ConverterKind::Bool:
-            return z::dyn::Value(DatumGetBool(value));
-        case ConverterKind::Text:
-        case ConverterKind::JsonText:
-        {
-            return z::dyn::Value(text_to_owned_string(value));
-        }
-        case ConverterKind::Uuid:
-            return z::dyn::Value(uuid_to_owned_string(value));
-        case ConverterKind::NameText:
-            return z::dyn::Value(std::string(name_text_view(value)));
-        case ConverterKind::CharText:
-            return z::dyn::Value(char_to_owned_string(value));
-        case ConverterKind::EnumText:
-            return z::dyn::Value(std::string(enum_label_view(value)));
-        case ConverterKind::InetText:
-        case ConverterKind::CidrText:
-        {
-            char out[kNetworkTextCapacity];
-            return z::dyn::Value(std::string(network_text_view(
-                value, col.kind == ConverterKind::CidrText, out)));
-        }
-        case ConverterKind::IntervalText:
-        {
-            char out[MAXDATELEN + 1];
-            return z::dyn::Value(std::string(interval_text_view(value, out)));
+    if (ndim > 1) {
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("multidimensional arrays not supported for batch serialization")));
+    }
+
+    if (element_type != RECORDOID && get_typtype(element_type) != TYPTYPE_COMPOSITE) {
+        ereport(ERROR,
+                (errcode(ERRCODE_DATATYPE_MISMATCH),
+                 errmsg("batch serialization requires an array of composite records"),
+                 errdetail("Got array element type OID %u.", element_type)));
+    }
+
+    int16 typlen;
+    bool typbyval;
+    char typalign;
+    get_typlenbyvalalign(element_type, &typlen, &typbyval, &typalign);
+
+    Datum* elements;
+    bool* nulls;
+    int nitems;
+    deconstruct_array(arr, element_type, typlen, typbyval, typalign, &elements, &nulls, &nitems);
+
+    z::dyn::Value::Array result_array;
+    result_array.reserve(nitems);
+
+    for (int i = 0; i < nitems; i++) {
+        if (nulls[i]) {
+            result_array.push_back(z::dyn::Value());
+        } else {
+            HeapTupleHeader rec = DatumGetHeapTupleHeader(elements[i]);
+            result_array.push_back(record_to_dynamic_map(rec));
         }
-        case ConverterKind::Numeric:
-            return numeric_to_dynamic_fast(value);
-        case ConverterKind::Date:
-            return z::dyn::Value(static_cast<int64_t>(DatumGetDateADT(value)));
-        case ConverterKind::Timestamp:
-            return z::dyn::Value(static_cast<int64_t>(DatumGetTimestamp(value)));
-        case ConverterKind::Timestamptz:
-            return z::dyn::Value(static_cast<int64_t>(DatumGetTimestampTz(value)));
-        case ConverterKind::Jsonb:
-            return z::dyn::Value::blob(datum_jsonb_span(value));
-        case ConverterKind::Bytea:
-            return z::dyn::Value::blob(datum_bytea_span(value));
-        case ConverterKind::Array:
-            return array_to_dynamic(value, col.typid);
-        case ConverterKind::Composite:
-            return record_to_dynamic_map(DatumGetHeapTupleHeader(value));
-        case ConverterKind::Fallback:
-            return fallback_to_text_output(value, col.typoutput);
     }
 
-    return z::dyn::Value();
-}
+    pfree(elements);
+    pfree(nulls);
 
-static bool is_msgpack_fast_kind(ConverterKind kind)
-{
-    switch (kind) {
-        case ConverterKind::Int2:
-        case ConverterKind::Int4:
-        case ConverterKind::Int8:
-        case ConverterKind::Float4:
-        case ConverterKind::Float8:
-        case ConverterKind::Bool:
-        case ConverterKind::Text:
-        case ConverterKind::JsonText:
-        case ConverterKind::Uuid:
-        case ConverterKind::NameText:
-        case ConverterKind::CharText:
-        case ConverterKind::EnumText:
-        case ConverterKind::InetText:
-        case ConverterKind::CidrText:
-        case ConverterKind::IntervalText:
-        case ConverterKind::Numeric:
-        case ConverterKind::Date:
-        case ConverterKind::Timestamp:
-        case ConverterKind::Timestamptz:
-        case ConverterKind::Jsonb:
-        case ConverterKind::Bytea:
-        case ConverterKind::Fallback:
-        case ConverterKind::Composite:
-            return true;
-        default:
-            return false;
+    try {
+        z::ZBuffer buffer = z::serialize<Protocol>(z::dyn::Value::array(std::move(result_array)));
+        std::span<const uint8_t> data = buffer.buf();
+        size_t len = data.size();
+        bytea* result = (bytea*) palloc(len + VARHDRSZ);
+        SET_VARSIZE(result, len + VARHDRSZ);
+        memcpy(VARDATA(result), data.data(), len);
+        return result;
+    } catch (const std::exception& ex) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("slow-path batch serialization failed"),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("slow-path batch serialization failed with unknown exception")));
     }
+
+    return nullptr;
 }
 
-static bool is_msgpack_fast_array_element_kind(ConverterKind kind)
+/*
+ * Deconstruct a batch whose layout is written once for all rows, and resolve
+ * the one row type every non-null element must share. Returns nullptr when
+ * no row is typed: an empty or all-NULL array of anonymous records.
+ */
+static const CachedSchema* batch_array_schema(
+    ArrayType* arr, Datum** elements_out, bool** nulls_out, int* nitems_out)
 {
-    switch (kind) {
-        case ConverterKind::Int2:
-        case ConverterKind::Int4:
-        case ConverterKind::Int8:
-        case ConverterKind::Float4:
-        case ConverterKind::Float8:
-        case ConverterKind::Bool:
-        case ConverterKind::Text:
-        case ConverterKind::JsonText:
-        case ConverterKind::Uuid:
-        case ConverterKind::NameText:
-        case ConverterKind::CharText:
-        case ConverterKind::EnumText:
-        case ConverterKind::InetText:
-        case ConverterKind::CidrText:
-        case ConverterKind::IntervalText:
-        case ConverterKind::Numeric:
-        case ConverterKind::Date:
-        case ConverterKind::Timestamp:
-        case ConverterKind::Timestamptz:
-        case ConverterKind::Jsonb:
-        case ConverterKind::Bytea:
-        case ConverterKind::Fallback:
-        case ConverterKind::Composite:
-            return true;
-        default:
-            return false;
+    Oid element_type = ARR_ELEMTYPE(arr);
+    int ndim = ARR_NDIM(arr);
+
+    if (ndim > 1) {
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("multidimensional arrays not supported for batch serialization")));
     }
-}
 
-static bool is_msgpack_fast_column(const CachedColumn& col)
-{
-    if (col.kind != ConverterKind::Array) {
-        return is_msgpack_fast_kind(col.kind);
+    if (element_type != RECORDOID && get_typtype(element_type) != TYPTYPE_COMPOSITE) {
+        ereport(ERROR,
+                (errcode(ERRCODE_DATATYPE_MISMATCH),
+                 errmsg("batch serialization requires an array of composite records"),
+                 errdetail("Got array element type OID %u.", element_type)));
     }
-    return OidIsValid(col.array_element_typid) &&
-           is_msgpack_fast_array_element_kind(col.array_element_kind);
-}
 
-static std::vector<uint8_t> encode_msgpack_string_key(std::string_view key)
-{
-    std::vector<uint8_t> out;
-    const size_t n = key.size();
+    Datum* elements = nullptr;
+    bool* nulls = nullptr;
+    int nitems = 0;
+    if (ndim == 1) {
+        int16 typlen;
+        bool typbyval;
+        char typalign;
+        get_typlenbyvalalign(element_type, &typlen, &typbyval, &typalign);
+        deconstruct_array(arr, element_type, typlen, typbyval, typalign,
+                          &elements, &nulls, &nitems);
+    }
 
-    if (n <= 31) {
-        out.reserve(1 + n);
-        out.push_back(static_cast<uint8_t>(0xA0u | static_cast<uint8_t>(n)));
-    } else if (n <= 0xFFu) {
-        out.reserve(2 + n);
-        out.push_back(0xD9u);
-        out.push_back(static_cast<uint8_t>(n));
-    } else if (n <= 0xFFFFu) {
-        out.reserve(3 + n);
-        out.push_back(0xDAu);
-        out.push_back(static_cast<uint8_t>((n >> 8) & 0xFFu));
-        out.push_back(static_cast<uint8_t>(n & 0xFFu));
-    } else if (n <= 0xFFFFFFFFu) {
-        out.reserve(5 + n);
-        out.push_back(0xDBu);
-        out.push_back(static_cast<uint8_t>((n >> 24) & 0xFFu));
-        out.push_back(static_cast<uint8_t>((n >> 16) & 0xFFu));
-        out.push_back(static_cast<uint8_t>((n >> 8) & 0xFFu));
-        out.push_back(static_cast<uint8_t>(n & 0xFFu));
-    } else {
-        ereport(ERROR,
-                (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
-                 errmsg("map key length exceeds MessagePack limits")));
+    // A named row type fixes the columns even when every row is NULL.
+    const CachedSchema* schema = nullptr;
+    Oid tupType = InvalidOid;
+    int32 tupTypmod = -1;
+    if (element_type != RECORDOID) {
+        tupType = element_type;
+        schema = &get_cached_schema(tupType, tupTypmod);
+    }
+    for (int i = 0; i < nitems; i++) {
+        if (nulls[i]) {
+            continue;
+        }
+        HeapTupleHeader rec = DatumGetHeapTupleHeader(elements[i]);
+        if (schema == nullptr) {
+            tupType = HeapTupleHeaderGetTypeId(rec);
+            tupTypmod = HeapTupleHeaderGetTypMod(rec);
+            schema = &get_cached_schema(tupType, tupTypmod);
+        } else if (HeapTupleHeaderGetTypeId(rec) != tupType ||
+                   HeapTupleHeaderGetTypMod(rec) != tupTypmod) {
+            ereport(ERROR,
+                    (errcode(ERRCODE_DATATYPE_MISMATCH),
+                     errmsg("batch serialization requires rows of a single type")));
+        }
     }
 
-    out.insert(out.end(), key.begin(), key.end());
-    return out;
+    *elements_out = elements;
+    *nulls_out = nulls;
+    *nitems_out = nitems;
+    return schema;
 }
 
-static std::vector<uint8_t> encode_msgpack_map_header(size_t n)
+/*
+ * Convert an array of records to the compact batch form. Every non-null row
+ * must share one row type, since the column list is written only once.
+ */
+template<typename Protocol>
+static bytea* array_to_compact_binary(ArrayType* arr)
 {
-    std::vector<uint8_t> out;
-    if (n <= 15u) {
-        out.reserve(1);
-        out.push_back(static_cast<uint8_t>(0x80u | static_cast<uint8_t>(n)));
-        return out;
+    Datum* elements;
+    bool* nulls;
+    int nitems;
+    const CachedSchema* schema = batch_array_schema(arr, &elements, &nulls, &nitems);
+
+    bytea* fast = nullptr;
+    if constexpr (std::is_same_v<Protocol, z::MsgPack>) {
+        fast = try_serialize_msgpack_compact_fast(schema, elements, nulls, nitems);
+    } else if constexpr (std::is_same_v<Protocol, z::CBOR>) {
+        fast = try_serialize_cbor_compact_fast(schema, elements, nulls, nitems);
+    } else if constexpr (std::is_same_v<Protocol, z::Zera>) {
+        fast = try_serialize_zera_compact_fast(schema, elements, nulls, nitems);
+    }
+    if (fast != nullptr) {
+        if (elements != nullptr) {
+            pfree(elements);
+            pfree(nulls);
+        }
+        stats_count_document(stats_protocol_of<Protocol>(), StatsEntryPoint::Compact, fast, nitems);
+        return fast;
     }
 
-    if (n <= 0xFFFFu) {
-        out.reserve(3);
-        out.push_back(0xDEu);
-        out.push_back(static_cast<uint8_t>((n >> 8) & 0xFFu));
-        out.push_back(static_cast<uint8_t>(n & 0xFFu));
-        return out;
+    z::dyn::Value::Array columns;
+    columns.reserve(schema->columns.size());
+    for (const CachedColumn& col : schema->columns) {
+        columns.push_back(z::dyn::Value(col.name));
     }
 
-    if (n <= 0xFFFFFFFFu) {
-        out.reserve(5);
-        out.push_back(0xDFu);
-        out.push_back(static_cast<uint8_t>((n >> 24) & 0xFFu));
-        out.push_back(static_cast<uint8_t>((n >> 16) & 0xFFu));
-        out.push_back(static_cast<uint8_t>((n >> 8) & 0xFFu));
-        out.push_back(static_cast<uint8_t>(n & 0xFFu));
-        return out;
+    z::dyn::Value::Array rows;
+    rows.reserve(nitems);
+    for (int i = 0; i < nitems; i++) {
+        if (nulls[i]) {
+            rows.push_back(z::dyn::Value());
+            continue;
+        }
+        HeapTupleData tuple;
+        tuple.t_len = HeapTupleHeaderGetDatumLength(DatumGetHeapTupleHeader(elements[i]));
+        tuple.t_data = DatumGetHeapTupleHeader(elements[i]);
+        z::dyn::Value::Array values;
+        values.reserve(schema->columns.size());
+        for (const CachedColumn& col : schema->columns) {
+            bool isnull;
+            Datum value = heap_getattr(&tuple, col.attnum, schema->tupdesc, &isnull);
+            values.push_back(datum_to_dynamic_cached(value, isnull, col));
+        }
+        rows.push_back(z::dyn::Value::array(std::move(values)));
     }
 
-    ereport(ERROR,
-            (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
-             errmsg("map field count exceeds MessagePack limits")));
-}
+    if (elements != nullptr) {
+        pfree(elements);
+        pfree(nulls);
+    }
 
-static std::vector<uint8_t> encode_zera_key(std::string_view key)
-{
-    if (key.size() > 0xFFFFu) {
+    try {
+        z::dyn::Value::Map entries;
+        entries.emplace_back("columns", z::dyn::Value::array(std::move(columns)));
+        entries.emplace_back("rows", z::dyn::Value::array(std::move(rows)));
+        z::ZBuffer buffer = z::serialize<Protocol>(z::dyn::Value::map(std::move(entries)));
+        std::span<const uint8_t> data = buffer.buf();
+        size_t len = data.size();
+        bytea* result = (bytea*) palloc(len + VARHDRSZ);
+        SET_VARSIZE(result, len + VARHDRSZ);
+        memcpy(VARDATA(result), data.data(), len);
+        stats_count_document(stats_protocol_of<Protocol>(), StatsEntryPoint::Compact, result, nitems);
+        return result;
+    } catch (const std::exception& ex) {
         ereport(ERROR,
-                (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
-                 errmsg("map key length exceeds ZERA key limit")));
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("compact batch serialization failed"),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("compact batch serialization failed with unknown exception")));
     }
 
-    std::vector<uint8_t> out;
-    out.reserve(4 + key.size());
-    const uint16_t len = static_cast<uint16_t>(key.size());
-    out.push_back(static_cast<uint8_t>(len & 0xFFu));
-    out.push_back(static_cast<uint8_t>((len >> 8) & 0xFFu));
-    out.push_back(0);
-    out.push_back(0);
-    out.insert(out.end(), key.begin(), key.end());
-    return out;
-}
-
-static inline void msgpack_write_text(z::MsgPackSerializer& writer, Datum value)
-{
-    text* txt = DatumGetTextPP(value);
-    const char* ptr = VARDATA_ANY(txt);
-    int len = VARSIZE_ANY_EXHDR(txt);
-    writer.string(std::string_view(ptr, static_cast<size_t>(len)));
+    return nullptr;
 }
 
-static inline void msgpack_write_record_map(
-    z::MsgPackSerializer& writer,
-    HeapTupleHeader rec,
-    const CachedSchema& schema,
-    TupleDeformScratch* scratch);
+/*
+ * Columnar ZERA batches transpose the rows into one buffer per column:
+ *
+ *   {"rows": n, "columns": {name: {"type": ..., "layout": ..., ...}}}
+ *
+ * "fixed" columns carry "dtype" (the codes of zerialize's tensor helpers),
+ * "shape" [n] and "data", n little-endian values with zeros under NULLs.
+ * "utf8" and "binary" columns carry "offsets", n + 1 int32 positions into
+ * the "data" bytes. "validity" is an LSB-first bitmap with a bit set for each
+ * non-null value, or null when the column has no NULLs. Blobs start on ZERA's
+ * arena alignment, so readers can map them in place.
+ */
+enum class ColumnarDType : int64_t {
+    None = 0,
+    Int16 = 1,
+    Int32 = 2,
+    Int64 = 3,
+    UInt8 = 4,
+    Float32 = 10,
+    Float64 = 11,
+};
 
-static inline void msgpack_array_elem_unsupported(
-    z::MsgPackSerializer& writer,
-    Datum value,
-    bool isnull)
+static ColumnarDType columnar_dtype(ConverterKind kind)
 {
-    (void)writer;
-    (void)value;
-    (void)isnull;
-    ereport(ERROR,
-            (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-             errmsg("unsupported array element type for fast MessagePack path")));
+    switch (kind) {
+        case ConverterKind::Int2: return ColumnarDType::Int16;
+        case ConverterKind::Int4: return ColumnarDType::Int32;
+        case ConverterKind::Date: return ColumnarDType::Int32;
+        case ConverterKind::Int8: return ColumnarDType::Int64;
+        case ConverterKind::Timestamp: return ColumnarDType::Int64;
+        case ConverterKind::Timestamptz: return ColumnarDType::Int64;
+        case ConverterKind::Bool: return ColumnarDType::UInt8;
+        case ConverterKind::Float4: return ColumnarDType::Float32;
+        case ConverterKind::Float8: return ColumnarDType::Float64;
+        default: return ColumnarDType::None;
+    }
 }
 
-static inline void msgpack_array_elem_composite(
-    z::MsgPackSerializer& writer, Datum value, bool isnull)
+template<typename T>
+static inline void columnar_store(uint8_t* out, T v)
 {
-    if (isnull) { writer.null(); return; }
-    HeapTupleHeader rec = DatumGetHeapTupleHeader(value);
-    const CachedSchema& schema = get_cached_schema(
-        HeapTupleHeaderGetTypeId(rec), HeapTupleHeaderGetTypMod(rec));
-    TupleDeformScratch scratch;
-    msgpack_write_record_map(writer, rec, schema, &scratch);
+    if constexpr (std::endian::native == std::endian::little) {
+        memcpy(out, &v, sizeof(T));
+    } else {
+        const auto* bytes = reinterpret_cast<const uint8_t*>(&v);
+        for (size_t b = 0; b < sizeof(T); b++) {
+            out[b] = bytes[sizeof(T) - 1 - b];
+        }
+    }
 }
 
-static inline void msgpack_array_elem_int2(z::MsgPackSerializer& writer, Datum value, bool isnull)
+template<typename T, typename Get>
+static void columnar_fill(
+    std::vector<uint8_t>& data, const Datum* values, const bool* nulls, int nrows, Get get)
 {
-    if (isnull) { writer.null(); return; }
-    writer.int64(static_cast<int64_t>(DatumGetInt16(value)));
+    data.assign(sizeof(T) * static_cast<size_t>(nrows), 0);
+    uint8_t* out = data.data();
+    for (int i = 0; i < nrows; i++) {
+        if (!nulls[i]) {
+            columnar_store<T>(out + sizeof(T) * i, get(values[i]));
+        }
+    }
 }
 
-static inline void msgpack_array_elem_int4(z::MsgPackSerializer& writer, Datum value, bool isnull)
+static void columnar_fill_fixed(
+    std::vector<uint8_t>& data, ConverterKind kind, const Datum* values, const bool* nulls,
+    int nrows)
 {
-    if (isnull) { writer.null(); return; }
-    writer.int64(static_cast<int64_t>(DatumGetInt32(value)));
+    switch (kind) {
+        case ConverterKind::Int2:
+            columnar_fill<int16_t>(data, values, nulls, nrows, [](Datum d) { return DatumGetInt16(d); });
+            return;
+        case ConverterKind::Int4:
+            columnar_fill<int32_t>(data, values, nulls, nrows, [](Datum d) { return DatumGetInt32(d); });
+            return;
+        case ConverterKind::Date:
+            columnar_fill<int32_t>(data, values, nulls, nrows, [](Datum d) { return DatumGetDateADT(d); });
+            return;
+        case ConverterKind::Int8:
+            columnar_fill<int64_t>(data, values, nulls, nrows, [](Datum d) { return DatumGetInt64(d); });
+            return;
+        case ConverterKind::Timestamp:
+            columnar_fill<int64_t>(data, values, nulls, nrows, [](Datum d) { return DatumGetTimestamp(d); });
+            return;
+        case ConverterKind::Timestamptz:
+            columnar_fill<int64_t>(data, values, nulls, nrows, [](Datum d) { return DatumGetTimestampTz(d); });
+            return;
+        case ConverterKind::Bool:
+            columnar_fill<uint8_t>(data, values, nulls, nrows,
+                                   [](Datum d) { return static_cast<uint8_t>(DatumGetBool(d)); });
+            return;
+        case ConverterKind::Float4:
+            columnar_fill<float>(data, values, nulls, nrows, [](Datum d) { return DatumGetFloat4(d); });
+            return;
+        case ConverterKind::Float8:
+            columnar_fill<double>(data, values, nulls, nrows, [](Datum d) { return DatumGetFloat8(d); });
+            return;
+        default:
+            break;
+    }
 }
 
-static inline void msgpack_array_elem_int8(z::MsgPackSerializer& writer, Datum value, bool isnull)
+/*
+ * Append one variable-width value. Strings match the row writers; types
+ * without a string form there use their output function text.
+ */
+static void columnar_append_value(std::vector<uint8_t>& data, const CachedColumn& col, Datum value)
 {
-    if (isnull) { writer.null(); return; }
-    writer.int64(static_cast<int64_t>(DatumGetInt64(value)));
-}
+    auto append = [&data](const void* ptr, size_t len) {
+        const auto* bytes = static_cast<const uint8_t*>(ptr);
+        data.insert(data.end(), bytes, bytes + len);
+    };
 
-static inline void msgpack_array_elem_float4(z::MsgPackSerializer& writer, Datum value, bool isnull)
-{
-    if (isnull) { writer.null(); return; }
-    writer.double_(static_cast<double>(DatumGetFloat4(value)));
+    switch (col.kind) {
+        case ConverterKind::Text:
+        case ConverterKind::JsonText:
+        {
+            text* txt = DatumGetTextPP(value);
+            append(VARDATA_ANY(txt), VARSIZE_ANY_EXHDR(txt));
+            return;
+        }
+        case ConverterKind::NameText:
+        case ConverterKind::EnumText:
+        {
+            std::string_view sv = col.kind == ConverterKind::NameText
+                                      ? name_text_view(value)
+                                      : enum_label_view(value);
+            append(sv.data(), sv.size());
+            return;
+        }
+        case ConverterKind::CharText:
+        {
+            char ch = DatumGetChar(value);
+            append(&ch, ch == '\0' ? 0 : 1);
+            return;
+        }
+        case ConverterKind::Uuid:
+        {
+            char out[36];
+            format_uuid(value, out);
+            append(out, sizeof(out));
+            return;
+        }
+        case ConverterKind::Bytea:
+        case ConverterKind::Jsonb:
+        {
+            std::span<const std::byte> bytes = col.kind == ConverterKind::Bytea
+                                                   ? datum_bytea_span(value)
+                                                   : datum_jsonb_span(value);
+            append(bytes.data(), bytes.size());
+            return;
+        }
+        default:
+        {
+            char* str = OidOutputFunctionCall(col.typoutput, value);
+            append(str, strlen(str));
+            pfree(str);
+            return;
+        }
+    }
 }
 
-static inline void msgpack_array_elem_float8(z::MsgPackSerializer& writer, Datum value, bool isnull)
+static std::span<const std::byte> columnar_bytes(const std::vector<uint8_t>& data)
 {
-    if (isnull) { writer.null(); return; }
-    writer.double_(DatumGetFloat8(value));
+    return std::as_bytes(std::span<const uint8_t>(data));
 }
 
-static inline void msgpack_array_elem_bool(z::MsgPackSerializer& writer, Datum value, bool isnull)
+static void zera_write_columnar_column(
+    z::zera::Serializer& writer, const CachedColumn& col, const Datum* values,
+    const bool* nulls, int nrows)
 {
-    if (isnull) { writer.null(); return; }
-    writer.boolean(DatumGetBool(value));
-}
+    std::vector<uint8_t> validity((static_cast<size_t>(nrows) + 7) / 8, 0);
+    bool has_nulls = false;
+    for (int i = 0; i < nrows; i++) {
+        if (nulls[i]) {
+            has_nulls = true;
+        } else {
+            validity[i >> 3] |= static_cast<uint8_t>(1u << (i & 7));
+        }
+    }
+
+    char* type_name = format_type_be(col.typid);
+    writer.begin_map(6);
+    writer.key("type");
+    writer.string(type_name);
+    pfree(type_name);
+
+    std::vector<uint8_t> data;
+    const ColumnarDType dtype = columnar_dtype(col.kind);
+    if (dtype != ColumnarDType::None) {
+        columnar_fill_fixed(data, col.kind, values, nulls, nrows);
+        writer.key("layout");
+        writer.string("fixed");
+        writer.key("dtype");
+        writer.int64(static_cast<int64_t>(dtype));
+        writer.key("shape");
+        writer.begin_array(1);
+        writer.int64(nrows);
+        writer.end_array();
+    } else {
+        std::vector<uint8_t> offsets(sizeof(int32_t) * (static_cast<size_t>(nrows) + 1));
+        for (int i = 0; i <= nrows; i++) {
+            if (data.size() > static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+                throw z::SerializationError("columnar data exceeds int32 offsets");
+            }
+            columnar_store<int32_t>(offsets.data() + sizeof(int32_t) * i,
+                                    static_cast<int32_t>(data.size()));
+            if (i < nrows && !nulls[i]) {
+                columnar_append_value(data, col, values[i]);
+            }
+        }
 
-static inline void msgpack_array_elem_text(z::MsgPackSerializer& writer, Datum value, bool isnull)
-{
-    if (isnull) { writer.null(); return; }
-    msgpack_write_text(writer, value);
+        const bool binary = col.kind == ConverterKind::Bytea || col.kind == ConverterKind::Jsonb;
+        writer.key("layout");
+        writer.string(binary ? "binary" : "utf8");
+        writer.key("offsets");
+        writer.binary(columnar_bytes(offsets));
+    }
+    writer.key("data");
+    writer.binary(columnar_bytes(data));
+    writer.key("validity");
+    if (has_nulls) {
+        writer.binary(columnar_bytes(validity));
+    } else {
+        writer.null();
+    }
+    writer.end_map();
 }
 
-static inline void msgpack_array_elem_uuid(z::MsgPackSerializer& writer, Datum value, bool isnull)
+static bytea* array_to_zera_columnar(ArrayType* arr)
 {
-    if (isnull) { writer.null(); return; }
-    char out[36];
-    format_uuid(value, out);
-    writer.string(std::string_view(out, sizeof(out)));
-}
+    Datum* elements;
+    bool* nulls;
+    int nitems;
+    const CachedSchema* schema = batch_array_schema(arr, &elements, &nulls, &nitems);
+    const size_t ncols = schema != nullptr ? schema->columns.size() : 0;
 
-static inline void msgpack_array_elem_name(z::MsgPackSerializer& writer, Datum value, bool isnull)
-{
-    if (isnull) { writer.null(); return; }
-    writer.string(name_text_view(value));
-}
+    // Deform each row once into column-major storage.
+    const size_t cells = Max(ncols * static_cast<size_t>(nitems), static_cast<size_t>(1));
+    auto* values = static_cast<Datum*>(MemoryContextAllocHuge(CurrentMemoryContext, sizeof(Datum) * cells));
+    auto* isnull = static_cast<bool*>(MemoryContextAllocHuge(CurrentMemoryContext, sizeof(bool) * cells));
+    TupleDeformScratch scratch;
+    for (int i = 0; i < nitems; i++) {
+        if (nulls[i]) {
+            for (size_t c = 0; c < ncols; c++) {
+                isnull[c * nitems + i] = true;
+            }
+            continue;
+        }
+        HeapTupleHeader rec = DatumGetHeapTupleHeader(elements[i]);
+        HeapTupleData tuple;
+        tuple.t_len = HeapTupleHeaderGetDatumLength(rec);
+        tuple.t_data = rec;
+        scratch.ensure(static_cast<size_t>(schema->tupdesc->natts));
+        heap_deform_tuple(&tuple, schema->tupdesc, scratch.values, scratch.nulls);
+        for (size_t c = 0; c < ncols; c++) {
+            const int idx = schema->columns[c].attnum - 1;
+            values[c * nitems + i] = scratch.values[idx];
+            isnull[c * nitems + i] = scratch.nulls[idx];
+        }
+    }
 
-static inline void msgpack_array_elem_char(z::MsgPackSerializer& writer, Datum value, bool isnull)
-{
-    if (isnull) { writer.null(); return; }
-    char ch = DatumGetChar(value);
-    writer.string(std::string_view(&ch, ch == '\0' ? 0 : 1));
+    try {
+        z::zera::RootSerializer& rs = zera_reusable_root();
+        z::zera::Serializer writer(rs);
+        writer.begin_map(2);
+        writer.key("rows");
+        writer.int64(nitems);
+        writer.key("columns");
+        writer.begin_map(ncols);
+        for (size_t c = 0; c < ncols; c++) {
+            const CachedColumn& col = schema->columns[c];
+            writer.key(col.name);
+            zera_write_columnar_column(writer, col, values + c * nitems, isnull + c * nitems, nitems);
+        }
+        writer.end_map();
+        writer.end_map();
+
+        bytea* result = zera_result_from_root(rs);
+        pfree(values);
+        pfree(isnull);
+        return result;
+    } catch (const std::exception& ex) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("columnar ZERA batch serialization failed"),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("columnar ZERA batch serialization failed with unknown exception")));
+    }
+
+    return nullptr;
 }
 
-static inline void msgpack_array_elem_enum(z::MsgPackSerializer& writer, Datum value, bool isnull)
+/*
+ * Single record serialization functions
+ */
+
+/*
+ * row_to_flexbuffers - Convert PostgreSQL record to FlexBuffers binary format
+ */
+extern "C" Datum
+row_to_flexbuffers(PG_FUNCTION_ARGS)
 {
-    if (isnull) { writer.null(); return; }
-    writer.string(enum_label_view(value));
-}
+    HeapTupleHeader rec;
+    bytea* result;
 
-static inline void msgpack_array_elem_inet(z::MsgPackSerializer& writer, Datum value, bool isnull)
-{
-    if (isnull) { writer.null(); return; }
-    write_network_string(writer, value, false);
-}
+    // Get the record argument
+    rec = PG_GETARG_HEAPTUPLEHEADER(0);
 
-static inline void msgpack_array_elem_cidr(z::MsgPackSerializer& writer, Datum value, bool isnull)
-{
-    if (isnull) { writer.null(); return; }
-    write_network_string(writer, value, true);
-}
+    // Convert to FlexBuffers
+    result = tuple_to_binary<z::Flex>(rec, nullptr, fcinfo);
 
-static inline void msgpack_array_elem_interval(z::MsgPackSerializer& writer, Datum value, bool isnull)
-{
-    if (isnull) { writer.null(); return; }
-    write_interval_string(writer, value);
+    PG_RETURN_BYTEA_P(result);
 }
 
-static inline void msgpack_array_elem_numeric(z::MsgPackSerializer& writer, Datum value, bool isnull)
+/*
+ * row_to_msgpack - Convert PostgreSQL record to MessagePack binary format
+ */
+extern "C" Datum
+row_to_msgpack(PG_FUNCTION_ARGS)
 {
-    if (isnull) { writer.null(); return; }
-    numeric_write_fast(writer, value);
-}
+    HeapTupleHeader rec;
+    bytea* result;
 
-static inline void msgpack_array_elem_date(z::MsgPackSerializer& writer, Datum value, bool isnull)
-{
-    if (isnull) { writer.null(); return; }
-    writer.int64(static_cast<int64_t>(DatumGetDateADT(value)));
-}
+    // Get the record argument
+    rec = PG_GETARG_HEAPTUPLEHEADER(0);
 
-static inline void msgpack_array_elem_timestamp(z::MsgPackSerializer& writer, Datum value, bool isnull)
-{
-    if (isnull) { writer.null(); return; }
-    writer.int64(static_cast<int64_t>(DatumGetTimestamp(value)));
-}
+    // Convert to MessagePack
+    result = tuple_to_binary<z::MsgPack>(rec, nullptr, fcinfo);
 
-static inline void msgpack_array_elem_timestamptz(z::MsgPackSerializer& writer, Datum value, bool isnull)
-{
-    if (isnull) { writer.null(); return; }
-    writer.int64(static_cast<int64_t>(DatumGetTimestampTz(value)));
+    PG_RETURN_BYTEA_P(result);
 }
 
-static inline void msgpack_array_elem_jsonb(z::MsgPackSerializer& writer, Datum value, bool isnull)
+/*
+ * row_to_msgpack_slow - Convert PostgreSQL record to MessagePack via generic dynamic path
+ * Useful for parity/correctness testing against fast path.
+ */
+extern "C" Datum
+row_to_msgpack_slow(PG_FUNCTION_ARGS)
 {
-    if (isnull) { writer.null(); return; }
-    writer.binary(datum_jsonb_span(value));
+    HeapTupleHeader rec;
+    bytea* result;
+
+    rec = PG_GETARG_HEAPTUPLEHEADER(0);
+    result = tuple_to_binary_slow<z::MsgPack>(rec);
+    PG_RETURN_BYTEA_P(result);
 }
 
-static inline void msgpack_array_elem_bytea(z::MsgPackSerializer& writer, Datum value, bool isnull)
+/*
+ * msgpack_from_jsonb - Convert nested jsonb to nested MessagePack.
+ * This is the core bridge for SQL builder parity workflows.
+ */
+extern "C" Datum
+msgpack_from_jsonb(PG_FUNCTION_ARGS)
 {
-    if (isnull) { writer.null(); return; }
-    writer.binary(datum_bytea_span(value));
+    Jsonb* jb = PG_GETARG_JSONB_P(0);
+    z::dyn::Value v = jsonb_to_dynamic(jb, numeric_encoding);
+    bytea* result = dynamic_to_msgpack_binary(v);
+    PG_RETURN_BYTEA_P(result);
 }
 
-static MsgpackArrayElemWriterFn select_msgpack_array_elem_writer(ConverterKind kind)
+/*
+ * msgpack_to_jsonb - Safely decode one complete MessagePack value to jsonb.
+ */
+extern "C" Datum
+msgpack_to_jsonb(PG_FUNCTION_ARGS)
 {
-    switch (kind) {
-        case ConverterKind::Int2: return &msgpack_array_elem_int2;
-        case ConverterKind::Int4: return &msgpack_array_elem_int4;
-        case ConverterKind::Int8: return &msgpack_array_elem_int8;
-        case ConverterKind::Float4: return &msgpack_array_elem_float4;
-        case ConverterKind::Float8: return &msgpack_array_elem_float8;
-        case ConverterKind::Bool: return &msgpack_array_elem_bool;
-        case ConverterKind::Text:
-        case ConverterKind::JsonText:
-            return &msgpack_array_elem_text;
-        case ConverterKind::Uuid: return &msgpack_array_elem_uuid;
-        case ConverterKind::NameText: return &msgpack_array_elem_name;
-        case ConverterKind::CharText: return &msgpack_array_elem_char;
-        case ConverterKind::EnumText: return &msgpack_array_elem_enum;
-        case ConverterKind::InetText: return &msgpack_array_elem_inet;
-        case ConverterKind::CidrText: return &msgpack_array_elem_cidr;
-        case ConverterKind::IntervalText: return &msgpack_array_elem_interval;
-        case ConverterKind::Numeric: return &msgpack_array_elem_numeric;
-        case ConverterKind::Date: return &msgpack_array_elem_date;
-        case ConverterKind::Timestamp: return &msgpack_array_elem_timestamp;
-        case ConverterKind::Timestamptz: return &msgpack_array_elem_timestamptz;
-        case ConverterKind::Jsonb: return &msgpack_array_elem_jsonb;
-        case ConverterKind::Bytea: return &msgpack_array_elem_bytea;
-        case ConverterKind::Composite: return &msgpack_array_elem_composite;
-        default: return &msgpack_array_elem_unsupported;
+    bytea* input = PG_GETARG_BYTEA_PP(0);
+    std::span<const uint8_t> data = decoder_input(input, frame_protocol_of<z::MsgPack>());
+
+    try {
+        const size_t consumed = msgpack_validate_value(data, 0);
+        if (consumed != data.size()) {
+            throw z::DeserializationError("trailing bytes after MessagePack value");
+        }
+
+        JsonbDecodeWriter writer;
+        msgpack_replay_value(data, 0, writer);
+        Jsonb* result = writer.finish();
+        PG_FREE_IF_COPY(input, 0);
+        PG_RETURN_JSONB_P(result);
+    } catch (const std::exception& ex) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                 errmsg("invalid MessagePack input"),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                 errmsg("invalid MessagePack input"),
+                 errdetail("unknown decoding error")));
     }
+
+    PG_RETURN_NULL();
 }
 
-static inline void msgpack_write_array_no_nulls(
-    z::MsgPackSerializer& writer,
-    ConverterKind elem_kind,
-    Datum* elements,
-    int nitems)
+/*
+ * flexbuffers_to_jsonb - Verify and decode one FlexBuffer value to jsonb.
+ */
+extern "C" Datum
+flexbuffers_to_jsonb(PG_FUNCTION_ARGS)
 {
-    switch (elem_kind) {
-        case ConverterKind::Int2:
-            for (int i = 0; i < nitems; i++) {
-                writer.int64(static_cast<int64_t>(DatumGetInt16(elements[i])));
-            }
-            return;
-        case ConverterKind::Int4:
-            for (int i = 0; i < nitems; i++) {
-                writer.int64(static_cast<int64_t>(DatumGetInt32(elements[i])));
-            }
-            return;
-        case ConverterKind::Int8:
-            for (int i = 0; i < nitems; i++) {
-                writer.int64(static_cast<int64_t>(DatumGetInt64(elements[i])));
-            }
-            return;
-        case ConverterKind::Float4:
-            for (int i = 0; i < nitems; i++) {
-                writer.double_(static_cast<double>(DatumGetFloat4(elements[i])));
-            }
-            return;
-        case ConverterKind::Float8:
-            for (int i = 0; i < nitems; i++) {
-                writer.double_(DatumGetFloat8(elements[i]));
-            }
-            return;
-        case ConverterKind::Bool:
-            for (int i = 0; i < nitems; i++) {
-                writer.boolean(DatumGetBool(elements[i]));
-            }
-            return;
-        case ConverterKind::Text:
-        case ConverterKind::JsonText:
-            for (int i = 0; i < nitems; i++) {
-                msgpack_write_text(writer, elements[i]);
-            }
-            return;
-        case ConverterKind::Uuid:
-            for (int i = 0; i < nitems; i++) {
-                char out[36];
-                format_uuid(elements[i], out);
-                writer.string(std::string_view(out, sizeof(out)));
-            }
-            return;
-        case ConverterKind::NameText:
-            for (int i = 0; i < nitems; i++) {
-                writer.string(name_text_view(elements[i]));
-            }
-            return;
-        case ConverterKind::CharText:
-            for (int i = 0; i < nitems; i++) {
-                char ch = DatumGetChar(elements[i]);
-                writer.string(std::string_view(&ch, ch == '\0' ? 0 : 1));
-            }
-            return;
-        case ConverterKind::EnumText:
-            for (int i = 0; i < nitems; i++) {
-                writer.string(enum_label_view(elements[i]));
-            }
-            return;
-        case ConverterKind::InetText:
-            for (int i = 0; i < nitems; i++) {
-                write_network_string(writer, elements[i], false);
-            }
-            return;
-        case ConverterKind::CidrText:
-            for (int i = 0; i < nitems; i++) {
-                write_network_string(writer, elements[i], true);
-            }
-            return;
-        case ConverterKind::IntervalText:
-            for (int i = 0; i < nitems; i++) {
-                write_interval_string(writer, elements[i]);
-            }
-            return;
-        case ConverterKind::Numeric:
-            for (int i = 0; i < nitems; i++) {
-                numeric_write_fast(writer, elements[i]);
-            }
-            return;
-        case ConverterKind::Date:
-            for (int i = 0; i < nitems; i++) {
-                writer.int64(static_cast<int64_t>(DatumGetDateADT(elements[i])));
-            }
-            return;
-        case ConverterKind::Timestamp:
-            for (int i = 0; i < nitems; i++) {
-                writer.int64(static_cast<int64_t>(DatumGetTimestamp(elements[i])));
-            }
-            return;
-        case ConverterKind::Timestamptz:
-            for (int i = 0; i < nitems; i++) {
-                writer.int64(static_cast<int64_t>(DatumGetTimestampTz(elements[i])));
-            }
-            return;
-        case ConverterKind::Jsonb:
-            for (int i = 0; i < nitems; i++) {
-                writer.binary(datum_jsonb_span(elements[i]));
-            }
-            return;
-        case ConverterKind::Bytea:
-            for (int i = 0; i < nitems; i++) {
-                writer.binary(datum_bytea_span(elements[i]));
-            }
-            return;
-        case ConverterKind::Composite:
-            for (int i = 0; i < nitems; i++) {
-                msgpack_array_elem_composite(writer, elements[i], false);
-            }
-            return;
-        default:
-            ereport(ERROR,
-                    (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-                     errmsg("unsupported array element type for fast MessagePack path")));
+    bytea* input = PG_GETARG_BYTEA_PP(0);
+    std::span<const uint8_t> data = decoder_input(input, frame_protocol_of<z::Flex>());
+    const uint8_t* bytes = data.data();
+    const size_t length = data.size();
+
+    try {
+        if (!::flexbuffers::VerifyBuffer(bytes, length)) {
+            throw z::DeserializationError("FlexBuffer verification failed");
+        }
+
+        ::flexbuffers::Reference root = ::flexbuffers::GetRoot(bytes, length);
+        JsonbDecodeWriter writer;
+        flex_replay_reference(root, writer);
+        Jsonb* result = writer.finish();
+        PG_FREE_IF_COPY(input, 0);
+        PG_RETURN_JSONB_P(result);
+    } catch (const std::exception& ex) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                 errmsg("invalid FlexBuffer input"),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                 errmsg("invalid FlexBuffer input"),
+                 errdetail("unknown decoding error")));
     }
+
+    PG_RETURN_NULL();
 }
 
-static inline void msgpack_store_be16(uint8_t* out, uint16_t value)
+/*
+ * cbor_to_jsonb - Strictly parse one complete CBOR value to jsonb.
+ */
+extern "C" Datum
+cbor_to_jsonb(PG_FUNCTION_ARGS)
 {
-    out[0] = static_cast<uint8_t>(value >> 8);
-    out[1] = static_cast<uint8_t>(value);
+    bytea* input = PG_GETARG_BYTEA_PP(0);
+    std::span<const uint8_t> data = decoder_input(input, frame_protocol_of<z::CBOR>());
+
+    try {
+        JsonbDecodeWriter writer;
+        const size_t consumed = cbor_replay_value(data, 0, writer);
+        if (consumed != data.size()) {
+            throw z::DeserializationError("trailing bytes after CBOR value");
+        }
+        Jsonb* result = writer.finish();
+        PG_FREE_IF_COPY(input, 0);
+        PG_RETURN_JSONB_P(result);
+    } catch (const std::exception& ex) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                 errmsg("invalid CBOR input"),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                 errmsg("invalid CBOR input"),
+                 errdetail("unknown decoding error")));
+    }
+
+    PG_RETURN_NULL();
 }
 
-static inline void msgpack_store_be32(uint8_t* out, uint32_t value)
+/*
+ * zera_to_jsonb - Validate and decode one ZERA v1 document to jsonb.
+ */
+extern "C" Datum
+zera_to_jsonb(PG_FUNCTION_ARGS)
 {
-    out[0] = static_cast<uint8_t>(value >> 24);
-    out[1] = static_cast<uint8_t>(value >> 16);
-    out[2] = static_cast<uint8_t>(value >> 8);
-    out[3] = static_cast<uint8_t>(value);
+    bytea* input = PG_GETARG_BYTEA_PP(0);
+    std::span<const uint8_t> data = decoder_input(input, frame_protocol_of<z::Zera>());
+
+    try {
+        uint32_t root_ofs;
+        ZeraDecodeContext context = zera_open_document(data, &root_ofs);
+        JsonbDecodeWriter writer;
+        zera_replay_value(context, root_ofs, writer, 0);
+        Jsonb* result = writer.finish();
+        PG_FREE_IF_COPY(input, 0);
+        PG_RETURN_JSONB_P(result);
+    } catch (const std::exception& ex) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                 errmsg("invalid ZERA input"),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                 errmsg("invalid ZERA input"),
+                 errdetail("unknown decoding error")));
+    }
+
+    PG_RETURN_NULL();
 }
 
-static inline void msgpack_store_be64(uint8_t* out, uint64_t value)
+/*
+ * Direct protocol-to-protocol transcoding. The source is checked by the same
+ * bounded readers the jsonb decoders use and its values are replayed straight
+ * into the target serializer, without a jsonb or dynamic tree in between.
+ */
+template <typename Source, typename WriterT>
+static void replay_document(std::span<const uint8_t> data, WriterT& writer)
 {
-    msgpack_store_be32(out, static_cast<uint32_t>(value >> 32));
-    msgpack_store_be32(out + 4, static_cast<uint32_t>(value));
+    if constexpr (std::is_same_v<Source, z::MsgPack>) {
+        const size_t consumed = msgpack_validate_value(data, 0);
+        if (consumed != data.size()) {
+            throw z::DeserializationError("trailing bytes after MessagePack value");
+        }
+        msgpack_replay_value(data, 0, writer);
+    } else if constexpr (std::is_same_v<Source, z::CBOR>) {
+        const size_t consumed = cbor_replay_value(data, 0, writer);
+        if (consumed != data.size()) {
+            throw z::DeserializationError("trailing bytes after CBOR value");
+        }
+    } else if constexpr (std::is_same_v<Source, z::Zera>) {
+        uint32_t root_ofs;
+        ZeraDecodeContext context = zera_open_document(data, &root_ofs);
+        zera_replay_value(context, root_ofs, writer, 0);
+    } else {
+        if (!::flexbuffers::VerifyBuffer(data.data(), data.size())) {
+            throw z::DeserializationError("FlexBuffer verification failed");
+        }
+        flex_replay_reference(::flexbuffers::GetRoot(data.data(), data.size()), writer);
+    }
 }
 
-static inline uint8_t* msgpack_encode_int64(uint8_t* out, int64_t value)
+/*
+ * Output is sized from the input: MessagePack is written in place into one
+ * bytea and CBOR reserves the input length in its recycled buffer.
+ */
+template <typename Source, typename Target>
+static bytea* transcode_document(std::span<const uint8_t> data)
 {
-    if (value >= 0) {
-        uint64_t unsigned_value = static_cast<uint64_t>(value);
-        if (unsigned_value <= 0x7f) {
-            *out++ = static_cast<uint8_t>(unsigned_value);
-        } else if (unsigned_value <= UINT8_MAX) {
-            *out++ = 0xcc;
-            *out++ = static_cast<uint8_t>(unsigned_value);
-        } else if (unsigned_value <= UINT16_MAX) {
-            *out++ = 0xcd;
-            msgpack_store_be16(out, static_cast<uint16_t>(unsigned_value));
-            out += 2;
-        } else if (unsigned_value <= UINT32_MAX) {
-            *out++ = 0xce;
-            msgpack_store_be32(out, static_cast<uint32_t>(unsigned_value));
-            out += 4;
-        } else {
-            *out++ = 0xcf;
-            msgpack_store_be64(out, unsigned_value);
-            out += 8;
-        }
-    } else if (value >= -32) {
-        *out++ = static_cast<uint8_t>(value);
-    } else if (value >= INT8_MIN) {
-        *out++ = 0xd0;
-        *out++ = static_cast<uint8_t>(value);
-    } else if (value >= INT16_MIN) {
-        *out++ = 0xd1;
-        msgpack_store_be16(out, static_cast<uint16_t>(value));
-        out += 2;
-    } else if (value >= INT32_MIN) {
-        *out++ = 0xd2;
-        msgpack_store_be32(out, static_cast<uint32_t>(value));
-        out += 4;
+    if constexpr (std::is_same_v<Target, z::MsgPack>) {
+        z::MsgPackRootSerializer rs;
+        msgpack_palloc_root_init(rs, data.size());
+        z::MsgPackSerializer writer(rs);
+        replay_document<Source>(data, writer);
+        return msgpack_result_from_palloc_root(rs);
+    } else if constexpr (std::is_same_v<Target, z::CBOR>) {
+        std::vector<uint8_t> storage = std::move(cbor_reusable_storage());
+        storage.reserve(data.size());
+        z::cborjc::RootSerializer rs(std::move(storage));
+        z::cborjc::Serializer writer(rs);
+        replay_document<Source>(data, writer);
+        return cbor_result_from_root(rs);
+    } else if constexpr (std::is_same_v<Target, z::Zera>) {
+        z::zera::RootSerializer& rs = zera_reusable_root();
+        z::zera::Serializer writer(rs);
+        replay_document<Source>(data, writer);
+        return zera_result_from_root(rs);
     } else {
-        *out++ = 0xd3;
-        msgpack_store_be64(out, static_cast<uint64_t>(value));
-        out += 8;
+        z::flex::RootSerializer& rs = flex_reusable_root();
+        z::flex::Serializer writer(rs);
+        replay_document<Source>(data, writer);
+        return flex_result_from_root(rs);
     }
-    return out;
 }
 
-template <typename ValueT>
-static inline void msgpack_write_int64_sequence(
-    z::MsgPackSerializer& writer, const ValueT* values, int nitems)
+template <typename Source, typename Target>
+static Datum transcode(FunctionCallInfo fcinfo)
 {
-    uint8_t* begin = writer.reserve_raw_append(static_cast<size_t>(nitems) * 9);
-    uint8_t* out = begin;
-    for (int i = 0; i < nitems; i++) {
-        out = msgpack_encode_int64(out, static_cast<int64_t>(values[i]));
+    bytea* input = PG_GETARG_BYTEA_PP(0);
+    const uint8_t source = frame_protocol_of<Source>();
+    std::span<const uint8_t> data = decoder_input(input, source);
+
+    try {
+        bytea* result = transcode_document<Source, Target>(data);
+        PG_FREE_IF_COPY(input, 0);
+        PG_RETURN_BYTEA_P(result);
+    } catch (const z::SerializationError& ex) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("cannot transcode %s input to %s", frame_protocol_name(source),
+                        frame_protocol_name(frame_protocol_of<Target>())),
+                 errdetail("%s", ex.what())));
+    } catch (const std::exception& ex) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                 errmsg("invalid %s input", frame_protocol_name(source)),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                 errmsg("invalid %s input", frame_protocol_name(source)),
+                 errdetail("unknown decoding error")));
     }
-    writer.commit_raw_append(static_cast<size_t>(out - begin));
+
+    PG_RETURN_NULL();
 }
 
-template <typename ValueT>
-static inline void msgpack_write_double_sequence(
-    z::MsgPackSerializer& writer, const ValueT* values, int nitems)
+extern "C" Datum
+msgpack_to_cbor(PG_FUNCTION_ARGS)
 {
-    uint8_t* begin = writer.reserve_raw_append(static_cast<size_t>(nitems) * 9);
-    uint8_t* out = begin;
-    for (int i = 0; i < nitems; i++) {
-        *out++ = 0xcb;
-        uint64_t bits = std::bit_cast<uint64_t>(static_cast<double>(values[i]));
-        msgpack_store_be64(out, bits);
-        out += 8;
-    }
-    writer.commit_raw_append(static_cast<size_t>(out - begin));
+    return transcode<z::MsgPack, z::CBOR>(fcinfo);
 }
 
-static inline void msgpack_write_bool_sequence(
-    z::MsgPackSerializer& writer, const bool* values, int nitems)
+extern "C" Datum
+msgpack_to_zera(PG_FUNCTION_ARGS)
 {
-    uint8_t* begin = writer.reserve_raw_append(static_cast<size_t>(nitems));
-    for (int i = 0; i < nitems; i++) {
-        begin[i] = values[i] ? 0xc3 : 0xc2;
-    }
-    writer.commit_raw_append(static_cast<size_t>(nitems));
+    return transcode<z::MsgPack, z::Zera>(fcinfo);
 }
 
-static inline bool msgpack_write_fixed_array_no_nulls(
-    z::MsgPackSerializer& writer,
-    ConverterKind elem_kind,
-    ArrayType* arr,
-    int nitems)
+extern "C" Datum
+msgpack_to_flexbuffers(PG_FUNCTION_ARGS)
 {
-    switch (elem_kind) {
-        case ConverterKind::Int2:
-        case ConverterKind::Int4:
-        case ConverterKind::Int8:
-        case ConverterKind::Float4:
-        case ConverterKind::Float8:
-        case ConverterKind::Bool:
-        case ConverterKind::Uuid:
-        case ConverterKind::NameText:
-        case ConverterKind::CharText:
-        case ConverterKind::EnumText:
-        case ConverterKind::IntervalText:
-        case ConverterKind::Date:
-        case ConverterKind::Timestamp:
-        case ConverterKind::Timestamptz:
-            break;
-        default:
-            return false;
-    }
+    return transcode<z::MsgPack, z::Flex>(fcinfo);
+}
 
-    const char* data = ARR_DATA_PTR(arr);
-    writer.begin_array(static_cast<size_t>(nitems));
-    switch (elem_kind) {
-        case ConverterKind::Int2:
-        {
-            const int16* values = reinterpret_cast<const int16*>(data);
-            msgpack_write_int64_sequence(writer, values, nitems);
-            break;
-        }
-        case ConverterKind::Int4:
-        {
-            const int32* values = reinterpret_cast<const int32*>(data);
-            msgpack_write_int64_sequence(writer, values, nitems);
-            break;
-        }
-        case ConverterKind::Int8:
-        {
-            const int64* values = reinterpret_cast<const int64*>(data);
-            msgpack_write_int64_sequence(writer, values, nitems);
-            break;
-        }
-        case ConverterKind::Float4:
-        {
-            const float4* values = reinterpret_cast<const float4*>(data);
-            msgpack_write_double_sequence(writer, values, nitems);
-            break;
-        }
-        case ConverterKind::Float8:
-        {
-            const float8* values = reinterpret_cast<const float8*>(data);
-            msgpack_write_double_sequence(writer, values, nitems);
-            break;
-        }
-        case ConverterKind::Bool:
-        {
-            const bool* values = reinterpret_cast<const bool*>(data);
-            msgpack_write_bool_sequence(writer, values, nitems);
-            break;
-        }
-        case ConverterKind::Uuid:
-        {
-            const pg_uuid_t* values = reinterpret_cast<const pg_uuid_t*>(data);
-            for (int i = 0; i < nitems; i++) {
-                char out[36];
-                format_uuid(PointerGetDatum(&values[i]), out);
-                writer.string(std::string_view(out, sizeof(out)));
-            }
-            break;
-        }
-        case ConverterKind::NameText:
-        {
-            const NameData* values = reinterpret_cast<const NameData*>(data);
-            for (int i = 0; i < nitems; i++) writer.string(name_text_view(NameGetDatum(&values[i])));
-            break;
-        }
-        case ConverterKind::CharText:
-            for (int i = 0; i < nitems; i++) {
-                char ch = data[i];
-                writer.string(std::string_view(&ch, ch == '\0' ? 0 : 1));
-            }
-            break;
-        case ConverterKind::EnumText:
-        {
-            const Oid* values = reinterpret_cast<const Oid*>(data);
-            for (int i = 0; i < nitems; i++) writer.string(enum_label_view(ObjectIdGetDatum(values[i])));
-            break;
-        }
-        case ConverterKind::IntervalText:
-        {
-            const Interval* values = reinterpret_cast<const Interval*>(data);
-            for (int i = 0; i < nitems; i++) write_interval_string(writer, PointerGetDatum(&values[i]));
-            break;
-        }
-        case ConverterKind::Date:
-        {
-            const DateADT* values = reinterpret_cast<const DateADT*>(data);
-            msgpack_write_int64_sequence(writer, values, nitems);
-            break;
-        }
-        case ConverterKind::Timestamp:
-        case ConverterKind::Timestamptz:
-        {
-            const int64* values = reinterpret_cast<const int64*>(data);
-            msgpack_write_int64_sequence(writer, values, nitems);
-            break;
-        }
-        default:
-            pg_unreachable();
-    }
-    writer.end_array();
-    return true;
+extern "C" Datum
+cbor_to_msgpack(PG_FUNCTION_ARGS)
+{
+    return transcode<z::CBOR, z::MsgPack>(fcinfo);
 }
 
-static inline void msgpack_write_array(
-    z::MsgPackSerializer& writer,
-    const CachedColumn& col,
-    Datum value)
+extern "C" Datum
+cbor_to_zera(PG_FUNCTION_ARGS)
 {
-    ArrayType* arr = DatumGetArrayTypeP(value);
-    int ndim = ARR_NDIM(arr);
+    return transcode<z::CBOR, z::Zera>(fcinfo);
+}
 
-    if (ndim == 0) {
-        writer.begin_array(0);
-        writer.end_array();
-        return;
-    }
+extern "C" Datum
+cbor_to_flexbuffers(PG_FUNCTION_ARGS)
+{
+    return transcode<z::CBOR, z::Flex>(fcinfo);
+}
 
-    if (ndim != 1) {
-        z::dyn::serialize(array_to_dynamic(value, col.typid), writer);
-        return;
-    }
+extern "C" Datum
+zera_to_msgpack(PG_FUNCTION_ARGS)
+{
+    return transcode<z::Zera, z::MsgPack>(fcinfo);
+}
+
+extern "C" Datum
+zera_to_cbor(PG_FUNCTION_ARGS)
+{
+    return transcode<z::Zera, z::CBOR>(fcinfo);
+}
+
+extern "C" Datum
+zera_to_flexbuffers(PG_FUNCTION_ARGS)
+{
+    return transcode<z::Zera, z::Flex>(fcinfo);
+}
+
+extern "C" Datum
+flexbuffers_to_msgpack(PG_FUNCTION_ARGS)
+{
+    return transcode<z::Flex, z::MsgPack>(fcinfo);
+}
+
+extern "C" Datum
+flexbuffers_to_cbor(PG_FUNCTION_ARGS)
+{
+    return transcode<z::Flex, z::CBOR>(fcinfo);
+}
+
+extern "C" Datum
+flexbuffers_to_zera(PG_FUNCTION_ARGS)
+{
+    return transcode<z::Flex, z::Zera>(fcinfo);
+}
 
-    int nitems = ArrayGetNItems(ndim, ARR_DIMS(arr));
-    if (!ARR_HASNULL(arr) &&
-        msgpack_write_fixed_array_no_nulls(writer, col.array_element_kind, arr, nitems)) {
-        return;
-    }
+/*
+ * Path extraction entry points. The path is a text[] of map keys and array
+ * indexes; a NULL step or a path that does not resolve returns NULL.
+ */
+enum class ExtractTarget { Text, Int8, Float8 };
 
+using ExtractSliceFn = bool (*)(std::span<const uint8_t> data,
+                                std::span<const std::string_view> path,
+                                size_t* start, size_t* end);
+
+static bool extract_path_steps(ArrayType* path, std::span<const std::string_view>* steps)
+{
     Datum* elements;
     bool* nulls;
-    deconstruct_array(arr,
-                      col.array_element_typid,
-                      col.array_typlen,
-                      col.array_typbyval,
-                      col.array_typalign,
-                      &elements,
-                      &nulls,
-                      &nitems);
+    int count;
+    deconstruct_array_builtin(path, TEXTOID, &elements, &nulls, &count);
 
-    MsgpackArrayElemWriterFn elem_writer = col.msgpack_array_elem_writer;
-    if (elem_writer == nullptr) {
-        elem_writer = &msgpack_array_elem_unsupported;
+    auto* views = static_cast<std::string_view*>(
+        palloc(sizeof(std::string_view) * Max(count, 1)));
+    for (int i = 0; i < count; i++) {
+        if (nulls[i]) {
+            return false;
+        }
+        text* step = DatumGetTextPP(elements[i]);
+        new (&views[i]) std::string_view(VARDATA_ANY(step), VARSIZE_ANY_EXHDR(step));
     }
+    *steps = std::span<const std::string_view>(views, count);
+    return true;
+}
 
-    writer.begin_array(static_cast<size_t>(nitems));
-    if (col.array_element_kind == ConverterKind::Fallback) {
-        for (int i = 0; i < nitems; i++) {
-            if (nulls[i]) {
-                writer.null();
-            } else {
-                write_output_string(writer, col.array_element_typoutput, elements[i]);
-            }
-        }
-    } else if (!ARR_HASNULL(arr)) {
-        msgpack_write_array_no_nulls(writer, col.array_element_kind, elements, nitems);
+static text* integer_text(const ExtractedScalar& value)
+{
+    std::array<char, 32> buffer;
+    char* begin = buffer.data();
+    char* end = buffer.data() + buffer.size();
+    std::to_chars_result converted;
+    if (value.kind == ExtractedScalar::Kind::Int) {
+        converted = std::to_chars(begin, end, value.int_value);
+    } else if (value.kind == ExtractedScalar::Kind::UInt) {
+        converted = std::to_chars(begin, end, value.uint_value);
+    } else if (value.uint_value == UINT64_MAX) {
+        return cstring_to_text("-18446744073709551616");
     } else {
-        for (int i = 0; i < nitems; i++) {
-            elem_writer(writer, elements[i], nulls[i]);
-        }
+        *begin = '-';
+        converted = std::to_chars(begin + 1, end, value.uint_value + 1);
     }
-    writer.end_array();
+    return cstring_to_text_with_len(begin, static_cast<int>(converted.ptr - begin));
+}
 
-    pfree(elements);
-    pfree(nulls);
+/* Matches msgpack_to_jsonb(...) #>> path for every value kind. */
+static text* extracted_to_text(const ExtractedScalar& value, Jsonb* container)
+{
+    using Kind = ExtractedScalar::Kind;
+    switch (value.kind) {
+        case Kind::Bool:
+            return cstring_to_text(value.boolean ? "true" : "false");
+        case Kind::Int:
+        case Kind::UInt:
+        case Kind::NegUInt:
+            return integer_text(value);
+        case Kind::Float:
+        {
+            const double number = value.float_value;
+            if (std::isnan(number)) return cstring_to_text("NaN");
+            if (std::isinf(number)) {
+                return cstring_to_text(number > 0 ? "Infinity" : "-Infinity");
+            }
+            std::array<char, 64> buffer;
+            format_decoded_double(number, buffer);
+            Datum numeric = DirectFunctionCall3(
+                numeric_in, CStringGetDatum(buffer.data()),
+                ObjectIdGetDatum(InvalidOid), Int32GetDatum(-1));
+            return cstring_to_text(DatumGetCString(DirectFunctionCall1(numeric_out, numeric)));
+        }
+        case Kind::Decimal:
+        case Kind::String:
+            return cstring_to_text_with_len(
+                value.string_value.data(), static_cast<int>(value.string_value.size()));
+        case Kind::Container:
+            return cstring_to_text(
+                JsonbToCString(nullptr, &container->root, VARSIZE(container)));
+        case Kind::Null:
+            break;
+    }
+    pg_unreachable();
 }
 
-static inline void msgpack_scalar_unsupported(
-    z::MsgPackSerializer& writer,
-    const CachedColumn& col,
-    Datum value,
-    bool isnull)
+static Datum extracted_decimal_numeric(const ExtractedScalar& value)
 {
-    (void)writer;
-    (void)value;
-    (void)isnull;
+    return DirectFunctionCall3(numeric_in, CStringGetDatum(value.string_value.data()),
+                               ObjectIdGetDatum(InvalidOid), Int32GetDatum(-1));
+}
+
+static int64 extracted_to_int8(const ExtractedScalar& value, const char* protocol_name)
+{
+    using Kind = ExtractedScalar::Kind;
+    if (value.kind == Kind::Int) {
+        return value.int_value;
+    }
+    // Like floats, decimals with a fractional part are not integers.
+    if (value.kind == Kind::Decimal &&
+        value.string_value.find('.') == std::string_view::npos) {
+        return DatumGetInt64(DirectFunctionCall1(numeric_int8, extracted_decimal_numeric(value)));
+    }
+    if (value.kind == Kind::UInt &&
+        value.uint_value <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+        return static_cast<int64>(value.uint_value);
+    }
+    if (value.kind == Kind::UInt || value.kind == Kind::NegUInt) {
+        ereport(ERROR,
+                (errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+                 errmsg("bigint out of range")));
+    }
     ereport(ERROR,
-            (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-             errmsg("unsupported type for fast MessagePack path"),
-             errdetail("column type OID %u", col.typid)));
+            (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+             errmsg("cannot extract %s %s as type bigint",
+                    protocol_name, value.type_name)));
+    pg_unreachable();
+}
+
+static float8 extracted_to_float8(const ExtractedScalar& value, const char* protocol_name)
+{
+    using Kind = ExtractedScalar::Kind;
+    switch (value.kind) {
+        case Kind::Int:
+            return static_cast<float8>(value.int_value);
+        case Kind::UInt:
+            return static_cast<float8>(value.uint_value);
+        case Kind::NegUInt:
+            return -1.0 - static_cast<float8>(value.uint_value);
+        case Kind::Float:
+            return value.float_value;
+        case Kind::Decimal:
+            return DatumGetFloat8(DirectFunctionCall1(numeric_float8,
+                                                      extracted_decimal_numeric(value)));
+        default:
+            break;
+    }
+    ereport(ERROR,
+            (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+             errmsg("cannot extract %s %s as type double precision",
+                    protocol_name, value.type_name)));
+    pg_unreachable();
 }
 
-static inline void msgpack_scalar_composite(
-    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+static Datum extract_slice_at(
+    FunctionCallInfo fcinfo, const char* protocol_name, ExtractSliceFn extract,
+    std::span<const std::string_view> path)
 {
-    if (isnull) { writer.null(); return; }
-    HeapTupleHeader rec = DatumGetHeapTupleHeader(value);
-    const CachedSchema& schema = get_cached_schema(
-        HeapTupleHeaderGetTypeId(rec), HeapTupleHeaderGetTypMod(rec));
-    TupleDeformScratch scratch;
-    msgpack_write_record_map(writer, rec, schema, &scratch);
+    bytea* input = PG_GETARG_BYTEA_PP(0);
+    std::span<const uint8_t> data(
+        reinterpret_cast<const uint8_t*>(VARDATA_ANY(input)),
+        static_cast<size_t>(VARSIZE_ANY_EXHDR(input)));
+
+    size_t start = 0;
+    size_t end = 0;
+    bool found = false;
+    try {
+        found = extract(data, path, &start, &end);
+    } catch (const std::exception& ex) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                 errmsg("invalid %s input", protocol_name),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                 errmsg("invalid %s input", protocol_name),
+                 errdetail("unknown decoding error")));
+    }
+    if (!found) {
+        PG_RETURN_NULL();
+    }
+
+    const size_t len = end - start;
+    bytea* result = (bytea*) palloc(len + VARHDRSZ);
+    SET_VARSIZE(result, len + VARHDRSZ);
+    memcpy(VARDATA(result), data.data() + start, len);
+    PG_FREE_IF_COPY(input, 0);
+    PG_RETURN_BYTEA_P(result);
 }
 
-static inline void msgpack_scalar_fallback(
-    z::MsgPackSerializer& writer, const CachedColumn& col, Datum value, bool isnull)
+static Datum extract_slice_datum(
+    FunctionCallInfo fcinfo, const char* protocol_name, ExtractSliceFn extract)
 {
-    if (isnull) { writer.null(); return; }
-    char* str = OidOutputFunctionCall(col.typoutput, value);
-    writer.string(std::string_view(str));
-    pfree(str);
+    std::span<const std::string_view> path;
+    if (!extract_path_steps(PG_GETARG_ARRAYTYPE_P(1), &path)) {
+        PG_RETURN_NULL();
+    }
+    return extract_slice_at(fcinfo, protocol_name, extract, path);
 }
 
-static inline void msgpack_scalar_int2(
-    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+static Datum extract_typed_at(
+    FunctionCallInfo fcinfo, const char* protocol_name, ExtractScalarFn extract,
+    ExtractTarget target, std::span<const std::string_view> path)
 {
-    if (isnull) { writer.null(); return; }
-    writer.int64(static_cast<int64_t>(DatumGetInt16(value)));
+    bytea* input = PG_GETARG_BYTEA_PP(0);
+    std::span<const uint8_t> data(
+        reinterpret_cast<const uint8_t*>(VARDATA_ANY(input)),
+        static_cast<size_t>(VARSIZE_ANY_EXHDR(input)));
+
+    ExtractedScalar value;
+    Jsonb* container = nullptr;
+    bool found = false;
+    try {
+        found = extract(data, path, &value,
+                        target == ExtractTarget::Text ? &container : nullptr);
+    } catch (const std::exception& ex) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                 errmsg("invalid %s input", protocol_name),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                 errmsg("invalid %s input", protocol_name),
+                 errdetail("unknown decoding error")));
+    }
+    if (!found || value.kind == ExtractedScalar::Kind::Null) {
+        PG_RETURN_NULL();
+    }
+
+    Datum result;
+    switch (target) {
+        case ExtractTarget::Text:
+            result = PointerGetDatum(extracted_to_text(value, container));
+            break;
+        case ExtractTarget::Int8:
+            result = Int64GetDatum(extracted_to_int8(value, protocol_name));
+            break;
+        case ExtractTarget::Float8:
+            result = Float8GetDatum(extracted_to_float8(value, protocol_name));
+            break;
+        default:
+            pg_unreachable();
+    }
+    PG_FREE_IF_COPY(input, 0);
+    PG_RETURN_DATUM(result);
 }
 
-static inline void msgpack_scalar_int4(
-    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+static Datum extract_typed_datum(
+    FunctionCallInfo fcinfo, const char* protocol_name, ExtractScalarFn extract,
+    ExtractTarget target)
 {
-    if (isnull) { writer.null(); return; }
-    writer.int64(static_cast<int64_t>(DatumGetInt32(value)));
+    std::span<const std::string_view> path;
+    if (!extract_path_steps(PG_GETARG_ARRAYTYPE_P(1), &path)) {
+        PG_RETURN_NULL();
+    }
+    return extract_typed_at(fcinfo, protocol_name, extract, target, path);
 }
 
-static inline void msgpack_scalar_int8(
-    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+/*
+ * msgpack_extract - Return the MessagePack value at a path as its own bytes.
+ */
+extern "C" Datum
+msgpack_extract(PG_FUNCTION_ARGS)
 {
-    if (isnull) { writer.null(); return; }
-    writer.int64(static_cast<int64_t>(DatumGetInt64(value)));
+    return extract_slice_datum(fcinfo, "MessagePack", msgpack_extract_slice);
 }
 
-static inline void msgpack_scalar_float4(
-    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+extern "C" Datum
+msgpack_extract_text(PG_FUNCTION_ARGS)
 {
-    if (isnull) { writer.null(); return; }
-    writer.double_(static_cast<double>(DatumGetFloat4(value)));
+    return extract_typed_datum(fcinfo, "MessagePack", msgpack_extract_scalar,
+                               ExtractTarget::Text);
 }
 
-static inline void msgpack_scalar_float8(
-    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+extern "C" Datum
+msgpack_extract_int8(PG_FUNCTION_ARGS)
 {
-    if (isnull) { writer.null(); return; }
-    writer.double_(DatumGetFloat8(value));
+    return extract_typed_datum(fcinfo, "MessagePack", msgpack_extract_scalar,
+                               ExtractTarget::Int8);
 }
 
-static inline void msgpack_scalar_bool(
-    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+extern "C" Datum
+msgpack_extract_float8(PG_FUNCTION_ARGS)
 {
-    if (isnull) { writer.null(); return; }
-    writer.boolean(DatumGetBool(value));
+    return extract_typed_datum(fcinfo, "MessagePack", msgpack_extract_scalar,
+                               ExtractTarget::Float8);
 }
 
-static inline void msgpack_scalar_text(
-    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+static void msgpack_validate_document(std::span<const uint8_t> data)
 {
-    if (isnull) { writer.null(); return; }
-    msgpack_write_text(writer, value);
+    try {
+        const size_t consumed = msgpack_validate_value(data, 0);
+        if (consumed != data.size()) {
+            throw z::DeserializationError("trailing bytes after MessagePack value");
+        }
+    } catch (const std::exception& ex) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                 errmsg("invalid MessagePack input"),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                 errmsg("invalid MessagePack input"),
+                 errdetail("unknown decoding error")));
+    }
 }
 
-static inline void msgpack_scalar_numeric(
-    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+/*
+ * The msgpack type. Values are a varlena holding exactly one validated
+ * MessagePack value, binary-compatible with bytea. A value prints as JSON
+ * only when reading that JSON back gives the same bytes, and as \x hex
+ * otherwise, so text output is lossless; binary send/recv keeps the bytes as
+ * they are.
+ */
+static bytea* msgpack_validated_copy(const char* bytes, size_t len)
 {
-    if (isnull) { writer.null(); return; }
-    numeric_write_fast(writer, value);
+    msgpack_validate_document(
+        std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(bytes), len));
+    bytea* result = (bytea*) palloc(len + VARHDRSZ);
+    SET_VARSIZE(result, len + VARHDRSZ);
+    memcpy(VARDATA(result), bytes, len);
+    return result;
 }
 
-static inline void msgpack_scalar_date(
-    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+/*
+ * JSON text input. Numbers are written as float64 encoding writes them,
+ * whatever pg_zerialize.numeric_encoding says, so text input does not depend
+ * on session settings.
+ */
+static bytea* msgpack_from_json_text(Jsonb* jb)
 {
-    if (isnull) { writer.null(); return; }
-    writer.int64(static_cast<int64_t>(DatumGetDateADT(value)));
+    z::dyn::Value v = jsonb_to_dynamic(jb, NUMERIC_ENCODING_FLOAT64);
+    return dynamic_to_msgpack_binary(v);
 }
 
-static inline void msgpack_scalar_timestamp(
-    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+/*
+ * Whether a validated value may print as JSON. Binary, ext, and float32
+ * values never read back as themselves, and strings jsonb cannot hold would
+ * make msgpack_to_jsonb fail.
+ */
+static bool msgpack_json_printable(std::span<const uint8_t> data, size_t* pos)
 {
-    if (isnull) { writer.null(); return; }
-    writer.int64(static_cast<int64_t>(DatumGetTimestamp(value)));
+    check_stack_depth();
+    const uint8_t marker = data[(*pos)++];
+
+    if (marker <= 0x7f || marker >= 0xe0 || marker == 0xc0 ||
+        marker == 0xc2 || marker == 0xc3) {
+        return true;
+    }
+    if (msgpack_marker_is_string(marker)) {
+        std::string_view text;
+        *pos = msgpack_replay_string(data, *pos, marker, &text);
+        return text.find('\0') == std::string_view::npos &&
+               pg_verify_mbstr(GetDatabaseEncoding(), text.data(), text.size(), true);
+    }
+
+    size_t count;
+    switch (marker) {
+        case 0xcb:
+            *pos += 8;
+            return true;
+        case 0xcc:
+        case 0xd0:
+            *pos += 1;
+            return true;
+        case 0xcd:
+        case 0xd1:
+            *pos += 2;
+            return true;
+        case 0xce:
+        case 0xd2:
+            *pos += 4;
+            return true;
+        case 0xcf:
+        case 0xd3:
+            *pos += 8;
+            return true;
+        case 0xdc:
+        case 0xde:
+            count = msgpack_read_u16(data, *pos);
+            *pos += 2;
+            break;
+        case 0xdd:
+        case 0xdf:
+            count = msgpack_read_u32(data, *pos);
+            *pos += 4;
+            break;
+        default:
+            if (!msgpack_marker_is_array(marker) && !msgpack_marker_is_map(marker)) {
+                return false;
+            }
+            count = marker & 0x0f;
+            break;
+    }
+    if (msgpack_marker_is_map(marker)) {
+        count *= 2;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (!msgpack_json_printable(data, pos)) {
+            return false;
+        }
+    }
+    return true;
 }
 
-static inline void msgpack_scalar_timestamptz(
-    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+extern "C" Datum
+msgpack_in(PG_FUNCTION_ARGS)
 {
-    if (isnull) { writer.null(); return; }
-    writer.int64(static_cast<int64_t>(DatumGetTimestampTz(value)));
+    char* text = PG_GETARG_CSTRING(0);
+    if (text[0] == '\\' && text[1] == 'x') {
+        bytea* raw = DatumGetByteaPP(DirectFunctionCall1(byteain, CStringGetDatum(text)));
+        PG_RETURN_BYTEA_P(msgpack_validated_copy(VARDATA_ANY(raw), VARSIZE_ANY_EXHDR(raw)));
+    }
+    Datum jb = DirectFunctionCall1(jsonb_in, CStringGetDatum(text));
+    PG_RETURN_BYTEA_P(msgpack_from_json_text(DatumGetJsonbP(jb)));
 }
 
-static inline void msgpack_scalar_jsonb(
-    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+extern "C" Datum
+msgpack_out(PG_FUNCTION_ARGS)
+{
+    bytea* input = PG_GETARG_BYTEA_PP(0);
+    const size_t len = VARSIZE_ANY_EXHDR(input);
+    std::span<const uint8_t> data(reinterpret_cast<const uint8_t*>(VARDATA_ANY(input)), len);
+
+    bool printable;
+    try {
+        size_t pos = 0;
+        printable = msgpack_json_printable(data, &pos);
+    } catch (const std::exception&) {
+        printable = false;
+    }
+    if (printable) {
+        Datum jb = DirectFunctionCall1(msgpack_to_jsonb, PointerGetDatum(input));
+        bytea* again = msgpack_from_json_text(DatumGetJsonbP(jb));
+        if (VARSIZE_ANY_EXHDR(again) == len && memcmp(VARDATA_ANY(again), data.data(), len) == 0) {
+            PG_RETURN_DATUM(DirectFunctionCall1(jsonb_out, jb));
+        }
+    }
+
+    char* out = (char*) palloc(2 * len + 3);
+    out[0] = '\\';
+    out[1] = 'x';
+    hex_encode(VARDATA_ANY(input), len, out + 2);
+    out[2 * len + 2] = '\0';
+    PG_RETURN_CSTRING(out);
+}
+
+extern "C" Datum
+msgpack_recv(PG_FUNCTION_ARGS)
 {
-    if (isnull) { writer.null(); return; }
-    writer.binary(datum_jsonb_span(value));
+    StringInfo buf = (StringInfo) PG_GETARG_POINTER(0);
+    const size_t len = static_cast<size_t>(buf->len - buf->cursor);
+    bytea* result = msgpack_validated_copy(buf->data + buf->cursor, len);
+    buf->cursor = buf->len;
+    PG_RETURN_BYTEA_P(result);
 }
 
-static inline void msgpack_scalar_bytea(
-    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+extern "C" Datum
+msgpack_send(PG_FUNCTION_ARGS)
 {
-    if (isnull) { writer.null(); return; }
-    writer.binary(datum_bytea_span(value));
+    PG_RETURN_BYTEA_P(PG_GETARG_BYTEA_P_COPY(0));
 }
 
-static inline void msgpack_scalar_array(
-    z::MsgPackSerializer& writer, const CachedColumn& col, Datum value, bool isnull)
+/*
+ * msgpack_from_bytea - Cast bytea to msgpack after validating it. Compressed
+ * batch frames are rejected; unwrap them with zerialize_decompress first.
+ */
+extern "C" Datum
+msgpack_from_bytea(PG_FUNCTION_ARGS)
 {
-    if (isnull) { writer.null(); return; }
-    msgpack_write_array(writer, col, value);
+    bytea* input = PG_GETARG_BYTEA_PP(0);
+    PG_RETURN_BYTEA_P(msgpack_validated_copy(VARDATA_ANY(input),
+                                             VARSIZE_ANY_EXHDR(input)));
 }
 
-static inline void msgpack_scalar_uuid(
-    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+/*
+ * -> and ->> with one key or index. Like jsonb, a key step on an array or an
+ * index step on a map returns NULL rather than matching a key spelled like
+ * the index.
+ */
+static Datum msgpack_field_datum(FunctionCallInfo fcinfo, std::string_view step, bool index_step,
+                                 bool as_text)
 {
-    if (isnull) { writer.null(); return; }
-    char out[36];
-    format_uuid(value, out);
-    writer.string(std::string_view(out, sizeof(out)));
+    bytea* input = PG_GETARG_BYTEA_PP(0);
+    if (VARSIZE_ANY_EXHDR(input) == 0) {
+        PG_RETURN_NULL();
+    }
+    const uint8_t marker = static_cast<uint8_t>(*VARDATA_ANY(input));
+    if (!(index_step ? msgpack_marker_is_array(marker) : msgpack_marker_is_map(marker))) {
+        PG_RETURN_NULL();
+    }
+
+    std::span<const std::string_view> path(&step, 1);
+    if (as_text) {
+        return extract_typed_at(fcinfo, "MessagePack", msgpack_extract_scalar,
+                                ExtractTarget::Text, path);
+    }
+    return extract_slice_at(fcinfo, "MessagePack", msgpack_extract_slice, path);
 }
 
-static inline void msgpack_scalar_name(
-    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+static std::string_view msgpack_index_step(int32 index, std::array<char, 16>* buffer)
 {
-    if (isnull) { writer.null(); return; }
-    writer.string(name_text_view(value));
+    auto converted = std::to_chars(buffer->data(), buffer->data() + buffer->size(), index);
+    return std::string_view(buffer->data(), converted.ptr - buffer->data());
 }
 
-static inline void msgpack_scalar_char(
-    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+extern "C" Datum
+msgpack_object_field(PG_FUNCTION_ARGS)
 {
-    if (isnull) { writer.null(); return; }
-    char ch = DatumGetChar(value);
-    writer.string(std::string_view(&ch, ch == '\0' ? 0 : 1));
+    text* key = PG_GETARG_TEXT_PP(1);
+    return msgpack_field_datum(
+        fcinfo, std::string_view(VARDATA_ANY(key), VARSIZE_ANY_EXHDR(key)), false, false);
 }
 
-static inline void msgpack_scalar_enum(
-    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+extern "C" Datum
+msgpack_object_field_text(PG_FUNCTION_ARGS)
 {
-    if (isnull) { writer.null(); return; }
-    writer.string(enum_label_view(value));
+    text* key = PG_GETARG_TEXT_PP(1);
+    return msgpack_field_datum(
+        fcinfo, std::string_view(VARDATA_ANY(key), VARSIZE_ANY_EXHDR(key)), false, true);
 }
 
-static inline void msgpack_scalar_inet(
-    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+extern "C" Datum
+msgpack_array_element(PG_FUNCTION_ARGS)
 {
-    if (isnull) { writer.null(); return; }
-    write_network_string(writer, value, false);
+    std::array<char, 16> buffer;
+    return msgpack_field_datum(fcinfo, msgpack_index_step(PG_GETARG_INT32(1), &buffer), true,
+                               false);
 }
 
-static inline void msgpack_scalar_cidr(
-    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+extern "C" Datum
+msgpack_array_element_text(PG_FUNCTION_ARGS)
 {
-    if (isnull) { writer.null(); return; }
-    write_network_string(writer, value, true);
+    std::array<char, 16> buffer;
+    return msgpack_field_datum(fcinfo, msgpack_index_step(PG_GETARG_INT32(1), &buffer), true,
+                               true);
 }
 
-static inline void msgpack_scalar_interval(
-    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+static void msgpack_key_append_be64(std::string* key, uint64_t value)
 {
-    if (isnull) { writer.null(); return; }
-    write_interval_string(writer, value);
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        key->push_back(static_cast<char>((value >> shift) & 0xff));
+    }
 }
 
-static MsgpackScalarWriterFn select_msgpack_scalar_writer(ConverterKind kind)
+static uint64_t msgpack_read_be(std::span<const uint8_t> data, size_t pos, size_t width)
 {
-    switch (kind) {
-        case ConverterKind::Int2: return &msgpack_scalar_int2;
-        case ConverterKind::Int4: return &msgpack_scalar_int4;
-        case ConverterKind::Int8: return &msgpack_scalar_int8;
-        case ConverterKind::Float4: return &msgpack_scalar_float4;
-        case ConverterKind::Float8: return &msgpack_scalar_float8;
-        case ConverterKind::Bool: return &msgpack_scalar_bool;
-        case ConverterKind::Text:
-        case ConverterKind::JsonText:
-            return &msgpack_scalar_text;
-        case ConverterKind::Uuid: return &msgpack_scalar_uuid;
-        case ConverterKind::NameText: return &msgpack_scalar_name;
-        case ConverterKind::CharText: return &msgpack_scalar_char;
-        case ConverterKind::EnumText: return &msgpack_scalar_enum;
-        case ConverterKind::InetText: return &msgpack_scalar_inet;
-        case ConverterKind::CidrText: return &msgpack_scalar_cidr;
-        case ConverterKind::IntervalText: return &msgpack_scalar_interval;
-        case ConverterKind::Numeric: return &msgpack_scalar_numeric;
-        case ConverterKind::Date: return &msgpack_scalar_date;
-        case ConverterKind::Timestamp: return &msgpack_scalar_timestamp;
-        case ConverterKind::Timestamptz: return &msgpack_scalar_timestamptz;
-        case ConverterKind::Jsonb: return &msgpack_scalar_jsonb;
-        case ConverterKind::Bytea: return &msgpack_scalar_bytea;
-        case ConverterKind::Array: return &msgpack_scalar_array;
-        case ConverterKind::Fallback: return &msgpack_scalar_fallback;
-        case ConverterKind::Composite: return &msgpack_scalar_composite;
+    msgpack_require_bytes(data, pos, width);
+    uint64_t value = 0;
+    for (size_t i = 0; i < width; i++) {
+        value = (value << 8) | data[pos + i];
     }
-    return &msgpack_scalar_unsupported;
+    return value;
 }
 
-static inline void msgpack_write_record_map(
-    z::MsgPackSerializer& writer,
-    HeapTupleHeader rec,
-    const CachedSchema& schema,
-    TupleDeformScratch* scratch)
+/*
+ * Writes a canonical key for the scalar at pos, so that containment and the
+ * GIN hashes agree on equality: integers compare by value whatever their
+ * width, floats with an integral int64 value compare equal to that integer,
+ * and ext values compare by type and payload.
+ */
+static void msgpack_scalar_key(std::span<const uint8_t> data, size_t pos, std::string* key)
 {
-    HeapTupleData tuple;
-    tuple.t_len = HeapTupleHeaderGetDatumLength(rec);
-    tuple.t_data = rec;
+    msgpack_require_bytes(data, pos, 1);
+    const uint8_t marker = data[pos++];
+    key->clear();
 
-    if (schema.columns.size() > 15) {
-        writer.begin_map_preencoded(schema.msgpack_map_header_ptr, schema.msgpack_map_header_len);
-    } else {
-        writer.begin_map(schema.columns.size());
-    }
-    if (!schema.use_deform_access) {
-        for (const CachedColumn& col : schema.columns) {
-            bool isnull;
-            Datum value = heap_getattr(&tuple, col.attnum, schema.tupdesc, &isnull);
-            writer.key_preencoded(col.msgpack_key_ptr, col.msgpack_key_len);
-            col.msgpack_scalar_writer(writer, col, value, isnull);
+    auto put_int = [key](int64_t value) {
+        key->push_back('i');
+        msgpack_key_append_be64(key, static_cast<uint64_t>(value));
+    };
+    auto put_float = [key, &put_int](double value) {
+        if (value >= -9223372036854775808.0 && value < 18446744073709551616.0 &&
+            std::trunc(value) == value) {
+            // Integral floats key like the integer of the same value.
+            if (value < 9223372036854775808.0) {
+                put_int(static_cast<int64_t>(value));
+            } else {
+                key->push_back('u');
+                msgpack_key_append_be64(key, static_cast<uint64_t>(value));
+            }
+            return;
         }
+        uint64_t bits;
+        if (std::isnan(value)) {
+            value = std::numeric_limits<double>::quiet_NaN();
+        }
+        memcpy(&bits, &value, sizeof(bits));
+        key->push_back('f');
+        msgpack_key_append_be64(key, bits);
+    };
+
+    if (marker <= 0x7f) {
+        put_int(marker);
+    } else if (marker >= 0xe0) {
+        put_int(static_cast<int8_t>(marker));
+    } else if (marker == 0xc0) {
+        key->push_back('N');
+    } else if (marker == 0xc2 || marker == 0xc3) {
+        key->push_back(marker == 0xc3 ? 'T' : 'F');
+    } else if (msgpack_marker_is_string(marker)) {
+        std::string_view text;
+        msgpack_replay_string(data, pos, marker, &text);
+        key->push_back('s');
+        key->append(text);
+    } else if (marker >= 0xc4 && marker <= 0xc6) {
+        const size_t width = size_t{1} << (marker - 0xc4);
+        const size_t len = msgpack_read_be(data, pos, width);
+        msgpack_require_bytes(data, pos + width, len);
+        key->push_back('b');
+        key->append(reinterpret_cast<const char*>(data.data() + pos + width), len);
+    } else if (marker >= 0xcc && marker <= 0xcf) {
+        const uint64_t value = msgpack_read_be(data, pos, size_t{1} << (marker - 0xcc));
+        if (value > static_cast<uint64_t>(INT64_MAX)) {
+            key->push_back('u');
+            msgpack_key_append_be64(key, value);
+        } else {
+            put_int(static_cast<int64_t>(value));
+        }
+    } else if (marker >= 0xd0 && marker <= 0xd3) {
+        const size_t width = size_t{1} << (marker - 0xd0);
+        const uint64_t raw = msgpack_read_be(data, pos, width);
+        const int shift = static_cast<int>(64 - 8 * width);
+        put_int(static_cast<int64_t>(raw << shift) >> shift);
+    } else if (marker == 0xca) {
+        const uint32_t bits = static_cast<uint32_t>(msgpack_read_be(data, pos, 4));
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        put_float(value);
+    } else if (marker == 0xcb) {
+        const uint64_t bits = msgpack_read_be(data, pos, 8);
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        put_float(value);
     } else {
-        const size_t nattrs = static_cast<size_t>(schema.tupdesc->natts);
-        scratch->ensure(nattrs);
-        heap_deform_tuple(&tuple, schema.tupdesc, scratch->values, scratch->nulls);
-        for (const CachedColumn& col : schema.columns) {
-            const int idx = col.attnum - 1;
-            writer.key_preencoded(col.msgpack_key_ptr, col.msgpack_key_len);
-            col.msgpack_scalar_writer(writer, col, scratch->values[idx], scratch->nulls[idx]);
+        uint8_t type;
+        size_t len;
+        if (!msgpack_read_ext(data, &pos, marker, &type, &len)) {
+            throw z::DeserializationError("unsupported or reserved MessagePack marker");
         }
+        key->push_back('x');
+        key->push_back(static_cast<char>(type));
+        key->append(reinterpret_cast<const char*>(data.data() + pos), len);
     }
-    writer.end_map();
-}
-
-static inline z::MsgPackRootSerializer& msgpack_reusable_root()
-{
-    static z::MsgPackRootSerializer rs;
-    return rs;
 }
 
-static inline bytea* msgpack_result_from_reusable_root(z::MsgPackRootSerializer& rs)
+/* Finds key in the map whose entries start at pos; *value_pos is its value. */
+static bool msgpack_map_find(std::span<const uint8_t> data, size_t pos, uint64_t count,
+                             std::string_view key, size_t* value_pos)
 {
-    size_t len = rs.sbuf.size;
-    bytea* result = (bytea*) palloc(len + VARHDRSZ);
-    SET_VARSIZE(result, len + VARHDRSZ);
-    if (len > 0) {
-        memcpy(VARDATA(result), rs.sbuf.data, len);
+    for (uint64_t i = 0; i < count; i++) {
+        std::string_view candidate;
+        msgpack_require_bytes(data, pos, 1);
+        pos = msgpack_replay_string(data, pos + 1, data[pos], &candidate);
+        if (candidate == key) {
+            *value_pos = pos;
+            return true;
+        }
+        pos = msgpack_skip_value(data, pos);
     }
-    msgpack_sbuffer_clear(&rs.sbuf);
-    return result;
+    return false;
 }
 
-static bool msgpack_schema_recursive_supported(
-    const CachedSchema& schema, std::unordered_set<Oid>& active_types)
+/*
+ * Whether the value at a_pos contains the one at b_pos, by jsonb's @> rules:
+ * a map contains a map whose keys it all has with contained values, an array
+ * contains an array whose elements are each contained by one of its own, and
+ * scalars contain only equal scalars. Walks both encodings in place.
+ */
+static bool msgpack_value_contains(std::span<const uint8_t> a, size_t a_pos,
+                                   std::span<const uint8_t> b, size_t b_pos)
 {
-    if (!schema.msgpack_fast_supported) {
+    check_stack_depth();
+    size_t a_cursor = a_pos;
+    size_t b_cursor = b_pos;
+    uint64_t a_count;
+    uint64_t b_count;
+    bool a_map = false;
+    bool b_map = false;
+    const bool a_container = msgpack_read_container(a, &a_cursor, &a_count, &a_map);
+    const bool b_container = msgpack_read_container(b, &b_cursor, &b_count, &b_map);
+    if (a_container != b_container || a_map != b_map) {
         return false;
     }
-    for (const CachedColumn& col : schema.columns) {
-        Oid nested_type = InvalidOid;
-        if (col.kind == ConverterKind::Composite) {
-            nested_type = col.typid;
-        } else if (col.kind == ConverterKind::Array &&
-                   col.array_element_kind == ConverterKind::Composite) {
-            nested_type = col.array_element_typid;
+
+    if (!b_container) {
+        std::string a_key;
+        std::string b_key;
+        msgpack_scalar_key(a, a_pos, &a_key);
+        msgpack_scalar_key(b, b_pos, &b_key);
+        return a_key == b_key;
+    }
+
+    if (b_map) {
+        for (uint64_t i = 0; i < b_count; i++) {
+            std::string_view key;
+            msgpack_require_bytes(b, b_cursor, 1);
+            b_cursor = msgpack_replay_string(b, b_cursor + 1, b[b_cursor], &key);
+            size_t a_value;
+            if (!msgpack_map_find(a, a_cursor, a_count, key, &a_value) ||
+                !msgpack_value_contains(a, a_value, b, b_cursor)) {
+                return false;
+            }
+            b_cursor = msgpack_skip_value(b, b_cursor);
         }
-        if (!OidIsValid(nested_type) || !active_types.insert(nested_type).second) {
-            continue;
+        return true;
+    }
+
+    for (uint64_t i = 0; i < b_count; i++) {
+        bool found = false;
+        size_t element = a_cursor;
+        for (uint64_t j = 0; j < a_count && !found; j++) {
+            found = msgpack_value_contains(a, element, b, b_cursor);
+            element = msgpack_skip_value(a, element);
         }
-        const CachedSchema& nested = get_cached_schema(nested_type, -1);
-        const bool supported = msgpack_schema_recursive_supported(nested, active_types);
-        active_types.erase(nested_type);
-        if (!supported) {
+        if (!found) {
             return false;
         }
+        b_cursor = msgpack_skip_value(b, b_cursor);
     }
     return true;
 }
 
-static bytea* try_serialize_msgpack_row_fast(HeapTupleHeader rec)
-{
-    Oid tupType = HeapTupleHeaderGetTypeId(rec);
-    int32 tupTypmod = HeapTupleHeaderGetTypMod(rec);
-    const CachedSchema& schema = get_cached_schema(tupType, tupTypmod);
-
-    if (!schema.msgpack_fast_supported) {
-        return nullptr;
-    }
-    if (schema.msgpack_has_recursive_columns) {
-        std::unordered_set<Oid> active_types{tupType};
-        if (!msgpack_schema_recursive_supported(schema, active_types)) {
-            return nullptr;
+/*
+ * @> on whole documents. As in jsonb, a top-level array also contains a bare
+ * scalar equal to one of its elements; nested arrays still need an array.
+ */
+static bool msgpack_document_contains(std::span<const uint8_t> a, std::span<const uint8_t> b)
+{
+    size_t a_cursor = 0;
+    size_t b_cursor = 0;
+    uint64_t a_count;
+    uint64_t b_count;
+    bool a_map = false;
+    bool b_map = false;
+    if (msgpack_read_container(a, &a_cursor, &a_count, &a_map) && !a_map &&
+        !msgpack_read_container(b, &b_cursor, &b_count, &b_map)) {
+        for (uint64_t i = 0; i < a_count; i++) {
+            if (msgpack_value_contains(a, a_cursor, b, 0)) {
+                return true;
+            }
+            a_cursor = msgpack_skip_value(a, a_cursor);
         }
+        return false;
     }
+    return msgpack_value_contains(a, 0, b, 0);
+}
 
-    z::MsgPackRootSerializer& rs = msgpack_reusable_root();
-    msgpack_sbuffer_clear(&rs.sbuf);
-
+static bool msgpack_contains_datum(Datum container, Datum contained)
+{
+    bytea* a = DatumGetByteaPP(container);
+    bytea* b = DatumGetByteaPP(contained);
     try {
-        z::MsgPackSerializer writer(rs);
-        if (!schema.use_deform_access) {
-            msgpack_write_record_map(writer, rec, schema, nullptr);
-        } else {
-            TupleDeformScratch scratch;
-            msgpack_write_record_map(writer, rec, schema, &scratch);
-        }
-
-        return msgpack_result_from_reusable_root(rs);
+        return msgpack_document_contains(
+            std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(VARDATA_ANY(a)),
+                                     VARSIZE_ANY_EXHDR(a)),
+            std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(VARDATA_ANY(b)),
+                                     VARSIZE_ANY_EXHDR(b)));
     } catch (const std::exception& ex) {
-        msgpack_sbuffer_clear(&rs.sbuf);
         ereport(ERROR,
-                (errcode(ERRCODE_INTERNAL_ERROR),
-                 errmsg("fast MessagePack row serialization failed"),
+                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                 errmsg("invalid MessagePack input"),
                  errdetail("%s", ex.what())));
-    } catch (...) {
-        msgpack_sbuffer_clear(&rs.sbuf);
-        ereport(ERROR,
-                (errcode(ERRCODE_INTERNAL_ERROR),
-                 errmsg("fast MessagePack row serialization failed with unknown exception")));
     }
+    pg_unreachable();
+}
 
-    return nullptr;
+extern "C" Datum
+msgpack_contains(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_BOOL(msgpack_contains_datum(PG_GETARG_DATUM(0), PG_GETARG_DATUM(1)));
 }
 
-static bytea* try_serialize_msgpack_array_fast(Datum* elements, bool* nulls, int nitems)
+extern "C" Datum
+msgpack_contained(PG_FUNCTION_ARGS)
 {
-    std::vector<const CachedSchema*> schemas;
-    schemas.reserve(nitems);
+    PG_RETURN_BOOL(msgpack_contains_datum(PG_GETARG_DATUM(1), PG_GETARG_DATUM(0)));
+}
 
-    for (int i = 0; i < nitems; i++) {
-        if (nulls[i]) {
-            schemas.push_back(nullptr);
-            continue;
-        }
+/*
+ * GIN support for @>, in the manner of jsonb_path_ops: each scalar leaf
+ * yields one hash of the map keys on its path combined with its canonical
+ * scalar key. Array elements share their array's path, and empty containers
+ * yield nothing. A document contains a query only if it has all the query's
+ * hashes; matches are rechecked since hashes collide and drop array
+ * structure.
+ */
+static constexpr StrategyNumber kMsgpackContainsStrategy = 7;
 
-        HeapTupleHeader rec = DatumGetHeapTupleHeader(elements[i]);
-        Oid tupType = HeapTupleHeaderGetTypeId(rec);
-        int32 tupTypmod = HeapTupleHeaderGetTypMod(rec);
-        const CachedSchema& schema = get_cached_schema(tupType, tupTypmod);
+static void msgpack_gin_collect(std::span<const uint8_t> data, size_t* pos, uint32 path_hash,
+                                std::vector<uint32>* hashes, std::string* scratch)
+{
+    check_stack_depth();
+    size_t cursor = *pos;
+    uint64_t count;
+    bool is_map;
+    if (!msgpack_read_container(data, &cursor, &count, &is_map)) {
+        msgpack_scalar_key(data, cursor, scratch);
+        hashes->push_back(hash_combine(
+            path_hash, hash_bytes(reinterpret_cast<const unsigned char*>(scratch->data()),
+                                  static_cast<int>(scratch->size()))));
+        *pos = msgpack_skip_value(data, cursor);
+        return;
+    }
 
-        if (!schema.msgpack_fast_supported) {
-            return nullptr;
-        }
-        if (schema.msgpack_has_recursive_columns) {
-            std::unordered_set<Oid> active_types{tupType};
-            if (!msgpack_schema_recursive_supported(schema, active_types)) {
-                return nullptr;
-            }
+    for (uint64_t i = 0; i < count; i++) {
+        uint32 child_hash = path_hash;
+        if (is_map) {
+            std::string_view key;
+            msgpack_require_bytes(data, cursor, 1);
+            cursor = msgpack_replay_string(data, cursor + 1, data[cursor], &key);
+            child_hash = hash_combine(
+                path_hash, hash_bytes(reinterpret_cast<const unsigned char*>(key.data()),
+                                      static_cast<int>(key.size())));
         }
-        schemas.push_back(&schema);
+        msgpack_gin_collect(data, &cursor, child_hash, hashes, scratch);
     }
+    *pos = cursor;
+}
 
-    z::MsgPackRootSerializer& rs = msgpack_reusable_root();
-    msgpack_sbuffer_clear(&rs.sbuf);
-
+static Datum* msgpack_gin_entries(Datum value, int32* nentries)
+{
+    bytea* input = DatumGetByteaPP(value);
+    std::span<const uint8_t> data(reinterpret_cast<const uint8_t*>(VARDATA_ANY(input)),
+                                  VARSIZE_ANY_EXHDR(input));
+    std::vector<uint32> hashes;
     try {
-        z::MsgPackSerializer writer(rs);
-        TupleDeformScratch scratch;
-
-        writer.begin_array(static_cast<size_t>(nitems));
-        for (int i = 0; i < nitems; i++) {
-            if (nulls[i]) {
-                writer.null();
-            } else {
-                HeapTupleHeader rec = DatumGetHeapTupleHeader(elements[i]);
-                msgpack_write_record_map(writer, rec, *schemas[i], &scratch);
-            }
-        }
-        writer.end_array();
-
-        return msgpack_result_from_reusable_root(rs);
-    } catch (const std::exception& ex) {
-        msgpack_sbuffer_clear(&rs.sbuf);
-        ereport(ERROR,
-                (errcode(ERRCODE_INTERNAL_ERROR),
-                 errmsg("fast MessagePack batch serialization failed"),
-                 errdetail("%s", ex.what())));
-    } catch (...) {
-        msgpack_sbuffer_clear(&rs.sbuf);
+        std::string scratch;
+        size_t pos = 0;
+        msgpack_gin_collect(data, &pos, 0, &hashes, &scratch);
+    } catch (const std::exception& ex) {
         ereport(ERROR,
-                (errcode(ERRCODE_INTERNAL_ERROR),
-                 errmsg("fast MessagePack batch serialization failed with unknown exception")));
+                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                 errmsg("invalid MessagePack input"),
+                 errdetail("%s", ex.what())));
     }
+    std::sort(hashes.begin(), hashes.end());
+    hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
 
-    return nullptr;
+    *nentries = static_cast<int32>(hashes.size());
+    if (hashes.empty()) {
+        return nullptr;
+    }
+    Datum* entries = static_cast<Datum*>(palloc(sizeof(Datum) * hashes.size()));
+    for (size_t i = 0; i < hashes.size(); i++) {
+        entries[i] = UInt32GetDatum(hashes[i]);
+    }
+    return entries;
 }
 
-static inline void cbor_write_text(z::cborjc::Serializer& writer, Datum value)
+extern "C" Datum
+gin_extract_msgpack(PG_FUNCTION_ARGS)
 {
-    text* txt = DatumGetTextPP(value);
-    const char* ptr = VARDATA_ANY(txt);
-    int len = VARSIZE_ANY_EXHDR(txt);
-    writer.string(std::string_view(ptr, static_cast<size_t>(len)));
+    int32* nentries = (int32*) PG_GETARG_POINTER(1);
+    PG_RETURN_POINTER(msgpack_gin_entries(PG_GETARG_DATUM(0), nentries));
 }
 
-static inline void cbor_write_array_element(
-    z::cborjc::Serializer& writer,
-    ConverterKind elem_kind,
-    Datum value,
-    bool isnull)
+extern "C" Datum
+gin_extract_msgpack_query(PG_FUNCTION_ARGS)
 {
-    if (isnull) {
-        writer.null();
-        return;
+    int32* nentries = (int32*) PG_GETARG_POINTER(1);
+    StrategyNumber strategy = PG_GETARG_UINT16(2);
+    int32* search_mode = (int32*) PG_GETARG_POINTER(6);
+
+    if (strategy != kMsgpackContainsStrategy) {
+        elog(ERROR, "unrecognized strategy number: %d", strategy);
     }
+    Datum* entries = msgpack_gin_entries(PG_GETARG_DATUM(0), nentries);
+    /* An empty query container, or one of only empty containers, matches
+     * every map or array, so it needs a full index scan. */
+    if (*nentries == 0) {
+        *search_mode = GIN_SEARCH_MODE_ALL;
+    }
+    PG_RETURN_POINTER(entries);
+}
 
-    switch (elem_kind) {
-        case ConverterKind::Int2:
-            writer.int64(static_cast<int64_t>(DatumGetInt16(value)));
-            return;
-        case ConverterKind::Int4:
-            writer.int64(static_cast<int64_t>(DatumGetInt32(value)));
-            return;
-        case ConverterKind::Int8:
-            writer.int64(static_cast<int64_t>(DatumGetInt64(value)));
-            return;
-        case ConverterKind::Float4:
-            writer.double_(static_cast<double>(DatumGetFloat4(value)));
-            return;
-        case ConverterKind::Float8:
-            writer.double_(DatumGetFloat8(value));
-            return;
-        case ConverterKind::Bool:
-            writer.boolean(DatumGetBool(value));
-            return;
-        case ConverterKind::Text:
-        case ConverterKind::JsonText:
-            cbor_write_text(writer, value);
-            return;
-        case ConverterKind::Uuid:
-        {
-            char out[36];
-            format_uuid(value, out);
-            writer.string(std::string_view(out, sizeof(out)));
-            return;
+extern "C" Datum
+gin_consistent_msgpack(PG_FUNCTION_ARGS)
+{
+    bool* check = (bool*) PG_GETARG_POINTER(0);
+    StrategyNumber strategy = PG_GETARG_UINT16(1);
+    int32 nkeys = PG_GETARG_INT32(3);
+    bool* recheck = (bool*) PG_GETARG_POINTER(5);
+
+    if (strategy != kMsgpackContainsStrategy) {
+        elog(ERROR, "unrecognized strategy number: %d", strategy);
+    }
+    *recheck = true;
+    for (int32 i = 0; i < nkeys; i++) {
+        if (!check[i]) {
+            PG_RETURN_BOOL(false);
         }
-        case ConverterKind::NameText:
-            writer.string(name_text_view(value));
-            return;
-        case ConverterKind::CharText:
-        {
-            char ch = DatumGetChar(value);
-            writer.string(std::string_view(&ch, ch == '\0' ? 0 : 1));
-            return;
+    }
+    PG_RETURN_BOOL(true);
+}
+
+extern "C" Datum
+gin_triconsistent_msgpack(PG_FUNCTION_ARGS)
+{
+    GinTernaryValue* check = (GinTernaryValue*) PG_GETARG_POINTER(0);
+    StrategyNumber strategy = PG_GETARG_UINT16(1);
+    int32 nkeys = PG_GETARG_INT32(3);
+
+    if (strategy != kMsgpackContainsStrategy) {
+        elog(ERROR, "unrecognized strategy number: %d", strategy);
+    }
+    for (int32 i = 0; i < nkeys; i++) {
+        if (check[i] == GIN_FALSE) {
+            PG_RETURN_GIN_TERNARY_VALUE(GIN_FALSE);
         }
-        case ConverterKind::EnumText:
-            writer.string(enum_label_view(value));
-            return;
-        case ConverterKind::InetText:
-            write_network_string(writer, value, false);
-            return;
-        case ConverterKind::CidrText:
-            write_network_string(writer, value, true);
-            return;
-        case ConverterKind::IntervalText:
-            write_interval_string(writer, value);
-            return;
-        case ConverterKind::Numeric:
-            numeric_write_fast(writer, value);
-            return;
-        case ConverterKind::Date:
-            writer.int64(static_cast<int64_t>(DatumGetDateADT(value)));
-            return;
-        case ConverterKind::Timestamp:
-            writer.int64(static_cast<int64_t>(DatumGetTimestamp(value)));
-            return;
-        case ConverterKind::Timestamptz:
-            writer.int64(static_cast<int64_t>(DatumGetTimestampTz(value)));
-            return;
-        case ConverterKind::Jsonb:
-            writer.binary(datum_jsonb_span(value));
-            return;
-        case ConverterKind::Bytea:
-            writer.binary(datum_bytea_span(value));
-            return;
-        default:
-            break;
     }
+    PG_RETURN_GIN_TERNARY_VALUE(GIN_MAYBE);
+}
 
-    ereport(ERROR,
-            (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-             errmsg("unsupported array element type for fast CBOR path")));
+/*
+ * cbor_extract - Return the CBOR data item at a path as its own bytes.
+ */
+extern "C" Datum
+cbor_extract(PG_FUNCTION_ARGS)
+{
+    return extract_slice_datum(fcinfo, "CBOR", cbor_extract_slice);
 }
 
-static inline void cbor_write_array(
-    z::cborjc::Serializer& writer,
-    const CachedColumn& col,
-    Datum value)
+extern "C" Datum
+cbor_extract_text(PG_FUNCTION_ARGS)
 {
-    ArrayType* arr = DatumGetArrayTypeP(value);
-    int ndim = ARR_NDIM(arr);
+    return extract_typed_datum(fcinfo, "CBOR", cbor_extract_scalar, ExtractTarget::Text);
+}
 
-    if (ndim == 0) {
-        writer.begin_array(0);
-        writer.end_array();
-        return;
+extern "C" Datum
+cbor_extract_int8(PG_FUNCTION_ARGS)
+{
+    return extract_typed_datum(fcinfo, "CBOR", cbor_extract_scalar, ExtractTarget::Int8);
+}
+
+extern "C" Datum
+cbor_extract_float8(PG_FUNCTION_ARGS)
+{
+    return extract_typed_datum(fcinfo, "CBOR", cbor_extract_scalar, ExtractTarget::Float8);
+}
+
+/*
+ * zera_extract - Decode only the ZERA value at a path to jsonb. A ZERA value
+ * references its document's envelope and arena, so it has no standalone
+ * byte form to slice out.
+ */
+extern "C" Datum
+zera_extract(PG_FUNCTION_ARGS)
+{
+    bytea* input = PG_GETARG_BYTEA_PP(0);
+    std::span<const std::string_view> path;
+    if (!extract_path_steps(PG_GETARG_ARRAYTYPE_P(1), &path)) {
+        PG_RETURN_NULL();
     }
+    std::span<const uint8_t> data(
+        reinterpret_cast<const uint8_t*>(VARDATA_ANY(input)),
+        static_cast<size_t>(VARSIZE_ANY_EXHDR(input)));
 
-    if (ndim != 1) {
-        z::dyn::serialize(array_to_dynamic(value, col.typid), writer);
-        return;
+    try {
+        uint32_t root_ofs;
+        ZeraDecodeContext context = zera_open_document(data, &root_ofs);
+        uint32_t ref_offset;
+        if (!zera_locate_path(context, root_ofs, path, &ref_offset)) {
+            PG_RETURN_NULL();
+        }
+        JsonbDecodeWriter writer;
+        zera_replay_value(context, ref_offset, writer, 0);
+        Jsonb* result = writer.finish();
+        PG_FREE_IF_COPY(input, 0);
+        PG_RETURN_JSONB_P(result);
+    } catch (const std::exception& ex) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                 errmsg("invalid ZERA input"),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                 errmsg("invalid ZERA input"),
+                 errdetail("unknown decoding error")));
     }
 
-    Datum* elements;
-    bool* nulls;
-    int nitems;
-    deconstruct_array(arr,
-                      col.array_element_typid,
-                      col.array_typlen,
-                      col.array_typbyval,
-                      col.array_typalign,
-                      &elements,
-                      &nulls,
-                      &nitems);
+    PG_RETURN_NULL();
+}
 
-    writer.begin_array(static_cast<size_t>(nitems));
-    for (int i = 0; i < nitems; i++) {
-        if (nulls[i]) {
-            writer.null();
-        } else if (col.array_element_kind == ConverterKind::Fallback) {
-            write_output_string(writer, col.array_element_typoutput, elements[i]);
-        } else {
-            cbor_write_array_element(writer, col.array_element_kind, elements[i], false);
-        }
-    }
-    writer.end_array();
+extern "C" Datum
+zera_extract_text(PG_FUNCTION_ARGS)
+{
+    return extract_typed_datum(fcinfo, "ZERA", zera_extract_scalar, ExtractTarget::Text);
+}
 
-    pfree(elements);
-    pfree(nulls);
+extern "C" Datum
+zera_extract_int8(PG_FUNCTION_ARGS)
+{
+    return extract_typed_datum(fcinfo, "ZERA", zera_extract_scalar, ExtractTarget::Int8);
 }
 
-static inline void cbor_write_scalar(
-    z::cborjc::Serializer& writer,
-    const CachedColumn& col,
-    Datum value,
-    bool isnull)
+extern "C" Datum
+zera_extract_float8(PG_FUNCTION_ARGS)
 {
-    if (isnull) {
-        writer.null();
-        return;
-    }
+    return extract_typed_datum(fcinfo, "ZERA", zera_extract_scalar, ExtractTarget::Float8);
+}
 
-    switch (col.kind) {
-        case ConverterKind::Int2:
-            writer.int64(static_cast<int64_t>(DatumGetInt16(value)));
-            return;
-        case ConverterKind::Int4:
-            writer.int64(static_cast<int64_t>(DatumGetInt32(value)));
-            return;
-        case ConverterKind::Int8:
-            writer.int64(static_cast<int64_t>(DatumGetInt64(value)));
-            return;
-        case ConverterKind::Float4:
-            writer.double_(static_cast<double>(DatumGetFloat4(value)));
-            return;
-        case ConverterKind::Float8:
-            writer.double_(DatumGetFloat8(value));
-            return;
-        case ConverterKind::Bool:
-            writer.boolean(DatumGetBool(value));
-            return;
-        case ConverterKind::Text:
-        case ConverterKind::JsonText:
-            cbor_write_text(writer, value);
-            return;
-        case ConverterKind::Uuid:
-        {
-            char out[36];
-            format_uuid(value, out);
-            writer.string(std::string_view(out, sizeof(out)));
-            return;
-        }
-        case ConverterKind::NameText:
-            writer.string(name_text_view(value));
-            return;
-        case ConverterKind::CharText:
-        {
-            char ch = DatumGetChar(value);
-            writer.string(std::string_view(&ch, ch == '\0' ? 0 : 1));
-            return;
-        }
-        case ConverterKind::EnumText:
-            writer.string(enum_label_view(value));
-            return;
-        case ConverterKind::InetText:
-            write_network_string(writer, value, false);
-            return;
-        case ConverterKind::CidrText:
-            write_network_string(writer, value, true);
-            return;
-        case ConverterKind::IntervalText:
-            write_interval_string(writer, value);
-            return;
-        case ConverterKind::Numeric:
-            numeric_write_fast(writer, value);
-            return;
-        case ConverterKind::Date:
-            writer.int64(static_cast<int64_t>(DatumGetDateADT(value)));
-            return;
-        case ConverterKind::Timestamp:
-            writer.int64(static_cast<int64_t>(DatumGetTimestamp(value)));
-            return;
-        case ConverterKind::Timestamptz:
-            writer.int64(static_cast<int64_t>(DatumGetTimestampTz(value)));
-            return;
-        case ConverterKind::Jsonb:
-            writer.binary(datum_jsonb_span(value));
-            return;
-        case ConverterKind::Bytea:
-            writer.binary(datum_bytea_span(value));
-            return;
-        case ConverterKind::Array:
-            cbor_write_array(writer, col, value);
-            return;
-        case ConverterKind::Fallback:
-        {
-            char* str = OidOutputFunctionCall(col.typoutput, value);
-            writer.string(std::string_view(str));
-            pfree(str);
-            return;
-        }
-        default:
-            break;
-    }
+/*
+ * Batch splitting returns each element of a top-level array as its own
+ * bytea, one per call. Elements are checked with the protocol's bounded
+ * reader as they are reached, so the input is walked once and the
+ * trailing-bytes check runs after the last element.
+ */
+using ArrayOpenFn = bool (*)(std::span<const uint8_t> data, size_t* pos,
+                             uint64_t* count, bool* indefinite);
+using ArrayElementEndFn = size_t (*)(std::span<const uint8_t> data, size_t pos);
+
+struct ArrayElementsState {
+    const uint8_t* data;
+    size_t length;
+    size_t pos;
+    uint64_t remaining;
+    bool indefinite;
+};
 
-    ereport(ERROR,
-            (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-             errmsg("unsupported type for fast CBOR path"),
-             errdetail("column type OID %u", col.typid)));
+static bool msgpack_open_array(
+    std::span<const uint8_t> data, size_t* pos, uint64_t* count, bool* indefinite)
+{
+    bool is_map;
+    *indefinite = false;
+    return msgpack_read_container(data, pos, count, &is_map) && !is_map;
 }
 
-static inline void cbor_write_record_map(
-    z::cborjc::Serializer& writer,
-    HeapTupleHeader rec,
-    const CachedSchema& schema,
-    TupleDeformScratch* scratch)
+static bool cbor_open_array(
+    std::span<const uint8_t> data, size_t* pos, uint64_t* count, bool* indefinite)
 {
-    HeapTupleData tuple;
-    tuple.t_len = HeapTupleHeaderGetDatumLength(rec);
-    tuple.t_data = rec;
+    CborHead head = cbor_read_head(data, *pos);
+    if (head.major != 4) {
+        return false;
+    }
+    *pos = head.next;
+    *count = head.value;
+    *indefinite = head.indefinite;
+    return true;
+}
 
-    writer.begin_map(schema.columns.size());
-    if (!schema.use_deform_access) {
-        for (const CachedColumn& col : schema.columns) {
-            bool isnull;
-            Datum value = heap_getattr(&tuple, col.attnum, schema.tupdesc, &isnull);
-            writer.key(col.name);
-            cbor_write_scalar(writer, col, value, isnull);
+static bool array_elements_next(
+    ArrayElementsState* state, ArrayElementEndFn element_end, size_t* start, size_t* end)
+{
+    std::span<const uint8_t> data(state->data, state->length);
+    bool done;
+    if (state->indefinite) {
+        cbor_require_bytes(data, state->pos, 1);
+        done = data[state->pos] == 0xff;
+        if (done) {
+            state->pos++;
         }
     } else {
-        const size_t nattrs = static_cast<size_t>(schema.tupdesc->natts);
-        scratch->ensure(nattrs);
-        heap_deform_tuple(&tuple, schema.tupdesc, scratch->values, scratch->nulls);
-        for (const CachedColumn& col : schema.columns) {
-            const int idx = col.attnum - 1;
-            writer.key(col.name);
-            cbor_write_scalar(writer, col, scratch->values[idx], scratch->nulls[idx]);
+        done = state->remaining == 0;
+    }
+    if (done) {
+        if (state->pos != state->length) {
+            throw z::DeserializationError("trailing bytes after array");
         }
+        return false;
     }
-    writer.end_map();
-}
-
-static bytea* try_serialize_cbor_row_fast(HeapTupleHeader rec)
-{
-    Oid tupType = HeapTupleHeaderGetTypeId(rec);
-    int32 tupTypmod = HeapTupleHeaderGetTypMod(rec);
-    const CachedSchema& schema = get_cached_schema(tupType, tupTypmod);
 
-    if (!schema.cbor_fast_supported) {
-        return nullptr;
+    *start = state->pos;
+    *end = element_end(data, state->pos);
+    state->pos = *end;
+    if (!state->indefinite) {
+        state->remaining--;
     }
+    return true;
+}
 
-    try {
-        z::cborjc::RootSerializer rs;
-        z::cborjc::Serializer writer(rs);
-        if (!schema.use_deform_access) {
-            cbor_write_record_map(writer, rec, schema, nullptr);
-        } else {
-            TupleDeformScratch scratch;
-            cbor_write_record_map(writer, rec, schema, &scratch);
+static Datum array_elements_srf(
+    FunctionCallInfo fcinfo, const char* protocol_name, ArrayOpenFn open_array,
+    ArrayElementEndFn element_end)
+{
+    FuncCallContext* funcctx;
+
+    if (SRF_IS_FIRSTCALL()) {
+        funcctx = SRF_FIRSTCALL_INIT();
+        MemoryContext old_context = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+        // Detoasting here keeps any copy alive for the whole set; plain
+        // inputs are read in place.
+        bytea* input = PG_GETARG_BYTEA_PP(0);
+        auto* state = static_cast<ArrayElementsState*>(palloc0(sizeof(ArrayElementsState)));
+        state->data = reinterpret_cast<const uint8_t*>(VARDATA_ANY(input));
+        state->length = static_cast<size_t>(VARSIZE_ANY_EXHDR(input));
+        MemoryContextSwitchTo(old_context);
+
+        bool is_array = false;
+        try {
+            is_array = open_array(std::span<const uint8_t>(state->data, state->length),
+                                  &state->pos, &state->remaining, &state->indefinite);
+        } catch (const std::exception& ex) {
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                     errmsg("invalid %s input", protocol_name),
+                     errdetail("%s", ex.what())));
+        } catch (...) {
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                     errmsg("invalid %s input", protocol_name),
+                     errdetail("unknown decoding error")));
         }
+        if (!is_array) {
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("cannot extract elements from a %s value that is not an array",
+                            protocol_name)));
+        }
+        funcctx->user_fctx = state;
+    }
 
-        z::ZBuffer buffer = rs.finish();
-        std::span<const uint8_t> data = buffer.buf();
-        size_t len = data.size();
-        bytea* result = (bytea*) palloc(len + VARHDRSZ);
-        SET_VARSIZE(result, len + VARHDRSZ);
-        memcpy(VARDATA(result), data.data(), len);
-        return result;
+    funcctx = SRF_PERCALL_SETUP();
+    auto* state = static_cast<ArrayElementsState*>(funcctx->user_fctx);
+    size_t start = 0;
+    size_t end = 0;
+    bool found = false;
+    try {
+        found = array_elements_next(state, element_end, &start, &end);
     } catch (const std::exception& ex) {
         ereport(ERROR,
-                (errcode(ERRCODE_INTERNAL_ERROR),
-                 errmsg("fast CBOR row serialization failed"),
+                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                 errmsg("invalid %s input", protocol_name),
                  errdetail("%s", ex.what())));
     } catch (...) {
         ereport(ERROR,
-                (errcode(ERRCODE_INTERNAL_ERROR),
-                 errmsg("fast CBOR row serialization failed with unknown exception")));
+                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                 errmsg("invalid %s input", protocol_name),
+                 errdetail("unknown decoding error")));
+    }
+    if (!found) {
+        SRF_RETURN_DONE(funcctx);
     }
 
-    return nullptr;
+    const size_t len = end - start;
+    bytea* result = (bytea*) palloc(len + VARHDRSZ);
+    SET_VARSIZE(result, len + VARHDRSZ);
+    memcpy(VARDATA(result), state->data + start, len);
+    SRF_RETURN_NEXT(funcctx, PointerGetDatum(result));
+}
+
+/*
+ * msgpack_array_elements - Return each element of a MessagePack array, such
+ * as a rows_to_msgpack batch, as a standalone MessagePack value.
+ */
+extern "C" Datum
+msgpack_array_elements(PG_FUNCTION_ARGS)
+{
+    return array_elements_srf(fcinfo, "MessagePack", msgpack_open_array,
+                              msgpack_validate_value);
 }
 
-static bytea* try_serialize_cbor_array_fast(Datum* elements, bool* nulls, int nitems)
+/*
+ * cbor_array_elements - Return each element of a definite or indefinite CBOR
+ * array as a standalone CBOR data item.
+ */
+extern "C" Datum
+cbor_array_elements(PG_FUNCTION_ARGS)
 {
-    std::vector<const CachedSchema*> schemas;
-    schemas.reserve(nitems);
+    return array_elements_srf(fcinfo, "CBOR", cbor_open_array, cbor_skip_value);
+}
 
-    for (int i = 0; i < nitems; i++) {
-        if (nulls[i]) {
-            schemas.push_back(nullptr);
-            continue;
-        }
+/*
+ * Record decoding reads MessagePack maps straight into composite datums.
+ * Keys resolve to attributes through the cached schema's name index, and
+ * values already in a column's binary form (integers, floats, booleans,
+ * binary, and the epoch-relative integers row_to_msgpack writes for dates
+ * and timestamps) become datums without text parsing. Anything else goes
+ * through the type's input function with the column typmod, so domains,
+ * length limits, and range errors match text input. Callers validate the
+ * whole document first; the readers below only skip and decode.
+ */
+struct MsgpackDecodeTarget {
+    Oid typid;
+    int32 typmod;
+    ConverterKind kind;
+    Oid typinput;
+    Oid typioparam;
+};
 
-        HeapTupleHeader rec = DatumGetHeapTupleHeader(elements[i]);
-        Oid tupType = HeapTupleHeaderGetTypeId(rec);
-        int32 tupTypmod = HeapTupleHeaderGetTypMod(rec);
-        const CachedSchema& schema = get_cached_schema(tupType, tupTypmod);
+static Datum msgpack_decode_record(
+    std::span<const uint8_t> data, size_t* pos, const CachedSchema& schema,
+    HeapTupleHeader base, const int* positions = nullptr, uint64_t npositions = 0);
 
-        if (!schema.cbor_fast_supported) {
-            return nullptr;
+static bool msgpack_value_int64(const z::MsgPackDeserializer& value, int64_t* out)
+{
+    if (value.isUInt()) {
+        const uint64_t number = value.asUInt64();
+        if (number > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+            return false;
         }
-        schemas.push_back(&schema);
+        *out = static_cast<int64_t>(number);
+        return true;
+    }
+    if (value.isInt()) {
+        *out = value.asInt64();
+        return true;
     }
+    return false;
+}
 
-    try {
-        z::cborjc::RootSerializer rs;
-        z::cborjc::Serializer writer(rs);
-        TupleDeformScratch scratch;
+static bool msgpack_value_double(const z::MsgPackDeserializer& value, double* out)
+{
+    if (value.isFloat()) {
+        *out = value.asDouble();
+        return true;
+    }
+    if (value.isUInt()) {
+        *out = static_cast<double>(value.asUInt64());
+        return true;
+    }
+    if (value.isInt()) {
+        *out = static_cast<double>(value.asInt64());
+        return true;
+    }
+    return false;
+}
 
-        writer.begin_array(static_cast<size_t>(nitems));
-        for (int i = 0; i < nitems; i++) {
-            if (nulls[i]) {
-                writer.null();
-            } else {
-                HeapTupleHeader rec = DatumGetHeapTupleHeader(elements[i]);
-                cbor_write_record_map(writer, rec, *schemas[i], &scratch);
-            }
-        }
-        writer.end_array();
+/* The text an input function would expect; containers render as JSON. */
+static char* msgpack_value_input_text(
+    std::span<const uint8_t> data, size_t pos, size_t end, Oid typid)
+{
+    z::MsgPackDeserializer value(data.subspan(pos, end - pos));
+    if (value.isString()) {
+        std::string_view text = value.asStringView();
+        check_decoded_string(text);
+        return pnstrdup(text.data(), text.size());
+    }
+    if (value.isBool()) {
+        return pstrdup(value.asBool() ? "true" : "false");
+    }
 
-        z::ZBuffer buffer = rs.finish();
-        std::span<const uint8_t> data = buffer.buf();
-        size_t len = data.size();
-        bytea* result = (bytea*) palloc(len + VARHDRSZ);
-        SET_VARSIZE(result, len + VARHDRSZ);
-        memcpy(VARDATA(result), data.data(), len);
-        return result;
-    } catch (const std::exception& ex) {
-        ereport(ERROR,
-                (errcode(ERRCODE_INTERNAL_ERROR),
-                 errmsg("fast CBOR batch serialization failed"),
-                 errdetail("%s", ex.what())));
-    } catch (...) {
+    std::array<char, 64> buffer;
+    if (value.isUInt() || value.isInt()) {
+        auto converted = value.isUInt()
+            ? std::to_chars(buffer.data(), buffer.data() + buffer.size(), value.asUInt64())
+            : std::to_chars(buffer.data(), buffer.data() + buffer.size(), value.asInt64());
+        return pnstrdup(buffer.data(), converted.ptr - buffer.data());
+    }
+    if (value.isFloat()) {
+        const double number = value.asDouble();
+        if (std::isnan(number)) return pstrdup("NaN");
+        if (std::isinf(number)) return pstrdup(number > 0 ? "Infinity" : "-Infinity");
+        format_decoded_double(number, buffer);
+        return pstrdup(buffer.data());
+    }
+    if (value.isBlob()) {
         ereport(ERROR,
-                (errcode(ERRCODE_INTERNAL_ERROR),
-                 errmsg("fast CBOR batch serialization failed with unknown exception")));
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("cannot decode MessagePack binary as type %s",
+                        format_type_be(typid))));
     }
 
-    return nullptr;
+    JsonbDecodeWriter writer;
+    msgpack_replay_value(data, pos, writer);
+    Jsonb* container = writer.finish();
+    return JsonbToCString(nullptr, &container->root, VARSIZE(container));
 }
 
-static inline void zera_write_text(z::zera::Serializer& writer, Datum value)
+/* Recognizes the ["~n", text, "decimal"] form of the tagged numeric encoding. */
+static bool msgpack_tagged_decimal(
+    std::span<const uint8_t> data, size_t pos, std::string_view* digits)
 {
-    text* txt = DatumGetTextPP(value);
-    const char* ptr = VARDATA_ANY(txt);
-    int len = VARSIZE_ANY_EXHDR(txt);
-    writer.string(std::string_view(ptr, static_cast<size_t>(len)));
+    uint64_t count;
+    bool is_map;
+    if (!msgpack_read_container(data, &pos, &count, &is_map) || is_map || count != 3) {
+        return false;
+    }
+    std::string_view parts[3];
+    for (std::string_view& part : parts) {
+        const uint8_t marker = data[pos];
+        if (!msgpack_marker_is_string(marker)) {
+            return false;
+        }
+        pos = msgpack_replay_string(data, pos + 1, marker, &part);
+    }
+    if (parts[0] != "~n" || parts[2] != "decimal") {
+        return false;
+    }
+    *digits = parts[1];
+    return true;
 }
 
-static inline void zera_write_array_element(
-    z::zera::Serializer& writer,
-    ConverterKind elem_kind,
-    Datum value,
-    bool isnull)
+/*
+ * Whether the array at pos is a tagged scalar of the element kind, such as
+ * a tagged numeric, rather than a nested array.
+ */
+static bool msgpack_is_tagged_scalar(std::span<const uint8_t> data, size_t pos, ConverterKind kind)
 {
-    if (isnull) {
-        writer.null();
-        return;
+    uint64_t count;
+    bool is_map;
+    if (!msgpack_read_container(data, &pos, &count, &is_map) || is_map || count < 3 ||
+        count > 4 || !msgpack_marker_is_string(data[pos])) {
+        return false;
     }
-
-    switch (elem_kind) {
-        case ConverterKind::Int2:
-            writer.int64(static_cast<int64_t>(DatumGetInt16(value)));
-            return;
-        case ConverterKind::Int4:
-            writer.int64(static_cast<int64_t>(DatumGetInt32(value)));
-            return;
-        case ConverterKind::Int8:
-            writer.int64(static_cast<int64_t>(DatumGetInt64(value)));
-            return;
-        case ConverterKind::Float4:
-            writer.double_(static_cast<double>(DatumGetFloat4(value)));
-            return;
-        case ConverterKind::Float8:
-            writer.double_(DatumGetFloat8(value));
-            return;
-        case ConverterKind::Bool:
-            writer.boolean(DatumGetBool(value));
-            return;
-        case ConverterKind::Text:
-        case ConverterKind::JsonText:
-            zera_write_text(writer, value);
-            return;
-        case ConverterKind::Uuid:
-        {
-            char out[36];
-            format_uuid(value, out);
-            writer.string(std::string_view(out, sizeof(out)));
-            return;
-        }
-        case ConverterKind::NameText:
-            writer.string(name_text_view(value));
-            return;
-        case ConverterKind::CharText:
-        {
-            char ch = DatumGetChar(value);
-            writer.string(std::string_view(&ch, ch == '\0' ? 0 : 1));
-            return;
-        }
-        case ConverterKind::EnumText:
-            writer.string(enum_label_view(value));
-            return;
-        case ConverterKind::InetText:
-            write_network_string(writer, value, false);
-            return;
-        case ConverterKind::CidrText:
-            write_network_string(writer, value, true);
-            return;
-        case ConverterKind::IntervalText:
-            write_interval_string(writer, value);
-            return;
+    std::string_view tag;
+    msgpack_replay_string(data, pos + 1, data[pos], &tag);
+    switch (kind) {
         case ConverterKind::Numeric:
-            numeric_write_fast(writer, value);
-            return;
-        case ConverterKind::Date:
-            writer.int64(static_cast<int64_t>(DatumGetDateADT(value)));
-            return;
+            return count == 3 && (tag == "~d" || tag == "~n");
         case ConverterKind::Timestamp:
-            writer.int64(static_cast<int64_t>(DatumGetTimestamp(value)));
-            return;
         case ConverterKind::Timestamptz:
-            writer.int64(static_cast<int64_t>(DatumGetTimestampTz(value)));
-            return;
-        case ConverterKind::Jsonb:
-            writer.binary(datum_jsonb_span(value));
-            return;
-        case ConverterKind::Bytea:
-            writer.binary(datum_bytea_span(value));
-            return;
+            return count == 3 && tag == "~t";
+        case ConverterKind::InetText:
+        case ConverterKind::CidrText:
+            return count == 3 && tag == "~ip";
+        case ConverterKind::IntervalText:
+            return count == 4 && tag == "~iv";
         default:
-            break;
+            return false;
     }
-
-    ereport(ERROR,
-            (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-             errmsg("unsupported array element type for fast ZERA path")));
 }
 
-static inline void zera_write_array(
-    z::zera::Serializer& writer,
-    const CachedColumn& col,
-    Datum value)
-{
-    ArrayType* arr = DatumGetArrayTypeP(value);
-    int ndim = ARR_NDIM(arr);
-
-    if (ndim == 0) {
-        writer.begin_array(0);
-        writer.end_array();
-        return;
+/*
+ * Opens the ["<tag>", ...] array of a native type written through dynamic
+ * values; on success pos is at the first element after the tag.
+ */
+static bool msgpack_open_tagged(
+    std::span<const uint8_t> data, size_t* pos, std::string_view tag, uint64_t count)
+{
+    size_t cursor = *pos;
+    uint64_t found;
+    bool is_map;
+    if (!msgpack_read_container(data, &cursor, &found, &is_map) || is_map || found != count ||
+        !msgpack_marker_is_string(data[cursor])) {
+        return false;
+    }
+    std::string_view found_tag;
+    cursor = msgpack_replay_string(data, cursor + 1, data[cursor], &found_tag);
+    if (found_tag != tag) {
+        return false;
     }
+    *pos = cursor;
+    return true;
+}
 
-    if (ndim != 1) {
-        z::dyn::serialize(array_to_dynamic(value, col.typid), writer);
-        return;
+/* Reads the integer at *pos and moves past it. */
+static bool msgpack_next_int64(std::span<const uint8_t> data, size_t* pos, int64_t* out)
+{
+    const size_t next = msgpack_skip_value(data, *pos);
+    if (!msgpack_value_int64(z::MsgPackDeserializer(data.subspan(*pos, next - *pos)), out)) {
+        return false;
     }
+    *pos = next;
+    return true;
+}
 
-    Datum* elements;
-    bool* nulls;
-    int nitems;
-    deconstruct_array(arr,
-                      col.array_element_typid,
-                      col.array_typlen,
-                      col.array_typbyval,
-                      col.array_typalign,
-                      &elements,
-                      &nulls,
-                      &nitems);
+/* Recognizes a native timestamp: the ext value or ["~t", seconds, nanoseconds]. */
+static bool msgpack_native_timestamp(std::span<const uint8_t> data, size_t pos, Timestamp* out)
+{
+    uint8_t type;
+    size_t len;
+    const uint8_t marker = data[pos];
+    if (msgpack_marker_is_ext(marker)) {
+        pos++;
+        if (!msgpack_read_ext(data, &pos, marker, &type, &len) || type != kMsgpackTimestampExt) {
+            return false;
+        }
+        *out = msgpack_read_timestamp(data.data() + pos, len);
+        return true;
+    }
+    int64_t seconds;
+    int64_t nanoseconds;
+    if (!msgpack_open_tagged(data, &pos, "~t", 3) || !msgpack_next_int64(data, &pos, &seconds) ||
+        !msgpack_next_int64(data, &pos, &nanoseconds) || nanoseconds < 0 ||
+        nanoseconds > PG_UINT32_MAX) {
+        return false;
+    }
+    *out = timestamp_from_epoch(seconds, static_cast<uint32_t>(nanoseconds));
+    return true;
+}
 
-    writer.begin_array(static_cast<size_t>(nitems));
-    for (int i = 0; i < nitems; i++) {
-        if (nulls[i]) {
-            writer.null();
-        } else if (col.array_element_kind == ConverterKind::Fallback) {
-            write_output_string(writer, col.array_element_typoutput, elements[i]);
-        } else {
-            zera_write_array_element(writer, col.array_element_kind, elements[i], false);
+/* Recognizes a native network address: the ext value or ["~ip", prefix, address]. */
+static bool msgpack_native_network(std::span<const uint8_t> data, size_t pos, NetworkValue* out)
+{
+    uint8_t type;
+    size_t len;
+    const uint8_t marker = data[pos];
+    if (msgpack_marker_is_ext(marker)) {
+        pos++;
+        if (!msgpack_read_ext(data, &pos, marker, &type, &len) || type != kMsgpackNetworkExt) {
+            return false;
         }
+        *out = msgpack_read_network(data.data() + pos, len);
+        return true;
     }
-    writer.end_array();
+    int64_t bits;
+    if (!msgpack_open_tagged(data, &pos, "~ip", 3) || !msgpack_next_int64(data, &pos, &bits) ||
+        bits < 0 || bits > 128) {
+        return false;
+    }
+    z::MsgPackDeserializer address(data.subspan(pos, msgpack_skip_value(data, pos) - pos));
+    if (!address.isBlob()) {
+        return false;
+    }
+    std::span<const std::byte> bytes = address.asBlob();
+    uint8_t payload[17];
+    if (bytes.size() != 4 && bytes.size() != 16) {
+        throw z::DeserializationError("network address has an invalid length");
+    }
+    payload[0] = static_cast<uint8_t>(bits);
+    memcpy(payload + 1, bytes.data(), bytes.size());
+    *out = msgpack_read_network(payload, bytes.size() + 1);
+    return true;
+}
 
-    pfree(elements);
-    pfree(nulls);
+/* Recognizes a native interval: the ext value or ["~iv", months, days, microseconds]. */
+static bool msgpack_native_interval(std::span<const uint8_t> data, size_t pos, Interval* out)
+{
+    uint8_t type;
+    size_t len;
+    const uint8_t marker = data[pos];
+    if (msgpack_marker_is_ext(marker)) {
+        pos++;
+        if (!msgpack_read_ext(data, &pos, marker, &type, &len) || type != kMsgpackIntervalExt) {
+            return false;
+        }
+        *out = msgpack_read_interval(data.data() + pos, len);
+        return true;
+    }
+    int64_t months;
+    int64_t days;
+    int64_t micros;
+    if (!msgpack_open_tagged(data, &pos, "~iv", 4) || !msgpack_next_int64(data, &pos, &months) ||
+        !msgpack_next_int64(data, &pos, &days) || !msgpack_next_int64(data, &pos, &micros) ||
+        months < PG_INT32_MIN || months > PG_INT32_MAX || days < PG_INT32_MIN ||
+        days > PG_INT32_MAX) {
+        return false;
+    }
+    out->month = static_cast<int32>(months);
+    out->day = static_cast<int32>(days);
+    out->time = micros;
+    return true;
 }
 
-static inline void zera_write_scalar(
-    z::zera::Serializer& writer,
-    const CachedColumn& col,
-    Datum value,
-    bool isnull)
+/*
+ * Recognizes a binary decimal: the ext value, or the ["~d", exponent,
+ * mantissa] array written through dynamic values.
+ */
+static bool msgpack_decimal_value(std::span<const uint8_t> data, size_t pos, DecimalValue* out)
 {
-    if (isnull) {
-        writer.null();
-        return;
+    if (msgpack_marker_is_ext(data[pos])) {
+        return msgpack_ext_decimal(data, pos, out);
+    }
+    uint64_t count;
+    bool is_map;
+    if (!msgpack_read_container(data, &pos, &count, &is_map) || is_map || count != 3 ||
+        !msgpack_marker_is_string(data[pos])) {
+        return false;
+    }
+    std::string_view tag;
+    pos = msgpack_replay_string(data, pos + 1, data[pos], &tag);
+    if (tag != "~d") {
+        return false;
     }
 
-    switch (col.kind) {
+    size_t next = msgpack_skip_value(data, pos);
+    int64_t exponent;
+    if (!msgpack_value_int64(z::MsgPackDeserializer(data.subspan(pos, next - pos)), &exponent)) {
+        return false;
+    }
+    pos = next;
+    next = msgpack_skip_value(data, pos);
+    z::MsgPackDeserializer mantissa(data.subspan(pos, next - pos));
+    int64_t small;
+    if (msgpack_value_int64(mantissa, &small)) {
+        uint8_t bytes[8];
+        decimal_from_twos_complement(bytes, twos_complement_int64(small, bytes), out);
+    } else if (mantissa.isBlob() && !mantissa.asBlob().empty()) {
+        std::span<const std::byte> bytes = mantissa.asBlob();
+        decimal_from_twos_complement(reinterpret_cast<const uint8_t*>(bytes.data()),
+                                     bytes.size(), out);
+    } else {
+        return false;
+    }
+    out->exponent = decimal_checked_exponent(exponent);
+    return true;
+}
+
+static Datum msgpack_decode_scalar(
+    std::span<const uint8_t> data, size_t pos, size_t end, const MsgpackDecodeTarget& target)
+{
+    z::MsgPackDeserializer value(data.subspan(pos, end - pos));
+    int64_t integer;
+    double number;
+
+    switch (target.kind) {
         case ConverterKind::Int2:
-            writer.int64(static_cast<int64_t>(DatumGetInt16(value)));
-            return;
+            if (msgpack_value_int64(value, &integer) &&
+                integer >= PG_INT16_MIN && integer <= PG_INT16_MAX) {
+                return Int16GetDatum(static_cast<int16>(integer));
+            }
+            break;
         case ConverterKind::Int4:
-            writer.int64(static_cast<int64_t>(DatumGetInt32(value)));
-            return;
+            if (msgpack_value_int64(value, &integer) &&
+                integer >= PG_INT32_MIN && integer <= PG_INT32_MAX) {
+                return Int32GetDatum(static_cast<int32>(integer));
+            }
+            break;
         case ConverterKind::Int8:
-            writer.int64(static_cast<int64_t>(DatumGetInt64(value)));
-            return;
+            if (msgpack_value_int64(value, &integer)) {
+                return Int64GetDatum(integer);
+            }
+            break;
         case ConverterKind::Float4:
-            writer.double_(static_cast<double>(DatumGetFloat4(value)));
-            return;
+            if (msgpack_value_double(value, &number)) {
+                const float4 narrowed = static_cast<float4>(number);
+                if (std::isinf(narrowed) && !std::isinf(number)) {
+                    ereport(ERROR,
+                            (errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+                             errmsg("value out of range: overflow")));
+                }
+                if (narrowed == 0.0f && number != 0.0) {
+                    ereport(ERROR,
+                            (errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+                             errmsg("value out of range: underflow")));
+                }
+                return Float4GetDatum(narrowed);
+            }
+            break;
         case ConverterKind::Float8:
-            writer.double_(DatumGetFloat8(value));
-            return;
+            if (msgpack_value_double(value, &number)) {
+                return Float8GetDatum(number);
+            }
+            break;
         case ConverterKind::Bool:
-            writer.boolean(DatumGetBool(value));
-            return;
+            if (value.isBool()) {
+                return BoolGetDatum(value.asBool());
+            }
+            break;
         case ConverterKind::Text:
-        case ConverterKind::JsonText:
-            zera_write_text(writer, value);
-            return;
-        case ConverterKind::Uuid:
-        {
-            char out[36];
-            format_uuid(value, out);
-            writer.string(std::string_view(out, sizeof(out)));
-            return;
-        }
-        case ConverterKind::NameText:
-            writer.string(name_text_view(value));
-            return;
-        case ConverterKind::CharText:
+            if (value.isString() && target.typmod < 0) {
+                std::string_view text = value.asStringView();
+                check_decoded_string(text);
+                return PointerGetDatum(
+                    cstring_to_text_with_len(text.data(), static_cast<int>(text.size())));
+            }
+            break;
+        case ConverterKind::Numeric:
         {
-            char ch = DatumGetChar(value);
-            writer.string(std::string_view(&ch, ch == '\0' ? 0 : 1));
-            return;
+            std::string_view digits;
+            DecimalValue decimal;
+            if (target.typmod < 0 && msgpack_value_int64(value, &integer)) {
+                return NumericGetDatum(int64_to_numeric(integer));
+            }
+            if ((value.isArray() || msgpack_marker_is_ext(data[pos])) &&
+                msgpack_decimal_value(data, pos, &decimal)) {
+                std::string text;
+                decimal_format_fixed(decimal, &text);
+                return OidInputFunctionCall(target.typinput, text.data(),
+                                            target.typioparam, target.typmod);
+            }
+            if (value.isArray() && msgpack_tagged_decimal(data, pos, &digits)) {
+                return OidInputFunctionCall(target.typinput,
+                                            pnstrdup(digits.data(), digits.size()),
+                                            target.typioparam, target.typmod);
+            }
+            break;
         }
-        case ConverterKind::EnumText:
-            writer.string(enum_label_view(value));
-            return;
+        case ConverterKind::Date:
+            if (msgpack_value_int64(value, &integer)) {
+                const DateADT date = static_cast<DateADT>(integer);
+                if (integer < PG_INT32_MIN || integer > PG_INT32_MAX ||
+                    !(DATE_NOT_FINITE(date) || IS_VALID_DATE(date))) {
+                    ereport(ERROR,
+                            (errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+                             errmsg("date out of range")));
+                }
+                return DateADTGetDatum(date);
+            }
+            break;
+        case ConverterKind::Uuid:
+            if (value.isBlob() && value.asBlob().size() == UUID_LEN) {
+                auto* uuid = static_cast<pg_uuid_t*>(palloc(sizeof(pg_uuid_t)));
+                memcpy(uuid->data, value.asBlob().data(), UUID_LEN);
+                return UUIDPGetDatum(uuid);
+            }
+            break;
         case ConverterKind::InetText:
-            write_network_string(writer, value, false);
-            return;
         case ConverterKind::CidrText:
-            write_network_string(writer, value, true);
-            return;
+        {
+            // Through the input function, which checks cidr host bits.
+            NetworkValue network;
+            if ((value.isArray() || msgpack_marker_is_ext(data[pos])) &&
+                msgpack_native_network(data, pos, &network)) {
+                char out[kNetworkTextCapacity];
+                const std::string_view text =
+                    network_format_text(network, target.kind == ConverterKind::CidrText, out);
+                return OidInputFunctionCall(target.typinput, pnstrdup(text.data(), text.size()),
+                                            target.typioparam, target.typmod);
+            }
+            break;
+        }
         case ConverterKind::IntervalText:
-            write_interval_string(writer, value);
-            return;
-        case ConverterKind::Numeric:
-            numeric_write_fast(writer, value);
-            return;
-        case ConverterKind::Date:
-            writer.int64(static_cast<int64_t>(DatumGetDateADT(value)));
-            return;
+        {
+            Interval span;
+            if ((value.isArray() || msgpack_marker_is_ext(data[pos])) &&
+                msgpack_native_interval(data, pos, &span)) {
+                auto* result = static_cast<Interval*>(palloc(sizeof(Interval)));
+                *result = span;
+                if (target.typmod >= 0) {
+                    return DirectFunctionCall2(interval_scale, IntervalPGetDatum(result),
+                                               Int32GetDatum(target.typmod));
+                }
+                return IntervalPGetDatum(result);
+            }
+            break;
+        }
         case ConverterKind::Timestamp:
-            writer.int64(static_cast<int64_t>(DatumGetTimestamp(value)));
-            return;
         case ConverterKind::Timestamptz:
-            writer.int64(static_cast<int64_t>(DatumGetTimestampTz(value)));
-            return;
+        {
+            Timestamp native;
+            if ((value.isArray() || msgpack_marker_is_ext(data[pos])) &&
+                msgpack_native_timestamp(data, pos, &native)) {
+                if (target.typmod >= 0) {
+                    AdjustTimestampForTypmod(&native, target.typmod, nullptr);
+                }
+                return TimestampGetDatum(native);
+            }
+            if (msgpack_value_int64(value, &integer)) {
+                Timestamp ts = static_cast<Timestamp>(integer);
+                if (!TIMESTAMP_NOT_FINITE(ts) && !IS_VALID_TIMESTAMP(ts)) {
+                    ereport(ERROR,
+                            (errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+                             errmsg("timestamp out of range")));
+                }
+                if (target.typmod >= 0) {
+                    AdjustTimestampForTypmod(&ts, target.typmod, nullptr);
+                }
+                return TimestampGetDatum(ts);
+            }
+            break;
+        }
         case ConverterKind::Jsonb:
-            writer.binary(datum_jsonb_span(value));
-            return;
-        case ConverterKind::Bytea:
-            writer.binary(datum_bytea_span(value));
-            return;
-        case ConverterKind::Array:
-            zera_write_array(writer, col, value);
-            return;
-        case ConverterKind::Fallback:
         {
-            char* str = OidOutputFunctionCall(col.typoutput, value);
-            writer.string(std::string_view(str));
-            pfree(str);
-            return;
+            // row_to_msgpack writes jsonb columns in their internal layout,
+            // which is not safe to accept from the wire.
+            if (value.isBlob()) {
+                ereport(ERROR,
+                        (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                         errmsg("cannot decode MessagePack binary as type jsonb"),
+                         errhint("Encode jsonb values with msgpack_from_jsonb.")));
+            }
+            JsonbDecodeWriter writer;
+            msgpack_replay_value(data, pos, writer);
+            return JsonbPGetDatum(writer.finish());
         }
+        case ConverterKind::Bytea:
+            if (value.isBlob()) {
+                std::span<const std::byte> bytes = value.asBlob();
+                bytea* result = (bytea*) palloc(bytes.size() + VARHDRSZ);
+                SET_VARSIZE(result, bytes.size() + VARHDRSZ);
+                if (!bytes.empty()) {
+                    memcpy(VARDATA(result), bytes.data(), bytes.size());
+                }
+                return PointerGetDatum(result);
+            }
+            break;
         default:
             break;
     }
 
-    ereport(ERROR,
-            (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-             errmsg("unsupported type for fast ZERA path"),
-             errdetail("column type OID %u", col.typid)));
+    char* input = msgpack_value_input_text(data, pos, end, target.typid);
+    return OidInputFunctionCall(target.typinput, input, target.typioparam, target.typmod);
 }
 
-static inline void zera_write_record_map(
-    z::zera::Serializer& writer,
-    HeapTupleHeader rec,
-    const CachedSchema& schema,
-    TupleDeformScratch* scratch)
+static Datum msgpack_decode_datum(
+    std::span<const uint8_t> data, size_t* pos, const CachedColumn& col, bool element,
+    HeapTupleHeader base, bool* isnull);
+
+static size_t msgpack_decode_array_level(
+    std::span<const uint8_t> data, size_t pos, const CachedColumn& col,
+    const int* dims, int ndim, int depth, Datum* values, bool* nulls, int* offset)
 {
-    HeapTupleData tuple;
-    tuple.t_len = HeapTupleHeaderGetDatumLength(rec);
-    tuple.t_data = rec;
+    uint64_t count;
+    bool is_map;
+    if (!msgpack_read_container(data, &pos, &count, &is_map) || is_map ||
+        count != static_cast<uint64_t>(dims[depth])) {
+        ereport(ERROR,
+                (errcode(ERRCODE_ARRAY_SUBSCRIPT_ERROR),
+                 errmsg("multidimensional arrays must have sub-arrays with matching dimensions")));
+    }
+    for (uint64_t i = 0; i < count; i++) {
+        if (depth == ndim - 1) {
+            values[*offset] = msgpack_decode_datum(
+                data, &pos, col, true, nullptr, &nulls[*offset]);
+            (*offset)++;
+        } else {
+            pos = msgpack_decode_array_level(
+                data, pos, col, dims, ndim, depth + 1, values, nulls, offset);
+        }
+    }
+    return pos;
+}
 
-    writer.begin_map(schema.columns.size());
-    if (!schema.use_deform_access) {
-        for (const CachedColumn& col : schema.columns) {
-            bool isnull;
-            Datum value = heap_getattr(&tuple, col.attnum, schema.tupdesc, &isnull);
-            writer.key_preencoded(col.zera_key_encoded);
-            zera_write_scalar(writer, col, value, isnull);
+/*
+ * Nested MessagePack arrays become dimensions, except under json and jsonb
+ * elements, where an inner array is itself an element value.
+ */
+static Datum msgpack_decode_array(
+    std::span<const uint8_t> data, size_t* pos, const CachedColumn& col)
+{
+    const bool nests = col.array_element_kind != ConverterKind::Jsonb &&
+                       col.array_element_kind != ConverterKind::JsonText;
+    int dims[MAXDIM];
+    int lbs[MAXDIM];
+    int ndim = 0;
+    size_t probe = *pos;
+    for (;;) {
+        uint64_t count;
+        bool is_map;
+        if (ndim > 0 && msgpack_is_tagged_scalar(data, probe, col.array_element_kind)) {
+            break;
         }
+        if (!msgpack_read_container(data, &probe, &count, &is_map) || is_map) {
+            break;
+        }
+        if (ndim == MAXDIM) {
+            ereport(ERROR,
+                    (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+                     errmsg("number of array dimensions exceeds the maximum allowed (%d)",
+                            MAXDIM)));
+        }
+        if (count > MaxArraySize) {
+            ereport(ERROR,
+                    (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+                     errmsg("array size exceeds the maximum allowed (%d)",
+                            (int) MaxArraySize)));
+        }
+        dims[ndim] = static_cast<int>(count);
+        lbs[ndim] = 1;
+        ndim++;
+        if (count == 0 || !nests) {
+            break;
+        }
+    }
+
+    const int nitems = ArrayGetNItems(ndim, dims);
+    auto* values = static_cast<Datum*>(palloc(sizeof(Datum) * Max(nitems, 1)));
+    auto* nulls = static_cast<bool*>(palloc(sizeof(bool) * Max(nitems, 1)));
+    int offset = 0;
+    *pos = msgpack_decode_array_level(data, *pos, col, dims, ndim, 0, values, nulls, &offset);
+
+    ArrayType* result;
+    if (nitems == 0) {
+        result = construct_empty_array(col.array_element_typid);
     } else {
-        const size_t nattrs = static_cast<size_t>(schema.tupdesc->natts);
-        scratch->ensure(nattrs);
-        heap_deform_tuple(&tuple, schema.tupdesc, scratch->values, scratch->nulls);
-        for (const CachedColumn& col : schema.columns) {
-            const int idx = col.attnum - 1;
-            writer.key_preencoded(col.zera_key_encoded);
-            zera_write_scalar(writer, col, scratch->values[idx], scratch->nulls[idx]);
+        result = construct_md_array(values, nulls, ndim, dims, lbs,
+                                    col.array_element_typid, col.array_typlen,
+                                    col.array_typbyval, col.array_typalign);
+    }
+    pfree(values);
+    pfree(nulls);
+    return PointerGetDatum(result);
+}
+
+/*
+ * A typed-array ext value for a one-dimensional array column. Packed
+ * elements of the column's own element type are copied; others are decoded
+ * as the equivalent MessagePack number, so int4 data fills an int8[] or
+ * numeric[] column just as the generic form would.
+ */
+static Datum msgpack_decode_typed_array(
+    std::span<const uint8_t> data, size_t* pos, const CachedColumn& col)
+{
+    size_t cursor = *pos + 1;
+    uint8_t type;
+    size_t len;
+    msgpack_read_ext(data, &cursor, data[*pos], &type, &len);
+    const TypedArrayFormat& fmt = msgpack_typed_array_ext(type, len);
+    const size_t nitems = len / fmt.width;
+    if (nitems > MaxArraySize) {
+        ereport(ERROR,
+                (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+                 errmsg("array size exceeds the maximum allowed (%d)",
+                        (int) MaxArraySize)));
+    }
+    *pos = cursor + len;
+    if (nitems == 0) {
+        return PointerGetDatum(construct_empty_array(col.array_element_typid));
+    }
+
+    const MsgpackDecodeTarget target{
+        col.array_element_typid, col.typmod, col.array_element_kind,
+        col.array_element_typinput, col.array_element_typioparam};
+    const uint8_t* elements = data.data() + cursor;
+    auto* values = static_cast<Datum*>(palloc(sizeof(Datum) * nitems));
+    for (size_t i = 0; i < nitems; i++) {
+        const uint8_t* p = elements + fmt.width * i;
+        if (target.kind == fmt.kind) {
+            switch (fmt.kind) {
+                case ConverterKind::Int2:
+                    values[i] = Int16GetDatum(typed_array_load<int16_t>(p));
+                    break;
+                case ConverterKind::Int4:
+                    values[i] = Int32GetDatum(typed_array_load<int32_t>(p));
+                    break;
+                case ConverterKind::Int8:
+                    values[i] = Int64GetDatum(typed_array_load<int64_t>(p));
+                    break;
+                case ConverterKind::Float4:
+                    values[i] = Float4GetDatum(typed_array_load<float>(p));
+                    break;
+                default:
+                    values[i] = Float8GetDatum(typed_array_load<double>(p));
+                    break;
+            }
+            continue;
+        }
+
+        uint8_t scalar[9];
+        uint8_t* end;
+        if (fmt.is_float) {
+            const double number = fmt.width == 4
+                ? static_cast<double>(typed_array_load<float>(p))
+                : typed_array_load<double>(p);
+            scalar[0] = 0xcb;
+            msgpack_store_be64(scalar + 1, std::bit_cast<uint64_t>(number));
+            end = scalar + 9;
+        } else {
+            const uint64_t bits = typed_array_load_bits(p, fmt.width);
+            const int shift = 64 - 8 * fmt.width;
+            end = msgpack_encode_int64(scalar, static_cast<int64_t>(bits << shift) >> shift);
         }
+        values[i] = msgpack_decode_scalar(
+            std::span<const uint8_t>(scalar, static_cast<size_t>(end - scalar)),
+            0, static_cast<size_t>(end - scalar), target);
     }
-    writer.end_map();
+
+    ArrayType* result = construct_array(values, static_cast<int>(nitems),
+                                        col.array_element_typid, col.array_typlen,
+                                        col.array_typbyval, col.array_typalign);
+    pfree(values);
+    return PointerGetDatum(result);
 }
 
-static bytea* try_serialize_zera_row_fast(HeapTupleHeader rec)
+static Datum msgpack_decode_datum(
+    std::span<const uint8_t> data, size_t* pos, const CachedColumn& col, bool element,
+    HeapTupleHeader base, bool* isnull)
 {
-    Oid tupType = HeapTupleHeaderGetTypeId(rec);
-    int32 tupTypmod = HeapTupleHeaderGetTypMod(rec);
-    const CachedSchema& schema = get_cached_schema(tupType, tupTypmod);
+    check_stack_depth();
+    const uint8_t marker = data[*pos];
+    if (marker == 0xc0) {
+        *isnull = true;
+        *pos += 1;
+        return (Datum) 0;
+    }
+    *isnull = false;
 
-    if (!schema.zera_fast_supported) {
-        return nullptr;
+    const MsgpackDecodeTarget target = element
+        ? MsgpackDecodeTarget{col.array_element_typid, col.typmod, col.array_element_kind,
+                              col.array_element_typinput, col.array_element_typioparam}
+        : MsgpackDecodeTarget{col.typid, col.typmod, col.kind, col.typinput, col.typioparam};
+
+    if (target.kind == ConverterKind::Composite && msgpack_marker_is_map(marker)) {
+        const CachedSchema& nested = get_cached_schema(target.typid, -1);
+        return msgpack_decode_record(data, pos, nested, base);
+    }
+    if (!element && target.kind == ConverterKind::Array && msgpack_marker_is_array(marker)) {
+        return msgpack_decode_array(data, pos, col);
+    }
+    if (!element && target.kind == ConverterKind::Array && msgpack_marker_is_ext(marker)) {
+        return msgpack_decode_typed_array(data, pos, col);
     }
 
-    try {
-        z::zera::RootSerializer rs;
-        z::zera::Serializer writer(rs);
-        if (!schema.use_deform_access) {
-            zera_write_record_map(writer, rec, schema, nullptr);
+    const size_t start = *pos;
+    *pos = msgpack_skip_value(data, start);
+    return msgpack_decode_scalar(data, start, *pos, target);
+}
+
+/*
+ * Decode one map at *pos into a row of the schema. Attributes the map does
+ * not mention keep their value from base, or are NULL without one; keys
+ * that match no attribute are skipped.
+ *
+ * With positions, *pos is instead a positional row of a compact batch, and
+ * positions[i] is the schema column of its i-th value, or -1 to skip it.
+ */
+static Datum msgpack_decode_record(
+    std::span<const uint8_t> data, size_t* pos, const CachedSchema& schema,
+    HeapTupleHeader base, const int* positions, uint64_t npositions)
+{
+    const int natts = schema.tupdesc->natts;
+    auto* values = static_cast<Datum*>(palloc(sizeof(Datum) * Max(natts, 1)));
+    auto* nulls = static_cast<bool*>(palloc(sizeof(bool) * Max(natts, 1)));
+    if (base != nullptr) {
+        HeapTupleData tuple;
+        tuple.t_len = HeapTupleHeaderGetDatumLength(base);
+        ItemPointerSetInvalid(&tuple.t_self);
+        tuple.t_tableOid = InvalidOid;
+        tuple.t_data = base;
+        heap_deform_tuple(&tuple, schema.tupdesc, values, nulls);
+    } else {
+        memset(nulls, true, sizeof(bool) * natts);
+    }
+
+    size_t cursor = *pos;
+    uint64_t count;
+    bool is_map;
+    msgpack_read_container(data, &cursor, &count, &is_map);
+    if (positions != nullptr && count != npositions) {
+        throw z::DeserializationError("compact row length does not match its column list");
+    }
+    for (uint64_t i = 0; i < count; i++) {
+        size_t column;
+        if (positions != nullptr) {
+            if (positions[i] < 0) {
+                cursor = msgpack_skip_value(data, cursor);
+                continue;
+            }
+            column = static_cast<size_t>(positions[i]);
         } else {
-            TupleDeformScratch scratch;
-            zera_write_record_map(writer, rec, schema, &scratch);
+            std::string_view key;
+            cursor = msgpack_replay_string(data, cursor + 1, data[cursor], &key);
+            auto it = schema.column_index_by_name.find(key);
+            if (it == schema.column_index_by_name.end()) {
+                cursor = msgpack_skip_value(data, cursor);
+                continue;
+            }
+            column = it->second;
         }
+        const CachedColumn& col = schema.columns[column];
+        const int idx = col.attnum - 1;
+        HeapTupleHeader nested_base =
+            col.kind == ConverterKind::Composite && !nulls[idx]
+                ? DatumGetHeapTupleHeader(values[idx])
+                : nullptr;
+        values[idx] = msgpack_decode_datum(data, &cursor, col, false, nested_base, &nulls[idx]);
+    }
+    *pos = cursor;
 
-        z::ZBuffer buffer = rs.finish();
-        std::span<const uint8_t> data = buffer.buf();
-        size_t len = data.size();
-        bytea* result = (bytea*) palloc(len + VARHDRSZ);
-        SET_VARSIZE(result, len + VARHDRSZ);
-        memcpy(VARDATA(result), data.data(), len);
-        return result;
+    HeapTuple tuple = heap_form_tuple(schema.tupdesc, values, nulls);
+    pfree(values);
+    pfree(nulls);
+    return HeapTupleGetDatum(tuple);
+}
+
+/*
+ * Resolve the row type from the anyelement argument the way
+ * jsonb_populate_record does; an anonymous record needs a non-null value.
+ */
+static HeapTupleHeader msgpack_record_argument(
+    FunctionCallInfo fcinfo, const char* fname, Oid* tupType, int32* tupTypmod)
+{
+    Oid argtype = get_fn_expr_argtype(fcinfo->flinfo, 0);
+    HeapTupleHeader base = PG_ARGISNULL(0) ? nullptr : PG_GETARG_HEAPTUPLEHEADER(0);
+
+    if (argtype == RECORDOID) {
+        if (base == nullptr) {
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("could not determine row type for result of %s", fname),
+                     errhint("Pass a NULL of the target composite type, "
+                             "such as NULL::my_type, as the first argument.")));
+        }
+        *tupType = HeapTupleHeaderGetTypeId(base);
+        *tupTypmod = HeapTupleHeaderGetTypMod(base);
+        return base;
+    }
+    if (!OidIsValid(argtype) || get_typtype(argtype) != TYPTYPE_COMPOSITE) {
+        ereport(ERROR,
+                (errcode(ERRCODE_DATATYPE_MISMATCH),
+                 errmsg("first argument of %s must be a row type", fname)));
+    }
+    *tupType = argtype;
+    *tupTypmod = -1;
+    return base;
+}
+
+static Datum msgpack_decode_record_datum(
+    std::span<const uint8_t> data, size_t* pos, Oid tupType, int32 tupTypmod,
+    HeapTupleHeader base, const int* positions = nullptr, uint64_t npositions = 0)
+{
+    try {
+        const CachedSchema& schema = get_cached_schema(tupType, tupTypmod);
+        return msgpack_decode_record(data, pos, schema, base, positions, npositions);
     } catch (const std::exception& ex) {
         ereport(ERROR,
-                (errcode(ERRCODE_INTERNAL_ERROR),
-                 errmsg("fast ZERA row serialization failed"),
+                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                 errmsg("invalid MessagePack input"),
                  errdetail("%s", ex.what())));
     } catch (...) {
         ereport(ERROR,
-                (errcode(ERRCODE_INTERNAL_ERROR),
-                 errmsg("fast ZERA row serialization failed with unknown exception")));
+                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                 errmsg("invalid MessagePack input"),
+                 errdetail("unknown decoding error")));
     }
-
-    return nullptr;
+    return (Datum) 0;
 }
 
-static bytea* try_serialize_zera_array_fast(Datum* elements, bool* nulls, int nitems)
+/*
+ * msgpack_populate_record - Decode one MessagePack map into a row of the
+ * first argument's type. A NULL or nil document returns the base row.
+ */
+extern "C" Datum
+msgpack_populate_record(PG_FUNCTION_ARGS)
 {
-    std::vector<const CachedSchema*> schemas;
-    schemas.reserve(nitems);
-
-    for (int i = 0; i < nitems; i++) {
-        if (nulls[i]) {
-            schemas.push_back(nullptr);
-            continue;
-        }
-
-        HeapTupleHeader rec = DatumGetHeapTupleHeader(elements[i]);
-        Oid tupType = HeapTupleHeaderGetTypeId(rec);
-        int32 tupTypmod = HeapTupleHeaderGetTypMod(rec);
-        const CachedSchema& schema = get_cached_schema(tupType, tupTypmod);
+    Oid tupType;
+    int32 tupTypmod;
+    HeapTupleHeader base = msgpack_record_argument(
+        fcinfo, "msgpack_populate_record", &tupType, &tupTypmod);
 
-        if (!schema.zera_fast_supported) {
-            return nullptr;
+    if (PG_ARGISNULL(1)) {
+        if (base == nullptr) {
+            PG_RETURN_NULL();
         }
-        schemas.push_back(&schema);
+        PG_RETURN_HEAPTUPLEHEADER(base);
     }
 
-    try {
-        z::zera::RootSerializer rs;
-        z::zera::Serializer writer(rs);
-        TupleDeformScratch scratch;
+    bytea* input = PG_GETARG_BYTEA_PP(1);
+    std::span<const uint8_t> data(
+        reinterpret_cast<const uint8_t*>(VARDATA_ANY(input)),
+        static_cast<size_t>(VARSIZE_ANY_EXHDR(input)));
+    msgpack_validate_document(data);
 
-        writer.begin_array(static_cast<size_t>(nitems));
-        for (int i = 0; i < nitems; i++) {
-            if (nulls[i]) {
-                writer.null();
-            } else {
-                HeapTupleHeader rec = DatumGetHeapTupleHeader(elements[i]);
-                zera_write_record_map(writer, rec, *schemas[i], &scratch);
-            }
+    if (data[0] == 0xc0) {
+        if (base == nullptr) {
+            PG_RETURN_NULL();
         }
-        writer.end_array();
-
-        z::ZBuffer buffer = rs.finish();
-        std::span<const uint8_t> data = buffer.buf();
-        size_t len = data.size();
-        bytea* result = (bytea*) palloc(len + VARHDRSZ);
-        SET_VARSIZE(result, len + VARHDRSZ);
-        memcpy(VARDATA(result), data.data(), len);
-        return result;
-    } catch (const std::exception& ex) {
-        ereport(ERROR,
-                (errcode(ERRCODE_INTERNAL_ERROR),
-                 errmsg("fast ZERA batch serialization failed"),
-                 errdetail("%s", ex.what())));
-    } catch (...) {
+        PG_RETURN_HEAPTUPLEHEADER(base);
+    }
+    if (!msgpack_marker_is_map(data[0])) {
         ereport(ERROR,
-                (errcode(ERRCODE_INTERNAL_ERROR),
-                 errmsg("fast ZERA batch serialization failed with unknown exception")));
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("cannot call msgpack_populate_record on a MessagePack value that is not a map")));
     }
 
-    return nullptr;
+    size_t pos = 0;
+    Datum result = msgpack_decode_record_datum(data, &pos, tupType, tupTypmod, base);
+    PG_FREE_IF_COPY(input, 1);
+    PG_RETURN_DATUM(result);
 }
 
-static inline void flex_write_text(z::flex::Serializer& writer, Datum value)
-{
-    text* txt = DatumGetTextPP(value);
-    const char* ptr = VARDATA_ANY(txt);
-    int len = VARSIZE_ANY_EXHDR(txt);
-    writer.string(std::string_view(ptr, static_cast<size_t>(len)));
-}
+struct MsgpackRecordsetState {
+    const uint8_t* data;
+    size_t length;
+    size_t pos;
+    uint64_t remaining;
+    Oid tupType;
+    int32 tupTypmod;
+    HeapTupleHeader base;
+    int* positions;
+    uint64_t npositions;
+};
 
-static inline void flex_write_array_element(
-    z::flex::Serializer& writer,
-    ConverterKind elem_kind,
-    Datum value,
-    bool isnull)
-{
-    if (isnull) {
-        writer.null();
-        return;
-    }
+/*
+ * Open a rows_to_msgpack_compact batch: resolve its column list against the
+ * row type and leave state->pos at the first row. The map has already been
+ * validated, so only its shape is checked here.
+ */
+static void msgpack_open_compact_batch(
+    std::span<const uint8_t> data, uint64_t nentries, MsgpackRecordsetState* state)
+{
+    const CachedSchema& schema = get_cached_schema(state->tupType, state->tupTypmod);
+    bool have_columns = false;
+    bool have_rows = false;
+    size_t rows_pos = 0;
+    uint64_t rows_count = 0;
+    size_t cursor = state->pos;
+
+    for (uint64_t entry = 0; entry < nentries; entry++) {
+        std::string_view key;
+        bool valid = msgpack_marker_is_string(data[cursor]);
+        if (valid) {
+            cursor = msgpack_replay_string(data, cursor + 1, data[cursor], &key);
+        }
+        uint64_t count = 0;
+        bool is_map = true;
+        const size_t value_start = cursor;
+        valid = valid && (key == "columns" || key == "rows") &&
+                msgpack_read_container(data, &cursor, &count, &is_map) && !is_map;
+        if (!valid) {
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("cannot call msgpack_to_recordset on a MessagePack map that is not a compact batch"),
+                     errhint("A compact batch has a \"columns\" array and a \"rows\" array.")));
+        }
 
-    switch (elem_kind) {
-        case ConverterKind::Int2:
-            writer.int64(static_cast<int64_t>(DatumGetInt16(value)));
-            return;
-        case ConverterKind::Int4:
-            writer.int64(static_cast<int64_t>(DatumGetInt32(value)));
-            return;
-        case ConverterKind::Int8:
-            writer.int64(static_cast<int64_t>(DatumGetInt64(value)));
-            return;
-        case ConverterKind::Float4:
-            writer.double_(static_cast<double>(DatumGetFloat4(value)));
-            return;
-        case ConverterKind::Float8:
-            writer.double_(DatumGetFloat8(value));
-            return;
-        case ConverterKind::Bool:
-            writer.boolean(DatumGetBool(value));
-            return;
-        case ConverterKind::Text:
-        case ConverterKind::JsonText:
-            flex_write_text(writer, value);
-            return;
-        case ConverterKind::Uuid:
-        {
-            char out[36];
-            format_uuid(value, out);
-            writer.string(std::string_view(out, sizeof(out)));
-            return;
+        if (key == "rows") {
+            have_rows = true;
+            rows_pos = cursor;
+            rows_count = count;
+            cursor = msgpack_skip_value(data, value_start);
+            continue;
         }
-        case ConverterKind::NameText:
-            writer.string(name_text_view(value));
-            return;
-        case ConverterKind::CharText:
-        {
-            char ch = DatumGetChar(value);
-            writer.string(std::string_view(&ch, ch == '\0' ? 0 : 1));
-            return;
+
+        have_columns = true;
+        state->npositions = count;
+        state->positions = static_cast<int*>(palloc(sizeof(int) * Max(count, UINT64CONST(1))));
+        for (uint64_t i = 0; i < count; i++) {
+            if (!msgpack_marker_is_string(data[cursor])) {
+                ereport(ERROR,
+                        (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                         errmsg("compact batch column names must be strings")));
+            }
+            std::string_view name;
+            cursor = msgpack_replay_string(data, cursor + 1, data[cursor], &name);
+            auto it = schema.column_index_by_name.find(name);
+            state->positions[i] =
+                it == schema.column_index_by_name.end() ? -1 : static_cast<int>(it->second);
         }
-        case ConverterKind::EnumText:
-            writer.string(enum_label_view(value));
-            return;
-        case ConverterKind::InetText:
-            write_network_string(writer, value, false);
-            return;
-        case ConverterKind::CidrText:
-            write_network_string(writer, value, true);
-            return;
-        case ConverterKind::IntervalText:
-            write_interval_string(writer, value);
-            return;
-        case ConverterKind::Numeric:
-            numeric_write_fast(writer, value);
-            return;
-        case ConverterKind::Date:
-            writer.int64(static_cast<int64_t>(DatumGetDateADT(value)));
-            return;
-        case ConverterKind::Timestamp:
-            writer.int64(static_cast<int64_t>(DatumGetTimestamp(value)));
-            return;
-        case ConverterKind::Timestamptz:
-            writer.int64(static_cast<int64_t>(DatumGetTimestampTz(value)));
-            return;
-        case ConverterKind::Jsonb:
-            writer.binary(datum_jsonb_span(value));
-            return;
-        case ConverterKind::Bytea:
-            writer.binary(datum_bytea_span(value));
-            return;
-        default:
-            break;
     }
 
-    ereport(ERROR,
-            (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-             errmsg("unsupported array element type for fast Flex path")));
+    if (!have_columns || !have_rows) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("cannot call msgpack_to_recordset on a MessagePack map that is not a compact batch"),
+                 errhint("A compact batch has a \"columns\" array and a \"rows\" array.")));
+    }
+    state->pos = rows_pos;
+    state->remaining = rows_count;
 }
 
-static inline void flex_write_array(
-    z::flex::Serializer& writer,
-    const CachedColumn& col,
-    Datum value)
-{
-    ArrayType* arr = DatumGetArrayTypeP(value);
-    int ndim = ARR_NDIM(arr);
-
-    if (ndim == 0) {
-        writer.begin_array(0);
-        writer.end_array();
-        return;
+/*
+ * msgpack_to_recordset - Return one row per map of a MessagePack array, such
+ * as a rows_to_msgpack batch, or one row per positional row of a
+ * rows_to_msgpack_compact batch. Rows are decoded one per call; nil elements
+ * produce NULL rows.
+ */
+extern "C" Datum
+msgpack_to_recordset(PG_FUNCTION_ARGS)
+{
+    FuncCallContext* funcctx;
+
+    if (SRF_IS_FIRSTCALL()) {
+        funcctx = SRF_FIRSTCALL_INIT();
+        Oid tupType;
+        int32 tupTypmod;
+        HeapTupleHeader base = msgpack_record_argument(
+            fcinfo, "msgpack_to_recordset", &tupType, &tupTypmod);
+        if (PG_ARGISNULL(1)) {
+            SRF_RETURN_DONE(funcctx);
+        }
+
+        MemoryContext old_context = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+        bytea* input = PG_GETARG_BYTEA_P_COPY(1);
+        auto* state = static_cast<MsgpackRecordsetState*>(palloc0(sizeof(MsgpackRecordsetState)));
+        state->data = reinterpret_cast<const uint8_t*>(VARDATA(input));
+        state->length = static_cast<size_t>(VARSIZE(input) - VARHDRSZ);
+        state->tupType = tupType;
+        state->tupTypmod = tupTypmod;
+        if (base != nullptr) {
+            const uint32 base_len = HeapTupleHeaderGetDatumLength(base);
+            state->base = static_cast<HeapTupleHeader>(palloc(base_len));
+            memcpy(state->base, base, base_len);
+        }
+        MemoryContextSwitchTo(old_context);
+
+        std::span<const uint8_t> data(state->data, state->length);
+        msgpack_validate_document(data);
+        bool is_map;
+        uint64_t count;
+        if (!msgpack_read_container(data, &state->pos, &count, &is_map)) {
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("cannot call msgpack_to_recordset on a MessagePack value that is not an array")));
+        }
+        if (is_map) {
+            old_context = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+            msgpack_open_compact_batch(data, count, state);
+            MemoryContextSwitchTo(old_context);
+        } else {
+            state->remaining = count;
+        }
+        funcctx->user_fctx = state;
     }
 
-    if (ndim != 1) {
-        z::dyn::serialize(array_to_dynamic(value, col.typid), writer);
-        return;
+    funcctx = SRF_PERCALL_SETUP();
+    auto* state = static_cast<MsgpackRecordsetState*>(funcctx->user_fctx);
+    if (state->remaining == 0) {
+        SRF_RETURN_DONE(funcctx);
     }
+    state->remaining--;
 
-    Datum* elements;
-    bool* nulls;
-    int nitems;
-    deconstruct_array(arr,
-                      col.array_element_typid,
-                      col.array_typlen,
-                      col.array_typbyval,
-                      col.array_typalign,
-                      &elements,
-                      &nulls,
-                      &nitems);
-
-    writer.begin_array(static_cast<size_t>(nitems));
-    for (int i = 0; i < nitems; i++) {
-        if (nulls[i]) {
-            writer.null();
-        } else if (col.array_element_kind == ConverterKind::Fallback) {
-            write_output_string(writer, col.array_element_typoutput, elements[i]);
-        } else {
-            flex_write_array_element(writer, col.array_element_kind, elements[i], false);
+    std::span<const uint8_t> data(state->data, state->length);
+    const uint8_t marker = data[state->pos];
+    if (marker == 0xc0) {
+        state->pos++;
+        SRF_RETURN_NEXT_NULL(funcctx);
+    }
+    if (state->positions != nullptr) {
+        if (!msgpack_marker_is_array(marker)) {
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("msgpack_to_recordset compact row is not an array")));
         }
+    } else if (!msgpack_marker_is_map(marker)) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("msgpack_to_recordset array element is not a map")));
     }
-    writer.end_array();
+    Datum result = msgpack_decode_record_datum(
+        data, &state->pos, state->tupType, state->tupTypmod, state->base,
+        state->positions, state->npositions);
+    SRF_RETURN_NEXT(funcctx, result);
+}
 
-    pfree(elements);
-    pfree(nulls);
+/*
+ * Per-call-site plan for the SQL builders, cached in fn_extra. The parser
+ * fixes each argument's type, so converter kinds, writers, and literal keys
+ * are resolved on the first call and values are written directly afterwards.
+ */
+struct BuilderPlan {
+    int nargs;
+    bool is_object;
+    // One column plan per argument; literal keys keep their encoded forms.
+    std::vector<CachedColumn> args;
+    std::vector<bool> const_keys;
+    size_t msgpack_bytes;
+    MemoryContextCallback cleanup;
+};
+
+static void builder_plan_cleanup(void* arg)
+{
+    static_cast<BuilderPlan*>(arg)->~BuilderPlan();
 }
 
-static inline void flex_write_scalar(
-    z::flex::Serializer& writer,
-    const CachedColumn& col,
-    Datum value,
-    bool isnull)
+static std::string_view builder_key_text(const CachedColumn& col, Datum value, std::string& buf)
 {
-    if (isnull) {
-        writer.null();
-        return;
+    if (col.kind == ConverterKind::Text) {
+        text* txt = DatumGetTextPP(value);
+        return std::string_view(VARDATA_ANY(txt), static_cast<size_t>(VARSIZE_ANY_EXHDR(txt)));
     }
+    char* str = OidOutputFunctionCall(col.typoutput, value);
+    buf.assign(str);
+    pfree(str);
+    return buf;
+}
 
-    switch (col.kind) {
-        case ConverterKind::Int2:
-            writer.int64(static_cast<int64_t>(DatumGetInt16(value)));
-            return;
-        case ConverterKind::Int4:
-            writer.int64(static_cast<int64_t>(DatumGetInt32(value)));
-            return;
-        case ConverterKind::Int8:
-            writer.int64(static_cast<int64_t>(DatumGetInt64(value)));
-            return;
-        case ConverterKind::Float4:
-            writer.double_(static_cast<double>(DatumGetFloat4(value)));
-            return;
-        case ConverterKind::Float8:
-            writer.double_(DatumGetFloat8(value));
-            return;
-        case ConverterKind::Bool:
-            writer.boolean(DatumGetBool(value));
-            return;
-        case ConverterKind::Text:
-        case ConverterKind::JsonText:
-            flex_write_text(writer, value);
-            return;
-        case ConverterKind::Uuid:
-        {
-            char out[36];
-            format_uuid(value, out);
-            writer.string(std::string_view(out, sizeof(out)));
-            return;
+/*
+ * Only literal keys are cached. get_fn_expr_arg_stable also accepts external
+ * params, and PL/pgSQL reuses fn_extra while its variables change.
+ */
+static bool builder_arg_is_const(FmgrInfo* flinfo, int argnum)
+{
+    if (flinfo->fn_expr == nullptr || !IsA(flinfo->fn_expr, FuncExpr)) {
+        return false;
+    }
+    List* args = castNode(FuncExpr, flinfo->fn_expr)->args;
+    return argnum < list_length(args) && IsA(list_nth(args, argnum), Const);
+}
+
+static BuilderPlan* builder_plan_create(FunctionCallInfo fcinfo, bool is_object)
+{
+    const int nargs = PG_NARGS();
+    void* mem = MemoryContextAlloc(fcinfo->flinfo->fn_mcxt, sizeof(BuilderPlan));
+    BuilderPlan* plan = new (mem) BuilderPlan();
+    plan->cleanup.func = builder_plan_cleanup;
+    plan->cleanup.arg = plan;
+    MemoryContextRegisterResetCallback(fcinfo->flinfo->fn_mcxt, &plan->cleanup);
+
+    plan->nargs = nargs;
+    plan->is_object = is_object;
+    plan->msgpack_bytes = 0;
+    plan->args.resize(static_cast<size_t>(nargs));
+    plan->const_keys.assign(is_object ? static_cast<size_t>(nargs / 2) : 0, false);
+
+    for (int i = 0; i < nargs; i++) {
+        Oid typid = get_fn_expr_argtype(fcinfo->flinfo, i);
+        if (!OidIsValid(typid)) {
+            typid = TEXTOID;
+        }
+        // Domains keep their own type, so they fall back to text output just
+        // as the dynamic conversion did.
+        CachedColumn& col = plan->args[i];
+        col.attnum = i + 1;
+        col.typmod = -1;
+        init_cached_column_type(col, typid, typid == RECORDOID ? ConverterKind::Composite
+                                                               : classify_type(typid));
+        if (col.kind == ConverterKind::Array && col.array_element_typid == RECORDOID) {
+            col.array_element_kind = ConverterKind::Composite;
+            select_array_elem_writers(col);
+        }
+
+        if (!is_object || (i % 2) != 0) {
+            continue;
         }
-        case ConverterKind::NameText:
-            writer.string(name_text_view(value));
-            return;
-        case ConverterKind::CharText:
-        {
-            char ch = DatumGetChar(value);
-            writer.string(std::string_view(&ch, ch == '\0' ? 0 : 1));
-            return;
+        if (!OidIsValid(col.typoutput)) {
+            bool typIsVarlena;
+            getTypeOutputInfo(col.typid, &col.typoutput, &typIsVarlena);
         }
-        case ConverterKind::EnumText:
-            writer.string(enum_label_view(value));
-            return;
-        case ConverterKind::InetText:
-            write_network_string(writer, value, false);
-            return;
-        case ConverterKind::CidrText:
-            write_network_string(writer, value, true);
-            return;
-        case ConverterKind::IntervalText:
-            write_interval_string(writer, value);
-            return;
-        case ConverterKind::Numeric:
-            numeric_write_fast(writer, value);
-            return;
-        case ConverterKind::Date:
-            writer.int64(static_cast<int64_t>(DatumGetDateADT(value)));
-            return;
-        case ConverterKind::Timestamp:
-            writer.int64(static_cast<int64_t>(DatumGetTimestamp(value)));
-            return;
-        case ConverterKind::Timestamptz:
-            writer.int64(static_cast<int64_t>(DatumGetTimestampTz(value)));
-            return;
-        case ConverterKind::Jsonb:
-            writer.binary(datum_jsonb_span(value));
-            return;
-        case ConverterKind::Bytea:
-            writer.binary(datum_bytea_span(value));
-            return;
-        case ConverterKind::Array:
-            flex_write_array(writer, col, value);
-            return;
-        case ConverterKind::Fallback:
-        {
-            char* str = OidOutputFunctionCall(col.typoutput, value);
-            writer.string(std::string_view(str));
-            pfree(str);
-            return;
+        if (builder_arg_is_const(fcinfo->flinfo, i) && !PG_ARGISNULL(i)) {
+            std::string buf;
+            col.name = std::string(builder_key_text(col, PG_GETARG_DATUM(i), buf));
+            col.msgpack_key_encoded = encode_msgpack_string_key(col.name);
+            col.msgpack_key_ptr = col.msgpack_key_encoded.data();
+            col.msgpack_key_len = col.msgpack_key_encoded.size();
+            if (col.name.size() <= 0xFFFFu) {
+                col.zera_key_encoded = encode_zera_key(col.name);
+            }
+            col.cbor_key_encoded = encode_cbor_key(col.name);
+            plan->const_keys[i / 2] = true;
         }
-        default:
-            break;
     }
 
-    ereport(ERROR,
-            (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-             errmsg("unsupported type for fast Flex path"),
-             errdetail("column type OID %u", col.typid)));
+    fcinfo->flinfo->fn_extra = plan;
+    return plan;
 }
 
-static inline void flex_write_record_map(
-    z::flex::Serializer& writer,
-    HeapTupleHeader rec,
-    const CachedSchema& schema,
-    TupleDeformScratch* scratch)
+/*
+ * Validate the builder arguments and return the call site's cached plan.
+ */
+static BuilderPlan& builder_prepare(FunctionCallInfo fcinfo, bool is_object, const char* fname)
 {
-    HeapTupleData tuple;
-    tuple.t_len = HeapTupleHeaderGetDatumLength(rec);
-    tuple.t_data = rec;
-
-    writer.begin_map(schema.columns.size());
-    if (!schema.use_deform_access) {
-        for (const CachedColumn& col : schema.columns) {
-            bool isnull;
-            Datum value = heap_getattr(&tuple, col.attnum, schema.tupdesc, &isnull);
-            writer.key(col.name);
-            flex_write_scalar(writer, col, value, isnull);
+    const int nargs = PG_NARGS();
+    if (is_object) {
+        if ((nargs % 2) != 0) {
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("%s requires an even number of arguments", fname)));
+        }
+        for (int i = 0; i < nargs; i += 2) {
+            if (PG_ARGISNULL(i)) {
+                ereport(ERROR,
+                        (errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+                         errmsg("%s key must not be null", fname)));
+            }
         }
+    }
+
+    auto* plan = static_cast<BuilderPlan*>(fcinfo->flinfo->fn_extra);
+    if (plan == nullptr || plan->nargs != nargs || plan->is_object != is_object) {
+        plan = builder_plan_create(fcinfo, is_object);
+    }
+    return *plan;
+}
+
+static inline void builder_write_const_key(z::MsgPackSerializer& writer, const CachedColumn& col)
+{
+    writer.key_preencoded(col.msgpack_key_ptr, col.msgpack_key_len);
+}
+
+static inline void builder_write_const_key(z::cborjc::Serializer& writer, const CachedColumn& col)
+{
+    cbor_write_key(writer, col);
+}
+
+static inline void builder_write_const_key(z::zera::Serializer& writer, const CachedColumn& col)
+{
+    if (col.zera_key_encoded.empty()) {
+        writer.key(col.name);
     } else {
-        const size_t nattrs = static_cast<size_t>(schema.tupdesc->natts);
-        scratch->ensure(nattrs);
-        heap_deform_tuple(&tuple, schema.tupdesc, scratch->values, scratch->nulls);
-        for (const CachedColumn& col : schema.columns) {
-            const int idx = col.attnum - 1;
-            writer.key(col.name);
-            flex_write_scalar(writer, col, scratch->values[idx], scratch->nulls[idx]);
+        writer.key_preencoded(col.zera_key_encoded);
+    }
+}
+
+static inline void builder_write_value(
+    z::MsgPackSerializer& writer, const CachedColumn& col, Datum value, bool isnull)
+{
+    col.msgpack_scalar_writer(writer, col, value, isnull);
+}
+
+static inline void builder_write_value(
+    z::cborjc::Serializer& writer, const CachedColumn& col, Datum value, bool isnull)
+{
+    cbor_write_scalar(writer, col, value, isnull);
+}
+
+static inline void builder_write_value(
+    z::zera::Serializer& writer, const CachedColumn& col, Datum value, bool isnull)
+{
+    zera_write_scalar(writer, col, value, isnull);
+}
+
+template<typename Writer>
+static void builder_write(Writer& writer, FunctionCallInfo fcinfo, const BuilderPlan& plan)
+{
+    if (!plan.is_object) {
+        writer.begin_array(static_cast<size_t>(plan.nargs));
+        for (int i = 0; i < plan.nargs; i++) {
+            builder_write_value(writer, plan.args[i], PG_GETARG_DATUM(i), PG_ARGISNULL(i));
+        }
+        writer.end_array();
+        return;
+    }
+
+    std::string key_buf;
+    writer.begin_map(static_cast<size_t>(plan.nargs / 2));
+    for (int i = 0; i < plan.nargs; i += 2) {
+        const CachedColumn& key = plan.args[i];
+        if (plan.const_keys[i / 2]) {
+            builder_write_const_key(writer, key);
+        } else {
+            writer.key(builder_key_text(key, PG_GETARG_DATUM(i), key_buf));
         }
+        builder_write_value(writer, plan.args[i + 1], PG_GETARG_DATUM(i + 1), PG_ARGISNULL(i + 1));
     }
     writer.end_map();
 }
 
-static bytea* try_serialize_flex_row_fast(HeapTupleHeader rec)
+static bytea* builder_to_msgpack(FunctionCallInfo fcinfo, BuilderPlan& plan)
 {
-    Oid tupType = HeapTupleHeaderGetTypeId(rec);
-    int32 tupTypmod = HeapTupleHeaderGetTypMod(rec);
-    const CachedSchema& schema = get_cached_schema(tupType, tupTypmod);
+    // Like single rows, builder results are written in place into their
+    // bytea, reserving the call site's recent result size plus 25%.
+    z::MsgPackRootSerializer rs;
+    msgpack_palloc_root_init(rs, plan.msgpack_bytes + plan.msgpack_bytes / 4);
 
-    if (!schema.flex_fast_supported) {
-        return nullptr;
+    try {
+        z::MsgPackSerializer writer(rs);
+        builder_write(writer, fcinfo, plan);
+
+        const size_t len = rs.sbuf.size - VARHDRSZ;
+        plan.msgpack_bytes = plan.msgpack_bytes == 0
+            ? len
+            : plan.msgpack_bytes - plan.msgpack_bytes / 8 + len / 8;
+        return msgpack_result_from_palloc_root(rs);
+    } catch (const std::exception& ex) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("msgpack serialization failed"),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("msgpack serialization failed with unknown exception")));
     }
 
+    return nullptr;
+}
+
+static bytea* builder_to_cbor(FunctionCallInfo fcinfo, const BuilderPlan& plan)
+{
     try {
-        z::flex::RootSerializer rs;
-        z::flex::Serializer writer(rs);
-        if (!schema.use_deform_access) {
-            flex_write_record_map(writer, rec, schema, nullptr);
-        } else {
-            TupleDeformScratch scratch;
-            flex_write_record_map(writer, rec, schema, &scratch);
-        }
+        z::cborjc::RootSerializer rs(std::move(cbor_reusable_storage()));
+        z::cborjc::Serializer writer(rs);
+        builder_write(writer, fcinfo, plan);
+        return cbor_result_from_root(rs);
+    } catch (const std::exception& ex) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("CBOR serialization failed"),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("CBOR serialization failed with unknown exception")));
+    }
 
-        z::ZBuffer buffer = rs.finish();
-        std::span<const uint8_t> data = buffer.buf();
-        size_t len = data.size();
-        bytea* result = (bytea*) palloc(len + VARHDRSZ);
-        SET_VARSIZE(result, len + VARHDRSZ);
-        memcpy(VARDATA(result), data.data(), len);
-        return result;
+    return nullptr;
+}
+
+static bytea* builder_to_zera(FunctionCallInfo fcinfo, const BuilderPlan& plan)
+{
+    try {
+        z::zera::RootSerializer& rs = zera_reusable_root();
+        z::zera::Serializer writer(rs);
+        builder_write(writer, fcinfo, plan);
+        return zera_result_from_root(rs);
     } catch (const std::exception& ex) {
         ereport(ERROR,
                 (errcode(ERRCODE_INTERNAL_ERROR),
-                 errmsg("fast Flex row serialization failed"),
+                 errmsg("ZERA serialization failed"),
                  errdetail("%s", ex.what())));
     } catch (...) {
         ereport(ERROR,
                 (errcode(ERRCODE_INTERNAL_ERROR),
-                 errmsg("fast Flex row serialization failed with unknown exception")));
+                 errmsg("ZERA serialization failed with unknown exception")));
     }
 
     return nullptr;
 }
 
-static bytea* try_serialize_flex_array_fast(Datum* elements, bool* nulls, int nitems)
+/*
+ * msgpack_build_object - Build a MessagePack object from variadic key/value args.
+ * Mirrors json_build_object semantics at SQL layer.
+ */
+extern "C" Datum
+msgpack_build_object(PG_FUNCTION_ARGS)
 {
-    std::vector<const CachedSchema*> schemas;
-    schemas.reserve(nitems);
+    BuilderPlan& plan = builder_prepare(fcinfo, true, "msgpack_build_object");
+    PG_RETURN_BYTEA_P(builder_to_msgpack(fcinfo, plan));
+}
 
-    for (int i = 0; i < nitems; i++) {
-        if (nulls[i]) {
-            schemas.push_back(nullptr);
-            continue;
-        }
+/*
+ * msgpack_build_array - Build a MessagePack array from variadic arguments.
+ * Mirrors json_build_array semantics at SQL layer.
+ */
+extern "C" Datum
+msgpack_build_array(PG_FUNCTION_ARGS)
+{
+    BuilderPlan& plan = builder_prepare(fcinfo, false, "msgpack_build_array");
+    PG_RETURN_BYTEA_P(builder_to_msgpack(fcinfo, plan));
+}
 
-        HeapTupleHeader rec = DatumGetHeapTupleHeader(elements[i]);
-        Oid tupType = HeapTupleHeaderGetTypeId(rec);
-        int32 tupTypmod = HeapTupleHeaderGetTypMod(rec);
-        const CachedSchema& schema = get_cached_schema(tupType, tupTypmod);
+/*
+ * cbor_build_object / cbor_build_array - CBOR forms of the builders.
+ */
+extern "C" Datum
+cbor_build_object(PG_FUNCTION_ARGS)
+{
+    BuilderPlan& plan = builder_prepare(fcinfo, true, "cbor_build_object");
+    PG_RETURN_BYTEA_P(builder_to_cbor(fcinfo, plan));
+}
 
-        if (!schema.flex_fast_supported) {
-            return nullptr;
-        }
-        schemas.push_back(&schema);
-    }
+extern "C" Datum
+cbor_build_array(PG_FUNCTION_ARGS)
+{
+    BuilderPlan& plan = builder_prepare(fcinfo, false, "cbor_build_array");
+    PG_RETURN_BYTEA_P(builder_to_cbor(fcinfo, plan));
+}
 
-    try {
-        z::flex::RootSerializer rs;
-        z::flex::Serializer writer(rs);
-        TupleDeformScratch scratch;
+/*
+ * zera_build_object / zera_build_array - ZERA forms of the builders.
+ */
+extern "C" Datum
+zera_build_object(PG_FUNCTION_ARGS)
+{
+    BuilderPlan& plan = builder_prepare(fcinfo, true, "zera_build_object");
+    PG_RETURN_BYTEA_P(builder_to_zera(fcinfo, plan));
+}
 
-        writer.begin_array(static_cast<size_t>(nitems));
-        for (int i = 0; i < nitems; i++) {
-            if (nulls[i]) {
-                writer.null();
-            } else {
-                HeapTupleHeader rec = DatumGetHeapTupleHeader(elements[i]);
-                flex_write_record_map(writer, rec, *schemas[i], &scratch);
+extern "C" Datum
+zera_build_array(PG_FUNCTION_ARGS)
+{
+    BuilderPlan& plan = builder_prepare(fcinfo, false, "zera_build_array");
+    PG_RETURN_BYTEA_P(builder_to_zera(fcinfo, plan));
+}
+
+/*
+ * Streaming aggregate state shared by msgpack_agg and msgpack_object_agg.
+ * Elements are appended to a backend-heap MessagePack buffer whose lifetime
+ * is tied to the aggregate memory context; the container header is written
+ * in front of the buffered elements at finalize time. msgpack_object_agg
+ * buffers values only and keeps, per key, the span of its latest value.
+ */
+struct MsgpackAggState {
+    z::MsgPackRootSerializer rs;
+    CachedColumn value_column;
+    MsgpackScalarWriterFn value_writer;
+    size_t count;
+    std::unordered_map<std::string, std::pair<size_t, size_t>> key_values;
+    MemoryContextCallback cleanup;
+};
+
+static void msgpack_write_jsonb_token(
+    z::MsgPackSerializer& writer, JsonbIterator** it, JsonbIteratorToken tok, JsonbValue* v)
+{
+    if (tok == WJB_BEGIN_OBJECT) {
+        writer.begin_map(static_cast<size_t>(v->val.object.nPairs));
+        JsonbIteratorToken t = JsonbIteratorNext(it, v, false);
+        while (t != WJB_END_OBJECT) {
+            if (t != WJB_KEY) {
+                ereport(ERROR,
+                        (errcode(ERRCODE_DATA_CORRUPTED),
+                         errmsg("invalid jsonb object token sequence")));
             }
+            writer.key(std::string_view(v->val.string.val, static_cast<size_t>(v->val.string.len)));
+            t = JsonbIteratorNext(it, v, false);
+            msgpack_write_jsonb_token(writer, it, t, v);
+            t = JsonbIteratorNext(it, v, false);
+        }
+        writer.end_map();
+        return;
+    }
+
+    if (tok == WJB_BEGIN_ARRAY) {
+        writer.begin_array(static_cast<size_t>(v->val.array.nElems));
+        JsonbIteratorToken t = JsonbIteratorNext(it, v, false);
+        while (t != WJB_END_ARRAY) {
+            msgpack_write_jsonb_token(writer, it, t, v);
+            t = JsonbIteratorNext(it, v, false);
         }
         writer.end_array();
+        return;
+    }
 
-        z::ZBuffer buffer = rs.finish();
-        std::span<const uint8_t> data = buffer.buf();
-        size_t len = data.size();
-        bytea* result = (bytea*) palloc(len + VARHDRSZ);
-        SET_VARSIZE(result, len + VARHDRSZ);
-        memcpy(VARDATA(result), data.data(), len);
-        return result;
-    } catch (const std::exception& ex) {
-        ereport(ERROR,
-                (errcode(ERRCODE_INTERNAL_ERROR),
-                 errmsg("fast Flex batch serialization failed"),
-                 errdetail("%s", ex.what())));
-    } catch (...) {
+    if (tok != WJB_VALUE && tok != WJB_ELEM) {
         ereport(ERROR,
-                (errcode(ERRCODE_INTERNAL_ERROR),
-                 errmsg("fast Flex batch serialization failed with unknown exception")));
+                (errcode(ERRCODE_DATA_CORRUPTED),
+                 errmsg("invalid jsonb token for conversion")));
+    }
+
+    switch (v->type) {
+        case jbvNull:
+            writer.null();
+            return;
+        case jbvBool:
+            writer.boolean(v->val.boolean);
+            return;
+        case jbvNumeric:
+            numeric_write_fast(writer, NumericGetDatum(v->val.numeric));
+            return;
+        case jbvString:
+            writer.string(std::string_view(v->val.string.val, static_cast<size_t>(v->val.string.len)));
+            return;
+        default:
+            ereport(ERROR,
+                    (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                     errmsg("unsupported jsonb scalar type for msgpack conversion")));
     }
-
-    return nullptr;
 }
 
 /*
- * Convert a PostgreSQL record (HeapTupleHeader) to a zerialize dynamic map
- * This is used by both single-record and batch processing functions
+ * Stream a jsonb document as structured MessagePack. The output is
+ * byte-identical to msgpack_from_jsonb without building a dynamic tree.
  */
-static z::dyn::Value record_to_dynamic_map(HeapTupleHeader rec)
+static void msgpack_write_jsonb(z::MsgPackSerializer& writer, Jsonb* jb)
 {
-    Oid tupType;
-    int32 tupTypmod;
-    const CachedSchema* schema;
-    HeapTupleData tuple;
+    JsonbIterator* it = JsonbIteratorInit(&jb->root);
+    JsonbValue v;
 
-    // Extract type info from the record
-    tupType = HeapTupleHeaderGetTypeId(rec);
-    tupTypmod = HeapTupleHeaderGetTypMod(rec);
-    schema = &get_cached_schema(tupType, tupTypmod);
-    tuple.t_len = HeapTupleHeaderGetDatumLength(rec);
-    tuple.t_data = rec;
+    if (JB_ROOT_IS_SCALAR(jb)) {
+        JsonbIteratorToken tok = JsonbIteratorNext(&it, &v, false); /* begin pseudo-array */
+        if (tok != WJB_BEGIN_ARRAY) {
+            ereport(ERROR,
+                    (errcode(ERRCODE_DATA_CORRUPTED),
+                     errmsg("invalid scalar jsonb root")));
+        }
+        tok = JsonbIteratorNext(&it, &v, false); /* scalar elem */
+        msgpack_write_jsonb_token(writer, &it, tok, &v);
+        (void) JsonbIteratorNext(&it, &v, false); /* end pseudo-array */
+        return;
+    }
 
-    // Build map of column name -> value
-    // Pre-allocate space to avoid reallocation overhead
-    z::dyn::Value::Map entries;
-    entries.reserve(schema->columns.size());
+    JsonbIteratorToken tok = JsonbIteratorNext(&it, &v, false);
+    msgpack_write_jsonb_token(writer, &it, tok, &v);
+}
 
-    if (!schema->use_deform_access) {
-        for (const CachedColumn& col : schema->columns) {
-            bool isnull;
-            Datum value = heap_getattr(&tuple, col.attnum, schema->tupdesc, &isnull);
-            entries.emplace_back(col.name, datum_to_dynamic_cached(value, isnull, col));
-        }
-    } else {
-        TupleDeformScratch scratch;
-        const size_t nattrs = static_cast<size_t>(schema->tupdesc->natts);
-        scratch.ensure(nattrs);
-        heap_deform_tuple(&tuple, schema->tupdesc, scratch.values, scratch.nulls);
-        for (const CachedColumn& col : schema->columns) {
-            const int idx = col.attnum - 1;
-            entries.emplace_back(col.name,
-                                 datum_to_dynamic_cached(scratch.values[idx], scratch.nulls[idx], col));
-        }
+static inline void msgpack_agg_elem_jsonb(
+    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    msgpack_write_jsonb(writer, DatumGetJsonbP(value));
+}
+
+static inline void msgpack_agg_elem_json(
+    z::MsgPackSerializer& writer, const CachedColumn&, Datum value, bool isnull)
+{
+    if (isnull) { writer.null(); return; }
+    char* str = text_to_cstring(DatumGetTextPP(value));
+    Datum jb = DirectFunctionCall1(jsonb_in, CStringGetDatum(str));
+    pfree(str);
+    msgpack_write_jsonb(writer, DatumGetJsonbP(jb));
+}
+
+static void msgpack_agg_state_cleanup(void* arg)
+{
+    static_cast<MsgpackAggState*>(arg)->~MsgpackAggState();
+}
+
+static MemoryContext msgpack_agg_memory_context(FunctionCallInfo fcinfo, const char* fname)
+{
+    MemoryContext aggcontext;
+    if (!AggCheckCallContext(fcinfo, &aggcontext)) {
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("%s called in non-aggregate context", fname)));
     }
+    return aggcontext;
+}
 
-    return z::dyn::Value::map(std::move(entries));
+/*
+ * Allocate an empty transition state whose buffer is released together with
+ * the aggregate memory context.
+ */
+static MsgpackAggState* msgpack_agg_state_alloc(MemoryContext aggcontext)
+{
+    void* mem = MemoryContextAlloc(aggcontext, sizeof(MsgpackAggState));
+    MsgpackAggState* state = new (mem) MsgpackAggState();
+    state->cleanup.func = msgpack_agg_state_cleanup;
+    state->cleanup.arg = state;
+    MemoryContextRegisterResetCallback(aggcontext, &state->cleanup);
+
+    CachedColumn& col = state->value_column;
+    col.attnum = 0;
+    col.msgpack_key_view = std::span<const uint8_t>();
+    col.msgpack_key_ptr = nullptr;
+    col.msgpack_key_len = 0;
+    col.msgpack_scalar_writer = nullptr;
+    state->value_writer = nullptr;
+    state->count = 0;
+    return state;
 }
 
 /*
- * Generic helper function to convert PostgreSQL tuple to any binary format
- * Template parameter determines the serialization protocol
+ * Allocate the transition state in the aggregate context and select the
+ * element writer once from the resolved input type.
  */
-template<typename Protocol>
-static bytea* tuple_to_binary(HeapTupleHeader rec)
+static MsgpackAggState* msgpack_agg_state_create(
+    FunctionCallInfo fcinfo, int value_argno, const char* fname)
 {
-    try {
-        if constexpr (std::is_same_v<Protocol, z::MsgPack>) {
-            if (bytea* fast = try_serialize_msgpack_row_fast(rec)) {
-                return fast;
-            }
-        } else if constexpr (std::is_same_v<Protocol, z::CBOR>) {
-            if (bytea* fast = try_serialize_cbor_row_fast(rec)) {
-                return fast;
-            }
-        } else if constexpr (std::is_same_v<Protocol, z::Zera>) {
-            if (bytea* fast = try_serialize_zera_row_fast(rec)) {
-                return fast;
-            }
-        } else if constexpr (std::is_same_v<Protocol, z::Flex>) {
-            if (bytea* fast = try_serialize_flex_row_fast(rec)) {
-                return fast;
-            }
-        }
+    MemoryContext aggcontext = msgpack_agg_memory_context(fcinfo, fname);
 
-        // Convert record to dynamic map
-        z::dyn::Value map = record_to_dynamic_map(rec);
+    Oid typid = get_fn_expr_argtype(fcinfo->flinfo, value_argno);
+    if (!OidIsValid(typid)) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("could not determine input data type")));
+    }
+    Oid basetype = getBaseType(typid);
+    ConverterKind kind = basetype == RECORDOID ? ConverterKind::Composite
+                                               : classify_type(basetype);
+
+    MsgpackAggState* state = msgpack_agg_state_alloc(aggcontext);
+    CachedColumn& col = state->value_column;
+    col.typmod = -1;
+    init_cached_column_type(col, basetype, kind);
+
+    // JSON inputs stay structured, matching the jsonb aggregates.
+    if (kind == ConverterKind::Jsonb) {
+        state->value_writer = &msgpack_agg_elem_jsonb;
+    } else if (kind == ConverterKind::JsonText) {
+        state->value_writer = &msgpack_agg_elem_json;
+    } else {
+        state->value_writer = col.msgpack_scalar_writer;
+    }
+    return state;
+}
 
-        // Serialize
-        z::ZBuffer buffer = z::serialize<Protocol>(map);
-        std::span<const uint8_t> data = buffer.buf();
+static inline size_t msgpack_store_container_header(uint8_t* out, size_t n, bool is_map)
+{
+    if (n < 16) {
+        out[0] = static_cast<uint8_t>((is_map ? 0x80u : 0x90u) | n);
+        return 1;
+    }
+    if (n < 65536) {
+        out[0] = is_map ? 0xDEu : 0xDCu;
+        msgpack_store_be16(out + 1, static_cast<uint16_t>(n));
+        return 3;
+    }
+    out[0] = is_map ? 0xDFu : 0xDDu;
+    msgpack_store_be32(out + 1, static_cast<uint32_t>(n));
+    return 5;
+}
 
-        // Allocate PostgreSQL bytea with actual size
-        // (Estimation helps zerialize internally, allocation uses actual size)
-        size_t len = data.size();
-        bytea* result = (bytea*) palloc(len + VARHDRSZ);
-        SET_VARSIZE(result, len + VARHDRSZ);
-        memcpy(VARDATA(result), data.data(), len);
+static inline size_t cbor_store_array_header(uint8_t* out, uint64_t n)
+{
+    return cbor_store_head(out, 4, n);
+}
 
-        return result;
-    } catch (const std::exception& ex) {
+static bytea* msgpack_agg_state_result(const MsgpackAggState* state, bool is_map)
+{
+    if (state->count > 0xFFFFFFFFu) {
         ereport(ERROR,
-                (errcode(ERRCODE_INTERNAL_ERROR),
-                 errmsg("serialization failed"),
-                 errdetail("%s", ex.what())));
-    } catch (...) {
+                (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+                 errmsg("aggregate element count exceeds MessagePack limits")));
+    }
+
+    uint8_t header[5];
+    const size_t header_len = msgpack_store_container_header(header, state->count, is_map);
+    const size_t body_len = state->rs.sbuf.size;
+    if (body_len > MaxAllocSize - VARHDRSZ - header_len) {
         ereport(ERROR,
-                (errcode(ERRCODE_INTERNAL_ERROR),
-                 errmsg("serialization failed with unknown exception")));
+                (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+                 errmsg("MessagePack aggregate result exceeds the maximum bytea size")));
     }
 
-    return nullptr;
+    bytea* result = (bytea*) palloc(VARHDRSZ + header_len + body_len);
+    SET_VARSIZE(result, VARHDRSZ + header_len + body_len);
+    memcpy(VARDATA(result), header, header_len);
+    if (body_len > 0) {
+        memcpy(VARDATA(result) + header_len, state->rs.sbuf.data, body_len);
+    }
+    return result;
 }
 
-template<typename Protocol>
-static bytea* tuple_to_binary_slow(HeapTupleHeader rec)
+static void msgpack_agg_append(MsgpackAggState* state, Datum value, bool isnull)
 {
     try {
-        z::dyn::Value map = record_to_dynamic_map(rec);
-        z::ZBuffer buffer = z::serialize<Protocol>(map);
-        std::span<const uint8_t> data = buffer.buf();
-        size_t len = data.size();
-        bytea* result = (bytea*) palloc(len + VARHDRSZ);
-        SET_VARSIZE(result, len + VARHDRSZ);
-        memcpy(VARDATA(result), data.data(), len);
-        return result;
+        z::MsgPackSerializer writer(state->rs);
+        state->value_writer(writer, state->value_column, isnull ? (Datum) 0 : value, isnull);
+        state->count++;
     } catch (const std::exception& ex) {
         ereport(ERROR,
                 (errcode(ERRCODE_INTERNAL_ERROR),
-                 errmsg("slow-path serialization failed"),
+                 errmsg("MessagePack aggregate serialization failed"),
                  errdetail("%s", ex.what())));
     } catch (...) {
         ereport(ERROR,
                 (errcode(ERRCODE_INTERNAL_ERROR),
-                 errmsg("slow-path serialization failed with unknown exception")));
+                 errmsg("MessagePack aggregate serialization failed with unknown exception")));
     }
-    return nullptr;
 }
 
-static bytea* dynamic_to_msgpack_binary(const z::dyn::Value& v)
+/*
+ * msgpack_agg_transfn - Append one value to the streaming MessagePack array.
+ */
+extern "C" Datum
+msgpack_agg_transfn(PG_FUNCTION_ARGS)
+{
+    MsgpackAggState* state = PG_ARGISNULL(0)
+        ? msgpack_agg_state_create(fcinfo, 1, "msgpack_agg_transfn")
+        : reinterpret_cast<MsgpackAggState*>(PG_GETARG_POINTER(0));
+    msgpack_agg_append(state, PG_GETARG_DATUM(1), PG_ARGISNULL(1));
+    PG_RETURN_POINTER(state);
+}
+
+/*
+ * msgpack_agg_finalfn - Prefix buffered elements with their array header.
+ */
+extern "C" Datum
+msgpack_agg_finalfn(PG_FUNCTION_ARGS)
+{
+    if (PG_ARGISNULL(0)) {
+        PG_RETURN_NULL();
+    }
+    const auto* state = reinterpret_cast<const MsgpackAggState*>(PG_GETARG_POINTER(0));
+    PG_RETURN_BYTEA_P(msgpack_agg_state_result(state, false));
+}
+
+/*
+ * msgpack_object_agg_transfn - Buffer one key/value pair. As in
+ * jsonb_object_agg, a repeated key keeps its last value.
+ */
+extern "C" Datum
+msgpack_object_agg_transfn(PG_FUNCTION_ARGS)
 {
+    MsgpackAggState* state = PG_ARGISNULL(0)
+        ? msgpack_agg_state_create(fcinfo, 2, "msgpack_object_agg_transfn")
+        : reinterpret_cast<MsgpackAggState*>(PG_GETARG_POINTER(0));
+
+    if (PG_ARGISNULL(1)) {
+        ereport(ERROR,
+                (errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+                 errmsg("field name must not be null")));
+    }
+    text* key = PG_GETARG_TEXT_PP(1);
+    std::string_view key_view(VARDATA_ANY(key), static_cast<size_t>(VARSIZE_ANY_EXHDR(key)));
+    const bool isnull = PG_ARGISNULL(2);
+    Datum value = isnull ? (Datum) 0 : PG_GETARG_DATUM(2);
+
     try {
-        z::ZBuffer buffer = z::serialize<z::MsgPack>(v);
-        std::span<const uint8_t> data = buffer.buf();
-        size_t len = data.size();
-        bytea* result = (bytea*) palloc(len + VARHDRSZ);
-        SET_VARSIZE(result, len + VARHDRSZ);
-        memcpy(VARDATA(result), data.data(), len);
-        return result;
+        const size_t offset = state->rs.sbuf.size;
+        z::MsgPackSerializer writer(state->rs);
+        state->value_writer(writer, state->value_column, value, isnull);
+        const std::pair<size_t, size_t> span(offset, state->rs.sbuf.size - offset);
+        auto [entry, inserted] = state->key_values.try_emplace(std::string(key_view), span);
+        if (!inserted) {
+            entry->second = span;
+        }
     } catch (const std::exception& ex) {
         ereport(ERROR,
                 (errcode(ERRCODE_INTERNAL_ERROR),
-                 errmsg("msgpack serialization failed"),
+                 errmsg("MessagePack aggregate serialization failed"),
                  errdetail("%s", ex.what())));
     } catch (...) {
         ereport(ERROR,
                 (errcode(ERRCODE_INTERNAL_ERROR),
-                 errmsg("msgpack serialization failed with unknown exception")));
+                 errmsg("MessagePack aggregate serialization failed with unknown exception")));
     }
-    return nullptr;
+
+    PG_RETURN_POINTER(state);
 }
 
 /*
- * Generic helper function to convert array of PostgreSQL tuples to binary format
- * This is the batch processing version for improved performance
- * Template parameter determines the serialization protocol
+ * msgpack_object_agg_finalfn - Write the buffered pairs as one map, keys in
+ * jsonb's order: shorter keys first, then bytewise.
  */
-template<typename Protocol>
-static bytea* array_to_binary(ArrayType* arr)
+extern "C" Datum
+msgpack_object_agg_finalfn(PG_FUNCTION_ARGS)
 {
-    // Get array element type (should be a record type)
-    Oid element_type = ARR_ELEMTYPE(arr);
-    int ndim = ARR_NDIM(arr);
-
-    // Handle empty arrays
-    if (ndim == 0 || ArrayGetNItems(ndim, ARR_DIMS(arr)) == 0) {
-        // Return empty array
-        z::ZBuffer buffer = z::serialize<Protocol>(z::dyn::Value::array(z::dyn::Value::Array()));
-        std::span<const uint8_t> data = buffer.buf();
-        size_t len = data.size();
-        bytea* result = (bytea*) palloc(len + VARHDRSZ);
-        SET_VARSIZE(result, len + VARHDRSZ);
-        memcpy(VARDATA(result), data.data(), len);
-        return result;
-    }
-
-    // For now, handle 1D arrays (covers most use cases)
-    if (ndim > 1) {
-        ereport(ERROR,
-                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-                 errmsg("multidimensional arrays not supported for batch serialization")));
+    if (PG_ARGISNULL(0)) {
+        PG_RETURN_NULL();
     }
-
-    // Batch functions only support arrays of records/composite values.
-    if (element_type != RECORDOID && get_typtype(element_type) != TYPTYPE_COMPOSITE) {
+    const auto* state = reinterpret_cast<const MsgpackAggState*>(PG_GETARG_POINTER(0));
+    if (state->key_values.size() > 0xFFFFFFFFu) {
         ereport(ERROR,
-                (errcode(ERRCODE_DATATYPE_MISMATCH),
-                 errmsg("batch serialization requires an array of composite records"),
-                 errdetail("Got array element type OID %u.", element_type)));
-    }
-
-    // Get array element info
-    int16 typlen;
-    bool typbyval;
-    char typalign;
-    get_typlenbyvalalign(element_type, &typlen, &typbyval, &typalign);
-
-    // Deconstruct array into elements
-    Datum* elements;
-    bool* nulls;
-    int nitems;
-
-    deconstruct_array(arr, element_type, typlen, typbyval, typalign,
-                     &elements, &nulls, &nitems);
-
-    if constexpr (std::is_same_v<Protocol, z::MsgPack>) {
-        if (bytea* fast = try_serialize_msgpack_array_fast(elements, nulls, nitems)) {
-            pfree(elements);
-            pfree(nulls);
-            return fast;
-        }
-    } else if constexpr (std::is_same_v<Protocol, z::CBOR>) {
-        if (bytea* fast = try_serialize_cbor_array_fast(elements, nulls, nitems)) {
-            pfree(elements);
-            pfree(nulls);
-            return fast;
-        }
-    } else if constexpr (std::is_same_v<Protocol, z::Zera>) {
-        if (bytea* fast = try_serialize_zera_array_fast(elements, nulls, nitems)) {
-            pfree(elements);
-            pfree(nulls);
-            return fast;
-        }
-    } else if constexpr (std::is_same_v<Protocol, z::Flex>) {
-        if (bytea* fast = try_serialize_flex_array_fast(elements, nulls, nitems)) {
-            pfree(elements);
-            pfree(nulls);
-            return fast;
-        }
+                (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+                 errmsg("aggregate element count exceeds MessagePack limits")));
     }
 
-    // Build array of record maps with pre-allocated capacity
-    z::dyn::Value::Array result_array;
-    result_array.reserve(nitems);  // Pre-allocate array capacity
+    z::MsgPackRootSerializer& rs = msgpack_reusable_root();
+    msgpack_sbuffer_clear(&rs.sbuf);
+    try {
+        using Entry = std::pair<const std::string, std::pair<size_t, size_t>>;
+        std::vector<const Entry*> entries;
+        entries.reserve(state->key_values.size());
+        for (const Entry& entry : state->key_values) {
+            entries.push_back(&entry);
+        }
+        std::sort(entries.begin(), entries.end(), [](const Entry* a, const Entry* b) {
+            if (a->first.size() != b->first.size()) {
+                return a->first.size() < b->first.size();
+            }
+            return a->first < b->first;
+        });
 
-    for (int i = 0; i < nitems; i++) {
-        if (nulls[i]) {
-            // Add null for NULL records
-            result_array.push_back(z::dyn::Value());
-        } else {
-            // Convert record to map
-            HeapTupleHeader rec = DatumGetHeapTupleHeader(elements[i]);
-            result_array.push_back(record_to_dynamic_map(rec));
+        const auto* values = reinterpret_cast<const uint8_t*>(state->rs.sbuf.data);
+        z::MsgPackSerializer writer(rs);
+        writer.begin_map(entries.size());
+        for (const Entry* entry : entries) {
+            writer.key(entry->first);
+            rs.write_raw(values + entry->second.first, entry->second.second);
         }
+        writer.end_map();
+    } catch (const std::exception& ex) {
+        msgpack_sbuffer_clear(&rs.sbuf);
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("MessagePack aggregate serialization failed"),
+                 errdetail("%s", ex.what())));
     }
+    if (rs.sbuf.size > MaxAllocSize - VARHDRSZ) {
+        msgpack_sbuffer_clear(&rs.sbuf);
+        ereport(ERROR,
+                (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+                 errmsg("MessagePack aggregate result exceeds the maximum bytea size")));
+    }
+    PG_RETURN_BYTEA_P(msgpack_result_from_reusable_root(rs));
+}
 
-    pfree(elements);
-    pfree(nulls);
-
+/*
+ * Re-encode the buffered rows of a rows aggregate as one protocol array.
+ * ZERA and FlexBuffers documents cannot be concatenated, so their partial
+ * states carry MessagePack and only this cheap byte-level pass runs serially.
+ */
+template <typename Protocol>
+static bytea* msgpack_agg_state_transcode(const MsgpackAggState* state, const char* protocol_name)
+{
     try {
-        // Serialize the array
-        z::ZBuffer buffer = z::serialize<Protocol>(z::dyn::Value::array(std::move(result_array)));
-        std::span<const uint8_t> data = buffer.buf();
+        std::span<const uint8_t> data(
+            reinterpret_cast<const uint8_t*>(state->rs.sbuf.data), state->rs.sbuf.size);
+        typename Protocol::RootSerializer rs;
+        typename Protocol::Serializer writer(rs);
 
-        // Copy to PostgreSQL bytea
-        size_t len = data.size();
+        writer.begin_array(state->count);
+        size_t pos = 0;
+        for (size_t i = 0; i < state->count; i++) {
+            pos = msgpack_replay_value(data, pos, writer);
+        }
+        writer.end_array();
+        if (pos != data.size()) {
+            throw z::DeserializationError("trailing bytes in aggregate state");
+        }
+
+        z::ZBuffer buffer = rs.finish();
+        std::span<const uint8_t> out = buffer.buf();
+        size_t len = out.size();
         bytea* result = (bytea*) palloc(len + VARHDRSZ);
         SET_VARSIZE(result, len + VARHDRSZ);
-        memcpy(VARDATA(result), data.data(), len);
-
+        memcpy(VARDATA(result), out.data(), len);
         return result;
     } catch (const std::exception& ex) {
         ereport(ERROR,
                 (errcode(ERRCODE_INTERNAL_ERROR),
-                 errmsg("batch serialization failed"),
+                 errmsg("%s rows aggregate serialization failed", protocol_name),
                  errdetail("%s", ex.what())));
     } catch (...) {
         ereport(ERROR,
                 (errcode(ERRCODE_INTERNAL_ERROR),
-                 errmsg("batch serialization failed with unknown exception")));
+                 errmsg("%s rows aggregate serialization failed with unknown exception",
+                        protocol_name)));
     }
-
     return nullptr;
 }
 
-template<typename Protocol>
-static bytea* array_to_binary_slow(ArrayType* arr)
+/*
+ * msgpack_rows_agg_transfn - Encode one record into the shared rows state.
+ */
+extern "C" Datum
+msgpack_rows_agg_transfn(PG_FUNCTION_ARGS)
 {
-    Oid element_type = ARR_ELEMTYPE(arr);
-    int ndim = ARR_NDIM(arr);
+    MsgpackAggState* state = PG_ARGISNULL(0)
+        ? msgpack_agg_state_create(fcinfo, 1, "msgpack_rows_agg_transfn")
+        : reinterpret_cast<MsgpackAggState*>(PG_GETARG_POINTER(0));
+    msgpack_agg_append(state, PG_GETARG_DATUM(1), PG_ARGISNULL(1));
+    PG_RETURN_POINTER(state);
+}
 
-    if (ndim == 0 || ArrayGetNItems(ndim, ARR_DIMS(arr)) == 0) {
-        z::ZBuffer buffer = z::serialize<Protocol>(z::dyn::Value::array(z::dyn::Value::Array()));
-        std::span<const uint8_t> data = buffer.buf();
-        size_t len = data.size();
-        bytea* result = (bytea*) palloc(len + VARHDRSZ);
-        SET_VARSIZE(result, len + VARHDRSZ);
-        memcpy(VARDATA(result), data.data(), len);
-        return result;
-    }
+/*
+ * cbor_rows_agg_transfn - Encode one record as CBOR into the rows state.
+ * Definite-length CBOR items concatenate like MessagePack ones, so the
+ * MessagePack combine, serial, and deserial functions apply unchanged.
+ */
+extern "C" Datum
+cbor_rows_agg_transfn(PG_FUNCTION_ARGS)
+{
+    MsgpackAggState* state = PG_ARGISNULL(0)
+        ? msgpack_agg_state_create(fcinfo, 1, "cbor_rows_agg_transfn")
+        : reinterpret_cast<MsgpackAggState*>(PG_GETARG_POINTER(0));
+    const bool isnull = PG_ARGISNULL(1);
 
-    if (ndim > 1) {
+    try {
+        z::cborjc::RootSerializer rs(std::move(cbor_reusable_storage()));
+        z::cborjc::Serializer writer(rs);
+        state->value_column.cbor_scalar_writer(
+            writer, state->value_column, isnull ? (Datum) 0 : PG_GETARG_DATUM(1), isnull);
+        std::span<const uint8_t> row = rs.bytes();
+        state->rs.write_raw(row.data(), row.size());
+        cbor_reusable_storage() = rs.release();
+        state->count++;
+    } catch (const std::exception& ex) {
         ereport(ERROR,
-                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-                 errmsg("multidimensional arrays not supported for batch serialization")));
-    }
-
-    if (element_type != RECORDOID && get_typtype(element_type) != TYPTYPE_COMPOSITE) {
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("CBOR rows aggregate serialization failed"),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
         ereport(ERROR,
-                (errcode(ERRCODE_DATATYPE_MISMATCH),
-                 errmsg("batch serialization requires an array of composite records"),
-                 errdetail("Got array element type OID %u.", element_type)));
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("CBOR rows aggregate serialization failed with unknown exception")));
     }
+    PG_RETURN_POINTER(state);
+}
 
-    int16 typlen;
-    bool typbyval;
-    char typalign;
-    get_typlenbyvalalign(element_type, &typlen, &typbyval, &typalign);
+/*
+ * msgpack_rows_agg_combinefn - Append one partial rows state to another.
+ */
+extern "C" Datum
+msgpack_rows_agg_combinefn(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext = msgpack_agg_memory_context(fcinfo, "msgpack_rows_agg_combinefn");
 
-    Datum* elements;
-    bool* nulls;
-    int nitems;
-    deconstruct_array(arr, element_type, typlen, typbyval, typalign, &elements, &nulls, &nitems);
+    if (PG_ARGISNULL(1)) {
+        if (PG_ARGISNULL(0)) {
+            PG_RETURN_NULL();
+        }
+        PG_RETURN_POINTER(PG_GETARG_POINTER(0));
+    }
 
-    z::dyn::Value::Array result_array;
-    result_array.reserve(nitems);
+    const auto* other = reinterpret_cast<const MsgpackAggState*>(PG_GETARG_POINTER(1));
+    MsgpackAggState* state = PG_ARGISNULL(0)
+        ? msgpack_agg_state_alloc(aggcontext)
+        : reinterpret_cast<MsgpackAggState*>(PG_GETARG_POINTER(0));
 
-    for (int i = 0; i < nitems; i++) {
-        if (nulls[i]) {
-            result_array.push_back(z::dyn::Value());
-        } else {
-            HeapTupleHeader rec = DatumGetHeapTupleHeader(elements[i]);
-            result_array.push_back(record_to_dynamic_map(rec));
+    try {
+        if (other->rs.sbuf.size > 0) {
+            state->rs.write_raw(reinterpret_cast<const uint8_t*>(other->rs.sbuf.data),
+                                other->rs.sbuf.size);
         }
+        state->count += other->count;
+    } catch (const std::exception& ex) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("MessagePack aggregate combine failed"),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("MessagePack aggregate combine failed with unknown exception")));
     }
 
-    pfree(elements);
-    pfree(nulls);
+    PG_RETURN_POINTER(state);
+}
+
+/*
+ * msgpack_rows_agg_serialfn - Flatten a partial rows state to bytea: a
+ * native-endian uint64 row count followed by the buffered MessagePack rows.
+ */
+extern "C" Datum
+msgpack_rows_agg_serialfn(PG_FUNCTION_ARGS)
+{
+    const auto* state = reinterpret_cast<const MsgpackAggState*>(PG_GETARG_POINTER(0));
+    const uint64_t count = static_cast<uint64_t>(state->count);
+    const size_t body_len = state->rs.sbuf.size;
+    if (body_len > MaxAllocSize - VARHDRSZ - sizeof(count)) {
+        ereport(ERROR,
+                (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+                 errmsg("MessagePack aggregate state exceeds the maximum bytea size")));
+    }
+
+    bytea* result = (bytea*) palloc(VARHDRSZ + sizeof(count) + body_len);
+    SET_VARSIZE(result, VARHDRSZ + sizeof(count) + body_len);
+    memcpy(VARDATA(result), &count, sizeof(count));
+    if (body_len > 0) {
+        memcpy(VARDATA(result) + sizeof(count), state->rs.sbuf.data, body_len);
+    }
+    PG_RETURN_BYTEA_P(result);
+}
+
+/*
+ * msgpack_rows_agg_deserialfn - Rebuild a partial rows state from bytea.
+ */
+extern "C" Datum
+msgpack_rows_agg_deserialfn(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext = msgpack_agg_memory_context(fcinfo, "msgpack_rows_agg_deserialfn");
+    bytea* input = PG_GETARG_BYTEA_PP(0);
+    const char* bytes = VARDATA_ANY(input);
+    const size_t len = VARSIZE_ANY_EXHDR(input);
+    uint64_t count;
+    if (len < sizeof(count)) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                 errmsg("invalid MessagePack aggregate state")));
+    }
+    memcpy(&count, bytes, sizeof(count));
 
+    MsgpackAggState* state = msgpack_agg_state_alloc(aggcontext);
     try {
-        z::ZBuffer buffer = z::serialize<Protocol>(z::dyn::Value::array(std::move(result_array)));
-        std::span<const uint8_t> data = buffer.buf();
-        size_t len = data.size();
-        bytea* result = (bytea*) palloc(len + VARHDRSZ);
-        SET_VARSIZE(result, len + VARHDRSZ);
-        memcpy(VARDATA(result), data.data(), len);
-        return result;
+        if (len > sizeof(count)) {
+            state->rs.write_raw(reinterpret_cast<const uint8_t*>(bytes + sizeof(count)),
+                                len - sizeof(count));
+        }
+        state->count = static_cast<size_t>(count);
     } catch (const std::exception& ex) {
         ereport(ERROR,
                 (errcode(ERRCODE_INTERNAL_ERROR),
-                 errmsg("slow-path batch serialization failed"),
+                 errmsg("MessagePack aggregate state restore failed"),
                  errdetail("%s", ex.what())));
     } catch (...) {
         ereport(ERROR,
                 (errcode(ERRCODE_INTERNAL_ERROR),
-                 errmsg("slow-path batch serialization failed with unknown exception")));
+                 errmsg("MessagePack aggregate state restore failed with unknown exception")));
     }
 
-    return nullptr;
+    PG_RETURN_POINTER(state);
+}
+
+/*
+ * cbor_rows_agg_finalfn - Emit buffered MessagePack rows as one CBOR array.
+ * Retained for extension schemas older than 1.21.
+ */
+extern "C" Datum
+cbor_rows_agg_finalfn(PG_FUNCTION_ARGS)
+{
+    if (PG_ARGISNULL(0)) {
+        PG_RETURN_NULL();
+    }
+    const auto* state = reinterpret_cast<const MsgpackAggState*>(PG_GETARG_POINTER(0));
+    PG_RETURN_BYTEA_P(msgpack_agg_state_transcode<z::CBOR>(state, "CBOR"));
+}
+
+/*
+ * cbor_rows_agg_concat_finalfn - Prefix buffered CBOR rows with their array
+ * header.
+ */
+extern "C" Datum
+cbor_rows_agg_concat_finalfn(PG_FUNCTION_ARGS)
+{
+    if (PG_ARGISNULL(0)) {
+        PG_RETURN_NULL();
+    }
+    const auto* state = reinterpret_cast<const MsgpackAggState*>(PG_GETARG_POINTER(0));
+
+    uint8_t header[9];
+    const size_t header_len = cbor_store_array_header(header, state->count);
+    const size_t body_len = state->rs.sbuf.size;
+    if (body_len > MaxAllocSize - VARHDRSZ - header_len) {
+        ereport(ERROR,
+                (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+                 errmsg("CBOR aggregate result exceeds the maximum bytea size")));
+    }
+
+    bytea* result = (bytea*) palloc(VARHDRSZ + header_len + body_len);
+    SET_VARSIZE(result, VARHDRSZ + header_len + body_len);
+    memcpy(VARDATA(result), header, header_len);
+    if (body_len > 0) {
+        memcpy(VARDATA(result) + header_len, state->rs.sbuf.data, body_len);
+    }
+    PG_RETURN_BYTEA_P(result);
+}
+
+/*
+ * zera_rows_agg_finalfn - Emit buffered rows as one ZERA array.
+ */
+extern "C" Datum
+zera_rows_agg_finalfn(PG_FUNCTION_ARGS)
+{
+    if (PG_ARGISNULL(0)) {
+        PG_RETURN_NULL();
+    }
+    const auto* state = reinterpret_cast<const MsgpackAggState*>(PG_GETARG_POINTER(0));
+    PG_RETURN_BYTEA_P(msgpack_agg_state_transcode<z::Zera>(state, "ZERA"));
+}
+
+/*
+ * flexbuffers_rows_agg_finalfn - Emit buffered rows as one FlexBuffers vector.
+ */
+extern "C" Datum
+flexbuffers_rows_agg_finalfn(PG_FUNCTION_ARGS)
+{
+    if (PG_ARGISNULL(0)) {
+        PG_RETURN_NULL();
+    }
+    const auto* state = reinterpret_cast<const MsgpackAggState*>(PG_GETARG_POINTER(0));
+    PG_RETURN_BYTEA_P(msgpack_agg_state_transcode<z::Flex>(state, "Flex"));
+}
+
+/*
+ * msgpack_agg_final - Finalize jsonb_agg state and convert to MessagePack.
+ * Retained for extension schemas older than 1.7.
+ */
+extern "C" Datum
+msgpack_agg_final(PG_FUNCTION_ARGS)
+{
+    if (PG_ARGISNULL(0)) {
+        PG_RETURN_NULL();
+    }
+    Datum agg = DirectFunctionCall1(jsonb_agg_finalfn, PG_GETARG_DATUM(0));
+    if (DatumGetPointer(agg) == nullptr) {
+        PG_RETURN_NULL();
+    }
+    Jsonb* jb = DatumGetJsonbP(agg);
+    z::dyn::Value v = jsonb_to_dynamic(jb, numeric_encoding);
+    bytea* result = dynamic_to_msgpack_binary(v);
+    PG_RETURN_BYTEA_P(result);
+}
+
+/*
+ * msgpack_object_agg_final - Finalize jsonb_object_agg state and convert.
+ * Retained for extension schemas older than 1.7.
+ */
+extern "C" Datum
+msgpack_object_agg_final(PG_FUNCTION_ARGS)
+{
+    if (PG_ARGISNULL(0)) {
+        PG_RETURN_NULL();
+    }
+    Datum agg = DirectFunctionCall1(jsonb_object_agg_finalfn, PG_GETARG_DATUM(0));
+    if (DatumGetPointer(agg) == nullptr) {
+        PG_RETURN_NULL();
+    }
+    Jsonb* jb = DatumGetJsonbP(agg);
+    z::dyn::Value v = jsonb_to_dynamic(jb, numeric_encoding);
+    bytea* result = dynamic_to_msgpack_binary(v);
+    PG_RETURN_BYTEA_P(result);
+}
+
+/*
+ * row_to_cbor - Convert PostgreSQL record to CBOR binary format
+ */
+extern "C" Datum
+row_to_cbor(PG_FUNCTION_ARGS)
+{
+    HeapTupleHeader rec;
+    bytea* result;
+
+    // Get the record argument
+    rec = PG_GETARG_HEAPTUPLEHEADER(0);
+
+    // Convert to CBOR
+    result = tuple_to_binary<z::CBOR>(rec, nullptr, fcinfo);
+
+    PG_RETURN_BYTEA_P(result);
+}
+
+/*
+ * row_to_zera - Convert PostgreSQL record to ZERA binary format
+ */
+extern "C" Datum
+row_to_zera(PG_FUNCTION_ARGS)
+{
+    HeapTupleHeader rec;
+    bytea* result;
+
+    // Get the record argument
+    rec = PG_GETARG_HEAPTUPLEHEADER(0);
+
+    // Convert to ZERA
+    result = tuple_to_binary<z::Zera>(rec, nullptr, fcinfo);
+
+    PG_RETURN_BYTEA_P(result);
 }
 
 /*
- * Single record serialization functions
+ * Batch processing functions (multiple records at once)
  */
 
 /*
- * row_to_flexbuffers - Convert PostgreSQL record to FlexBuffers binary format
+ * rows_to_flexbuffers - Convert array of PostgreSQL records to FlexBuffers binary format
  */
 extern "C" Datum
-row_to_flexbuffers(PG_FUNCTION_ARGS)
+rows_to_flexbuffers(PG_FUNCTION_ARGS)
 {
-    HeapTupleHeader rec;
+    ArrayType* arr;
     bytea* result;
 
-    // Get the record argument
-    rec = PG_GETARG_HEAPTUPLEHEADER(0);
+    // Get the array argument
+    arr = PG_GETARG_ARRAYTYPE_P(0);
 
-    // Convert to FlexBuffers
-    result = tuple_to_binary<z::Flex>(rec);
+    // Convert to FlexBuffers array
+    result = array_to_binary<z::Flex>(arr);
 
     PG_RETURN_BYTEA_P(result);
 }
 
 /*
- * row_to_msgpack - Convert PostgreSQL record to MessagePack binary format
+ * rows_to_msgpack - Convert array of PostgreSQL records to MessagePack binary format
  */
 extern "C" Datum
-row_to_msgpack(PG_FUNCTION_ARGS)
+rows_to_msgpack(PG_FUNCTION_ARGS)
 {
-    HeapTupleHeader rec;
+    ArrayType* arr;
     bytea* result;
 
-    // Get the record argument
-    rec = PG_GETARG_HEAPTUPLEHEADER(0);
+    // Get the array argument
+    arr = PG_GETARG_ARRAYTYPE_P(0);
 
-    // Convert to MessagePack
-    result = tuple_to_binary<z::MsgPack>(rec);
+    // Convert to MessagePack array
+    result = array_to_binary<z::MsgPack>(arr);
 
     PG_RETURN_BYTEA_P(result);
 }
 
 /*
- * row_to_msgpack_slow - Convert PostgreSQL record to MessagePack via generic dynamic path
+ * rows_to_msgpack_slow - Convert array of records via generic dynamic path
  * Useful for parity/correctness testing against fast path.
  */
 extern "C" Datum
-row_to_msgpack_slow(PG_FUNCTION_ARGS)
+rows_to_msgpack_slow(PG_FUNCTION_ARGS)
 {
-    HeapTupleHeader rec;
+    ArrayType* arr;
     bytea* result;
 
-    rec = PG_GETARG_HEAPTUPLEHEADER(0);
-    result = tuple_to_binary_slow<z::MsgPack>(rec);
+    arr = PG_GETARG_ARRAYTYPE_P(0);
+    result = array_to_binary_slow<z::MsgPack>(arr);
     PG_RETURN_BYTEA_P(result);
 }
 
 /*
- * msgpack_from_jsonb - Convert nested jsonb to nested MessagePack.
- * This is the core bridge for SQL builder parity workflows.
+ * rows_to_cbor - Convert array of PostgreSQL records to CBOR binary format
  */
 extern "C" Datum
-msgpack_from_jsonb(PG_FUNCTION_ARGS)
+rows_to_cbor(PG_FUNCTION_ARGS)
 {
-    Jsonb* jb = PG_GETARG_JSONB_P(0);
-    z::dyn::Value v = jsonb_to_dynamic(jb);
-    bytea* result = dynamic_to_msgpack_binary(v);
+    ArrayType* arr;
+    bytea* result;
+
+    // Get the array argument
+    arr = PG_GETARG_ARRAYTYPE_P(0);
+
+    // Convert to CBOR array
+    result = array_to_binary<z::CBOR>(arr);
+
     PG_RETURN_BYTEA_P(result);
 }
 
 /*
- * msgpack_to_jsonb - Safely decode one complete MessagePack value to jsonb.
+ * rows_to_zera - Convert array of PostgreSQL records to ZERA binary format
  */
 extern "C" Datum
-msgpack_to_jsonb(PG_FUNCTION_ARGS)
+rows_to_zera(PG_FUNCTION_ARGS)
 {
-    bytea* input = PG_GETARG_BYTEA_PP(0);
-    const auto* bytes = reinterpret_cast<const uint8_t*>(VARDATA_ANY(input));
-    const size_t length = static_cast<size_t>(VARSIZE_ANY_EXHDR(input));
-    std::span<const uint8_t> data(bytes, length);
+    ArrayType* arr;
+    bytea* result;
 
-    try {
-        const size_t consumed = msgpack_validate_value(data, 0);
-        if (consumed != data.size()) {
-            throw z::DeserializationError("trailing bytes after MessagePack value");
-        }
+    // Get the array argument
+    arr = PG_GETARG_ARRAYTYPE_P(0);
 
-        z::MsgPackDeserializer reader(data);
-        std::string json;
-        json.reserve(length + 32);
-        msgpack_reader_to_json(reader, json);
-        PG_FREE_IF_COPY(input, 0);
+    // Convert to ZERA array
+    result = array_to_binary<z::Zera>(arr);
 
-        Datum result = DirectFunctionCall1(jsonb_in, CStringGetDatum(json.c_str()));
-        PG_RETURN_DATUM(result);
-    } catch (const std::exception& ex) {
-        ereport(ERROR,
-                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
-                 errmsg("invalid MessagePack input"),
-                 errdetail("%s", ex.what())));
-    } catch (...) {
-        ereport(ERROR,
-                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
-                 errmsg("invalid MessagePack input"),
-                 errdetail("unknown decoding error")));
+    PG_RETURN_BYTEA_P(result);
+}
+
+/*
+ * Compressed batch variants. The document is encoded as usual and then
+ * compressed once into a frame that the *_to_jsonb decoders and
+ * zerialize_decompress unwrap; 'none' returns the plain document.
+ */
+template<typename Protocol>
+static Datum rows_to_binary_compressed(FunctionCallInfo fcinfo)
+{
+    ArrayType* arr = PG_GETARG_ARRAYTYPE_P(0);
+    const int level = PG_GETARG_INT32(2);
+    const FrameCodec codec = frame_codec_from_args(PG_GETARG_TEXT_PP(1), level);
+    bytea* document = array_to_binary<Protocol>(arr);
+    if (codec == FrameCodec::None) {
+        PG_RETURN_BYTEA_P(document);
     }
+    bytea* result = frame_compress(document, frame_protocol_of<Protocol>(), codec, level);
+    pfree(document);
+    PG_RETURN_BYTEA_P(result);
+}
 
-    PG_RETURN_NULL();
+extern "C" Datum
+rows_to_flexbuffers_compressed(PG_FUNCTION_ARGS)
+{
+    return rows_to_binary_compressed<z::Flex>(fcinfo);
+}
+
+extern "C" Datum
+rows_to_msgpack_compressed(PG_FUNCTION_ARGS)
+{
+    return rows_to_binary_compressed<z::MsgPack>(fcinfo);
+}
+
+extern "C" Datum
+rows_to_cbor_compressed(PG_FUNCTION_ARGS)
+{
+    return rows_to_binary_compressed<z::CBOR>(fcinfo);
+}
+
+extern "C" Datum
+rows_to_zera_compressed(PG_FUNCTION_ARGS)
+{
+    return rows_to_binary_compressed<z::Zera>(fcinfo);
 }
 
 /*
- * flexbuffers_to_jsonb - Verify and decode one FlexBuffer value to jsonb.
+ * zerialize_decompress - Unwrap a compressed frame of any protocol. Input
+ * without a frame header is returned unchanged.
  */
 extern "C" Datum
-flexbuffers_to_jsonb(PG_FUNCTION_ARGS)
+zerialize_decompress(PG_FUNCTION_ARGS)
 {
     bytea* input = PG_GETARG_BYTEA_PP(0);
-    const auto* bytes = reinterpret_cast<const uint8_t*>(VARDATA_ANY(input));
-    const size_t length = static_cast<size_t>(VARSIZE_ANY_EXHDR(input));
+    std::span<const uint8_t> data(reinterpret_cast<const uint8_t*>(VARDATA_ANY(input)),
+                                  static_cast<size_t>(VARSIZE_ANY_EXHDR(input)));
+    if (!frame_has_header(data)) {
+        PG_RETURN_BYTEA_P(input);
+    }
+    PG_RETURN_BYTEA_P(frame_decompress(data, 0));
+}
 
-    try {
-        if (!::flexbuffers::VerifyBuffer(bytes, length)) {
-            throw z::DeserializationError("FlexBuffer verification failed");
-        }
+/*
+ * Column projection variants. The text[] argument names the columns to emit,
+ * in output order; the resolved plan is cached per row type and column list.
+ */
+static void read_column_projection(ArrayType* columns, ColumnProjection* projection)
+{
+    Datum* elements;
+    bool* nulls;
+    int count;
+    deconstruct_array_builtin(columns, TEXTOID, &elements, &nulls, &count);
 
-        ::flexbuffers::Reference root = ::flexbuffers::GetRoot(bytes, length);
-        std::string json;
-        json.reserve(length + 32);
-        flex_reference_to_json(root, json);
-        PG_FREE_IF_COPY(input, 0);
+    std::vector<size_t> lengths;
+    lengths.reserve(count);
+    for (int i = 0; i < count; i++) {
+        if (nulls[i]) {
+            ereport(ERROR,
+                    (errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+                     errmsg("column names must not be null")));
+        }
+        text* name = DatumGetTextPP(elements[i]);
+        if (i > 0) {
+            projection->key.push_back('\0');
+        }
+        projection->key.append(VARDATA_ANY(name), VARSIZE_ANY_EXHDR(name));
+        lengths.push_back(VARSIZE_ANY_EXHDR(name));
+    }
 
-        Datum result = DirectFunctionCall1(jsonb_in, CStringGetDatum(json.c_str()));
-        PG_RETURN_DATUM(result);
-    } catch (const std::exception& ex) {
-        ereport(ERROR,
-                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
-                 errmsg("invalid FlexBuffer input"),
-                 errdetail("%s", ex.what())));
-    } catch (...) {
-        ereport(ERROR,
-                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
-                 errmsg("invalid FlexBuffer input"),
-                 errdetail("unknown decoding error")));
+    // Views are taken once the key has stopped growing.
+    projection->names.reserve(count);
+    size_t offset = 0;
+    for (size_t len : lengths) {
+        projection->names.emplace_back(projection->key.data() + offset, len);
+        offset += len + 1;
     }
+}
 
-    PG_RETURN_NULL();
+template<typename Protocol>
+static Datum row_to_binary_columns(FunctionCallInfo fcinfo)
+{
+    HeapTupleHeader rec = PG_GETARG_HEAPTUPLEHEADER(0);
+    ColumnProjection projection;
+    read_column_projection(PG_GETARG_ARRAYTYPE_P(1), &projection);
+    PG_RETURN_BYTEA_P(tuple_to_binary<Protocol>(rec, &projection));
+}
+
+template<typename Protocol>
+static Datum rows_to_binary_columns(FunctionCallInfo fcinfo)
+{
+    ArrayType* arr = PG_GETARG_ARRAYTYPE_P(0);
+    ColumnProjection projection;
+    read_column_projection(PG_GETARG_ARRAYTYPE_P(1), &projection);
+    PG_RETURN_BYTEA_P(array_to_binary<Protocol>(arr, &projection));
+}
+
+extern "C" Datum
+row_to_flexbuffers_columns(PG_FUNCTION_ARGS)
+{
+    return row_to_binary_columns<z::Flex>(fcinfo);
+}
+
+extern "C" Datum
+row_to_msgpack_columns(PG_FUNCTION_ARGS)
+{
+    return row_to_binary_columns<z::MsgPack>(fcinfo);
+}
+
+extern "C" Datum
+row_to_cbor_columns(PG_FUNCTION_ARGS)
+{
+    return row_to_binary_columns<z::CBOR>(fcinfo);
+}
+
+extern "C" Datum
+row_to_zera_columns(PG_FUNCTION_ARGS)
+{
+    return row_to_binary_columns<z::Zera>(fcinfo);
+}
+
+extern "C" Datum
+rows_to_flexbuffers_columns(PG_FUNCTION_ARGS)
+{
+    return rows_to_binary_columns<z::Flex>(fcinfo);
+}
+
+extern "C" Datum
+rows_to_msgpack_columns(PG_FUNCTION_ARGS)
+{
+    return rows_to_binary_columns<z::MsgPack>(fcinfo);
+}
+
+extern "C" Datum
+rows_to_cbor_columns(PG_FUNCTION_ARGS)
+{
+    return rows_to_binary_columns<z::CBOR>(fcinfo);
+}
+
+extern "C" Datum
+rows_to_zera_columns(PG_FUNCTION_ARGS)
+{
+    return rows_to_binary_columns<z::Zera>(fcinfo);
 }
 
 /*
- * cbor_to_jsonb - Strictly parse one complete CBOR value to jsonb.
+ * rows_to_msgpack_compact - Convert array of PostgreSQL records to a compact
+ * MessagePack batch with the column names written once
  */
 extern "C" Datum
-cbor_to_jsonb(PG_FUNCTION_ARGS)
+rows_to_msgpack_compact(PG_FUNCTION_ARGS)
 {
-    bytea* input = PG_GETARG_BYTEA_PP(0);
-    const auto* bytes = reinterpret_cast<const uint8_t*>(VARDATA_ANY(input));
-    const size_t length = static_cast<size_t>(VARSIZE_ANY_EXHDR(input));
-    std::span<const uint8_t> data(bytes, length);
+    ArrayType* arr = PG_GETARG_ARRAYTYPE_P(0);
+    PG_RETURN_BYTEA_P(array_to_compact_binary<z::MsgPack>(arr));
+}
 
-    try {
-        std::string json;
-        json.reserve(length + 32);
-        const size_t consumed = cbor_value_to_json(data, 0, json);
-        if (consumed != data.size()) {
-            throw z::DeserializationError("trailing bytes after CBOR value");
-        }
-        PG_FREE_IF_COPY(input, 0);
+/*
+ * rows_to_cbor_compact - Convert array of PostgreSQL records to a compact
+ * CBOR batch with the column names written once
+ */
+extern "C" Datum
+rows_to_cbor_compact(PG_FUNCTION_ARGS)
+{
+    ArrayType* arr = PG_GETARG_ARRAYTYPE_P(0);
+    PG_RETURN_BYTEA_P(array_to_compact_binary<z::CBOR>(arr));
+}
 
-        Datum result = DirectFunctionCall1(jsonb_in, CStringGetDatum(json.c_str()));
-        PG_RETURN_DATUM(result);
-    } catch (const std::exception& ex) {
-        ereport(ERROR,
-                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
-                 errmsg("invalid CBOR input"),
-                 errdetail("%s", ex.what())));
-    } catch (...) {
-        ereport(ERROR,
-                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
-                 errmsg("invalid CBOR input"),
-                 errdetail("unknown decoding error")));
+/*
+ * rows_to_zera_compact - Convert array of PostgreSQL records to a compact
+ * ZERA batch with the column names written once
+ */
+extern "C" Datum
+rows_to_zera_compact(PG_FUNCTION_ARGS)
+{
+    ArrayType* arr = PG_GETARG_ARRAYTYPE_P(0);
+    PG_RETURN_BYTEA_P(array_to_compact_binary<z::Zera>(arr));
+}
+
+/*
+ * rows_to_zera_columnar - Convert array of PostgreSQL records to a columnar
+ * ZERA batch with one contiguous buffer per column
+ */
+extern "C" Datum
+rows_to_zera_columnar(PG_FUNCTION_ARGS)
+{
+    ArrayType* arr = PG_GETARG_ARRAYTYPE_P(0);
+    PG_RETURN_BYTEA_P(array_to_zera_columnar(arr));
+}
+
+/*
+ * Fast record writers by serializer type, for callers that write records into
+ * a larger document. Each returns false when the schema needs the dynamic
+ * path; either way the record counts as one embedded row.
+ */
+static inline bool write_record_fast(
+    z::MsgPackSerializer& writer, HeapTupleHeader rec, const CachedSchema& schema)
+{
+    stats_count(StatsProtocol::MsgPack, StatsEntryPoint::Embedded, StatsPathMetric::Rows);
+    if (!schema_fast_supported(schema, HeapTupleHeaderGetTypeId(rec),
+                               StatsProtocol::MsgPack, StatsEntryPoint::Embedded)) {
+        return false;
     }
+    stats_count(StatsProtocol::MsgPack, StatsEntryPoint::Embedded, StatsPathMetric::FastPath);
+    TupleDeformScratch scratch;
+    msgpack_write_record_map(writer, rec, schema, &scratch);
+    return true;
+}
 
-    PG_RETURN_NULL();
+static inline bool write_record_fast(
+    z::cborjc::Serializer& writer, HeapTupleHeader rec, const CachedSchema& schema)
+{
+    stats_count(StatsProtocol::Cbor, StatsEntryPoint::Embedded, StatsPathMetric::Rows);
+    if (!schema_fast_supported(schema, HeapTupleHeaderGetTypeId(rec),
+                               StatsProtocol::Cbor, StatsEntryPoint::Embedded)) {
+        return false;
+    }
+    stats_count(StatsProtocol::Cbor, StatsEntryPoint::Embedded, StatsPathMetric::FastPath);
+    TupleDeformScratch scratch;
+    cbor_write_record_map(writer, rec, schema, &scratch);
+    return true;
+}
+
+static inline bool write_record_fast(
+    z::zera::Serializer& writer, HeapTupleHeader rec, const CachedSchema& schema)
+{
+    stats_count(StatsProtocol::Zera, StatsEntryPoint::Embedded, StatsPathMetric::Rows);
+    if (!schema_fast_supported(schema, HeapTupleHeaderGetTypeId(rec),
+                               StatsProtocol::Zera, StatsEntryPoint::Embedded)) {
+        return false;
+    }
+    stats_count(StatsProtocol::Zera, StatsEntryPoint::Embedded, StatsPathMetric::FastPath);
+    TupleDeformScratch scratch;
+    zera_write_record_map(writer, rec, schema, &scratch);
+    return true;
+}
+
+static inline bool write_record_fast(
+    z::flex::Serializer& writer, HeapTupleHeader rec, const CachedSchema& schema)
+{
+    stats_count(StatsProtocol::Flex, StatsEntryPoint::Embedded, StatsPathMetric::Rows);
+    if (!schema_fast_supported(schema, HeapTupleHeaderGetTypeId(rec),
+                               StatsProtocol::Flex, StatsEntryPoint::Embedded)) {
+        return false;
+    }
+    stats_count(StatsProtocol::Flex, StatsEntryPoint::Embedded, StatsPathMetric::FastPath);
+    TupleDeformScratch scratch;
+    flex_write_record_map(writer, rec, schema, &scratch);
+    return true;
 }
 
 /*
- * zera_to_jsonb - Validate and decode one ZERA v1 document to jsonb.
+ * Write one record map into an open serializer, through the fast writer when
+ * the schema allows it and the dynamic tree otherwise.
  */
-extern "C" Datum
-zera_to_jsonb(PG_FUNCTION_ARGS)
+template<typename Writer>
+static void write_record_any(
+    Writer& writer, HeapTupleHeader rec, const CachedSchema& schema,
+    const ColumnProjection* projection)
+{
+    if (!write_record_fast(writer, rec, schema)) {
+        z::dyn::serialize(record_to_dynamic_map(rec, projection), writer);
+    }
+}
+
+/*
+ * Chunked query export
+ *
+ * msgpack_stream runs its query through an SPI cursor and encodes fetched
+ * rows into a buffer owned by the set, so the reusable root stays free for
+ * other calls between chunks. Whenever the rows buffered for the next chunk
+ * reach chunk_bytes, a cut is recorded; each call emits the oldest cut as a
+ * MessagePack array of row maps and shifts the remaining rows down.
+ */
+
+static constexpr long MSGPACK_STREAM_FETCH_ROWS = 1000;
+
+struct MsgpackStreamCut {
+    size_t end;
+    size_t rows;
+};
+
+struct MsgpackStreamState {
+    z::MsgPackRootSerializer rs;
+    std::vector<MsgpackStreamCut> cuts;
+    size_t chunk_bytes;
+    size_t chunk_start;
+    size_t buffered_rows;
+    size_t cut_rows;
+    char* portal_name;
+    bool exhausted;
+    MemoryContextCallback cleanup;
+};
+
+static void msgpack_stream_state_cleanup(void* arg)
+{
+    static_cast<MsgpackStreamState*>(arg)->~MsgpackStreamState();
+}
+
+/* Encode the next batch of cursor rows, recording a cut at each threshold. */
+static void msgpack_stream_fetch(MsgpackStreamState* state)
 {
-    bytea* input = PG_GETARG_BYTEA_PP(0);
-    const auto* bytes = reinterpret_cast<const uint8_t*>(VARDATA_ANY(input));
-    const size_t length = static_cast<size_t>(VARSIZE_ANY_EXHDR(input));
-    std::span<const uint8_t> data(bytes, length);
+    if (SPI_connect() != SPI_OK_CONNECT) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("msgpack_stream could not connect to SPI")));
+    }
+    Portal portal = SPI_cursor_find(state->portal_name);
+    if (portal == nullptr) {
+        ereport(ERROR,
+                (errcode(ERRCODE_UNDEFINED_CURSOR),
+                 errmsg("msgpack_stream cursor \"%s\" no longer exists",
+                        state->portal_name)));
+    }
+    SPI_cursor_fetch(portal, true, MSGPACK_STREAM_FETCH_ROWS);
 
-    try {
-        if (data.size() < z::zera::HeaderSize) {
-            throw z::DeserializationError("truncated ZERA header");
-        }
-        const z::zera::HeaderView header = z::zera::parse_header(data);
-        if (header.magic != z::zera::Magic) {
-            throw z::DeserializationError("invalid ZERA magic");
-        }
-        if (header.version != z::zera::Version) {
-            throw z::DeserializationError("unsupported ZERA version");
-        }
-        if (header.flags != 1) {
-            throw z::DeserializationError("invalid ZERA header flags");
-        }
-        if (header.env_size < 16 ||
-            header.env_size > data.size() - z::zera::HeaderSize) {
-            throw z::DeserializationError("invalid ZERA envelope size");
-        }
-        if (header.root_ofs > header.env_size - 16) {
-            throw z::DeserializationError("ZERA root ValueRef is out of bounds");
-        }
-        const size_t envelope_end =
-            z::zera::HeaderSize + static_cast<size_t>(header.env_size);
-        if (header.arena_ofs < envelope_end || header.arena_ofs > data.size() ||
-            header.arena_ofs % z::zera::ArenaBaseAlign != 0) {
-            throw z::DeserializationError("invalid ZERA arena offset");
-        }
-        for (size_t i = envelope_end; i < header.arena_ofs; i++) {
-            if (data[i] != 0) {
-                throw z::DeserializationError("nonzero ZERA envelope padding");
+    if (SPI_processed == 0) {
+        state->exhausted = true;
+    } else {
+        // A blessed descriptor gives the rows a record typmod the schema
+        // cache can resolve.
+        TupleDesc tupdesc = BlessTupleDesc(SPI_tuptable->tupdesc);
+        const CachedSchema& schema = get_cached_schema(tupdesc->tdtypeid, tupdesc->tdtypmod);
+        try {
+            z::MsgPackSerializer writer(state->rs);
+            for (uint64 i = 0; i < SPI_processed; i++) {
+                HeapTupleHeader rec = DatumGetHeapTupleHeader(
+                    heap_copy_tuple_as_datum(SPI_tuptable->vals[i], tupdesc));
+                write_record_any(writer, rec, schema, nullptr);
+                state->buffered_rows++;
+                state->cut_rows++;
+                if (state->rs.sbuf.size - state->chunk_start >= state->chunk_bytes) {
+                    state->cuts.push_back({state->rs.sbuf.size, state->cut_rows});
+                    state->chunk_start = state->rs.sbuf.size;
+                    state->cut_rows = 0;
+                }
             }
+        } catch (const std::exception& ex) {
+            ereport(ERROR,
+                    (errcode(ERRCODE_INTERNAL_ERROR),
+                     errmsg("msgpack_stream row serialization failed"),
+                     errdetail("%s", ex.what())));
+        } catch (...) {
+            ereport(ERROR,
+                    (errcode(ERRCODE_INTERNAL_ERROR),
+                     errmsg("msgpack_stream row serialization failed with unknown exception")));
         }
+    }
 
-        ZeraDecodeContext context{
-            data.subspan(z::zera::HeaderSize, header.env_size),
-            data.subspan(header.arena_ofs),
-            {}};
-        std::string json;
-        json.reserve(length + 32);
-        zera_value_to_json(context, header.root_ofs, json, 0);
-        PG_FREE_IF_COPY(input, 0);
+    SPI_freetuptable(SPI_tuptable);
+    SPI_finish();
+}
 
-        Datum result = DirectFunctionCall1(jsonb_in, CStringGetDatum(json.c_str()));
-        PG_RETURN_DATUM(result);
-    } catch (const std::exception& ex) {
+/* Copy the first `end` buffered bytes out as an array of `rows` maps. */
+static bytea* msgpack_stream_take(MsgpackStreamState* state, size_t end, size_t rows)
+{
+    if (rows > 0xFFFFFFFFu) {
         ereport(ERROR,
-                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
-                 errmsg("invalid ZERA input"),
-                 errdetail("%s", ex.what())));
-    } catch (...) {
+                (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+                 errmsg("msgpack_stream chunk row count exceeds MessagePack limits")));
+    }
+
+    uint8_t header[5];
+    const size_t header_len = msgpack_store_container_header(header, rows, false);
+    if (end > MaxAllocSize - VARHDRSZ - header_len) {
         ereport(ERROR,
-                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
-                 errmsg("invalid ZERA input"),
-                 errdetail("unknown decoding error")));
+                (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+                 errmsg("msgpack_stream chunk exceeds the maximum bytea size"),
+                 errhint("Use a smaller chunk_bytes.")));
     }
 
-    PG_RETURN_NULL();
+    bytea* result = (bytea*) palloc(VARHDRSZ + header_len + end);
+    SET_VARSIZE(result, VARHDRSZ + header_len + end);
+    memcpy(VARDATA(result), header, header_len);
+    if (end > 0) {
+        memcpy(VARDATA(result) + header_len, state->rs.sbuf.data, end);
+    }
+
+    const size_t rest = state->rs.sbuf.size - end;
+    if (rest > 0) {
+        memmove(state->rs.sbuf.data, state->rs.sbuf.data + end, rest);
+    }
+    state->rs.sbuf.size = rest;
+    state->chunk_start -= end;
+    state->buffered_rows -= rows;
+    for (MsgpackStreamCut& cut : state->cuts) {
+        cut.end -= end;
+    }
+    return result;
 }
 
 /*
- * msgpack_build_object - Build a MessagePack object from variadic key/value args.
- * Mirrors json_build_object semantics at SQL layer.
+ * msgpack_stream - Run a query and return its rows as MessagePack arrays of
+ * row maps, starting a new chunk once a chunk reaches chunk_bytes.
  */
 extern "C" Datum
-msgpack_build_object(PG_FUNCTION_ARGS)
+msgpack_stream(PG_FUNCTION_ARGS)
 {
-    const int nargs = PG_NARGS();
-    if ((nargs % 2) != 0) {
-        ereport(ERROR,
-                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-                 errmsg("msgpack_build_object requires an even number of arguments")));
-    }
-
-    z::dyn::Value::Map entries;
-    entries.reserve(static_cast<size_t>(nargs / 2));
+    FuncCallContext* funcctx;
 
-    for (int i = 0; i < nargs; i += 2) {
-        if (PG_ARGISNULL(i)) {
+    if (SRF_IS_FIRSTCALL()) {
+        char* query = text_to_cstring(PG_GETARG_TEXT_PP(0));
+        int32 chunk_bytes = PG_GETARG_INT32(1);
+        if (chunk_bytes <= 0) {
             ereport(ERROR,
-                    (errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
-                     errmsg("msgpack_build_object key must not be null")));
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("chunk_bytes must be greater than zero")));
+        }
+
+        funcctx = SRF_FIRSTCALL_INIT();
+        MemoryContext old_context = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+        void* mem = palloc(sizeof(MsgpackStreamState));
+        MsgpackStreamState* state = new (mem) MsgpackStreamState();
+        state->cleanup.func = msgpack_stream_state_cleanup;
+        state->cleanup.arg = state;
+        MemoryContextRegisterResetCallback(funcctx->multi_call_memory_ctx, &state->cleanup);
+        state->chunk_bytes = static_cast<size_t>(chunk_bytes);
+        state->chunk_start = 0;
+        state->buffered_rows = 0;
+        state->cut_rows = 0;
+        state->exhausted = false;
+        MemoryContextSwitchTo(old_context);
+
+        if (SPI_connect() != SPI_OK_CONNECT) {
+            ereport(ERROR,
+                    (errcode(ERRCODE_INTERNAL_ERROR),
+                     errmsg("msgpack_stream could not connect to SPI")));
         }
-
-        Oid key_typid = get_fn_expr_argtype(fcinfo->flinfo, i);
-        if (!OidIsValid(key_typid)) {
-            key_typid = TEXTOID;
+        SPIPlanPtr plan = SPI_prepare(query, 0, nullptr);
+        if (plan == nullptr) {
+            ereport(ERROR,
+                    (errcode(ERRCODE_INTERNAL_ERROR),
+                     errmsg("msgpack_stream could not prepare query: %s",
+                            SPI_result_code_string(SPI_result))));
         }
-        std::string key = datum_to_string_output(PG_GETARG_DATUM(i), key_typid);
+        // The portal outlives this SPI connection; later calls find it by name.
+        Portal portal = SPI_cursor_open(nullptr, plan, nullptr, nullptr, false);
+        state->portal_name = MemoryContextStrdup(funcctx->multi_call_memory_ctx, portal->name);
+        SPI_finish();
 
-        Oid val_typid = get_fn_expr_argtype(fcinfo->flinfo, i + 1);
-        if (!OidIsValid(val_typid)) {
-            val_typid = TEXTOID;
-        }
-        Datum val = (i + 1 < nargs && !PG_ARGISNULL(i + 1)) ? PG_GETARG_DATUM(i + 1) : (Datum) 0;
-        entries.emplace_back(std::move(key), datum_to_dynamic(val, val_typid, PG_ARGISNULL(i + 1)));
+        funcctx->user_fctx = state;
     }
 
-    bytea* result = dynamic_to_msgpack_binary(z::dyn::Value::map(std::move(entries)));
-    PG_RETURN_BYTEA_P(result);
-}
+    funcctx = SRF_PERCALL_SETUP();
+    auto* state = static_cast<MsgpackStreamState*>(funcctx->user_fctx);
 
-/*
- * msgpack_build_array - Build a MessagePack array from variadic arguments.
- * Mirrors json_build_array semantics at SQL layer.
- */
-extern "C" Datum
-msgpack_build_array(PG_FUNCTION_ARGS)
-{
-    const int nargs = PG_NARGS();
-    z::dyn::Value::Array arr;
-    arr.reserve(static_cast<size_t>(nargs));
+    while (state->cuts.empty() && !state->exhausted) {
+        msgpack_stream_fetch(state);
+    }
 
-    for (int i = 0; i < nargs; i++) {
-        Oid typid = get_fn_expr_argtype(fcinfo->flinfo, i);
-        if (!OidIsValid(typid)) {
-            typid = TEXTOID;
-        }
-        Datum val = (!PG_ARGISNULL(i)) ? PG_GETARG_DATUM(i) : (Datum) 0;
-        arr.push_back(datum_to_dynamic(val, typid, PG_ARGISNULL(i)));
+    bytea* chunk = nullptr;
+    if (!state->cuts.empty()) {
+        const MsgpackStreamCut cut = state->cuts.front();
+        state->cuts.erase(state->cuts.begin());
+        chunk = msgpack_stream_take(state, cut.end, cut.rows);
+    } else if (state->buffered_rows > 0) {
+        chunk = msgpack_stream_take(state, state->rs.sbuf.size, state->buffered_rows);
+        state->cut_rows = 0;
     }
 
-    bytea* result = dynamic_to_msgpack_binary(z::dyn::Value::array(std::move(arr)));
-    PG_RETURN_BYTEA_P(result);
+    if (chunk == nullptr) {
+        if (SPI_connect() == SPI_OK_CONNECT) {
+            Portal portal = SPI_cursor_find(state->portal_name);
+            if (portal != nullptr) {
+                SPI_cursor_close(portal);
+            }
+            SPI_finish();
+        }
+        SRF_RETURN_DONE(funcctx);
+    }
+    SRF_RETURN_NEXT(funcctx, PointerGetDatum(chunk));
 }
 
 /*
- * msgpack_agg_final - Finalize jsonb_agg state and convert to MessagePack.
+ * pg_zerialize_stats - List the path and schema cache counters, one row per
+ * metric. Path metrics carry their protocol and entry point; cache metrics
+ * leave both NULL. With shared, the counters are the aggregate of every
+ * backend's finished transactions plus this backend's unflushed part.
  */
 extern "C" Datum
-msgpack_agg_final(PG_FUNCTION_ARGS)
+pg_zerialize_stats(PG_FUNCTION_ARGS)
 {
-    if (PG_ARGISNULL(0)) {
-        PG_RETURN_NULL();
+    const bool shared = PG_GETARG_BOOL(0);
+    if (shared && shared_stats == nullptr) {
+        ereport(ERROR,
+                (errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+                 errmsg("cluster-wide pg_zerialize statistics require shared_preload_libraries"),
+                 errhint("Add pg_zerialize to shared_preload_libraries and restart the server.")));
     }
-    Datum agg = DirectFunctionCall1(jsonb_agg_finalfn, PG_GETARG_DATUM(0));
-    if (DatumGetPointer(agg) == nullptr) {
-        PG_RETURN_NULL();
+
+    InitMaterializedSRF(fcinfo, 0);
+    ReturnSetInfo* rsinfo = (ReturnSetInfo*) fcinfo->resultinfo;
+
+    auto emit = [rsinfo, shared](size_t index, const char* metric, const char* protocol,
+                                 const char* entry_point) {
+        uint64 value = stats_counters[index];
+        if (shared) {
+            value += pg_atomic_read_u64(&shared_stats->counters[index]) - stats_flushed[index];
+        }
+
+        Datum values[4];
+        bool nulls[4] = {false, protocol == nullptr, entry_point == nullptr, false};
+        values[0] = CStringGetTextDatum(metric);
+        values[1] = protocol != nullptr ? CStringGetTextDatum(protocol) : (Datum) 0;
+        values[2] = entry_point != nullptr ? CStringGetTextDatum(entry_point) : (Datum) 0;
+        values[3] = Int64GetDatum(static_cast<int64>(value));
+        tuplestore_putvalues(rsinfo->setResult, rsinfo->setDesc, values, nulls);
+    };
+
+    for (size_t p = 0; p < kStatsProtocols; p++) {
+        for (size_t e = 0; e < kStatsEntryPoints; e++) {
+            for (size_t m = 0; m < kStatsPathMetrics; m++) {
+                emit(stats_path_index(static_cast<StatsProtocol>(p),
+                                      static_cast<StatsEntryPoint>(e),
+                                      static_cast<StatsPathMetric>(m)),
+                     kStatsPathMetricNames[m], kStatsProtocolNames[p], kStatsEntryPointNames[e]);
+            }
+        }
     }
-    Jsonb* jb = DatumGetJsonbP(agg);
-    z::dyn::Value v = jsonb_to_dynamic(jb);
-    bytea* result = dynamic_to_msgpack_binary(v);
-    PG_RETURN_BYTEA_P(result);
+    for (size_t m = 0; m < std::size(kStatsCacheMetricNames); m++) {
+        emit(kStatsPathCounters + m, kStatsCacheMetricNames[m], nullptr, nullptr);
+    }
+
+    return (Datum) 0;
 }
 
 /*
- * msgpack_object_agg_final - Finalize jsonb_object_agg state and convert.
+ * pg_zerialize_stats_reset - Zero this backend's counters. Growth not yet
+ * flushed is folded into the shared aggregate first, which is never reset.
  */
 extern "C" Datum
-msgpack_object_agg_final(PG_FUNCTION_ARGS)
+pg_zerialize_stats_reset(PG_FUNCTION_ARGS)
 {
-    if (PG_ARGISNULL(0)) {
-        PG_RETURN_NULL();
-    }
-    Datum agg = DirectFunctionCall1(jsonb_object_agg_finalfn, PG_GETARG_DATUM(0));
-    if (DatumGetPointer(agg) == nullptr) {
-        PG_RETURN_NULL();
+    (void)fcinfo;
+    if (shared_stats != nullptr) {
+        stats_flush();
     }
-    Jsonb* jb = DatumGetJsonbP(agg);
-    z::dyn::Value v = jsonb_to_dynamic(jb);
-    bytea* result = dynamic_to_msgpack_binary(v);
-    PG_RETURN_BYTEA_P(result);
+    memset(stats_counters, 0, sizeof(stats_counters));
+    memset(stats_flushed, 0, sizeof(stats_flushed));
+    PG_RETURN_VOID();
 }
 
 /*
- * row_to_cbor - Convert PostgreSQL record to CBOR binary format
+ * pg_zerialize_schema_cache - List this backend's cached row schemas with
+ * their fast-path flags. A flag covers the schema's own columns; nested
+ * composites are checked when a record is written.
  */
 extern "C" Datum
-row_to_cbor(PG_FUNCTION_ARGS)
-{
-    HeapTupleHeader rec;
-    bytea* result;
+pg_zerialize_schema_cache(PG_FUNCTION_ARGS)
+{
+    InitMaterializedSRF(fcinfo, 0);
+    ReturnSetInfo* rsinfo = (ReturnSetInfo*) fcinfo->resultinfo;
+
+    auto emit = [rsinfo](const CachedSchema& schema, bool projected) {
+        Datum* names = (Datum*) palloc(sizeof(Datum) * std::max<size_t>(schema.columns.size(), 1));
+        int fallback_columns = 0;
+        for (size_t i = 0; i < schema.columns.size(); i++) {
+            const CachedColumn& col = schema.columns[i];
+            names[i] = CStringGetTextDatum(col.name.c_str());
+            if (col.kind == ConverterKind::Fallback ||
+                (col.kind == ConverterKind::Array &&
+                 col.array_element_kind == ConverterKind::Fallback)) {
+                fallback_columns++;
+            }
+        }
 
-    // Get the record argument
-    rec = PG_GETARG_HEAPTUPLEHEADER(0);
+        Datum values[10];
+        bool nulls[10] = {};
+        values[0] = ObjectIdGetDatum(schema.tupdesc->tdtypeid);
+        values[1] = Int32GetDatum(schema.tupdesc->tdtypmod);
+        values[2] = BoolGetDatum(projected);
+        values[3] = PointerGetDatum(
+            construct_array_builtin(names, static_cast<int>(schema.columns.size()), TEXTOID));
+        values[4] = Int32GetDatum(fallback_columns);
+        values[5] = BoolGetDatum(schema.has_recursive_columns);
+        values[6] = BoolGetDatum(schema.msgpack_fast_supported);
+        values[7] = BoolGetDatum(schema.cbor_fast_supported);
+        values[8] = BoolGetDatum(schema.zera_fast_supported);
+        values[9] = BoolGetDatum(schema.flex_fast_supported);
+        tuplestore_putvalues(rsinfo->setResult, rsinfo->setDesc, values, nulls);
+    };
 
-    // Convert to CBOR
-    result = tuple_to_binary<z::CBOR>(rec);
+    for (const auto& entry : schema_cache) {
+        emit(entry.second, false);
+    }
+    for (const auto& entry : projection_cache) {
+        emit(entry.second, true);
+    }
 
-    PG_RETURN_BYTEA_P(result);
+    return (Datum) 0;
 }
 
 /*
- * row_to_zera - Convert PostgreSQL record to ZERA binary format
+ * Logical decoding output plugin
+ *
+ * pg_zerialize_decoding forwards its plugin registration here, so change
+ * records share the row writers and the schema cache. Every record is its own
+ * message: a map with an "action" key of B (begin), C (commit), I, U, D, or T
+ * (truncate). Row changes carry "schema" and "table", the new row as "new",
+ * and the old row or its replica identity columns as "old".
  */
-extern "C" Datum
-row_to_zera(PG_FUNCTION_ARGS)
-{
-    HeapTupleHeader rec;
-    bytea* result;
 
-    // Get the record argument
-    rec = PG_GETARG_HEAPTUPLEHEADER(0);
+enum DecodingFormat {
+    DECODING_FORMAT_MSGPACK = 0,
+    DECODING_FORMAT_CBOR = 1,
+    DECODING_FORMAT_ZERA = 2,
+    DECODING_FORMAT_FLEX = 3,
+};
 
-    // Convert to ZERA
-    result = tuple_to_binary<z::Zera>(rec);
+struct DecodingData {
+    MemoryContext context;
+    DecodingFormat format;
+    bool include_transaction;
+    bool include_xids;
+    bool include_timestamp;
+};
 
-    PG_RETURN_BYTEA_P(result);
+/* One side of a row change, formed as a composite datum of the table rowtype. */
+struct DecodingTuple {
+    HeapTupleHeader rec = nullptr;
+    const CachedSchema* schema = nullptr;
+    const ColumnProjection* projection = nullptr;
+    std::vector<std::string_view> unchanged;
+};
+
+#if PG_VERSION_NUM >= 170000
+static inline HeapTuple decoding_change_tuple(HeapTuple tuple)
+{
+    return tuple;
+}
+#else
+static inline HeapTuple decoding_change_tuple(ReorderBufferTupleBuf* tuple)
+{
+    return tuple != nullptr ? &tuple->tuple : nullptr;
 }
+#endif
 
 /*
- * Batch processing functions (multiple records at once)
+ * Rebuild a decoded heap tuple as a datum the row writers can read. TOAST
+ * values the change did not log are still on-disk pointers; they become NULL
+ * and are listed in *unchanged. Reassembled values are flattened.
  */
+static HeapTupleHeader decoding_form_tuple(
+    Relation relation, HeapTuple tuple, std::vector<std::string_view>* unchanged)
+{
+    TupleDesc tupdesc = RelationGetDescr(relation);
+    const int natts = tupdesc->natts;
+    Datum* values = (Datum*) palloc(natts * sizeof(Datum));
+    bool* nulls = (bool*) palloc(natts * sizeof(bool));
+
+    heap_deform_tuple(tuple, tupdesc, values, nulls);
+    for (int i = 0; i < natts; i++) {
+        Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
+        if (attr->attisdropped || attr->attlen != -1 || nulls[i]) {
+            continue;
+        }
+        struct varlena* datum = (struct varlena*) DatumGetPointer(values[i]);
+        if (VARATT_IS_EXTERNAL_ONDISK(datum)) {
+            nulls[i] = true;
+            if (unchanged != nullptr) {
+                unchanged->emplace_back(NameStr(attr->attname));
+            }
+        } else if (VARATT_IS_EXTERNAL(datum)) {
+            values[i] = PointerGetDatum(detoast_external_attr(datum));
+        }
+    }
+
+    return heap_form_tuple(tupdesc, values, nulls)->t_data;
+}
 
 /*
- * rows_to_flexbuffers - Convert array of PostgreSQL records to FlexBuffers binary format
+ * Collect the replica identity columns of a relation in attribute order.
+ * Returns false for REPLICA IDENTITY FULL, whose old rows are written whole.
  */
-extern "C" Datum
-rows_to_flexbuffers(PG_FUNCTION_ARGS)
+static bool decoding_identity_projection(Relation relation, ColumnProjection* projection)
 {
-    ArrayType* arr;
-    bytea* result;
-
-    // Get the array argument
-    arr = PG_GETARG_ARRAYTYPE_P(0);
+    if (relation->rd_rel->relreplident == REPLICA_IDENTITY_FULL) {
+        return false;
+    }
 
-    // Convert to FlexBuffers array
-    result = array_to_binary<z::Flex>(arr);
+    TupleDesc tupdesc = RelationGetDescr(relation);
+    Bitmapset* identity = RelationGetIndexAttrBitmap(relation, INDEX_ATTR_BITMAP_IDENTITY_KEY);
+    int member = -1;
+    while ((member = bms_next_member(identity, member)) >= 0) {
+        AttrNumber attnum = member + FirstLowInvalidHeapAttributeNumber;
+        if (attnum <= 0) {
+            continue;
+        }
+        const char* name = NameStr(TupleDescAttr(tupdesc, attnum - 1)->attname);
+        if (!projection->names.empty()) {
+            projection->key.push_back('\0');
+        }
+        projection->key.append(name);
+        projection->names.emplace_back(name);
+    }
+    bms_free(identity);
 
-    PG_RETURN_BYTEA_P(result);
+    return !projection->names.empty();
 }
 
-/*
- * rows_to_msgpack - Convert array of PostgreSQL records to MessagePack binary format
- */
-extern "C" Datum
-rows_to_msgpack(PG_FUNCTION_ARGS)
+template<typename Root, typename Writer, typename Body>
+static void decoding_serialize_root(StringInfo out, Body& body)
 {
-    ArrayType* arr;
-    bytea* result;
+    Root rs;
+    Writer writer(rs);
+    body(writer);
+    z::ZBuffer buffer = rs.finish();
+    std::span<const uint8_t> data = buffer.buf();
+    appendBinaryStringInfo(out, reinterpret_cast<const char*>(data.data()),
+                           static_cast<int>(data.size()));
+}
 
-    // Get the array argument
-    arr = PG_GETARG_ARRAYTYPE_P(0);
+/* Write one record as its own message in the slot's format. */
+template<typename Body>
+static void decoding_emit(LogicalDecodingContext* ctx, Body&& body)
+{
+    DecodingData* data = (DecodingData*) ctx->output_plugin_private;
 
-    // Convert to MessagePack array
-    result = array_to_binary<z::MsgPack>(arr);
+    OutputPluginPrepareWrite(ctx, true);
+    try {
+        switch (data->format) {
+            case DECODING_FORMAT_MSGPACK: {
+                z::MsgPackRootSerializer& rs = msgpack_reusable_root();
+                msgpack_sbuffer_clear(&rs.sbuf);
+                z::MsgPackSerializer writer(rs);
+                body(writer);
+                appendBinaryStringInfo(ctx->out, rs.sbuf.data, static_cast<int>(rs.sbuf.size));
+                msgpack_sbuffer_clear(&rs.sbuf);
+                break;
+            }
+            case DECODING_FORMAT_CBOR:
+                decoding_serialize_root<z::cborjc::RootSerializer, z::cborjc::Serializer>(
+                    ctx->out, body);
+                break;
+            case DECODING_FORMAT_ZERA:
+                decoding_serialize_root<z::zera::RootSerializer, z::zera::Serializer>(
+                    ctx->out, body);
+                break;
+            case DECODING_FORMAT_FLEX:
+                decoding_serialize_root<z::flex::RootSerializer, z::flex::Serializer>(
+                    ctx->out, body);
+                break;
+        }
+    } catch (const std::exception& ex) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("logical decoding record serialization failed"),
+                 errdetail("%s", ex.what())));
+    } catch (...) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("logical decoding record serialization failed with unknown exception")));
+    }
+    OutputPluginWrite(ctx, true);
+}
+
+static void pgz_decode_startup(
+    LogicalDecodingContext* ctx, OutputPluginOptions* opt, bool is_init)
+{
+    (void)is_init;
+
+    DecodingData* data = (DecodingData*) palloc0(sizeof(DecodingData));
+    data->context = AllocSetContextCreate(ctx->context,
+                                          "pg_zerialize decoding context",
+                                          ALLOCSET_DEFAULT_SIZES);
+    data->format = DECODING_FORMAT_MSGPACK;
+    data->include_transaction = true;
+    data->include_xids = false;
+    data->include_timestamp = false;
+
+    ListCell* option;
+    foreach(option, ctx->output_plugin_options) {
+        DefElem* elem = (DefElem*) lfirst(option);
+
+        if (strcmp(elem->defname, "format") == 0) {
+            const char* value = defGetString(elem);
+            if (strcmp(value, "msgpack") == 0) {
+                data->format = DECODING_FORMAT_MSGPACK;
+            } else if (strcmp(value, "cbor") == 0) {
+                data->format = DECODING_FORMAT_CBOR;
+            } else if (strcmp(value, "zera") == 0) {
+                data->format = DECODING_FORMAT_ZERA;
+            } else if (strcmp(value, "flexbuffers") == 0) {
+                data->format = DECODING_FORMAT_FLEX;
+            } else {
+                ereport(ERROR,
+                        (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                         errmsg("invalid value for option \"format\": \"%s\"", value),
+                         errhint("Valid values are \"msgpack\", \"cbor\", \"zera\", and \"flexbuffers\".")));
+            }
+        } else if (strcmp(elem->defname, "include-transaction") == 0) {
+            data->include_transaction = defGetBoolean(elem);
+        } else if (strcmp(elem->defname, "include-xids") == 0) {
+            data->include_xids = defGetBoolean(elem);
+        } else if (strcmp(elem->defname, "include-timestamp") == 0) {
+            data->include_timestamp = defGetBoolean(elem);
+        } else {
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("option \"%s\" is unknown to pg_zerialize_decoding",
+                            elem->defname)));
+        }
+    }
 
-    PG_RETURN_BYTEA_P(result);
+    ctx->output_plugin_private = data;
+    opt->output_type = OUTPUT_PLUGIN_BINARY_OUTPUT;
+    opt->receive_rewrites = false;
 }
 
-/*
- * rows_to_msgpack_slow - Convert array of records via generic dynamic path
- * Useful for parity/correctness testing against fast path.
- */
-extern "C" Datum
-rows_to_msgpack_slow(PG_FUNCTION_ARGS)
+static void pgz_decode_shutdown(LogicalDecodingContext* ctx)
 {
-    ArrayType* arr;
-    bytea* result;
-
-    arr = PG_GETARG_ARRAYTYPE_P(0);
-    result = array_to_binary_slow<z::MsgPack>(arr);
-    PG_RETURN_BYTEA_P(result);
+    DecodingData* data = (DecodingData*) ctx->output_plugin_private;
+    MemoryContextDelete(data->context);
 }
 
-/*
- * rows_to_cbor - Convert array of PostgreSQL records to CBOR binary format
- */
-extern "C" Datum
-rows_to_cbor(PG_FUNCTION_ARGS)
+static void pgz_decode_begin(LogicalDecodingContext* ctx, ReorderBufferTXN* txn)
 {
-    ArrayType* arr;
-    bytea* result;
+    DecodingData* data = (DecodingData*) ctx->output_plugin_private;
+    if (!data->include_transaction) {
+        return;
+    }
 
-    // Get the array argument
-    arr = PG_GETARG_ARRAYTYPE_P(0);
+    decoding_emit(ctx, [&](auto& writer) {
+        writer.begin_map(data->include_xids ? 2 : 1);
+        writer.key("action");
+        writer.string("B");
+        if (data->include_xids) {
+            writer.key("xid");
+            writer.uint64(txn->xid);
+        }
+        writer.end_map();
+    });
+}
 
-    // Convert to CBOR array
-    result = array_to_binary<z::CBOR>(arr);
+static void pgz_decode_commit(
+    LogicalDecodingContext* ctx, ReorderBufferTXN* txn, XLogRecPtr commit_lsn)
+{
+    DecodingData* data = (DecodingData*) ctx->output_plugin_private;
+    (void)commit_lsn;
+    if (!data->include_transaction) {
+        return;
+    }
 
-    PG_RETURN_BYTEA_P(result);
+    decoding_emit(ctx, [&](auto& writer) {
+        writer.begin_map(1 + (data->include_xids ? 1 : 0) + (data->include_timestamp ? 1 : 0));
+        writer.key("action");
+        writer.string("C");
+        if (data->include_xids) {
+            writer.key("xid");
+            writer.uint64(txn->xid);
+        }
+        if (data->include_timestamp) {
+            writer.key("commit_time");
+            writer.int64(static_cast<int64_t>(txn->xact_time.commit_time));
+        }
+        writer.end_map();
+    });
 }
 
-/*
- * rows_to_zera - Convert array of PostgreSQL records to ZERA binary format
- */
-extern "C" Datum
-rows_to_zera(PG_FUNCTION_ARGS)
+static void pgz_decode_change(
+    LogicalDecodingContext* ctx,
+    ReorderBufferTXN* txn,
+    Relation relation,
+    ReorderBufferChange* change)
 {
-    ArrayType* arr;
-    bytea* result;
+    DecodingData* data = (DecodingData*) ctx->output_plugin_private;
+    (void)txn;
+    schema_cache_begin_scope();
 
-    // Get the array argument
-    arr = PG_GETARG_ARRAYTYPE_P(0);
+    const char* action;
+    switch (change->action) {
+        case REORDER_BUFFER_CHANGE_INSERT:
+            action = "I";
+            break;
+        case REORDER_BUFFER_CHANGE_UPDATE:
+            action = "U";
+            break;
+        case REORDER_BUFFER_CHANGE_DELETE:
+            action = "D";
+            break;
+        default:
+            return;
+    }
 
-    // Convert to ZERA array
-    result = array_to_binary<z::Zera>(arr);
+    MemoryContext old_context = MemoryContextSwitchTo(data->context);
+
+    const Oid reltype = relation->rd_rel->reltype;
+    const CachedSchema& schema = get_cached_schema(reltype, -1);
+    const char* nspname = get_namespace_name(RelationGetNamespace(relation));
+    const char* relname = RelationGetRelationName(relation);
+
+    DecodingTuple new_side;
+    HeapTuple newtuple = decoding_change_tuple(change->data.tp.newtuple);
+    if (newtuple != nullptr) {
+        new_side.rec = decoding_form_tuple(relation, newtuple, &new_side.unchanged);
+        new_side.schema = &schema;
+    }
+
+    DecodingTuple old_side;
+    ColumnProjection identity;
+    HeapTuple oldtuple = decoding_change_tuple(change->data.tp.oldtuple);
+    if (oldtuple != nullptr) {
+        old_side.rec = decoding_form_tuple(relation, oldtuple, nullptr);
+        old_side.schema = &schema;
+        if (decoding_identity_projection(relation, &identity)) {
+            old_side.projection = &identity;
+            old_side.schema = &get_projected_schema(reltype, -1, identity);
+        }
+    }
+
+    decoding_emit(ctx, [&](auto& writer) {
+        writer.begin_map(3 + (new_side.rec != nullptr ? 1 : 0) +
+                         (old_side.rec != nullptr ? 1 : 0) +
+                         (!new_side.unchanged.empty() ? 1 : 0));
+        writer.key("action");
+        writer.string(action);
+        writer.key("schema");
+        writer.string(nspname);
+        writer.key("table");
+        writer.string(relname);
+        if (new_side.rec != nullptr) {
+            writer.key("new");
+            write_record_any(writer, new_side.rec, *new_side.schema, new_side.projection);
+        }
+        if (old_side.rec != nullptr) {
+            writer.key("old");
+            write_record_any(writer, old_side.rec, *old_side.schema, old_side.projection);
+        }
+        if (!new_side.unchanged.empty()) {
+            writer.key("unchanged");
+            writer.begin_array(new_side.unchanged.size());
+            for (std::string_view name : new_side.unchanged) {
+                writer.string(name);
+            }
+            writer.end_array();
+        }
+        writer.end_map();
+    });
 
-    PG_RETURN_BYTEA_P(result);
+    MemoryContextSwitchTo(old_context);
+    MemoryContextReset(data->context);
+}
+
+static void pgz_decode_truncate(
+    LogicalDecodingContext* ctx,
+    ReorderBufferTXN* txn,
+    int nrelations,
+    Relation relations[],
+    ReorderBufferChange* change)
+{
+    DecodingData* data = (DecodingData*) ctx->output_plugin_private;
+    (void)txn;
+    (void)change;
+
+    MemoryContext old_context = MemoryContextSwitchTo(data->context);
+    for (int i = 0; i < nrelations; i++) {
+        const char* nspname = get_namespace_name(RelationGetNamespace(relations[i]));
+        const char* relname = RelationGetRelationName(relations[i]);
+        decoding_emit(ctx, [&](auto& writer) {
+            writer.begin_map(3);
+            writer.key("action");
+            writer.string("T");
+            writer.key("schema");
+            writer.string(nspname);
+            writer.key("table");
+            writer.string(relname);
+            writer.end_map();
+        });
+    }
+    MemoryContextSwitchTo(old_context);
+    MemoryContextReset(data->context);
+}
+
+extern "C" void
+_PG_output_plugin_init(OutputPluginCallbacks* cb)
+{
+    cb->startup_cb = pgz_decode_startup;
+    cb->begin_cb = pgz_decode_begin;
+    cb->change_cb = pgz_decode_change;
+    cb->truncate_cb = pgz_decode_truncate;
+    cb->commit_cb = pgz_decode_commit;
+    cb->shutdown_cb = pgz_decode_shutdown;
 }
@@ -0,0 +1,27 @@
+/*
+ * pg_zerialize_decoding.cpp
+ * Logical decoding output plugin emitting pg_zerialize change records
+ *
+ * The plugin is implemented in pg_zerialize so that it shares the row
+ * writers, GUCs, and schema cache; this module only forwards registration.
+ */
+
+extern "C" {
+#include "postgres.h"
+#include "fmgr.h"
+#include "replication/output_plugin.h"
+
+#ifdef PG_MODULE_MAGIC
+PG_MODULE_MAGIC;
+#endif
+}
+
+typedef void (*OutputPluginInitFn)(OutputPluginCallbacks* cb);
+
+extern "C" void
+_PG_output_plugin_init(OutputPluginCallbacks* cb)
+{
+    OutputPluginInitFn init = reinterpret_cast<OutputPluginInitFn>(
+        load_external_function("$libdir/pg_zerialize", "_PG_output_plugin_init", true, nullptr));
+    init(cb);
+}
@@ -0,0 +1,652 @@
+/*
+ * pg_zerialize_kernels.hpp
+ * Server-independent MessagePack encoding kernels
+ *
+ * The integer encoder, the bulk array kernels, and the sequence writers the
+ * fast paths use for pass-by-value arrays. They touch no backend state beyond
+ * c.h's typedefs, so bench/native/bench_serializers builds them without a
+ * running server. pg_zerialize.cpp is the only other includer.
+ */
+
+#ifndef PG_ZERIALIZE_KERNELS_HPP
+#define PG_ZERIALIZE_KERNELS_HPP
+
+extern "C" {
+#include "postgres.h"
+}
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+#include <zerialize/protocols/msgpack.hpp>
+
+namespace z = zerialize;
+
+/* Backs pg_zerialize.simd; the serializer bench flips it to time both paths. */
+static bool simd_kernels_enabled = true;
+
+static inline void msgpack_store_be16(uint8_t* out, uint16_t value)
+{
+    out[0] = static_cast<uint8_t>(value >> 8);
+    out[1] = static_cast<uint8_t>(value);
+}
+
+static inline void msgpack_store_be32(uint8_t* out, uint32_t value)
+{
+    out[0] = static_cast<uint8_t>(value >> 24);
+    out[1] = static_cast<uint8_t>(value >> 16);
+    out[2] = static_cast<uint8_t>(value >> 8);
+    out[3] = static_cast<uint8_t>(value);
+}
+
+static inline void msgpack_store_be64(uint8_t* out, uint64_t value)
+{
+    msgpack_store_be32(out, static_cast<uint32_t>(value >> 32));
+    msgpack_store_be32(out + 4, static_cast<uint32_t>(value));
+}
+
+static inline uint8_t* msgpack_encode_int64(uint8_t* out, int64_t value)
+{
+    if (value >= 0) {
+        uint64_t unsigned_value = static_cast<uint64_t>(value);
+        if (unsigned_value <= 0x7f) {
+            *out++ = static_cast<uint8_t>(unsigned_value);
+        } else if (unsigned_value <= UINT8_MAX) {
+            *out++ = 0xcc;
+            *out++ = static_cast<uint8_t>(unsigned_value);
+        } else if (unsigned_value <= UINT16_MAX) {
+            *out++ = 0xcd;
+            msgpack_store_be16(out, static_cast<uint16_t>(unsigned_value));
+            out += 2;
+        } else if (unsigned_value <= UINT32_MAX) {
+            *out++ = 0xce;
+            msgpack_store_be32(out, static_cast<uint32_t>(unsigned_value));
+            out += 4;
+        } else {
+            *out++ = 0xcf;
+            msgpack_store_be64(out, unsigned_value);
+            out += 8;
+        }
+    } else if (value >= -32) {
+        *out++ = static_cast<uint8_t>(value);
+    } else if (value >= INT8_MIN) {
+        *out++ = 0xd0;
+        *out++ = static_cast<uint8_t>(value);
+    } else if (value >= INT16_MIN) {
+        *out++ = 0xd1;
+        msgpack_store_be16(out, static_cast<uint16_t>(value));
+        out += 2;
+    } else if (value >= INT32_MIN) {
+        *out++ = 0xd2;
+        msgpack_store_be32(out, static_cast<uint32_t>(value));
+        out += 4;
+    } else {
+        *out++ = 0xd3;
+        msgpack_store_be64(out, static_cast<uint64_t>(value));
+        out += 8;
+    }
+    return out;
+}
+
+/*
+ * Bulk kernels for no-null int4/int8/float8 arrays.
+ *
+ * MessagePack writes every integer in its smallest form, so the integer path
+ * first scans the array's range. When the minimum and maximum land in the same
+ * encoding class, every element shares one marker and payload width and the
+ * array is written in bulk; otherwise the per-value encoder runs. float8
+ * elements are always 0xcb plus eight big-endian bytes. Output is identical
+ * to the per-value encoder either way.
+ *
+ * The x86 tier is chosen once per backend from the running CPU; AArch64
+ * always has NEON. pg_zerialize.simd = off keeps the per-value encoders.
+ */
+struct MsgpackArrayKernels {
+    void (*range_int32)(const int32* values, int nitems, int64* lo, int64* hi);
+    void (*range_int64)(const int64* values, int nitems, int64* lo, int64* hi);
+    // Writes nitems elements of src_width bytes each as marker (when nonzero)
+    // plus the low width bytes big-endian. May write up to
+    // kMsgpackKernelSlack bytes past the returned end.
+    uint8_t* (*emit)(uint8_t* out, const void* values, int nitems, int src_width,
+                     uint8_t marker, int width);
+};
+
+static constexpr int kMsgpackKernelMinItems = 16;
+static constexpr size_t kMsgpackKernelSlack = 16;
+
+/*
+ * Sets marker and width when every value in [lo, hi] has the same MessagePack
+ * integer encoding. Fixints carry no marker and report marker 0.
+ */
+static inline bool msgpack_uniform_int_encoding(int64 lo, int64 hi, uint8_t* marker, int* width)
+{
+    if (lo >= -32 && hi <= 0x7f) {
+        *marker = 0;
+        *width = 1;
+        return true;
+    }
+    if (lo >= 0) {
+        const uint64 ulo = static_cast<uint64>(lo);
+        const uint64 uhi = static_cast<uint64>(hi);
+        if (uhi <= UINT8_MAX) {
+            *marker = 0xcc;
+            *width = 1;
+            return ulo > 0x7f;
+        }
+        if (uhi <= UINT16_MAX) {
+            *marker = 0xcd;
+            *width = 2;
+            return ulo > UINT8_MAX;
+        }
+        if (uhi <= UINT32_MAX) {
+            *marker = 0xce;
+            *width = 4;
+            return ulo > UINT16_MAX;
+        }
+        *marker = 0xcf;
+        *width = 8;
+        return ulo > UINT32_MAX;
+    }
+    if (hi < 0) {
+        if (lo >= INT8_MIN) {
+            *marker = 0xd0;
+            *width = 1;
+            return hi < -32;
+        }
+        if (lo >= INT16_MIN) {
+            *marker = 0xd1;
+            *width = 2;
+            return hi < INT8_MIN;
+        }
+        if (lo >= INT32_MIN) {
+            *marker = 0xd2;
+            *width = 4;
+            return hi < INT16_MIN;
+        }
+        *marker = 0xd3;
+        *width = 8;
+        return hi < INT32_MIN;
+    }
+    return false;
+}
+
+// Fixints are the low byte of each little-endian element.
+static inline uint8_t* msgpack_emit_fixint_tail(uint8_t* out, const uint8_t* src, int nitems,
+                                                int src_width)
+{
+    for (int i = 0; i < nitems; i++, src += src_width) {
+        *out++ = *src;
+    }
+    return out;
+}
+
+/*
+ * Byte shuffle that turns one little-endian element in the low bytes of a
+ * 16-byte register into payload-width big-endian bytes, leaving the first
+ * byte free for the marker when there is one. Indexes with the high bit set
+ * select zero for both pshufb and TBL.
+ */
+static inline void msgpack_emit_shuffle(uint8_t shuffle[16], bool marked, int width)
+{
+    std::memset(shuffle, 0x80, 16);
+    const int head = marked ? 1 : 0;
+    for (int b = 0; b < width; b++) {
+        shuffle[head + b] = static_cast<uint8_t>(width - 1 - b);
+    }
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PGZ_MSGPACK_KERNELS_X86 1
+
+__attribute__((target("sse4.2")))
+static void msgpack_range_int32_sse42(const int32* values, int nitems, int64* lo, int64* hi)
+{
+    __m128i vmin = _mm_set1_epi32(values[0]);
+    __m128i vmax = vmin;
+    int i = 0;
+    for (; i + 4 <= nitems; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+        vmin = _mm_min_epi32(vmin, v);
+        vmax = _mm_max_epi32(vmax, v);
+    }
+    alignas(16) int32 mins[4];
+    alignas(16) int32 maxs[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(mins), vmin);
+    _mm_store_si128(reinterpret_cast<__m128i*>(maxs), vmax);
+    int32 min_value = std::min(std::min(mins[0], mins[1]), std::min(mins[2], mins[3]));
+    int32 max_value = std::max(std::max(maxs[0], maxs[1]), std::max(maxs[2], maxs[3]));
+    for (; i < nitems; i++) {
+        min_value = std::min(min_value, values[i]);
+        max_value = std::max(max_value, values[i]);
+    }
+    *lo = min_value;
+    *hi = max_value;
+}
+
+__attribute__((target("sse4.2")))
+static void msgpack_range_int64_sse42(const int64* values, int nitems, int64* lo, int64* hi)
+{
+    __m128i vmin = _mm_set1_epi64x(values[0]);
+    __m128i vmax = vmin;
+    int i = 0;
+    for (; i + 2 <= nitems; i += 2) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+        vmin = _mm_blendv_epi8(vmin, v, _mm_cmpgt_epi64(vmin, v));
+        vmax = _mm_blendv_epi8(vmax, v, _mm_cmpgt_epi64(v, vmax));
+    }
+    alignas(16) int64 mins[2];
+    alignas(16) int64 maxs[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(mins), vmin);
+    _mm_store_si128(reinterpret_cast<__m128i*>(maxs), vmax);
+    int64 min_value = std::min(mins[0], mins[1]);
+    int64 max_value = std::max(maxs[0], maxs[1]);
+    for (; i < nitems; i++) {
+        min_value = std::min(min_value, values[i]);
+        max_value = std::max(max_value, values[i]);
+    }
+    *lo = min_value;
+    *hi = max_value;
+}
+
+/*
+ * One shuffle and one unaligned 16-byte store per element; each store's tail
+ * is overwritten by the next element. Fixints (no marker, one byte) pack 16
+ * elements per store instead.
+ */
+__attribute__((target("sse4.2")))
+static uint8_t* msgpack_emit_sse42(uint8_t* out, const void* values, int nitems, int src_width,
+                                   uint8_t marker, int width)
+{
+    const uint8_t* src = static_cast<const uint8_t*>(values);
+    int i = 0;
+    if (marker == 0) {
+        if (src_width == 4) {
+            for (; i + 16 <= nitems; i += 16, src += 64) {
+                const __m128i* p = reinterpret_cast<const __m128i*>(src);
+                __m128i ab = _mm_packs_epi32(_mm_loadu_si128(p), _mm_loadu_si128(p + 1));
+                __m128i cd = _mm_packs_epi32(_mm_loadu_si128(p + 2), _mm_loadu_si128(p + 3));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_packs_epi16(ab, cd));
+                out += 16;
+            }
+        } else {
+            for (; i + 8 <= nitems; i += 8, src += 64) {
+                const __m128i* p = reinterpret_cast<const __m128i*>(src);
+                __m128i ab = _mm_castps_si128(_mm_shuffle_ps(
+                    _mm_castsi128_ps(_mm_loadu_si128(p)),
+                    _mm_castsi128_ps(_mm_loadu_si128(p + 1)), _MM_SHUFFLE(2, 0, 2, 0)));
+                __m128i cd = _mm_castps_si128(_mm_shuffle_ps(
+                    _mm_castsi128_ps(_mm_loadu_si128(p + 2)),
+                    _mm_castsi128_ps(_mm_loadu_si128(p + 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+                __m128i packed = _mm_packs_epi16(_mm_packs_epi32(ab, cd), _mm_setzero_si128());
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(out), packed);
+                out += 8;
+            }
+        }
+        return msgpack_emit_fixint_tail(out, src, nitems - i, src_width);
+    }
+
+    alignas(16) uint8_t shuffle_bytes[16];
+    msgpack_emit_shuffle(shuffle_bytes, true, width);
+    const __m128i shuffle = _mm_load_si128(reinterpret_cast<const __m128i*>(shuffle_bytes));
+    const __m128i head = _mm_cvtsi32_si128(marker);
+    const int stride = 1 + width;
+    if (src_width == 8) {
+        for (; i < nitems; i++, src += 8, out += stride) {
+            __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src));
+            v = _mm_or_si128(_mm_shuffle_epi8(v, shuffle), head);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), v);
+        }
+    } else {
+        for (; i < nitems; i++, src += 4, out += stride) {
+            int32 element;
+            std::memcpy(&element, src, 4);
+            __m128i v = _mm_or_si128(_mm_shuffle_epi8(_mm_cvtsi32_si128(element), shuffle), head);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), v);
+        }
+    }
+    return out;
+}
+
+__attribute__((target("avx2")))
+static void msgpack_range_int32_avx2(const int32* values, int nitems, int64* lo, int64* hi)
+{
+    __m256i vmin = _mm256_set1_epi32(values[0]);
+    __m256i vmax = vmin;
+    int i = 0;
+    for (; i + 8 <= nitems; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+        vmin = _mm256_min_epi32(vmin, v);
+        vmax = _mm256_max_epi32(vmax, v);
+    }
+    __m128i min4 = _mm_min_epi32(_mm256_castsi256_si128(vmin), _mm256_extracti128_si256(vmin, 1));
+    __m128i max4 = _mm_max_epi32(_mm256_castsi256_si128(vmax), _mm256_extracti128_si256(vmax, 1));
+    min4 = _mm_min_epi32(min4, _mm_shuffle_epi32(min4, _MM_SHUFFLE(1, 0, 3, 2)));
+    max4 = _mm_max_epi32(max4, _mm_shuffle_epi32(max4, _MM_SHUFFLE(1, 0, 3, 2)));
+    min4 = _mm_min_epi32(min4, _mm_shuffle_epi32(min4, _MM_SHUFFLE(2, 3, 0, 1)));
+    max4 = _mm_max_epi32(max4, _mm_shuffle_epi32(max4, _MM_SHUFFLE(2, 3, 0, 1)));
+    int32 min_value = _mm_cvtsi128_si32(min4);
+    int32 max_value = _mm_cvtsi128_si32(max4);
+    for (; i < nitems; i++) {
+        min_value = std::min(min_value, values[i]);
+        max_value = std::max(max_value, values[i]);
+    }
+    *lo = min_value;
+    *hi = max_value;
+}
+
+__attribute__((target("avx2")))
+static void msgpack_range_int64_avx2(const int64* values, int nitems, int64* lo, int64* hi)
+{
+    __m256i vmin = _mm256_set1_epi64x(values[0]);
+    __m256i vmax = vmin;
+    int i = 0;
+    for (; i + 4 <= nitems; i += 4) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+        vmin = _mm256_blendv_epi8(vmin, v, _mm256_cmpgt_epi64(vmin, v));
+        vmax = _mm256_blendv_epi8(vmax, v, _mm256_cmpgt_epi64(v, vmax));
+    }
+    alignas(32) int64 mins[4];
+    alignas(32) int64 maxs[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(mins), vmin);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(maxs), vmax);
+    int64 min_value = std::min(std::min(mins[0], mins[1]), std::min(mins[2], mins[3]));
+    int64 max_value = std::max(std::max(maxs[0], maxs[1]), std::max(maxs[2], maxs[3]));
+    for (; i < nitems; i++) {
+        min_value = std::min(min_value, values[i]);
+        max_value = std::max(max_value, values[i]);
+    }
+    *lo = min_value;
+    *hi = max_value;
+}
+
+/*
+ * AVX-512 with VBMI handles every encoding with one byte permute per block:
+ * up to 64 source bytes are rearranged into as many whole output elements as
+ * fit in 64 bytes, and masked loads and stores cover the tail.
+ */
+static inline uint64 msgpack_byte_mask(int nbytes)
+{
+    return nbytes >= 64 ? ~UINT64CONST(0) : (UINT64CONST(1) << nbytes) - 1;
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vbmi")))
+static void msgpack_range_int32_avx512(const int32* values, int nitems, int64* lo, int64* hi)
+{
+    __m512i vmin = _mm512_set1_epi32(values[0]);
+    __m512i vmax = vmin;
+    for (int i = 0; i < nitems; i += 16) {
+        const __mmask16 lanes = static_cast<__mmask16>(msgpack_byte_mask(nitems - i));
+        __m512i v = _mm512_maskz_loadu_epi32(lanes, values + i);
+        vmin = _mm512_mask_min_epi32(vmin, lanes, vmin, v);
+        vmax = _mm512_mask_max_epi32(vmax, lanes, vmax, v);
+    }
+    alignas(64) int32 mins[16];
+    alignas(64) int32 maxs[16];
+    _mm512_store_si512(mins, vmin);
+    _mm512_store_si512(maxs, vmax);
+    *lo = *std::min_element(mins, mins + 16);
+    *hi = *std::max_element(maxs, maxs + 16);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vbmi")))
+static void msgpack_range_int64_avx512(const int64* values, int nitems, int64* lo, int64* hi)
+{
+    __m512i vmin = _mm512_set1_epi64(values[0]);
+    __m512i vmax = vmin;
+    for (int i = 0; i < nitems; i += 8) {
+        const __mmask8 lanes = static_cast<__mmask8>(msgpack_byte_mask(nitems - i));
+        __m512i v = _mm512_maskz_loadu_epi64(lanes, values + i);
+        vmin = _mm512_mask_min_epi64(vmin, lanes, vmin, v);
+        vmax = _mm512_mask_max_epi64(vmax, lanes, vmax, v);
+    }
+    alignas(64) int64 mins[8];
+    alignas(64) int64 maxs[8];
+    _mm512_store_si512(mins, vmin);
+    _mm512_store_si512(maxs, vmax);
+    *lo = *std::min_element(mins, mins + 8);
+    *hi = *std::max_element(maxs, maxs + 8);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vbmi")))
+static uint8_t* msgpack_emit_avx512(uint8_t* out, const void* values, int nitems, int src_width,
+                                    uint8_t marker, int width)
+{
+    const int head = marker != 0 ? 1 : 0;
+    const int stride = head + width;
+    const int per_block = std::min(64 / src_width, 64 / stride);
+    alignas(64) uint8_t index_bytes[64] = {};
+    uint64 marker_lanes = 0;
+    for (int e = 0; e < per_block; e++) {
+        if (head) {
+            marker_lanes |= UINT64CONST(1) << (e * stride);
+        }
+        for (int b = 0; b < width; b++) {
+            index_bytes[e * stride + head + b] = static_cast<uint8_t>(e * src_width + width - 1 - b);
+        }
+    }
+    const __m512i index = _mm512_load_si512(index_bytes);
+    const __m512i markers = _mm512_set1_epi8(static_cast<char>(marker));
+
+    const uint8_t* src = static_cast<const uint8_t*>(values);
+    for (int i = 0; i < nitems; i += per_block) {
+        const int count = std::min(per_block, nitems - i);
+        __m512i v = _mm512_maskz_loadu_epi8(msgpack_byte_mask(count * src_width), src);
+        v = _mm512_maskz_permutexvar_epi8(~UINT64CONST(0), index, v);
+        v = _mm512_mask_mov_epi8(v, marker_lanes, markers);
+        _mm512_mask_storeu_epi8(out, msgpack_byte_mask(count * stride), v);
+        src += count * src_width;
+        out += count * stride;
+    }
+    return out;
+}
+
+static const MsgpackArrayKernels msgpack_kernels_sse42 = {
+    msgpack_range_int32_sse42,
+    msgpack_range_int64_sse42,
+    msgpack_emit_sse42,
+};
+
+// Per-element stores bound the marked encodings, so AVX2 only widens the scan.
+static const MsgpackArrayKernels msgpack_kernels_avx2 = {
+    msgpack_range_int32_avx2,
+    msgpack_range_int64_avx2,
+    msgpack_emit_sse42,
+};
+
+static const MsgpackArrayKernels msgpack_kernels_avx512 = {
+    msgpack_range_int32_avx512,
+    msgpack_range_int64_avx512,
+    msgpack_emit_avx512,
+};
+
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define PGZ_MSGPACK_KERNELS_NEON 1
+
+static void msgpack_range_int32_neon(const int32* values, int nitems, int64* lo, int64* hi)
+{
+    int32x4_t vmin = vdupq_n_s32(values[0]);
+    int32x4_t vmax = vmin;
+    int i = 0;
+    for (; i + 4 <= nitems; i += 4) {
+        int32x4_t v = vld1q_s32(values + i);
+        vmin = vminq_s32(vmin, v);
+        vmax = vmaxq_s32(vmax, v);
+    }
+    int32 min_value = vminvq_s32(vmin);
+    int32 max_value = vmaxvq_s32(vmax);
+    for (; i < nitems; i++) {
+        min_value = std::min(min_value, values[i]);
+        max_value = std::max(max_value, values[i]);
+    }
+    *lo = min_value;
+    *hi = max_value;
+}
+
+static void msgpack_range_int64_neon(const int64* values, int nitems, int64* lo, int64* hi)
+{
+    int64x2_t vmin = vdupq_n_s64(values[0]);
+    int64x2_t vmax = vmin;
+    int i = 0;
+    for (; i + 2 <= nitems; i += 2) {
+        int64x2_t v = vld1q_s64(reinterpret_cast<const int64_t*>(values + i));
+        vmin = vbslq_s64(vcgtq_s64(vmin, v), v, vmin);
+        vmax = vbslq_s64(vcgtq_s64(v, vmax), v, vmax);
+    }
+    int64 min_value = std::min<int64>(vgetq_lane_s64(vmin, 0), vgetq_lane_s64(vmin, 1));
+    int64 max_value = std::max<int64>(vgetq_lane_s64(vmax, 0), vgetq_lane_s64(vmax, 1));
+    for (; i < nitems; i++) {
+        min_value = std::min(min_value, values[i]);
+        max_value = std::max(max_value, values[i]);
+    }
+    *lo = min_value;
+    *hi = max_value;
+}
+
+static uint8_t* msgpack_emit_neon(uint8_t* out, const void* values, int nitems, int src_width,
+                                  uint8_t marker, int width)
+{
+    const uint8_t* src = static_cast<const uint8_t*>(values);
+    int i = 0;
+    if (marker == 0) {
+        if (src_width == 4) {
+            for (; i + 8 <= nitems; i += 8, src += 32) {
+                const int32_t* p = reinterpret_cast<const int32_t*>(src);
+                int16x8_t halves = vcombine_s16(vmovn_s32(vld1q_s32(p)), vmovn_s32(vld1q_s32(p + 4)));
+                vst1_s8(reinterpret_cast<int8_t*>(out), vmovn_s16(halves));
+                out += 8;
+            }
+        } else {
+            for (; i + 4 <= nitems; i += 4, src += 32) {
+                const int64_t* p = reinterpret_cast<const int64_t*>(src);
+                int32x4_t words = vcombine_s32(vmovn_s64(vld1q_s64(p)), vmovn_s64(vld1q_s64(p + 2)));
+                int16x4_t halves = vmovn_s32(words);
+                int8x8_t bytes = vmovn_s16(vcombine_s16(halves, halves));
+                vst1_lane_s32(reinterpret_cast<int32_t*>(out), vreinterpret_s32_s8(bytes), 0);
+                out += 4;
+            }
+        }
+        return msgpack_emit_fixint_tail(out, src, nitems - i, src_width);
+    }
+
+    uint8_t shuffle_bytes[16];
+    msgpack_emit_shuffle(shuffle_bytes, true, width);
+    const uint8x16_t shuffle = vld1q_u8(shuffle_bytes);
+    const uint8x16_t head = vsetq_lane_u8(marker, vdupq_n_u8(0), 0);
+    const int stride = 1 + width;
+    for (; i < nitems; i++, src += src_width, out += stride) {
+        uint64 element = 0;
+        std::memcpy(&element, src, src_width);
+        uint8x16_t v = vcombine_u8(vcreate_u8(element), vdup_n_u8(0));
+        vst1q_u8(out, vorrq_u8(vqtbl1q_u8(v, shuffle), head));
+    }
+    return out;
+}
+
+static const MsgpackArrayKernels msgpack_kernels_neon = {
+    msgpack_range_int32_neon,
+    msgpack_range_int64_neon,
+    msgpack_emit_neon,
+};
+#endif
+
+/*
+ * Returns nullptr when the CPU has no supported vector tier; callers then use
+ * the per-value encoders.
+ */
+static const MsgpackArrayKernels* msgpack_resolve_array_kernels()
+{
+#if defined(PGZ_MSGPACK_KERNELS_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+        __builtin_cpu_supports("avx512vbmi")) {
+        return &msgpack_kernels_avx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return &msgpack_kernels_avx2;
+    }
+    if (__builtin_cpu_supports("sse4.2")) {
+        return &msgpack_kernels_sse42;
+    }
+#elif defined(PGZ_MSGPACK_KERNELS_NEON)
+    return &msgpack_kernels_neon;
+#endif
+    return nullptr;
+}
+
+static inline const MsgpackArrayKernels* msgpack_array_kernels()
+{
+    static const MsgpackArrayKernels* resolved = msgpack_resolve_array_kernels();
+    return simd_kernels_enabled ? resolved : nullptr;
+}
+
+template <typename ValueT>
+static inline void msgpack_write_int64_sequence(
+    z::MsgPackSerializer& writer, const ValueT* values, int nitems)
+{
+    uint8_t* begin = writer.reserve_raw_append(static_cast<size_t>(nitems) * 9 + kMsgpackKernelSlack);
+    uint8_t* out = begin;
+    if constexpr (sizeof(ValueT) == sizeof(int32) || sizeof(ValueT) == sizeof(int64)) {
+        const MsgpackArrayKernels* kernels = msgpack_array_kernels();
+        if (kernels != nullptr && nitems >= kMsgpackKernelMinItems) {
+            int64 lo;
+            int64 hi;
+            uint8_t marker;
+            int width;
+            if constexpr (sizeof(ValueT) == sizeof(int32)) {
+                kernels->range_int32(reinterpret_cast<const int32*>(values), nitems, &lo, &hi);
+            } else {
+                kernels->range_int64(reinterpret_cast<const int64*>(values), nitems, &lo, &hi);
+            }
+            if (msgpack_uniform_int_encoding(lo, hi, &marker, &width)) {
+                out = kernels->emit(out, values, nitems, sizeof(ValueT), marker, width);
+                writer.commit_raw_append(static_cast<size_t>(out - begin));
+                return;
+            }
+        }
+    }
+    for (int i = 0; i < nitems; i++) {
+        out = msgpack_encode_int64(out, static_cast<int64_t>(values[i]));
+    }
+    writer.commit_raw_append(static_cast<size_t>(out - begin));
+}
+
+template <typename ValueT>
+static inline void msgpack_write_double_sequence(
+    z::MsgPackSerializer& writer, const ValueT* values, int nitems)
+{
+    uint8_t* begin = writer.reserve_raw_append(static_cast<size_t>(nitems) * 9 + kMsgpackKernelSlack);
+    uint8_t* out = begin;
+    if constexpr (std::is_same_v<ValueT, float8>) {
+        const MsgpackArrayKernels* kernels = msgpack_array_kernels();
+        if (kernels != nullptr && nitems >= kMsgpackKernelMinItems) {
+            out = kernels->emit(out, values, nitems, sizeof(float8), 0xcb, 8);
+            writer.commit_raw_append(static_cast<size_t>(out - begin));
+            return;
+        }
+    }
+    for (int i = 0; i < nitems; i++) {
+        *out++ = 0xcb;
+        uint64_t bits = std::bit_cast<uint64_t>(static_cast<double>(values[i]));
+        msgpack_store_be64(out, bits);
+        out += 8;
+    }
+    writer.commit_raw_append(static_cast<size_t>(out - begin));
+}
+
+static inline void msgpack_write_bool_sequence(
+    z::MsgPackSerializer& writer, const bool* values, int nitems)
+{
+    uint8_t* begin = writer.reserve_raw_append(static_cast<size_t>(nitems));
+    for (int i = 0; i < nitems; i++) {
+        begin[i] = values[i] ? 0xc3 : 0xc2;
+    }
+    writer.commit_raw_append(static_cast<size_t>(nitems));
+}
+
+#endif /* PG_ZERIALIZE_KERNELS_HPP */
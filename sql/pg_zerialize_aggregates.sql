@@ -0,0 +1,104 @@
+SET client_min_messages TO warning;
+DROP EXTENSION IF EXISTS pg_zerialize CASCADE;
+CREATE EXTENSION pg_zerialize;
+
+BEGIN;
+CREATE TYPE pg_temp.pgz_agg_item AS (id int, label text, payload bytea);
+CREATE DOMAIN pg_temp.pgz_agg_positive AS int CHECK (VALUE > 0);
+
+CREATE TEMP TABLE pgz_agg_src AS
+SELECT i AS id,
+       i % 3 AS grp,
+       format('k%s', i) AS k,
+       decode(lpad(to_hex(i), 2, '0'), 'hex') AS payload,
+       TIMESTAMP '2025-01-01 00:00:00' + make_interval(secs => i) AS ts
+FROM generate_series(1, 6) AS i;
+
+-- Elements use the row serializer encodings rather than a jsonb detour.
+SELECT msgpack_agg(id ORDER BY id) = msgpack_build_array(1, 2, 3, 4, 5, 6) AS ints_match,
+       msgpack_agg(payload ORDER BY id) = msgpack_build_array(
+           '\x01'::bytea, '\x02'::bytea, '\x03'::bytea,
+           '\x04'::bytea, '\x05'::bytea, '\x06'::bytea) AS bytea_is_binary,
+       msgpack_agg(ts ORDER BY id) = msgpack_build_array(
+           TIMESTAMP '2025-01-01 00:00:01', TIMESTAMP '2025-01-01 00:00:02',
+           TIMESTAMP '2025-01-01 00:00:03', TIMESTAMP '2025-01-01 00:00:04',
+           TIMESTAMP '2025-01-01 00:00:05', TIMESTAMP '2025-01-01 00:00:06')
+           AS timestamp_is_integer,
+       msgpack_agg(id::pg_temp.pgz_agg_positive ORDER BY id) =
+           msgpack_build_array(1, 2, 3, 4, 5, 6) AS domain_uses_base_type
+FROM pgz_agg_src;
+
+SELECT msgpack_agg(ROW(id, k, payload)::pg_temp.pgz_agg_item ORDER BY id) =
+           rows_to_msgpack(array_agg(ROW(id, k, payload)::pg_temp.pgz_agg_item ORDER BY id))
+           AS composite_matches_batch,
+       msgpack_to_jsonb(msgpack_agg(ROW(id, k) ORDER BY id) FILTER (WHERE id <= 2)) =
+           '[{"f1":1,"f2":"k1"},{"f1":2,"f2":"k2"}]'::jsonb AS anonymous_record_is_map,
+       msgpack_to_jsonb(msgpack_agg(CASE WHEN id % 2 = 0 THEN id END ORDER BY id)) =
+           '[null,2,null,4,null,6]'::jsonb AS nulls_are_kept
+FROM pgz_agg_src;
+
+-- JSON inputs stay structured, matching the jsonb aggregates.
+SELECT msgpack_agg(jsonb_build_object('id', id, 'k', k) ORDER BY id) =
+           msgpack_from_jsonb(jsonb_agg(jsonb_build_object('id', id, 'k', k) ORDER BY id))
+           AS jsonb_parity,
+       msgpack_agg(json_build_object('id', id) ORDER BY id) =
+           msgpack_from_jsonb(jsonb_agg(jsonb_build_object('id', id) ORDER BY id))
+           AS json_parity,
+       msgpack_object_agg(k, payload ORDER BY id) =
+           msgpack_build_object('k1', '\x01'::bytea, 'k2', '\x02'::bytea,
+                                'k3', '\x03'::bytea, 'k4', '\x04'::bytea,
+                                'k5', '\x05'::bytea, 'k6', '\x06'::bytea)
+           AS object_values_are_binary
+FROM pgz_agg_src;
+
+-- Keys follow jsonb order, whatever the input order.
+SELECT msgpack_object_agg(k, id ORDER BY id DESC) =
+           msgpack_build_object('k1', 1, 'k2', 2, 'k3', 3, 'k4', 4, 'k5', 5, 'k6', 6)
+           AS object_keys_sorted,
+       msgpack_object_agg(k || repeat('x', 7 - id), id) =
+           msgpack_from_jsonb(jsonb_object_agg(k || repeat('x', 7 - id), id))
+           AS object_keys_jsonb_order
+FROM pgz_agg_src;
+
+-- Container headers switch width at 16 and 65536 elements.
+SELECT bool_and(msgpack_to_jsonb(m) = j) AS array_header_widths
+FROM (
+    SELECT msgpack_agg(i ORDER BY i) AS m, jsonb_agg(i ORDER BY i) AS j
+    FROM (VALUES (15), (16), (65535), (65536)) AS sizes(n),
+         LATERAL generate_series(1, n) AS i
+    GROUP BY n
+) s;
+
+SELECT bool_and(msgpack_to_jsonb(m) = j) AS map_header_widths
+FROM (
+    SELECT msgpack_object_agg(i::text, i ORDER BY i) AS m,
+           jsonb_object_agg(i::text, i ORDER BY i) AS j
+    FROM (VALUES (15), (16), (65535), (65536)) AS sizes(n),
+         LATERAL generate_series(1, n) AS i
+    GROUP BY n
+) s;
+
+-- Grouped and windowed use share one state shape.
+SELECT bool_and(msgpack_to_jsonb(m) = j) AS grouped_parity
+FROM (
+    SELECT msgpack_agg(id ORDER BY id) AS m, jsonb_agg(id ORDER BY id) AS j
+    FROM pgz_agg_src
+    GROUP BY grp
+) s;
+
+SELECT bool_and(msgpack_to_jsonb(m) = j) AS window_parity
+FROM (
+    SELECT msgpack_agg(id) OVER w AS m, jsonb_agg(id) OVER w AS j
+    FROM pgz_agg_src
+    WINDOW w AS (ORDER BY id)
+) s;
+
+-- A repeated key keeps its last value, as in jsonb_object_agg.
+SELECT msgpack_object_agg(k, v ORDER BY n) = msgpack_build_object('a', 3, 'b', 2)
+           AS duplicate_key_last_wins,
+       msgpack_object_agg(k, v ORDER BY n) =
+           msgpack_from_jsonb(jsonb_object_agg(k, v ORDER BY n)) AS duplicate_key_parity
+FROM (VALUES (1, 'a', 1), (2, 'b', 2), (3, 'a', 3)) AS t(n, k, v);
+
+ROLLBACK;
+DROP EXTENSION pg_zerialize;
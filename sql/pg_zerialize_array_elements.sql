@@ -0,0 +1,51 @@
+SET client_min_messages TO warning;
+DROP EXTENSION IF EXISTS pg_zerialize CASCADE;
+CREATE EXTENSION pg_zerialize;
+
+CREATE TEMP TABLE pgz_split_src AS
+SELECT i AS id,
+       format('name_%s', i) AS name,
+       ARRAY[i, i * 2] AS pair
+FROM generate_series(1, 300) AS i;
+
+-- Each element is the same document the single-row functions produce.
+SELECT bool_and(e.elem = row_to_msgpack(t)) AND count(*) = 300 AS msgpack_rows_match
+FROM msgpack_array_elements(
+         (SELECT rows_to_msgpack(array_agg(t ORDER BY id)) FROM pgz_split_src AS t))
+         WITH ORDINALITY AS e(elem, n)
+JOIN pgz_split_src AS t ON t.id = e.n;
+
+SELECT bool_and(e.elem = row_to_cbor(t)) AND count(*) = 300 AS cbor_rows_match
+FROM cbor_array_elements(
+         (SELECT rows_to_cbor(array_agg(t ORDER BY id)) FROM pgz_split_src AS t))
+         WITH ORDINALITY AS e(elem, n)
+JOIN pgz_split_src AS t ON t.id = e.n;
+
+SELECT array_agg(msgpack_to_jsonb(e) ORDER BY n) =
+       ARRAY['1', '"x"', '[null, true]', '{"k": 2.5}']::jsonb[] AS msgpack_mixed_elements
+FROM msgpack_array_elements(msgpack_from_jsonb('[1, "x", [null, true], {"k": 2.5}]'))
+     WITH ORDINALITY AS t(e, n);
+
+SELECT array_agg(e ORDER BY n) = ARRAY['\x01', '\x8102', '\x63616263']::bytea[]
+       AS cbor_indefinite_elements
+FROM cbor_array_elements('\x9f01810263616263ff'::bytea) WITH ORDINALITY AS t(e, n);
+
+SELECT (SELECT count(*) FROM msgpack_array_elements('\x90'::bytea)) = 0 AND
+       (SELECT count(*) FROM cbor_array_elements('\x80'::bytea)) = 0 AND
+       (SELECT count(*) FROM cbor_array_elements('\x9fff'::bytea)) = 0 AS empty_arrays;
+
+-- Split batches feed record decoding one element at a time.
+SELECT count(*) = 300 AND bool_and(r.pair[2] = r.id * 2) AS split_then_populate
+FROM msgpack_array_elements(
+         (SELECT rows_to_msgpack(array_agg(t ORDER BY id)) FROM pgz_split_src AS t)) AS e,
+     LATERAL msgpack_populate_record(NULL::pgz_split_src, e) AS r;
+
+SELECT * FROM msgpack_array_elements('\x81a16101'::bytea);
+SELECT * FROM cbor_array_elements('\xa0'::bytea);
+SELECT * FROM msgpack_array_elements('\x920101'::bytea);
+SELECT * FROM msgpack_array_elements('\x9201'::bytea);
+SELECT * FROM cbor_array_elements('\x9f01'::bytea);
+SELECT * FROM cbor_array_elements('\x81c001'::bytea);
+
+DROP TABLE pgz_split_src;
+DROP EXTENSION pg_zerialize;
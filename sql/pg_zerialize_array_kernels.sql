@@ -0,0 +1,59 @@
+SET client_min_messages TO warning;
+DROP EXTENSION IF EXISTS pg_zerialize CASCADE;
+CREATE EXTENSION pg_zerialize;
+
+BEGIN;
+CREATE TYPE pg_temp.pgz_kernel_row AS (
+    i4 int4[],
+    i8 int8[],
+    f8 float8[],
+    d date[],
+    ts timestamp[]
+);
+
+-- One array per MessagePack integer class, a mixed-width array, and short
+-- arrays below the kernel threshold. Lengths 17 and 40 leave vector tails.
+CREATE TEMP TABLE pgz_kernel_src AS
+SELECT row_number() OVER () AS id,
+       ROW(CASE WHEN lo >= -2147483648 AND hi <= 2147483647 THEN vals::int4[] END,
+           vals::int8[],
+           ARRAY(SELECT (g * 1.5 - 7)::float8 FROM generate_series(1, len) AS g) ||
+               ARRAY['NaN', 'Infinity', '-Infinity', '-0']::float8[],
+           ARRAY(SELECT DATE '2000-01-01' + g * 3 FROM generate_series(1, len) AS g),
+           ARRAY(SELECT TIMESTAMP '2025-01-01' + g * INTERVAL '1 second'
+                 FROM generate_series(1, len) AS g))::pg_temp.pgz_kernel_row AS r
+FROM (VALUES (-32, 127), (0, 0), (128, 255), (256, 65535), (65536, 4294967295),
+             (4294967296, 9223372036854775807), (-128, -33), (-32768, -129),
+             (-2147483648, -32769), (-9223372036854775808, -2147483649),
+             (-5, 300), (-2147483648, 2147483647)) AS bounds(lo, hi),
+     (VALUES (3), (15), (17), (40)) AS lengths(len),
+     LATERAL (SELECT ARRAY(SELECT lo::numeric + floor((hi::numeric - lo) * g / (len - 1))
+                           FROM generate_series(0, len - 1) AS g) AS vals) AS v;
+
+SET LOCAL pg_zerialize.simd = off;
+CREATE TEMP TABLE pgz_kernel_scalar AS
+SELECT id, row_to_msgpack(r) AS m FROM pgz_kernel_src;
+CREATE TEMP TABLE pgz_kernel_scalar_batch AS
+SELECT rows_to_msgpack(array_agg(r ORDER BY id)) AS batch FROM pgz_kernel_src;
+RESET pg_zerialize.simd;
+
+-- The vector kernels reproduce the per-value encoding byte for byte.
+SELECT current_setting('pg_zerialize.simd') = 'on' AS simd_default_on,
+       bool_and(row_to_msgpack(s.r) = k.m) AS rows_match_scalar,
+       count(*) = 48 AS all_rows
+FROM pgz_kernel_src AS s
+JOIN pgz_kernel_scalar AS k USING (id);
+
+SELECT rows_to_msgpack(array_agg(r ORDER BY id)) = (SELECT batch FROM pgz_kernel_scalar_batch)
+       AS batch_matches_scalar
+FROM pgz_kernel_src;
+
+SELECT bool_and(msgpack_to_jsonb(row_to_msgpack(r)) -> 'i8' = to_jsonb((r).i8)) AS int8_values,
+       bool_and(msgpack_to_jsonb(row_to_msgpack(r)) -> 'i4' = to_jsonb((r).i4)) AS int4_values,
+       bool_and(msgpack_to_jsonb(row_to_msgpack(r)) -> 'd' =
+                to_jsonb(ARRAY(SELECT e - DATE '2000-01-01' FROM unnest((r).d) AS e)))
+           AS date_values
+FROM pgz_kernel_src;
+
+ROLLBACK;
+DROP EXTENSION pg_zerialize;
@@ -0,0 +1,79 @@
+SET client_min_messages TO warning;
+DROP EXTENSION IF EXISTS pg_zerialize CASCADE;
+CREATE EXTENSION pg_zerialize;
+
+BEGIN;
+CREATE TYPE pg_temp.pgz_threads_row AS (
+    id int4,
+    big int8,
+    small int2,
+    ratio float4,
+    score float8,
+    flag boolean,
+    label text,
+    code char(3),
+    payload bytea,
+    key uuid,
+    day date,
+    at timestamp,
+    at_tz timestamptz
+);
+
+-- Enough rows for several slices, with null rows and null columns spread
+-- across slice boundaries.
+CREATE TEMP TABLE pgz_threads_src AS
+SELECT g AS id,
+       CASE WHEN g % 997 = 0 THEN NULL
+            ELSE ROW(g, g::int8 * 2147483659, (g % 32767)::int2, g / 3.0, g * -1.25,
+                     g % 2 = 0,
+                     CASE WHEN g % 11 = 0 THEN NULL ELSE format('row-%s-é', g) END,
+                     chr(65 + g % 26), decode(lpad(to_hex(g), 8, '0'), 'hex'),
+                     md5(g::text)::uuid, DATE '2000-01-01' + g % 5000,
+                     TIMESTAMP '2025-01-01' + g * INTERVAL '1 second',
+                     TIMESTAMPTZ '2025-01-01 00:00+00' - g * INTERVAL '1 minute')::pg_temp.pgz_threads_row
+       END AS r
+FROM generate_series(1, 70000) AS g;
+
+SELECT current_setting('pg_zerialize.batch_threads') = '1' AS threads_default_off;
+
+CREATE TEMP TABLE pgz_threads_serial AS
+SELECT rows_to_msgpack(array_agg(r ORDER BY id)) AS batch FROM pgz_threads_src;
+
+-- Threaded batches match the serial encoder byte for byte.
+SET LOCAL pg_zerialize.batch_threads = 4;
+SELECT rows_to_msgpack(array_agg(r ORDER BY id)) = (SELECT batch FROM pgz_threads_serial)
+       AS threaded_matches_serial
+FROM pgz_threads_src;
+
+SET LOCAL pg_zerialize.type_encoding = native;
+SET LOCAL pg_zerialize.batch_threads = 1;
+CREATE TEMP TABLE pgz_threads_native AS
+SELECT rows_to_msgpack(array_agg(r ORDER BY id)) AS batch FROM pgz_threads_src;
+SET LOCAL pg_zerialize.batch_threads = 8;
+SELECT rows_to_msgpack(array_agg(r ORDER BY id)) = (SELECT batch FROM pgz_threads_native)
+       AS native_matches_serial
+FROM pgz_threads_src;
+RESET pg_zerialize.type_encoding;
+
+-- Compressed text makes the workers give up; the serial encoder takes over.
+SET LOCAL pg_zerialize.batch_threads = 3;
+CREATE TEMP TABLE pgz_threads_wide (id int4, label text);
+INSERT INTO pgz_threads_wide
+SELECT g, CASE WHEN g = 60000 THEN repeat('compressible ', 1000) ELSE g::text END
+FROM generate_series(1, 70000) AS g;
+SELECT msgpack_to_jsonb(rows_to_msgpack(array_agg(w ORDER BY id))) =
+           jsonb_agg(to_jsonb(w) ORDER BY id) AS compressed_value_parity
+FROM pgz_threads_wide AS w;
+
+-- Columns the workers cannot write, and small batches, stay serial.
+SELECT rows_to_msgpack(array_agg(ROW(g, g::numeric / 7) ORDER BY g)) =
+           rows_to_msgpack_slow(array_agg(ROW(g, g::numeric / 7) ORDER BY g)) AS numeric_parity
+FROM generate_series(1, 40000) AS g;
+SELECT rows_to_msgpack(array_agg(r ORDER BY id)) =
+           rows_to_msgpack_slow(array_agg(r ORDER BY id)) AS small_parity
+FROM pgz_threads_src
+WHERE id <= 100;
+ROLLBACK;
+
+SET pg_zerialize.batch_threads = 0;
+DROP EXTENSION pg_zerialize;
@@ -0,0 +1,117 @@
+SET client_min_messages TO warning;
+DROP EXTENSION IF EXISTS pg_zerialize CASCADE;
+CREATE EXTENSION pg_zerialize;
+
+BEGIN;
+CREATE TYPE pg_temp.pgz_decimal_row AS (
+    id int,
+    amount numeric,
+    amounts numeric[]
+);
+CREATE TYPE pg_temp.pgz_decimal_money AS (
+    id int,
+    amount numeric(12, 2),
+    amounts numeric(6, 1)[]
+);
+
+CREATE TEMP TABLE pgz_decimal_src AS
+SELECT ROW(id, n, ARRAY[n, -n, 0.000])::pg_temp.pgz_decimal_row AS r
+FROM (VALUES (1, '0'), (2, '1.20'), (3, '-0.05'), (4, '12345678.90'),
+             (5, '9223372036854775807'), (6, '-9223372036854775808'),
+             (7, '9223372036854775808'), (8, '-99999999999999999999.999999'),
+             (9, '123456789012345678901234567890.12345678901234567890'),
+             (10, '0.0000000000000000000000000000000000000001'), (11, '1e100')) AS v(id, t),
+     LATERAL (SELECT t::numeric AS n) AS n
+UNION ALL
+SELECT ROW(100 + g, n, ARRAY[n])::pg_temp.pgz_decimal_row
+FROM generate_series(1, 2000) AS g,
+     LATERAL (SELECT format('%s.%s', g * 7919 % 1000003 - 500000,
+                            repeat('7', g % 6))::numeric AS n) AS n;
+
+SET LOCAL pg_zerialize.numeric_encoding = tagged_decimal;
+CREATE TEMP TABLE pgz_decimal_tagged AS
+SELECT (r).id, row_to_msgpack(r) AS m, row_to_cbor(r) AS c FROM pgz_decimal_src;
+
+SET LOCAL pg_zerialize.numeric_encoding = binary_decimal;
+
+-- Mantissa and negated display scale under each protocol's decimal form.
+SELECT row_to_msgpack(ROW(1.20)) = '\x81a26631c70304fffe78'::bytea AS msgpack_ext,
+       row_to_msgpack(ROW(-0.05)) = '\x81a26631c70304fffefb'::bytea AS msgpack_negative,
+       row_to_msgpack(ROW(12345678.90)) = '\x81a26631c70604fffe499602d2'::bytea
+           AS msgpack_wide_mantissa,
+       row_to_cbor(ROW(1.20)) = '\xa1626631c482211878'::bytea AS cbor_decimal_fraction,
+       zera_to_jsonb(row_to_zera(ROW(1.20))) = '{"f1": ["~d", -2, 120]}'::jsonb AS zera_triple,
+       flexbuffers_to_jsonb(row_to_flexbuffers(ROW(1.20))) = '{"f1": ["~d", -2, 120]}'::jsonb
+           AS flex_triple;
+
+-- CBOR mantissas take the shortest integer form, then a tag 2/3 bignum.
+SELECT row_to_cbor(ROW(9223372036854775808::numeric))
+           = '\xa1626631c482001b8000000000000000'::bytea AS cbor_uint64_mantissa,
+       row_to_cbor(ROW(-18446744073709551617::numeric))
+           = '\xa1626631c48200c349010000000000000000'::bytea AS cbor_bignum_mantissa;
+
+-- Decoding restores every value with its display scale.
+SELECT bool_and(msgpack_to_jsonb(row_to_msgpack(r)) = to_jsonb(r)) AS msgpack_values,
+       bool_and(cbor_to_jsonb(row_to_cbor(r)) = to_jsonb(r)) AS cbor_values,
+       bool_and(msgpack_to_jsonb(row_to_msgpack(r))::text = to_jsonb(r)::text) AS msgpack_scales,
+       bool_and(cbor_to_jsonb(row_to_cbor(r))::text = to_jsonb(r)::text) AS cbor_scales,
+       bool_and(msgpack_populate_record(NULL::pg_temp.pgz_decimal_row, row_to_msgpack(r))::text =
+                r::text) AS populate_roundtrip
+FROM pgz_decimal_src;
+
+SELECT sum(octet_length(row_to_msgpack(s.r))) < sum(octet_length(t.m)) AS msgpack_smaller,
+       sum(octet_length(row_to_cbor(s.r))) < sum(octet_length(t.c)) AS cbor_smaller
+FROM pgz_decimal_src AS s
+JOIN pgz_decimal_tagged AS t ON t.id = (s.r).id;
+
+-- Buffered aggregates replay the decimal form unchanged.
+SELECT msgpack_rows_agg(r ORDER BY (r).id) = rows_to_msgpack(array_agg(r ORDER BY (r).id))
+           AS msgpack_agg_parity,
+       cbor_rows_agg(r ORDER BY (r).id) = rows_to_cbor(array_agg(r ORDER BY (r).id))
+           AS cbor_agg_parity,
+       zera_rows_agg(r ORDER BY (r).id) = rows_to_zera(array_agg(r ORDER BY (r).id))
+           AS zera_agg_parity,
+       flexbuffers_rows_agg(r ORDER BY (r).id) = rows_to_flexbuffers(array_agg(r ORDER BY (r).id))
+           AS flex_agg_parity
+FROM pgz_decimal_src;
+
+-- Typmods apply on decode; jsonb input takes the array form, which decodes too.
+SELECT (msgpack_populate_record(NULL::pg_temp.pgz_decimal_money,
+            row_to_msgpack(ROW(1, 1.235, ARRAY[2.25])::pg_temp.pgz_decimal_row)))::text =
+           '(1,1.24,{2.3})' AS typmod_rounds,
+       msgpack_to_jsonb(msgpack_from_jsonb('{"a": 1.20}'::jsonb)) = '{"a": ["~d", -2, 120]}'::jsonb
+           AS jsonb_input_triple,
+       (msgpack_populate_record(NULL::pg_temp.pgz_decimal_row,
+            msgpack_from_jsonb('{"amount": 1.20, "amounts": [-0.5]}'::jsonb)))::text =
+           '(,1.20,{-0.5})' AS triple_populates;
+
+SELECT msgpack_extract_text(row_to_msgpack(ROW(-12.50)), '{f1}') = '-12.50' AS msgpack_extract_text,
+       msgpack_extract_float8(row_to_msgpack(ROW(-12.50)), '{f1}') = -12.5 AS msgpack_extract_float8,
+       msgpack_extract_int8(row_to_msgpack(ROW(42)), '{f1}') = 42 AS msgpack_extract_int8,
+       cbor_extract_text(row_to_cbor(ROW(-12.50)), '{f1}') = '-12.50' AS cbor_extract_text,
+       cbor_extract_float8(row_to_cbor(ROW(-12.50)), '{f1}') = -12.5 AS cbor_extract_float8;
+
+-- NaN and the infinities have no decimal form and stay float64.
+SELECT row_to_msgpack(ROW('NaN'::numeric, 'Infinity'::numeric)) =
+           row_to_msgpack(ROW('NaN'::float8, 'Infinity'::float8)) AS msgpack_specials,
+       row_to_cbor(ROW('-Infinity'::numeric)) = row_to_cbor(ROW('-Infinity'::float8))
+           AS cbor_specials;
+ROLLBACK;
+
+-- Decimal fractions and bignums from other CBOR encoders.
+SELECT cbor_to_jsonb('\xc482211903e8'::bytea)::text = '10.00' AS cbor_scaled,
+       cbor_to_jsonb('\xc4820203'::bytea)::text = '300' AS cbor_positive_exponent,
+       cbor_to_jsonb('\xc249010000000000000000'::bytea)::text = '18446744073709551616'
+           AS cbor_bignum,
+       cbor_to_jsonb('\xc349010000000000000000'::bytea)::text = '-18446744073709551617'
+           AS cbor_negative_bignum,
+       cbor_to_jsonb('\xc48220c249010000000000000000'::bytea)::text = '1844674407370955161.6'
+           AS cbor_bignum_mantissa,
+       cbor_to_jsonb('\xa16178c4822139ffff'::bytea) = '{"x": -655.36}'::jsonb AS cbor_nested;
+
+SELECT cbor_to_jsonb('\xc48121'::bytea);
+SELECT cbor_to_jsonb('\xc482216161'::bytea);
+SELECT cbor_to_jsonb('\xc4821a0001000001'::bytea);
+SELECT msgpack_to_jsonb('\xd504ffff'::bytea);
+
+DROP EXTENSION pg_zerialize;
@@ -47,6 +47,57 @@ FROM employees;
 SELECT msgpack_object_agg(name, role ORDER BY name) IS NOT NULL AS object_agg_ok
 FROM employees;
 
+-- Call-site plans: constant keys resolve once, column keys vary by row.
+SELECT bool_and(msgpack_build_object('id', id, 'name', name) =
+                msgpack_from_jsonb(jsonb_build_object('id', id, 'name', name))) AS const_key_plan,
+       bool_and(msgpack_build_object(name, id) =
+                msgpack_from_jsonb(jsonb_build_object(name, id))) AS column_key_plan,
+       bool_and(msgpack_build_object(id, role) =
+                msgpack_from_jsonb(jsonb_build_object(id::text, role))) AS output_key_plan
+FROM employees;
+
+SELECT msgpack_to_jsonb(msgpack_build_array(ROW(1, 'x'), ARRAY[ROW(2, 'y')])) =
+       '[{"f1": 1, "f2": "x"}, [{"f1": 2, "f2": "y"}]]'::jsonb AS record_args_are_maps;
+
+-- CBOR and ZERA builders share the plans and decode like MessagePack.
+SELECT bool_and(cbor_to_jsonb(cbor_build_object('id', e.id, 'name', e.name, 'tags', ARRAY[role, NULL],
+                                                'dept', d, 'none', NULL)) =
+                msgpack_to_jsonb(msgpack_build_object('id', e.id, 'name', e.name, 'tags', ARRAY[role, NULL],
+                                                      'dept', d, 'none', NULL))) AS cbor_object_parity,
+       bool_and(zera_to_jsonb(zera_build_object('id', e.id, 'name', e.name, 'tags', ARRAY[role, NULL],
+                                                'dept', d, 'none', NULL)) =
+                msgpack_to_jsonb(msgpack_build_object('id', e.id, 'name', e.name, 'tags', ARRAY[role, NULL],
+                                                      'dept', d, 'none', NULL))) AS zera_object_parity,
+       bool_and(cbor_to_jsonb(cbor_build_array(e.id, e.name, true, NULL)) =
+                msgpack_to_jsonb(msgpack_build_array(e.id, e.name, true, NULL))) AS cbor_array_parity,
+       bool_and(zera_to_jsonb(zera_build_array(e.id, e.name, true, NULL)) =
+                msgpack_to_jsonb(msgpack_build_array(e.id, e.name, true, NULL))) AS zera_array_parity
+FROM employees e
+JOIN departments d ON d.id = e.department_id;
+
+-- Keys from PL/pgSQL variables change between calls of one cached plan.
+DO $$
+DECLARE
+    k text;
+    keys text := '';
+BEGIN
+    FOREACH k IN ARRAY ARRAY['a', 'b', 'c'] LOOP
+        keys := keys || (SELECT string_agg(key, ',')
+                         FROM jsonb_object_keys(msgpack_to_jsonb(msgpack_build_object(k, 1))) AS key)
+                     || (SELECT string_agg(key, ',')
+                         FROM jsonb_object_keys(cbor_to_jsonb(cbor_build_object(k, 1))) AS key)
+                     || (SELECT string_agg(key, ',')
+                         FROM jsonb_object_keys(zera_to_jsonb(zera_build_object(k, 1))) AS key);
+    END LOOP;
+    IF keys <> 'aaabbbccc' THEN
+        RAISE EXCEPTION 'builder reused a variable key: %', keys;
+    END IF;
+END
+$$;
+
+SELECT cbor_build_object('a');
+SELECT zera_build_object(NULL::text, 1);
+
 DROP TABLE employees;
 DROP TABLE departments;
 DROP EXTENSION pg_zerialize;
@@ -18,6 +18,41 @@ SELECT bool_and(row_to_msgpack(pgz_ci_tbl) IS NOT NULL) AS table_after_add_col F
 ALTER TABLE pgz_ci_tbl ALTER COLUMN b TYPE varchar(8);
 SELECT bool_and(row_to_msgpack(pgz_ci_tbl) IS NOT NULL) AS table_after_type_change FROM pgz_ci_tbl;
 
+-- Renaming an enum label drops only that label from the cache.
+CREATE TYPE pgz_ci_mood AS ENUM ('sad', 'ok');
+CREATE TYPE pgz_ci_feeling AS (m pgz_ci_mood);
+SELECT msgpack_to_jsonb(row_to_msgpack(ROW('ok')::pgz_ci_feeling)) = '{"m": "ok"}'::jsonb
+       AS enum_before_rename;
+ALTER TYPE pgz_ci_mood RENAME VALUE 'ok' TO 'fine';
+SELECT msgpack_to_jsonb(row_to_msgpack(ROW('fine')::pgz_ci_feeling)) = '{"m": "fine"}'::jsonb
+       AS enum_after_rename;
+
+-- Unrelated relation churn leaves cached schemas correct.
+CREATE TEMP TABLE pgz_ci_churn AS SELECT 1 AS x;
+DROP TABLE pgz_ci_churn;
+SELECT bool_and(msgpack_to_jsonb(row_to_msgpack(pgz_ci_tbl)) = '{"a": 1, "b": "v"}'::jsonb)
+       AS table_after_unrelated_ddl
+FROM pgz_ci_tbl
+WHERE a = 1;
+
+-- A bounded cache evicts older schemas and rebuilds them on demand.
+CREATE TYPE pgz_ci_t1 AS (v int);
+CREATE TYPE pgz_ci_t2 AS (v text);
+CREATE TYPE pgz_ci_t3 AS (v bool);
+SET pg_zerialize.schema_cache_max_entries = 2;
+SELECT msgpack_to_jsonb(row_to_msgpack(ROW(1)::pgz_ci_t1)) = '{"v": 1}'::jsonb AS lru_t1;
+SELECT msgpack_to_jsonb(row_to_msgpack(ROW('x')::pgz_ci_t2)) = '{"v": "x"}'::jsonb AS lru_t2;
+SELECT msgpack_to_jsonb(row_to_msgpack(ROW(true)::pgz_ci_t3)) = '{"v": true}'::jsonb AS lru_t3;
+SELECT msgpack_to_jsonb(row_to_msgpack(ROW(1)::pgz_ci_t1)) = '{"v": 1}'::jsonb AND
+       msgpack_to_jsonb(row_to_msgpack(ROW('x')::pgz_ci_t2)) = '{"v": "x"}'::jsonb AND
+       msgpack_to_jsonb(row_to_msgpack(ROW(true)::pgz_ci_t3)) = '{"v": true}'::jsonb AS lru_over_bound;
+RESET pg_zerialize.schema_cache_max_entries;
+
+DROP TYPE pgz_ci_t3;
+DROP TYPE pgz_ci_t2;
+DROP TYPE pgz_ci_t1;
+DROP TYPE pgz_ci_feeling;
+DROP TYPE pgz_ci_mood;
 DROP TABLE pgz_ci_tbl;
 DROP TYPE pgz_ci;
 DROP EXTENSION pg_zerialize;
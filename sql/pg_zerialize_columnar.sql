@@ -0,0 +1,74 @@
+SET client_min_messages TO warning;
+DROP EXTENSION IF EXISTS pg_zerialize CASCADE;
+CREATE EXTENSION pg_zerialize;
+
+CREATE TYPE pgz_col_row AS (
+    id int4, small int2, big int8, f4 float4, f8 float8, ok bool,
+    d date, ts timestamp, label text, raw bytea, amount numeric
+);
+CREATE FUNCTION pgz_col_blob(b bytea) RETURNS jsonb
+LANGUAGE sql IMMUTABLE AS $$ SELECT jsonb_build_array('~b', encode(b, 'base64'), 'base64') $$;
+
+CREATE TEMP TABLE pgz_col_doc AS
+SELECT zera_to_jsonb(rows_to_zera_columnar(ARRAY[
+           ROW(1, 10, 100, 0.5, 1.5, true, '2000-01-02', '2000-01-01 00:00:01',
+               'a', '\x01', 1.25)::pgz_col_row,
+           ROW(2, NULL, 200, 1.0, 2.5, false, '2000-01-03', '2000-01-01 00:00:02',
+               NULL, '\x0203', NULL)::pgz_col_row,
+           ROW(3, 30, 300, 2.0, -1, true, '1999-12-31', '2000-01-01 00:00:03',
+               'bc', '\x', 10)::pgz_col_row])) AS j;
+
+-- Fixed-width columns are contiguous little-endian buffers.
+SELECT j->'rows' = '3'::jsonb AS row_count,
+       j->'columns'->'id' = jsonb_build_object(
+           'type', 'integer', 'layout', 'fixed', 'dtype', 2, 'shape', jsonb_build_array(3),
+           'data', pgz_col_blob('\x010000000200000003000000'), 'validity', NULL) AS int4_column,
+       j->'columns'->'small'->'data' = pgz_col_blob('\x0a0000001e00') AS int2_zero_under_null,
+       j->'columns'->'small'->'validity' = pgz_col_blob('\x05') AS int2_validity,
+       j->'columns'->'d'->'data' = pgz_col_blob('\x0100000002000000ffffffff') AS date_days,
+       j->'columns'->'ok'->'data' = pgz_col_blob('\x010001') AS bool_bytes,
+       j->'columns'->'f8'->'data' =
+           pgz_col_blob('\x000000000000f83f0000000000000440000000000000f0bf') AS float8_values
+FROM pgz_col_doc;
+
+SELECT j->'columns'->'big'->'dtype' = '3'::jsonb AND
+       j->'columns'->'ts'->'dtype' = '3'::jsonb AND
+       j->'columns'->'f4'->'dtype' = '10'::jsonb AND
+       j->'columns'->'ok'->'dtype' = '4'::jsonb AS dtype_codes
+FROM pgz_col_doc;
+
+-- Variable-width columns use int32 offsets into one data blob.
+SELECT j->'columns'->'label' = jsonb_build_object(
+           'type', 'text', 'layout', 'utf8',
+           'offsets', pgz_col_blob('\x00000000010000000100000003000000'),
+           'data', pgz_col_blob('\x616263'), 'validity', pgz_col_blob('\x05')) AS text_column,
+       j->'columns'->'raw'->>'layout' = 'binary' AND
+       j->'columns'->'raw'->'offsets' = pgz_col_blob('\x00000000010000000300000003000000') AND
+       j->'columns'->'raw'->'data' = pgz_col_blob('\x010203') AS bytea_column,
+       j->'columns'->'amount'->>'layout' = 'utf8' AND
+       j->'columns'->'amount'->'data' = pgz_col_blob(convert_to('1.2510', 'UTF8'))
+           AS numeric_as_text
+FROM pgz_col_doc;
+
+-- Every column is present; a NULL row is NULL in each of them.
+SELECT (SELECT array_agg(k ORDER BY k) FROM jsonb_object_keys(j->'columns') AS k) =
+           ARRAY['amount', 'big', 'd', 'f4', 'f8', 'id', 'label', 'ok', 'raw', 'small', 'ts']
+           AS all_columns
+FROM pgz_col_doc;
+
+SELECT zera_to_jsonb(rows_to_zera_columnar(ARRAY[ROW(1, 'x'), NULL, ROW(3, 'z')]))->'columns'->'f1'
+           = jsonb_build_object(
+               'type', 'integer', 'layout', 'fixed', 'dtype', 2, 'shape', jsonb_build_array(3),
+               'data', pgz_col_blob('\x010000000000000003000000'),
+               'validity', pgz_col_blob('\x05')) AS null_row;
+
+SELECT zera_to_jsonb(rows_to_zera_columnar('{}'::pgz_col_row[]))->'rows' = '0'::jsonb AND
+       zera_to_jsonb(rows_to_zera_columnar('{}'::pgz_col_row[]))->'columns'->'id'->'shape' =
+           '[0]'::jsonb AS empty_batch;
+
+SELECT rows_to_zera_columnar(ARRAY[ROW(1), ROW(1, 2)]);
+
+DROP TABLE pgz_col_doc;
+DROP FUNCTION pgz_col_blob(bytea);
+DROP TYPE pgz_col_row;
+DROP EXTENSION pg_zerialize;
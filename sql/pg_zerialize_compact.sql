@@ -0,0 +1,70 @@
+SET client_min_messages TO warning;
+DROP EXTENSION IF EXISTS pg_zerialize CASCADE;
+CREATE EXTENSION pg_zerialize;
+
+CREATE TYPE pgz_cmp_inner AS (k int, v text);
+CREATE TABLE pgz_cmp_src (id int, name text, score float8, tags text[]);
+INSERT INTO pgz_cmp_src
+SELECT i, CASE WHEN i % 4 = 0 THEN NULL ELSE format('n%s', i) END, i / 2.0, ARRAY[format('t%s', i)]
+FROM generate_series(1, 50) AS i;
+
+-- Column names are written once; each row is a positional array.
+SELECT msgpack_to_jsonb(rows_to_msgpack_compact(array_agg(t ORDER BY id))) =
+           '{"columns": ["id", "name", "score", "tags"],
+             "rows": [[1, "n1", 0.5, ["t1"]], [2, "n2", 1.0, ["t2"]], [3, "n3", 1.5, ["t3"]]]}'::jsonb
+           AS msgpack_shape
+FROM pgz_cmp_src AS t
+WHERE id <= 3;
+
+SELECT octet_length(rows_to_msgpack_compact(a)) < octet_length(rows_to_msgpack(a)) AS msgpack_smaller,
+       octet_length(rows_to_cbor_compact(a)) < octet_length(rows_to_cbor(a)) AS cbor_smaller,
+       octet_length(rows_to_zera_compact(a)) < octet_length(rows_to_zera(a)) AS zera_smaller
+FROM (SELECT array_agg(t ORDER BY id) AS a FROM pgz_cmp_src AS t) AS s;
+
+SELECT cbor_to_jsonb(rows_to_cbor_compact(a)) = msgpack_to_jsonb(rows_to_msgpack_compact(a))
+           AS cbor_parity,
+       zera_to_jsonb(rows_to_zera_compact(a)) = msgpack_to_jsonb(rows_to_msgpack_compact(a))
+           AS zera_parity
+FROM (SELECT array_agg(CASE WHEN id % 5 = 0 THEN NULL ELSE t END ORDER BY id) AS a
+      FROM pgz_cmp_src AS t) AS s;
+
+-- Composite columns go through the generic path with the same layout.
+SELECT msgpack_to_jsonb(rows_to_msgpack_compact(a)) = j AS msgpack_nested,
+       cbor_to_jsonb(rows_to_cbor_compact(a)) = j AS cbor_nested,
+       zera_to_jsonb(rows_to_zera_compact(a)) = j AS zera_nested
+FROM (SELECT ARRAY[ROW(1, ROW(10, 'x')::pgz_cmp_inner)] AS a,
+             '{"columns": ["f1", "f2"], "rows": [[1, {"k": 10, "v": "x"}]]}'::jsonb AS j) AS s;
+
+-- A named row type keeps its columns even without rows.
+SELECT msgpack_to_jsonb(rows_to_msgpack_compact('{}'::pgz_cmp_src[])) =
+           '{"columns": ["id", "name", "score", "tags"], "rows": []}'::jsonb AS empty_named,
+       msgpack_to_jsonb(rows_to_msgpack_compact(ARRAY[NULL::record])) =
+           '{"columns": [], "rows": [null]}'::jsonb AS untyped_nulls;
+
+-- msgpack_to_recordset reads compact batches back.
+SELECT (SELECT array_agg(r ORDER BY r.id)
+        FROM msgpack_to_recordset(NULL::pgz_cmp_src, rows_to_msgpack_compact(a)) AS r) =
+       (SELECT array_agg(t ORDER BY id) FROM pgz_cmp_src AS t) AS compact_round_trip
+FROM (SELECT array_agg(t ORDER BY id) AS a FROM pgz_cmp_src AS t) AS s;
+
+SELECT count(*) = 3 AND count(r.id) = 2 AS null_rows_kept
+FROM msgpack_to_recordset(NULL::pgz_cmp_src,
+                          rows_to_msgpack_compact(ARRAY[ROW(1, 'a', 1, NULL)::pgz_cmp_src,
+                                                        NULL,
+                                                        ROW(3, 'c', 3, NULL)::pgz_cmp_src])) AS r;
+
+-- Columns resolve by name, so order may differ and unknown names are skipped.
+SELECT r.id = 7 AND r.name = 'x' AND r.score IS NULL AS by_name
+FROM msgpack_to_recordset(NULL::pgz_cmp_src,
+                          msgpack_from_jsonb('{"columns": ["name", "zzz", "id"],
+                                               "rows": [["x", true, 7]]}')) AS r;
+
+SELECT rows_to_msgpack_compact(ARRAY[ROW(1), ROW(1, 2)]);
+SELECT * FROM msgpack_to_recordset(NULL::pgz_cmp_src,
+                                   msgpack_from_jsonb('{"columns": ["id"], "rows": [[1, 2]]}'));
+SELECT * FROM msgpack_to_recordset(NULL::pgz_cmp_src,
+                                   msgpack_from_jsonb('{"columns": ["id"], "rows": [{"id": 1}]}'));
+
+DROP TABLE pgz_cmp_src;
+DROP TYPE pgz_cmp_inner;
+DROP EXTENSION pg_zerialize;
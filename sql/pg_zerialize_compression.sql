@@ -0,0 +1,70 @@
+SET client_min_messages TO warning;
+DROP EXTENSION IF EXISTS pg_zerialize CASCADE;
+CREATE EXTENSION pg_zerialize;
+
+CREATE TYPE pgz_compress_inner AS (k int, v text);
+CREATE TABLE pgz_compress_src (id int, name text, score float8, tags text[], inner_row pgz_compress_inner);
+INSERT INTO pgz_compress_src
+SELECT i, CASE WHEN i % 5 = 0 THEN NULL ELSE format('name-%s', i % 40) END, i / 4.0,
+       ARRAY[format('tag-%s', i % 7)], ROW(i, format('value-%s', i % 13))::pgz_compress_inner
+FROM generate_series(1, 3000) AS i;
+
+CREATE TEMP TABLE pgz_compress_batches AS
+SELECT rows_to_msgpack(a) AS m, rows_to_cbor(a) AS c, rows_to_zera(a) AS z,
+       rows_to_flexbuffers(a) AS f
+FROM (SELECT array_agg(t ORDER BY id) AS a FROM pgz_compress_src AS t) AS s;
+
+-- Each frame unwraps to the plain batch byte for byte and is much smaller.
+SELECT zerialize_decompress(rows_to_msgpack(a, 'lz4')) = b.m AS msgpack_lz4,
+       zerialize_decompress(rows_to_msgpack(a, 'zstd')) = b.m AS msgpack_zstd,
+       zerialize_decompress(rows_to_cbor(a, 'zstd', 19)) = b.c AS cbor_zstd_19,
+       zerialize_decompress(rows_to_zera(a, compression => 'lz4', level => 9)) = b.z AS zera_lz4hc,
+       zerialize_decompress(rows_to_flexbuffers(a, 'zstd', -5)) = b.f AS flex_zstd_fast,
+       octet_length(rows_to_msgpack(a, 'zstd')) * 3 < octet_length(b.m) AS zstd_smaller,
+       octet_length(rows_to_msgpack(a, 'lz4')) * 2 < octet_length(b.m) AS lz4_smaller,
+       rows_to_msgpack(a, 'none') = b.m AS none_is_plain
+FROM (SELECT array_agg(t ORDER BY id) AS a FROM pgz_compress_src AS t) AS s,
+     pgz_compress_batches AS b;
+
+-- The header names the codec, the protocol, and the uncompressed length.
+SELECT substr(rows_to_msgpack(a, 'lz4'), 1, 8) = '\xc150475a01010100'::bytea AS msgpack_lz4_header,
+       substr(rows_to_zera(a, 'zstd'), 1, 8) = '\xc150475a01020300'::bytea AS zera_zstd_header,
+       substr(rows_to_flexbuffers(a, 'lz4'), 1, 8) = '\xc150475a01010400'::bytea AS flex_lz4_header,
+       ('x' || encode(substr(rows_to_cbor(a, 'zstd'), 9, 8), 'hex'))::bit(64)::bigint =
+           octet_length(b.c) AS length_recorded
+FROM (SELECT array_agg(t ORDER BY id) AS a FROM pgz_compress_src AS t) AS s,
+     pgz_compress_batches AS b;
+
+-- Decoders unwrap frames transparently.
+SELECT msgpack_to_jsonb(rows_to_msgpack(a, 'zstd')) = msgpack_to_jsonb(b.m) AS msgpack_decodes,
+       cbor_to_jsonb(rows_to_cbor(a, 'lz4')) = cbor_to_jsonb(b.c) AS cbor_decodes,
+       zera_to_jsonb(rows_to_zera(a, 'zstd')) = zera_to_jsonb(b.z) AS zera_decodes,
+       flexbuffers_to_jsonb(rows_to_flexbuffers(a, 'lz4')) = flexbuffers_to_jsonb(b.f)
+           AS flex_decodes,
+       zerialize_decompress(b.m) = b.m AS plain_passes_through
+FROM (SELECT array_agg(t ORDER BY id) AS a FROM pgz_compress_src AS t) AS s,
+     pgz_compress_batches AS b;
+
+SELECT rows_to_msgpack(ARRAY[ROW(1, 'x')], 'brotli');
+SELECT rows_to_msgpack(ARRAY[ROW(1, 'x')], 'lz4', 13);
+SELECT cbor_to_jsonb(rows_to_msgpack(ARRAY[ROW(1, 'x')], 'lz4'));
+SELECT zerialize_decompress('\xc150475a0101010000000000000000ff01'::bytea);
+
+-- Only a fully valid header marks a frame; other input decodes as a document.
+SELECT zerialize_decompress('\xc150475a010301000000000000000000'::bytea) =
+           '\xc150475a010301000000000000000000'::bytea AS unknown_codec_passes_through,
+       zerialize_decompress('\xc150475a65640001080101010104022401'::bytea) =
+           '\xc150475a65640001080101010104022401'::bytea AS flex_key_passes_through;
+SELECT msgpack_to_jsonb('\xc150475a0102010000000000ffffffff'::bytea);
+-- {"\xc1PGZed": 1}: decodes in LATIN1, and in UTF8 fails on the key, not as a frame.
+DO $$
+BEGIN
+    PERFORM flexbuffers_to_jsonb('\xc150475a65640001080101010104022401'::bytea);
+EXCEPTION WHEN invalid_binary_representation THEN
+    NULL;
+END
+$$;
+
+DROP TABLE pgz_compress_src;
+DROP TYPE pgz_compress_inner;
+DROP EXTENSION pg_zerialize;
@@ -0,0 +1,82 @@
+SET client_min_messages TO warning;
+DROP EXTENSION IF EXISTS pg_zerialize CASCADE;
+CREATE EXTENSION pg_zerialize;
+
+CREATE TABLE pgz_dec_items (id int PRIMARY KEY, name text, score float8, tags text[]);
+CREATE TABLE pgz_dec_full (id int, note text);
+ALTER TABLE pgz_dec_full REPLICA IDENTITY FULL;
+CREATE TABLE pgz_dec_toast (id int PRIMARY KEY, flag bool, body text);
+
+SELECT slot_name FROM pg_create_logical_replication_slot('pgz_dec_slot', 'pg_zerialize_decoding');
+
+-- Old rows carry the replica identity columns, or the whole row under FULL.
+INSERT INTO pgz_dec_items VALUES (1, 'a', 1.5, ARRAY['x']), (2, 'b', NULL, NULL);
+UPDATE pgz_dec_items SET name = 'c' WHERE id = 1;
+UPDATE pgz_dec_items SET id = 3 WHERE id = 2;
+DELETE FROM pgz_dec_items WHERE id = 1;
+INSERT INTO pgz_dec_full VALUES (1, 'n');
+UPDATE pgz_dec_full SET note = 'm';
+DELETE FROM pgz_dec_full;
+TRUNCATE pgz_dec_items;
+
+SELECT msgpack_to_jsonb(data) AS record
+FROM pg_logical_slot_get_binary_changes('pgz_dec_slot', NULL, NULL);
+
+-- TOAST values an update did not log are reported instead of fetched.
+INSERT INTO pgz_dec_toast
+SELECT 1, false, string_agg(md5(i::text), '') FROM generate_series(1, 300) AS i;
+SELECT count(*) AS insert_records
+FROM pg_logical_slot_get_binary_changes('pgz_dec_slot', NULL, NULL);
+UPDATE pgz_dec_toast SET flag = true;
+
+SELECT msgpack_to_jsonb(data) AS record
+FROM pg_logical_slot_get_binary_changes('pgz_dec_slot', NULL, NULL);
+
+-- Every protocol writes the same records.
+INSERT INTO pgz_dec_items VALUES (4, 'd', 2.25, ARRAY['y', NULL]);
+
+SELECT bool_and(cbor_to_jsonb(c.data) = msgpack_to_jsonb(m.data)) AS cbor_matches,
+       bool_and(zera_to_jsonb(z.data) = msgpack_to_jsonb(m.data)) AS zera_matches,
+       bool_and(flexbuffers_to_jsonb(f.data) = msgpack_to_jsonb(m.data)) AS flex_matches
+FROM pg_logical_slot_peek_binary_changes('pgz_dec_slot', NULL, NULL) WITH ORDINALITY AS m(lsn, xid, data, n)
+JOIN pg_logical_slot_peek_binary_changes('pgz_dec_slot', NULL, NULL, 'format', 'cbor')
+     WITH ORDINALITY AS c(lsn, xid, data, n) USING (n)
+JOIN pg_logical_slot_peek_binary_changes('pgz_dec_slot', NULL, NULL, 'format', 'zera')
+     WITH ORDINALITY AS z(lsn, xid, data, n) USING (n)
+JOIN pg_logical_slot_peek_binary_changes('pgz_dec_slot', NULL, NULL, 'format', 'flexbuffers')
+     WITH ORDINALITY AS f(lsn, xid, data, n) USING (n);
+
+SELECT bool_and(msgpack_to_jsonb(data) ? 'xid') AS xids_included,
+       bool_or(msgpack_to_jsonb(data) ? 'commit_time') AS commit_time_included
+FROM pg_logical_slot_peek_binary_changes('pgz_dec_slot', NULL, NULL,
+     'include-xids', 'on', 'include-timestamp', 'on')
+WHERE msgpack_to_jsonb(data)->>'action' IN ('B', 'C');
+
+SELECT msgpack_to_jsonb(data) AS record
+FROM pg_logical_slot_get_binary_changes('pgz_dec_slot', NULL, NULL, 'include-transaction', 'off');
+
+-- Each decoded change is its own cache scope, so one long decoding call
+-- still trims the schema cache.
+CREATE TABLE pgz_dec_lru1 (v int);
+CREATE TABLE pgz_dec_lru2 (v text);
+CREATE TABLE pgz_dec_lru3 (v bool);
+INSERT INTO pgz_dec_lru1 VALUES (1);
+INSERT INTO pgz_dec_lru2 VALUES ('x');
+INSERT INTO pgz_dec_lru3 VALUES (true);
+SET pg_zerialize.schema_cache_max_entries = 2;
+SELECT count(*) AS lru_records
+FROM pg_logical_slot_get_binary_changes('pgz_dec_slot', NULL, NULL, 'include-transaction', 'off');
+SELECT count(*) <= 2 AS lru_bounded FROM pg_zerialize_schema_cache WHERE NOT projected;
+RESET pg_zerialize.schema_cache_max_entries;
+
+SELECT count(*) FROM pg_logical_slot_get_binary_changes('pgz_dec_slot', NULL, NULL, 'format', 'json');
+SELECT count(*) FROM pg_logical_slot_get_binary_changes('pgz_dec_slot', NULL, NULL, 'pretty', 'on');
+
+SELECT pg_drop_replication_slot('pgz_dec_slot');
+DROP TABLE pgz_dec_lru3;
+DROP TABLE pgz_dec_lru2;
+DROP TABLE pgz_dec_lru1;
+DROP TABLE pgz_dec_toast;
+DROP TABLE pgz_dec_full;
+DROP TABLE pgz_dec_items;
+DROP EXTENSION pg_zerialize;
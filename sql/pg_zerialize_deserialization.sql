@@ -42,6 +42,15 @@ SELECT msgpack_to_jsonb(decode('dc0002c2c3', 'hex')) =
        msgpack_to_jsonb(decode('df00000001a16101', 'hex')) =
            '{"a":1}'::jsonb AS map32_value;
 
+SELECT msgpack_to_jsonb(decode('cb3fb999999999999a', 'hex')) =
+           '0.10000000000000001'::jsonb AS float64_digits,
+       msgpack_to_jsonb(decode('82a17a91a0a161c3', 'hex')) =
+           '{"a":true,"z":[""]}'::jsonb AS nested_after_key;
+
+SELECT msgpack_to_jsonb(msgpack_from_jsonb(j)) = j AS wide_object_roundtrip
+FROM (SELECT jsonb_object_agg(format('k%s', i), i) AS j
+      FROM generate_series(1, 500) AS i) s;
+
 SELECT msgpack_to_jsonb(msgpack_build_object(
            'quoted', E'a"b\\c\n',
            'nested', ARRAY[[1, NULL], [3, 4]]
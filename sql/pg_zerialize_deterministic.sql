@@ -25,5 +25,16 @@ SELECT row_to_flexbuffers(ROW(7, 'det', true, 42.5::numeric, ARRAY[1,2,3])::pgz_
 SELECT encode(row_to_msgpack(ROW(1, 'a', true, 1::numeric, ARRAY[1])::pgz_det), 'hex')
      = encode(row_to_msgpack_slow(ROW(1, 'a', true, 1::numeric, ARRAY[1])::pgz_det), 'hex') AS msgpack_hex_parity;
 
+-- Reused output buffers: small rows after large ones decode to the same values.
+SELECT bool_and(row_to_msgpack(r) = row_to_msgpack_slow(r)) AS msgpack_reuse_parity,
+       bool_and(cbor_to_jsonb(row_to_cbor(r)) = msgpack_to_jsonb(row_to_msgpack(r))) AS cbor_reuse_parity,
+       bool_and(zera_to_jsonb(row_to_zera(r)) = msgpack_to_jsonb(row_to_msgpack(r))) AS zera_reuse_parity,
+       bool_and(flexbuffers_to_jsonb(row_to_flexbuffers(r)) = msgpack_to_jsonb(row_to_msgpack(r)))
+           AS flex_reuse_parity
+FROM (
+    SELECT ROW(i, repeat('x', (i * 7919) % 20000), i % 2 = 0, i::numeric, ARRAY[i])::pgz_det AS r
+    FROM generate_series(1, 200) AS i
+) s;
+
 DROP TYPE pgz_det;
 DROP EXTENSION pg_zerialize;
@@ -0,0 +1,94 @@
+SET client_min_messages TO warning;
+DROP EXTENSION IF EXISTS pg_zerialize CASCADE;
+CREATE EXTENSION pg_zerialize;
+
+CREATE TYPE pg_temp.pgz_extract_inner AS (k int, v text);
+CREATE TEMP TABLE pgz_extract_src AS
+SELECT 42::int AS id,
+       'alpha'::text AS name,
+       2.5::float8 AS score,
+       true AS ok,
+       NULL::text AS missing,
+       '\x00ff'::bytea AS payload,
+       ARRAY[10, 20, 30] AS nums,
+       ROW(7, 'seven')::pg_temp.pgz_extract_inner AS inner_row,
+       9007199254740993::int8 AS big;
+
+-- Extraction matches the full decoders for every protocol.
+SELECT msgpack_extract_int8(row_to_msgpack(t), '{id}') = 42 AS msgpack_int8,
+       msgpack_extract_text(row_to_msgpack(t), '{name}') = 'alpha' AS msgpack_text,
+       msgpack_extract_float8(row_to_msgpack(t), '{score}') = 2.5 AS msgpack_float8,
+       msgpack_extract_text(row_to_msgpack(t), '{ok}') = 'true' AS msgpack_bool_text,
+       msgpack_extract_int8(row_to_msgpack(t), '{big}') = 9007199254740993 AS msgpack_big_exact,
+       msgpack_extract_int8(row_to_msgpack(t), '{inner_row,k}') = 7 AS msgpack_nested
+FROM pgz_extract_src AS t;
+
+SELECT cbor_extract_int8(row_to_cbor(t), '{id}') = 42 AS cbor_int8,
+       cbor_extract_text(row_to_cbor(t), '{name}') = 'alpha' AS cbor_text,
+       cbor_extract_float8(row_to_cbor(t), '{score}') = 2.5 AS cbor_float8,
+       cbor_extract_int8(row_to_cbor(t), '{nums,-1}') = 30 AS cbor_negative_index,
+       cbor_extract_text(row_to_cbor(t), '{inner_row,v}') = 'seven' AS cbor_nested
+FROM pgz_extract_src AS t;
+
+SELECT zera_extract_int8(row_to_zera(t), '{id}') = 42 AS zera_int8,
+       zera_extract_text(row_to_zera(t), '{name}') = 'alpha' AS zera_text,
+       zera_extract_float8(row_to_zera(t), '{score}') = 2.5 AS zera_float8,
+       zera_extract_int8(row_to_zera(t), '{nums,1}') = 20 AS zera_index,
+       zera_extract(row_to_zera(t), '{inner_row}') =
+           '{"k":7,"v":"seven"}'::jsonb AS zera_subtree
+FROM pgz_extract_src AS t;
+
+-- Slices are standalone documents of the same protocol.
+SELECT msgpack_to_jsonb(msgpack_extract(row_to_msgpack(t), '{inner_row}')) =
+           '{"k":7,"v":"seven"}'::jsonb AS msgpack_slice,
+       msgpack_extract(row_to_msgpack(t), '{nums}') =
+           msgpack_build_array(10, 20, 30) AS msgpack_slice_bytes,
+       cbor_to_jsonb(cbor_extract(row_to_cbor(t), '{nums}')) =
+           '[10,20,30]'::jsonb AS cbor_slice,
+       msgpack_extract(row_to_msgpack(t), '{}') = row_to_msgpack(t) AS empty_path_is_root
+FROM pgz_extract_src AS t;
+
+-- Text extraction agrees with #>> on the decoded document.
+SELECT bool_and(msgpack_extract_text(m, p) IS NOT DISTINCT FROM msgpack_to_jsonb(m) #>> p)
+           AS msgpack_text_parity,
+       bool_and(cbor_extract_text(c, p) IS NOT DISTINCT FROM cbor_to_jsonb(c) #>> p)
+           AS cbor_text_parity,
+       bool_and(zera_extract_text(z, p) IS NOT DISTINCT FROM zera_to_jsonb(z) #>> p)
+           AS zera_text_parity
+FROM (SELECT row_to_msgpack(t) AS m, row_to_cbor(t) AS c, row_to_zera(t) AS z
+      FROM pgz_extract_src AS t) AS docs,
+     (VALUES ('{id}'::text[]), ('{score}'), ('{ok}'), ('{missing}'), ('{payload}'),
+             ('{nums}'), ('{nums,0}'), ('{nums,-3}'), ('{inner_row}'), ('{big}'))
+         AS paths(p);
+
+-- Unresolvable paths return NULL.
+SELECT msgpack_extract(row_to_msgpack(t), '{nope}') IS NULL AS msgpack_missing_key,
+       msgpack_extract(row_to_msgpack(t), '{nums,3}') IS NULL AS msgpack_index_past_end,
+       msgpack_extract(row_to_msgpack(t), '{nums,x}') IS NULL AS msgpack_index_not_integer,
+       msgpack_extract(row_to_msgpack(t), '{id,k}') IS NULL AS msgpack_scalar_step,
+       msgpack_extract_int8(row_to_msgpack(t), '{missing}') IS NULL AS msgpack_nil_is_null,
+       cbor_extract(row_to_cbor(t), ARRAY['nums', NULL]) IS NULL AS cbor_null_step,
+       zera_extract(row_to_zera(t), '{nums,-4}') IS NULL AS zera_index_before_start
+FROM pgz_extract_src AS t;
+
+-- Indefinite-length CBOR containers are walked without a count.
+SELECT cbor_extract_int8(decode('bf6161820102ff', 'hex'), '{a,1}') = 2 AS cbor_indefinite_map,
+       cbor_extract_int8(decode('9f010203ff', 'hex'), '{-1}') = 3 AS cbor_indefinite_tail,
+       cbor_extract(decode('9f010203ff', 'hex'), '{3}') IS NULL AS cbor_indefinite_past_end,
+       cbor_extract(decode('a1616101', 'hex'), '{a,b}') IS NULL AS cbor_scalar_leaf;
+
+-- Typed extraction does not coerce across kinds.
+SELECT msgpack_extract_int8(row_to_msgpack(t), '{name}')
+FROM pgz_extract_src AS t;
+
+SELECT msgpack_extract_int8(decode('cfffffffffffffffff', 'hex'), '{}');
+
+SELECT zera_extract_float8(row_to_zera(t), '{inner_row}')
+FROM pgz_extract_src AS t;
+
+-- Malformed input along the path is rejected.
+SELECT msgpack_extract(decode('82a16101', 'hex'), '{b}');
+
+DROP TABLE pgz_extract_src;
+DROP TYPE pg_temp.pgz_extract_inner;
+DROP EXTENSION pg_zerialize;
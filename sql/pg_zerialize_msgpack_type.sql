@@ -0,0 +1,105 @@
+SET client_min_messages TO warning;
+DROP EXTENSION IF EXISTS pg_zerialize CASCADE;
+CREATE EXTENSION pg_zerialize;
+
+-- JSON text input; bytea casts and send keep the bytes.
+SELECT '{"b": [1, 2.5, null], "a": "x"}'::msgpack::text = '{"a": "x", "b": [1, 2.5, null]}'
+           AS text_roundtrip,
+       '{"a": 1}'::msgpack::bytea = msgpack_from_jsonb('{"a": 1}') AS text_input_bytes,
+       '\x82a162c3a161c0'::bytea::msgpack::bytea = '\x82a162c3a161c0'::bytea AS bytea_cast_keeps_bytes,
+       msgpack_send('\x92cd0100c0'::bytea::msgpack) = '\x92cd0100c0'::bytea AS send_raw,
+       msgpack_to_jsonb('{"k": [true]}'::msgpack) = '{"k": [true]}'::jsonb AS bytea_functions_accept,
+       '{"k": 1}'::jsonb::msgpack::jsonb = '{"k": 1}'::jsonb AS jsonb_casts;
+
+-- Text output is lossless: values JSON cannot reproduce print as hex.
+SELECT '\x82a162c403010203a161d6ff00000001'::bytea::msgpack::text
+           = '\x82a162c403010203a161d6ff00000001' AS bin_ext_print_hex,
+       '\x82a162c403010203a161d6ff00000001'::bytea::msgpack::text::msgpack::bytea
+           = '\x82a162c403010203a161d6ff00000001'::bytea AS bin_ext_roundtrip,
+       '\x93cd0001ca3fc00000cb4004000000000000'::bytea::msgpack::text::msgpack::bytea
+           = '\x93cd0001ca3fc00000cb4004000000000000'::bytea AS widths_roundtrip,
+       '\x82a162c3a161c2'::bytea::msgpack::text::msgpack::bytea
+           = '\x82a162c3a161c2'::bytea AS key_order_roundtrip,
+       '{"a": [1, 2.5, "x"]}'::msgpack::text = '{"a": [1, 2.5, "x"]}' AS json_stays_json;
+
+-- -> and ->> follow jsonb: key steps on maps, index steps on arrays.
+SELECT ('{"a": {"b": [10, 20, 30]}, "n": null}'::msgpack -> 'a' -> 'b' -> 1)::text = '20'
+           AS arrow_chain,
+       '{"a": {"b": [10, 20, 30]}}'::msgpack -> 'a' -> 'b' ->> -1 = '30' AS arrow_text_negative,
+       '{"a": {"b": 1}}'::msgpack ->> 'a' = '{"b": 1}' AS arrow_text_container,
+       '{"a": "x"}'::msgpack ->> 'a' = 'x' AS arrow_text_string,
+       ('{"n": null}'::msgpack ->> 'n') IS NULL AS null_text_is_null,
+       ('{"n": null}'::msgpack -> 'n')::text = 'null' AS null_value,
+       ('{"0": 1}'::msgpack -> 0) IS NULL AS index_on_map,
+       ('[1, 2]'::msgpack -> '0') IS NULL AS key_on_array,
+       ('{"a": 1}'::msgpack -> 'b') IS NULL AS missing_key,
+       ('[1]'::msgpack -> 5) IS NULL AS missing_index;
+
+-- Containment compares integers by value, whatever their width.
+SELECT '{"a": 1, "b": {"c": [1, 2, 3]}}'::msgpack @> '{"b": {"c": [3, 1]}}' AS nested_contains,
+       '{"a": 1}'::msgpack @> '{"a": 1.0}' AS integral_float_matches,
+       '\x81a161cd0001'::bytea::msgpack @> '{"a": 1}' AS wide_integer_matches,
+       NOT ('{"a": 1}'::msgpack @> '{"a": 2}') AS value_mismatch,
+       NOT ('{"a": [1, 2]}'::msgpack @> '{"a": 1}') AS array_needs_array,
+       NOT ('{"a": "1"}'::msgpack @> '{"a": 1}') AS string_is_not_number,
+       '[{"k": 1}, {"k": 2}]'::msgpack @> '[{"k": 2}]' AS array_of_maps,
+       '{"a": 1}'::msgpack <@ '{"a": 1, "b": 2}' AS contained_by,
+       '{}'::msgpack <@ '{"a": 1}' AS empty_map,
+       '["a", "b"]'::msgpack @> '"b"' AS top_array_contains_scalar,
+       NOT ('["a"]'::msgpack @> '"b"') AS top_array_scalar_mismatch;
+
+-- Integral floats past int64 match the unsigned integer of the same value.
+SELECT '\x81a161cf8000000000000000'::bytea::msgpack @> '\x81a161cb43e0000000000000'::bytea::msgpack
+           AS uint64_float_matches,
+       '\x81a161cb43e0000000000000'::bytea::msgpack @> '\x81a161cf8000000000000000'::bytea::msgpack
+           AS float_uint64_matches,
+       NOT ('\x81a161cfffffffffffffffff'::bytea::msgpack @>
+            '\x81a161cb43f0000000000000'::bytea::msgpack) AS float_past_uint64_differs;
+
+CREATE TABLE pgz_events (id int, doc msgpack);
+INSERT INTO pgz_events
+SELECT g, msgpack_from_jsonb(jsonb_build_object(
+           'kind', CASE WHEN g % 10 = 0 THEN 'click' ELSE 'view' END,
+           'user', g % 100,
+           'tags', jsonb_build_array('t' || (g % 7)),
+           'meta', jsonb_build_object('ok', g % 2 = 0)))
+FROM generate_series(1, 5000) AS g;
+
+CREATE TEMP TABLE pgz_event_counts AS
+SELECT q, (SELECT count(*) FROM pgz_events AS e WHERE e.doc @> q::msgpack) AS n
+FROM unnest(ARRAY['{"kind": "click"}', '{"kind": "click", "user": 10}', '{"tags": ["t3"]}',
+                  '{"meta": {"ok": true}}', '{"kind": "nope"}', '{}', '{"meta": {}}']) AS q;
+
+CREATE INDEX pgz_events_doc_idx ON pgz_events USING gin (doc);
+SET enable_seqscan = off;
+
+CREATE FUNCTION pg_temp.uses_index(query text) RETURNS boolean
+LANGUAGE plpgsql AS $$
+DECLARE
+  line text;
+BEGIN
+  FOR line IN EXECUTE 'EXPLAIN (COSTS OFF) ' || query LOOP
+    IF line LIKE '%Bitmap Index Scan on pgz_events_doc_idx%' THEN
+      RETURN true;
+    END IF;
+  END LOOP;
+  RETURN false;
+END;
+$$;
+
+-- The GIN index answers @> and agrees with a sequential scan.
+SELECT pg_temp.uses_index('SELECT count(*) FROM pgz_events WHERE doc @> ''{"kind": "click"}''')
+           AS click_uses_index,
+       (SELECT count(*) FROM pgz_events WHERE doc @> '{"kind": "click"}') = 500 AS click_count,
+       (SELECT count(*) FROM pgz_events WHERE doc @> '{"kind": "click", "user": 10}') = 50
+           AS two_key_count,
+       (SELECT bool_and((SELECT count(*) FROM pgz_events AS e WHERE e.doc @> c.q::msgpack) = c.n)
+        FROM pgz_event_counts AS c) AS index_matches_seqscan;
+RESET enable_seqscan;
+
+SELECT '\x81a16101ff'::bytea::msgpack;
+SELECT '\x82a16101a16102'::bytea::msgpack;
+SELECT rows_to_msgpack(ARRAY[ROW(1)], 'lz4')::msgpack;
+
+DROP TABLE pgz_events;
+DROP EXTENSION pg_zerialize;
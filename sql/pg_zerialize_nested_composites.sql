@@ -53,6 +53,15 @@ SELECT octet_length(row_to_msgpack(value)) > 0 AS msgpack_nested,
        octet_length(row_to_flexbuffers(value)) > 0 AS flex_nested
 FROM pgz_nested_values;
 
+-- Every protocol's fast writer recurses into nested rows and decodes alike.
+SELECT cbor_to_jsonb(row_to_cbor(value)) = msgpack_to_jsonb(row_to_msgpack(value))
+           AS cbor_nested_decodes,
+       zera_to_jsonb(row_to_zera(value)) = msgpack_to_jsonb(row_to_msgpack(value))
+           AS zera_nested_decodes,
+       flexbuffers_to_jsonb(row_to_flexbuffers(value)) = msgpack_to_jsonb(row_to_msgpack(value))
+           AS flex_nested_decodes
+FROM pgz_nested_values;
+
 -- Batch conversion preserves nested composites and null outer records.
 SELECT octet_length(rows_to_msgpack(ARRAY[value, NULL::pg_temp.pgz_nested_customer])) > 0 AS msgpack_batch_nested,
        octet_length(rows_to_cbor(ARRAY[value, NULL::pg_temp.pgz_nested_customer])) > 0 AS cbor_batch_nested,
@@ -107,5 +116,38 @@ SELECT row_to_msgpack(
     )::pg_temp.pgz_nested_customer
 ) AS dropped_nested_attribute_parity;
 
+SELECT cbor_to_jsonb(rows_to_cbor(ARRAY[value])) = msgpack_to_jsonb(rows_to_msgpack(ARRAY[value]))
+           AS cbor_nested_after_ddl,
+       zera_to_jsonb(rows_to_zera(ARRAY[value])) = msgpack_to_jsonb(rows_to_msgpack(ARRAY[value]))
+           AS zera_nested_after_ddl,
+       flexbuffers_to_jsonb(rows_to_flexbuffers(ARRAY[value])) =
+           msgpack_to_jsonb(rows_to_msgpack(ARRAY[value])) AS flex_nested_after_ddl
+FROM pgz_nested_values;
+
+-- Memoized child schemas resolve again after their cache entry is evicted.
+CREATE TYPE pg_temp.pgz_memo_leaf AS (v int);
+CREATE TYPE pg_temp.pgz_memo_mid AS (leaf pg_temp.pgz_memo_leaf, leaves pg_temp.pgz_memo_leaf[]);
+CREATE TYPE pg_temp.pgz_memo_other AS (x int);
+SET LOCAL pg_zerialize.schema_cache_max_entries = 2;
+SELECT row_to_msgpack(ROW(ROW(1)::pg_temp.pgz_memo_leaf,
+                          ARRAY[ROW(2)::pg_temp.pgz_memo_leaf])::pg_temp.pgz_memo_mid)
+           IS NOT NULL AS memo_filled;
+
+SELECT row_to_msgpack(ROW(ROW(1)::pg_temp.pgz_memo_leaf,
+                          ARRAY[ROW(2)::pg_temp.pgz_memo_leaf])::pg_temp.pgz_memo_mid)
+           IS NOT NULL AS verdict_kept;
+
+SELECT row_to_msgpack(ROW(NULL, NULL)::pg_temp.pgz_memo_mid) IS NOT NULL AS parent_touched;
+
+SELECT row_to_msgpack(ROW(3)::pg_temp.pgz_memo_other) IS NOT NULL AS child_evicted;
+
+SELECT msgpack_to_jsonb(row_to_msgpack(m)) = j AS msgpack_memo_refreshed,
+       cbor_to_jsonb(row_to_cbor(m)) = j AS cbor_memo_refreshed,
+       zera_to_jsonb(row_to_zera(m)) = j AS zera_memo_refreshed,
+       flexbuffers_to_jsonb(row_to_flexbuffers(m)) = j AS flex_memo_refreshed
+FROM (SELECT ROW(ROW(4)::pg_temp.pgz_memo_leaf,
+                 ARRAY[ROW(5)::pg_temp.pgz_memo_leaf, NULL])::pg_temp.pgz_memo_mid AS m,
+             '{"leaf": {"v": 4}, "leaves": [{"v": 5}, null]}'::jsonb AS j) AS s;
+
 ROLLBACK;
 DROP EXTENSION pg_zerialize;
@@ -69,4 +69,36 @@ SET pg_zerialize.numeric_encoding = 'float64';
 SELECT msgpack_to_jsonb(row_to_msgpack(ROW(1::numeric, 1.25::numeric))) =
        '{"f1":1,"f2":1.25}'::jsonb AS default_semantics_unchanged;
 
+-- Values decoded from the digit array match the int8 and float8 casts.
+CREATE TEMP TABLE pgz_numeric_digits AS
+SELECT t::numeric AS n
+FROM (VALUES ('0'), ('5.000'), ('-7'), ('10000'), ('99999999'), ('100000000.0'),
+             ('9223372036854775807'), ('-9223372036854775808'), ('9223372036854775808'),
+             ('-9223372036854775809'), ('123456789012345678901234567890'), ('0.1'),
+             ('-0.5'), ('0.0001'), ('1.23456789012345678901234567890'),
+             ('3.14159265358979323846264338327950288'), ('1e-300'), ('-2.5e300'),
+             ('4.9e-324'), ('2.2250738585072011e-308'), ('0.30000000000000004'),
+             ('12345678901234567.5'), ('NaN'), ('Infinity'), ('-Infinity')) AS v(t)
+UNION ALL
+SELECT (g * 7919 % 1000003)::numeric / (10::numeric ^ (g % 40)) * (1 - 2 * (g % 2))
+FROM generate_series(1, 2000) AS g;
+
+CREATE FUNCTION pg_temp.pgz_numeric_reference(n numeric)
+RETURNS bytea
+LANGUAGE sql AS $$
+    SELECT CASE WHEN n = trunc(n) AND n BETWEEN -9223372036854775808 AND 9223372036854775807
+                THEN row_to_msgpack(ROW(n::int8))
+                ELSE row_to_msgpack(ROW(n::float8)) END
+$$;
+
+SELECT bool_and(row_to_msgpack(ROW(n)) = pg_temp.pgz_numeric_reference(n)) AS digits_match_casts,
+       bool_and(msgpack_from_jsonb(jsonb_build_array(n)) = msgpack_build_array(n))
+           FILTER (WHERE n::text NOT IN ('NaN', 'Infinity', '-Infinity')) AS jsonb_numerics_match
+FROM pgz_numeric_digits;
+
+SET pg_zerialize.numeric_float_backend = 'postgres';
+SELECT bool_and(row_to_msgpack(ROW(n)) = pg_temp.pgz_numeric_reference(n)) AS postgres_backend_matches
+FROM pgz_numeric_digits;
+RESET pg_zerialize.numeric_float_backend;
+
 DROP EXTENSION pg_zerialize;
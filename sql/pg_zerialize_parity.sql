@@ -135,6 +135,39 @@ BEGIN
 END
 $$;
 
+-- CBOR keys are encoded once per column and Flex keys are written once per
+-- document; names of 24 or more bytes take the longer CBOR key header.
+CREATE TYPE pgz_parity_keys_inner AS (k int, "clé" text);
+CREATE TYPE pgz_parity_keys AS (
+    k int,
+    "twenty_four_bytes_name__" text,
+    "ünïcode_ñame" boolean,
+    inner_rows pgz_parity_keys_inner[]
+);
+CREATE TEMP TABLE pgz_parity_keys_src AS
+SELECT ROW(g, format('v%s', g), g % 2 = 0,
+           ARRAY[ROW(g, 'a')::pgz_parity_keys_inner, ROW(-g, NULL)::pgz_parity_keys_inner]
+       )::pgz_parity_keys AS r
+FROM generate_series(1, 20) AS g;
+
+SELECT bool_and(msgpack_to_cbor(row_to_msgpack(r)) = row_to_cbor(r)) AS cbor_row_keys,
+       bool_and(flexbuffers_to_jsonb(row_to_flexbuffers(r)) = msgpack_to_jsonb(row_to_msgpack(r)))
+           AS flex_row_keys
+FROM pgz_parity_keys_src;
+
+SELECT msgpack_to_cbor(rows_to_msgpack(array_agg(r))) = rows_to_cbor(array_agg(r)) AS cbor_batch_keys,
+       flexbuffers_to_jsonb(rows_to_flexbuffers(array_agg(r))) =
+           msgpack_to_jsonb(rows_to_msgpack(array_agg(r))) AS flex_batch_keys
+FROM pgz_parity_keys_src;
+
+SELECT cbor_build_object('ünïcode_ñame', 1, 'k', ARRAY[1, 2]) =
+           msgpack_to_cbor(msgpack_build_object('ünïcode_ñame', 1, 'k', ARRAY[1, 2]))
+           AS cbor_builder_keys;
+
+DROP TABLE pgz_parity_keys_src;
+DROP TYPE pgz_parity_keys;
+DROP TYPE pgz_parity_keys_inner;
+
 RESET intervalstyle;
 
 DROP TYPE pgz_parity_interval;
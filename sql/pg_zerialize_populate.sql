@@ -0,0 +1,134 @@
+SET client_min_messages TO warning;
+DROP EXTENSION IF EXISTS pg_zerialize CASCADE;
+CREATE EXTENSION pg_zerialize;
+
+CREATE TYPE pg_temp.pgz_pop_inner AS (k int, v text);
+CREATE DOMAIN pg_temp.pgz_pop_positive AS int CHECK (VALUE > 0);
+CREATE TEMP TABLE pgz_pop_src (
+    id int,
+    small int2,
+    name text,
+    code varchar(8),
+    score float8,
+    ratio float4,
+    ok bool,
+    payload bytea,
+    born date,
+    seen timestamp,
+    seen_tz timestamptz,
+    amount numeric,
+    uid uuid,
+    tags text[],
+    inner_row pg_temp.pgz_pop_inner,
+    inner_arr pg_temp.pgz_pop_inner[],
+    grid int[],
+    positive pg_temp.pgz_pop_positive
+);
+INSERT INTO pgz_pop_src
+SELECT i,
+       (i * 3)::int2,
+       CASE WHEN i % 5 = 0 THEN NULL ELSE format('name_%s', i) END,
+       format('c%s', i),
+       i / 4.0,
+       (i / 8.0)::float4,
+       i % 2 = 0,
+       decode(lpad(to_hex(i % 256), 2, '0'), 'hex'),
+       DATE '2024-02-28' + i,
+       TIMESTAMP '2025-01-01 00:00:00' + make_interval(secs => i * 1.5),
+       TIMESTAMPTZ '2025-01-01 00:00:00+00' + make_interval(days => i),
+       i * 2.5,
+       md5(i::text)::uuid,
+       ARRAY[format('t%s', i), NULL],
+       ROW(i, format('v%s', i))::pg_temp.pgz_pop_inner,
+       ARRAY[ROW(i, 'a')::pg_temp.pgz_pop_inner, NULL],
+       ARRAY[[i, i + 1], [i + 2, i + 3]],
+       i
+FROM generate_series(1, 50) AS i;
+
+-- Rows written by row_to_msgpack and rows_to_msgpack decode to equal rows.
+SELECT bool_and(msgpack_populate_record(NULL::pgz_pop_src, row_to_msgpack(t)) = t)
+       AS row_roundtrip
+FROM pgz_pop_src AS t;
+
+SELECT (SELECT array_agg(r ORDER BY r.id)
+        FROM msgpack_to_recordset(NULL::pgz_pop_src,
+                                  (SELECT rows_to_msgpack(array_agg(t ORDER BY id))
+                                   FROM pgz_pop_src AS t)) AS r) =
+       (SELECT array_agg(t ORDER BY id) FROM pgz_pop_src AS t) AS recordset_roundtrip;
+
+SELECT count(*) = 0 AS null_batch_is_empty
+FROM msgpack_to_recordset(NULL::pgz_pop_src, NULL);
+
+-- Missing keys keep the base row's values; unknown keys are skipped.
+SELECT msgpack_populate_record(ROW(1, 'keep')::pg_temp.pgz_pop_inner,
+                               msgpack_build_object('k', 2, 'extra', 'x')) =
+       ROW(2, 'keep')::pg_temp.pgz_pop_inner AS base_fills_missing,
+       msgpack_populate_record(NULL::pg_temp.pgz_pop_inner,
+                               msgpack_build_object('v', 'only')) =
+       ROW(NULL, 'only')::pg_temp.pgz_pop_inner AS missing_is_null,
+       msgpack_populate_record(ROW(1, 'keep')::pg_temp.pgz_pop_inner, NULL) =
+       ROW(1, 'keep')::pg_temp.pgz_pop_inner AS null_input_returns_base,
+       msgpack_populate_record(NULL::pg_temp.pgz_pop_inner, '\xc0'::bytea) IS NULL
+       AS nil_without_base_is_null;
+
+-- Values not in a column's binary form go through its input function.
+SELECT r.id = 42 AS text_to_int,
+       r.score = 3 AS int_to_float,
+       r.ok AS text_to_bool,
+       r.born = DATE '2025-03-01' AS text_to_date,
+       r.payload = '\x0102'::bytea AS text_to_bytea,
+       r.uid = '00000000-0000-0000-0000-000000000001'::uuid AS text_to_uuid,
+       r.positive = 5 AS text_to_domain
+FROM msgpack_populate_record(NULL::pgz_pop_src, msgpack_build_object(
+         'id', '42'::text, 'score', 3, 'ok', 'yes'::text, 'born', '2025-03-01'::text,
+         'payload', '\x0102'::text, 'uid', '00000000-0000-0000-0000-000000000001'::text,
+         'positive', 5)) AS r;
+
+CREATE TEMP TABLE pgz_pop_typed (
+    price numeric(6, 2),
+    label varchar(3),
+    at timestamp(0),
+    doc jsonb,
+    raw json,
+    cube int[]
+);
+
+SELECT r.price = 3.14 AS numeric_typmod,
+       r.at = TIMESTAMP '2025-01-01 00:00:02' AS timestamp_typmod,
+       r.doc = '{"a": [1, {"b": null}]}'::jsonb AS jsonb_structured,
+       r.raw::text = '{"x":1}' AS json_text,
+       r.cube = '{{{1,2}},{{3,4}}}'::int[] AS three_dimensions
+FROM msgpack_populate_record(NULL::pgz_pop_typed, msgpack_from_jsonb(jsonb_build_object(
+         'price', 3.14159,
+         'at', (EXTRACT(EPOCH FROM TIMESTAMP '2025-01-01 00:00:01.6' -
+                TIMESTAMP '2000-01-01') * 1000000)::bigint,
+         'doc', '{"a": [1, {"b": null}]}'::jsonb,
+         'raw', '{"x":1}',
+         'cube', '[[[1, 2]], [[3, 4]]]'::jsonb))) AS r;
+
+SET pg_zerialize.numeric_encoding = 'tagged_decimal';
+SELECT (msgpack_populate_record(NULL::pgz_pop_src,
+                                row_to_msgpack(t))).amount = t.amount AS tagged_decimal
+FROM (SELECT 1 AS id, 123456789012345678901234567890.123456789::numeric AS amount) AS t;
+RESET pg_zerialize.numeric_encoding;
+
+-- nil batch elements produce NULL rows.
+SELECT count(*) = 3 AND count(*) FILTER (WHERE r IS NULL) = 1 AS nil_element_is_null_row
+FROM msgpack_to_recordset(NULL::pg_temp.pgz_pop_inner,
+                          msgpack_from_jsonb('[{"k": 1}, null, {"v": "z"}]')) AS r;
+
+SELECT msgpack_populate_record(NULL::pgz_pop_typed, msgpack_build_object('label', 'toolong'::text));
+SELECT msgpack_populate_record(NULL::pgz_pop_src, msgpack_build_object('small', 70000));
+SELECT msgpack_populate_record(NULL::pgz_pop_src, msgpack_build_object('positive', 0));
+SELECT msgpack_populate_record(NULL::pgz_pop_typed, msgpack_build_object('doc', '\x01'::bytea));
+SELECT msgpack_populate_record(NULL::pgz_pop_typed,
+                               msgpack_from_jsonb('{"cube": [[1, 2], [3]]}'));
+SELECT msgpack_populate_record(NULL::pgz_pop_typed, msgpack_build_array(1, 2));
+SELECT * FROM msgpack_to_recordset(NULL::pgz_pop_typed, msgpack_build_object('a', 1));
+SELECT msgpack_populate_record(NULL::pgz_pop_typed, '\x81a1'::bytea);
+
+DROP TABLE pgz_pop_typed;
+DROP TABLE pgz_pop_src;
+DROP DOMAIN pg_temp.pgz_pop_positive;
+DROP TYPE pg_temp.pgz_pop_inner;
+DROP EXTENSION pg_zerialize;
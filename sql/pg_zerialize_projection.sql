@@ -0,0 +1,84 @@
+SET client_min_messages TO warning;
+DROP EXTENSION IF EXISTS pg_zerialize CASCADE;
+CREATE EXTENSION pg_zerialize;
+
+CREATE TABLE pgz_proj_src (id int, name text, score float8, tags text[], payload bytea);
+INSERT INTO pgz_proj_src
+SELECT i, format('n%s', i), i / 2.0, ARRAY[format('t%s', i)], decode(lpad(to_hex(i), 2, '0'), 'hex')
+FROM generate_series(1, 5) AS i;
+
+-- Keys follow the requested order, not the table order.
+SELECT row_to_msgpack(t, ARRAY['score', 'id']) = msgpack_build_object('score', score, 'id', id)
+           AS msgpack_ordered,
+       msgpack_to_jsonb(row_to_msgpack(t, ARRAY['name', 'tags'])) =
+           jsonb_build_object('name', name, 'tags', tags) AS msgpack_subset
+FROM pgz_proj_src AS t
+WHERE id = 1;
+
+SELECT bool_and(cbor_to_jsonb(row_to_cbor(t, ARRAY['id', 'name'])) =
+                jsonb_build_object('id', id, 'name', name)) AS cbor_subset,
+       bool_and(zera_to_jsonb(row_to_zera(t, ARRAY['id', 'name'])) =
+                jsonb_build_object('id', id, 'name', name)) AS zera_subset,
+       bool_and(flexbuffers_to_jsonb(row_to_flexbuffers(t, ARRAY['id', 'name'])) =
+                jsonb_build_object('id', id, 'name', name)) AS flex_subset
+FROM pgz_proj_src AS t;
+
+-- Projecting every column matches the unprojected encoding.
+SELECT row_to_msgpack(t, ARRAY['id', 'name', 'score', 'tags', 'payload']) = row_to_msgpack(t)
+           AS msgpack_full,
+       row_to_cbor(t, ARRAY['id', 'name', 'score', 'tags', 'payload']) = row_to_cbor(t)
+           AS cbor_full,
+       row_to_zera(t, ARRAY['id', 'name', 'score', 'tags', 'payload']) = row_to_zera(t)
+           AS zera_full
+FROM pgz_proj_src AS t
+WHERE id = 2;
+
+SELECT msgpack_to_jsonb(row_to_msgpack(t, '{}'::text[])) = '{}'::jsonb AS empty_projection
+FROM pgz_proj_src AS t
+WHERE id = 1;
+
+-- Batches share one projection plan and keep NULL rows.
+SELECT msgpack_to_jsonb(rows_to_msgpack(a, ARRAY['id'])) =
+           '[{"id": 1}, null, {"id": 3}]'::jsonb AS msgpack_rows,
+       cbor_to_jsonb(rows_to_cbor(a, ARRAY['id'])) =
+           '[{"id": 1}, null, {"id": 3}]'::jsonb AS cbor_rows,
+       zera_to_jsonb(rows_to_zera(a, ARRAY['id'])) =
+           '[{"id": 1}, null, {"id": 3}]'::jsonb AS zera_rows,
+       flexbuffers_to_jsonb(rows_to_flexbuffers(a, ARRAY['id'])) =
+           '[{"id": 1}, null, {"id": 3}]'::jsonb AS flex_rows
+FROM (SELECT array_agg(CASE WHEN id = 2 THEN NULL ELSE t END ORDER BY id) AS a
+      FROM pgz_proj_src AS t
+      WHERE id <= 3) AS s;
+
+-- Wide rows take the deform path; only the leading attributes are read.
+CREATE TABLE pgz_proj_wide AS
+SELECT i AS c01, i + 1 AS c02, i + 2 AS c03, i + 3 AS c04, i + 4 AS c05,
+       i + 5 AS c06, i + 6 AS c07, i + 7 AS c08, i + 8 AS c09, i + 9 AS c10,
+       i + 10 AS c11, i + 11 AS c12, i + 12 AS c13, i + 13 AS c14, i + 14 AS c15,
+       i + 15 AS c16, i + 16 AS c17, i + 17 AS c18, i + 18 AS c19, i + 19 AS c20,
+       i + 20 AS c21, i + 21 AS c22, i + 22 AS c23, i + 23 AS c24, i + 24 AS c25,
+       format('w%s', i) AS c26
+FROM generate_series(1, 3) AS i;
+
+SELECT bool_and(msgpack_to_jsonb(row_to_msgpack(w, ARRAY['c03', 'c01'])) =
+                jsonb_build_object('c03', c03, 'c01', c01)) AS wide_prefix,
+       bool_and(msgpack_to_jsonb(row_to_msgpack(w, ARRAY['c26'])) =
+                jsonb_build_object('c26', c26)) AS wide_last,
+       msgpack_to_jsonb(rows_to_msgpack(array_agg(w ORDER BY c01), ARRAY['c02'])) =
+           '[{"c02": 2}, {"c02": 3}, {"c02": 4}]'::jsonb AS wide_rows
+FROM pgz_proj_wide AS w;
+
+-- Dropped columns cannot be named; plans are rebuilt after the change.
+ALTER TABLE pgz_proj_src DROP COLUMN score;
+SELECT msgpack_to_jsonb(row_to_msgpack(t, ARRAY['tags', 'id'])) =
+           jsonb_build_object('tags', tags, 'id', id) AS after_drop
+FROM pgz_proj_src AS t
+WHERE id = 1;
+
+SELECT row_to_msgpack(t, ARRAY['score']) FROM pgz_proj_src AS t WHERE id = 1;
+SELECT row_to_cbor(t, ARRAY['id', 'id']) FROM pgz_proj_src AS t WHERE id = 1;
+SELECT rows_to_zera(array_agg(t), ARRAY['id', NULL]) FROM pgz_proj_src AS t;
+
+DROP TABLE pgz_proj_wide;
+DROP TABLE pgz_proj_src;
+DROP EXTENSION pg_zerialize;
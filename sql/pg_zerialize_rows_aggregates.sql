@@ -0,0 +1,102 @@
+SET client_min_messages TO warning;
+DROP EXTENSION IF EXISTS pg_zerialize CASCADE;
+CREATE EXTENSION pg_zerialize;
+
+CREATE TYPE pgz_rows_inner AS (k int, v text);
+CREATE TABLE pgz_rows_src (
+    id int,
+    name text,
+    score float8,
+    ok bool,
+    payload bytea,
+    tags text[],
+    inner_row pgz_rows_inner,
+    inner_arr pgz_rows_inner[]
+);
+INSERT INTO pgz_rows_src
+SELECT i,
+       CASE WHEN i % 7 = 0 THEN NULL ELSE format('name_%s', i) END,
+       i / 4.0,
+       i % 2 = 0,
+       decode(lpad(to_hex(i % 256), 2, '0'), 'hex'),
+       ARRAY[format('t%s', i), NULL],
+       ROW(i, format('v%s', i))::pgz_rows_inner,
+       ARRAY[ROW(i, 'a')::pgz_rows_inner, NULL]
+FROM generate_series(1, 2000) AS i;
+
+-- Serial aggregation is byte-identical to the array-based batch functions.
+SELECT msgpack_rows_agg(t ORDER BY id) = rows_to_msgpack(array_agg(t ORDER BY id)) AS msgpack_parity,
+       cbor_rows_agg(t ORDER BY id) = rows_to_cbor(array_agg(t ORDER BY id)) AS cbor_parity,
+       zera_rows_agg(t ORDER BY id) = rows_to_zera(array_agg(t ORDER BY id)) AS zera_parity,
+       flexbuffers_rows_agg(t ORDER BY id) = rows_to_flexbuffers(array_agg(t ORDER BY id))
+           AS flex_parity
+FROM pgz_rows_src AS t;
+
+SELECT msgpack_rows_agg(r ORDER BY id) = rows_to_msgpack(array_agg(r ORDER BY id)) AS msgpack_null_rows,
+       cbor_rows_agg(r ORDER BY id) = rows_to_cbor(array_agg(r ORDER BY id)) AS cbor_null_rows,
+       zera_rows_agg(r ORDER BY id) = rows_to_zera(array_agg(r ORDER BY id)) AS zera_null_rows,
+       flexbuffers_rows_agg(r ORDER BY id) = rows_to_flexbuffers(array_agg(r ORDER BY id))
+           AS flex_null_rows
+FROM (
+    SELECT id, CASE WHEN id % 3 = 0 THEN NULL ELSE ROW(id, name)::pgz_rows_inner END AS r
+    FROM pgz_rows_src
+    WHERE id <= 20
+) s;
+
+SELECT msgpack_rows_agg(t) IS NULL AND cbor_rows_agg(t) IS NULL AND
+       zera_rows_agg(t) IS NULL AND flexbuffers_rows_agg(t) IS NULL AS empty_is_null
+FROM pgz_rows_src AS t
+WHERE false;
+
+-- Partial states from parallel workers combine into one document.
+CREATE FUNCTION pgz_rows_plan_is_partial(query text)
+RETURNS boolean
+LANGUAGE plpgsql AS $$
+DECLARE
+    line text;
+BEGIN
+    FOR line IN EXECUTE 'EXPLAIN (COSTS OFF) ' || query LOOP
+        IF line LIKE '%Partial Aggregate%' THEN
+            RETURN true;
+        END IF;
+    END LOOP;
+    RETURN false;
+END
+$$;
+
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SET max_parallel_workers_per_gather = 2;
+
+SELECT pgz_rows_plan_is_partial('SELECT msgpack_rows_agg(t) FROM pgz_rows_src t') AS msgpack_partial,
+       pgz_rows_plan_is_partial('SELECT zera_rows_agg(t) FROM pgz_rows_src t') AS zera_partial;
+
+SELECT (SELECT jsonb_agg(e ORDER BY (e->>'id')::int)
+        FROM jsonb_array_elements(msgpack_to_jsonb(m)) AS e) =
+       msgpack_to_jsonb(rows_to_msgpack(a)) AS msgpack_parallel_rows,
+       (SELECT jsonb_agg(e ORDER BY (e->>'id')::int)
+        FROM jsonb_array_elements(cbor_to_jsonb(c)) AS e) =
+       cbor_to_jsonb(rows_to_cbor(a)) AS cbor_parallel_rows,
+       (SELECT jsonb_agg(e ORDER BY (e->>'id')::int)
+        FROM jsonb_array_elements(zera_to_jsonb(z)) AS e) =
+       zera_to_jsonb(rows_to_zera(a)) AS zera_parallel_rows,
+       (SELECT jsonb_agg(e ORDER BY (e->>'id')::int)
+        FROM jsonb_array_elements(flexbuffers_to_jsonb(f)) AS e) =
+       flexbuffers_to_jsonb(rows_to_flexbuffers(a)) AS flex_parallel_rows
+FROM (SELECT msgpack_rows_agg(t) AS m,
+             cbor_rows_agg(t) AS c,
+             zera_rows_agg(t) AS z,
+             flexbuffers_rows_agg(t) AS f
+      FROM pgz_rows_src AS t) AS p,
+     (SELECT array_agg(t ORDER BY id) AS a FROM pgz_rows_src AS t) AS s;
+
+RESET max_parallel_workers_per_gather;
+RESET min_parallel_table_scan_size;
+RESET parallel_tuple_cost;
+RESET parallel_setup_cost;
+
+DROP FUNCTION pgz_rows_plan_is_partial(text);
+DROP TABLE pgz_rows_src;
+DROP TYPE pgz_rows_inner;
+DROP EXTENSION pg_zerialize;
@@ -0,0 +1,93 @@
+SET client_min_messages TO warning;
+DROP EXTENSION IF EXISTS pg_zerialize CASCADE;
+CREATE EXTENSION pg_zerialize;
+
+CREATE TYPE pgz_stats_plain AS (id int, label text);
+CREATE TYPE pgz_stats_odd AS (id int, v int2vector[]);
+CREATE TYPE pgz_stats_outer AS (id int, inner_row pgz_stats_odd);
+CREATE TABLE pgz_stats_src (id int, label text);
+INSERT INTO pgz_stats_src VALUES (1, 'a'), (2, 'b'), (3, 'c');
+
+CREATE FUNCTION pgz_stat(m text, p text DEFAULT NULL, e text DEFAULT NULL)
+RETURNS bigint
+LANGUAGE sql AS $$
+    SELECT value FROM pg_zerialize_stats()
+    WHERE metric = m AND protocol IS NOT DISTINCT FROM p AND entry_point IS NOT DISTINCT FROM e
+$$;
+
+-- Every protocol and entry point is listed, with the cache metrics after them.
+SELECT count(*) = 84 AND count(*) FILTER (WHERE protocol IS NULL) = 4 AS all_metrics_listed
+FROM pg_zerialize_stats();
+
+SELECT pg_zerialize_stats_reset() IS NOT NULL AS reset;
+SELECT sum(value) = 0 AS reset_zeroes
+FROM pg_zerialize_stats();
+
+-- Fast rows count one document, its rows, and its bytes.
+CREATE TEMP TABLE pgz_stats_docs AS
+SELECT row_to_msgpack(ROW(1, 'a')::pgz_stats_plain) AS doc;
+
+SELECT pgz_stat('fast_path', 'msgpack', 'row') = 1 AND
+       pgz_stat('rows', 'msgpack', 'row') = 1 AND
+       pgz_stat('bytes', 'msgpack', 'row') = (SELECT octet_length(doc) FROM pgz_stats_docs)
+           AS row_fast_counted;
+
+-- Fallbacks name their reason and still count the rows they encode.
+SELECT row_to_msgpack(ROW(1, ARRAY['1 2'::int2vector])::pgz_stats_odd) IS NOT NULL AS unsupported_row,
+       row_to_msgpack(ROW(1, ROW(2, ARRAY['3'::int2vector])::pgz_stats_odd)::pgz_stats_outer)
+           IS NOT NULL AS recursive_row;
+
+SELECT pgz_stat('fallback_unsupported', 'msgpack', 'row') = 1 AND
+       pgz_stat('fallback_recursive', 'msgpack', 'row') = 1 AND
+       pgz_stat('fast_path', 'msgpack', 'row') = 1 AND
+       pgz_stat('rows', 'msgpack', 'row') = 3 AS fallback_reasons;
+
+-- Batches count one document and every element in it.
+SELECT rows_to_cbor(ARRAY[ROW(1, 'a'), ROW(2, 'b'), NULL]::pgz_stats_plain[]) IS NOT NULL AS cbor_rows,
+       rows_to_zera_compact(ARRAY[ROW(1, 'a'), ROW(2, 'b'), NULL]::pgz_stats_plain[])
+           IS NOT NULL AS zera_compact;
+
+SELECT pgz_stat('fast_path', 'cbor', 'rows') = 1 AND
+       pgz_stat('rows', 'cbor', 'rows') = 3 AND
+       pgz_stat('fast_path', 'zera', 'compact') = 1 AND
+       pgz_stat('rows', 'zera', 'compact') = 3 AS batches_counted;
+
+-- Streamed rows are embedded in larger documents.
+SELECT count(*) = 1 AS streamed
+FROM msgpack_stream('SELECT * FROM pgz_stats_src ORDER BY id', 1000000000) AS c;
+
+SELECT pgz_stat('rows', 'msgpack', 'embedded') = 3 AND
+       pgz_stat('fast_path', 'msgpack', 'embedded') = 3 AS embedded_counted;
+
+-- Repeated lookups hit the cache; DDL on a cached type invalidates it.
+SELECT pgz_stat('schema_cache_hits') > 0 AND pgz_stat('schema_cache_misses') > 0 AS cache_used;
+
+SELECT type, projected, columns, fallback_columns, nested, msgpack_fast, flex_fast
+FROM pg_zerialize_schema_cache
+WHERE type IN ('pgz_stats_plain'::regtype, 'pgz_stats_odd'::regtype, 'pgz_stats_outer'::regtype)
+ORDER BY type::text;
+
+SELECT row_to_msgpack(ROW(1, 'a')::pgz_stats_plain, ARRAY['label']) IS NOT NULL AS projected_row;
+
+SELECT columns = ARRAY['label'] AS projection_listed
+FROM pg_zerialize_schema_cache()
+WHERE type = 'pgz_stats_plain'::regtype AND projected;
+
+ALTER TYPE pgz_stats_plain ADD ATTRIBUTE extra int;
+
+SELECT pgz_stat('schema_cache_invalidations') > 0 AS ddl_invalidates;
+
+SELECT count(*) = 0 AS dropped_after_ddl
+FROM pg_zerialize_schema_cache()
+WHERE type = 'pgz_stats_plain'::regtype;
+
+-- The shared aggregate only exists when the library is preloaded.
+SELECT * FROM pg_zerialize_stats(true);
+
+DROP FUNCTION pgz_stat(text, text, text);
+DROP TABLE pgz_stats_docs;
+DROP TABLE pgz_stats_src;
+DROP TYPE pgz_stats_outer;
+DROP TYPE pgz_stats_odd;
+DROP TYPE pgz_stats_plain;
+DROP EXTENSION pg_zerialize;
@@ -0,0 +1,54 @@
+SET client_min_messages TO warning;
+DROP EXTENSION IF EXISTS pg_zerialize CASCADE;
+CREATE EXTENSION pg_zerialize;
+
+CREATE TYPE pgz_stream_inner AS (k int, v text);
+CREATE TABLE pgz_stream_src (id int, name text, score float8, tags text[], inner_row pgz_stream_inner);
+INSERT INTO pgz_stream_src
+SELECT i, CASE WHEN i % 5 = 0 THEN NULL ELSE format('n%s', i) END, i / 4.0,
+       ARRAY[format('t%s', i)], ROW(i, format('v%s', i))::pgz_stream_inner
+FROM generate_series(1, 3000) AS i;
+
+-- One chunk holding every row matches the array batch byte for byte.
+SELECT count(*) = 1 AND
+       bool_and(c = (SELECT rows_to_msgpack(array_agg(t ORDER BY id)) FROM pgz_stream_src AS t))
+           AS single_chunk_parity
+FROM msgpack_stream('SELECT * FROM pgz_stream_src ORDER BY id', 1000000000) AS c;
+
+-- Small chunks split on row boundaries; only the last may fall short.
+SELECT count(*) > 10 AS many_chunks,
+       bool_and(octet_length(c) >= 4096 OR n = (SELECT count(*) FROM msgpack_stream(
+           'SELECT * FROM pgz_stream_src ORDER BY id', 4096))) AS chunks_reach_threshold,
+       bool_and(octet_length(c) < 4096 + 200) AS chunks_cut_after_one_row
+FROM msgpack_stream('SELECT * FROM pgz_stream_src ORDER BY id', 4096) WITH ORDINALITY AS s(c, n);
+
+SELECT (SELECT jsonb_agg(e ORDER BY n, o)
+        FROM msgpack_stream('SELECT * FROM pgz_stream_src ORDER BY id', 4096) WITH ORDINALITY AS s(c, n),
+             jsonb_array_elements(msgpack_to_jsonb(c)) WITH ORDINALITY AS r(e, o)) =
+       msgpack_to_jsonb(rows_to_msgpack(array_agg(t ORDER BY id))) AS chunks_concatenate
+FROM pgz_stream_src AS t;
+
+SELECT (SELECT count(*) FROM msgpack_stream('SELECT * FROM pgz_stream_src ORDER BY id', 4096) AS c,
+               msgpack_to_recordset(NULL::pgz_stream_src, c)) = 3000 AS chunks_decode_as_recordsets;
+
+-- The default chunk size and the select-list form both work.
+SELECT count(*) = 1 AS default_chunk_size
+FROM msgpack_stream('SELECT * FROM pgz_stream_src') AS c;
+
+SELECT sum(length(msgpack_stream)) > 0 AS select_list_form
+FROM (SELECT msgpack_stream('SELECT id, name FROM pgz_stream_src', 1024)) AS s;
+
+SELECT count(*) = 0 AS empty_query_has_no_chunks
+FROM msgpack_stream('SELECT * FROM pgz_stream_src WHERE false', 1024) AS c;
+
+SELECT msgpack_to_jsonb(c) = '[{"a": 1, "b": [1, 2]}, {"a": 2, "b": null}]'::jsonb AS anonymous_columns
+FROM msgpack_stream('SELECT * FROM (VALUES (1, ARRAY[1, 2]), (2, NULL)) AS v(a, b)', 1024) AS c;
+
+SELECT count(*) = 0 AS null_query_is_empty FROM msgpack_stream(NULL, 1024) AS c;
+
+SELECT count(*) FROM msgpack_stream('SELECT 1', 0);
+SELECT count(*) FROM msgpack_stream('INSERT INTO pgz_stream_src DEFAULT VALUES', 1024);
+
+DROP TABLE pgz_stream_src;
+DROP TYPE pgz_stream_inner;
+DROP EXTENSION pg_zerialize;
@@ -0,0 +1,89 @@
+SET client_min_messages TO warning;
+DROP EXTENSION IF EXISTS pg_zerialize CASCADE;
+CREATE EXTENSION pg_zerialize;
+
+BEGIN;
+CREATE TYPE pg_temp.pgz_transcode_inner AS (k int, v text);
+CREATE TYPE pg_temp.pgz_transcode_row AS (
+    id int,
+    name text,
+    flag boolean,
+    score float8,
+    big bigint,
+    payload bytea,
+    tags text[],
+    grid int4[],
+    inner_row pg_temp.pgz_transcode_inner
+);
+
+CREATE TEMP TABLE pgz_transcode_src AS
+SELECT ROW(g,
+           CASE WHEN g % 7 = 0 THEN NULL ELSE format('name-%s-é', g) END,
+           g % 2 = 0,
+           g / 8.0 - 3,
+           (g::bigint - 100) * 92233720368547,
+           decode(md5(g::text), 'hex'),
+           ARRAY[format('tag-%s', g % 5), NULL],
+           ARRAY[[g, -g], [g * 1000, 0]],
+           ROW(g, repeat('v', g % 40))::pg_temp.pgz_transcode_inner
+       )::pg_temp.pgz_transcode_row AS r
+FROM generate_series(1, 200) AS g;
+
+CREATE TEMP TABLE pgz_transcode_docs AS
+SELECT (r).id, row_to_msgpack(r) AS m, row_to_cbor(r) AS c, row_to_zera(r) AS z,
+       row_to_flexbuffers(r) AS f, msgpack_to_jsonb(row_to_msgpack(r)) AS j
+FROM pgz_transcode_src;
+
+-- MessagePack and CBOR targets match what the row encoders write.
+SELECT bool_and(cbor_to_msgpack(c) = m) AS cbor_to_msgpack_parity,
+       bool_and(zera_to_msgpack(z) = m) AS zera_to_msgpack_parity,
+       bool_and(msgpack_to_cbor(m) = c) AS msgpack_to_cbor_parity,
+       bool_and(zera_to_cbor(z) = c) AS zera_to_cbor_parity
+FROM pgz_transcode_docs;
+
+-- Every pair decodes to the same jsonb as its source.
+SELECT bool_and(msgpack_to_jsonb(flexbuffers_to_msgpack(f)) = j) AS flex_to_msgpack,
+       bool_and(cbor_to_jsonb(flexbuffers_to_cbor(f)) = j) AS flex_to_cbor,
+       bool_and(zera_to_jsonb(flexbuffers_to_zera(f)) = j) AS flex_to_zera,
+       bool_and(zera_to_jsonb(msgpack_to_zera(m)) = j) AS msgpack_to_zera,
+       bool_and(flexbuffers_to_jsonb(msgpack_to_flexbuffers(m)) = j) AS msgpack_to_flex,
+       bool_and(zera_to_jsonb(cbor_to_zera(c)) = j) AS cbor_to_zera,
+       bool_and(flexbuffers_to_jsonb(cbor_to_flexbuffers(c)) = j) AS cbor_to_flex,
+       bool_and(flexbuffers_to_jsonb(zera_to_flexbuffers(z)) = j) AS zera_to_flex
+FROM pgz_transcode_docs;
+
+-- Batches, including compressed frames, transcode as one document.
+SELECT cbor_to_msgpack(rows_to_cbor(a)) = rows_to_msgpack(a) AS batch_parity,
+       cbor_to_msgpack(rows_to_cbor(a, 'lz4')) = rows_to_msgpack(a) AS framed_parity,
+       zera_to_jsonb(msgpack_to_zera(rows_to_msgpack(a, 'zstd'))) =
+           msgpack_to_jsonb(rows_to_msgpack(a)) AS framed_zera
+FROM (SELECT array_agg(r ORDER BY (r).id) AS a FROM pgz_transcode_src) AS s;
+ROLLBACK;
+
+-- Indefinite CBOR strings and containers become definite lengths.
+SELECT cbor_to_msgpack('\xbf6161019f0102ffff'::bytea) = '\x81a161920102'::bytea AS indefinite_containers,
+       cbor_to_msgpack('\x7f626162616363ff'::bytea) = '\xa3616263'::bytea AS indefinite_text,
+       cbor_to_msgpack('\xbf7f6161ff01ff'::bytea) = '\x81a16101'::bytea AS indefinite_key,
+       cbor_to_zera('\x9fff'::bytea) = msgpack_to_zera('\x90'::bytea) AS empty_indefinite;
+
+-- Typed arrays and decimals keep their binary forms across protocols.
+SELECT msgpack_to_cbor(cbor_to_msgpack('\xd84e480100000002000000'::bytea)) =
+           '\xd84e480100000002000000'::bytea AS typed_array_roundtrip,
+       msgpack_to_jsonb(cbor_to_msgpack('\xd84e480100000002000000'::bytea)) =
+           '[1, 2]'::jsonb AS typed_array_values,
+       msgpack_to_jsonb(cbor_to_msgpack('\x3bffffffffffffffff'::bytea)) =
+           '-18446744073709551616'::jsonb AS negative_below_int64,
+       cbor_to_jsonb('\x3bffffffffffffffff'::bytea) =
+           '-18446744073709551616'::jsonb AS cbor_decode_unchanged;
+
+SELECT cbor_to_msgpack('\xa2616101616102'::bytea);
+-- Huge definite counts in a few bytes fail before anything is reserved.
+SELECT cbor_to_zera('\x9a10000000'::bytea);
+SELECT cbor_to_zera('\xbbffffffffffffffff'::bytea);
+SELECT cbor_to_jsonb('\x9a10000000'::bytea);
+SELECT cbor_to_jsonb('\xbbffffffffffffffff'::bytea);
+SELECT msgpack_to_zera('\x81a16101c0'::bytea);
+SELECT zera_to_cbor('\x00'::bytea);
+SELECT flexbuffers_to_msgpack(''::bytea);
+SELECT cbor_to_msgpack(rows_to_msgpack(ARRAY[ROW(1, 'x')], 'lz4'));
+DROP EXTENSION pg_zerialize;
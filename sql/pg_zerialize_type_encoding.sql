@@ -0,0 +1,133 @@
+SET client_min_messages TO warning;
+DROP EXTENSION IF EXISTS pg_zerialize CASCADE;
+CREATE EXTENSION pg_zerialize;
+
+BEGIN;
+CREATE TYPE pg_temp.pgz_native_row AS (
+    id int,
+    u uuid,
+    ts timestamp,
+    tz timestamptz,
+    addr inet,
+    net cidr,
+    span interval,
+    stamps timestamptz[],
+    grid timestamptz[]
+);
+
+CREATE TEMP TABLE pgz_native_src AS
+SELECT ROW(g,
+           md5(g::text)::uuid,
+           timestamp '2024-01-01 00:00:00' + g * interval '1 hour 0.25 second',
+           timestamptz '1969-12-31 23:59:59+00' + g * interval '1 day 1 microsecond',
+           CASE WHEN g % 2 = 0 THEN format('10.%s.%s.7/24', g % 256, g % 100)::inet
+                ELSE format('2001:db8::%s/64', g)::inet END,
+           format('192.168.%s.0/24', g % 256)::cidr,
+           make_interval(months => g % 14, days => g % 31, secs => g * 0.5),
+           ARRAY[timestamptz '2024-06-01 12:00:00+00' + g * interval '1 second',
+                 'infinity'::timestamptz],
+           ARRAY[[timestamptz '2000-01-01 00:00:00+00', '-infinity'],
+                 [timestamptz '1999-12-31 23:59:59.5+00', '2000-01-01 00:00:00.000001+00']]
+       )::pg_temp.pgz_native_row AS r
+FROM generate_series(1, 500) AS g
+UNION ALL
+SELECT ROW(0, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL)::pg_temp.pgz_native_row;
+
+CREATE TEMP TABLE pgz_native_plain AS
+SELECT (r).id, row_to_msgpack(r) AS m, row_to_cbor(r) AS c FROM pgz_native_src;
+
+SET LOCAL pg_zerialize.type_encoding = native;
+
+-- Exact bytes for each protocol's native form.
+SELECT row_to_msgpack(ROW('a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11'::uuid)) =
+           '\x81a26631c410a0eebc999c0b4ef8bb6d6bb9bd380a11'::bytea AS msgpack_uuid,
+       row_to_msgpack(ROW('2024-01-01 00:00:00+00'::timestamptz)) =
+           '\x81a26631d6ff65920080'::bytea AS msgpack_timestamp32,
+       row_to_msgpack(ROW('2024-01-01 00:00:00.5'::timestamp)) =
+           '\x81a26631d7ff7735940065920080'::bytea AS msgpack_timestamp64,
+       row_to_msgpack(ROW('1969-12-31 23:59:59+00'::timestamptz)) =
+           '\x81a26631c70cff00000000ffffffffffffffff'::bytea AS msgpack_timestamp96,
+       row_to_msgpack(ROW('infinity'::timestamptz)) =
+           '\x81a26631a8696e66696e697479'::bytea AS msgpack_infinity,
+       row_to_msgpack(ROW('192.168.1.5/24'::inet)) =
+           '\x81a26631c7050518c0a80105'::bytea AS msgpack_inet,
+       row_to_msgpack(ROW('::1'::inet)) =
+           '\x81a26631c7110580000000000000000000000000000000000001'::bytea AS msgpack_inet6,
+       row_to_msgpack(ROW('1 mon 2 days 00:00:03'::interval)) =
+           '\x81a26631d80600000001000000020000000000002dc6c0'::bytea AS msgpack_interval;
+
+SELECT row_to_cbor(ROW('2024-01-01 00:00:00+00'::timestamptz)) =
+           '\xa1626631c11a65920080'::bytea AS cbor_epoch_int,
+       row_to_cbor(ROW('2024-01-01 00:00:00.5+00'::timestamptz)) =
+           '\xa1626631c1fb41d9648020200000'::bytea AS cbor_epoch_float,
+       row_to_cbor(ROW('192.168.1.5/24'::inet)) =
+           '\xa162663183637e6970181844c0a80105'::bytea AS cbor_inet,
+       row_to_cbor(ROW('1 mon 2 days 00:00:03'::interval)) =
+           '\xa162663184637e697601021a002dc6c0'::bytea AS cbor_interval,
+       zera_to_jsonb(row_to_zera(ROW('2024-01-01 00:00:00.5+00'::timestamptz))) =
+           '{"f1": ["~t", 1704067200, 500000000]}'::jsonb AS zera_timestamp,
+       flexbuffers_to_jsonb(row_to_flexbuffers(ROW('10.0.0.0/8'::cidr))) =
+           '{"f1": ["~ip", 8, ["~b", "CgAAAA==", "base64"]]}'::jsonb AS flex_cidr,
+       zera_to_jsonb(row_to_zera(ROW('-1 days 00:00:01.5'::interval))) =
+           '{"f1": ["~iv", 0, -1, 1500000]}'::jsonb AS zera_interval;
+
+-- Decoders render native values as ISO 8601 UTC and PostgreSQL text.
+SELECT msgpack_to_jsonb(row_to_msgpack(ROW('2024-01-01 00:00:00.5+00'::timestamptz,
+                                           '10.1.2.3/16'::inet,
+                                           '1 mon 2 days 00:00:03'::interval))) =
+           '{"f1": "2024-01-01T00:00:00.5+00:00", "f2": "10.1.2.3/16",
+             "f3": "1 mon 2 days 00:00:03"}'::jsonb AS msgpack_text,
+       cbor_to_jsonb(row_to_cbor(ROW('1969-12-31 23:59:59+00'::timestamptz))) =
+           '{"f1": "1969-12-31T23:59:59+00:00"}'::jsonb AS cbor_text,
+       msgpack_extract_text(row_to_msgpack(ROW('::ffff:1.2.3.4'::inet)), '{f1}') =
+           '::ffff:1.2.3.4' AS msgpack_extract_inet,
+       cbor_extract_text(row_to_cbor(ROW('2024-01-01 00:00:00+00'::timestamptz)), '{f1}') =
+           '2024-01-01T00:00:00+00:00' AS cbor_extract_timestamp;
+
+SELECT bool_and(msgpack_populate_record(NULL::pg_temp.pgz_native_row, row_to_msgpack(r))::text =
+                r::text) AS populate_roundtrip,
+       bool_and(msgpack_extract_text(row_to_msgpack(r), '{tz}') IS NOT DISTINCT FROM
+                msgpack_to_jsonb(row_to_msgpack(r)) ->> 'tz') AS extract_matches_jsonb
+FROM pgz_native_src;
+
+SELECT sum(octet_length(row_to_msgpack(s.r))) < sum(octet_length(p.m)) AS msgpack_smaller,
+       sum(octet_length(row_to_cbor(s.r))) < sum(octet_length(p.c)) AS cbor_smaller
+FROM pgz_native_src AS s
+JOIN pgz_native_plain AS p ON p.id = (s.r).id;
+
+-- Buffered aggregates replay each ext in the target protocol's native form.
+SELECT msgpack_rows_agg(r ORDER BY (r).id) = rows_to_msgpack(array_agg(r ORDER BY (r).id))
+           AS msgpack_agg_parity,
+       cbor_rows_agg(r ORDER BY (r).id) = rows_to_cbor(array_agg(r ORDER BY (r).id))
+           AS cbor_agg_parity,
+       zera_rows_agg(r ORDER BY (r).id) = rows_to_zera(array_agg(r ORDER BY (r).id))
+           AS zera_agg_parity,
+       flexbuffers_rows_agg(r ORDER BY (r).id) = rows_to_flexbuffers(array_agg(r ORDER BY (r).id))
+           AS flex_agg_parity
+FROM pgz_native_src;
+
+-- Typmods apply on decode; plain encodings still populate.
+SELECT (msgpack_populate_record(NULL::pg_temp.pgz_native_row,
+            msgpack_from_jsonb('{"ts": ["~t", 1704067200, 123456789],
+                                 "span": ["~iv", 1, 2, 3000000]}'::jsonb))).ts =
+           '2024-01-01 00:00:00.123457' AS tagged_timestamp,
+       (SELECT bool_and(msgpack_populate_record(NULL::pg_temp.pgz_native_row, p.m)::text =
+                        s.r::text)
+        FROM pgz_native_src AS s
+        JOIN pgz_native_plain AS p ON p.id = (s.r).id) AS plain_populates;
+ROLLBACK;
+
+-- Epoch times from other CBOR encoders.
+SELECT cbor_to_jsonb('\xc11a65920080'::bytea) = '"2024-01-01T00:00:00+00:00"'::jsonb
+           AS cbor_epoch_uint,
+       cbor_to_jsonb('\xc120'::bytea) = '"1969-12-31T23:59:59+00:00"'::jsonb AS cbor_epoch_negative,
+       cbor_to_jsonb('\xc1fa3f000000'::bytea) = '"1970-01-01T00:00:00.5+00:00"'::jsonb
+           AS cbor_epoch_single;
+
+SELECT msgpack_to_jsonb('\xd5ff0000'::bytea);
+SELECT msgpack_to_jsonb('\xd7ff0000000000000000'::bytea) = '"1970-01-01T00:00:00+00:00"'::jsonb
+           AS msgpack_epoch;
+SELECT msgpack_to_jsonb('\xc7050521c0a80105'::bytea);
+SELECT msgpack_to_jsonb('\xd406ff'::bytea);
+SELECT cbor_to_jsonb('\xc16161'::bytea);
+DROP EXTENSION pg_zerialize;
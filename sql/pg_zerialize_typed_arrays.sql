@@ -0,0 +1,120 @@
+SET client_min_messages TO warning;
+DROP EXTENSION IF EXISTS pg_zerialize CASCADE;
+CREATE EXTENSION pg_zerialize;
+
+BEGIN;
+CREATE TYPE pg_temp.pgz_typed_row AS (
+    id int,
+    i2 int2[],
+    i4 int4[],
+    i8 int8[],
+    f4 float4[],
+    f8 float8[]
+);
+CREATE TYPE pg_temp.pgz_typed_wide AS (
+    i2 int8[],
+    i4 numeric[],
+    i8 numeric[],
+    f4 float8[],
+    f8 float8[]
+);
+CREATE TYPE pg_temp.pgz_typed_shape AS (
+    with_null int4[],
+    grid int8[],
+    labels text[],
+    empty float8[],
+    amounts numeric[]
+);
+
+CREATE TEMP TABLE pgz_typed_src AS
+SELECT ROW(len,
+           ARRAY(SELECT (g * 997 % 65536 - 32768)::int2 FROM generate_series(1, len) AS g),
+           ARRAY(SELECT (g * 104729 - 2147483)::int4 FROM generate_series(1, len) AS g),
+           ARRAY(SELECT g::int8 * 2305843009213693 - 9223372036854775 FROM generate_series(1, len) AS g),
+           ARRAY(SELECT (g * 0.25 - 3)::float4 FROM generate_series(1, len) AS g),
+           ARRAY(SELECT (g * 1.5 - 7)::float8 FROM generate_series(1, len) AS g) ||
+               ARRAY['NaN', 'Infinity', '-Infinity', '-0']::float8[])::pg_temp.pgz_typed_row AS r
+FROM (VALUES (1), (2), (4), (8), (63), (300)) AS lengths(len);
+
+CREATE TEMP TABLE pgz_typed_generic AS
+SELECT (r).id, row_to_msgpack(r) AS m, row_to_cbor(r) AS c, row_to_zera(r) AS z,
+       row_to_flexbuffers(r) AS f
+FROM pgz_typed_src;
+
+CREATE TEMP TABLE pgz_typed_shapes AS
+SELECT r, row_to_msgpack(r) AS m, row_to_cbor(r) AS c, row_to_zera(r) AS z,
+       row_to_flexbuffers(r) AS f
+FROM (VALUES (ROW(ARRAY[1, NULL]::int4[], ARRAY[[1, 2], [3, 4]]::int8[],
+                  ARRAY['a']::text[], '{}'::float8[],
+                  ARRAY[1.5, NULL]::numeric[])::pg_temp.pgz_typed_shape)) AS v(r);
+
+SET LOCAL pg_zerialize.array_encoding = typed;
+
+-- Packed little-endian elements under each protocol's typed-array marker.
+SELECT current_setting('pg_zerialize.array_encoding') = 'typed' AS typed_enabled,
+       row_to_msgpack(ROW(ARRAY[1, 2, 3]::int4[])) =
+           '\x81a26631c70c4e010000000200000003000000'::bytea AS msgpack_ext8,
+       row_to_msgpack(ROW(ARRAY[7]::int2[])) = '\x81a26631d54d0700'::bytea AS msgpack_fixext2,
+       row_to_msgpack(ROW(ARRAY[1.5]::float8[])) =
+           '\x81a26631d756000000000000f83f'::bytea AS msgpack_fixext8,
+       row_to_cbor(ROW(ARRAY[1, 2, 3]::int4[])) =
+           '\xa1626631d84e4c010000000200000003000000'::bytea AS cbor_rfc8746;
+
+-- Every protocol decodes the typed form to the same document as the generic one.
+SELECT bool_and(msgpack_to_jsonb(row_to_msgpack(s.r)) = msgpack_to_jsonb(g.m)) AS msgpack_values,
+       bool_and(cbor_to_jsonb(row_to_cbor(s.r)) = cbor_to_jsonb(g.c)) AS cbor_values,
+       bool_and(zera_to_jsonb(row_to_zera(s.r)) = zera_to_jsonb(g.z)) AS zera_values,
+       bool_and(flexbuffers_to_jsonb(row_to_flexbuffers(s.r)) = flexbuffers_to_jsonb(g.f))
+           AS flex_values,
+       bool_and(octet_length(row_to_msgpack(s.r)) < octet_length(g.m)) FILTER (WHERE g.id >= 63)
+           AS msgpack_smaller
+FROM pgz_typed_src AS s
+JOIN pgz_typed_generic AS g ON g.id = (s.r).id;
+
+-- NULLs, extra dimensions, and other element types keep the generic form.
+SELECT row_to_msgpack(r) = m AS msgpack_generic_shapes,
+       row_to_cbor(r) = c AS cbor_generic_shapes,
+       row_to_zera(r) = z AS zera_generic_shapes,
+       row_to_flexbuffers(r) = f AS flex_generic_shapes
+FROM pgz_typed_shapes;
+
+-- Buffered aggregates replay the typed form unchanged.
+SELECT msgpack_rows_agg(r ORDER BY (r).id) = rows_to_msgpack(array_agg(r ORDER BY (r).id))
+           AS msgpack_agg_parity,
+       cbor_rows_agg(r ORDER BY (r).id) = rows_to_cbor(array_agg(r ORDER BY (r).id))
+           AS cbor_agg_parity,
+       zera_rows_agg(r ORDER BY (r).id) = rows_to_zera(array_agg(r ORDER BY (r).id))
+           AS zera_agg_parity,
+       flexbuffers_rows_agg(r ORDER BY (r).id) = rows_to_flexbuffers(array_agg(r ORDER BY (r).id))
+           AS flex_agg_parity
+FROM pgz_typed_src;
+
+-- Record decoding accepts typed arrays, converting elements like generic ones.
+SELECT bool_and(msgpack_populate_record(NULL::pg_temp.pgz_typed_row, row_to_msgpack(s.r))::text =
+                s.r::text) AS same_type_roundtrip,
+       bool_and(msgpack_populate_record(NULL::pg_temp.pgz_typed_wide, row_to_msgpack(s.r)) =
+                msgpack_populate_record(NULL::pg_temp.pgz_typed_wide, g.m)) AS widened_like_generic
+FROM pgz_typed_src AS s
+JOIN pgz_typed_generic AS g ON g.id = (s.r).id;
+
+SELECT msgpack_extract_text(row_to_msgpack(ROW(ARRAY[1, 2]::int8[])), '{f1}')::jsonb = '[1, 2]'::jsonb
+           AS msgpack_extract_typed,
+       cbor_extract_text(row_to_cbor(ROW(ARRAY[1, 2]::int8[])), '{f1}')::jsonb = '[1, 2]'::jsonb
+           AS cbor_extract_typed,
+       zera_extract_text(row_to_zera(ROW(ARRAY[1, 2]::int8[])), '{f1}')::jsonb = '[1, 2]'::jsonb
+           AS zera_extract_typed;
+ROLLBACK;
+
+-- Typed arrays from other RFC 8746 encoders.
+SELECT cbor_to_jsonb('\xd8424800000001fffffffe'::bytea) = '[1, 4294967294]'::jsonb AS cbor_uint32_be,
+       cbor_to_jsonb('\xd84842ff7f'::bytea) = '[-1, 127]'::jsonb AS cbor_sint8,
+       cbor_to_jsonb('\xd85444003c00c0'::bytea) = '[1, -2]'::jsonb AS cbor_float16_le,
+       cbor_to_jsonb('\xa16178d8464440010000'::bytea) = '{"x": [320]}'::jsonb AS cbor_uint32_le;
+
+SELECT cbor_to_jsonb('\xd84c42ffff'::bytea);
+SELECT cbor_to_jsonb('\xd84e43010203'::bytea);
+SELECT cbor_to_jsonb('\xd84e01'::bytea);
+SELECT msgpack_to_jsonb('\xd40100'::bytea);
+SELECT msgpack_to_jsonb('\xc7034e010203'::bytea);
+
+DROP EXTENSION pg_zerialize;
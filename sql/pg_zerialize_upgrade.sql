@@ -47,4 +47,129 @@ SELECT to_regprocedure('zera_to_jsonb(bytea)') IS NOT NULL AS zera_decoder_prese
 SELECT zera_to_jsonb(row_to_zera(ROW(1, 'upgrade-ok'))) =
        '{"f1":1,"f2":"upgrade-ok"}'::jsonb AS zera_decoder_works;
 
+ALTER EXTENSION pg_zerialize UPDATE TO '1.7';
+SELECT extversion = '1.7' AS upgraded_to_1_7
+FROM pg_extension
+WHERE extname = 'pg_zerialize';
+SELECT to_regprocedure('msgpack_agg_transfn(internal,anyelement)') IS NOT NULL AND
+       to_regprocedure('msgpack_agg_final(internal)') IS NULL AS streaming_agg_present;
+SELECT msgpack_agg(x ORDER BY x) = msgpack_build_array(1, 2) AS streaming_agg_works
+FROM (VALUES (1), (2)) AS t(x);
+
+ALTER EXTENSION pg_zerialize UPDATE TO '1.8';
+SELECT extversion = '1.8' AS upgraded_to_1_8
+FROM pg_extension
+WHERE extname = 'pg_zerialize';
+SELECT to_regprocedure('msgpack_rows_agg(record)') IS NOT NULL AS rows_agg_present;
+SELECT msgpack_rows_agg(t ORDER BY x) = rows_to_msgpack(array_agg(t ORDER BY x))
+       AS rows_agg_works
+FROM (VALUES (1), (2)) AS t(x);
+
+ALTER EXTENSION pg_zerialize UPDATE TO '1.9';
+SELECT extversion = '1.9' AS upgraded_to_1_9
+FROM pg_extension
+WHERE extname = 'pg_zerialize';
+SELECT to_regprocedure('msgpack_extract(bytea,text[])') IS NOT NULL AS extract_present;
+SELECT msgpack_extract_int8(msgpack_build_object('a', 7), '{a}') = 7 AS extract_works;
+
+ALTER EXTENSION pg_zerialize UPDATE TO '1.10';
+SELECT extversion = '1.10' AS upgraded_to_1_10
+FROM pg_extension
+WHERE extname = 'pg_zerialize';
+SELECT to_regprocedure('msgpack_to_recordset(anyelement,bytea)') IS NOT NULL AS populate_present;
+SELECT (msgpack_populate_record(NULL::pg_namespace,
+                                msgpack_build_object('nspname', 'x'))).nspname = 'x'
+       AS populate_works;
+
+ALTER EXTENSION pg_zerialize UPDATE TO '1.11';
+SELECT extversion = '1.11' AS upgraded_to_1_11
+FROM pg_extension
+WHERE extname = 'pg_zerialize';
+SELECT to_regprocedure('cbor_array_elements(bytea)') IS NOT NULL AS array_elements_present;
+SELECT (SELECT count(*) FROM msgpack_array_elements(msgpack_build_array(1, 2))) = 2
+       AS array_elements_works;
+
+ALTER EXTENSION pg_zerialize UPDATE TO '1.12';
+SELECT extversion = '1.12' AS upgraded_to_1_12
+FROM pg_extension
+WHERE extname = 'pg_zerialize';
+SELECT to_regprocedure('rows_to_zera(anyarray,text[])') IS NOT NULL AS projection_present;
+SELECT msgpack_to_jsonb(row_to_msgpack(ROW(1, 2), ARRAY['f2'])) = '{"f2": 2}'::jsonb
+       AS projection_works;
+
+ALTER EXTENSION pg_zerialize UPDATE TO '1.13';
+SELECT extversion = '1.13' AS upgraded_to_1_13
+FROM pg_extension
+WHERE extname = 'pg_zerialize';
+SELECT to_regprocedure('rows_to_zera_compact(anyarray)') IS NOT NULL AS compact_present;
+SELECT msgpack_to_jsonb(rows_to_msgpack_compact(ARRAY[ROW(1, 2)])) =
+       '{"columns": ["f1", "f2"], "rows": [[1, 2]]}'::jsonb AS compact_works;
+
+ALTER EXTENSION pg_zerialize UPDATE TO '1.14';
+SELECT extversion = '1.14' AS upgraded_to_1_14
+FROM pg_extension
+WHERE extname = 'pg_zerialize';
+SELECT to_regprocedure('rows_to_zera_columnar(anyarray)') IS NOT NULL AS columnar_present;
+SELECT zera_to_jsonb(rows_to_zera_columnar(ARRAY[ROW(1, 2)]))->'rows' = '1'::jsonb
+       AS columnar_works;
+
+ALTER EXTENSION pg_zerialize UPDATE TO '1.15';
+SELECT extversion = '1.15' AS upgraded_to_1_15
+FROM pg_extension
+WHERE extname = 'pg_zerialize';
+SELECT to_regprocedure('msgpack_stream(text,integer)') IS NOT NULL AS stream_present;
+SELECT msgpack_to_jsonb(c) = '[{"a": 1}]'::jsonb AS stream_works
+FROM msgpack_stream('SELECT 1 AS a') AS c;
+
+ALTER EXTENSION pg_zerialize UPDATE TO '1.16';
+SELECT extversion = '1.16' AS upgraded_to_1_16
+FROM pg_extension
+WHERE extname = 'pg_zerialize';
+SELECT to_regprocedure('zera_build_object("any")') IS NOT NULL AS builders_present;
+SELECT cbor_to_jsonb(cbor_build_object('a', 1)) = '{"a": 1}'::jsonb AS builders_work;
+
+ALTER EXTENSION pg_zerialize UPDATE TO '1.17';
+SELECT extversion = '1.17' AS upgraded_to_1_17
+FROM pg_extension
+WHERE extname = 'pg_zerialize';
+SELECT to_regprocedure('pg_zerialize_stats(boolean)') IS NOT NULL AND
+       to_regprocedure('pg_zerialize_stats_reset()') IS NOT NULL AND
+       to_regclass('pg_zerialize_schema_cache') IS NOT NULL AS stats_present;
+SELECT count(*) = 84 AS stats_work
+FROM pg_zerialize_stats();
+
+ALTER EXTENSION pg_zerialize UPDATE TO '1.18';
+SELECT extversion = '1.18' AS upgraded_to_1_18
+FROM pg_extension
+WHERE extname = 'pg_zerialize';
+SELECT to_regprocedure('rows_to_msgpack(anyarray, text, integer)') IS NOT NULL AND
+       to_regprocedure('zerialize_decompress(bytea)') IS NOT NULL AS compression_present;
+SELECT zerialize_decompress(rows_to_msgpack(ARRAY[ROW(1)], 'none')) =
+           rows_to_msgpack(ARRAY[ROW(1)]) AS compression_works;
+
+ALTER EXTENSION pg_zerialize UPDATE TO '1.19';
+SELECT extversion = '1.19' AS upgraded_to_1_19
+FROM pg_extension
+WHERE extname = 'pg_zerialize';
+SELECT to_regprocedure('cbor_to_msgpack(bytea)') IS NOT NULL AND
+       to_regprocedure('flexbuffers_to_zera(bytea)') IS NOT NULL AS transcoders_present;
+SELECT msgpack_to_cbor('\x81a16101'::bytea) = '\xa1616101'::bytea AS transcoders_work;
+
+ALTER EXTENSION pg_zerialize UPDATE TO '1.20';
+SELECT extversion = '1.20' AS upgraded_to_1_20
+FROM pg_extension
+WHERE extname = 'pg_zerialize';
+SELECT to_regtype('msgpack') IS NOT NULL AND
+       to_regprocedure('msgpack_contains(msgpack, msgpack)') IS NOT NULL AS msgpack_type_present;
+SELECT '{"a": [1, 2]}'::msgpack @> '{"a": [2]}'::msgpack AS msgpack_type_works;
+
+ALTER EXTENSION pg_zerialize UPDATE TO '1.21';
+SELECT extversion = '1.21' AS upgraded_to_1_21
+FROM pg_extension
+WHERE extname = 'pg_zerialize';
+SELECT to_regprocedure('cbor_rows_agg_transfn(internal, record)') IS NOT NULL AND
+       to_regprocedure('cbor_rows_agg_finalfn(internal)') IS NULL AS cbor_rows_agg_native;
+SELECT cbor_rows_agg(r) = rows_to_cbor(ARRAY[r]) AS cbor_rows_agg_works
+FROM (SELECT 1 AS a, 'x' AS b) AS r;
+
 DROP EXTENSION pg_zerialize;